@@ -0,0 +1,814 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Dynamic 4-wide bounding volume hierarchy for scene queries
+----------------------------------------------*/
+#include <Core/BVH.h>
+
+#include <Core/Culling.h>
+#include <Core/SIMD.h>
+
+#include <algorithm>
+#include <chrono>
+#include <float.h>
+#include <math.h>
+#include <utility>
+
+namespace Muon
+{
+using namespace SIMD;
+
+namespace
+{
+    static const uint32_t kNumSAHBins = 16;
+
+    static_assert(BVH_WIDTH == 4, "Node traversal tests one node's children with 4-wide vectors");
+
+    float SurfaceArea(const BVHBounds& b)
+    {
+        const float dx = std::max(b.Max[0] - b.Min[0], 0.0f);
+        const float dy = std::max(b.Max[1] - b.Min[1], 0.0f);
+        const float dz = std::max(b.Max[2] - b.Min[2], 0.0f);
+        return 2.0f * (dx * dy + dy * dz + dz * dx);
+    }
+
+    BVHBounds Union(const BVHBounds& a, const BVHBounds& b)
+    {
+        BVHBounds u;
+        for (uint32_t axis = 0; axis != 3; ++axis)
+        {
+            u.Min[axis] = std::min(a.Min[axis], b.Min[axis]);
+            u.Max[axis] = std::max(a.Max[axis], b.Max[axis]);
+        }
+        return u;
+    }
+
+    BVHBounds EmptyBounds()
+    {
+        return { { FLT_MAX, FLT_MAX, FLT_MAX }, { -FLT_MAX, -FLT_MAX, -FLT_MAX } };
+    }
+
+    // Traversal stacks are kept per thread so queries don't allocate once warmed up
+    std::vector<uint32_t>& GetNodeStack()
+    {
+        static thread_local std::vector<uint32_t> stack;
+        stack.clear();
+        return stack;
+    }
+}
+
+uint32_t DynamicBVH::AllocNode(uint32_t parent)
+{
+    uint32_t index = mFreeNode;
+    if (index != BVH_INVALID)
+    {
+        mFreeNode = mNodes[index].NextFree;
+    }
+    else
+    {
+        index = static_cast<uint32_t>(mNodes.size());
+        mNodes.emplace_back();
+    }
+
+    Node& node = mNodes[index];
+    for (uint32_t slot = 0; slot != BVH_WIDTH; ++slot)
+    {
+        node.MinX[slot] = node.MinY[slot] = node.MinZ[slot] = FLT_MAX;
+        node.MaxX[slot] = node.MaxY[slot] = node.MaxZ[slot] = -FLT_MAX;
+        node.Children[slot] = BVH_INVALID;
+    }
+    node.Parent = parent;
+    node.Count = 0;
+    node.Dirty = 0;
+    node.NextFree = BVH_INVALID;
+
+    mNumNodes++;
+    return index;
+}
+
+void DynamicBVH::FreeNode(uint32_t node)
+{
+    mNodes[node].Count = 0;
+    mNodes[node].NextFree = mFreeNode;
+    mFreeNode = node;
+    mNumNodes--;
+}
+
+void DynamicBVH::SetSlot(uint32_t node, uint32_t slot, uint32_t child, const BVHBounds& bounds)
+{
+    Node& n = mNodes[node];
+    n.MinX[slot] = bounds.Min[0];
+    n.MinY[slot] = bounds.Min[1];
+    n.MinZ[slot] = bounds.Min[2];
+    n.MaxX[slot] = bounds.Max[0];
+    n.MaxY[slot] = bounds.Max[1];
+    n.MaxZ[slot] = bounds.Max[2];
+    n.Children[slot] = child;
+
+    if (child & BVH_LEAF_BIT)
+    {
+        Proxy& proxy = mProxies[child & ~BVH_LEAF_BIT];
+        proxy.Node = node;
+        proxy.Slot = slot;
+    }
+    else
+    {
+        mNodes[child].Parent = node;
+    }
+}
+
+BVHBounds DynamicBVH::GetSlotBounds(uint32_t node, uint32_t slot) const
+{
+    const Node& n = mNodes[node];
+    return { { n.MinX[slot], n.MinY[slot], n.MinZ[slot] }, { n.MaxX[slot], n.MaxY[slot], n.MaxZ[slot] } };
+}
+
+BVHBounds DynamicBVH::GetNodeBounds(uint32_t node) const
+{
+    BVHBounds bounds = EmptyBounds();
+    for (uint32_t slot = 0; slot != mNodes[node].Count; ++slot)
+        bounds = Union(bounds, GetSlotBounds(node, slot));
+    return bounds;
+}
+
+uint32_t DynamicBVH::Insert(const BVHBounds& bounds, uint32_t userData)
+{
+    uint32_t proxy = mFreeProxy;
+    if (proxy != BVH_INVALID)
+    {
+        mFreeProxy = mProxies[proxy].Node;
+    }
+    else
+    {
+        proxy = static_cast<uint32_t>(mProxies.size());
+        mProxies.emplace_back();
+    }
+
+    mProxies[proxy].Bounds = bounds;
+    mProxies[proxy].UserData = userData;
+    mNumProxies++;
+
+    const uint32_t leaf = proxy | BVH_LEAF_BIT;
+    if (mRoot == BVH_INVALID)
+    {
+        mRoot = AllocNode(BVH_INVALID);
+        SetSlot(mRoot, 0, leaf, bounds);
+        mNodes[mRoot].Count = 1;
+        return proxy;
+    }
+
+    // Walk down through full nodes, growing the child whose box grows least, until there's a free slot.
+    // Boxes are grown on the way, so nothing above needs touching afterwards.
+    uint32_t node = mRoot;
+    for (;;)
+    {
+        if (mNodes[node].Count < BVH_WIDTH)
+        {
+            SetSlot(node, mNodes[node].Count, leaf, bounds);
+            mNodes[node].Count++;
+            break;
+        }
+
+        uint32_t bestSlot = 0;
+        float bestGrowth = FLT_MAX;
+        float bestArea = FLT_MAX;
+        for (uint32_t slot = 0; slot != BVH_WIDTH; ++slot)
+        {
+            const float area = SurfaceArea(Union(GetSlotBounds(node, slot), bounds));
+            const float growth = area - SurfaceArea(GetSlotBounds(node, slot));
+            if (growth < bestGrowth || (growth == bestGrowth && area < bestArea))
+            {
+                bestSlot = slot;
+                bestGrowth = growth;
+                bestArea = area;
+            }
+        }
+
+        const uint32_t child = mNodes[node].Children[bestSlot];
+        const BVHBounds childBounds = GetSlotBounds(node, bestSlot);
+        const BVHBounds grown = Union(childBounds, bounds);
+
+        // Two leaves can't share a slot, so the one already there moves down into a new node with the new one
+        if (child & BVH_LEAF_BIT)
+        {
+            const uint32_t pair = AllocNode(node);
+            SetSlot(pair, 0, child, childBounds);
+            SetSlot(pair, 1, leaf, bounds);
+            mNodes[pair].Count = 2;
+            SetSlot(node, bestSlot, pair, grown);
+            break;
+        }
+
+        SetSlot(node, bestSlot, child, grown);
+        node = child;
+    }
+
+    return proxy;
+}
+
+void DynamicBVH::Remove(uint32_t proxy)
+{
+    Proxy& p = mProxies[proxy];
+    RemoveSlot(p.Node, p.Slot);
+
+    p.Node = mFreeProxy;
+    p.Slot = BVH_INVALID;
+    mFreeProxy = proxy;
+    mNumProxies--;
+}
+
+// Keeps slots packed and every node but the root at two or more children, collapsing nodes left with one
+void DynamicBVH::RemoveSlot(uint32_t node, uint32_t slot)
+{
+    const uint32_t last = mNodes[node].Count - 1;
+    if (slot != last)
+        SetSlot(node, slot, mNodes[node].Children[last], GetSlotBounds(node, last));
+
+    Node& n = mNodes[node];
+    n.MinX[last] = n.MinY[last] = n.MinZ[last] = FLT_MAX;
+    n.MaxX[last] = n.MaxY[last] = n.MaxZ[last] = -FLT_MAX;
+    n.Children[last] = BVH_INVALID;
+    n.Count--;
+
+    if (node == mRoot)
+    {
+        if (n.Count == 0)
+        {
+            FreeNode(node);
+            mRoot = BVH_INVALID;
+        }
+        else if (n.Count == 1 && !(n.Children[0] & BVH_LEAF_BIT))
+        {
+            mRoot = n.Children[0];
+            mNodes[mRoot].Parent = BVH_INVALID;
+            FreeNode(node);
+        }
+        return;
+    }
+
+    if (n.Count == 1)
+    {
+        const uint32_t parent = n.Parent;
+        uint32_t parentSlot = 0;
+        while (mNodes[parent].Children[parentSlot] != node)
+            parentSlot++;
+
+        SetSlot(parent, parentSlot, n.Children[0], GetSlotBounds(node, 0));
+        FreeNode(node);
+        node = parent;
+    }
+
+    RefitUpward(node);
+}
+
+void DynamicBVH::RefitUpward(uint32_t node)
+{
+    for (uint32_t parent = mNodes[node].Parent; parent != BVH_INVALID; node = parent, parent = mNodes[node].Parent)
+    {
+        uint32_t slot = 0;
+        while (mNodes[parent].Children[slot] != node)
+            slot++;
+
+        SetSlot(parent, slot, node, GetNodeBounds(node));
+    }
+}
+
+void DynamicBVH::Update(uint32_t proxy, const BVHBounds& bounds)
+{
+    Proxy& p = mProxies[proxy];
+    p.Bounds = bounds;
+
+    Node& n = mNodes[p.Node];
+    n.MinX[p.Slot] = bounds.Min[0];
+    n.MinY[p.Slot] = bounds.Min[1];
+    n.MinZ[p.Slot] = bounds.Min[2];
+    n.MaxX[p.Slot] = bounds.Max[0];
+    n.MaxY[p.Slot] = bounds.Max[1];
+    n.MaxZ[p.Slot] = bounds.Max[2];
+
+    MarkDirty(p.Node);
+}
+
+// Flags the path to the root, stopping at the first node already flagged since everything above it is too
+void DynamicBVH::MarkDirty(uint32_t node)
+{
+    while (node != BVH_INVALID && !mNodes[node].Dirty)
+    {
+        mNodes[node].Dirty = 1;
+        node = mNodes[node].Parent;
+    }
+    mHasDirty = true;
+}
+
+void DynamicBVH::Refit()
+{
+    using Clock = std::chrono::high_resolution_clock;
+    const Clock::time_point refitStart = Clock::now();
+
+    if (mHasDirty && mRoot != BVH_INVALID)
+    {
+        // Parents come before children in the gathered order, so walking it backwards refits bottom up
+        std::vector<uint32_t>& dirty = GetNodeStack();
+        dirty.push_back(mRoot);
+        for (size_t i = 0; i != dirty.size(); ++i)
+        {
+            const Node& n = mNodes[dirty[i]];
+            for (uint32_t slot = 0; slot != n.Count; ++slot)
+            {
+                const uint32_t child = n.Children[slot];
+                if (!(child & BVH_LEAF_BIT) && mNodes[child].Dirty)
+                    dirty.push_back(child);
+            }
+        }
+
+        for (size_t i = dirty.size(); i-- != 0; )
+        {
+            const uint32_t node = dirty[i];
+            mNodes[node].Dirty = 0;
+
+            const uint32_t parent = mNodes[node].Parent;
+            if (parent == BVH_INVALID)
+                continue;
+
+            uint32_t slot = 0;
+            while (mNodes[parent].Children[slot] != node)
+                slot++;
+            SetSlot(parent, slot, node, GetNodeBounds(node));
+        }
+    }
+
+    mHasDirty = false;
+    mRefitMs = std::chrono::duration<double, std::milli>(Clock::now() - refitStart).count();
+}
+
+void DynamicBVH::Rebuild()
+{
+    using Clock = std::chrono::high_resolution_clock;
+    const Clock::time_point rebuildStart = Clock::now();
+
+    std::vector<BuildItem> items;
+    items.reserve(mNumProxies);
+    for (uint32_t proxy = 0; proxy != mProxies.size(); ++proxy)
+    {
+        if (mProxies[proxy].Slot == BVH_INVALID)
+            continue;
+
+        BuildItem item;
+        item.Bounds = mProxies[proxy].Bounds;
+        for (uint32_t axis = 0; axis != 3; ++axis)
+            item.Centroid[axis] = 0.5f * (item.Bounds.Min[axis] + item.Bounds.Max[axis]);
+        item.Proxy = proxy;
+        items.push_back(item);
+    }
+
+    // Fresh nodes are allocated depth first, so a subtree ends up close together in memory
+    mNodes.clear();
+    mNodes.reserve(items.size() / 2 + 1);
+    mFreeNode = BVH_INVALID;
+    mNumNodes = 0;
+    mRoot = BVH_INVALID;
+    mHasDirty = false;
+
+    if (!items.empty())
+        mRoot = BuildNode(items, 0, static_cast<uint32_t>(items.size()), BVH_INVALID);
+
+    mRebuildMs = std::chrono::duration<double, std::milli>(Clock::now() - rebuildStart).count();
+}
+
+namespace
+{
+    // Picks the binned SAH split of [begin, end) and partitions around it. Falls back to a median split
+    // when centroids coincide or every object lands in the same bin.
+    template <typename Item>
+    uint32_t PartitionSAH(std::vector<Item>& items, uint32_t begin, uint32_t end)
+    {
+        float centroidMin[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+        float centroidMax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+        for (uint32_t i = begin; i != end; ++i)
+        {
+            for (uint32_t axis = 0; axis != 3; ++axis)
+            {
+                centroidMin[axis] = std::min(centroidMin[axis], items[i].Centroid[axis]);
+                centroidMax[axis] = std::max(centroidMax[axis], items[i].Centroid[axis]);
+            }
+        }
+
+        float bestCost = FLT_MAX;
+        uint32_t bestAxis = 0;
+        uint32_t bestBin = 0;
+        float bestScale = 0.0f;
+        for (uint32_t axis = 0; axis != 3; ++axis)
+        {
+            const float extent = centroidMax[axis] - centroidMin[axis];
+            if (extent <= 0.0f)
+                continue;
+
+            const float scale = kNumSAHBins / extent;
+            uint32_t binCounts[kNumSAHBins] = {};
+            BVHBounds binBounds[kNumSAHBins];
+            for (BVHBounds& b : binBounds)
+                b = EmptyBounds();
+
+            for (uint32_t i = begin; i != end; ++i)
+            {
+                const uint32_t bin = std::min(kNumSAHBins - 1, static_cast<uint32_t>((items[i].Centroid[axis] - centroidMin[axis]) * scale));
+                binCounts[bin]++;
+                binBounds[bin] = Union(binBounds[bin], items[i].Bounds);
+            }
+
+            // Sweep from the right for the areas and counts of every right side, then from the left to cost each split
+            float rightArea[kNumSAHBins];
+            uint32_t rightCount[kNumSAHBins];
+            BVHBounds running = EmptyBounds();
+            uint32_t count = 0;
+            for (uint32_t bin = kNumSAHBins; bin-- != 1; )
+            {
+                running = Union(running, binBounds[bin]);
+                count += binCounts[bin];
+                rightArea[bin] = SurfaceArea(running);
+                rightCount[bin] = count;
+            }
+
+            running = EmptyBounds();
+            count = 0;
+            for (uint32_t bin = 0; bin != kNumSAHBins - 1; ++bin)
+            {
+                running = Union(running, binBounds[bin]);
+                count += binCounts[bin];
+                if (count == 0 || rightCount[bin + 1] == 0)
+                    continue;
+
+                const float cost = SurfaceArea(running) * count + rightArea[bin + 1] * rightCount[bin + 1];
+                if (cost < bestCost)
+                {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestBin = bin;
+                    bestScale = scale;
+                }
+            }
+        }
+
+        if (bestCost < FLT_MAX)
+        {
+            const float axisMin = centroidMin[bestAxis];
+            const auto it = std::partition(items.begin() + begin, items.begin() + end, [=](const Item& item)
+            {
+                return std::min(kNumSAHBins - 1, static_cast<uint32_t>((item.Centroid[bestAxis] - axisMin) * bestScale)) <= bestBin;
+            });
+
+            const uint32_t mid = static_cast<uint32_t>(it - items.begin());
+            if (mid != begin && mid != end)
+                return mid;
+        }
+
+        uint32_t longestAxis = 0;
+        for (uint32_t axis = 1; axis != 3; ++axis)
+        {
+            if (centroidMax[axis] - centroidMin[axis] > centroidMax[longestAxis] - centroidMin[longestAxis])
+                longestAxis = axis;
+        }
+
+        const uint32_t mid = begin + (end - begin) / 2;
+        std::nth_element(items.begin() + begin, items.begin() + mid, items.begin() + end, [=](const Item& a, const Item& b)
+        {
+            return a.Centroid[longestAxis] < b.Centroid[longestAxis];
+        });
+        return mid;
+    }
+}
+
+// Two levels of binary SAH splits give up to four children. Ranges of one object become leaf slots.
+uint32_t DynamicBVH::BuildNode(std::vector<BuildItem>& items, uint32_t begin, uint32_t end, uint32_t parent)
+{
+    const uint32_t node = AllocNode(parent);
+
+    uint32_t ranges[BVH_WIDTH][2];
+    uint32_t numRanges = 0;
+    if (end - begin <= BVH_WIDTH)
+    {
+        for (uint32_t i = begin; i != end; ++i)
+        {
+            ranges[numRanges][0] = i;
+            ranges[numRanges][1] = i + 1;
+            numRanges++;
+        }
+    }
+    else
+    {
+        const uint32_t mid = PartitionSAH(items, begin, end);
+        const uint32_t halves[2][2] = { { begin, mid }, { mid, end } };
+        for (const uint32_t* half : halves)
+        {
+            if (half[1] - half[0] == 1)
+            {
+                ranges[numRanges][0] = half[0];
+                ranges[numRanges][1] = half[1];
+                numRanges++;
+                continue;
+            }
+
+            const uint32_t quarter = PartitionSAH(items, half[0], half[1]);
+            ranges[numRanges][0] = half[0];
+            ranges[numRanges][1] = quarter;
+            ranges[numRanges + 1][0] = quarter;
+            ranges[numRanges + 1][1] = half[1];
+            numRanges += 2;
+        }
+    }
+
+    for (uint32_t slot = 0; slot != numRanges; ++slot)
+    {
+        const uint32_t rangeBegin = ranges[slot][0];
+        const uint32_t rangeEnd = ranges[slot][1];
+        if (rangeEnd - rangeBegin == 1)
+        {
+            SetSlot(node, slot, items[rangeBegin].Proxy | BVH_LEAF_BIT, items[rangeBegin].Bounds);
+        }
+        else
+        {
+            const uint32_t child = BuildNode(items, rangeBegin, rangeEnd, node);
+            SetSlot(node, slot, child, GetNodeBounds(child));
+        }
+    }
+
+    mNodes[node].Count = numRanges;
+    return node;
+}
+
+void DynamicBVH::Clear()
+{
+    mNodes.clear();
+    mProxies.clear();
+    mRoot = BVH_INVALID;
+    mFreeNode = BVH_INVALID;
+    mFreeProxy = BVH_INVALID;
+    mNumNodes = 0;
+    mNumProxies = 0;
+    mHasDirty = false;
+}
+
+void DynamicBVH::GatherLeaves(uint32_t node, std::vector<uint32_t>& out_userData) const
+{
+    // Called from inside other traversals, so this one can't share their stack
+    std::vector<uint32_t> stack(1, node);
+    while (!stack.empty())
+    {
+        const Node& n = mNodes[stack.back()];
+        stack.pop_back();
+
+        for (uint32_t slot = 0; slot != n.Count; ++slot)
+        {
+            const uint32_t child = n.Children[slot];
+            if (child & BVH_LEAF_BIT)
+                out_userData.push_back(mProxies[child & ~BVH_LEAF_BIT].UserData);
+            else
+                stack.push_back(child);
+        }
+    }
+}
+
+// Children entirely inside the frustum have their whole subtree reported without further plane tests
+void DynamicBVH::QueryFrustum(const Frustum& frustum, std::vector<uint32_t>& out_userData) const
+{
+    if (mRoot == BVH_INVALID)
+        return;
+
+    std::vector<uint32_t>& stack = GetNodeStack();
+    stack.push_back(mRoot);
+
+    const Float4 half = Splat4(0.5f);
+    while (!stack.empty())
+    {
+        const uint32_t node = stack.back();
+        stack.pop_back();
+        const Node& n = mNodes[node];
+
+        const Float4 minX = Load4(n.MinX), minY = Load4(n.MinY), minZ = Load4(n.MinZ);
+        const Float4 maxX = Load4(n.MaxX), maxY = Load4(n.MaxY), maxZ = Load4(n.MaxZ);
+        const Float4 cx = Mul4(Add4(minX, maxX), half), cy = Mul4(Add4(minY, maxY), half), cz = Mul4(Add4(minZ, maxZ), half);
+        const Float4 ex = Mul4(Sub4(maxX, minX), half), ey = Mul4(Sub4(maxY, minY), half), ez = Mul4(Sub4(maxZ, minZ), half);
+
+        uint32_t touching = (1u << n.Count) - 1;
+        uint32_t contained = touching;
+        for (uint32_t p = 0; p != Frustum::COUNT && touching; ++p)
+        {
+            const Float4 dist = Add4(Add4(Mul4(Splat4(frustum.NormalX[p]), cx), Mul4(Splat4(frustum.NormalY[p]), cy)),
+                                     Add4(Mul4(Splat4(frustum.NormalZ[p]), cz), Splat4(frustum.D[p])));
+            const Float4 reach = Add4(Add4(Mul4(Splat4(fabsf(frustum.NormalX[p])), ex), Mul4(Splat4(fabsf(frustum.NormalY[p])), ey)),
+                                      Mul4(Splat4(fabsf(frustum.NormalZ[p])), ez));
+
+            touching &= MoveMask4(GreaterEqual4(Add4(dist, reach), Splat4(0.0f)));
+            contained &= MoveMask4(GreaterEqual4(Sub4(dist, reach), Splat4(0.0f)));
+        }
+
+        for (uint32_t slot = 0; slot != n.Count; ++slot)
+        {
+            if (!(touching & (1u << slot)))
+                continue;
+
+            const uint32_t child = n.Children[slot];
+            if (child & BVH_LEAF_BIT)
+                out_userData.push_back(mProxies[child & ~BVH_LEAF_BIT].UserData);
+            else if (contained & (1u << slot))
+                GatherLeaves(child, out_userData);
+            else
+                stack.push_back(child);
+        }
+    }
+}
+
+void DynamicBVH::QuerySphere(const float center[3], float radius, std::vector<uint32_t>& out_userData) const
+{
+    if (mRoot == BVH_INVALID)
+        return;
+
+    std::vector<uint32_t>& stack = GetNodeStack();
+    stack.push_back(mRoot);
+
+    const Float4 cx = Splat4(center[0]), cy = Splat4(center[1]), cz = Splat4(center[2]);
+    const Float4 radiusSq = Splat4(radius * radius);
+    const Float4 zero = Splat4(0.0f);
+    while (!stack.empty())
+    {
+        const uint32_t node = stack.back();
+        stack.pop_back();
+        const Node& n = mNodes[node];
+
+        const Float4 minX = Load4(n.MinX), minY = Load4(n.MinY), minZ = Load4(n.MinZ);
+        const Float4 maxX = Load4(n.MaxX), maxY = Load4(n.MaxY), maxZ = Load4(n.MaxZ);
+
+        // Nearest point of each box decides whether it's touched, the furthest corner whether it's contained
+        const Float4 nearX = Max4(Max4(Sub4(minX, cx), Sub4(cx, maxX)), zero);
+        const Float4 nearY = Max4(Max4(Sub4(minY, cy), Sub4(cy, maxY)), zero);
+        const Float4 nearZ = Max4(Max4(Sub4(minZ, cz), Sub4(cz, maxZ)), zero);
+        const Float4 farX = Max4(Sub4(cx, minX), Sub4(maxX, cx));
+        const Float4 farY = Max4(Sub4(cy, minY), Sub4(maxY, cy));
+        const Float4 farZ = Max4(Sub4(cz, minZ), Sub4(maxZ, cz));
+
+        const Float4 nearSq = Add4(Add4(Mul4(nearX, nearX), Mul4(nearY, nearY)), Mul4(nearZ, nearZ));
+        const Float4 farSq = Add4(Add4(Mul4(farX, farX), Mul4(farY, farY)), Mul4(farZ, farZ));
+
+        const uint32_t used = (1u << n.Count) - 1;
+        const uint32_t touching = MoveMask4(LessEqual4(nearSq, radiusSq)) & used;
+        const uint32_t contained = MoveMask4(LessEqual4(farSq, radiusSq)) & used;
+
+        for (uint32_t slot = 0; slot != n.Count; ++slot)
+        {
+            if (!(touching & (1u << slot)))
+                continue;
+
+            const uint32_t child = n.Children[slot];
+            if (child & BVH_LEAF_BIT)
+                out_userData.push_back(mProxies[child & ~BVH_LEAF_BIT].UserData);
+            else if (contained & (1u << slot))
+                GatherLeaves(child, out_userData);
+            else
+                stack.push_back(child);
+        }
+    }
+}
+
+// Slab tests against all four children at once. Hit children are pushed far to near so the nearest is visited
+// first, and anything entering beyond the closest hit so far is skipped when popped.
+bool DynamicBVH::RayCast(const float origin[3], const float dir[3], float maxT, BVHRayHit& out_hit) const
+{
+    if (mRoot == BVH_INVALID)
+        return false;
+
+    struct StackEntry
+    {
+        uint32_t Node;
+        float TNear;
+    };
+
+    static thread_local std::vector<StackEntry> stack;
+    stack.clear();
+    stack.push_back({ mRoot, 0.0f });
+
+    const Float4 ox = Splat4(origin[0]), oy = Splat4(origin[1]), oz = Splat4(origin[2]);
+    const Float4 invX = Splat4(1.0f / dir[0]), invY = Splat4(1.0f / dir[1]), invZ = Splat4(1.0f / dir[2]);
+    const Float4 zero = Splat4(0.0f);
+
+    float bestT = maxT;
+    uint32_t bestProxy = BVH_INVALID;
+    while (!stack.empty())
+    {
+        const StackEntry entry = stack.back();
+        stack.pop_back();
+        if (entry.TNear > bestT)
+            continue;
+
+        const Node& n = mNodes[entry.Node];
+        const Float4 t1x = Mul4(Sub4(Load4(n.MinX), ox), invX), t2x = Mul4(Sub4(Load4(n.MaxX), ox), invX);
+        const Float4 t1y = Mul4(Sub4(Load4(n.MinY), oy), invY), t2y = Mul4(Sub4(Load4(n.MaxY), oy), invY);
+        const Float4 t1z = Mul4(Sub4(Load4(n.MinZ), oz), invZ), t2z = Mul4(Sub4(Load4(n.MaxZ), oz), invZ);
+
+        const Float4 tNear = Max4(Max4(Max4(Min4(t1x, t2x), Min4(t1y, t2y)), Min4(t1z, t2z)), zero);
+        const Float4 tFar = Min4(Min4(Max4(t1x, t2x), Max4(t1y, t2y)), Max4(t1z, t2z));
+        const uint32_t hits = MoveMask4(And4(LessEqual4(tNear, tFar), LessEqual4(tNear, Splat4(bestT)))) & ((1u << n.Count) - 1);
+        if (!hits)
+            continue;
+
+        alignas(16) float nearT[BVH_WIDTH];
+        Store4(nearT, tNear);
+
+        StackEntry children[BVH_WIDTH];
+        uint32_t numChildren = 0;
+        for (uint32_t slot = 0; slot != n.Count; ++slot)
+        {
+            if (!(hits & (1u << slot)) || nearT[slot] > bestT)
+                continue;
+
+            const uint32_t child = n.Children[slot];
+            if (child & BVH_LEAF_BIT)
+            {
+                bestT = nearT[slot];
+                bestProxy = child & ~BVH_LEAF_BIT;
+                continue;
+            }
+
+            // Insertion sort by distance, furthest first
+            uint32_t i = numChildren++;
+            for (; i > 0 && children[i - 1].TNear < nearT[slot]; --i)
+                children[i] = children[i - 1];
+            children[i] = { child, nearT[slot] };
+        }
+
+        for (uint32_t i = 0; i != numChildren; ++i)
+        {
+            if (children[i].TNear <= bestT)
+                stack.push_back(children[i]);
+        }
+    }
+
+    if (bestProxy == BVH_INVALID)
+        return false;
+
+    out_hit.Proxy = bestProxy;
+    out_hit.UserData = mProxies[bestProxy].UserData;
+    out_hit.T = bestT;
+    return true;
+}
+
+// Each internal node costs one visit, made with probability proportional to its surface area
+float DynamicBVH::GetSAHCost() const
+{
+    if (mRoot == BVH_INVALID)
+        return 0.0f;
+
+    const float rootArea = SurfaceArea(GetNodeBounds(mRoot));
+    if (rootArea <= 0.0f)
+        return 1.0f;
+
+    float cost = 1.0f;
+    std::vector<uint32_t> stack(1, mRoot);
+    while (!stack.empty())
+    {
+        const uint32_t node = stack.back();
+        stack.pop_back();
+
+        const Node& n = mNodes[node];
+        for (uint32_t slot = 0; slot != n.Count; ++slot)
+        {
+            const uint32_t child = n.Children[slot];
+            if (child & BVH_LEAF_BIT)
+                continue;
+
+            cost += SurfaceArea(GetSlotBounds(node, slot)) / rootArea;
+            stack.push_back(child);
+        }
+    }
+    return cost;
+}
+
+BVHStats DynamicBVH::GetStats() const
+{
+    BVHStats stats;
+    stats.NumProxies = mNumProxies;
+    stats.NumNodes = mNumNodes;
+    stats.SAHCost = GetSAHCost();
+    stats.RefitMs = mRefitMs;
+    stats.RebuildMs = mRebuildMs;
+
+    if (mRoot != BVH_INVALID)
+    {
+        std::vector<std::pair<uint32_t, uint32_t>> stack(1, std::make_pair(mRoot, 1u));
+        while (!stack.empty())
+        {
+            const std::pair<uint32_t, uint32_t> entry = stack.back();
+            stack.pop_back();
+            stats.MaxDepth = std::max(stats.MaxDepth, entry.second);
+
+            const Node& n = mNodes[entry.first];
+            for (uint32_t slot = 0; slot != n.Count; ++slot)
+            {
+                if (!(n.Children[slot] & BVH_LEAF_BIT))
+                    stack.push_back(std::make_pair(n.Children[slot], entry.second + 1));
+            }
+        }
+    }
+    return stats;
+}
+
+}
@@ -0,0 +1,138 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Dynamic 4-wide bounding volume hierarchy for scene queries
+----------------------------------------------*/
+#ifndef MUON_BVH_H
+#define MUON_BVH_H
+
+#include <stdint.h>
+#include <vector>
+
+namespace Muon
+{
+struct Frustum;
+
+static const uint32_t BVH_WIDTH = 4;
+static const uint32_t BVH_INVALID = 0xFFFFFFFF;
+
+struct BVHBounds
+{
+    float Min[3];
+    float Max[3];
+};
+
+struct BVHRayHit
+{
+    uint32_t Proxy = BVH_INVALID;
+    uint32_t UserData = 0;
+    float T = 0.0f; // Where the ray enters the object's box, 0 if it starts inside
+};
+
+struct BVHStats
+{
+    uint32_t NumProxies = 0;
+    uint32_t NumNodes = 0;
+    uint32_t MaxDepth = 0;
+    float SAHCost = 0.0f;   // Expected node visits for a ray that hits the root, lower is better
+    double RefitMs = 0.0;   // Last Refit
+    double RebuildMs = 0.0; // Last Rebuild
+};
+
+// Objects are leaves stored directly in the child slots of 4-wide nodes, with the children's boxes laid out
+// as arrays so one node visit tests all four at once.
+//
+// Insert and Remove keep the tree valid incrementally. Moving objects either go through Update, which only
+// writes the new box and leaves the structure alone until the next Refit, or through Remove and Insert.
+// Refits are cheap but let the tree's quality drift as objects move apart; Rebuild restores it with a full
+// SAH build, and GetSAHCost gives a way to decide when that's worth it. Queries must not run between an
+// Update and the following Refit.
+//
+// Insertion is greedy, and spatially sorted streams of inserts build long chains. Bulk loads should Rebuild after.
+class DynamicBVH
+{
+public:
+    // Returns a proxy handle for Remove and Update. userData is what queries report back.
+    uint32_t Insert(const BVHBounds& bounds, uint32_t userData);
+    void Remove(uint32_t proxy);
+    void Update(uint32_t proxy, const BVHBounds& bounds);
+
+    // Recomputes the boxes above every leaf touched by Update since the last Refit
+    void Refit();
+
+    // Rebuilds the whole tree top down with binned SAH splits. Proxy handles stay valid.
+    void Rebuild();
+
+    void Clear();
+
+    // Append the user data of every object whose box touches the volume
+    void QueryFrustum(const Frustum& frustum, std::vector<uint32_t>& out_userData) const;
+    void QuerySphere(const float center[3], float radius, std::vector<uint32_t>& out_userData) const;
+
+    // Closest box along the ray within maxT. dir doesn't need to be normalized, T is in units of its length.
+    bool RayCast(const float origin[3], const float dir[3], float maxT, BVHRayHit& out_hit) const;
+
+    const BVHBounds& GetBounds(uint32_t proxy) const { return mProxies[proxy].Bounds; }
+    uint32_t GetUserData(uint32_t proxy) const { return mProxies[proxy].UserData; }
+
+    float GetSAHCost() const;
+    BVHStats GetStats() const;
+
+private:
+    struct alignas(64) Node
+    {
+        float MinX[BVH_WIDTH], MinY[BVH_WIDTH], MinZ[BVH_WIDTH];
+        float MaxX[BVH_WIDTH], MaxY[BVH_WIDTH], MaxZ[BVH_WIDTH];
+        uint32_t Children[BVH_WIDTH]; // Node index, or a proxy with BVH_LEAF_BIT set. Slots [0, Count) are used.
+        uint32_t Parent;
+        uint32_t Count;
+        uint32_t Dirty;
+        uint32_t NextFree;
+    };
+
+    struct Proxy
+    {
+        BVHBounds Bounds;
+        uint32_t UserData;
+        uint32_t Node;     // Node holding the leaf, or the next free proxy once removed
+        uint32_t Slot;
+    };
+
+    struct BuildItem
+    {
+        BVHBounds Bounds;
+        float Centroid[3];
+        uint32_t Proxy;
+    };
+
+    static const uint32_t BVH_LEAF_BIT = 0x80000000;
+
+    uint32_t AllocNode(uint32_t parent);
+    void FreeNode(uint32_t node);
+
+    void SetSlot(uint32_t node, uint32_t slot, uint32_t child, const BVHBounds& bounds);
+    BVHBounds GetSlotBounds(uint32_t node, uint32_t slot) const;
+    BVHBounds GetNodeBounds(uint32_t node) const;
+    void RemoveSlot(uint32_t node, uint32_t slot);
+    void RefitUpward(uint32_t node);
+    void MarkDirty(uint32_t node);
+
+    uint32_t BuildNode(std::vector<BuildItem>& items, uint32_t begin, uint32_t end, uint32_t parent);
+    void GatherLeaves(uint32_t node, std::vector<uint32_t>& out_userData) const;
+
+    std::vector<Node> mNodes;
+    std::vector<Proxy> mProxies;
+    uint32_t mRoot = BVH_INVALID;
+    uint32_t mFreeNode = BVH_INVALID;
+    uint32_t mFreeProxy = BVH_INVALID;
+    uint32_t mNumNodes = 0;
+    uint32_t mNumProxies = 0;
+    bool mHasDirty = false;
+
+    double mRefitMs = 0.0;
+    double mRebuildMs = 0.0;
+};
+
+}
+
+#endif
@@ -0,0 +1,144 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Minimal binary reader/writer used for on-disk caches
+----------------------------------------------*/
+#include <Core/BinaryStream.h>
+
+#if defined(_WIN32)
+#include <Core/WinApp.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <filesystem>
+#include <fstream>
+
+namespace Muon
+{
+
+bool BinaryWriter::SaveToFile(const wchar_t* path) const
+{
+    namespace fs = std::filesystem;
+
+    std::error_code ec;
+    fs::path filePath(path);
+    if (filePath.has_parent_path())
+        fs::create_directories(filePath.parent_path(), ec);
+
+    std::ofstream file(filePath, std::ios::binary | std::ios::trunc);
+    if (!file)
+        return false;
+
+    file.write(reinterpret_cast<const char*>(mBuffer.data()), mBuffer.size());
+    return file.good();
+}
+
+bool LoadFileBytes(const wchar_t* path, std::vector<uint8_t>& out_bytes)
+{
+    std::ifstream file(std::filesystem::path(path), std::ios::binary | std::ios::ate);
+    if (!file)
+        return false;
+
+    const std::streamsize size = file.tellg();
+    if (size < 0)
+        return false;
+
+    out_bytes.resize(static_cast<size_t>(size));
+    file.seekg(0, std::ios::beg);
+    return size == 0 || file.read(reinterpret_cast<char*>(out_bytes.data()), size).good();
+}
+
+#if defined(_WIN32)
+bool MappedFile::Open(const wchar_t* path)
+{
+    Close();
+
+    HANDLE file = CreateFileW(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart <= 0)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    const void* pView = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (!pView)
+    {
+        if (mapping)
+            CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    mFileHandle = file;
+    mMappingHandle = mapping;
+    mpData = static_cast<const uint8_t*>(pView);
+    mSize = static_cast<size_t>(size.QuadPart);
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (mpData)
+        UnmapViewOfFile(mpData);
+    if (mMappingHandle)
+        CloseHandle(mMappingHandle);
+    if (mFileHandle)
+        CloseHandle(mFileHandle);
+
+    mpData = nullptr;
+    mSize = 0;
+    mMappingHandle = nullptr;
+    mFileHandle = nullptr;
+}
+#else
+bool MappedFile::Open(const wchar_t* path)
+{
+    Close();
+
+    const int fd = open(std::filesystem::path(path).c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    void* pView = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    if (pView == MAP_FAILED)
+    {
+        close(fd);
+        return false;
+    }
+
+    mFileDescriptor = fd;
+    mpData = static_cast<const uint8_t*>(pView);
+    mSize = static_cast<size_t>(info.st_size);
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (mpData)
+        munmap(const_cast<uint8_t*>(mpData), mSize);
+    if (mFileDescriptor >= 0)
+        close(mFileDescriptor);
+
+    mpData = nullptr;
+    mSize = 0;
+    mFileDescriptor = -1;
+}
+#endif
+
+}
@@ -0,0 +1,145 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Minimal binary reader/writer used for on-disk caches
+----------------------------------------------*/
+#ifndef MUON_BINARYSTREAM_H
+#define MUON_BINARYSTREAM_H
+
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace Muon
+{
+
+// Appends trivially copyable values and length-prefixed strings to a byte array.
+class BinaryWriter
+{
+public:
+    template<typename T>
+    void Write(const T& value)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "BinaryWriter::Write requires a trivially copyable type");
+        WriteBytes(&value, sizeof(T));
+    }
+
+    void WriteBytes(const void* data, size_t size)
+    {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        mBuffer.insert(mBuffer.end(), bytes, bytes + size);
+    }
+
+    void WriteString(const std::string& str)
+    {
+        Write<uint32_t>(static_cast<uint32_t>(str.size()));
+        WriteBytes(str.data(), str.size());
+    }
+
+    const std::vector<uint8_t>& GetBuffer() const { return mBuffer; }
+    bool SaveToFile(const wchar_t* path) const;
+
+private:
+    std::vector<uint8_t> mBuffer;
+};
+
+// Reads back what BinaryWriter produced. Any out of bounds read puts the reader into a failed state instead of throwing.
+class BinaryReader
+{
+public:
+    BinaryReader() = default;
+    BinaryReader(const uint8_t* data, size_t size) : mpData(data), mSize(size) {}
+
+    template<typename T>
+    bool Read(T& out_value)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "BinaryReader::Read requires a trivially copyable type");
+        return ReadBytes(&out_value, sizeof(T));
+    }
+
+    bool ReadBytes(void* out_data, size_t size)
+    {
+        if (mFailed || size > mSize - mOffset)
+        {
+            mFailed = true;
+            return false;
+        }
+
+        memcpy(out_data, mpData + mOffset, size);
+        mOffset += size;
+        return true;
+    }
+
+    bool ReadString(std::string& out_str)
+    {
+        uint32_t length = 0;
+        if (!Read(length) || length > mSize - mOffset)
+        {
+            mFailed = true;
+            return false;
+        }
+
+        out_str.assign(reinterpret_cast<const char*>(mpData + mOffset), length);
+        mOffset += length;
+        return true;
+    }
+
+    // Reads an element count, failing early if it couldn't possibly fit in the remaining data
+    bool ReadCount(uint32_t& out_count)
+    {
+        out_count = 0;
+        if (!Read(out_count) || out_count > mSize - mOffset)
+        {
+            mFailed = true;
+            out_count = 0;
+            return false;
+        }
+        return true;
+    }
+
+    bool IsFailed() const { return mFailed; }
+    bool IsAtEnd() const { return mOffset == mSize; }
+
+private:
+    const uint8_t* mpData = nullptr;
+    size_t mSize = 0;
+    size_t mOffset = 0;
+    bool mFailed = false;
+};
+
+// Reads an entire file into memory. Returns false if the file doesn't exist or can't be read.
+bool LoadFileBytes(const wchar_t* path, std::vector<uint8_t>& out_bytes);
+
+// Read-only view of a whole file. The OS only pages data in as it's touched, so large files cost nothing until they're read.
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile() { Close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool Open(const wchar_t* path);
+    void Close();
+
+    bool IsOpen() const { return mpData != nullptr; }
+    const uint8_t* GetData() const { return mpData; }
+    size_t GetSize() const { return mSize; }
+
+private:
+    const uint8_t* mpData = nullptr;
+    size_t mSize = 0;
+#if defined(_WIN32)
+    void* mFileHandle = nullptr;
+    void* mMappingHandle = nullptr;
+#else
+    int mFileDescriptor = -1;
+#endif
+};
+
+}
+
+#endif
@@ -167,11 +167,16 @@ bool DefaultBuffer::Populate(void* data, size_t dataSize, UploadBuffer& stagingB
 	if (!pCommandList || !data || dataSize > mBufferSize)
 		return false;
 
-	void* mapped = stagingBuffer.Map();
-	memcpy(mapped, data, mBufferSize);
-	stagingBuffer.Unmap(0, 0);
+	// The staging buffer is expected to be mapped by the caller, so several buffers can be populated within one command list
+	void* mapped = nullptr;
+	D3D12_GPU_VIRTUAL_ADDRESS stagingGpuAddr;
+	UINT stagingOffset = 0;
+	if (!stagingBuffer.Allocate((UINT)dataSize, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT, mapped, stagingGpuAddr, stagingOffset))
+		return false;
+
+	memcpy(mapped, data, dataSize);
 
-	pCommandList->CopyBufferRegion(mpResource.Get(), 0, stagingBuffer.GetResource(), 0, mBufferSize);
+	pCommandList->CopyBufferRegion(mpResource.Get(), 0, stagingBuffer.GetResource(), stagingOffset, dataSize);
 
 	CD3DX12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(
 		mpResource.Get(),
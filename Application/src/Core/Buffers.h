@@ -50,6 +50,9 @@ struct UploadBuffer : Buffer
     bool CanAllocate(UINT desiredSize, UINT alignment);
     bool Allocate(UINT desiredSize, UINT alignment, void*& out_mappedPtr, D3D12_GPU_VIRTUAL_ADDRESS& out_gpuAddr, UINT& out_offset);
 
+    // Rewinds the write head. Only safe once the GPU is done reading everything allocated so far.
+    void ResetAllocations() { mOffset = 0; }
+
 private:
     UINT8* mMappedPtr = nullptr;
     size_t mOffset = 0; // The current offset into the buffer where allocations take place
@@ -6,42 +6,25 @@ Description : Declation of structs used as constant buffers by various shaders
 #ifndef CBUFFERSTRUCTS_H
 #define CBUFFERSTRUCTS_H
 
-#include <DirectXMath.h>
-#include <DirectXColors.h>
+#include <Generated/ShaderCBuffers.h>
 
-namespace Muon
-{
-
-struct alignas(16) cbCamera
-{
-    DirectX::XMFLOAT4X4 view;
-    DirectX::XMFLOAT4X4 proj;
-    DirectX::XMFLOAT4X4 viewProj;
-};
-
-struct alignas(16) cbPerEntity
-{
-    DirectX::XMFLOAT4X4 world;
-};
-
-struct alignas(16) DirectionalLight
-{
-    DirectX::XMFLOAT3 diffuseColor;
-    DirectX::XMFLOAT3 dir;
-};
+#include <Core/NameID.h>
 
-struct alignas(16) cbLights
+namespace Muon
 {
-    DirectX::XMFLOAT3A ambientColor;
-    DirectionalLight directionalLight;
-    DirectX::XMFLOAT3A cameraWorldPos;
-};
 
-struct alignas(16) cbMaterialParams
-{
-    DirectX::XMFLOAT4  colorTint = DirectX::XMFLOAT4(DirectX::Colors::Black);
-    float              specularExp = 0.0f;
-};
+// The layouts are generated from shader reflection by ShaderBuild (see Generated/ShaderCBuffers.h),
+// these are the names the engine uses for them.
+typedef cbVSCamera      cbCamera;
+typedef cbVSWorld       cbPerEntity;
+typedef cbPSLights      cbLights;
+typedef cbPSPerMaterial cbMaterialParams;
+
+// Reflected names of the constant buffers above, hashed at compile time
+constexpr NameID kVSCameraID      = NameID(cbVSCamera::kName);
+constexpr NameID kVSWorldID       = NameID(cbVSWorld::kName);
+constexpr NameID kPSLightsID      = NameID(cbPSLights::kName);
+constexpr NameID kPSPerMaterialID = NameID(cbPSPerMaterial::kName);
 
 }
 #endif
\ No newline at end of file
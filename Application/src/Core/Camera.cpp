@@ -4,6 +4,7 @@ Date : 2019/11
 Description : Implementation of Camera Class
 ----------------------------------------------*/
 #include "Camera.h"
+#include <Core/DXCore.h>
 #include <DirectXMath.h>
 
 namespace Muon 
@@ -47,15 +48,12 @@ void Camera::Init(DirectX::XMFLOAT3& pos, float aspectRatio, float nearPlane, fl
     mRight = XMVector3Normalize(XMVector3Cross(worldUp, mForward));
     mUp = XMVector3Cross(mForward, mRight);
 
-    mConstantBuffer.Create(L"CameraConstantBuffer", Muon::GetConstantBufferSize(sizeof(cbCamera)));
-
     UpdateView();
     UpdateProjection(aspectRatio);
 }
 
 void Camera::Destroy()
 {
-    mConstantBuffer.Destroy();
 }
 
 void Camera::UpdateView()
@@ -104,7 +102,10 @@ void Camera::UpdateProjection(float aspectRatio)
 
 void Camera::Bind(int32_t rootParamIndex, ID3D12GraphicsCommandList* pCommandList) const
 {
-    pCommandList->SetGraphicsRootConstantBufferView((UINT)rootParamIndex, mConstantBuffer.GetGPUVirtualAddress());
+    // Copied into the frame's upload buffer, so frames still in flight keep the camera they were recorded with
+    D3D12_GPU_VIRTUAL_ADDRESS gpuAddr;
+    if (Muon::AllocateFrameConstants(&mConstants, sizeof(mConstants), gpuAddr))
+        pCommandList->SetGraphicsRootConstantBufferView((UINT)rootParamIndex, gpuAddr);
 }
 
 void Camera::GetPosition3A(XMFLOAT3A* out_pos) const
@@ -153,14 +154,11 @@ void Camera::Rotate(XMVECTOR quatRotation)
 void Camera::UpdateConstantBuffer()
 {
     DirectX::XMMATRIX viewProj = XMMatrixMultiply(mView, mProjection);
-    cbCamera cb;
-    XMStoreFloat4x4(&cb.viewProj, viewProj);
-    XMStoreFloat4x4(&cb.view, mView);
-    XMStoreFloat4x4(&cb.proj, mProjection);
-
-    void* pMappedMemory = mConstantBuffer.Map();
-    memcpy(pMappedMemory, &cb, mConstantBuffer.GetBufferSize());
-    mConstantBuffer.Unmap(0, mConstantBuffer.GetBufferSize());
+    XMStoreFloat4x4(&mConstants.viewProj, viewProj);
+    XMStoreFloat4x4(&mConstants.view, mView);
+    XMStoreFloat4x4(&mConstants.proj, mProjection);
+
+    ExtractFrustumPlanes(&mConstants.viewProj.m[0][0], mFrustum);
 }
 
 }
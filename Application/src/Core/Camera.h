@@ -9,6 +9,7 @@ Description : Interface for Quaternion-Based Camera functionality
 #include "CBufferStructs.h"
 #include "DXCore.h"
 #include <Core/Buffers.h>
+#include <Core/Culling.h>
 
 //namespace DirectX
 //{
@@ -45,9 +46,11 @@ public:
     void UpdateProjection(float aspectRatio);
 
     void Bind(int32_t rootParamIndex, ID3D12GraphicsCommandList* pCommandList) const;
+    const cbCamera& GetConstants() const { return mConstants; }
 
     DirectX::XMMATRIX   GetView()           const  { return mView;         }
     DirectX::XMMATRIX   GetProjection()     const  { return mProjection;   }
+    const Frustum&      GetFrustum()        const  { return mFrustum;      }
     float               GetSensitivity()    const  { return mSensitivity;  }
     
     void GetPosition3A(DirectX::XMFLOAT3A* out_pos) const;
@@ -61,6 +64,9 @@ private:
     DirectX::XMMATRIX   mProjection;
     DirectX::XMFLOAT4X4 mViewProjection;
 
+    // World space, rebuilt whenever the view or projection changes
+    Frustum             mFrustum;
+
     // Camera's local axis and position
     DirectX::XMVECTOR   mForward;
     DirectX::XMVECTOR   mRight;
@@ -75,7 +81,8 @@ private:
     // Look Sensitivity
     float mSensitivity;
 
-    Muon::UploadBuffer mConstantBuffer;
+    // Uploaded to the current frame's transient buffer on Bind()
+    cbCamera mConstants;
 
     CameraMode mCameraMode;
 
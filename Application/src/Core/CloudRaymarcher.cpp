@@ -0,0 +1,543 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : CPU reference raymarcher for volumetric clouds. Ground truth for the cloud shaders, and a performance baseline.
+----------------------------------------------*/
+#include <Core/CloudRaymarcher.h>
+
+#include <Core/ImageWriter.h>
+#include <Core/JobSystem.h>
+#include <Core/NoiseVolume.h>
+#include <Core/Profiler.h>
+#include <Core/SIMD.h>
+#include <Utils/Utils.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <math.h>
+#include <string>
+
+namespace Muon
+{
+
+namespace
+{
+    using namespace SIMD;
+
+    static const uint32_t kTileSize = 16;          // Pixels along each side, even so tiles only hold whole packets
+    static const uint32_t kMaxImageSize = 16384;
+    static const float kMinTransmittance = 0.001f; // Rays stop marching once they're this opaque
+    static const float kPi = 3.14159265f;
+
+    uint32_t CountLanes(uint32_t laneMask)
+    {
+        return (laneMask & 1) + ((laneMask >> 1) & 1) + ((laneMask >> 2) & 1) + ((laneMask >> 3) & 1);
+    }
+
+    Float4 Saturate4(Float4 a)
+    {
+        return Min4(Max4(a, Splat4(0.0f)), Splat4(1.0f));
+    }
+
+    // Lanes where a > 0
+    uint32_t PositiveMask4(Float4 a)
+    {
+        return ~MoveMask4(LessEqual4(a, Splat4(0.0f))) & 0xF;
+    }
+
+    // Beer-Lambert only has to be exact here, so this stays a per-lane expf
+    Float4 Exp4(Float4 a)
+    {
+        float v[4];
+        Store4(v, a);
+        for (uint32_t l = 0; l != 4; ++l)
+            v[l] = expf(v[l]);
+        return Load4(v);
+    }
+
+    float HenyeyGreenstein(float cosTheta, float g)
+    {
+        const float denom = 1.0f + g * g - 2.0f * g * cosTheta;
+        return (1.0f - g * g) / (4.0f * kPi * denom * sqrtf(denom));
+    }
+
+    float LinearToSRGB(float c)
+    {
+        c = std::min(std::max(c, 0.0f), 1.0f);
+        return c <= 0.0031308f ? c * 12.92f : 1.055f * powf(c, 1.0f / 2.4f) - 0.055f;
+    }
+
+    // Trilinear and wrapping, like a sampler with WRAP addressing. Coordinates are in repeats of the volume.
+    void SampleVolume(const NoiseVolume& volume, float u, float v, float w, float out_rgba[4])
+    {
+        const int32_t size = static_cast<int32_t>(volume.Size);
+        const float coords[3] = { u, v, w };
+
+        // Wrapping the coordinate first leaves at most one texel to wrap, which saves an integer divide per axis
+        size_t offsets[3][2];
+        float weights[3];
+        for (uint32_t a = 0; a != 3; ++a)
+        {
+            // Shifted by a texel so the truncation below is a floor
+            const float texel = (coords[a] - floorf(coords[a])) * size + 0.5f;
+            int32_t i0 = static_cast<int32_t>(texel);
+            weights[a] = texel - i0;
+            i0 -= 1;
+            int32_t i1 = i0 + 1;
+            if (i0 < 0)
+                i0 += size;
+            if (i1 >= size)
+                i1 -= size;
+
+            const size_t pitch = a == 0 ? 4 : (a == 1 ? size_t(size) * 4 : size_t(size) * size * 4);
+            offsets[a][0] = i0 * pitch;
+            offsets[a][1] = i1 * pitch;
+        }
+
+        float corners[8][4];
+        const uint8_t* pVoxels = volume.Voxels.data();
+        for (uint32_t corner = 0; corner != 8; ++corner)
+        {
+            const uint8_t* pTexel = pVoxels + offsets[0][corner & 1] + offsets[1][(corner >> 1) & 1] + offsets[2][corner >> 2];
+            for (uint32_t c = 0; c != 4; ++c)
+                corners[corner][c] = pTexel[c];
+        }
+
+        for (uint32_t c = 0; c != 4; ++c)
+        {
+            const float y0 = corners[0][c] + (corners[1][c] - corners[0][c]) * weights[0];
+            const float y1 = corners[2][c] + (corners[3][c] - corners[2][c]) * weights[0];
+            const float y2 = corners[4][c] + (corners[5][c] - corners[4][c]) * weights[0];
+            const float y3 = corners[6][c] + (corners[7][c] - corners[6][c]) * weights[0];
+            const float z0 = y0 + (y1 - y0) * weights[1];
+            const float z1 = y2 + (y3 - y2) * weights[1];
+            out_rgba[c] = (z0 + (z1 - z0) * weights[2]) * (1.0f / 255.0f);
+        }
+    }
+
+    struct MarchContext
+    {
+        const CloudVolumes* pVolumes = nullptr;
+        const CloudLayerDesc* pDesc = nullptr;
+        float InvShapeTile = 0.0f;
+        float InvDetailTile = 0.0f;
+        float InvWeatherTile = 0.0f;
+        float InvThickness = 0.0f;
+        float SunDirection[3] = {};
+    };
+
+    Float4 HeightFraction4(const MarchContext& ctx, Float4 py)
+    {
+        return Saturate4(Mul4(Sub4(py, Splat4(ctx.pDesc->BottomHeight)), Splat4(ctx.InvThickness)));
+    }
+
+    // Extinction at four points. Lanes outside laneMask or the layer are zero. Each volume is only fetched for lanes
+    // the cheaper ones before it left with some density, like the shader's cheap/expensive split.
+    Float4 SampleExtinction4(const MarchContext& ctx, Float4 px, Float4 py, Float4 pz, uint32_t laneMask)
+    {
+        const CloudLayerDesc& desc = *ctx.pDesc;
+        const CloudVolumes& volumes = *ctx.pVolumes;
+
+        float x[4], y[4], z[4];
+        Store4(x, px);
+        Store4(y, py);
+        Store4(z, pz);
+
+        float coverage[4] = {}, cloudType[4] = {};
+        for (uint32_t l = 0; l != 4; ++l)
+        {
+            if (!(laneMask & (1u << l)) || y[l] <= desc.BottomHeight || y[l] >= desc.TopHeight)
+                continue;
+
+            float texel[4];
+            SampleVolume(*volumes.pWeather, x[l] * ctx.InvWeatherTile, z[l] * ctx.InvWeatherTile, desc.WeatherTime, texel);
+            coverage[l] = texel[0];
+            cloudType[l] = texel[1];
+        }
+
+        const Float4 zero = Splat4(0.0f);
+        const Float4 one = Splat4(1.0f);
+        const Float4 h = HeightFraction4(ctx, py);
+
+        // Flat bottoms, and tops rounded off at a height that grows from stratus (type 0) to cumulus (type 1)
+        const Float4 cloudTop = Add4(Splat4(0.25f), Mul4(Load4(cloudType), Splat4(0.75f)));
+        const Float4 bottomFade = Saturate4(Mul4(h, Splat4(1.0f / 0.07f)));
+        const Float4 topFade = Saturate4(Div4(Sub4(cloudTop, h), Mul4(cloudTop, Splat4(0.25f))));
+        const Float4 gradient = Mul4(bottomFade, topFade);
+        const Float4 cov = Saturate4(Mul4(Load4(coverage), Splat4(2.0f * desc.Coverage)));
+
+        // The shape can't exceed the height gradient, so lanes where that alone stays under the coverage cut-off are empty
+        const uint32_t shapeMask = PositiveMask4(Sub4(gradient, Sub4(one, cov))) & laneMask;
+        if (!shapeMask)
+            return zero;
+
+        float shape[4][4] = {}; // [channel][lane]
+        for (uint32_t l = 0; l != 4; ++l)
+        {
+            if (!(shapeMask & (1u << l)))
+                continue;
+
+            float texel[4];
+            SampleVolume(*volumes.pShape, x[l] * ctx.InvShapeTile, y[l] * ctx.InvShapeTile, z[l] * ctx.InvShapeTile, texel);
+            for (uint32_t c = 0; c != 4; ++c)
+                shape[c][l] = texel[c];
+        }
+
+        // Perlin-Worley dilated by the Worley octaves, remap(R, fbm - 1, 1, 0, 1)
+        const Float4 shapeFbm = Add4(Add4(Mul4(Load4(shape[1]), Splat4(0.625f)), Mul4(Load4(shape[2]), Splat4(0.25f))), Mul4(Load4(shape[3]), Splat4(0.125f)));
+        Float4 base = Div4(Sub4(Load4(shape[0]), Sub4(shapeFbm, one)), Sub4(Splat4(2.0f), shapeFbm));
+        base = Mul4(Saturate4(base), gradient);
+
+        // remap(base, 1 - coverage, 1, 0, 1) * coverage
+        base = Min4(Max4(Sub4(base, Sub4(one, cov)), zero), cov);
+
+        const uint32_t detailMask = PositiveMask4(base) & shapeMask;
+        if (!detailMask)
+            return zero;
+
+        float detail[3][4] = {};
+        for (uint32_t l = 0; l != 4; ++l)
+        {
+            if (!(detailMask & (1u << l)))
+                continue;
+
+            float texel[4];
+            SampleVolume(*volumes.pDetail, x[l] * ctx.InvDetailTile, y[l] * ctx.InvDetailTile, z[l] * ctx.InvDetailTile, texel);
+            for (uint32_t c = 0; c != 3; ++c)
+                detail[c][l] = texel[c];
+        }
+
+        // Wispy towards the bottom of the layer and billowy towards the top
+        const Float4 detailFbm = Add4(Add4(Mul4(Load4(detail[0]), Splat4(0.625f)), Mul4(Load4(detail[1]), Splat4(0.25f))), Mul4(Load4(detail[2]), Splat4(0.125f)));
+        const Float4 billow = Saturate4(Mul4(h, Splat4(10.0f)));
+        const Float4 modifier = Add4(detailFbm, Mul4(Sub4(Sub4(one, detailFbm), detailFbm), billow));
+        const Float4 erosion = Mul4(modifier, Splat4(desc.DetailStrength));
+
+        const Float4 density = Saturate4(Div4(Sub4(base, erosion), Sub4(one, erosion)));
+        return Mul4(density, Splat4(desc.Extinction));
+    }
+
+    struct PacketResult
+    {
+        float Radiance[3][4];
+        float Transmittance[4];
+        uint64_t NumSamples;
+    };
+
+    // Marches the 4 rays of a packet together. Every ray takes NumSteps steps over its own span through the layer,
+    // so the lanes stay in lockstep even though their step lengths differ.
+    void MarchPacket(const MarchContext& ctx, const float origin[3][4], const float dir[3][4], const float tStart[4], const float tEnd[4],
+        PacketResult& out_result)
+    {
+        const CloudLayerDesc& desc = *ctx.pDesc;
+        out_result.NumSamples = 0;
+
+        float stepLength[4], sunPhase[3][4];
+        uint32_t active = 0;
+        for (uint32_t l = 0; l != 4; ++l)
+        {
+            stepLength[l] = 0.0f;
+            if (tEnd[l] > tStart[l])
+            {
+                stepLength[l] = (tEnd[l] - tStart[l]) / desc.NumSteps;
+                active |= 1u << l;
+            }
+
+            // The sun is a directional light, so the phase function only depends on the ray
+            const float cosTheta = dir[0][l] * ctx.SunDirection[0] + dir[1][l] * ctx.SunDirection[1] + dir[2][l] * ctx.SunDirection[2];
+            const float forward = HenyeyGreenstein(cosTheta, desc.ForwardScattering);
+            const float back = HenyeyGreenstein(cosTheta, desc.BackScattering);
+            const float phase = forward + (back - forward) * desc.BackScatterWeight;
+            for (uint32_t c = 0; c != 3; ++c)
+                sunPhase[c][l] = desc.SunColor[c] * phase * desc.Albedo;
+        }
+
+        const Float4 ox = Load4(origin[0]), oy = Load4(origin[1]), oz = Load4(origin[2]);
+        const Float4 dx = Load4(dir[0]), dy = Load4(dir[1]), dz = Load4(dir[2]);
+        const Float4 t0 = Load4(tStart);
+        const Float4 dt = Load4(stepLength);
+        const Float4 sun[3] = { Load4(sunPhase[0]), Load4(sunPhase[1]), Load4(sunPhase[2]) };
+
+        const float lightStep = desc.LightMarchDistance / desc.NumLightSteps;
+        const Float4 one = Splat4(1.0f);
+
+        Float4 transmittance = one;
+        Float4 radiance[3] = { Splat4(0.0f), Splat4(0.0f), Splat4(0.0f) };
+
+        for (uint32_t s = 0; s != desc.NumSteps && active; ++s)
+        {
+            const Float4 t = Add4(t0, Mul4(dt, Splat4(s + 0.5f)));
+            const Float4 px = Add4(ox, Mul4(dx, t));
+            const Float4 py = Add4(oy, Mul4(dy, t));
+            const Float4 pz = Add4(oz, Mul4(dz, t));
+
+            const Float4 extinction = SampleExtinction4(ctx, px, py, pz, active);
+            out_result.NumSamples += CountLanes(active);
+
+            const uint32_t lit = PositiveMask4(extinction) & active;
+            if (!lit)
+                continue;
+
+            // Optical depth towards the sun
+            Float4 opticalDepth = Splat4(0.0f);
+            for (uint32_t j = 0; j != desc.NumLightSteps; ++j)
+            {
+                const float d = (j + 0.5f) * lightStep;
+                const Float4 qx = Add4(px, Splat4(ctx.SunDirection[0] * d));
+                const Float4 qy = Add4(py, Splat4(ctx.SunDirection[1] * d));
+                const Float4 qz = Add4(pz, Splat4(ctx.SunDirection[2] * d));
+                opticalDepth = Add4(opticalDepth, SampleExtinction4(ctx, qx, qy, qz, lit));
+                out_result.NumSamples += CountLanes(lit);
+            }
+            const Float4 sunTransmittance = Exp4(Mul4(opticalDepth, Splat4(-lightStep)));
+
+            // Brighter towards the top of the layer, a cheap stand-in for occlusion of the sky
+            const Float4 ambientScale = Add4(Splat4(0.5f), Mul4(HeightFraction4(ctx, py), Splat4(0.5f)));
+
+            // Integrating the in-scattering analytically over the step (Hillaire 2015) keeps dense steps energy conserving.
+            // The scattering coefficient is albedo * extinction, which cancels against the integral's 1 / extinction.
+            const Float4 stepTransmittance = Exp4(Mul4(extinction, Sub4(Splat4(0.0f), dt)));
+            const Float4 weight = Mul4(transmittance, Sub4(one, stepTransmittance));
+            for (uint32_t c = 0; c != 3; ++c)
+            {
+                const Float4 ambient = Mul4(ambientScale, Splat4(desc.AmbientColor[c] * desc.Albedo));
+                const Float4 scattered = Add4(Mul4(sun[c], sunTransmittance), ambient);
+                radiance[c] = Add4(radiance[c], Mul4(weight, scattered));
+            }
+
+            transmittance = Mul4(transmittance, stepTransmittance);
+            active &= MoveMask4(GreaterEqual4(transmittance, Splat4(kMinTransmittance)));
+        }
+
+        for (uint32_t c = 0; c != 3; ++c)
+            Store4(out_result.Radiance[c], radiance[c]);
+        Store4(out_result.Transmittance, transmittance);
+    }
+
+    // Row-vector convention, p = [x y z 1] * M
+    void Unproject(const float m[16], float ndcX, float ndcY, float ndcZ, double out_point[3])
+    {
+        double v[4];
+        for (uint32_t c = 0; c != 4; ++c)
+            v[c] = double(ndcX) * m[c] + double(ndcY) * m[4 + c] + double(ndcZ) * m[8 + c] + m[12 + c];
+
+        for (uint32_t c = 0; c != 3; ++c)
+            out_point[c] = v[c] / v[3];
+    }
+
+    // Span of the ray between the layer's bottom and top, clamped to [0, maxDistance]
+    void IntersectLayer(const CloudLayerDesc& desc, const double origin[3], const double dir[3], float& out_tStart, float& out_tEnd)
+    {
+        double tStart = 0.0, tEnd = desc.MaxDistance;
+        if (fabs(dir[1]) < 1e-8)
+        {
+            if (origin[1] <= desc.BottomHeight || origin[1] >= desc.TopHeight)
+                tEnd = 0.0;
+        }
+        else
+        {
+            double tBottom = (desc.BottomHeight - origin[1]) / dir[1];
+            double tTop = (desc.TopHeight - origin[1]) / dir[1];
+            if (tBottom > tTop)
+                std::swap(tBottom, tTop);
+            tStart = std::max(tBottom, 0.0);
+            tEnd = std::min(tTop, tEnd);
+        }
+
+        out_tStart = static_cast<float>(tStart);
+        out_tEnd = static_cast<float>(std::max(tEnd, tStart));
+    }
+
+    bool ValidateInputs(const CloudVolumes& volumes, const CloudLayerDesc& desc, uint32_t width, uint32_t height)
+    {
+        const NoiseVolume* pVolumes[3] = { volumes.pShape, volumes.pDetail, volumes.pWeather };
+        for (const NoiseVolume* pVolume : pVolumes)
+        {
+            if (!pVolume || pVolume->Size == 0 || pVolume->Voxels.size() != size_t(pVolume->Size) * pVolume->Size * pVolume->Size * 4)
+            {
+                Muon::Print("Error: Cloud reference render is missing its shape, detail or weather volume!\n");
+                return false;
+            }
+        }
+
+        if (width == 0 || height == 0 || width > kMaxImageSize || height > kMaxImageSize)
+        {
+            Muon::Printf("Error: Can't render a %ux%u cloud reference, dimensions must be between 1 and %u!\n", width, height, kMaxImageSize);
+            return false;
+        }
+
+        const float sunLengthSq = desc.SunDirection[0] * desc.SunDirection[0] + desc.SunDirection[1] * desc.SunDirection[1] + desc.SunDirection[2] * desc.SunDirection[2];
+        if (!(desc.TopHeight > desc.BottomHeight) || !(desc.MaxDistance > 0.0f) || desc.NumSteps == 0 || desc.NumLightSteps == 0 ||
+            !(desc.ShapeTileSize > 0.0f) || !(desc.DetailTileSize > 0.0f) || !(desc.WeatherTileSize > 0.0f) ||
+            !(desc.DetailStrength >= 0.0f && desc.DetailStrength < 1.0f) || !(sunLengthSq > 0.0f) ||
+            fabsf(desc.ForwardScattering) >= 1.0f || fabsf(desc.BackScattering) >= 1.0f)
+        {
+            Muon::Print("Error: Invalid cloud layer description!\n");
+            return false;
+        }
+
+        return true;
+    }
+}
+
+bool RenderCloudReference(const float invViewProj[16], const CloudVolumes& volumes, const CloudLayerDesc& desc,
+    uint32_t width, uint32_t height, CloudImage& out_image, CloudRenderStats* pStats)
+{
+    using Clock = std::chrono::high_resolution_clock;
+
+    MUON_PROFILE_SCOPE("Render Cloud Reference");
+    if (!ValidateInputs(volumes, desc, width, height))
+        return false;
+
+    const Clock::time_point start = Clock::now();
+
+    MarchContext ctx;
+    ctx.pVolumes = &volumes;
+    ctx.pDesc = &desc;
+    ctx.InvShapeTile = 1.0f / desc.ShapeTileSize;
+    ctx.InvDetailTile = 1.0f / desc.DetailTileSize;
+    ctx.InvWeatherTile = 1.0f / desc.WeatherTileSize;
+    ctx.InvThickness = 1.0f / (desc.TopHeight - desc.BottomHeight);
+
+    const float sunLength = sqrtf(desc.SunDirection[0] * desc.SunDirection[0] + desc.SunDirection[1] * desc.SunDirection[1] + desc.SunDirection[2] * desc.SunDirection[2]);
+    for (uint32_t c = 0; c != 3; ++c)
+        ctx.SunDirection[c] = desc.SunDirection[c] / sunLength;
+
+    out_image.Width = width;
+    out_image.Height = height;
+    out_image.Pixels.assign(size_t(width) * height * 4, 0.0f);
+
+    const uint32_t numTilesX = (width + kTileSize - 1) / kTileSize;
+    const uint32_t numTilesY = (height + kTileSize - 1) / kTileSize;
+    std::atomic<uint64_t> numSamples{ 0 };
+
+    JobSystem::GetSingleton().ParallelFor(size_t(numTilesX) * numTilesY, 1, [&](size_t begin, size_t end)
+    {
+        uint64_t jobSamples = 0;
+        for (size_t tile = begin; tile != end; ++tile)
+        {
+            const uint32_t tileX = static_cast<uint32_t>(tile % numTilesX) * kTileSize;
+            const uint32_t tileY = static_cast<uint32_t>(tile / numTilesX) * kTileSize;
+            const uint32_t tileEndX = std::min(tileX + kTileSize, width);
+            const uint32_t tileEndY = std::min(tileY + kTileSize, height);
+
+            for (uint32_t y = tileY; y < tileEndY; y += 2)
+            {
+                for (uint32_t x = tileX; x < tileEndX; x += 2)
+                {
+                    // Lanes are the 2x2 quad at (x, y). Lanes past the image edge repeat the last pixel and are discarded.
+                    float origin[3][4], dir[3][4], tStart[4], tEnd[4];
+                    for (uint32_t l = 0; l != 4; ++l)
+                    {
+                        const uint32_t pixelX = std::min(x + (l & 1), width - 1);
+                        const uint32_t pixelY = std::min(y + (l >> 1), height - 1);
+                        const float ndcX = (pixelX + 0.5f) / width * 2.0f - 1.0f;
+                        const float ndcY = 1.0f - (pixelY + 0.5f) / height * 2.0f;
+
+                        // Near to far plane, which also covers orthographic projections
+                        double nearPoint[3], farPoint[3], rayDir[3];
+                        Unproject(invViewProj, ndcX, ndcY, 0.0f, nearPoint);
+                        Unproject(invViewProj, ndcX, ndcY, 1.0f, farPoint);
+
+                        double length = 0.0;
+                        for (uint32_t c = 0; c != 3; ++c)
+                        {
+                            rayDir[c] = farPoint[c] - nearPoint[c];
+                            length += rayDir[c] * rayDir[c];
+                        }
+                        length = sqrt(length);
+                        for (uint32_t c = 0; c != 3; ++c)
+                        {
+                            rayDir[c] /= length;
+                            origin[c][l] = static_cast<float>(nearPoint[c]);
+                            dir[c][l] = static_cast<float>(rayDir[c]);
+                        }
+
+                        IntersectLayer(desc, nearPoint, rayDir, tStart[l], tEnd[l]);
+                    }
+
+                    PacketResult result;
+                    MarchPacket(ctx, origin, dir, tStart, tEnd, result);
+                    jobSamples += result.NumSamples;
+
+                    for (uint32_t l = 0; l != 4; ++l)
+                    {
+                        const uint32_t pixelX = x + (l & 1);
+                        const uint32_t pixelY = y + (l >> 1);
+                        if (pixelX >= tileEndX || pixelY >= tileEndY)
+                            continue;
+
+                        float* pPixel = &out_image.Pixels[(size_t(pixelY) * width + pixelX) * 4];
+                        pPixel[0] = result.Radiance[0][l];
+                        pPixel[1] = result.Radiance[1][l];
+                        pPixel[2] = result.Radiance[2][l];
+                        pPixel[3] = 1.0f - result.Transmittance[l];
+                    }
+                }
+            }
+        }
+        numSamples.fetch_add(jobSamples, std::memory_order_relaxed);
+    });
+
+    if (pStats)
+    {
+        pStats->RenderMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        pStats->NumRays = uint64_t(width) * height;
+        pStats->NumDensitySamples = numSamples.load(std::memory_order_relaxed);
+    }
+    return true;
+}
+
+bool WriteCloudImagePNG(const CloudImage& image, const wchar_t* path)
+{
+    std::vector<uint8_t> rgba(image.Pixels.size());
+    for (size_t i = 0; i < image.Pixels.size(); i += 4)
+    {
+        const float alpha = std::min(std::max(image.Pixels[i + 3], 0.0f), 1.0f);
+        const float unpremultiply = alpha > 0.0f ? 1.0f / alpha : 0.0f;
+        for (uint32_t c = 0; c != 3; ++c)
+            rgba[i + c] = static_cast<uint8_t>(LinearToSRGB(image.Pixels[i + c] * unpremultiply) * 255.0f + 0.5f);
+        rgba[i + 3] = static_cast<uint8_t>(alpha * 255.0f + 0.5f);
+    }
+
+    return WritePNG(path, image.Width, image.Height, rgba.data());
+}
+
+bool WriteCloudImageEXR(const CloudImage& image, const wchar_t* path)
+{
+    return WriteEXR(path, image.Width, image.Height, image.Pixels.data());
+}
+
+bool CaptureCloudReference(const float invViewProj[16], uint32_t width, uint32_t height, const wchar_t* pathNoExtension)
+{
+    NoiseVolume shape, detail, weather;
+    if (!LoadOrGenerateNoiseVolume(GetCloudShapeNoiseDesc(), shape) ||
+        !LoadOrGenerateNoiseVolume(GetCloudDetailNoiseDesc(), detail) ||
+        !LoadOrGenerateNoiseVolume(GetCloudWeatherNoiseDesc(), weather))
+    {
+        Muon::Print("Error: Failed to get the noise volumes for the cloud reference!\n");
+        return false;
+    }
+
+    CloudVolumes volumes;
+    volumes.pShape = &shape;
+    volumes.pDetail = &detail;
+    volumes.pWeather = &weather;
+
+    CloudImage image;
+    CloudRenderStats stats;
+    if (!RenderCloudReference(invViewProj, volumes, CloudLayerDesc(), width, height, image, &stats))
+        return false;
+
+    const double seconds = std::max(stats.RenderMs, 1e-3) / 1000.0;
+    Muon::Printf("Info: Rendered %ux%u reference clouds in %.1fms (%.2f Mrays/s, %.1f M density samples/s)\n",
+        width, height, stats.RenderMs, stats.NumRays / seconds * 1e-6, stats.NumDensitySamples / seconds * 1e-6);
+
+    const std::wstring path(pathNoExtension);
+    const bool wrotePNG = WriteCloudImagePNG(image, (path + L".png").c_str());
+    const bool wroteEXR = WriteCloudImageEXR(image, (path + L".exr").c_str());
+    return wrotePNG && wroteEXR;
+}
+
+}
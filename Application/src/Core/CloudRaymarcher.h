@@ -0,0 +1,84 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : CPU reference raymarcher for volumetric clouds. Ground truth for the cloud shaders, and a performance baseline.
+----------------------------------------------*/
+#ifndef MUON_CLOUDRAYMARCHER_H
+#define MUON_CLOUDRAYMARCHER_H
+
+#include <stdint.h>
+#include <vector>
+
+namespace Muon
+{
+struct NoiseVolume;
+
+// Any of these may be shared with the GPU path, they're only read
+struct CloudVolumes
+{
+    const NoiseVolume* pShape = nullptr;   // GetCloudShapeNoiseDesc
+    const NoiseVolume* pDetail = nullptr;  // GetCloudDetailNoiseDesc
+    const NoiseVolume* pWeather = nullptr; // GetCloudWeatherNoiseDesc
+};
+
+// A flat layer of clouds between two heights. Distances are in world units.
+struct CloudLayerDesc
+{
+    float BottomHeight = 150.0f;
+    float TopHeight = 350.0f;
+    float MaxDistance = 3000.0f;     // Rays stop marching this far from the camera
+
+    // World units covered by one repeat of each volume
+    float ShapeTileSize = 400.0f;
+    float DetailTileSize = 60.0f;
+    float WeatherTileSize = 3000.0f;
+    float WeatherTime = 0.0f;        // [0, 1) through the weather volume's third axis, wraps
+
+    float Coverage = 0.35f;          // Scales the weather map's coverage, 0.5 leaves it as authored
+    float DetailStrength = 0.35f;    // How much the detail noise erodes the shape's edges
+    float Extinction = 0.05f;        // Per world unit, at a density of 1
+
+    // Lighting. SunDirection points towards the sun and doesn't have to be normalized.
+    float SunDirection[3] = { 0.4f, 0.6f, 0.3f };
+    float SunColor[3] = { 1.0f, 0.95f, 0.85f };
+    float AmbientColor[3] = { 0.25f, 0.3f, 0.4f };
+    float Albedo = 0.95f;
+    float ForwardScattering = 0.6f;  // Henyey-Greenstein g of the forward lobe
+    float BackScattering = -0.25f;   // g of the back lobe
+    float BackScatterWeight = 0.25f;
+
+    uint32_t NumSteps = 96;          // Per view ray, spread evenly over its span through the layer
+    uint32_t NumLightSteps = 6;
+    float LightMarchDistance = 120.0f;
+};
+
+// RGB is in-scattered radiance and A is opacity (1 - transmittance), so the image is premultiplied. Rows go top to bottom.
+struct CloudImage
+{
+    uint32_t Width = 0;
+    uint32_t Height = 0;
+    std::vector<float> Pixels;
+};
+
+struct CloudRenderStats
+{
+    double RenderMs = 0.0;
+    uint64_t NumRays = 0;
+    uint64_t NumDensitySamples = 0; // View and light samples of rays that were still marching
+};
+
+// Rays are traced in 2x2 packets, one ray per SIMD lane, and the image is split into tiles across the job system.
+// invViewProj is row-major in the row-vector convention used by DirectXMath (v = clip * M).
+bool RenderCloudReference(const float invViewProj[16], const CloudVolumes& volumes, const CloudLayerDesc& desc,
+    uint32_t width, uint32_t height, CloudImage& out_image, CloudRenderStats* pStats = nullptr);
+
+// The PNG is sRGB with straight alpha, the EXR keeps linear premultiplied floats
+bool WriteCloudImagePNG(const CloudImage& image, const wchar_t* path);
+bool WriteCloudImageEXR(const CloudImage& image, const wchar_t* path);
+
+// Renders the view with the default layer and writes <pathNoExtension>.png and .exr. The noise volumes come from the noise cache.
+bool CaptureCloudReference(const float invViewProj[16], uint32_t width, uint32_t height, const wchar_t* pathNoExtension);
+
+}
+
+#endif
@@ -0,0 +1,471 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Shader, texture and material definitions loaded from the asset manifests
+----------------------------------------------*/
+#include <Core/CodexManifest.h>
+
+#include <Core/BinaryStream.h>
+#include <Core/PathMacros.h>
+#include <Core/XmlParser.h>
+#include <Utils/Utils.h>
+
+#include <filesystem>
+#include <stdlib.h>
+
+namespace Muon
+{
+
+static const uint32_t kManifestMagic = 0x4D434E4D; // 'MNCM'
+static const uint32_t kManifestVersion = 3;
+
+static const wchar_t* kCodexXmlPath = ASSETPATHW L"codex.xml";
+static const wchar_t* kMaterialsXmlPath = ASSETPATHW L"materials.xml";
+static const wchar_t* kManifestBinaryPath = CACHEPATHW L"codex.bin";
+
+// Identifies a version of a source file without having to read it
+struct SourceStamp
+{
+    uint64_t Size = 0;
+    int64_t WriteTime = 0;
+
+    bool operator==(const SourceStamp& other) const { return Size == other.Size && WriteTime == other.WriteTime; }
+};
+
+static bool GetSourceStamp(const wchar_t* path, SourceStamp& out_stamp)
+{
+    namespace fs = std::filesystem;
+
+    std::error_code ec;
+    out_stamp.Size = fs::file_size(path, ec);
+    if (ec)
+        return false;
+
+    out_stamp.WriteTime = fs::last_write_time(path, ec).time_since_epoch().count();
+    return !ec;
+}
+
+static ParameterType ParseParamType(std::string_view type)
+{
+    if (type == "int")    return ParameterType::Int;
+    if (type == "float")  return ParameterType::Float;
+    if (type == "float2") return ParameterType::Float2;
+    if (type == "float3") return ParameterType::Float3;
+    if (type == "float4") return ParameterType::Float4;
+    return ParameterType::Invalid;
+}
+
+// Materials without a depth attribute test and write depth
+static bool ParseDepthMode(std::string_view mode, DepthMode& out_mode)
+{
+    if (mode.empty() || mode == "test") { out_mode = DepthMode::TestWrite; return true; }
+    if (mode == "prepass")              { out_mode = DepthMode::Prepass; return true; }
+    if (mode == "off")                  { out_mode = DepthMode::Disabled; return true; }
+    return false;
+}
+
+// Parses a comma separated list of up to 4 floats, e.g. "1.0,0.5,0.5,1.0"
+static UINT ParseFloatList(std::string_view text, float* out_values, UINT maxValues)
+{
+    std::string buffer(text);
+    const char* cursor = buffer.c_str();
+
+    UINT count = 0;
+    while (count < maxValues && *cursor)
+    {
+        char* end = nullptr;
+        out_values[count] = strtof(cursor, &end);
+        if (end == cursor)
+            break;
+
+        count++;
+        cursor = end;
+        while (*cursor == ',' || *cursor == ' ' || *cursor == '\t')
+            cursor++;
+    }
+
+    return count;
+}
+
+static bool ParseParamValue(ParameterType type, std::string_view text, ParameterValue& out_value)
+{
+    float values[4] = {};
+    const UINT count = ParseFloatList(text, values, 4);
+
+    switch (type)
+    {
+    case ParameterType::Int:
+        out_value.IntValue = (int)values[0];
+        return count == 1;
+    case ParameterType::Float:
+        out_value.FloatValue = values[0];
+        return count == 1;
+    case ParameterType::Float2:
+        out_value.Float2Value = DirectX::XMFLOAT2(values[0], values[1]);
+        return count == 2;
+    case ParameterType::Float3:
+        out_value.Float3Value = DirectX::XMFLOAT3(values[0], values[1], values[2]);
+        return count == 3;
+    case ParameterType::Float4:
+        out_value.Float4Value = DirectX::XMFLOAT4(values[0], values[1], values[2], values[3]);
+        return count == 4;
+    default:
+        return false;
+    }
+}
+
+bool CodexManifest::Load(bool& out_fromBinary)
+{
+    out_fromBinary = false;
+
+    SourceStamp codexStamp, materialsStamp;
+    if (!GetSourceStamp(kCodexXmlPath, codexStamp) || !GetSourceStamp(kMaterialsXmlPath, materialsStamp))
+    {
+        Muon::Print("Error: Failed to find codex.xml or materials.xml!\n");
+        return false;
+    }
+
+    // Fast path: the compiled manifest is still valid for the current xml sources
+    std::vector<uint8_t> binary;
+    if (LoadFileBytes(kManifestBinaryPath, binary))
+    {
+        BinaryReader reader(binary.data(), binary.size());
+
+        uint32_t magic = 0, version = 0;
+        SourceStamp cachedCodexStamp, cachedMaterialsStamp;
+        reader.Read(magic);
+        reader.Read(version);
+        reader.Read(cachedCodexStamp);
+        reader.Read(cachedMaterialsStamp);
+
+        if (!reader.IsFailed() && magic == kManifestMagic && version == kManifestVersion &&
+            cachedCodexStamp == codexStamp && cachedMaterialsStamp == materialsStamp)
+        {
+            if (Deserialize(reader))
+            {
+                out_fromBinary = true;
+                return true;
+            }
+
+            Muon::Print("Warning: Compiled codex manifest is corrupt, reparsing xml.\n");
+        }
+    }
+
+    std::vector<uint8_t> codexXml, materialsXml;
+    if (!LoadFileBytes(kCodexXmlPath, codexXml) || !LoadFileBytes(kMaterialsXmlPath, materialsXml))
+    {
+        Muon::Print("Error: Failed to read codex.xml or materials.xml!\n");
+        return false;
+    }
+
+    std::string error;
+    bool parsed = ParseXml(
+        std::string_view(reinterpret_cast<const char*>(codexXml.data()), codexXml.size()),
+        std::string_view(reinterpret_cast<const char*>(materialsXml.data()), materialsXml.size()),
+        error);
+
+    if (!parsed)
+    {
+        Muon::Printf("Error: Failed to parse asset manifest: %s\n", error.c_str());
+        return false;
+    }
+
+    BinaryWriter writer;
+    writer.Write(kManifestMagic);
+    writer.Write(kManifestVersion);
+    writer.Write(codexStamp);
+    writer.Write(materialsStamp);
+    Serialize(writer);
+
+    if (!writer.SaveToFile(kManifestBinaryPath))
+        Muon::Print("Warning: Failed to write compiled codex manifest.\n");
+
+    return true;
+}
+
+bool CodexManifest::ParseXml(std::string_view codexXml, std::string_view materialsXml, std::string& out_error)
+{
+    Shaders.clear();
+    Textures.clear();
+    Materials.clear();
+
+    XmlDocument doc;
+    if (!doc.Parse(codexXml))
+    {
+        out_error = "codex.xml: " + doc.GetError();
+        return false;
+    }
+
+    if (!ParseCodexNodes(doc, out_error))
+        return false;
+
+    if (!doc.Parse(materialsXml))
+    {
+        out_error = "materials.xml: " + doc.GetError();
+        return false;
+    }
+
+    return ParseMaterialNodes(doc, out_error);
+}
+
+bool CodexManifest::ParseCodexNodes(const XmlDocument& doc, std::string& out_error)
+{
+    for (uint32_t root = doc.GetFirstRoot(); root != XmlDocument::INVALID_NODE; root = doc.GetNode(root).NextSibling)
+    {
+        uint32_t shaders = doc.FindChild(root, "shaders");
+        for (uint32_t node = shaders != XmlDocument::INVALID_NODE ? doc.GetNode(shaders).FirstChild : XmlDocument::INVALID_NODE;
+            node != XmlDocument::INVALID_NODE; node = doc.GetNode(node).NextSibling)
+        {
+            ShaderDefinition shader;
+            shader.FileName = std::string(doc.GetAttribute(node, "name"));
+
+            std::string_view type = doc.GetAttribute(node, "type");
+            if (type == "VS")
+                shader.Stage = ShaderStage::Vertex;
+            else if (type == "PS")
+                shader.Stage = ShaderStage::Pixel;
+            else
+            {
+                out_error = "codex.xml: Unknown shader type '" + std::string(type) + "' for " + shader.FileName;
+                return false;
+            }
+
+            Shaders.push_back(std::move(shader));
+        }
+
+        uint32_t textures = doc.FindChild(root, "textures");
+        for (uint32_t node = textures != XmlDocument::INVALID_NODE ? doc.GetNode(textures).FirstChild : XmlDocument::INVALID_NODE;
+            node != XmlDocument::INVALID_NODE; node = doc.GetNode(node).NextSibling)
+        {
+            TextureDefinition texture;
+            texture.FileName = std::string(doc.GetAttribute(node, "name"));
+            Textures.push_back(std::move(texture));
+        }
+    }
+
+    return true;
+}
+
+bool CodexManifest::ParseMaterialNodes(const XmlDocument& doc, std::string& out_error)
+{
+    for (uint32_t root = doc.GetFirstRoot(); root != XmlDocument::INVALID_NODE; root = doc.GetNode(root).NextSibling)
+    {
+        for (uint32_t matNode = doc.GetNode(root).FirstChild; matNode != XmlDocument::INVALID_NODE; matNode = doc.GetNode(matNode).NextSibling)
+        {
+            if (doc.GetNode(matNode).Name != "material")
+                continue;
+
+            MaterialDefinition material;
+            material.Name = std::string(doc.GetAttribute(matNode, "name"));
+
+            if (!ParseDepthMode(doc.GetAttribute(matNode, "depth"), material.Depth))
+            {
+                out_error = "materials.xml: " + material.Name + " has an unknown depth mode '" + std::string(doc.GetAttribute(matNode, "depth")) + "'";
+                return false;
+            }
+
+            for (uint32_t node = doc.GetNode(matNode).FirstChild; node != XmlDocument::INVALID_NODE; node = doc.GetNode(node).NextSibling)
+            {
+                const XmlNode& child = doc.GetNode(node);
+                if (child.Name == "shader")
+                {
+                    std::string_view type = doc.GetAttribute(node, "type");
+                    std::string fileName(doc.GetAttribute(node, "name"));
+
+                    const ShaderDefinition* pShader = FindShader(fileName);
+                    if (!pShader)
+                    {
+                        out_error = "materials.xml: " + material.Name + " references undeclared shader " + fileName;
+                        return false;
+                    }
+
+                    std::string defines(doc.GetAttribute(node, "defines"));
+                    if (type == "VS" && pShader->Stage == ShaderStage::Vertex)
+                    {
+                        material.VertexShader = fileName;
+                        material.VertexDefines = std::move(defines);
+                    }
+                    else if (type == "PS" && pShader->Stage == ShaderStage::Pixel)
+                    {
+                        material.PixelShader = fileName;
+                        material.PixelDefines = std::move(defines);
+                    }
+                    else
+                    {
+                        out_error = "materials.xml: " + material.Name + " has a mismatched shader type for " + fileName;
+                        return false;
+                    }
+                }
+                else if (child.Name == "texture")
+                {
+                    MaterialTextureDefinition texture;
+                    texture.ParamName = std::string(doc.GetAttribute(node, "param"));
+                    texture.FileName = std::string(doc.GetAttribute(node, "name"));
+
+                    if (!FindTexture(texture.FileName))
+                    {
+                        out_error = "materials.xml: " + material.Name + " references undeclared texture " + texture.FileName;
+                        return false;
+                    }
+
+                    material.Textures.push_back(std::move(texture));
+                }
+                else if (child.Name == "params")
+                {
+                    for (uint32_t paramNode = child.FirstChild; paramNode != XmlDocument::INVALID_NODE; paramNode = doc.GetNode(paramNode).NextSibling)
+                    {
+                        MaterialParamDefinition param;
+                        param.Name = std::string(doc.GetAttribute(paramNode, "name"));
+                        param.Type = ParseParamType(doc.GetAttribute(paramNode, "type"));
+
+                        if (!ParseParamValue(param.Type, doc.GetNode(paramNode).Text, param.Value))
+                        {
+                            out_error = "materials.xml: " + material.Name + " has an invalid value for param " + param.Name;
+                            return false;
+                        }
+
+                        material.Params.push_back(std::move(param));
+                    }
+                }
+            }
+
+            if (material.Name.empty() || material.VertexShader.empty() || material.PixelShader.empty())
+            {
+                out_error = "materials.xml: Material '" + material.Name + "' needs a name, a VS and a PS";
+                return false;
+            }
+
+            Materials.push_back(std::move(material));
+        }
+    }
+
+    return true;
+}
+
+void CodexManifest::Serialize(BinaryWriter& writer) const
+{
+    writer.Write<uint32_t>((uint32_t)Shaders.size());
+    for (const ShaderDefinition& shader : Shaders)
+    {
+        writer.WriteString(shader.FileName);
+        writer.Write(shader.Stage);
+    }
+
+    writer.Write<uint32_t>((uint32_t)Textures.size());
+    for (const TextureDefinition& texture : Textures)
+    {
+        writer.WriteString(texture.FileName);
+    }
+
+    writer.Write<uint32_t>((uint32_t)Materials.size());
+    for (const MaterialDefinition& material : Materials)
+    {
+        writer.WriteString(material.Name);
+        writer.WriteString(material.VertexShader);
+        writer.WriteString(material.PixelShader);
+        writer.WriteString(material.VertexDefines);
+        writer.WriteString(material.PixelDefines);
+        writer.Write(material.Depth);
+
+        writer.Write<uint32_t>((uint32_t)material.Params.size());
+        for (const MaterialParamDefinition& param : material.Params)
+        {
+            writer.WriteString(param.Name);
+            writer.Write(param.Type);
+            writer.Write(param.Value);
+        }
+
+        writer.Write<uint32_t>((uint32_t)material.Textures.size());
+        for (const MaterialTextureDefinition& texture : material.Textures)
+        {
+            writer.WriteString(texture.ParamName);
+            writer.WriteString(texture.FileName);
+        }
+    }
+}
+
+bool CodexManifest::Deserialize(BinaryReader& reader)
+{
+    uint32_t count = 0;
+
+    reader.ReadCount(count);
+    Shaders.resize(count);
+    for (ShaderDefinition& shader : Shaders)
+    {
+        reader.ReadString(shader.FileName);
+        reader.Read(shader.Stage);
+
+        if (shader.Stage != ShaderStage::Vertex && shader.Stage != ShaderStage::Pixel)
+            return false;
+    }
+
+    reader.ReadCount(count);
+    Textures.resize(count);
+    for (TextureDefinition& texture : Textures)
+    {
+        reader.ReadString(texture.FileName);
+    }
+
+    reader.ReadCount(count);
+    Materials.resize(count);
+    for (MaterialDefinition& material : Materials)
+    {
+        reader.ReadString(material.Name);
+        reader.ReadString(material.VertexShader);
+        reader.ReadString(material.PixelShader);
+        reader.ReadString(material.VertexDefines);
+        reader.ReadString(material.PixelDefines);
+        reader.Read(material.Depth);
+
+        if (material.Depth != DepthMode::Disabled && material.Depth != DepthMode::TestWrite && material.Depth != DepthMode::Prepass)
+            return false;
+
+        reader.ReadCount(count);
+        material.Params.resize(count);
+        for (MaterialParamDefinition& param : material.Params)
+        {
+            reader.ReadString(param.Name);
+            reader.Read(param.Type);
+            reader.Read(param.Value);
+
+            // Only the value types the xml can declare
+            if (param.Type < ParameterType::Int || param.Type > ParameterType::Float4)
+                return false;
+        }
+
+        reader.ReadCount(count);
+        material.Textures.resize(count);
+        for (MaterialTextureDefinition& texture : material.Textures)
+        {
+            reader.ReadString(texture.ParamName);
+            reader.ReadString(texture.FileName);
+        }
+
+        if (reader.IsFailed())
+            break;
+    }
+
+    return !reader.IsFailed() && reader.IsAtEnd();
+}
+
+const ShaderDefinition* CodexManifest::FindShader(const std::string& fileName) const
+{
+    for (const ShaderDefinition& shader : Shaders)
+    {
+        if (shader.FileName == fileName)
+            return &shader;
+    }
+    return nullptr;
+}
+
+const TextureDefinition* CodexManifest::FindTexture(const std::string& fileName) const
+{
+    for (const TextureDefinition& texture : Textures)
+    {
+        if (texture.FileName == fileName)
+            return &texture;
+    }
+    return nullptr;
+}
+
+}
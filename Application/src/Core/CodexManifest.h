@@ -0,0 +1,86 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Shader, texture and material definitions loaded from the asset manifests
+----------------------------------------------*/
+#ifndef MUON_CODEXMANIFEST_H
+#define MUON_CODEXMANIFEST_H
+
+#include <Core/Material.h>
+#include <Core/Shader.h>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Muon
+{
+class BinaryReader;
+class BinaryWriter;
+class XmlDocument;
+}
+
+namespace Muon
+{
+
+struct ShaderDefinition
+{
+    std::string FileName;
+    ShaderStage Stage = ShaderStage::Vertex;
+};
+
+struct TextureDefinition
+{
+    std::string FileName;
+};
+
+struct MaterialParamDefinition
+{
+    std::string Name;
+    ParameterType Type = ParameterType::Invalid;
+    ParameterValue Value = {};
+};
+
+struct MaterialTextureDefinition
+{
+    std::string ParamName;
+    std::string FileName;
+};
+
+struct MaterialDefinition
+{
+    std::string Name;
+    std::string VertexShader;
+    std::string PixelShader;
+    std::string VertexDefines; // Permutation defines selecting a shader variant, e.g. "NORMAL_MAP"
+    std::string PixelDefines;
+    DepthMode Depth = DepthMode::TestWrite;
+    std::vector<MaterialParamDefinition> Params;
+    std::vector<MaterialTextureDefinition> Textures;
+};
+
+// Mirrors Assets/codex.xml (shaders, textures) and Assets/materials.xml (materials).
+// The first load compiles both into a binary manifest under the cache folder, later launches read that instead while it is up to date.
+struct CodexManifest
+{
+    std::vector<ShaderDefinition> Shaders;
+    std::vector<TextureDefinition> Textures;
+    std::vector<MaterialDefinition> Materials;
+
+    bool Load(bool& out_fromBinary);
+
+    bool ParseXml(std::string_view codexXml, std::string_view materialsXml, std::string& out_error);
+    void Serialize(BinaryWriter& writer) const;
+    bool Deserialize(BinaryReader& reader);
+
+    const ShaderDefinition* FindShader(const std::string& fileName) const;
+    const TextureDefinition* FindTexture(const std::string& fileName) const;
+
+private:
+    bool ParseCodexNodes(const XmlDocument& doc, std::string& out_error);
+    bool ParseMaterialNodes(const XmlDocument& doc, std::string& out_error);
+};
+
+}
+
+#endif
@@ -0,0 +1,76 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Splitting a frame's draw list across worker threads for command recording
+----------------------------------------------*/
+#include <Core/CommandRecorder.h>
+
+#include <Core/JobSystem.h>
+
+#include <algorithm>
+#include <chrono>
+
+namespace Muon
+{
+
+void PlanRecordingChunks(size_t numItems, uint32_t maxChunks, size_t minItemsPerChunk, std::vector<RecordingChunk>& out_chunks)
+{
+    out_chunks.clear();
+    if (numItems == 0)
+        return;
+
+    minItemsPerChunk = std::max<size_t>(minItemsPerChunk, 1);
+    const size_t maxUseful = numItems / minItemsPerChunk; // Rounded down, so every chunk reaches the minimum
+    const size_t numChunks = std::max<size_t>(1, std::min<size_t>(maxChunks, maxUseful));
+
+    // Spread the remainder over the first chunks so no chunk is more than one item larger than another
+    const size_t baseSize = numItems / numChunks;
+    const size_t remainder = numItems % numChunks;
+
+    size_t begin = 0;
+    for (size_t i = 0; i != numChunks; ++i)
+    {
+        const size_t size = baseSize + (i < remainder ? 1 : 0);
+        out_chunks.push_back({ begin, begin + size });
+        begin += size;
+    }
+}
+
+bool RecordInParallel(ICommandRecorder& recorder, size_t numItems, size_t minItemsPerChunk, RecordingStats* pStats)
+{
+    using Clock = std::chrono::high_resolution_clock;
+    const Clock::time_point recordStart = Clock::now();
+
+    JobSystem& jobs = JobSystem::GetSingleton();
+    const uint32_t maxChunks = std::min(recorder.GetMaxChunks(), jobs.GetNumThreads());
+
+    std::vector<RecordingChunk> chunks;
+    PlanRecordingChunks(numItems, maxChunks, minItemsPerChunk, chunks);
+
+    if (!recorder.BeginRecording(static_cast<uint32_t>(chunks.size())))
+        return false;
+
+    JobCounter counter;
+    for (uint32_t i = 1; i < chunks.size(); ++i)
+    {
+        const RecordingChunk chunk = chunks[i];
+        jobs.Submit([&recorder, i, chunk]() { recorder.RecordChunk(i, chunk.Begin, chunk.End); }, &counter);
+    }
+
+    if (!chunks.empty())
+        recorder.RecordChunk(0, chunks[0].Begin, chunks[0].End);
+
+    jobs.Wait(counter);
+
+    const bool submitted = recorder.Submit();
+
+    if (pStats)
+    {
+        pStats->NumChunks = static_cast<uint32_t>(chunks.size());
+        pStats->RecordMs = std::chrono::duration<double, std::milli>(Clock::now() - recordStart).count();
+    }
+
+    return submitted;
+}
+
+}
@@ -0,0 +1,57 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Splitting a frame's draw list across worker threads for command recording
+----------------------------------------------*/
+#ifndef MUON_COMMANDRECORDER_H
+#define MUON_COMMANDRECORDER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace Muon
+{
+
+// A contiguous range of the draw list, recorded into its own command stream
+struct RecordingChunk
+{
+    size_t Begin = 0;
+    size_t End = 0;
+};
+
+// Splits numItems into at most maxChunks ordered, contiguous chunks of at least minItemsPerChunk items (except when there are fewer items than that).
+void PlanRecordingChunks(size_t numItems, uint32_t maxChunks, size_t minItemsPerChunk, std::vector<RecordingChunk>& out_chunks);
+
+// Owns one command stream per chunk. RecordInParallel drives it, so the chunking and submission order can be
+// exercised with an implementation that doesn't touch the GPU at all.
+class ICommandRecorder
+{
+public:
+    virtual ~ICommandRecorder() = default;
+
+    // Upper bound on the chunks this recorder can hold per frame
+    virtual uint32_t GetMaxChunks() const = 0;
+
+    // Called on the submitting thread before any chunk is recorded
+    virtual bool BeginRecording(uint32_t numChunks) = 0;
+
+    // Called concurrently from the job system, exactly once per chunk. Chunk i covers the items right before chunk i + 1.
+    virtual void RecordChunk(uint32_t chunkIndex, size_t begin, size_t end) = 0;
+
+    // Called on the submitting thread once every chunk is recorded. Must submit the chunks in index order.
+    virtual bool Submit() = 0;
+};
+
+struct RecordingStats
+{
+    uint32_t NumChunks = 0;
+    double RecordMs = 0.0; // Wall time from BeginRecording to the end of Submit
+};
+
+// Records numItems across the job system's threads and submits them in order. The calling thread records the first chunk.
+bool RecordInParallel(ICommandRecorder& recorder, size_t numItems, size_t minItemsPerChunk, RecordingStats* pStats = nullptr);
+
+}
+
+#endif
@@ -15,6 +15,10 @@ namespace Muon
     typedef id_type MeshID;
     typedef id_type TextureID;
     typedef id_type MaterialTypeID;
+    typedef id_type CloudVolumeID;
+
+    // Bit i enables the i-th permutation define declared by a shader source
+    typedef uint32_t VariantKey;
 
     static const id_type IDTYPE_MAX = UINT32_MAX;
     static const TextureID TEXTUREID_INVALID = IDTYPE_MAX;
@@ -6,5 +6,11 @@ Description : Defines DLL import/export macro and other things
 #ifndef MUON_CORE_H
 #define MUON_CORE_H
 
+#if defined(_WIN32)
 #include <Core/WinApp.h>
+#else
+// Only the CPU modules build outside Windows, for the headless tests. These are the Windows types they share.
+#include <stdint.h>
+typedef unsigned int UINT;
+#endif
 #endif
\ No newline at end of file
@@ -0,0 +1,278 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Frustum culling over structure-of-arrays bounding volumes
+----------------------------------------------*/
+#include <Core/Culling.h>
+
+#include <Core/JobSystem.h>
+#include <Core/Profiler.h>
+#include <Core/SIMD.h>
+
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <string.h>
+
+namespace Muon
+{
+using namespace SIMD;
+
+namespace
+{
+    // Below this many volumes per chunk, handing chunks to other threads costs more than it saves
+    static const size_t kMinVolumesPerChunk = 8192;
+
+    static_assert(kMinVolumesPerChunk % CULL_SIMD_PADDING == 0, "Chunks must start on a SIMD group");
+
+    size_t PaddedCount(size_t count)
+    {
+        return (count + CULL_SIMD_PADDING - 1) / CULL_SIMD_PADDING * CULL_SIMD_PADDING;
+    }
+
+    // Appends the lanes set in mask without branching on them, lanes past the end of the real data are masked off by the caller
+    template <uint32_t Width>
+    uint32_t* EmitVisible(uint32_t* pOut, uint32_t base, uint32_t mask)
+    {
+        for (uint32_t lane = 0; lane != Width; ++lane)
+        {
+            *pOut = base + lane;
+            pOut += (mask >> lane) & 1;
+        }
+        return pOut;
+    }
+
+    static const uint32_t kGroupWidth = 4;
+    static_assert(CULL_SIMD_PADDING % kGroupWidth == 0, "Padding must cover a whole SIMD group");
+
+    // Ranges are padded to CULL_SIMD_PADDING, which can be more than one group past the last volume. Stopping after the group
+    // holding it keeps the tail mask below in range.
+    size_t GroupEnd(size_t end, size_t count)
+    {
+        return std::min(end, (count + kGroupWidth - 1) / kGroupWidth * kGroupWidth);
+    }
+
+    uint32_t TailMask(size_t i, size_t count)
+    {
+        return count - i < kGroupWidth ? (1u << (count - i)) - 1 : ~0u;
+    }
+
+    struct FrustumLanes
+    {
+        Float4 NormalX[Frustum::COUNT], NormalY[Frustum::COUNT], NormalZ[Frustum::COUNT], D[Frustum::COUNT];
+        Float4 AbsNormalX[Frustum::COUNT], AbsNormalY[Frustum::COUNT], AbsNormalZ[Frustum::COUNT];
+
+        explicit FrustumLanes(const Frustum& f)
+        {
+            for (uint32_t p = 0; p != Frustum::COUNT; ++p)
+            {
+                NormalX[p] = Splat4(f.NormalX[p]);
+                NormalY[p] = Splat4(f.NormalY[p]);
+                NormalZ[p] = Splat4(f.NormalZ[p]);
+                D[p] = Splat4(f.D[p]);
+                AbsNormalX[p] = Splat4(fabsf(f.NormalX[p]));
+                AbsNormalY[p] = Splat4(fabsf(f.NormalY[p]));
+                AbsNormalZ[p] = Splat4(fabsf(f.NormalZ[p]));
+            }
+        }
+    };
+
+    // Visible unless the sphere is entirely behind some plane: dot(n, c) + d >= -r for all six
+    uint32_t* CullSphereRange(const FrustumLanes& f, const BoundingSpheresSoA& s, size_t begin, size_t end, size_t count, uint32_t* pOut)
+    {
+        const Float4 zero = Splat4(0.0f);
+        const Float4 allTrue = GreaterEqual4(zero, zero);
+        end = GroupEnd(end, count);
+        for (size_t i = begin; i < end; i += kGroupWidth)
+        {
+            const Float4 cx = Load4(&s.CenterX[i]), cy = Load4(&s.CenterY[i]), cz = Load4(&s.CenterZ[i]);
+            const Float4 negRadius = Sub4(zero, Load4(&s.Radius[i]));
+
+            Float4 inside = allTrue;
+            for (uint32_t p = 0; p != Frustum::COUNT; ++p)
+            {
+                const Float4 dist = Add4(Add4(Mul4(f.NormalX[p], cx), Mul4(f.NormalY[p], cy)), Add4(Mul4(f.NormalZ[p], cz), f.D[p]));
+                inside = And4(inside, GreaterEqual4(dist, negRadius));
+            }
+
+            const uint32_t mask = MoveMask4(inside) & TailMask(i, count);
+            pOut = EmitVisible<kGroupWidth>(pOut, static_cast<uint32_t>(i), mask);
+        }
+        return pOut;
+    }
+
+    // Tests the box corner furthest along each plane normal: dot(n, c) + dot(|n|, e) + d >= 0 for all six
+    uint32_t* CullBoxRange(const FrustumLanes& f, const BoundingBoxesSoA& b, size_t begin, size_t end, size_t count, uint32_t* pOut)
+    {
+        const Float4 zero = Splat4(0.0f);
+        const Float4 allTrue = GreaterEqual4(zero, zero);
+        end = GroupEnd(end, count);
+        for (size_t i = begin; i < end; i += kGroupWidth)
+        {
+            const Float4 cx = Load4(&b.CenterX[i]), cy = Load4(&b.CenterY[i]), cz = Load4(&b.CenterZ[i]);
+            const Float4 ex = Load4(&b.ExtentX[i]), ey = Load4(&b.ExtentY[i]), ez = Load4(&b.ExtentZ[i]);
+
+            Float4 inside = allTrue;
+            for (uint32_t p = 0; p != Frustum::COUNT; ++p)
+            {
+                const Float4 dist = Add4(Add4(Mul4(f.NormalX[p], cx), Mul4(f.NormalY[p], cy)), Add4(Mul4(f.NormalZ[p], cz), f.D[p]));
+                const Float4 reach = Add4(Add4(Mul4(f.AbsNormalX[p], ex), Mul4(f.AbsNormalY[p], ey)), Mul4(f.AbsNormalZ[p], ez));
+                inside = And4(inside, GreaterEqual4(Add4(dist, reach), zero));
+            }
+
+            const uint32_t mask = MoveMask4(inside) & TailMask(i, count);
+            pOut = EmitVisible<kGroupWidth>(pOut, static_cast<uint32_t>(i), mask);
+        }
+        return pOut;
+    }
+
+    // Every chunk writes its visible indices starting at its own first index, which can't overlap another chunk's
+    // output since a chunk never emits more than it tests. The results are then packed down in chunk order.
+    template <typename Volumes, typename RangeFunc>
+    void CullVolumes(const Frustum& frustum, const Volumes& volumes, std::vector<uint32_t>& out_visible, CullStats* pStats, RangeFunc cullRange)
+    {
+        using Clock = std::chrono::high_resolution_clock;
+        const Clock::time_point cullStart = Clock::now();
+
+        const size_t count = volumes.GetCount();
+        const size_t paddedCount = PaddedCount(count);
+        out_visible.resize(paddedCount);
+
+        uint32_t numChunks = 1;
+        if (count >= 2 * kMinVolumesPerChunk)
+            numChunks = static_cast<uint32_t>(std::min<size_t>(JobSystem::GetSingleton().GetNumThreads(), count / kMinVolumesPerChunk));
+
+        const size_t chunkSize = PaddedCount((paddedCount + numChunks - 1) / numChunks);
+        const FrustumLanes lanes(frustum);
+        uint32_t* pOutBase = out_visible.data();
+
+        std::vector<uint32_t> chunkVisible(numChunks, 0);
+        auto cullChunks = [&](size_t chunkBegin, size_t chunkEnd)
+        {
+            for (size_t c = chunkBegin; c != chunkEnd; ++c)
+            {
+                const size_t begin = c * chunkSize;
+                const size_t end = std::min(paddedCount, begin + chunkSize);
+                if (begin >= end)
+                    continue;
+
+                uint32_t* pEnd = cullRange(lanes, volumes, begin, end, count, pOutBase + begin);
+                chunkVisible[c] = static_cast<uint32_t>(pEnd - (pOutBase + begin));
+            }
+        };
+
+        if (numChunks == 1)
+            cullChunks(0, 1);
+        else
+            JobSystem::GetSingleton().ParallelFor(numChunks, 1, cullChunks);
+
+        size_t numVisible = chunkVisible[0];
+        for (uint32_t c = 1; c != numChunks; ++c)
+        {
+            memmove(pOutBase + numVisible, pOutBase + c * chunkSize, chunkVisible[c] * sizeof(uint32_t));
+            numVisible += chunkVisible[c];
+        }
+        out_visible.resize(numVisible);
+
+        if (pStats)
+        {
+            pStats->NumTested = static_cast<uint32_t>(count);
+            pStats->NumVisible = static_cast<uint32_t>(numVisible);
+            pStats->NumChunks = numChunks;
+            pStats->CullMs = std::chrono::duration<double, std::milli>(Clock::now() - cullStart).count();
+        }
+    }
+}
+
+// Gribb-Hartmann. With clip = v * M the clip coordinates are dot products with M's columns, and each plane
+// is a sum or difference of the w column with another. D3D clips z to [0, w], so near is the z column alone.
+void ExtractFrustumPlanes(const float m[16], Frustum& out_frustum)
+{
+    auto column = [m](uint32_t c, float out[4])
+    {
+        for (uint32_t r = 0; r != 4; ++r)
+            out[r] = m[r * 4 + c];
+    };
+
+    float x[4], y[4], z[4], w[4];
+    column(0, x);
+    column(1, y);
+    column(2, z);
+    column(3, w);
+
+    float planes[Frustum::COUNT][4];
+    for (uint32_t i = 0; i != 4; ++i)
+    {
+        planes[Frustum::LEFT][i] = w[i] + x[i];
+        planes[Frustum::RIGHT][i] = w[i] - x[i];
+        planes[Frustum::BOTTOM][i] = w[i] + y[i];
+        planes[Frustum::TOP][i] = w[i] - y[i];
+        planes[Frustum::NEAR_PLANE][i] = z[i];
+        planes[Frustum::FAR_PLANE][i] = w[i] - z[i];
+    }
+
+    // Normalized so plane distances are world space distances, which sphere radii are compared against
+    for (uint32_t p = 0; p != Frustum::COUNT; ++p)
+    {
+        const float length = sqrtf(planes[p][0] * planes[p][0] + planes[p][1] * planes[p][1] + planes[p][2] * planes[p][2]);
+        const float invLength = length > 0.0f ? 1.0f / length : 0.0f;
+        out_frustum.NormalX[p] = planes[p][0] * invLength;
+        out_frustum.NormalY[p] = planes[p][1] * invLength;
+        out_frustum.NormalZ[p] = planes[p][2] * invLength;
+        out_frustum.D[p] = planes[p][3] * invLength;
+    }
+}
+
+void BoundingSpheresSoA::Resize(size_t count)
+{
+    const size_t paddedCount = PaddedCount(count);
+    CenterX.resize(paddedCount, 0.0f);
+    CenterY.resize(paddedCount, 0.0f);
+    CenterZ.resize(paddedCount, 0.0f);
+    Radius.resize(paddedCount, 0.0f);
+    mCount = count;
+}
+
+void BoundingSpheresSoA::Set(size_t i, float x, float y, float z, float radius)
+{
+    CenterX[i] = x;
+    CenterY[i] = y;
+    CenterZ[i] = z;
+    Radius[i] = radius;
+}
+
+void BoundingBoxesSoA::Resize(size_t count)
+{
+    const size_t paddedCount = PaddedCount(count);
+    CenterX.resize(paddedCount, 0.0f);
+    CenterY.resize(paddedCount, 0.0f);
+    CenterZ.resize(paddedCount, 0.0f);
+    ExtentX.resize(paddedCount, 0.0f);
+    ExtentY.resize(paddedCount, 0.0f);
+    ExtentZ.resize(paddedCount, 0.0f);
+    mCount = count;
+}
+
+void BoundingBoxesSoA::Set(size_t i, const float center[3], const float extents[3])
+{
+    CenterX[i] = center[0];
+    CenterY[i] = center[1];
+    CenterZ[i] = center[2];
+    ExtentX[i] = extents[0];
+    ExtentY[i] = extents[1];
+    ExtentZ[i] = extents[2];
+}
+
+void CullSpheres(const Frustum& frustum, const BoundingSpheresSoA& spheres, std::vector<uint32_t>& out_visible, CullStats* pStats)
+{
+    MUON_PROFILE_SCOPE("Frustum Cull Spheres");
+    CullVolumes(frustum, spheres, out_visible, pStats, CullSphereRange);
+}
+
+void CullBoxes(const Frustum& frustum, const BoundingBoxesSoA& boxes, std::vector<uint32_t>& out_visible, CullStats* pStats)
+{
+    MUON_PROFILE_SCOPE("Frustum Cull Boxes");
+    CullVolumes(frustum, boxes, out_visible, pStats, CullBoxRange);
+}
+
+}
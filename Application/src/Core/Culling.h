@@ -0,0 +1,74 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Frustum culling over structure-of-arrays bounding volumes
+----------------------------------------------*/
+#ifndef MUON_CULLING_H
+#define MUON_CULLING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace Muon
+{
+
+// Planes point inward: a point p is inside when Normal.p + D >= 0 for all six
+struct Frustum
+{
+    enum Planes { LEFT, RIGHT, BOTTOM, TOP, NEAR_PLANE, FAR_PLANE, COUNT };
+
+    float NormalX[COUNT];
+    float NormalY[COUNT];
+    float NormalZ[COUNT];
+    float D[COUNT];
+};
+
+// From a row-major view-projection matrix in the row-vector convention used by DirectXMath (clip = v * M), with D3D's [0, 1] depth
+void ExtractFrustumPlanes(const float viewProj[16], Frustum& out_frustum);
+
+// The arrays are padded with empty volumes to a multiple of CULL_SIMD_PADDING, so SIMD loads never run past the end
+static const uint32_t CULL_SIMD_PADDING = 8;
+
+struct BoundingSpheresSoA
+{
+    std::vector<float> CenterX, CenterY, CenterZ, Radius;
+
+    void Resize(size_t count);
+    void Set(size_t i, float x, float y, float z, float radius);
+    size_t GetCount() const { return mCount; }
+
+private:
+    size_t mCount = 0;
+};
+
+// Center and half extents
+struct BoundingBoxesSoA
+{
+    std::vector<float> CenterX, CenterY, CenterZ;
+    std::vector<float> ExtentX, ExtentY, ExtentZ;
+
+    void Resize(size_t count);
+    void Set(size_t i, const float center[3], const float extents[3]);
+    size_t GetCount() const { return mCount; }
+
+private:
+    size_t mCount = 0;
+};
+
+struct CullStats
+{
+    uint32_t NumTested = 0;
+    uint32_t NumVisible = 0;
+    uint32_t NumChunks = 0;
+    double CullMs = 0.0;
+};
+
+// Writes the indices of volumes intersecting the frustum to out_visible, in ascending order. Splits the work across
+// the job system once there's enough of it; the job system must be initialized for that.
+void CullSpheres(const Frustum& frustum, const BoundingSpheresSoA& spheres, std::vector<uint32_t>& out_visible, CullStats* pStats = nullptr);
+void CullBoxes(const Frustum& frustum, const BoundingBoxesSoA& boxes, std::vector<uint32_t>& out_visible, CullStats* pStats = nullptr);
+
+}
+
+#endif
@@ -0,0 +1,116 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Command recorder that gives each chunk its own D3D12 command list
+----------------------------------------------*/
+#include <Core/D3D12CommandRecorder.h>
+
+#include <Core/ThrowMacros.h>
+#include <Utils/Utils.h>
+
+#include <string>
+
+namespace Muon
+{
+
+bool D3D12CommandRecorder::Init(const wchar_t* name, uint32_t maxChunks, RecorderTargets targets)
+{
+    ID3D12Device* pDevice = GetDevice();
+    if (!pDevice || maxChunks == 0 || maxChunks > RECORDER_MAX_CHUNKS)
+        return false;
+
+    mTargets = targets;
+
+    mChunkLists.resize(maxChunks);
+    for (uint32_t i = 0; i != maxChunks; ++i)
+    {
+        ChunkList& chunk = mChunkLists[i];
+        for (uint32_t frame = 0; frame != MN_FRAMES_IN_FLIGHT; ++frame)
+        {
+            HRESULT hr = pDevice->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(chunk.Allocators[frame].GetAddressOf()));
+            COM_EXCEPT(hr);
+            if (FAILED(hr))
+                return false;
+        }
+
+        HRESULT hr = pDevice->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, chunk.Allocators[0].Get(), nullptr, IID_PPV_ARGS(chunk.List.GetAddressOf()));
+        COM_EXCEPT(hr);
+        if (FAILED(hr))
+            return false;
+
+        // Lists are created open, but RecordChunk expects to Reset them
+        chunk.List->Close();
+
+        std::wstring listName = std::wstring(name) + L" " + std::to_wstring(i);
+        chunk.List->SetName(listName.c_str());
+    }
+
+    return true;
+}
+
+void D3D12CommandRecorder::Destroy()
+{
+    mChunkLists.clear();
+    mNumChunks = 0;
+    mRecordFunc = nullptr;
+}
+
+bool D3D12CommandRecorder::BeginRecording(uint32_t numChunks)
+{
+    if (numChunks > mChunkLists.size() || !mRecordFunc)
+        return false;
+
+    mNumChunks = numChunks;
+    for (uint32_t i = 0; i != numChunks; ++i)
+        mChunkLists[i].Recorded = false;
+
+    return true;
+}
+
+void D3D12CommandRecorder::RecordChunk(uint32_t chunkIndex, size_t begin, size_t end)
+{
+    ChunkList& chunk = mChunkLists[chunkIndex];
+
+    // BeginFrame already waited for this frame context, so its allocators are free to reuse
+    ID3D12CommandAllocator* pAllocator = chunk.Allocators[GetFrameIndex()].Get();
+    HRESULT hr = pAllocator->Reset();
+    COM_EXCEPT(hr);
+
+    hr = chunk.List->Reset(pAllocator, nullptr);
+    COM_EXCEPT(hr);
+    if (FAILED(hr))
+        return;
+
+    if (mTargets == RecorderTargets::DepthOnly)
+        SetDepthOnlyTargetState(chunk.List.Get());
+    else
+        SetRenderTargetState(chunk.List.Get());
+    mRecordFunc(chunk.List.Get(), begin, end);
+
+    hr = chunk.List->Close();
+    COM_EXCEPT(hr);
+    chunk.Recorded = SUCCEEDED(hr);
+}
+
+bool D3D12CommandRecorder::Submit()
+{
+    ID3D12CommandList* lists[RECORDER_MAX_CHUNKS];
+    UINT numLists = 0;
+    for (uint32_t i = 0; i != mNumChunks; ++i)
+    {
+        // A failed chunk is dropped rather than submitting a list that never closed
+        if (!mChunkLists[i].Recorded)
+        {
+            Muon::Printf("Error: Command recording chunk %u failed and was skipped!\n", i);
+            continue;
+        }
+
+        lists[numLists++] = mChunkLists[i].List.Get();
+    }
+
+    const bool submitted = SubmitCommandLists(lists, numLists);
+    mNumChunks = 0;
+    return submitted;
+}
+
+}
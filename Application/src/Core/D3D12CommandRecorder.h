@@ -0,0 +1,62 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Command recorder that gives each chunk its own D3D12 command list
+----------------------------------------------*/
+#ifndef MUON_D3D12COMMANDRECORDER_H
+#define MUON_D3D12COMMANDRECORDER_H
+
+#include <Core/CommandRecorder.h>
+#include <Core/DXCore.h>
+
+#include <functional>
+#include <vector>
+#include <wrl/client.h>
+
+namespace Muon
+{
+
+static const uint32_t RECORDER_MAX_CHUNKS = 64;
+
+// What every chunk's list has bound before the record function runs
+enum class RecorderTargets
+{
+    BackBuffer, // Back buffer and depth buffer
+    DepthOnly,  // Depth buffer alone, for depth-only pipelines
+};
+
+class D3D12CommandRecorder : public ICommandRecorder
+{
+public:
+    // Records items [begin, end) into a list whose render targets, viewport and scissor are already set.
+    // Runs on worker threads, so it must only read shared state.
+    typedef std::function<void(ID3D12GraphicsCommandList* pCommandList, size_t begin, size_t end)> RecordFunc;
+
+    bool Init(const wchar_t* name, uint32_t maxChunks, RecorderTargets targets = RecorderTargets::BackBuffer);
+    void Destroy();
+
+    void SetRecordFunc(RecordFunc func) { mRecordFunc = std::move(func); }
+
+    uint32_t GetMaxChunks() const override { return static_cast<uint32_t>(mChunkLists.size()); }
+    bool BeginRecording(uint32_t numChunks) override;
+    void RecordChunk(uint32_t chunkIndex, size_t begin, size_t end) override;
+    bool Submit() override;
+
+private:
+    // Each frame in flight needs its own allocators, the lists themselves can be reset as soon as they're submitted
+    struct ChunkList
+    {
+        Microsoft::WRL::ComPtr<ID3D12CommandAllocator> Allocators[MN_FRAMES_IN_FLIGHT];
+        Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> List;
+        bool Recorded = false;
+    };
+
+    std::vector<ChunkList> mChunkLists;
+    uint32_t mNumChunks = 0;
+    RecorderTargets mTargets = RecorderTargets::BackBuffer;
+    RecordFunc mRecordFunc;
+};
+
+}
+
+#endif
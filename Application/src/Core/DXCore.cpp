@@ -10,6 +10,8 @@ or "Introduction to 3D Game Programming with DirectX 12" by Frank Luna
 #include <Core/DXCore.h>
 #include <Core/ThrowMacros.h>
 #include <Core/CBufferStructs.h>
+#include <Core/Buffers.h>
+#include <Core/Profiler.h>
 
 #include <d3dx12.h>
 #include <d3d12.h>
@@ -17,6 +19,7 @@ or "Introduction to 3D Game Programming with DirectX 12" by Frank Luna
 #include <dxgidebug.h>
 #include <stdint.h>
 #include <wrl/client.h>
+#include <chrono>
 #include <sstream>
 
 #define CHECK_SUCCESS(s, msg)       \
@@ -41,9 +44,32 @@ namespace Muon
     UINT gMSAAQuality = 0;
 
     Microsoft::WRL::ComPtr<ID3D12CommandQueue> gCommandQueue;
-    Microsoft::WRL::ComPtr<ID3D12CommandAllocator> gCommandAllocator;
     Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> gCommandList;
 
+    // Everything a frame writes that the GPU may still be reading while the CPU records the next ones
+    struct FrameContext
+    {
+        Microsoft::WRL::ComPtr<ID3D12CommandAllocator> CommandAllocator;
+        UploadBuffer TransientUploadBuffer; // Persistently mapped, rewound at the start of the frame
+        UINT64 FenceValue = 0;              // Signaled once the GPU is done with this frame
+    };
+
+    const size_t FRAME_UPLOAD_BUFFER_SIZE = 4 * 1024 * 1024; // Constants plus instance streams, 64 bytes per instance
+    const UINT MAX_SUBMITTED_LISTS = 64; // Per SubmitCommandLists call, besides the main list
+
+    FrameContext gFrameContexts[MN_FRAMES_IN_FLIGHT];
+    uint32_t gFrameIndex = 0;
+
+    // Accumulated between title bar updates
+    struct FrameStats
+    {
+        uint32_t NumFrames = 0;
+        uint32_t NumStalls = 0;      // Frames where the CPU caught up to the GPU and had to wait
+        uint64_t FramesQueued = 0;   // Sum of the frames still on the GPU when each frame began
+        double CPUWaitMs = 0.0;
+    };
+    FrameStats gFrameStats;
+
     DXGI_FORMAT BackBufferFormat = DXGI_FORMAT_R8G8B8A8_UNORM;
     DXGI_FORMAT DepthStencilFormat = DXGI_FORMAT_D24_UNORM_S8_UINT;
     const int SWAP_CHAIN_BUFFER_COUNT = 2;
@@ -76,10 +102,15 @@ namespace Muon
     UINT GetMSAAQualityLevel() { return gMSAAQuality; }
     ID3D12CommandQueue* GetCommandQueue() { return gCommandQueue.Get(); }
     ID3D12GraphicsCommandList* GetCommandList() { return gCommandList.Get(); }
-    ID3D12CommandAllocator* GetCommandAllocator() { return gCommandAllocator.Get(); }
+    ID3D12CommandAllocator* GetCommandAllocator() { return gFrameContexts[gFrameIndex].CommandAllocator.Get(); }
+    uint32_t GetFrameIndex() { return gFrameIndex; }
     IDXGISwapChain3* GetSwapChain() { return gSwapChain.Get(); }
     DXGI_FORMAT GetBackBufferFormat() { return BackBufferFormat; }
+    UINT GetBackBufferWidth() { return static_cast<UINT>(gViewport.Width); }
+    UINT GetBackBufferHeight() { return static_cast<UINT>(gViewport.Height); }
+    ID3D12Resource* GetCurrentBackBuffer() { return gSwapChainBuffers[CurrentBackBuffer].Get(); }
     DXGI_FORMAT GetDepthStencilFormat() { return DepthStencilFormat; }
+    ID3D12Resource* GetDepthStencilBuffer() { return gDepthStencilBuffer.Get(); }
 
     /////////////////////////////////////////////////////////////////////
     /// Interface Utility Functions
@@ -265,7 +296,7 @@ namespace Muon
 
     bool CreateCommandObjects(ID3D12Device* pDevice,
         Microsoft::WRL::ComPtr<ID3D12CommandQueue>& out_queue,
-        Microsoft::WRL::ComPtr<ID3D12CommandAllocator>& out_alloc,
+        FrameContext (&out_frames)[MN_FRAMES_IN_FLIGHT],
         Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList>& out_list)
     {
         HRESULT hr;
@@ -276,15 +307,22 @@ namespace Muon
         hr = pDevice->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(out_queue.GetAddressOf()));
         COM_EXCEPT(hr);
 
-        hr = pDevice->CreateCommandAllocator(
-            D3D12_COMMAND_LIST_TYPE_DIRECT,
-            IID_PPV_ARGS(out_alloc.GetAddressOf()));
-        COM_EXCEPT(hr);
+        for (uint32_t i = 0; i != MN_FRAMES_IN_FLIGHT; ++i)
+        {
+            hr = pDevice->CreateCommandAllocator(
+                D3D12_COMMAND_LIST_TYPE_DIRECT,
+                IID_PPV_ARGS(out_frames[i].CommandAllocator.GetAddressOf()));
+            COM_EXCEPT(hr);
+
+            std::wstring uploadName = L"Frame Upload Buffer " + std::to_wstring(i);
+            out_frames[i].TransientUploadBuffer.Create(uploadName.c_str(), FRAME_UPLOAD_BUFFER_SIZE);
+            out_frames[i].TransientUploadBuffer.Map();
+        }
 
         hr = pDevice->CreateCommandList(
             0,
             D3D12_COMMAND_LIST_TYPE_DIRECT,
-            out_alloc.Get(), // Associated command allocator
+            out_frames[0].CommandAllocator.Get(), // Associated command allocator
             nullptr,         // Initial PipelineStateObject
             IID_PPV_ARGS(out_list.GetAddressOf()));
         COM_EXCEPT(hr);
@@ -471,39 +509,142 @@ namespace Muon
         return SUCCEEDED(hr);
     }
 
+    bool BeginFrame(ID3D12PipelineState* pInitialPipelineState)
+    {
+        using Clock = std::chrono::high_resolution_clock;
+
+        FrameContext& frame = gFrameContexts[gFrameIndex];
+        ID3D12GraphicsCommandList* pCommandList = GetCommandList();
+        if (!frame.CommandAllocator || !pCommandList)
+            return false;
+
+        const UINT64 completed = gFence->GetCompletedValue();
+        gFrameStats.NumFrames++;
+        gFrameStats.FramesQueued += (gFenceVal - 1) - completed;
+
+        // Only block if the GPU is still on the frame that last used this context
+        if (completed < frame.FenceValue)
+        {
+            MUON_PROFILE_SCOPE("Wait For GPU");
+            const Clock::time_point waitStart = Clock::now();
+
+            HANDLE eventHandle = CreateEventEx(nullptr, false, false, EVENT_ALL_ACCESS);
+            if (!eventHandle)
+            {
+                HRESULT hr = HRESULT_FROM_WIN32(GetLastError());
+                COM_EXCEPT(hr);
+                return false;
+            }
+            gFence->SetEventOnCompletion(frame.FenceValue, eventHandle);
+            WaitForSingleObject(eventHandle, INFINITE);
+            CloseHandle(eventHandle);
+
+            gFrameStats.NumStalls++;
+            gFrameStats.CPUWaitMs += std::chrono::duration<double, std::milli>(Clock::now() - waitStart).count();
+        }
+
+        frame.TransientUploadBuffer.ResetAllocations();
+
+        HRESULT hr = frame.CommandAllocator->Reset();
+        COM_EXCEPT(hr);
+
+        hr = pCommandList->Reset(frame.CommandAllocator.Get(), pInitialPipelineState);
+        COM_EXCEPT(hr);
+
+        return SUCCEEDED(hr);
+    }
+
+    bool EndFrame()
+    {
+        if (!CloseCommandList())
+            return false;
+
+        ExecuteCommandList();
+        const bool presented = Present();
+
+        FrameContext& frame = gFrameContexts[gFrameIndex];
+        frame.FenceValue = gFenceVal;
+        HRESULT hr = GetCommandQueue()->Signal(gFence.Get(), gFenceVal);
+        gFenceVal++;
+
+        gFrameIndex = (gFrameIndex + 1) % MN_FRAMES_IN_FLIGHT;
+        UpdateBackBufferIndex();
+
+        return presented && SUCCEEDED(hr);
+    }
+
+    bool AllocateFrameConstants(const void* pData, size_t dataSize, D3D12_GPU_VIRTUAL_ADDRESS& out_gpuAddr)
+    {
+        MUON_PROFILE_SCOPE("Upload Frame Constants");
+        void* pMapped = nullptr;
+        if (!AllocateFrameUpload(dataSize, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT, pMapped, out_gpuAddr))
+            return false;
+
+        memcpy(pMapped, pData, dataSize);
+        return true;
+    }
+
+    bool AllocateFrameUpload(size_t size, UINT alignment, void*& out_mappedPtr, D3D12_GPU_VIRTUAL_ADDRESS& out_gpuAddr)
+    {
+        UINT offset = 0;
+        UploadBuffer& uploadBuffer = gFrameContexts[gFrameIndex].TransientUploadBuffer;
+        return uploadBuffer.Allocate((UINT)size, alignment, out_mappedPtr, out_gpuAddr, offset);
+    }
+
     bool CloseCommandList()
     {
         ID3D12GraphicsCommandList* pCommandList = GetCommandList();
         return pCommandList && SUCCEEDED(pCommandList->Close());
     }
 
-    bool PrepareForRender()
+    bool SetRenderTargetState(ID3D12GraphicsCommandList* pCommandList)
     {
-        ID3D12GraphicsCommandList* pCommandList = GetCommandList();
+        if (!pCommandList)
+            return false;
 
-        //pCommandList->SetGraphicsRootSignature(gRootSig.Get());
         pCommandList->RSSetViewports(1, &gViewport);
         pCommandList->RSSetScissorRects(1, &gScissorRect);
 
-        // Set back buffer as render target
-        pCommandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(gSwapChainBuffers[CurrentBackBuffer].Get(), D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET));
-
         CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHandle(gRTVHeap->GetCPUDescriptorHandleForHeapStart(), CurrentBackBuffer, gRTVSize);
-        pCommandList->OMSetRenderTargets(1, &rtvHandle, FALSE, nullptr);
+        const D3D12_CPU_DESCRIPTOR_HANDLE dsvHandle = DepthStencilView();
+        pCommandList->OMSetRenderTargets(1, &rtvHandle, FALSE, &dsvHandle);
+        return true;
+    }
 
-        // Clear the back buffer
-        const float clearColor[] = { 0.0f, 0.2f, 0.4f, 1.0f };
-        pCommandList->ClearRenderTargetView(rtvHandle, clearColor, 0, nullptr);
+    bool SetDepthOnlyTargetState(ID3D12GraphicsCommandList* pCommandList)
+    {
+        if (!pCommandList)
+            return false;
 
+        pCommandList->RSSetViewports(1, &gViewport);
+        pCommandList->RSSetScissorRects(1, &gScissorRect);
+
+        const D3D12_CPU_DESCRIPTOR_HANDLE dsvHandle = DepthStencilView();
+        pCommandList->OMSetRenderTargets(0, nullptr, FALSE, &dsvHandle);
         return true;
     }
 
-    bool FinalizeRender()
+    bool SubmitCommandLists(ID3D12CommandList* const* ppLists, UINT numLists)
     {
-        // Now set back buffer as present target
+        // Rejected before closing anything, so the main list is still open for the caller
+        if (numLists > MAX_SUBMITTED_LISTS || (numLists && !ppLists))
+            return false;
+
         ID3D12GraphicsCommandList* pCommandList = GetCommandList();
-        pCommandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(gSwapChainBuffers[CurrentBackBuffer].Get(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT));
-        return true;
+        if (!CloseCommandList())
+            return false;
+
+        ID3D12CommandList* lists[MAX_SUBMITTED_LISTS + 1];
+        lists[0] = pCommandList;
+        for (UINT i = 0; i != numLists; ++i)
+            lists[i + 1] = ppLists[i];
+
+        GetCommandQueue()->ExecuteCommandLists(numLists + 1, lists);
+
+        // The allocator keeps what was just submitted alive, so the main list can reopen on it right away
+        HRESULT hr = pCommandList->Reset(GetCommandAllocator(), nullptr);
+        COM_EXCEPT(hr);
+        return SUCCEEDED(hr);
     }
 
     bool ExecuteCommandList()
@@ -518,6 +659,7 @@ namespace Muon
 
     bool Present()
     {
+        MUON_PROFILE_SCOPE("Present");
         if (!GetSwapChain())
             return false;
 
@@ -583,7 +725,7 @@ namespace Muon
     bool UpdateTitleBar(uint32_t fps, uint32_t frameCount)
     {
         // Update title bar every 120 frames
-        if (frameCount % 120 == 0)
+        if (frameCount % 120 != 0)
             return false;
 
         std::wstringstream wss;
@@ -595,6 +737,19 @@ namespace Muon
 
         wss << "    " << gFeatureLevelStr;
 
+        // How far the CPU runs ahead: the GPU queue depth at the start of each frame, and how often and how long the CPU had to wait for it
+        if (gFrameStats.NumFrames > 0)
+        {
+            const double numFrames = (double)gFrameStats.NumFrames;
+            wss.precision(2);
+            wss << std::fixed <<
+                L"    Frames in flight: " << MN_FRAMES_IN_FLIGHT <<
+                L"    GPU queue: " << gFrameStats.FramesQueued / numFrames <<
+                L"    CPU wait: " << gFrameStats.CPUWaitMs / numFrames << L"ms" <<
+                L" (" << (int)(100.0 * gFrameStats.NumStalls / numFrames) << L"% stalled)";
+        }
+        gFrameStats = FrameStats();
+
         // MSAA Level
         //wss << L"    " << mMSAASampleCount << L"xMSAA";
 
@@ -646,7 +801,7 @@ namespace Muon
         //success &= DetermineMSAAQuality(GetDevice(), &gMSAAQuality);
         //CHECK_SUCCESS(success, "Error: Failed to determine MSAA quality!");
 
-        success &= CreateCommandObjects(GetDevice(), gCommandQueue, gCommandAllocator, gCommandList);
+        success &= CreateCommandObjects(GetDevice(), gCommandQueue, gFrameContexts, gCommandList);
         CHECK_SUCCESS(success, "Error: Failed to create command objects!\n");
 
         success &= CreateSwapChain(GetDevice(), dxgiFactory.Get(), GetCommandQueue(), hwnd, width, height, gSwapChain);
@@ -664,7 +819,7 @@ namespace Muon
         success &= CreateDepthStencilBuffer(GetDevice(), GetCommandList(), GetCommandQueue(), width, height, gDepthStencilBuffer);
         CHECK_SUCCESS(success, "Error: Failed to create depth stencil buffer!\n");
 
-        success &= SetViewport(GetCommandList(), 0, 0, width, height, 0.001f, 1000.0f);
+        success &= SetViewport(GetCommandList(), 0, 0, width, height, 0.0f, 1.0f);
         CHECK_SUCCESS(success, "Error: Failed to set viewport!\n");
 
         success &= SetScissorRects(GetCommandList(), 0, 0, width, height);
@@ -721,7 +876,12 @@ namespace Muon
         gRTVHeap.Reset();
         gDSVHeap.Reset();
         gCommandList.Reset();
-        gCommandAllocator.Reset();
+        for (FrameContext& frame : gFrameContexts)
+        {
+            frame.CommandAllocator.Reset();
+            frame.TransientUploadBuffer.Destroy();
+            frame.FenceValue = 0;
+        }
         gCommandQueue.Reset();
         gSwapChain.Reset();
         gFence.Reset();
@@ -740,6 +900,8 @@ namespace Muon
         gCBVSize = 0;
         gMSAAQuality = 0;
         CurrentBackBuffer = 0;
+        gFrameIndex = 0;
+        gFrameStats = FrameStats();
         gHwnd = nullptr;
 
         return true;
@@ -13,8 +13,17 @@ Description : Holds all the central DX12 Data structures
 #pragma comment(lib, "d3d12.lib")
 #pragma comment(lib, "dxgi.lib")
 #pragma comment(lib, "d3dcompiler.lib")
+#pragma comment(lib, "dxcompiler.lib")
 #pragma comment(lib, "dxguid.lib")
 
+// Number of frames the CPU may record ahead of the GPU. Each one owns a command allocator, a fence value and
+// a transient upload buffer, so the CPU only blocks when it is about to reuse a frame the GPU hasn't finished.
+#ifndef MN_FRAMES_IN_FLIGHT
+#define MN_FRAMES_IN_FLIGHT 2
+#endif
+
+static_assert(MN_FRAMES_IN_FLIGHT >= 2 && MN_FRAMES_IN_FLIGHT <= 3, "MN_FRAMES_IN_FLIGHT must be 2 or 3");
+
 namespace Muon
 {
 	ID3D12Device* GetDevice();
@@ -23,10 +32,46 @@ namespace Muon
 	ID3D12CommandAllocator* GetCommandAllocator();
 	ID3D12Fence* GetFence();
 
+	uint32_t GetFrameIndex();
+
+	// Start recording the next frame: waits only if that frame's previous use is still on the GPU, then resets its allocator and upload buffer.
+	bool BeginFrame(ID3D12PipelineState* pInitialPipelineState);
+
+	// Closes and submits the frame's command list, presents, and fences the frame context so it can be reused once the GPU is done.
+	bool EndFrame();
+
+	// Copies data into the current frame's upload buffer and returns its GPU address. Valid until this frame context comes around again.
+	// Not thread safe: upload shared per-frame data on the main thread before recording in parallel.
+	bool AllocateFrameConstants(const void* pData, size_t dataSize, D3D12_GPU_VIRTUAL_ADDRESS& out_gpuAddr);
+
+	// Same lifetime and threading rules, but hands out the mapped memory to write into directly (e.g. instance streams)
+	bool AllocateFrameUpload(size_t size, UINT alignment, void*& out_mappedPtr, D3D12_GPU_VIRTUAL_ADDRESS& out_gpuAddr);
+
+	// Waits for all submitted work. Only for init, shutdown and resource loading; frames use BeginFrame/EndFrame instead.
 	bool ResetCommandList(ID3D12PipelineState* pInitialPipelineState);
 	bool CloseCommandList();
-	bool PrepareForRender();
-	bool FinalizeRender();
+
+	// The swap chain buffer this frame renders into. Its transitions are left to the render graph.
+	ID3D12Resource* GetCurrentBackBuffer();
+	D3D12_CPU_DESCRIPTOR_HANDLE CurrentBackBufferView();
+	DXGI_FORMAT GetBackBufferFormat();
+	UINT GetBackBufferWidth();
+	UINT GetBackBufferHeight();
+
+	// The depth buffer is created in the depth write state and never leaves it outside the render graph
+	ID3D12Resource* GetDepthStencilBuffer();
+	D3D12_CPU_DESCRIPTOR_HANDLE DepthStencilView();
+	DXGI_FORMAT GetDepthStencilFormat();
+
+	// Binds the back buffer, depth buffer, viewport and scissor. Every command list drawing to the back buffer needs this.
+	bool SetRenderTargetState(ID3D12GraphicsCommandList* pCommandList);
+
+	// Same, but binds only the depth buffer, for depth-only pipelines with no render targets
+	bool SetDepthOnlyTargetState(ID3D12GraphicsCommandList* pCommandList);
+
+	// Submits the main command list followed by ppLists in one ExecuteCommandLists call, then reopens the main list
+	// so the frame can keep recording (e.g. the render graph's final barriers) after them.
+	bool SubmitCommandLists(ID3D12CommandList* const* ppLists, UINT numLists);
 	bool ExecuteCommandList();
 	bool Present();
 	bool FlushCommandQueue();
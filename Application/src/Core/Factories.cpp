@@ -10,14 +10,26 @@
 
 // ShaderFactory
 #include "Shader.h"
+#include <Core/JobSystem.h>
+#include <Core/Profiler.h>
 
 // TextureFactory
 #include "Material.h"
+#include <Core/NoiseVolume.h>
+#include <d3dx12.h>
 #include <filesystem>
 #include <DDSTextureLoader.h>
 #include <WICTextureLoader.h>
 #include <ResourceUploadBatch.h>
 
+// CloudVolumeFactory
+#include <Core/NanoVDBImporter.h>
+#include <Core/SparseCloudVolume.h>
+
+// MaterialFactory
+#include <Core/CodexManifest.h>
+#include <chrono>
+
 #include <Core/DXCore.h>
 #include <Utils/Utils.h>
 #include <unordered_map>
@@ -122,6 +134,13 @@ MeshID MeshFactory::CreateMesh(const char* fileName, const VertexBufferDescripti
             if (!success)
                 Muon::Print("Failed to init mesh!\n");
 
+            // Init takes bounds from the start of each vertex, which is only right when the position comes first
+            for (unsigned int k = 0; success && k != vertDesc.AttrCount; ++k)
+            {
+                if (vertDesc.SemanticsArr[k] == Semantics::POSITION && vertDesc.ByteOffsets[k] != 0)
+                    out_mesh.ComputeBounds(vertices, numVertices, vertDesc.ByteSize, vertDesc.ByteOffsets[k]);
+            }
+
             free(vertices);
             free(indices);
         }
@@ -157,6 +176,7 @@ MeshID MeshFactory::CreateMesh(const char* fileName, const VertexBufferDescripti
 
 void MeshFactory::LoadAllMeshes(ResourceCodex& codex)
 {
+    MUON_PROFILE_SCOPE("Load Meshes");
     namespace fs = std::filesystem;
     std::string modelPath = MODELPATH;
 
@@ -181,9 +201,11 @@ void MeshFactory::LoadAllMeshes(ResourceCodex& codex)
     }
 }
 
-void ShaderFactory::LoadAllShaders(ResourceCodex& codex)
+void ShaderFactory::LoadAllShaders(ResourceCodex& codex, const CodexManifest& manifest)
 {
+    MUON_PROFILE_SCOPE("Load Shaders");
     namespace fs = std::filesystem;
+    using Clock = std::chrono::high_resolution_clock;
     std::string shaderPath = SHADERPATH;
 
     #if defined(MN_DEBUG)
@@ -191,29 +213,117 @@ void ShaderFactory::LoadAllShaders(ResourceCodex& codex)
         throw std::exception("Shaders folder doesn't exist!");
     #endif
 
-    // Iterate through folder and load shaders
-    for (const auto& entry : fs::directory_iterator(shaderPath))
+    const Clock::time_point loadStart = Clock::now();
+
+    struct PendingShader
     {
-        std::wstring path = entry.path();
-        std::wstring name = entry.path().filename();
+        std::wstring Path;
+        ShaderID Hash;
+        size_t Index; // Into vertexShaders or pixelShaders
+        bool IsVertex;
+    };
+
+    std::vector<PendingShader> pending;
+    size_t numVS = 0;
+    size_t numPS = 0;
+
+    // Only what the manifest declares is loaded, so build byproducts sitting next to the .cso files are never picked up
+    for (const ShaderDefinition& def : manifest.Shaders)
+    {
+        const std::wstring name(def.FileName.begin(), def.FileName.end());
+        const bool isVertex = def.Stage == ShaderStage::Vertex;
+        pending.push_back({ GetShaderPathFromFile_W(name), fnv1a(def.FileName.c_str()), isVertex ? numVS++ : numPS++, isVertex });
+    }
 
-        ShaderID hash = fnv1a(name.c_str());
+    std::vector<VertexShader> vertexShaders(numVS);
+    std::vector<PixelShader> pixelShaders(numPS);
 
-        // Parse file name to decide how to create this resource
-        if (name.find(L"VS") != std::wstring::npos)
+    // File read, reflection and input layout construction don't touch the codex, so each shader is independent
+    JobSystem& jobSystem = JobSystem::GetSingleton();
+    jobSystem.ParallelFor(pending.size(), 1, [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i != end; ++i)
         {
-            codex.AddVertexShader(hash, path.c_str());
+            const PendingShader& shader = pending[i];
+            if (shader.IsVertex)
+                vertexShaders[shader.Index].Init(shader.Path.c_str());
+            else
+                pixelShaders[shader.Index].Init(shader.Path.c_str());
         }
-        else if (name.find(L"PS") != std::wstring::npos)
+    });
+
+    size_t numLoaded = 0;
+    size_t numCached = 0;
+    for (const PendingShader& shader : pending)
+    {
+        bool initialized = false;
+        bool inserted = false;
+        bool cached = false;
+        if (shader.IsVertex)
         {
-            codex.AddPixelShader(hash, path.c_str());
+            VertexShader& vs = vertexShaders[shader.Index];
+            initialized = vs.Initialized;
+            cached = vs.FromReflectionCache;
+            inserted = initialized && codex.AddVertexShader(shader.Hash, std::move(vs));
+            if (!initialized)
+                vs.Release();
         }
+        else
+        {
+            PixelShader& ps = pixelShaders[shader.Index];
+            initialized = ps.Initialized;
+            cached = ps.FromReflectionCache;
+            inserted = initialized && codex.AddPixelShader(shader.Hash, std::move(ps));
+            if (!initialized)
+                ps.Release();
+        }
+
+        if (!initialized)
+            Muon::Printf(L"Warning: Failed to load shader %s!\n", shader.Path.c_str());
+
+        numLoaded += inserted ? 1 : 0;
+        numCached += (inserted && cached) ? 1 : 0;
+    }
+
+    const double loadMs = std::chrono::duration<double, std::milli>(Clock::now() - loadStart).count();
+    Muon::Printf("Info: Loaded %zu/%zu shaders (%zu reflected from cache) in %.2fms on %u threads.\n",
+        numLoaded, pending.size(), numCached, loadMs, jobSystem.GetNumThreads());
+}
+
+void ShaderFactory::LoadAllShaderSources(ResourceCodex& codex)
+{
+    MUON_PROFILE_SCOPE("Load Shader Sources");
+    namespace fs = std::filesystem;
+    const fs::path sourcePath = ASSETPATH "Shaders\\";
+
+    std::error_code ec;
+    if (!fs::exists(sourcePath, ec))
+    {
+        Muon::Print("Warning: Shader sources folder doesn't exist, variants can't be compiled!\n");
+        return;
+    }
+
+    size_t numPermutable = 0;
+    for (const auto& entry : fs::directory_iterator(sourcePath))
+    {
+        if (entry.path().extension() != L".hlsl")
+            continue;
+
+        ShaderPermutationSource source;
+        if (!ParsePermutationSource(entry.path().wstring(), source))
+            continue;
+
+        numPermutable += source.Defines.empty() ? 0 : 1;
+        codex.AddShaderSource(std::move(source));
     }
+
+    Muon::Printf("Info: Found %zu shader sources with permutations.\n", numPermutable);
 }
 
-// Loads all the textures from the directory and returns them as out params to the ResourceCodex
-void TextureFactory::LoadAllTextures(ID3D12Device* pDevice, ID3D12CommandList* pCommandList, ResourceCodex& codex)
+// Loads all the textures declared in the manifest and returns them as out params to the ResourceCodex
+void TextureFactory::LoadAllTextures(ID3D12Device* pDevice, ID3D12CommandList* pCommandList, ResourceCodex& codex, const CodexManifest& manifest)
 {
+    MUON_PROFILE_SCOPE("Load Textures");
     namespace fs = std::filesystem;
     std::string texturePath = TEXTUREPATH;
 
@@ -227,22 +337,11 @@ void TextureFactory::LoadAllTextures(ID3D12Device* pDevice, ID3D12CommandList* p
 
     pResourceUpload->Begin();
 
-    for (const auto& entry : fs::directory_iterator(texturePath))
+    for (const TextureDefinition& def : manifest.Textures)
     {
-        std::wstring path = entry.path().c_str();
-        std::wstring name = entry.path().filename().c_str();
-
-        size_t pos = name.find(L'_');
-        const std::wstring TexName = name.substr(0, pos++);
-        const std::wstring TexType = name.substr(pos, 1);
-
-        pos = name.find(L'.') + 1;
-        const std::wstring TexExt = name.substr(pos);
-
-        if (TexExt != L"png")
-            continue;
+        const std::wstring path(fs::path(texturePath + def.FileName).wstring());
 
-        TextureID tid = fnv1a(name.c_str());
+        TextureID tid = fnv1a(def.FileName.c_str());
         Texture& tex = codex.InsertTexture(tid);
 
         HRESULT hr = DirectX::CreateWICTextureFromFile(
@@ -265,6 +364,8 @@ void TextureFactory::LoadAllTextures(ID3D12Device* pDevice, ID3D12CommandList* p
         }
     }
 
+    LoadNoiseVolumes(pDevice, *pResourceUpload, codex);
+
     auto uploadResourcesFinished = pResourceUpload->End(Muon::GetCommandQueue());
     uploadResourcesFinished.wait();
 
@@ -289,66 +390,237 @@ bool TextureFactory::CreateSRV(DescriptorHeap& descHeap, ID3D12Device* pDevice,
     D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
     srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
     srvDesc.Format = resourceDesc.Format;
-    srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
-    srvDesc.Texture2D.MipLevels = resourceDesc.MipLevels;
-    srvDesc.Texture2D.MostDetailedMip = 0;
+    if (resourceDesc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D)
+    {
+        outTexture.Depth = resourceDesc.DepthOrArraySize;
+        srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE3D;
+        srvDesc.Texture3D.MipLevels = resourceDesc.MipLevels;
+        srvDesc.Texture3D.MostDetailedMip = 0;
+    }
+    else
+    {
+        outTexture.Depth = 1;
+        srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+        srvDesc.Texture2D.MipLevels = resourceDesc.MipLevels;
+        srvDesc.Texture2D.MostDetailedMip = 0;
+    }
 
     pDevice->CreateShaderResourceView(pResource, &srvDesc, outTexture.CPUHandle);
 
     return true;
 }
 
-bool MaterialFactory::CreateAllMaterials(ResourceCodex& codex)
+void TextureFactory::LoadNoiseVolumes(ID3D12Device* pDevice, DirectX::ResourceUploadBatch& uploadBatch, ResourceCodex& codex)
 {
-    const TextureID kRockDiffuseId = fnv1a(L"Rock_T.png");       // FNV1A of L"Lunar_T"
-    const TextureID kRockNormalId = fnv1a(L"Rock_N.png");       // FNV1A of L"Lunar_T"
+    MUON_PROFILE_SCOPE("Load Noise Volumes");
 
-    const ShaderID kPhongVSID = fnv1a("PhongVS.cso");
-    const ShaderID kPhongPSID = 0x4dc6e249;          // FNV1A of L"PhongPS.cso"
-    const ShaderID kPhongPSNormalMapID = fnv1a(L"Phong_NormalMapPS.cso");
-    const MeshID kSkyMeshID = 0x4a986f37; // cube
+    struct NamedVolume
+    {
+        const wchar_t* Name;
+        NoiseVolumeDesc Desc;
+    };
 
-    const VertexShader* pPhongVS = codex.GetVertexShader(kPhongVSID);
-    const PixelShader* pPhongPS = codex.GetPixelShader(kPhongPSID);
+    const NamedVolume volumes[] =
+    {
+        { L"CloudShapeNoise", GetCloudShapeNoiseDesc() },
+        { L"CloudDetailNoise", GetCloudDetailNoiseDesc() },
+    };
 
-    if (!pPhongVS || !pPhongPS)
+    for (const NamedVolume& named : volumes)
     {
-        Muon::Print("Error: Failed to fetch Phong VS/PS from codex!");
+        NoiseVolume volume;
+        NoiseVolumeStats stats;
+        if (!LoadOrGenerateNoiseVolume(named.Desc, volume, &stats))
+        {
+            Muon::Printf(L"Error: Failed to generate noise volume %s!\n", named.Name);
+            continue;
+        }
+
+        Texture& tex = codex.InsertTexture(fnv1a(named.Name));
+        if (!CreateVolumeTexture(pDevice, uploadBatch, volume, codex.GetSRVDescriptorHeap(), tex))
+        {
+            Muon::Printf(L"Error: Failed to create D3D12 Resource and SRV for noise volume %s!\n", named.Name);
+            continue;
+        }
+
+        if (stats.FromCache)
+            Muon::Printf(L"Info: Noise volume %s (%u^3) loaded from cache in %.3f ms\n", named.Name, volume.Size, stats.LoadMs);
+        else
+            Muon::Printf(L"Info: Noise volume %s (%u^3) generated in %.3f ms\n", named.Name, volume.Size, stats.GenerateMs);
+    }
+}
+
+bool TextureFactory::CreateVolumeTexture(ID3D12Device* pDevice, DirectX::ResourceUploadBatch& uploadBatch, const NoiseVolume& volume, DescriptorHeap& descHeap, Texture& outTexture)
+{
+    const UINT size = volume.Size;
+    const CD3DX12_RESOURCE_DESC desc = CD3DX12_RESOURCE_DESC::Tex3D(DXGI_FORMAT_R8G8B8A8_UNORM, size, size, static_cast<UINT16>(size), 1);
+    const CD3DX12_HEAP_PROPERTIES heapProps(D3D12_HEAP_TYPE_DEFAULT);
+
+    HRESULT hr = pDevice->CreateCommittedResource(&heapProps, D3D12_HEAP_FLAG_NONE, &desc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr,
+        IID_PPV_ARGS(outTexture.pResource.ReleaseAndGetAddressOf()));
+    if (FAILED(hr))
         return false;
+
+    D3D12_SUBRESOURCE_DATA data = {};
+    data.pData = volume.Voxels.data();
+    data.RowPitch = LONG_PTR(size) * 4;
+    data.SlicePitch = data.RowPitch * size;
+    uploadBatch.Upload(outTexture.pResource.Get(), 0, &data, 1);
+    uploadBatch.Transition(outTexture.pResource.Get(), D3D12_RESOURCE_STATE_COPY_DEST,
+        D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+
+    return CreateSRV(descHeap, pDevice, outTexture.pResource.Get(), outTexture);
+}
+
+void CloudVolumeFactory::LoadAllCloudVolumes(ResourceCodex& codex)
+{
+    MUON_PROFILE_SCOPE("Load Cloud Volumes");
+    namespace fs = std::filesystem;
+    using Clock = std::chrono::high_resolution_clock;
+
+    // 4MB of bricks per volume, the streamer keeps the nearest ones resident
+    static const uint32_t kPoolCapacity = 8192;
+
+    const std::string volumePath = VOLUMEPATH;
+    if (!fs::exists(volumePath))
+    {
+        Muon::Print("Info: No cloud volumes folder, skipping sparse volumes.\n");
+        return;
     }
 
-    // Test MaterialType
+    for (const auto& entry : fs::directory_iterator(volumePath))
     {
-        const wchar_t* kPhongMaterialName = L"Phong";
-        MaterialType* pPhongMaterial = codex.InsertMaterialType(kPhongMaterialName);
-        if (!pPhongMaterial)
-        {
-            Muon::Printf(L"Warning: %s MaterialType failed to be inserted into codex!", kPhongMaterialName);
-            return false;
-        }
+        const bool isNanoVDB = entry.path().extension() == L".nvdb";
+        if (entry.path().extension() != L".mnsv" && !isNanoVDB)
+            continue;
 
-        //pbr->SetRootSignature(Muon::GetRootSignature());
-        pPhongMaterial->SetVertexShader(pPhongVS);
-        pPhongMaterial->SetPixelShader(pPhongPS);
+        std::wstring path = entry.path().c_str();
+        const std::wstring name = entry.path().filename().c_str();
 
-        if (!pPhongMaterial->Generate())
+        // NanoVDB exports are converted once into the cache and streamed from there
+        if (isNanoVDB)
         {
-            Muon::Printf(L"Warning: %s MaterialType failed to Generate()!", pPhongMaterial->GetName().c_str());
-            return false;
+            const std::wstring cachePath = CACHEPATHW L"Volumes\\" + entry.path().stem().wstring() + L".mnsv";
+            NanoVDBImportStats stats;
+            if (!ImportNanoVDBCached(path.c_str(), NanoVDBImportDesc(), cachePath.c_str(), &stats))
+            {
+                Muon::Printf(L"Error: Failed to import cloud volume %s!\n", path.c_str());
+                continue;
+            }
+
+            if (stats.FromCache)
+                Muon::Printf(L"Info: Cloud volume %s is up to date in the cache, checked in %.3f ms\n", name.c_str(), stats.HashMs);
+            else
+                Muon::Printf(L"Info: Imported cloud volume %s: %u leaves and %u tiles, %.2f Mvoxels in %.3f ms (%.1f Mvoxels/s)\n", name.c_str(),
+                    stats.NumLeaves, stats.NumTiles, stats.NumVoxels / 1e6, stats.ImportMs, stats.VoxelsPerSecond / 1e6);
+            path = cachePath;
         }
 
-        cbMaterialParams phongMaterialParams;
-        phongMaterialParams.colorTint = DirectX::XMFLOAT4(1, 1, 1, 1);
-        phongMaterialParams.specularExp = 32.0f;
+        // Opened before it's inserted, so a volume that fails to open never shows up in the codex
+        const Clock::time_point start = Clock::now();
+        std::unique_ptr<SparseCloudVolume> pVolume = std::make_unique<SparseCloudVolume>();
+        if (!pVolume->Open(path.c_str(), kPoolCapacity))
+            continue;
+
+        const SparseCloudVolumeHeader& header = pVolume->GetHeader();
+        Muon::Printf(L"Info: Mapped cloud volume %s (%ux%ux%u bricks, %u occupied) in %.3f ms\n", name.c_str(),
+            header.GridSize[0], header.GridSize[1], header.GridSize[2], header.NumBricks,
+            std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+        codex.InsertCloudVolume(fnv1a(name.c_str()), std::move(pVolume));
+    }
+}
+
+bool MaterialFactory::CreateMaterial(ResourceCodex& codex, const MaterialDefinition& def)
+{
+    const std::wstring name(def.Name.begin(), def.Name.end());
 
-        pPhongMaterial->PopulateMaterialParams(codex.GetMatParamsStagingBuffer(), Muon::GetCommandList());
+    const ShaderID vsID = fnv1a(def.VertexShader.c_str());
+    const ShaderID psID = fnv1a(def.PixelShader.c_str());
 
-        pPhongMaterial->SetTextureParam("diffuseTexture",   kRockDiffuseId);
-        pPhongMaterial->SetTextureParam("normalMap",        kRockNormalId);
+    VariantKey vsKey = 0;
+    VariantKey psKey = 0;
+    if (!codex.GetShaderVariantKey(vsID, def.VertexDefines, vsKey) || !codex.GetShaderVariantKey(psID, def.PixelDefines, psKey))
+    {
+        Muon::Printf(L"Error: %s MaterialType uses permutation defines its shaders don't declare!\n", name.c_str());
+        return false;
     }
 
+    // Variants other than the default are compiled (or pulled from the variant cache) here if nothing has requested them yet
+    const VertexShader* pVS = codex.GetVertexShaderVariant(vsID, vsKey);
+    const PixelShader* pPS = codex.GetPixelShaderVariant(psID, psKey);
+    if (!pVS || !pPS)
+    {
+        Muon::Printf(L"Error: Failed to fetch VS/PS for %s MaterialType from codex!\n", name.c_str());
+        return false;
+    }
+
+    MaterialType* pMaterial = codex.InsertMaterialType(name.c_str());
+    if (!pMaterial)
+    {
+        Muon::Printf(L"Warning: %s MaterialType failed to be inserted into codex!\n", name.c_str());
+        return false;
+    }
+
+    pMaterial->SetVertexShader(pVS);
+    pMaterial->SetPixelShader(pPS);
+    pMaterial->SetDepthMode(def.Depth);
+
+    if (!pMaterial->Generate())
+    {
+        Muon::Printf(L"Warning: %s MaterialType failed to Generate()!\n", pMaterial->GetName().c_str());
+        return false;
+    }
+
+    for (const MaterialParamDefinition& param : def.Params)
+    {
+        if (!pMaterial->SetParamValue(MakeNameID(param.Name.c_str()), param.Type, param.Value))
+            Muon::Printf("Warning: %s has no per-material param named '%s' of the given type.\n", def.Name.c_str(), param.Name.c_str());
+    }
+
+    pMaterial->PopulateMaterialParams(codex.GetMatParamsStagingBuffer(), Muon::GetCommandList());
+
+    for (const MaterialTextureDefinition& texture : def.Textures)
+    {
+        if (!pMaterial->SetTextureParam(MakeNameID(texture.ParamName.c_str()), fnv1a(texture.FileName.c_str())))
+            Muon::Printf("Warning: %s has no texture param named '%s'.\n", def.Name.c_str(), texture.ParamName.c_str());
+    }
 
     return true;
 }
 
+bool MaterialFactory::CreateAllMaterials(ResourceCodex& codex, const CodexManifest& manifest)
+{
+    MUON_PROFILE_SCOPE("Create Materials");
+
+    // Kick off every variant the materials need up front so they compile in parallel, CreateMaterial then waits on each
+    for (const MaterialDefinition& def : manifest.Materials)
+    {
+        const ShaderID vsID = fnv1a(def.VertexShader.c_str());
+        const ShaderID psID = fnv1a(def.PixelShader.c_str());
+
+        VariantKey key = 0;
+        if (codex.GetShaderVariantKey(vsID, def.VertexDefines, key) && key != 0)
+            codex.RequestShaderVariant(vsID, key);
+        if (codex.GetShaderVariantKey(psID, def.PixelDefines, key) && key != 0)
+            codex.RequestShaderVariant(psID, key);
+    }
+
+    UploadBuffer& stagingBuffer = codex.GetMatParamsStagingBuffer();
+    stagingBuffer.Map();
+
+    size_t numCreated = 0;
+    for (const MaterialDefinition& def : manifest.Materials)
+    {
+        if (CreateMaterial(codex, def))
+            numCreated++;
+    }
+
+    stagingBuffer.Unmap(0, stagingBuffer.GetBufferSize());
+
+    Muon::Printf("Info: Loaded %zu/%zu materials.\n", numCreated, manifest.Materials.size());
+    Muon::Printf("Info: Created %zu material types sharing %zu root signatures.\n", codex.mMaterialTypeMap.size(), codex.GetNumRootSignatures());
+
+    return numCreated == manifest.Materials.size();
+}
+
 }
\ No newline at end of file
@@ -11,19 +11,38 @@
 namespace Muon
 {
 
+struct CodexManifest;
+
 struct ShaderFactory final
 {
     friend class ResourceCodex;
 
-    // Main initialization function: Takes a codex, which then calls the static functions from ShaderFactory to populate its own hashtables
-    static void LoadAllShaders(ResourceCodex& codex);
+    // Loads and reflects every compiled shader the manifest declares, each as the stage it's declared as
+    static void LoadAllShaders(ResourceCodex& codex, const CodexManifest& manifest);
+
+    // Registers the HLSL sources under Assets/Shaders so their permutation variants can be compiled on demand
+    static void LoadAllShaderSources(ResourceCodex& codex);
 };
 
+struct NoiseVolume;
+
 struct TextureFactory final
 {
     //typedef std::pair<TextureID, const ResourceBindChord> TexturePair;
-    static void LoadAllTextures(ID3D12Device* pDevice, ID3D12CommandList* pCommandList, ResourceCodex& codex);
+    // Loads every texture the manifest declares from Assets/Textures, keyed by file name
+    static void LoadAllTextures(ID3D12Device* pDevice, ID3D12CommandList* pCommandList, ResourceCodex& codex, const CodexManifest& manifest);
     static bool CreateSRV(DescriptorHeap& descHeap, ID3D12Device* pDevice, ID3D12Resource* pResource, Texture& outTexture);
+
+    // Cloud noise volumes are generated on the CPU, or read back from the cache, and inserted as 3D textures by name
+    static void LoadNoiseVolumes(ID3D12Device* pDevice, DirectX::ResourceUploadBatch& uploadBatch, ResourceCodex& codex);
+    static bool CreateVolumeTexture(ID3D12Device* pDevice, DirectX::ResourceUploadBatch& uploadBatch, const NoiseVolume& volume, DescriptorHeap& descHeap, Texture& outTexture);
+};
+
+struct CloudVolumeFactory final
+{
+    // Maps every .mnsv file under Assets/Volumes, keyed by file name like textures. NanoVDB (.nvdb) files are converted
+    // into the cache first, and only converted again when the file changes.
+    static void LoadAllCloudVolumes(ResourceCodex& codex);
 };
 
 struct MeshFactory final
@@ -32,9 +51,13 @@ struct MeshFactory final
     static void LoadAllMeshes(ResourceCodex& codex);
 };
 
+struct MaterialDefinition;
+
 struct MaterialFactory final
 {
-    static bool CreateAllMaterials(ResourceCodex& codex);
+    // Builds every MaterialType described by the asset manifest (Assets/materials.xml)
+    static bool CreateAllMaterials(ResourceCodex& codex, const CodexManifest& manifest);
+    static bool CreateMaterial(ResourceCodex& codex, const MaterialDefinition& def);
 };
 
 }
@@ -10,13 +10,30 @@ Description : Implementation of Game.h
 
 #include <Core/Camera.h>
 #include <Core/COMException.h>
+#include <Core/CommandRecorder.h>
 #include <Core/Factories.h>
+#include <Core/JobSystem.h>
 #include <Core/PipelineState.h>
+#include <Core/Profiler.h>
 #include <Core/ResourceCodex.h>
 #include <Core/Shader.h>
 #include <Core/hash_util.h>
 #include <Utils/Utils.h>
 
+#include <algorithm>
+
+// Below this many draws per chunk, the cost of another command list outweighs recording in parallel
+static const size_t kMinDrawsPerChunk = 128;
+
+// Test scene
+static const uint32_t kCubeGridSize = 100;
+static const float kCubeSpacing = 2.0f;
+
+// Small enough to rasterize in well under a millisecond, the aspect ratio doesn't need to match the screen
+static const uint32_t kOcclusionWidth = 256;
+static const uint32_t kOcclusionHeight = 128;
+static const uint32_t kMaxOccluders = 64;
+
 Game::Game() :
     mInput(),
     mCamera()
@@ -31,6 +48,11 @@ bool Game::Init(HWND window, int width, int height)
     bool success = Muon::InitDX12(window, width, height);
     
     Muon::ResetCommandList(nullptr);
+
+    // Before the job system, so its workers are named in traces
+    Profiler::Init();
+    Profiler::SetThreadName("Main");
+    JobSystem::Init();
     ResourceCodex::Init();
 
     ResourceCodex& codex = ResourceCodex::GetSingleton();
@@ -134,23 +156,82 @@ bool Game::Init(HWND window, int width, int height)
     mCube.Init(cubeVertices, sizeof(cubeVertices), sizeof(PhongVertex), cubeIndices, sizeof(cubeIndices), sizeof(cubeIndices) / sizeof(uint32_t), DXGI_FORMAT_R32_UINT);
     stagingBuffer.Unmap(0, stagingBuffer.GetBufferSize());
 
-    mWorldMatrixBuffer.Create(L"world matrix buffer", sizeof(cbPerEntity));
-    void* mapped = mWorldMatrixBuffer.Map();
-    cbPerEntity entity;
-    DirectX::XMStoreFloat4x4(&entity.world, DirectX::XMMatrixIdentity());
-    memcpy(mapped, &entity, sizeof(entity));
-    mWorldMatrixBuffer.Unmap(0, mWorldMatrixBuffer.GetBufferSize());
+    success &= InitOccluderMesh(mCubeOccluder, cubeVertices, sizeof(cubeVertices) / sizeof(PhongVertex), sizeof(PhongVertex), 0, cubeIndices, sizeof(cubeIndices) / sizeof(uint32_t));
+    success &= mOcclusionCuller.Init(kOcclusionWidth, kOcclusionHeight);
+
+    // A grid of cubes. With the instanced Phong variant they batch into a single draw, otherwise each is its own.
+    const MaterialType* pCubeMaterial = codex.GetMaterialType(fnv1a("Phong_Instanced"));
+    if (!pCubeMaterial)
+        pCubeMaterial = codex.GetMaterialType(fnv1a("Phong"));
+
+    if (pCubeMaterial)
+    {
+        const float halfExtent = 0.5f * (kCubeGridSize - 1) * kCubeSpacing;
+        mGridRoot = mSceneTransforms.Create();
+        mSceneTransforms.SetLocalPosition(mGridRoot, -halfExtent, 0.0f, -halfExtent);
+
+        mEntities.reserve(kCubeGridSize * kCubeGridSize);
+        for (uint32_t x = 0; x != kCubeGridSize; ++x)
+        {
+            for (uint32_t z = 0; z != kCubeGridSize; ++z)
+            {
+                SceneEntity entity;
+                entity.pMaterial = pCubeMaterial;
+                entity.pMesh = &mCube;
+                entity.pOccluder = &mCubeOccluder;
+                entity.Transform = mSceneTransforms.Create(mGridRoot);
+                mSceneTransforms.SetLocalPosition(entity.Transform, x * kCubeSpacing, 0.0f, z * kCubeSpacing);
+                mEntities.push_back(entity);
+            }
+        }
+    }
 
-    mLightBuffer.Create(L"Light Buffer", sizeof(cbLights));
+    mSceneTransforms.Update();
+
+    // Transforming a box's half extents by the absolute rotation/scale gives the extents of its world space bounding box
+    mEntityBounds.Resize(mEntities.size());
+    for (size_t i = 0; i != mEntities.size(); ++i)
+    {
+        const SceneEntity& entity = mEntities[i];
+        const DirectX::XMMATRIX world = DirectX::XMLoadFloat4x4(&mSceneTransforms.GetWorld(entity.Transform));
+        const DirectX::XMMATRIX absWorld(DirectX::XMVectorAbs(world.r[0]), DirectX::XMVectorAbs(world.r[1]), DirectX::XMVectorAbs(world.r[2]), DirectX::g_XMZero);
+
+        DirectX::XMFLOAT3 center, extents;
+        DirectX::XMStoreFloat3(&center, DirectX::XMVector3TransformCoord(DirectX::XMLoadFloat3(&entity.pMesh->BoundsCenter), world));
+        DirectX::XMStoreFloat3(&extents, DirectX::XMVector3TransformNormal(DirectX::XMLoadFloat3(&entity.pMesh->BoundsExtents), absWorld));
+        mEntityBounds.Set(i, &center.x, &extents.x);
+    }
+
+    // One command list per thread at most, the draw list is split between them each frame
+    const uint32_t numRecordingChunks = std::min(JobSystem::GetSingleton().GetNumThreads(), Muon::RECORDER_MAX_CHUNKS);
+    success &= mDepthRecorder.Init(L"Depth Prepass Command List", numRecordingChunks, RecorderTargets::DepthOnly);
+    mDepthRecorder.SetRecordFunc([this](ID3D12GraphicsCommandList* pCommandList, size_t begin, size_t end)
+    {
+        RecordDepthDraws(pCommandList, begin, end);
+    });
+
+    success &= mSceneRecorder.Init(L"Scene Command List", numRecordingChunks);
+    mSceneRecorder.SetRecordFunc([this](ID3D12GraphicsCommandList* pCommandList, size_t begin, size_t end)
+    {
+        RecordDraws(pCommandList, mOpaqueBegin + begin, mOpaqueBegin + end);
+    });
+
+    success &= mGraphExecutor.Init();
 
     Muon::CloseCommandList();
     Muon::ExecuteCommandList();
+
+    // Frames reuse the init allocator, so everything recorded here has to finish before the first BeginFrame
+    Muon::FlushCommandQueue();
     return success;
 }
 
 // On Timer tick, run Update() on the game, then Render()
 void Game::Frame()
 {
+    Muon::Profiler& profiler = Muon::Profiler::GetSingleton();
+    profiler.BeginFrame();
+
     mTimer.Tick([&]()
     {
         Update(mTimer);
@@ -159,30 +240,41 @@ void Game::Frame()
     Render();
 
     Muon::UpdateTitleBar(mTimer.GetFramesPerSecond(), mTimer.GetFrameCount());
+
+    profiler.EndFrame();
 }
 
 void Game::Update(Muon::StepTimer const& timer)
 {
+    MUON_PROFILE_SCOPE("Update");
     float elapsedTime = float(timer.GetElapsedSeconds());
     mInput.Frame(elapsedTime, &mCamera);
     mCamera.UpdateView();
 
-    Muon::cbLights lights;
+    // Only nodes that changed since the last frame are recomputed
+    mSceneTransforms.Update();
+
+    // Pick up any shader variants that finished compiling in the background
+    Muon::ResourceCodex::GetSingleton().RetireShaderVariants();
+
+    // Cloud bricks around the new camera position start streaming in
+    DirectX::XMFLOAT3 cameraPos;
+    DirectX::XMStoreFloat3(&cameraPos, mCamera.GetPosition());
+    Muon::ResourceCodex::GetSingleton().UpdateCloudVolumeStreaming(&cameraPos.x);
+
+    Muon::cbLights& lights = mLights;
 
     lights.ambientColor = DirectX::XMFLOAT3A(+1.0f, +0.772f, +0.56f);
 
     lights.directionalLight.diffuseColor = DirectX::XMFLOAT3A(1, 1, 1);
-    lights.directionalLight.dir = DirectX::XMFLOAT3A(cos(elapsedTime), 0.0, sin(elapsedTime));
+    lights.directionalLight.toLight = DirectX::XMFLOAT3A(cos(elapsedTime), 0.0, sin(elapsedTime));
 
     DirectX::XMStoreFloat3(&lights.cameraWorldPos, mCamera.GetPosition());
-
-    void* mapped = mLightBuffer.Map();
-    memcpy(mapped, &lights, sizeof(Muon::cbLights));
-    mLightBuffer.Unmap(0, mLightBuffer.GetBufferSize());
 }
 
 void Game::Render()
 {
+    MUON_PROFILE_SCOPE("Render");
     using namespace Muon;
 
     // Don't try to render anything before the first Update.
@@ -191,54 +283,231 @@ void Game::Render()
         return;
     }
 
-    ResetCommandList(nullptr);
-    PrepareForRender();
+    BeginFrame(nullptr);
 
-    // Fetch the desired material from the codex
-    ResourceCodex& codex = ResourceCodex::GetSingleton();
-    MaterialTypeID matId = fnv1a("Phong");
-    const Muon::MaterialType* pPhongMaterial = codex.GetMaterialType(matId);
-    if (pPhongMaterial)
+    // Constants shared by every draw are uploaded once here, the recording workers only read the addresses
+    AllocateFrameConstants(&mCamera.GetConstants(), sizeof(cbCamera), mFrameCameraAddr);
+    AllocateFrameConstants(&mLights, sizeof(mLights), mFrameLightsAddr);
+
+    // Only entities whose bounds touch the view frustum go on to be batched
+    CullStats cullStats;
+    CullBoxes(mCamera.GetFrustum(), mEntityBounds, mFrustumVisibleEntities, &cullStats);
+
+    // Then the ones hidden behind the nearest few, as far as a low resolution software depth buffer can tell
+    const DirectX::XMMATRIX view = mCamera.GetView();
+    mOccluderCandidates.clear();
+    for (uint32_t entityIndex : mFrustumVisibleEntities)
+    {
+        const SceneEntity& entity = mEntities[entityIndex];
+        if (!entity.pOccluder)
+            continue;
+
+        const DirectX::XMVECTOR worldPos = DirectX::XMLoadFloat4x4(&mSceneTransforms.GetWorld(entity.Transform)).r[3];
+        mOccluderCandidates.emplace_back(DirectX::XMVectorGetZ(DirectX::XMVector3TransformCoord(worldPos, view)), entityIndex);
+    }
+
+    const size_t numOccluders = std::min<size_t>(kMaxOccluders, mOccluderCandidates.size());
+    std::partial_sort(mOccluderCandidates.begin(), mOccluderCandidates.begin() + numOccluders, mOccluderCandidates.end());
+
+    mOcclusionCuller.BeginFrame(&mCamera.GetConstants().viewProj.m[0][0]);
+    for (size_t i = 0; i != numOccluders; ++i)
+    {
+        const SceneEntity& entity = mEntities[mOccluderCandidates[i].second];
+        mOcclusionCuller.AddOccluder(entity.pOccluder, &mSceneTransforms.GetWorld(entity.Transform).m[0][0]);
+    }
+    mOcclusionCuller.RenderOccluders();
+    mOcclusionCuller.CullBoxes(mEntityBounds, mFrustumVisibleEntities, mVisibleEntities);
+
+    // Group entities sharing a mesh and material into instanced draws, keyed by the view space depth of their origins
+    {
+        MUON_PROFILE_SCOPE("Batch Draws");
+        mInstanceBatcher.Reset();
+        for (uint32_t entityIndex : mVisibleEntities)
+        {
+            const SceneEntity& entity = mEntities[entityIndex];
+            const DirectX::XMFLOAT4X4& world = mSceneTransforms.GetWorld(entity.Transform);
+            const float depth = DirectX::XMVectorGetZ(DirectX::XMVector3TransformCoord(DirectX::XMLoadFloat4x4(&world).r[3], view));
+            mInstanceBatcher.Add(entity.pMaterial, entity.pMesh, &world, depth);
+        }
+        mInstanceBatcher.Build();
+    }
+
+    const InstanceBatchStats& batchStats = mInstanceBatcher.GetStats();
+    if (batchStats.NumBatches != mLastNumDraws)
+    {
+        const OcclusionStats& occlusionStats = mOcclusionCuller.GetStats();
+        Muon::Printf("Info: Scene: %u of %u entities in the frustum (culled in %.3f ms), %u of those occluded by %u occluders "
+            "(%.3f ms raster, %.3f ms tests), %u draw calls (batched in %.3f ms)\n",
+            cullStats.NumVisible, cullStats.NumTested, cullStats.CullMs, occlusionStats.NumOccluded, occlusionStats.NumOccluders, occlusionStats.RasterMs, occlusionStats.TestMs,
+            batchStats.NumBatches, batchStats.BuildMs);
+        mLastNumDraws = batchStats.NumBatches;
+    }
+
+    // Both passes go front to back. The pre-pass lays down the nearest depth first, so the main pass only shades visible pixels.
+    const std::vector<InstanceBatch>& batches = mInstanceBatcher.GetBatches();
+    mRenderQueue.Reset();
+    for (uint32_t i = 0; i != batches.size(); ++i)
+    {
+        const InstanceBatch& batch = batches[i];
+        if (batch.pMaterial->GetDepthMode() == DepthMode::Prepass)
+            mRenderQueue.Push(RENDERPASS_DEPTH_PREPASS, batch.pMaterial->GetDepthPipelineState(), batch.pMaterial, batch.MinDepth, i);
+
+        mRenderQueue.Push(RENDERPASS_OPAQUE, batch.pMaterial->GetPipelineState(), batch.pMaterial, batch.MinDepth, i);
+    }
+    mRenderQueue.Sort();
+    mOpaqueBegin = mRenderQueue.GetPassBegin(RENDERPASS_OPAQUE);
+
+    // The back buffer arrives and leaves in the present state, the graph derives the transitions around the scene pass
+    mRenderGraph.Reset();
+
+    RGTextureDesc backBufferDesc;
+    backBufferDesc.Width = GetBackBufferWidth();
+    backBufferDesc.Height = GetBackBufferHeight();
+    backBufferDesc.Format = GetBackBufferFormat();
+    const RGResourceHandle backBuffer = mRenderGraph.ImportTexture("Back Buffer", backBufferDesc, RG_ACCESS_PRESENT, RG_ACCESS_PRESENT);
+    mGraphExecutor.SetImportedTexture(backBuffer, GetCurrentBackBuffer(), CurrentBackBufferView());
+
+    // Stays in the depth write state between frames, whichever pass runs first clears it
+    RGTextureDesc depthDesc;
+    depthDesc.Width = GetBackBufferWidth();
+    depthDesc.Height = GetBackBufferHeight();
+    depthDesc.Format = GetDepthStencilFormat();
+    const RGResourceHandle depthBuffer = mRenderGraph.ImportTexture("Depth Buffer", depthDesc, RG_ACCESS_DEPTH_WRITE, RG_ACCESS_DEPTH_WRITE);
+    mGraphExecutor.SetImportedTexture(depthBuffer, GetDepthStencilBuffer(), {}, DepthStencilView());
+
+    const bool hasPrepass = mOpaqueBegin != 0;
+    if (hasPrepass)
+    {
+        const RGPassHandle prepass = mRenderGraph.AddPass("Depth Prepass", [this, depthBuffer](const RGPassContext& context, ID3D12GraphicsCommandList* pCommandList)
+        {
+            const D3D12_CPU_DESCRIPTOR_HANDLE dsvHandle = { static_cast<SIZE_T>(context.GetDSV(depthBuffer)) };
+            pCommandList->ClearDepthStencilView(dsvHandle, D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, nullptr);
+
+            RecordInParallel(mDepthRecorder, mOpaqueBegin, kMinDrawsPerChunk);
+        });
+        mRenderGraph.Write(prepass, depthBuffer, RG_ACCESS_DEPTH_WRITE);
+    }
+
+    const RGPassHandle scenePass = mRenderGraph.AddPass("Scene", [this, backBuffer, depthBuffer, hasPrepass](const RGPassContext& context, ID3D12GraphicsCommandList* pCommandList)
+    {
+        const D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle = { static_cast<SIZE_T>(context.GetRTV(backBuffer)) };
+        const float clearColor[] = { 0.0f, 0.2f, 0.4f, 1.0f };
+        pCommandList->ClearRenderTargetView(rtvHandle, clearColor, 0, nullptr);
+
+        if (!hasPrepass)
+        {
+            const D3D12_CPU_DESCRIPTOR_HANDLE dsvHandle = { static_cast<SIZE_T>(context.GetDSV(depthBuffer)) };
+            pCommandList->ClearDepthStencilView(dsvHandle, D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, nullptr);
+        }
+
+        RecordInParallel(mSceneRecorder, mRenderQueue.GetCount() - mOpaqueBegin, kMinDrawsPerChunk);
+    });
+    mRenderGraph.Write(scenePass, backBuffer, RG_ACCESS_RENDER_TARGET);
+    mRenderGraph.Write(scenePass, depthBuffer, RG_ACCESS_DEPTH_WRITE);
+
+    mGraphExecutor.Execute(mRenderGraph, GetCommandList());
+    EndFrame();
+}
+
+// Runs on the job system, once per chunk of the sorted render queue, each into its own command list
+void Game::RecordDraws(ID3D12GraphicsCommandList* pCommandList, size_t begin, size_t end) const
+{
+    MUON_PROFILE_SCOPE("Record Draws");
+    using namespace Muon;
+
+    // The queue is sorted to group shared state, so only what differs from the previous packet is bound.
+    // Root signatures are shared across material types, so the bound one is tracked separately.
+    const MaterialType* pBoundMaterial = nullptr;
+    const ID3D12RootSignature* pBoundRootSig = nullptr;
+    const ID3D12PipelineState* pBoundPipeline = nullptr;
+    const Mesh* pBoundMesh = nullptr;
+
+    const std::vector<InstanceBatch>& batches = mInstanceBatcher.GetBatches();
+    for (size_t i = begin; i != end; ++i)
     {
-        // Bind the material's PipelineState and RootSignature (Defined by Shaders)
-        pPhongMaterial->Bind(GetCommandList());
-        
-        // Bind the Camera's Upload Buffer to the root index known by the material
-        int32_t cameraRootIdx = pPhongMaterial->GetResourceRootIndex("VSCamera");
-        if (cameraRootIdx != ROOTIDX_INVALID)
+        const InstanceBatch& batch = batches[mRenderQueue.GetSortedIndex(i)];
+        if (batch.pMaterial != pBoundMaterial)
         {
-            mCamera.Bind(cameraRootIdx, GetCommandList());
+            // Bind the material's PipelineState and RootSignature (Defined by Shaders)
+            batch.pMaterial->Bind(pCommandList, pBoundRootSig, pBoundPipeline);
+            pBoundRootSig = batch.pMaterial->GetRootSignature();
+            pBoundPipeline = batch.pMaterial->GetPipelineState();
+            pBoundMaterial = batch.pMaterial;
+
+            // Bind the camera to the root index known by the material
+            const int32_t cameraRootIdx = batch.pMaterial->GetResourceRootIndex(kVSCameraID);
+            if (cameraRootIdx != ROOTIDX_INVALID)
+                pCommandList->SetGraphicsRootConstantBufferView((UINT)cameraRootIdx, mFrameCameraAddr);
+
+            // Bind the lights to the root index known by the material.
+            // Small enough to usually be promoted to root constants, in which case the CPU copy is used directly.
+            batch.pMaterial->BindConstantBuffer(pCommandList, kPSLightsID, &mLights, sizeof(mLights), mFrameLightsAddr);
         }
 
-        // Bind the world matrix Upload Buffer to the root index known by the material
-        int32_t worldMatrixRootIdx = pPhongMaterial->GetResourceRootIndex("VSWorld");
-        if (worldMatrixRootIdx != ROOTIDX_INVALID)
+        // Bind VBO/IBO and Draw
+        if (batch.pMesh != pBoundMesh)
         {
-            GetCommandList()->SetGraphicsRootConstantBufferView(worldMatrixRootIdx, mWorldMatrixBuffer.GetGPUVirtualAddress());
+            batch.pMesh->Bind(pCommandList);
+            pBoundMesh = batch.pMesh;
         }
 
-        int32_t lightsRootIdx = pPhongMaterial->GetResourceRootIndex("PSLights");
-        if (lightsRootIdx != ROOTIDX_INVALID)
+        if (batch.IsInstanced())
+        {
+            pCommandList->IASetVertexBuffers(1, 1, &batch.InstanceView);
+        }
+        else
         {
-            GetCommandList()->SetGraphicsRootConstantBufferView(lightsRootIdx, mLightBuffer.GetGPUVirtualAddress());
+            batch.pMaterial->BindConstantBuffer(pCommandList, kVSWorldID, batch.pWorld, sizeof(cbPerEntity), batch.WorldAddr);
         }
+
+        batch.pMesh->DrawIndexed(pCommandList, batch.NumInstances);
     }
+}
+
+// Same walk as RecordDraws over the pre-pass packets, binding only what the vertex shader reads
+void Game::RecordDepthDraws(ID3D12GraphicsCommandList* pCommandList, size_t begin, size_t end) const
+{
+    MUON_PROFILE_SCOPE("Record Depth Draws");
+    using namespace Muon;
+
+    const MaterialType* pBoundMaterial = nullptr;
+    const ID3D12RootSignature* pBoundRootSig = nullptr;
+    const ID3D12PipelineState* pBoundPipeline = nullptr;
+    const Mesh* pBoundMesh = nullptr;
 
-    // Fetch the desired mesh from the codex
-    const MeshID cubeID = fnv1a("cube.obj");
-    const Mesh* cubeMesh = codex.GetMesh(cubeID);
-    if (cubeMesh)
+    const std::vector<InstanceBatch>& batches = mInstanceBatcher.GetBatches();
+    for (size_t i = begin; i != end; ++i)
     {
-        // Bind VBO/IBO and Draw
-        mCube.Draw(Muon::GetCommandList());
-    }
+        const InstanceBatch& batch = batches[mRenderQueue.GetSortedIndex(i)];
+        if (batch.pMaterial != pBoundMaterial)
+        {
+            batch.pMaterial->BindDepthOnly(pCommandList, pBoundRootSig, pBoundPipeline);
+            pBoundRootSig = batch.pMaterial->GetRootSignature();
+            pBoundPipeline = batch.pMaterial->GetDepthPipelineState();
+            pBoundMaterial = batch.pMaterial;
+
+            const int32_t cameraRootIdx = batch.pMaterial->GetResourceRootIndex(kVSCameraID);
+            if (cameraRootIdx != ROOTIDX_INVALID)
+                pCommandList->SetGraphicsRootConstantBufferView((UINT)cameraRootIdx, mFrameCameraAddr);
+        }
+
+        if (batch.pMesh != pBoundMesh)
+        {
+            batch.pMesh->Bind(pCommandList);
+            pBoundMesh = batch.pMesh;
+        }
 
-    FinalizeRender();
-    CloseCommandList();
-    ExecuteCommandList();
-    Present();
-    FlushCommandQueue();
-    UpdateBackBufferIndex();
+        if (batch.IsInstanced())
+        {
+            pCommandList->IASetVertexBuffers(1, 1, &batch.InstanceView);
+        }
+        else
+        {
+            batch.pMaterial->BindConstantBuffer(pCommandList, kVSWorldID, batch.pWorld, sizeof(cbPerEntity), batch.WorldAddr);
+        }
+
+        batch.pMesh->DrawIndexed(pCommandList, batch.NumInstances);
+    }
 }
 
 void Game::CreateDeviceDependentResources()
@@ -253,14 +522,21 @@ void Game::CreateWindowSizeDependentResources(int newWidth, int newHeight)
 
 Game::~Game()
 { 
+    // Up to MN_FRAMES_IN_FLIGHT frames may still reference these
+    Muon::FlushCommandQueue();
+
+    mOcclusionCuller.Destroy();
+    mGraphExecutor.Destroy();
+    mSceneRecorder.Destroy();
+    mDepthRecorder.Destroy();
     mTriangle.Release();
     mCube.Release();
-    mWorldMatrixBuffer.Destroy();
-    mLightBuffer.Destroy();
     mCamera.Destroy();
     mInput.Destroy();
 
     Muon::ResourceCodex::Destroy();
+    Muon::JobSystem::Destroy();
+    Muon::Profiler::Destroy();
     Muon::DestroyDX12();
 }
 
@@ -8,12 +8,27 @@ This class encapsulates all app functionality
 #define GAME_H
 
 #include <Core/Camera.h>
+#include <Core/Culling.h>
+#include <Core/D3D12CommandRecorder.h>
+#include <Core/InstanceBatcher.h>
 #include <Core/Mesh.h>
+#include <Core/OcclusionCuller.h>
 #include <Core/PipelineState.h>
+#include <Core/RenderGraphExecutor.h>
+#include <Core/RenderQueue.h>
 #include <Core/StepTimer.h>
+#include <Core/TransformHierarchy.h>
 
 #include <Input/GameInput.h>
 
+#include <utility>
+#include <vector>
+
+namespace Muon
+{
+    class MaterialType;
+}
+
 class Game
 {
 public:
@@ -39,6 +54,8 @@ public:
 private:
     void Update(Muon::StepTimer const& timer);
     void Render();
+    void RecordDraws(ID3D12GraphicsCommandList* pCommandList, size_t begin, size_t end) const;
+    void RecordDepthDraws(ID3D12GraphicsCommandList* pCommandList, size_t begin, size_t end) const;
 
     void CreateDeviceDependentResources();
     void CreateWindowSizeDependentResources(int newWidth, int newHeight);
@@ -53,8 +70,50 @@ private:
     Muon::Mesh mTriangle;
     Muon::Mesh mCube;
 
-    Muon::UploadBuffer mWorldMatrixBuffer;
-    Muon::UploadBuffer mLightBuffer;
+    // CPU copy bound as root constants when the material promotes it, otherwise uploaded per frame
+    Muon::cbLights mLights;
+
+    struct SceneEntity
+    {
+        const Muon::MaterialType* pMaterial = nullptr;
+        const Muon::Mesh* pMesh = nullptr;
+        const Muon::OccluderMesh* pOccluder = nullptr; // Entities without one never hide others
+        uint32_t Transform = Muon::TRANSFORM_INVALID; // Node in mSceneTransforms
+    };
+
+    std::vector<SceneEntity> mEntities;
+
+    // Entity world matrices, brought up to date in Update. The grid's cubes all hang off one root node.
+    Muon::TransformHierarchy mSceneTransforms;
+    uint32_t mGridRoot = Muon::TRANSFORM_INVALID;
+
+    // World space boxes parallel to mEntities. The entities don't move, so these are filled once at Init.
+    Muon::BoundingBoxesSoA mEntityBounds;
+    std::vector<uint32_t> mFrustumVisibleEntities;
+    std::vector<uint32_t> mVisibleEntities;
+
+    // The nearest frustum visible entities are rasterized as occluders, everything else is tested against them
+    Muon::OccluderMesh mCubeOccluder;
+    Muon::OcclusionCuller mOcclusionCuller;
+    std::vector<std::pair<float, uint32_t>> mOccluderCandidates;
+
+    // Rebuilt every frame. Batches are ordered by the queue's sort keys and recorded in parallel chunks.
+    // Batches whose material uses a depth pre-pass are queued twice, once per pass.
+    Muon::InstanceBatcher mInstanceBatcher;
+    Muon::RenderQueue mRenderQueue;
+    Muon::D3D12CommandRecorder mDepthRecorder;
+    Muon::D3D12CommandRecorder mSceneRecorder;
+    size_t mOpaqueBegin = 0; // Sorted queue index of the first main pass packet, the pre-pass packets come before it
+
+    // Redeclared every frame, the executor keeps its transient textures alive between them
+    Muon::RenderGraph mRenderGraph;
+    Muon::RenderGraphExecutor mGraphExecutor;
+
+    // This frame's copies of the shared constants, in the frame's upload buffer
+    D3D12_GPU_VIRTUAL_ADDRESS mFrameCameraAddr = 0;
+    D3D12_GPU_VIRTUAL_ADDRESS mFrameLightsAddr = 0;
+
+    uint32_t mLastNumDraws = 0; // Batch stats are printed when this changes
 
     // Timer for the main game loop
     Muon::StepTimer mTimer;
@@ -0,0 +1,254 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Dependency-free PNG and OpenEXR writers for CPU-side captures
+----------------------------------------------*/
+#include <Core/ImageWriter.h>
+
+#include <Core/BinaryStream.h>
+#include <Utils/Utils.h>
+
+#include <algorithm>
+#include <string.h>
+
+namespace Muon
+{
+
+namespace
+{
+    static const uint32_t kMaxImageDimension = 16384;
+
+    // Largest payload a stored deflate block can hold
+    static const size_t kMaxStoredBlock = 65535;
+
+    // Most bytes Adler-32 can sum before the 32-bit sums have to be reduced (zlib's NMAX)
+    static const size_t kAdlerRun = 5552;
+
+    bool ValidateImage(const wchar_t* path, uint32_t width, uint32_t height, const void* pPixels)
+    {
+        if (!path || !pPixels || width == 0 || height == 0 || width > kMaxImageDimension || height > kMaxImageDimension)
+        {
+            Muon::Printf("Error: Can't write a %ux%u image, dimensions must be between 1 and %u!\n", width, height, kMaxImageDimension);
+            return false;
+        }
+        return true;
+    }
+
+    // PNG is big endian throughout, BinaryWriter is not
+    void WriteBE32(BinaryWriter& writer, uint32_t value)
+    {
+        const uint8_t bytes[4] = { uint8_t(value >> 24), uint8_t(value >> 16), uint8_t(value >> 8), uint8_t(value) };
+        writer.WriteBytes(bytes, 4);
+    }
+
+    struct CRC32Table
+    {
+        uint32_t Entries[256];
+
+        CRC32Table()
+        {
+            for (uint32_t i = 0; i != 256; ++i)
+            {
+                uint32_t c = i;
+                for (uint32_t k = 0; k != 8; ++k)
+                    c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                Entries[i] = c;
+            }
+        }
+    };
+
+    uint32_t UpdateCRC32(uint32_t crc, const uint8_t* pData, size_t size)
+    {
+        static const CRC32Table kTable;
+        for (size_t i = 0; i != size; ++i)
+            crc = kTable.Entries[(crc ^ pData[i]) & 0xFF] ^ (crc >> 8);
+        return crc;
+    }
+
+    // Chunks are length, type, data, then a CRC over the type and data
+    void WritePNGChunk(BinaryWriter& writer, const char type[4], const uint8_t* pData, size_t size)
+    {
+        WriteBE32(writer, static_cast<uint32_t>(size));
+        writer.WriteBytes(type, 4);
+        writer.WriteBytes(pData, size);
+
+        uint32_t crc = UpdateCRC32(0xFFFFFFFFu, reinterpret_cast<const uint8_t*>(type), 4);
+        crc = UpdateCRC32(crc, pData, size);
+        WriteBE32(writer, crc ^ 0xFFFFFFFFu);
+    }
+
+    // A zlib stream made of stored deflate blocks
+    void BuildStoredZlib(const std::vector<uint8_t>& raw, std::vector<uint8_t>& out_zlib)
+    {
+        const size_t numBlocks = std::max<size_t>((raw.size() + kMaxStoredBlock - 1) / kMaxStoredBlock, 1);
+        out_zlib.clear();
+        out_zlib.reserve(raw.size() + numBlocks * 5 + 6);
+
+        // CM = 8 (deflate) with a 32K window, no dictionary. The check bits make the header a multiple of 31.
+        out_zlib.push_back(0x78);
+        out_zlib.push_back(0x01);
+
+        uint32_t adlerA = 1, adlerB = 0;
+        size_t offset = 0;
+        for (size_t b = 0; b != numBlocks; ++b)
+        {
+            const size_t size = std::min(kMaxStoredBlock, raw.size() - offset);
+            const uint16_t len = static_cast<uint16_t>(size);
+            const uint16_t nlen = static_cast<uint16_t>(~len);
+
+            out_zlib.push_back(b + 1 == numBlocks ? 1 : 0); // BFINAL, BTYPE = 00
+            out_zlib.push_back(uint8_t(len));
+            out_zlib.push_back(uint8_t(len >> 8));
+            out_zlib.push_back(uint8_t(nlen));
+            out_zlib.push_back(uint8_t(nlen >> 8));
+            out_zlib.insert(out_zlib.end(), raw.begin() + offset, raw.begin() + offset + size);
+
+            for (size_t run = offset; run < offset + size; run += kAdlerRun)
+            {
+                const size_t runEnd = std::min(run + kAdlerRun, offset + size);
+                for (size_t i = run; i != runEnd; ++i)
+                {
+                    adlerA += raw[i];
+                    adlerB += adlerA;
+                }
+                adlerA %= 65521;
+                adlerB %= 65521;
+            }
+            offset += size;
+        }
+
+        const uint32_t adler = (adlerB << 16) | adlerA;
+        out_zlib.push_back(uint8_t(adler >> 24));
+        out_zlib.push_back(uint8_t(adler >> 16));
+        out_zlib.push_back(uint8_t(adler >> 8));
+        out_zlib.push_back(uint8_t(adler));
+    }
+
+    // EXR attributes are a name, a type name, a byte size and the value
+    void WriteEXRAttribute(BinaryWriter& writer, const char* name, const char* type, const void* pValue, uint32_t size)
+    {
+        writer.WriteBytes(name, strlen(name) + 1);
+        writer.WriteBytes(type, strlen(type) + 1);
+        writer.Write(size);
+        writer.WriteBytes(pValue, size);
+    }
+}
+
+bool WritePNG(const wchar_t* path, uint32_t width, uint32_t height, const uint8_t* pRGBA8)
+{
+    if (!ValidateImage(path, width, height, pRGBA8))
+        return false;
+
+    // Every row is prefixed with its filter type, 0 for none
+    const size_t rowBytes = size_t(width) * 4;
+    std::vector<uint8_t> raw((rowBytes + 1) * height);
+    for (uint32_t y = 0; y != height; ++y)
+    {
+        uint8_t* pRow = &raw[y * (rowBytes + 1)];
+        pRow[0] = 0;
+        memcpy(pRow + 1, pRGBA8 + y * rowBytes, rowBytes);
+    }
+
+    std::vector<uint8_t> zlib;
+    BuildStoredZlib(raw, zlib);
+
+    const uint8_t header[13] =
+    {
+        uint8_t(width >> 24), uint8_t(width >> 16), uint8_t(width >> 8), uint8_t(width),
+        uint8_t(height >> 24), uint8_t(height >> 16), uint8_t(height >> 8), uint8_t(height),
+        8, // Bit depth
+        6, // Color type: RGBA
+        0, // Compression: deflate
+        0, // Filter method: adaptive
+        0, // Not interlaced
+    };
+
+    static const uint8_t kSignature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+    BinaryWriter writer;
+    writer.WriteBytes(kSignature, sizeof(kSignature));
+    WritePNGChunk(writer, "IHDR", header, sizeof(header));
+    WritePNGChunk(writer, "IDAT", zlib.data(), zlib.size());
+    WritePNGChunk(writer, "IEND", nullptr, 0);
+
+    if (!writer.SaveToFile(path))
+    {
+        Muon::Printf(L"Error: Failed to write %s!\n", path);
+        return false;
+    }
+    return true;
+}
+
+bool WriteEXR(const wchar_t* path, uint32_t width, uint32_t height, const float* pRGBA32F)
+{
+    if (!ValidateImage(path, width, height, pRGBA32F))
+        return false;
+
+    static const uint32_t kMagic = 20000630;
+    static const uint32_t kVersion = 2; // Single part scanline image
+    static const int32_t kPixelTypeFloat = 2;
+
+    // Channels have to be listed in alphabetical order, and the scanline data follows the same order
+    static const char* kChannelNames[4] = { "A", "B", "G", "R" };
+    static const uint32_t kChannelSources[4] = { 3, 2, 1, 0 };
+
+    BinaryWriter channels;
+    for (const char* name : kChannelNames)
+    {
+        channels.WriteBytes(name, strlen(name) + 1);
+        channels.Write(kPixelTypeFloat);
+        channels.Write(uint32_t(0)); // pLinear and reserved bytes
+        channels.Write(int32_t(1));  // x sampling
+        channels.Write(int32_t(1));  // y sampling
+    }
+    channels.Write(uint8_t(0));
+
+    const int32_t window[4] = { 0, 0, int32_t(width) - 1, int32_t(height) - 1 };
+    const uint8_t noCompression = 0;
+    const uint8_t increasingY = 0;
+    const float one = 1.0f;
+    const float center[2] = { 0.0f, 0.0f };
+
+    BinaryWriter writer;
+    writer.Write(kMagic);
+    writer.Write(kVersion);
+    WriteEXRAttribute(writer, "channels", "chlist", channels.GetBuffer().data(), static_cast<uint32_t>(channels.GetBuffer().size()));
+    WriteEXRAttribute(writer, "compression", "compression", &noCompression, 1);
+    WriteEXRAttribute(writer, "dataWindow", "box2i", window, sizeof(window));
+    WriteEXRAttribute(writer, "displayWindow", "box2i", window, sizeof(window));
+    WriteEXRAttribute(writer, "lineOrder", "lineOrder", &increasingY, 1);
+    WriteEXRAttribute(writer, "pixelAspectRatio", "float", &one, sizeof(one));
+    WriteEXRAttribute(writer, "screenWindowCenter", "v2f", center, sizeof(center));
+    WriteEXRAttribute(writer, "screenWindowWidth", "float", &one, sizeof(one));
+    writer.Write(uint8_t(0));
+
+    // Uncompressed files hold one scanline per chunk, and the offset table points at each of them
+    const uint32_t lineBytes = width * 4 * sizeof(float);
+    const uint64_t firstChunk = writer.GetBuffer().size() + uint64_t(height) * sizeof(uint64_t);
+    for (uint32_t y = 0; y != height; ++y)
+        writer.Write(firstChunk + uint64_t(y) * (8 + lineBytes));
+
+    std::vector<float> line(width);
+    for (uint32_t y = 0; y != height; ++y)
+    {
+        writer.Write(int32_t(y));
+        writer.Write(lineBytes);
+
+        const float* pRow = pRGBA32F + size_t(y) * width * 4;
+        for (uint32_t source : kChannelSources)
+        {
+            for (uint32_t x = 0; x != width; ++x)
+                line[x] = pRow[x * 4 + source];
+            writer.WriteBytes(line.data(), line.size() * sizeof(float));
+        }
+    }
+
+    if (!writer.SaveToFile(path))
+    {
+        Muon::Printf(L"Error: Failed to write %s!\n", path);
+        return false;
+    }
+    return true;
+}
+
+}
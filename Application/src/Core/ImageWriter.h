@@ -0,0 +1,23 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Dependency-free PNG and OpenEXR writers for CPU-side captures
+----------------------------------------------*/
+#ifndef MUON_IMAGEWRITER_H
+#define MUON_IMAGEWRITER_H
+
+#include <stdint.h>
+
+namespace Muon
+{
+
+// 8-bit RGBA with straight alpha, rows top to bottom. The deflate stream is stored rather than compressed,
+// these are debug captures and any viewer will still read them.
+bool WritePNG(const wchar_t* path, uint32_t width, uint32_t height, const uint8_t* pRGBA8);
+
+// 32-bit float RGBA, rows top to bottom, uncompressed scanlines. EXR's convention is premultiplied alpha.
+bool WriteEXR(const wchar_t* path, uint32_t width, uint32_t height, const float* pRGBA32F);
+
+}
+
+#endif
@@ -0,0 +1,155 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Groups a frame's entities into instanced draws by mesh and material
+----------------------------------------------*/
+#include <Core/InstanceBatcher.h>
+
+#include <Core/Material.h>
+#include <Core/Mesh.h>
+#include <Core/Shader.h>
+#include <algorithm>
+#include <chrono>
+#include <string.h>
+
+namespace Muon
+{
+
+void InstanceBatcher::Reset()
+{
+    mEntries.clear();
+    mBatchEntries.clear();
+    mBatches.clear();
+    mBatchLookup.clear();
+    mStats = {};
+}
+
+void InstanceBatcher::Add(const MaterialType* pMaterial, const Mesh* pMesh, const DirectX::XMFLOAT4X4* pWorld, float depth)
+{
+    mEntries.push_back({ pMaterial, pMesh, pWorld, depth, 0 });
+}
+
+bool InstanceBatcher::Build()
+{
+    using Clock = std::chrono::high_resolution_clock;
+    const Clock::time_point buildStart = Clock::now();
+
+    // Assign every entry a batch, counting as we go
+    std::vector<uint32_t> batchCounts;
+    for (Entry& entry : mEntries)
+    {
+        const VertexShader* pVS = entry.pMaterial->GetVertexShader();
+        const bool instanced = pVS && pVS->Instanced && pVS->InstanceDesc.ByteSize != 0;
+
+        uint32_t batchIndex = static_cast<uint32_t>(mBatches.size());
+        if (instanced)
+        {
+            auto it = mBatchLookup.emplace(std::make_pair(entry.pMaterial, entry.pMesh), batchIndex).first;
+            batchIndex = it->second;
+        }
+
+        if (batchIndex == mBatches.size())
+        {
+            InstanceBatch batch;
+            batch.pMaterial = entry.pMaterial;
+            batch.pMesh = entry.pMesh;
+            batch.MinDepth = entry.Depth;
+            batch.pWorld = instanced ? nullptr : entry.pWorld;
+            mBatches.push_back(batch);
+            batchCounts.push_back(0);
+        }
+
+        InstanceBatch& batch = mBatches[batchIndex];
+        batch.NumInstances++;
+        batch.MinDepth = std::min(batch.MinDepth, entry.Depth);
+        entry.Batch = batchIndex;
+    }
+
+    // Counting sort of the entries by batch, keeping submission order within each batch
+    std::vector<uint32_t> batchOffsets(mBatches.size() + 1, 0);
+    for (uint32_t i = 0; i != mBatches.size(); ++i)
+        batchOffsets[i + 1] = batchOffsets[i] + mBatches[i].NumInstances;
+
+    mBatchEntries.resize(mEntries.size());
+    for (uint32_t i = 0; i != mEntries.size(); ++i)
+        mBatchEntries[batchOffsets[mEntries[i].Batch] + batchCounts[mEntries[i].Batch]++] = i;
+
+    bool success = true;
+    for (uint32_t i = 0; i != mBatches.size(); ++i)
+    {
+        InstanceBatch& batch = mBatches[i];
+        if (batch.pWorld)
+        {
+            void* pMapped = nullptr;
+            const bool uploaded = Upload(sizeof(DirectX::XMFLOAT4X4), D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT, pMapped, batch.WorldAddr);
+            if (uploaded)
+                memcpy(pMapped, batch.pWorld, sizeof(DirectX::XMFLOAT4X4));
+            success &= uploaded;
+        }
+        else
+            success &= WriteInstanceStream(batch, batch.pMaterial->GetVertexShader()->InstanceDesc, &mBatchEntries[batchOffsets[i]]);
+    }
+
+    mStats.NumEntities = static_cast<uint32_t>(mEntries.size());
+    mStats.NumBatches = static_cast<uint32_t>(mBatches.size());
+    mStats.BuildMs = std::chrono::duration<double, std::milli>(Clock::now() - buildStart).count();
+    return success;
+}
+
+bool InstanceBatcher::Upload(size_t size, UINT alignment, void*& out_mappedPtr, D3D12_GPU_VIRTUAL_ADDRESS& out_gpuAddr) const
+{
+    if (mUploadFunc)
+        return mUploadFunc(size, alignment, out_mappedPtr, out_gpuAddr);
+    return AllocateFrameUpload(size, alignment, out_mappedPtr, out_gpuAddr);
+}
+
+// Lays each instance out the way the vertex shader's reflected instance inputs expect. World matrix rows go to
+// consecutive WORLDMATRIX attributes; anything the batcher has no data for is zeroed.
+bool InstanceBatcher::WriteInstanceStream(InstanceBatch& batch, const VertexBufferDescription& desc, const uint32_t* pEntries)
+{
+    const UINT stride = desc.ByteSize;
+    const size_t streamSize = size_t(stride) * batch.NumInstances;
+
+    void* pMapped = nullptr;
+    D3D12_GPU_VIRTUAL_ADDRESS gpuAddr = 0;
+    if (!Upload(streamSize, 16, pMapped, gpuAddr))
+        return false;
+
+    struct RowWrite
+    {
+        uint16_t Offset;
+        uint8_t Row;
+    };
+
+    RowWrite rowWrites[4];
+    uint32_t numRowWrites = 0;
+    for (uint16_t attr = 0; attr != desc.AttrCount && numRowWrites != 4; ++attr)
+    {
+        if (desc.SemanticsArr[attr] == Semantics::WORLDMATRIX && desc.ByteOffsets[attr] + sizeof(DirectX::XMFLOAT4) <= stride)
+        {
+            rowWrites[numRowWrites] = { desc.ByteOffsets[attr], static_cast<uint8_t>(numRowWrites) };
+            numRowWrites++;
+        }
+    }
+
+    // Upload memory is recycled every frame, so gaps between what gets written must be cleared
+    const bool hasGaps = stride != numRowWrites * sizeof(DirectX::XMFLOAT4);
+
+    uint8_t* pDst = static_cast<uint8_t*>(pMapped);
+    for (uint32_t i = 0; i != batch.NumInstances; ++i, pDst += stride)
+    {
+        const DirectX::XMFLOAT4X4& world = *mEntries[pEntries[i]].pWorld;
+        if (hasGaps)
+            memset(pDst, 0, stride);
+
+        for (uint32_t w = 0; w != numRowWrites; ++w)
+            memcpy(pDst + rowWrites[w].Offset, world.m[rowWrites[w].Row], sizeof(DirectX::XMFLOAT4));
+    }
+
+    batch.InstanceView.BufferLocation = gpuAddr;
+    batch.InstanceView.SizeInBytes = static_cast<UINT>(streamSize);
+    batch.InstanceView.StrideInBytes = stride;
+    return true;
+}
+
+}
@@ -0,0 +1,88 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Groups a frame's entities into instanced draws by mesh and material
+----------------------------------------------*/
+#ifndef MUON_INSTANCEBATCHER_H
+#define MUON_INSTANCEBATCHER_H
+
+#include <Core/DXCore.h>
+
+#include <DirectXMath.h>
+#include <functional>
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace Muon
+{
+class MaterialType;
+struct Mesh;
+struct VertexBufferDescription;
+
+// One draw. Materials with an instanced vertex shader get one batch per mesh, fed from a per-frame instance stream in slot 1.
+// Everything else gets a batch per entity with its world matrix uploaded for VSWorld.
+struct InstanceBatch
+{
+    const MaterialType* pMaterial = nullptr;
+    const Mesh* pMesh = nullptr;
+    uint32_t NumInstances = 0;
+    float MinDepth = 0.0f; // Of the nearest instance, for front to back sorting
+
+    D3D12_VERTEX_BUFFER_VIEW InstanceView = {};        // Instanced batches
+    const DirectX::XMFLOAT4X4* pWorld = nullptr;       // Single draws, used directly when VSWorld is promoted to root constants
+    D3D12_GPU_VIRTUAL_ADDRESS WorldAddr = 0;           // Single draws otherwise
+
+    bool IsInstanced() const { return InstanceView.BufferLocation != 0; }
+};
+
+struct InstanceBatchStats
+{
+    uint32_t NumEntities = 0;
+    uint32_t NumBatches = 0; // Draw calls
+    double BuildMs = 0.0;
+};
+
+class InstanceBatcher
+{
+public:
+    // Where Build writes instance streams and single draw matrices. Defaults to the frame upload buffer (AllocateFrameUpload),
+    // replaced e.g. to run the batcher without a device.
+    typedef std::function<bool(size_t size, UINT alignment, void*& out_mappedPtr, D3D12_GPU_VIRTUAL_ADDRESS& out_gpuAddr)> UploadFunc;
+    void SetUploadFunc(UploadFunc func) { mUploadFunc = std::move(func); }
+
+    void Reset();
+
+    // pWorld must stay valid until the frame is recorded
+    void Add(const MaterialType* pMaterial, const Mesh* pMesh, const DirectX::XMFLOAT4X4* pWorld, float depth);
+
+    // Groups everything added since Reset and writes the instance streams into the frame's upload buffer. Main thread only.
+    bool Build();
+
+    const std::vector<InstanceBatch>& GetBatches() const { return mBatches; }
+    const InstanceBatchStats& GetStats() const { return mStats; }
+
+private:
+    struct Entry
+    {
+        const MaterialType* pMaterial;
+        const Mesh* pMesh;
+        const DirectX::XMFLOAT4X4* pWorld;
+        float Depth;
+        uint32_t Batch;
+    };
+
+    bool Upload(size_t size, UINT alignment, void*& out_mappedPtr, D3D12_GPU_VIRTUAL_ADDRESS& out_gpuAddr) const;
+    bool WriteInstanceStream(InstanceBatch& batch, const VertexBufferDescription& desc, const uint32_t* pEntries);
+
+    std::vector<Entry> mEntries;
+    std::vector<uint32_t> mBatchEntries; // Entry indices grouped by batch
+    std::vector<InstanceBatch> mBatches;
+    std::map<std::pair<const MaterialType*, const Mesh*>, uint32_t> mBatchLookup; // Few batches, many lookups
+    InstanceBatchStats mStats;
+    UploadFunc mUploadFunc;
+};
+
+}
+
+#endif
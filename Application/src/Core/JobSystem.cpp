@@ -0,0 +1,166 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Worker thread pool for loading and per-frame CPU work
+----------------------------------------------*/
+#include <Core/JobSystem.h>
+
+#include <Core/Profiler.h>
+#include <Utils/Utils.h>
+
+#include <algorithm>
+
+namespace Muon
+{
+static JobSystem* gJobSystemInstance = nullptr;
+
+void JobSystem::Init(uint32_t numWorkers)
+{
+    if (gJobSystemInstance)
+    {
+        Muon::Print("ERROR: Tried to initialize already initialized JobSystem!\n");
+        return;
+    }
+
+    if (numWorkers == 0)
+    {
+        const uint32_t hwThreads = std::thread::hardware_concurrency();
+        numWorkers = hwThreads > 1 ? hwThreads - 1 : 0;
+    }
+
+    gJobSystemInstance = new JobSystem();
+    gJobSystemInstance->mWorkers.reserve(numWorkers);
+    for (uint32_t i = 0; i != numWorkers; ++i)
+        gJobSystemInstance->mWorkers.emplace_back(&JobSystem::WorkerLoop, gJobSystemInstance, i);
+}
+
+void JobSystem::Destroy()
+{
+    if (!gJobSystemInstance)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(gJobSystemInstance->mMutex);
+        gJobSystemInstance->mShutdown = true;
+    }
+    gJobSystemInstance->mWorkAvailable.notify_all();
+
+    for (std::thread& worker : gJobSystemInstance->mWorkers)
+        worker.join();
+
+    delete gJobSystemInstance;
+    gJobSystemInstance = nullptr;
+}
+
+JobSystem& JobSystem::GetSingleton()
+{
+    return *gJobSystemInstance;
+}
+
+void JobSystem::Submit(Job job, JobCounter* pCounter)
+{
+    if (pCounter)
+        pCounter->Pending.fetch_add(1, std::memory_order_relaxed);
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mQueue.push_back({ std::move(job), pCounter });
+    }
+    mWorkAvailable.notify_one();
+}
+
+void JobSystem::Wait(JobCounter& counter)
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    while (!counter.IsDone())
+    {
+        if (!mQueue.empty())
+        {
+            QueuedJob job = std::move(mQueue.front());
+            mQueue.pop_front();
+
+            lock.unlock();
+            Execute(job);
+            lock.lock();
+        }
+        else
+        {
+            mWorkFinished.wait(lock);
+        }
+    }
+    lock.unlock();
+
+    if (counter.HasException.load(std::memory_order_acquire))
+        std::rethrow_exception(counter.Exception);
+}
+
+void JobSystem::ParallelFor(size_t count, size_t grainSize, const RangeJob& func)
+{
+    if (count == 0)
+        return;
+
+    grainSize = std::max<size_t>(grainSize, 1);
+
+    // Not worth the queue traffic
+    if (count <= grainSize || mWorkers.empty())
+    {
+        func(0, count);
+        return;
+    }
+
+    JobCounter counter;
+    for (size_t begin = 0; begin < count; begin += grainSize)
+    {
+        const size_t end = std::min(begin + grainSize, count);
+        Submit([&func, begin, end]() { func(begin, end); }, &counter);
+    }
+
+    Wait(counter);
+}
+
+void JobSystem::WorkerLoop(uint32_t workerIndex)
+{
+    const std::string threadName = "Worker " + std::to_string(workerIndex);
+    Profiler::SetThreadName(threadName.c_str());
+
+    while (true)
+    {
+        QueuedJob job;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mWorkAvailable.wait(lock, [this]() { return mShutdown || !mQueue.empty(); });
+
+            if (mQueue.empty())
+                return; // Shutting down with nothing left to run
+
+            job = std::move(mQueue.front());
+            mQueue.pop_front();
+        }
+
+        Execute(job);
+    }
+}
+
+void JobSystem::Execute(QueuedJob& job)
+{
+    try
+    {
+        job.Func();
+    }
+    catch (...)
+    {
+        if (job.pCounter && !job.pCounter->HasException.exchange(true, std::memory_order_acq_rel))
+            job.pCounter->Exception = std::current_exception();
+        else if (!job.pCounter)
+            Muon::Print("Error: Unhandled exception in a job with no counter!\n");
+    }
+
+    if (job.pCounter && job.pCounter->Pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        // Taking the lock orders this with a waiter that just checked the counter and is about to sleep
+        std::lock_guard<std::mutex> lock(mMutex);
+        mWorkFinished.notify_all();
+    }
+}
+
+}
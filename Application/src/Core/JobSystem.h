@@ -0,0 +1,77 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Worker thread pool for loading and per-frame CPU work
+----------------------------------------------*/
+#ifndef MUON_JOBSYSTEM_H
+#define MUON_JOBSYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+namespace Muon
+{
+
+// Tracks a group of submitted jobs. The first exception thrown by any of them is rethrown by JobSystem::Wait.
+struct JobCounter
+{
+    std::atomic<uint32_t> Pending{ 0 };
+    std::atomic<bool> HasException{ false };
+    std::exception_ptr Exception;
+
+    bool IsDone() const { return Pending.load(std::memory_order_acquire) == 0; }
+};
+
+class JobSystem
+{
+public:
+    typedef std::function<void()> Job;
+    typedef std::function<void(size_t begin, size_t end)> RangeJob;
+
+    // Singleton Stuff. numWorkers = 0 picks one less than the hardware thread count, since the caller helps out while waiting.
+    static void Init(uint32_t numWorkers = 0);
+    static void Destroy();
+
+    static JobSystem& GetSingleton();
+
+    // Worker threads plus the calling thread
+    uint32_t GetNumThreads() const { return static_cast<uint32_t>(mWorkers.size()) + 1; }
+
+    void Submit(Job job, JobCounter* pCounter = nullptr);
+
+    // Runs queued jobs on the calling thread until the counter reaches zero, so waiting never idles a core.
+    void Wait(JobCounter& counter);
+
+    // Splits [0, count) into chunks of at most grainSize and blocks until func has run on all of them.
+    void ParallelFor(size_t count, size_t grainSize, const RangeJob& func);
+
+private:
+    JobSystem() = default;
+
+    struct QueuedJob
+    {
+        Job Func;
+        JobCounter* pCounter = nullptr;
+    };
+
+    void WorkerLoop(uint32_t workerIndex);
+    void Execute(QueuedJob& job);
+
+    std::vector<std::thread> mWorkers;
+    std::deque<QueuedJob> mQueue;
+    std::mutex mMutex;
+    std::condition_variable mWorkAvailable;
+    std::condition_variable mWorkFinished;
+    bool mShutdown = false;
+};
+
+}
+
+#endif
@@ -6,10 +6,12 @@ Description : Implementation of custom material system
 #include "Material.h"
 
 #include <Core/PipelineState.h>
+#include <Core/Profiler.h>
 #include <Core/ResourceCodex.h>
 #include <Core/RootSignatureBuilder.h>
 #include <Core/Shader.h>
 #include <Core/ShaderUtils.h>
+#include <Utils/Utils.h>
 
 namespace Muon
 {
@@ -25,32 +27,34 @@ void MaterialType::Destroy()
 {
     mpRootSignature.Reset();
     mpPipelineState.Reset();
+    mpDepthPipelineState.Reset();
     mMaterialParamsBuffer.Destroy();
 }
 
-bool MaterialType::Bind(ID3D12GraphicsCommandList* pCommandList) const
+bool MaterialType::Bind(ID3D12GraphicsCommandList* pCommandList, const ID3D12RootSignature* pBoundRootSig, const ID3D12PipelineState* pBoundPipeline) const
 {
+    MUON_PROFILE_SCOPE("Material Bind");
     if (!mpRootSignature || !mpPipelineState)
         return false;
 
-    pCommandList->SetGraphicsRootSignature(mpRootSignature.Get());
-    pCommandList->SetPipelineState(mpPipelineState.Get());
+    // Root signatures are shared between material types with the same layout, so consecutive binds can often skip this.
+    if (pBoundRootSig != mpRootSignature.Get())
+        pCommandList->SetGraphicsRootSignature(mpRootSignature.Get());
 
-    int32_t materialParamsRootIndex = GetResourceRootIndex("PSPerMaterial");
-    if (materialParamsRootIndex != ROOTIDX_INVALID)
-    {
-        pCommandList->SetGraphicsRootConstantBufferView(materialParamsRootIndex, mMaterialParamsBuffer.GetGPUVirtualAddress());
-    }
+    if (pBoundPipeline != mpPipelineState.Get())
+        pCommandList->SetPipelineState(mpPipelineState.Get());
+
+    BindConstantBuffer(pCommandList, kPSPerMaterialID, &mMaterialParams, sizeof(mMaterialParams), mMaterialParamsBuffer.GetGPUVirtualAddress());
 
     ResourceCodex& codex = ResourceCodex::GetSingleton();
-    for (auto texPair : mTextureParams)
+    for (const auto& texPair : mTextureParams)
     {
         TextureID texId = texPair.second;
         const Texture* pTex = codex.GetTexture(texId);
         if (!pTex || !pTex->pResource)
             continue;
 
-        int32_t texRootParamIndex = GetResourceRootIndex(texPair.first.c_str());
+        int32_t texRootParamIndex = GetResourceRootIndex(texPair.first);
         if (texRootParamIndex == ROOTIDX_INVALID)
             continue;
 
@@ -71,38 +75,112 @@ void MaterialType::SetPixelShader(const PixelShader* ps)
 	mpPS = ps;
 }
 
-const ParameterDesc* MaterialType::GetParameter(const char* paramName) const
+const ParameterDesc* MaterialType::GetParameter(NameID paramId) const
 {
-	auto itFind = mParamNameToIndex.find(paramName);
-	if (itFind == mParamNameToIndex.end() || itFind->second >= mParamNameToIndex.size())
+	const size_t* pIndex = mParamIndices.Find(paramId);
+	if (!pIndex || *pIndex >= mParameters.size())
 		return nullptr;
 
-	size_t index = itFind->second;
-	return &mParameters.at(index);
+	return &mParameters.at(*pIndex);
+}
+
+bool MaterialType::SetParamValue(NameID paramId, ParameterType type, const ParameterValue& value)
+{
+    const ParameterDesc* pParam = GetParameter(paramId);
+    if (!pParam || pParam->Type != type || type > ParameterType::Float4)
+        return false;
+
+    // Only the PSPerMaterial block is owned by the material, everything else is bound by the renderer
+    if (pParam->ConstantBufferName != cbMaterialParams::kName)
+        return false;
+
+    const size_t paramSize = GetParamTypeSize(type);
+    if (pParam->Offset + paramSize > sizeof(cbMaterialParams))
+        return false;
+
+    memcpy(reinterpret_cast<uint8_t*>(&mMaterialParams) + pParam->Offset, &value, paramSize);
+    return true;
 }
 
 bool MaterialType::PopulateMaterialParams(UploadBuffer& stagingBuffer, ID3D12GraphicsCommandList* pCommandList)
 {
+    MUON_PROFILE_SCOPE("Upload Material Params");
     return mMaterialParamsBuffer.Populate(&mMaterialParams, sizeof(cbMaterialParams), stagingBuffer, pCommandList);
 }
 
-bool MaterialType::SetTextureParam(const char* paramName, TextureID texId)
+bool MaterialType::SetTextureParam(NameID paramId, TextureID texId)
 {
     // Validate that the param actually exists.
-    if (GetResourceRootIndex(paramName) == ROOTIDX_INVALID)
+    if (GetResourceRootIndex(paramId) == ROOTIDX_INVALID)
+        return false;
+
+    mTextureParams.Insert(paramId, texId);
+    return true;
+}
+
+bool MaterialType::IsRootConstant(int32_t rootIndex) const
+{
+    if (rootIndex < 0 || rootIndex >= (int32_t)mRootParams.size())
+        return false;
+
+    return mRootParams[rootIndex].Kind == RootParameterKind::RootConstants;
+}
+
+bool MaterialType::BindDepthOnly(ID3D12GraphicsCommandList* pCommandList, const ID3D12RootSignature* pBoundRootSig, const ID3D12PipelineState* pBoundPipeline) const
+{
+    MUON_PROFILE_SCOPE("Material Bind");
+    if (!mpRootSignature || !mpDepthPipelineState)
+        return false;
+
+    if (pBoundRootSig != mpRootSignature.Get())
+        pCommandList->SetGraphicsRootSignature(mpRootSignature.Get());
+
+    if (pBoundPipeline != mpDepthPipelineState.Get())
+        pCommandList->SetPipelineState(mpDepthPipelineState.Get());
+
+    // Nothing the pixel shader reads is needed, the caller binds the VS constants as usual
+    return true;
+}
+
+bool MaterialType::BindConstantBuffer(ID3D12GraphicsCommandList* pCommandList, NameID resourceId, const void* pData, size_t dataSize, D3D12_GPU_VIRTUAL_ADDRESS gpuAddr) const
+{
+    const int32_t rootIndex = GetResourceRootIndex(resourceId);
+    if (rootIndex == ROOTIDX_INVALID)
+        return false;
+
+    const RootParamBinding& binding = mRootParams[rootIndex];
+    if (binding.Kind != RootParameterKind::RootConstants)
+    {
+        pCommandList->SetGraphicsRootConstantBufferView(rootIndex, gpuAddr);
+        return true;
+    }
+
+    if (!pData)
         return false;
 
-    mTextureParams[paramName] = texId;
+    // The reflected size may include trailing padding the CPU-side struct doesn't have, so never read past dataSize
+    const size_t constantsSize = binding.Num32BitValues * sizeof(UINT);
+    if (dataSize >= constantsSize)
+    {
+        pCommandList->SetGraphicsRoot32BitConstants(rootIndex, binding.Num32BitValues, pData, 0);
+    }
+    else
+    {
+        UINT padded[ROOTSIG_MAX_DWORDS] = {};
+        memcpy(padded, pData, dataSize);
+        pCommandList->SetGraphicsRoot32BitConstants(rootIndex, binding.Num32BitValues, padded, 0);
+    }
+
     return true;
 }
 
-int32_t MaterialType::GetResourceRootIndex(const char* name) const
+int32_t MaterialType::GetResourceRootIndex(NameID resourceId) const
 {
-    auto itFind = mResourceNameToRootIndex.find(name);
-    if (itFind == mResourceNameToRootIndex.end())
+    const int32_t* pRootIndex = mResourceRootIndices.Find(resourceId);
+    if (!pRootIndex)
         return ROOTIDX_INVALID;
 
-    return itFind->second;
+    return *pRootIndex;
 }
 
 bool MaterialType::Generate(DXGI_FORMAT rtvFormat, DXGI_FORMAT dsvFormat)
@@ -118,6 +196,17 @@ bool MaterialType::Generate(DXGI_FORMAT rtvFormat, DXGI_FORMAT dsvFormat)
     if (!MergeShaderResources())
         return false;
 
+    // The params block is memcpy'd whole, so the generated struct must cover everything the shader reads
+    for (const ConstantBufferReflection& cb : mConstantBuffers)
+    {
+        if (cb.Name == cbMaterialParams::kName && cb.Size > sizeof(cbMaterialParams))
+        {
+            Muon::Printf(L"Error: %s reflects a %u byte %S, but cbMaterialParams is only %zu bytes. Rebuild the Shaders project to regenerate it.\n",
+                mName.c_str(), cb.Size, cbMaterialParams::kName, sizeof(cbMaterialParams));
+            return false;
+        }
+    }
+
     if (!GenerateRootSignature())
         return false;
 
@@ -144,7 +233,7 @@ bool MaterialType::MergeShaderResources()
     }
 
     mParameters.clear();
-    mParamNameToIndex.clear();
+    mParamIndices.Clear();
 
     UINT paramIndex = 0;
     for (const auto& cb : mConstantBuffers)
@@ -154,7 +243,7 @@ bool MaterialType::MergeShaderResources()
             ParameterDesc param = var;
             param.Index = paramIndex;
             mParameters.push_back(param);
-            mParamNameToIndex[param.Name] = paramIndex;
+            mParamIndices.Insert(MakeNameID(param.Name.c_str()), paramIndex);
             paramIndex++;
         }
     }
@@ -164,17 +253,24 @@ bool MaterialType::MergeShaderResources()
 
 bool MaterialType::GenerateRootSignature()
 {
-    ID3D12Device* pDevice = Muon::GetDevice();
-
     RootSignatureBuilder builder;
-    mResourceNameToRootIndex.clear();
+    mResourceRootIndices.Clear();
+    mRootParams.clear();
+
+    // Decide which constant buffers are small enough to live directly in the root signature
+    RootParameterPlan plan;
+    if (!PlanRootParameters(mResources, ROOTCONSTANT_MAX_BYTES, ROOTSIG_MAX_DWORDS, plan))
+    {
+        Muon::Printf(L"Error: %s's resources don't fit in a root signature!\n", mName.c_str());
+        return false;
+    }
 
     // Organize resources by type and shader stage
-    std::vector<ShaderResourceBinding> VSCBs;
-    std::vector<ShaderResourceBinding> PSCBs;
-    std::vector<ShaderResourceBinding> VSSRVs;
-    std::vector<ShaderResourceBinding> PSSRVs;
-    std::vector<ShaderResourceBinding> Samplers;
+    std::vector<size_t> VSCBs;
+    std::vector<size_t> PSCBs;
+    std::vector<size_t> VSSRVs;
+    std::vector<size_t> PSSRVs;
+    std::vector<size_t> Samplers;
 
     // Categorize resources
     for (size_t i = 0; i < mResources.size(); ++i)
@@ -185,46 +281,65 @@ bool MaterialType::GenerateRootSignature()
         switch (res.Type)
         {
         case ShaderResourceType::ConstantBuffer:
-            if (isVS) VSCBs.push_back(res);
-            else PSCBs.push_back(res);
+            if (isVS) VSCBs.push_back(i);
+            else PSCBs.push_back(i);
             break;
         case ShaderResourceType::Texture:
         case ShaderResourceType::StructuredBuffer:
-            if (isVS) VSSRVs.push_back(res);
-            else PSSRVs.push_back(res);
+            if (isVS) VSSRVs.push_back(i);
+            else PSSRVs.push_back(i);
             break;
         case ShaderResourceType::Sampler:
-            Samplers.push_back(res);
+            Samplers.push_back(i);
             break;
         }
     }
 
-    UINT rootParamIndex = 0;
+    auto addConstantBuffer = [&](size_t resIndex, D3D12_SHADER_VISIBILITY visibility)
+    {
+        const ShaderResourceBinding& cb = mResources[resIndex];
+
+        RootParamBinding binding;
+        binding.Kind = plan.Kinds[resIndex];
+        if (binding.Kind == RootParameterKind::RootConstants)
+        {
+            binding.Num32BitValues = cb.Size / sizeof(UINT);
+            builder.AddConstants(binding.Num32BitValues, cb.BindPoint, cb.Space, visibility);
+        }
+        else
+        {
+            builder.AddConstantBufferView(cb.BindPoint, cb.Space, visibility);
+        }
+
+        mResourceRootIndices.Insert(MakeNameID(cb.Name.c_str()), (int32_t)mRootParams.size());
+        mRootParams.push_back(binding);
+    };
 
     // Add VS constant buffers
-    for (const auto& cb : VSCBs)
-    {
-        builder.AddConstantBufferView(cb.BindPoint, cb.Space, D3D12_SHADER_VISIBILITY_VERTEX);
-        mResourceNameToRootIndex[cb.Name] = rootParamIndex++;
-    }
+    for (size_t i : VSCBs)
+        addConstantBuffer(i, D3D12_SHADER_VISIBILITY_VERTEX);
 
     // Add PS constant buffers
-    for (const auto& cb : PSCBs)
-    {
-        builder.AddConstantBufferView(cb.BindPoint, cb.Space, D3D12_SHADER_VISIBILITY_PIXEL);
-        mResourceNameToRootIndex[cb.Name] = rootParamIndex++;
-    }
+    for (size_t i : PSCBs)
+        addConstantBuffer(i, D3D12_SHADER_VISIBILITY_PIXEL);
 
     // Add PS textures as unique SRVs
-    for (const auto& srv : PSSRVs)
+    for (size_t i : PSSRVs)
     {
+        const ShaderResourceBinding& srv = mResources[i];
         builder.AddShaderResourceView(srv.BindPoint, srv.Space, D3D12_SHADER_VISIBILITY_PIXEL);
-        mResourceNameToRootIndex[srv.Name] = rootParamIndex++;
+
+        RootParamBinding binding;
+        binding.Kind = RootParameterKind::DescriptorTable;
+        mResourceRootIndices.Insert(MakeNameID(srv.Name.c_str()), (int32_t)mRootParams.size());
+        mRootParams.push_back(binding);
     }
 
     // Add static samplers
-    for (const auto& sampler : Samplers)
+    for (size_t i : Samplers)
     {
+        const ShaderResourceBinding& sampler = mResources[i];
+
         D3D12_STATIC_SAMPLER_DESC samplerDesc = {};
         samplerDesc.Filter = D3D12_FILTER_MIN_MAG_MIP_LINEAR;
         samplerDesc.AddressU = D3D12_TEXTURE_ADDRESS_MODE_WRAP;
@@ -243,7 +358,7 @@ bool MaterialType::GenerateRootSignature()
         builder.AddStaticSampler(samplerDesc);
     }
 
-    return builder.Build(pDevice, mpRootSignature.GetAddressOf());
+    return ResourceCodex::GetSingleton().GetOrCreateRootSignature(builder, mpRootSignature.ReleaseAndGetAddressOf());
 }
 
 bool MaterialType::GeneratePipelineState(DXGI_FORMAT rtvFormat, DXGI_FORMAT dsvFormat)
@@ -273,9 +388,10 @@ bool MaterialType::GeneratePipelineState(DXGI_FORMAT rtvFormat, DXGI_FORMAT dsvF
     psoDesc.BlendState.RenderTarget[0].RenderTargetWriteMask = D3D12_COLOR_WRITE_ENABLE_ALL;
 
     // Depth stencil state
-    psoDesc.DepthStencilState.DepthEnable = FALSE; // TODO: Enable this when we want to do depth testing
-    psoDesc.DepthStencilState.DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ALL;
-    psoDesc.DepthStencilState.DepthFunc = D3D12_COMPARISON_FUNC_LESS;
+    psoDesc.DepthStencilState.DepthEnable = mDepthMode != DepthMode::Disabled;
+    psoDesc.DepthStencilState.DepthWriteMask = mDepthMode == DepthMode::TestWrite ? D3D12_DEPTH_WRITE_MASK_ALL : D3D12_DEPTH_WRITE_MASK_ZERO;
+    psoDesc.DepthStencilState.DepthFunc = mDepthMode == DepthMode::Prepass ? D3D12_COMPARISON_FUNC_EQUAL : D3D12_COMPARISON_FUNC_LESS_EQUAL;
+    psoDesc.DSVFormat = dsvFormat;
 
     // Render target formats
     psoDesc.NumRenderTargets = 1;
@@ -285,6 +401,22 @@ bool MaterialType::GeneratePipelineState(DXGI_FORMAT rtvFormat, DXGI_FORMAT dsvF
     psoDesc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
 
     HRESULT hr = pDevice->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&mpPipelineState));
+    if (FAILED(hr))
+        return false;
+
+    mpDepthPipelineState.Reset();
+    if (mDepthMode != DepthMode::Prepass)
+        return true;
+
+    // The pre-pass runs the exact same vertex shader, so its depths match the main pass bit for bit and EQUAL holds
+    psoDesc.PS = {};
+    psoDesc.NumRenderTargets = 0;
+    psoDesc.RTVFormats[0] = DXGI_FORMAT_UNKNOWN;
+    psoDesc.BlendState.RenderTarget[0].RenderTargetWriteMask = 0;
+    psoDesc.DepthStencilState.DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ALL;
+    psoDesc.DepthStencilState.DepthFunc = D3D12_COMPARISON_FUNC_LESS;
+
+    hr = pDevice->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&mpDepthPipelineState));
     return SUCCEEDED(hr);
 }
 
@@ -296,9 +428,9 @@ MaterialInstance::MaterialInstance(const char* name, const MaterialType& materia
 {
 }
 
-bool MaterialInstance::SetParamValue(const char* paramName, ParameterValue value)
+bool MaterialInstance::SetParamValue(NameID paramId, ParameterValue value)
 {
-	const ParameterDesc* pParamDesc = mType.GetParameter(paramName);
+	const ParameterDesc* pParamDesc = mType.GetParameter(paramId);
 	if (!pParamDesc)
 		return false;
 
@@ -11,9 +11,11 @@ Description : Material class for shader information
 
 #include <Core/Buffers.h>
 #include <Core/CommonTypes.h>
+#include <Core/NameID.h>
 #include <Core/PipelineState.h>
+#include <Core/RootParameterPlan.h>
 #include <Core/Shader.h>
-#include <unordered_map>
+#include <Core/ShaderUtils.h>
 #include <string>
 
 namespace Muon
@@ -75,6 +77,14 @@ struct ParameterValue
 
 static const int32_t ROOTIDX_INVALID = -1;
 
+// How a material's main pass pipeline uses the depth buffer
+enum class DepthMode : uint8_t
+{
+    Disabled,  // Neither tests nor writes
+    TestWrite, // Tests LESS_EQUAL and writes
+    Prepass,   // Writes depth in a depth-only pre-pass, then shades only where the main pass depth is EQUAL without writing
+};
+
 // Material types define the required parameters, shaders, and hold the underlying pipeline state.
 class MaterialType
 {
@@ -82,22 +92,43 @@ public:
     MaterialType(const wchar_t* name);
     void Destroy();
 
-    bool Bind(ID3D12GraphicsCommandList* pCommandList) const;
+    // Skips SetGraphicsRootSignature and SetPipelineState when pBoundRootSig or pBoundPipeline are already the ones this material uses.
+    bool Bind(ID3D12GraphicsCommandList* pCommandList, const ID3D12RootSignature* pBoundRootSig = nullptr, const ID3D12PipelineState* pBoundPipeline = nullptr) const;
+
+    // Binds the depth-only pipeline for the pre-pass instead. Only valid for DepthMode::Prepass materials.
+    bool BindDepthOnly(ID3D12GraphicsCommandList* pCommandList, const ID3D12RootSignature* pBoundRootSig = nullptr, const ID3D12PipelineState* pBoundPipeline = nullptr) const;
+
+    ID3D12RootSignature* GetRootSignature() const { return mpRootSignature.Get(); }
+    ID3D12PipelineState* GetPipelineState() const { return mpPipelineState.Get(); }
+    ID3D12PipelineState* GetDepthPipelineState() const { return mpDepthPipelineState.Get(); }
+
+    // Must be set before Generate
+    void SetDepthMode(DepthMode mode) { mDepthMode = mode; }
+    DepthMode GetDepthMode() const { return mDepthMode; }
 
     const std::wstring& GetName() const { return mName; }
+    const VertexShader* GetVertexShader() const { return mpVS; }
     void SetVertexShader(const VertexShader* vs);
     void SetPixelShader(const PixelShader* ps);
     
     const std::vector<ParameterDesc>& GetAllParameters() const { return mParameters; }
-    const ParameterDesc* GetParameter(const char* paramName) const;
+    const ParameterDesc* GetParameter(NameID paramId) const;
 
     void SetMaterialParams(cbMaterialParams& params) { mMaterialParams = params; }
+
+    // Writes a single reflected per-material parameter into the material's params block by its reflected offset.
+    bool SetParamValue(NameID paramId, ParameterType type, const ParameterValue& value);
     bool PopulateMaterialParams(UploadBuffer& stagingBuffer, ID3D12GraphicsCommandList* pCommandList);
 
-    bool SetTextureParam(const char* paramName, TextureID texId);
+    bool SetTextureParam(NameID paramId, TextureID texId);
 
     const std::vector<ConstantBufferReflection>& GetConstantBuffers() const { return mConstantBuffers; }
-    int GetResourceRootIndex(const char* name) const;
+    int32_t GetResourceRootIndex(NameID resourceId) const;
+
+    // Constant buffers small enough are promoted to root constants when the root signature is generated.
+    // This binds one either way: pData is uploaded as root constants if promoted, otherwise gpuAddr is bound as a root CBV.
+    bool BindConstantBuffer(ID3D12GraphicsCommandList* pCommandList, NameID resourceId, const void* pData, size_t dataSize, D3D12_GPU_VIRTUAL_ADDRESS gpuAddr) const;
+    bool IsRootConstant(int32_t rootIndex) const;
 
     bool Generate(DXGI_FORMAT rtvFormat = DXGI_FORMAT_R8G8B8A8_UNORM,
         DXGI_FORMAT dsvFormat = DXGI_FORMAT_D24_UNORM_S8_UINT);
@@ -114,12 +145,22 @@ protected:
     std::vector<ConstantBufferReflection> mConstantBuffers;
     std::vector<ParameterDesc> mParameters;
 
-    std::unordered_map<std::string, size_t> mParamNameToIndex;
-    std::unordered_map<std::string, int32_t> mResourceNameToRootIndex;
-    std::unordered_map<std::string, TextureID> mTextureParams;
+    NameIDMap<size_t> mParamIndices;
+    NameIDMap<int32_t> mResourceRootIndices;
+    NameIDMap<TextureID> mTextureParams;
+
+    struct RootParamBinding
+    {
+        RootParameterKind Kind = RootParameterKind::Unbound;
+        UINT Num32BitValues = 0;
+    };
+    std::vector<RootParamBinding> mRootParams; // Indexed by root parameter index
 
     Microsoft::WRL::ComPtr<ID3D12RootSignature> mpRootSignature;
     Microsoft::WRL::ComPtr<ID3D12PipelineState> mpPipelineState;
+    Microsoft::WRL::ComPtr<ID3D12PipelineState> mpDepthPipelineState; // Same VS, no PS or render targets
+
+    DepthMode mDepthMode = DepthMode::TestWrite;
 
     std::wstring mName;
 
@@ -137,7 +178,7 @@ class MaterialInstance
 {
 public:
     MaterialInstance(const char* name, const MaterialType& materialType);
-    bool SetParamValue(const char* paramName, ParameterValue value);
+    bool SetParamValue(NameID paramId, ParameterValue value);
 
 protected:
     const MaterialType& mType;
@@ -11,6 +11,10 @@ Description : Mesh initialization logic, for DX12
 #include <Utils/Utils.h>
 #include <d3dx12.h>
 
+#include <algorithm>
+#include <float.h>
+#include <string.h>
+
 namespace Muon
 {
 
@@ -56,6 +60,9 @@ bool Mesh::Release()
 
 bool Mesh::Init(void* vertexData, UINT vertexDataSize, UINT vertexStride, void* indexData, UINT indexDataSize, UINT indexCount, DXGI_FORMAT indexFormat)
 {
+    if (vertexData && vertexStride != 0)
+        ComputeBounds(vertexData, vertexDataSize / vertexStride, vertexStride);
+
     vertexDataSize = Muon::AlignToBoundary(vertexDataSize, 16);
 
     if (!vertexData || !CreateBuffer(vertexData, vertexDataSize, this->VertexBuffer))
@@ -92,6 +99,32 @@ bool Mesh::Init(void* vertexData, UINT vertexDataSize, UINT vertexStride, void*
     return true;
 }
 
+void Mesh::ComputeBounds(const void* vertexData, UINT numVertices, UINT vertexStride, UINT positionOffset)
+{
+    if (numVertices == 0)
+    {
+        BoundsCenter = BoundsExtents = DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f);
+        return;
+    }
+
+    float minPos[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+    float maxPos[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+    const BYTE* pVertex = static_cast<const BYTE*>(vertexData) + positionOffset;
+    for (UINT i = 0; i != numVertices; ++i, pVertex += vertexStride)
+    {
+        float pos[3];
+        memcpy(pos, pVertex, sizeof(pos));
+        for (int axis = 0; axis != 3; ++axis)
+        {
+            minPos[axis] = std::min<float>(minPos[axis], pos[axis]);
+            maxPos[axis] = std::max<float>(maxPos[axis], pos[axis]);
+        }
+    }
+
+    BoundsCenter = DirectX::XMFLOAT3(0.5f * (minPos[0] + maxPos[0]), 0.5f * (minPos[1] + maxPos[1]), 0.5f * (minPos[2] + maxPos[2]));
+    BoundsExtents = DirectX::XMFLOAT3(0.5f * (maxPos[0] - minPos[0]), 0.5f * (maxPos[1] - minPos[1]), 0.5f * (maxPos[2] - minPos[2]));
+}
+
 bool Mesh::PopulateBuffers(void* vertexData, UINT vertexDataSize, UINT vertexStride, void* indexData, UINT indexDataSize, UINT indexCount)
 {
     ResourceCodex& codex = ResourceCodex::GetSingleton();
@@ -178,14 +211,24 @@ bool Mesh::PopulateBuffers(void* vertexData, UINT vertexDataSize, UINT vertexStr
 }
 
 bool Mesh::Draw(ID3D12GraphicsCommandList* pCommandList) const
+{
+    Bind(pCommandList);
+    //pCommandList->DrawInstanced(3, 1, 0, 0);
+    DrawIndexed(pCommandList);
+
+    return true;
+}
+
+void Mesh::Bind(ID3D12GraphicsCommandList* pCommandList) const
 {
     pCommandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
     pCommandList->IASetVertexBuffers(0, 1, &VertexBufferView);
     pCommandList->IASetIndexBuffer(&IndexBufferView);
-    //pCommandList->DrawInstanced(3, 1, 0, 0);
-    pCommandList->DrawIndexedInstanced(IndexCount, 1, 0, 0, 0);
+}
 
-    return true;
+void Mesh::DrawIndexed(ID3D12GraphicsCommandList* pCommandList, UINT numInstances) const
+{
+    pCommandList->DrawIndexedInstanced(IndexCount, numInstances, 0, 0, 0);
 }
 
 }
\ No newline at end of file
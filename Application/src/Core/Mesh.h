@@ -9,6 +9,8 @@ Description : Mesh stores the vertex,index buffers ready to be drawn by DirectX
 #include "DXCore.h"
 #include "Shader.h"
 
+#include <DirectXMath.h>
+
 namespace Muon
 {
 struct Mesh
@@ -18,12 +20,22 @@ struct Mesh
     bool PopulateBuffers(void* vertexData, UINT vertexDataSize, UINT vertexStride, void* indexData, UINT indexDataSize, UINT indexCount);
     bool Draw(ID3D12GraphicsCommandList* pCommandList) const;
 
+    // Split versions of Draw, so consecutive draws of the same mesh only bind its buffers once
+    void Bind(ID3D12GraphicsCommandList* pCommandList) const;
+    void DrawIndexed(ID3D12GraphicsCommandList* pCommandList, UINT numInstances = 1) const;
+
+    // Local space bounds for culling. Init assumes the position is the first float3 of each vertex, callers
+    // with a different layout recompute them with the right offset.
+    void ComputeBounds(const void* vertexData, UINT numVertices, UINT vertexStride, UINT positionOffset = 0);
+
     ID3D12Resource* VertexBuffer = nullptr;
     ID3D12Resource* IndexBuffer = nullptr;
     D3D12_VERTEX_BUFFER_VIEW VertexBufferView = {0};
     D3D12_INDEX_BUFFER_VIEW IndexBufferView = {0};
     UINT IndexCount = 0;
     UINT Stride = 0;
+    DirectX::XMFLOAT3 BoundsCenter = { 0.0f, 0.0f, 0.0f };
+    DirectX::XMFLOAT3 BoundsExtents = { 0.0f, 0.0f, 0.0f }; // Half size
 };
 
 }
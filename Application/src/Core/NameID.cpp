@@ -0,0 +1,67 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Strongly typed hashed names for shader parameters and resources
+----------------------------------------------*/
+#include <Core/NameID.h>
+
+#include <Utils/Utils.h>
+
+#if defined(MN_DEBUG)
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#endif
+
+namespace Muon
+{
+
+#if defined(MN_DEBUG)
+namespace
+{
+// Reverse lookup for diagnostics. Debug only, release builds never keep the strings around.
+std::mutex gNameRegistryMutex;
+std::unordered_map<uint32_t, std::string> gNameRegistry;
+}
+
+NameID MakeNameID(const char* name)
+{
+    NameID id(name);
+
+    std::lock_guard<std::mutex> lock(gNameRegistryMutex);
+    auto itFind = gNameRegistry.find(id.Value);
+    if (itFind == gNameRegistry.end())
+    {
+        gNameRegistry.emplace(id.Value, name);
+    }
+    else if (itFind->second != name)
+    {
+        Muon::Printf("Error: NameID collision between '%s' and '%s' (0x%08x)!\n", itFind->second.c_str(), name, id.Value);
+    }
+
+    return id;
+}
+
+const char* GetNameIDString(NameID id)
+{
+    std::lock_guard<std::mutex> lock(gNameRegistryMutex);
+    auto itFind = gNameRegistry.find(id.Value);
+    if (itFind == gNameRegistry.end())
+        return "<unregistered>";
+
+    // Entries are never removed, so the string outlives the lock
+    return itFind->second.c_str();
+}
+#else
+NameID MakeNameID(const char* name)
+{
+    return NameID(name);
+}
+
+const char* GetNameIDString(NameID)
+{
+    return "<stripped>";
+}
+#endif
+
+}
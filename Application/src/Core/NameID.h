@@ -0,0 +1,99 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Strongly typed hashed names for shader parameters and resources
+----------------------------------------------*/
+#ifndef MUON_NAMEID_H
+#define MUON_NAMEID_H
+
+#include <Core/hash_util.h>
+
+#include <algorithm>
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+namespace Muon
+{
+
+// FNV-1a of a reflected name. Constructing one from a string literal in a constexpr context costs nothing at runtime,
+// so hot-path lookups are integer compares against a constant.
+struct NameID
+{
+    uint32_t Value = 0;
+
+    constexpr NameID() = default;
+    constexpr explicit NameID(const char* name) : Value(fnv1a(name)) {}
+
+    constexpr bool IsValid() const { return Value != 0; }
+
+    constexpr bool operator==(NameID other) const { return Value == other.Value; }
+    constexpr bool operator!=(NameID other) const { return Value != other.Value; }
+    constexpr bool operator<(NameID other) const { return Value < other.Value; }
+};
+
+// e.g. constexpr NameID kCameraID = "VSCamera"_nid;
+constexpr NameID operator""_nid(const char* name, size_t)
+{
+    return NameID(name);
+}
+
+// Hashes a name only known at runtime (reflection, manifests).
+// Debug builds also record the string so IDs can be printed, and report any two names that hash to the same ID.
+NameID MakeNameID(const char* name);
+
+// Returns the name an ID was made from if it went through MakeNameID, otherwise a placeholder. Only meaningful in debug builds.
+const char* GetNameIDString(NameID id);
+
+// Small sorted flat map keyed by NameID. Meant for the handful of entries a material has, where a binary search
+// over one contiguous array beats hashing strings into an unordered_map.
+template<typename T>
+class NameIDMap
+{
+public:
+    using Entry = std::pair<NameID, T>;
+
+    void Clear() { mEntries.clear(); }
+    void Reserve(size_t count) { mEntries.reserve(count); }
+    size_t Size() const { return mEntries.size(); }
+
+    // Inserts or overwrites the value for id
+    T& Insert(NameID id, const T& value)
+    {
+        auto it = LowerBound(id);
+        if (it != mEntries.end() && it->first == id)
+        {
+            it->second = value;
+            return it->second;
+        }
+
+        return mEntries.insert(it, Entry(id, value))->second;
+    }
+
+    const T* Find(NameID id) const
+    {
+        auto it = std::lower_bound(mEntries.begin(), mEntries.end(), id,
+            [](const Entry& entry, NameID key) { return entry.first < key; });
+
+        if (it == mEntries.end() || it->first != id)
+            return nullptr;
+
+        return &it->second;
+    }
+
+    typename std::vector<Entry>::const_iterator begin() const { return mEntries.begin(); }
+    typename std::vector<Entry>::const_iterator end() const { return mEntries.end(); }
+
+private:
+    typename std::vector<Entry>::iterator LowerBound(NameID id)
+    {
+        return std::lower_bound(mEntries.begin(), mEntries.end(), id,
+            [](const Entry& entry, NameID key) { return entry.first < key; });
+    }
+
+    std::vector<Entry> mEntries; // Sorted by NameID
+};
+
+}
+
+#endif
@@ -0,0 +1,521 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Converts float grids from NanoVDB files into sparse cloud volumes
+----------------------------------------------*/
+#include <Core/NanoVDBImporter.h>
+
+#include <Core/JobSystem.h>
+#include <Core/Profiler.h>
+#include <Core/hash_util.h>
+#include <Utils/Utils.h>
+
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <string.h>
+#include <string>
+
+namespace Muon
+{
+
+namespace
+{
+    // Bump whenever the conversion changes, so cached volumes are rebuilt
+    static const uint32_t kImporterVersion = 2;
+
+    static const size_t kLeavesPerJob = 64;
+    static const size_t kTileBricksPerJob = 256;
+    static const size_t kHashChunkSize = 1024 * 1024;
+
+    // NanoVDB is a flat buffer with a fixed layout, these are the byte offsets of the parts a float grid import needs.
+    // Grids aren't guaranteed to be aligned inside a file, so everything is read with memcpy.
+    static const uint64_t kNanoMagic = 0x004244566F6E614Eull; // "NanoVDB", the last byte differs between file and grid magic
+    static const uint64_t kNanoMagicMask = 0x00FFFFFFFFFFFFFFull;
+    static const uint32_t kNanoMajorVersion = 32;
+    static const uint32_t kNanoMajorVersionShift = 21;
+    static const uint16_t kNanoCodecNone = 0;
+    static const uint32_t kNanoGridTypeFloat = 1;
+
+    // File header, followed by a metadata block, a name and a grid buffer for each grid
+    static const size_t kFileHeaderSize = 16;
+    static const size_t kFileHeaderVersion = 8;
+    static const size_t kFileHeaderGridCount = 12;
+
+    static const size_t kMetaDataSize = 176;
+    static const size_t kMetaFileSize = 8;
+    static const size_t kMetaGridType = 32;
+    static const size_t kMetaNameSize = 136;
+    static const size_t kMetaCodec = 168;
+
+    // GridData, the tree follows right after it
+    static const size_t kGridDataSize = 672;
+    static const size_t kGridMagic = 0;
+    static const size_t kGridVersion = 16;
+    static const size_t kGridSize = 32;
+    static const size_t kGridMatD = 384;
+    static const size_t kGridVecD = 528;
+    static const size_t kGridType = 636;
+
+    // TreeData. Node offsets are relative to the tree and ordered leaf, lower, upper, root. Counts skip the root.
+    static const size_t kTreeDataSize = 64;
+    static const size_t kTreeNodeOffsets = 0;
+    static const size_t kTreeNodeCounts = 32;
+    static const size_t kTreeTileCounts = 44;
+
+    // LeafData<float>. Values are z fastest, and the bounding box's min corner rounds down to the leaf's origin.
+    static const uint32_t kLeafDim = 8;
+    static const size_t kLeafValueMask = 16;
+    static const size_t kLeafValues = 96;
+    static const size_t kLeafSize = 2144;
+
+    static_assert(kLeafDim == SPARSE_BRICK_SIZE, "Leaves are converted one to one into bricks");
+
+    // InternalData<float>. Tables are 8 bytes per entry, holding either a child offset or a tile value.
+    struct InternalNodeLayout
+    {
+        uint32_t Log2Dim;       // Children along each axis
+        uint32_t ChildLog2Dim;  // Voxels along each axis of a child
+        size_t ValueMask;
+        size_t ChildMask;
+        size_t Table;
+        size_t Size;
+    };
+    static const InternalNodeLayout kLowerLayout = { 4, 3, 32, 544, 1088, 33856 };
+    static const InternalNodeLayout kUpperLayout = { 5, 7, 32, 4128, 8256, 270400 };
+
+    template<typename T>
+    T ReadAt(const uint8_t* pData, size_t offset)
+    {
+        T value;
+        memcpy(&value, pData + offset, sizeof(T));
+        return value;
+    }
+
+    struct NanoGrid
+    {
+        const uint8_t* pData = nullptr;
+        size_t Size = 0;
+        std::string Name;
+    };
+
+    bool FindFloatGrid(const uint8_t* pFile, size_t fileSize, const wchar_t* path, const char* gridName, NanoGrid& out_grid)
+    {
+        if (fileSize < kFileHeaderSize || (ReadAt<uint64_t>(pFile, 0) & kNanoMagicMask) != kNanoMagic)
+        {
+            Muon::Printf(L"Error: %s isn't a NanoVDB file!\n", path);
+            return false;
+        }
+
+        const uint32_t fileVersion = ReadAt<uint32_t>(pFile, kFileHeaderVersion);
+        if (fileVersion >> kNanoMajorVersionShift != kNanoMajorVersion)
+        {
+            Muon::Printf(L"Error: %s was written by NanoVDB %u.x, only %u.x is supported!\n", path, fileVersion >> kNanoMajorVersionShift, kNanoMajorVersion);
+            return false;
+        }
+
+        const uint16_t gridCount = ReadAt<uint16_t>(pFile, kFileHeaderGridCount);
+        size_t offset = kFileHeaderSize;
+        for (uint16_t g = 0; g != gridCount; ++g)
+        {
+            if (offset + kMetaDataSize > fileSize)
+                break;
+
+            const uint8_t* pMeta = pFile + offset;
+            const uint64_t sizeInFile = ReadAt<uint64_t>(pMeta, kMetaFileSize);
+            const uint32_t nameSize = ReadAt<uint32_t>(pMeta, kMetaNameSize);
+            const size_t gridOffset = offset + kMetaDataSize + nameSize;
+            if (gridOffset > fileSize || sizeInFile > fileSize - gridOffset)
+                break;
+
+            // The stored name counts its terminator
+            const std::string name(reinterpret_cast<const char*>(pMeta + kMetaDataSize), nameSize > 0 ? nameSize - 1 : 0);
+            const bool isFloat = ReadAt<uint32_t>(pMeta, kMetaGridType) == kNanoGridTypeFloat;
+            if ((gridName && name == gridName) || (!gridName && isFloat))
+            {
+                if (!isFloat || ReadAt<uint16_t>(pMeta, kMetaCodec) != kNanoCodecNone)
+                {
+                    Muon::Printf(L"Error: Grid '%S' in %s must be an uncompressed float grid!\n", name.c_str(), path);
+                    return false;
+                }
+
+                out_grid.pData = pFile + gridOffset;
+                out_grid.Size = static_cast<size_t>(sizeInFile);
+                out_grid.Name = name;
+                return true;
+            }
+
+            offset = gridOffset + static_cast<size_t>(sizeInFile);
+        }
+
+        if (gridName)
+            Muon::Printf(L"Error: %s has no grid named '%S'!\n", path, gridName);
+        else
+            Muon::Printf(L"Error: %s has no float grids!\n", path);
+        return false;
+    }
+
+    // Checks a level's node array lies inside the grid buffer. Levels without nodes come back as nullptr.
+    bool GetNodeArray(const NanoGrid& grid, uint32_t level, size_t nodeSize, const uint8_t*& out_pNodes, uint32_t& out_count)
+    {
+        const uint8_t* pTree = grid.pData + kGridDataSize;
+        const int64_t nodeOffset = ReadAt<int64_t>(pTree, kTreeNodeOffsets + level * sizeof(int64_t));
+        out_count = ReadAt<uint32_t>(pTree, kTreeNodeCounts + level * sizeof(uint32_t));
+        out_pNodes = nullptr;
+        if (out_count == 0)
+            return true;
+
+        const uint64_t start = kGridDataSize + uint64_t(nodeOffset);
+        if (nodeOffset < int64_t(kTreeDataSize) || start > grid.Size || uint64_t(out_count) * nodeSize > grid.Size - start)
+            return false;
+
+        out_pNodes = grid.pData + start;
+        return true;
+    }
+
+    // Grid values become [0, 255], where 255 is the desc's full density
+    struct ValueRemap
+    {
+        float Min;
+        float InvRange;
+
+        // Inactive voxels and tiles hold the background value. That's empty for fog volumes but not for level sets, whose
+        // interior is only stored as inactive tiles of -background. An inverted range is what marks a level set import.
+        bool KeepInactive;
+
+        uint8_t Quantize(float value) const
+        {
+            // Written so NaNs come out empty
+            const float t = (value - Min) * InvRange;
+            if (!(t > 0.0f))
+                return 0;
+            return t < 1.0f ? static_cast<uint8_t>(t * 255.0f + 0.5f) : 255;
+        }
+    };
+
+    // Tiles of internal nodes stand for a constant block of voxels, which are expanded into bricks
+    struct NanoTile
+    {
+        int32_t Origin[3];
+        uint32_t Dim;
+        uint8_t Value;
+    };
+
+    void GatherTiles(const uint8_t* pNodes, uint32_t numNodes, const InternalNodeLayout& layout, const ValueRemap& remap, std::vector<NanoTile>& out_tiles)
+    {
+        const uint32_t numEntries = 1u << (3 * layout.Log2Dim);
+        const uint32_t childDim = 1u << layout.ChildLog2Dim;
+        const int32_t nodeMask = ~int32_t((1u << (layout.Log2Dim + layout.ChildLog2Dim)) - 1);
+        const uint32_t axisMask = (1u << layout.Log2Dim) - 1;
+
+        for (uint32_t n = 0; n != numNodes; ++n)
+        {
+            const uint8_t* pNode = pNodes + size_t(n) * layout.Size;
+            int32_t origin[3];
+            for (uint32_t a = 0; a != 3; ++a)
+                origin[a] = ReadAt<int32_t>(pNode, a * sizeof(int32_t)) & nodeMask;
+
+            for (uint32_t w = 0; w != numEntries / 64; ++w)
+            {
+                const uint64_t active = remap.KeepInactive ? ~0ull : ReadAt<uint64_t>(pNode, layout.ValueMask + w * sizeof(uint64_t));
+                const uint64_t tiles = active & ~ReadAt<uint64_t>(pNode, layout.ChildMask + w * sizeof(uint64_t));
+                for (uint32_t bit = 0; tiles != 0 && bit != 64; ++bit)
+                {
+                    if (!((tiles >> bit) & 1))
+                        continue;
+
+                    const uint32_t entry = w * 64 + bit;
+                    const uint8_t value = remap.Quantize(ReadAt<float>(pNode, layout.Table + entry * sizeof(uint64_t)));
+                    if (value == 0)
+                        continue;
+
+                    // Like leaf values, entries are z fastest
+                    NanoTile tile;
+                    tile.Origin[0] = origin[0] + int32_t(((entry >> (2 * layout.Log2Dim)) & axisMask) * childDim);
+                    tile.Origin[1] = origin[1] + int32_t(((entry >> layout.Log2Dim) & axisMask) * childDim);
+                    tile.Origin[2] = origin[2] + int32_t((entry & axisMask) * childDim);
+                    tile.Dim = childDim;
+                    tile.Value = value;
+                    out_tiles.push_back(tile);
+                }
+            }
+        }
+    }
+
+    bool ImportNanoVDBBuffer(const uint8_t* pFile, size_t fileSize, const wchar_t* path, const NanoVDBImportDesc& desc,
+        SparseCloudVolumeData& out_data, NanoVDBImportStats& stats)
+    {
+        using Clock = std::chrono::high_resolution_clock;
+
+        MUON_PROFILE_SCOPE("Import NanoVDB");
+        const Clock::time_point start = Clock::now();
+
+        if (!(desc.ValueMax != desc.ValueMin) || !isfinite(desc.ValueMax - desc.ValueMin) || !(desc.WorldScale > 0.0f))
+        {
+            Muon::Printf(L"Error: Can't import %s, the value range must not be empty and the world scale must be positive!\n", path);
+            return false;
+        }
+
+        NanoGrid grid;
+        if (!FindFloatGrid(pFile, fileSize, path, desc.GridName, grid))
+            return false;
+
+        if (grid.Size < kGridDataSize + kTreeDataSize || (ReadAt<uint64_t>(grid.pData, kGridMagic) & kNanoMagicMask) != kNanoMagic ||
+            ReadAt<uint32_t>(grid.pData, kGridVersion) >> kNanoMajorVersionShift != kNanoMajorVersion ||
+            ReadAt<uint32_t>(grid.pData, kGridType) != kNanoGridTypeFloat || ReadAt<uint64_t>(grid.pData, kGridSize) > grid.Size)
+        {
+            Muon::Printf(L"Error: Grid '%S' in %s is corrupt!\n", grid.Name.c_str(), path);
+            return false;
+        }
+
+        // Bricks are axis aligned cubes, so anything but a uniform scale and a translation can't be represented
+        double mat[9], translation[3];
+        for (uint32_t i = 0; i != 9; ++i)
+            mat[i] = ReadAt<double>(grid.pData, kGridMatD + i * sizeof(double));
+        for (uint32_t a = 0; a != 3; ++a)
+            translation[a] = ReadAt<double>(grid.pData, kGridVecD + a * sizeof(double));
+
+        const double voxelSize = mat[0];
+        const double tolerance = 1e-5 * fabs(voxelSize);
+        bool isUniformScale = voxelSize > 0.0 && fabs(mat[4] - voxelSize) <= tolerance && fabs(mat[8] - voxelSize) <= tolerance;
+        for (uint32_t i : { 1, 2, 3, 5, 6, 7 })
+            isUniformScale = isUniformScale && fabs(mat[i]) <= tolerance;
+        if (!isUniformScale)
+        {
+            Muon::Printf(L"Error: Grid '%S' in %s is rotated or not uniformly scaled!\n", grid.Name.c_str(), path);
+            return false;
+        }
+
+        const uint8_t* pLeaves = nullptr;
+        const uint8_t* pLowers = nullptr;
+        const uint8_t* pUppers = nullptr;
+        uint32_t numLeaves = 0, numLowers = 0, numUppers = 0;
+        if (!GetNodeArray(grid, 0, kLeafSize, pLeaves, numLeaves) || !GetNodeArray(grid, 1, kLowerLayout.Size, pLowers, numLowers) ||
+            !GetNodeArray(grid, 2, kUpperLayout.Size, pUppers, numUppers))
+        {
+            Muon::Printf(L"Error: Grid '%S' in %s has nodes outside of its buffer!\n", grid.Name.c_str(), path);
+            return false;
+        }
+
+        const uint32_t numRootTiles = ReadAt<uint32_t>(grid.pData + kGridDataSize, kTreeTileCounts + 2 * sizeof(uint32_t));
+        if (numRootTiles > 0)
+            Muon::Printf(L"Warning: Ignoring %u active root tiles of '%S' in %s, they're 4096 voxels across.\n", numRootTiles, grid.Name.c_str(), path);
+
+        ValueRemap remap;
+        remap.Min = desc.ValueMin;
+        remap.InvRange = 1.0f / (desc.ValueMax - desc.ValueMin);
+        remap.KeepInactive = desc.ValueMax < desc.ValueMin;
+
+        std::vector<NanoTile> tiles;
+        GatherTiles(pLowers, numLowers, kLowerLayout, remap, tiles);
+        GatherTiles(pUppers, numUppers, kUpperLayout, remap, tiles);
+
+        // Leaves that end up empty after remapping still get a brick here, Finalize drops them
+        std::vector<int32_t> leafOrigins(size_t(numLeaves) * 3);
+        int64_t boundsMin[3] = { INT64_MAX, INT64_MAX, INT64_MAX };
+        int64_t boundsMax[3] = { INT64_MIN, INT64_MIN, INT64_MIN };
+        for (uint32_t l = 0; l != numLeaves; ++l)
+        {
+            for (uint32_t a = 0; a != 3; ++a)
+            {
+                const int32_t origin = ReadAt<int32_t>(pLeaves + size_t(l) * kLeafSize, a * sizeof(int32_t)) & ~int32_t(kLeafDim - 1);
+                leafOrigins[l * 3 + a] = origin;
+                boundsMin[a] = std::min<int64_t>(boundsMin[a], origin);
+                boundsMax[a] = std::max<int64_t>(boundsMax[a], int64_t(origin) + kLeafDim);
+            }
+        }
+        for (const NanoTile& tile : tiles)
+        {
+            for (uint32_t a = 0; a != 3; ++a)
+            {
+                boundsMin[a] = std::min<int64_t>(boundsMin[a], tile.Origin[a]);
+                boundsMax[a] = std::max<int64_t>(boundsMax[a], int64_t(tile.Origin[a]) + tile.Dim);
+            }
+        }
+
+        if (numLeaves == 0 && tiles.empty())
+        {
+            Muon::Printf(L"Error: Grid '%S' in %s has no active voxels!\n", grid.Name.c_str(), path);
+            return false;
+        }
+
+        uint32_t gridSize[3];
+        float origin[3];
+        for (uint32_t a = 0; a != 3; ++a)
+        {
+            // Voxel centers sit on index coordinates, bricks start half a voxel before theirs
+            gridSize[a] = static_cast<uint32_t>(std::min<int64_t>((boundsMax[a] - boundsMin[a]) / kLeafDim, SPARSE_MAX_GRID_SIZE + 1));
+            origin[a] = static_cast<float>((translation[a] + (double(boundsMin[a]) - 0.5) * voxelSize) * desc.WorldScale) + desc.WorldOffset[a];
+        }
+
+        if (!out_data.Init(gridSize, origin, static_cast<float>(voxelSize * desc.WorldScale), desc.DensityScale))
+        {
+            Muon::Printf(L"Error: Grid '%S' in %s doesn't fit in a sparse volume!\n", grid.Name.c_str(), path);
+            return false;
+        }
+
+        const auto getBrickCoord = [&](int64_t index, uint32_t axis, uint32_t brickOffset)
+        {
+            return static_cast<uint16_t>((index - boundsMin[axis]) / kLeafDim + brickOffset);
+        };
+
+        std::vector<uint32_t> leafBricks(numLeaves);
+        for (uint32_t l = 0; l != numLeaves; ++l)
+        {
+            const int32_t* pOrigin = &leafOrigins[l * 3];
+            leafBricks[l] = out_data.AddBrick(getBrickCoord(pOrigin[0], 0, 0), getBrickCoord(pOrigin[1], 1, 0), getBrickCoord(pOrigin[2], 2, 0));
+        }
+
+        struct TileBrick
+        {
+            uint32_t Brick;
+            uint8_t Value;
+        };
+        std::vector<TileBrick> tileBricks;
+        uint64_t numTileVoxels = 0;
+        for (const NanoTile& tile : tiles)
+        {
+            const uint32_t bricksPerAxis = tile.Dim / kLeafDim;
+            for (uint32_t z = 0; z != bricksPerAxis; ++z)
+            {
+                for (uint32_t y = 0; y != bricksPerAxis; ++y)
+                {
+                    for (uint32_t x = 0; x != bricksPerAxis; ++x)
+                    {
+                        const uint32_t brick = out_data.AddBrick(getBrickCoord(tile.Origin[0], 0, x), getBrickCoord(tile.Origin[1], 1, y),
+                            getBrickCoord(tile.Origin[2], 2, z));
+                        tileBricks.push_back({ brick, tile.Value });
+                    }
+                }
+            }
+            numTileVoxels += uint64_t(tile.Dim) * tile.Dim * tile.Dim;
+        }
+
+        JobSystem& jobSystem = JobSystem::GetSingleton();
+        jobSystem.ParallelFor(numLeaves, kLeavesPerJob, [&](size_t begin, size_t end)
+        {
+            float values[SPARSE_BRICK_VOXELS];
+            uint64_t activeMask[SPARSE_BRICK_VOXELS / 64];
+            for (size_t l = begin; l != end; ++l)
+            {
+                const uint8_t* pLeaf = pLeaves + l * kLeafSize;
+                memcpy(values, pLeaf + kLeafValues, sizeof(values));
+                memcpy(activeMask, pLeaf + kLeafValueMask, sizeof(activeMask));
+
+                uint8_t* pBrick = &out_data.BrickVoxels[size_t(leafBricks[l]) * SPARSE_BRICK_VOXELS];
+                for (uint32_t n = 0; n != SPARSE_BRICK_VOXELS; ++n)
+                {
+                    if (!remap.KeepInactive && !((activeMask[n >> 6] >> (n & 63)) & 1))
+                        continue;
+
+                    const uint32_t x = n >> 6, y = (n >> 3) & 7, z = n & 7;
+                    pBrick[(z * SPARSE_BRICK_SIZE + y) * SPARSE_BRICK_SIZE + x] = remap.Quantize(values[n]);
+                }
+            }
+        });
+
+        jobSystem.ParallelFor(tileBricks.size(), kTileBricksPerJob, [&](size_t begin, size_t end)
+        {
+            for (size_t t = begin; t != end; ++t)
+                memset(&out_data.BrickVoxels[size_t(tileBricks[t].Brick) * SPARSE_BRICK_VOXELS], tileBricks[t].Value, SPARSE_BRICK_VOXELS);
+        });
+
+        out_data.Finalize();
+
+        stats.NumLeaves = numLeaves;
+        stats.NumTiles = static_cast<uint32_t>(tiles.size());
+        stats.NumVoxels = uint64_t(numLeaves) * SPARSE_BRICK_VOXELS + numTileVoxels;
+        stats.ImportMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        stats.VoxelsPerSecond = stats.ImportMs > 0.0 ? stats.NumVoxels / (stats.ImportMs * 0.001) : 0.0;
+        return true;
+    }
+
+    // FNV-1a over 64-bit words rather than bytes, the byte-wise version costs as much as the import itself
+    uint64_t HashChunk(const uint8_t* pData, size_t size)
+    {
+        uint64_t hash = 0xCBF29CE484222325ull;
+        size_t i = 0;
+        for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+            hash = (hash ^ ReadAt<uint64_t>(pData, i)) * 0x00000100000001B3ull;
+        return fnv1a64_bytes(pData + i, size - i, hash);
+    }
+
+    // The whole file goes into the key, so re-exporting a volume under the same name still invalidates the cache.
+    // Chunks are hashed in parallel and then hashed together with the description.
+    uint64_t HashNanoVDBImport(const uint8_t* pFile, size_t fileSize, const NanoVDBImportDesc& desc)
+    {
+        const size_t numChunks = (fileSize + kHashChunkSize - 1) / kHashChunkSize;
+        std::vector<uint64_t> chunkHashes(numChunks);
+        JobSystem::GetSingleton().ParallelFor(numChunks, 1, [&](size_t begin, size_t end)
+        {
+            for (size_t c = begin; c != end; ++c)
+                chunkHashes[c] = HashChunk(pFile + c * kHashChunkSize, std::min(kHashChunkSize, fileSize - c * kHashChunkSize));
+        });
+
+        uint64_t hash = fnv1a64_bytes(&kImporterVersion, sizeof(kImporterVersion));
+        hash = fnv1a64_bytes(&fileSize, sizeof(fileSize), hash);
+        hash = fnv1a64_bytes(chunkHashes.data(), chunkHashes.size() * sizeof(uint64_t), hash);
+        hash = fnv1a64_bytes(&desc.ValueMin, sizeof(desc.ValueMin), hash);
+        hash = fnv1a64_bytes(&desc.ValueMax, sizeof(desc.ValueMax), hash);
+        hash = fnv1a64_bytes(&desc.DensityScale, sizeof(desc.DensityScale), hash);
+        hash = fnv1a64_bytes(&desc.WorldScale, sizeof(desc.WorldScale), hash);
+        hash = fnv1a64_bytes(desc.WorldOffset, sizeof(desc.WorldOffset), hash);
+        if (desc.GridName)
+            hash = fnv1a64_bytes(desc.GridName, strlen(desc.GridName) + 1, hash);
+        return hash;
+    }
+}
+
+bool ImportNanoVDB(const wchar_t* path, const NanoVDBImportDesc& desc, SparseCloudVolumeData& out_data, NanoVDBImportStats* pStats)
+{
+    MappedFile file;
+    if (!file.Open(path))
+    {
+        Muon::Printf(L"Error: Failed to open %s!\n", path);
+        return false;
+    }
+
+    NanoVDBImportStats stats;
+    const bool succeeded = ImportNanoVDBBuffer(file.GetData(), file.GetSize(), path, desc, out_data, stats);
+    if (pStats)
+        *pStats = stats;
+    return succeeded;
+}
+
+bool ImportNanoVDBCached(const wchar_t* path, const NanoVDBImportDesc& desc, const wchar_t* cachePath, NanoVDBImportStats* pStats)
+{
+    using Clock = std::chrono::high_resolution_clock;
+
+    MappedFile file;
+    if (!file.Open(path))
+    {
+        Muon::Printf(L"Error: Failed to open %s!\n", path);
+        return false;
+    }
+
+    NanoVDBImportStats stats;
+    const Clock::time_point hashStart = Clock::now();
+    const uint64_t hash = HashNanoVDBImport(file.GetData(), file.GetSize(), desc);
+    stats.HashMs = std::chrono::duration<double, std::milli>(Clock::now() - hashStart).count();
+
+    SparseCloudVolumeHeader cached;
+    stats.FromCache = ReadSparseCloudVolumeHeader(cachePath, cached) && cached.SourceHash == hash;
+
+    bool succeeded = stats.FromCache;
+    if (!stats.FromCache)
+    {
+        SparseCloudVolumeData data;
+        if (ImportNanoVDBBuffer(file.GetData(), file.GetSize(), path, desc, data, stats))
+        {
+            const Clock::time_point saveStart = Clock::now();
+            succeeded = SaveSparseCloudVolume(data, cachePath, hash);
+            stats.SaveMs = std::chrono::duration<double, std::milli>(Clock::now() - saveStart).count();
+        }
+    }
+
+    if (pStats)
+        *pStats = stats;
+    return succeeded;
+}
+
+}
@@ -0,0 +1,53 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Converts float grids from NanoVDB files into sparse cloud volumes
+----------------------------------------------*/
+#ifndef MUON_NANOVDBIMPORTER_H
+#define MUON_NANOVDBIMPORTER_H
+
+#include <Core/SparseCloudVolume.h>
+
+#include <stdint.h>
+
+namespace Muon
+{
+
+struct NanoVDBImportDesc
+{
+    const char* GridName = nullptr; // nullptr takes the file's first float grid
+
+    // Grid values are remapped so ValueMin is empty and ValueMax is full, clamped in between. Inactive voxels are skipped,
+    // unless ValueMax is below ValueMin: that inverts the ramp to turn a level set's negative interior into density, and
+    // keeps inactive voxels and tiles, since a level set's interior is only stored as inactive tiles of -background.
+    float ValueMin = 0.0f;
+    float ValueMax = 1.0f;
+    float DensityScale = 1.0f;      // Density of a full voxel
+
+    // Applied on top of the grid's own transform, e.g. to convert from the authoring tool's units
+    float WorldScale = 1.0f;
+    float WorldOffset[3] = {};
+};
+
+struct NanoVDBImportStats
+{
+    bool FromCache = false;
+    uint32_t NumLeaves = 0;
+    uint32_t NumTiles = 0;          // Non-empty internal node tiles, each expanded into full bricks
+    uint64_t NumVoxels = 0;         // Voxels converted from leaves and tiles
+    double HashMs = 0.0;
+    double ImportMs = 0.0;
+    double SaveMs = 0.0;
+    double VoxelsPerSecond = 0.0;   // Of the import alone
+};
+
+// Reads uncompressed .nvdb files of NanoVDB major version 32. Each 8^3 leaf becomes one brick, so the brick grid is aligned
+// to the leaves. The grid's transform has to be a uniform scale and a translation.
+bool ImportNanoVDB(const wchar_t* path, const NanoVDBImportDesc& desc, SparseCloudVolumeData& out_data, NanoVDBImportStats* pStats = nullptr);
+
+// Writes the converted volume to cachePath, unless it already holds a conversion of the same file with the same description
+bool ImportNanoVDBCached(const wchar_t* path, const NanoVDBImportDesc& desc, const wchar_t* cachePath, NanoVDBImportStats* pStats = nullptr);
+
+}
+
+#endif
@@ -0,0 +1,514 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Tiling 3D Perlin, Worley and Perlin-Worley noise volumes for clouds, cached on disk
+----------------------------------------------*/
+#include <Core/NoiseVolume.h>
+
+#include <Core/BinaryStream.h>
+#include <Core/JobSystem.h>
+#include <Core/PathMacros.h>
+#include <Core/Profiler.h>
+#include <Core/SIMD.h>
+#include <Core/hash_util.h>
+#include <Utils/Utils.h>
+
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+
+namespace Muon
+{
+
+namespace
+{
+    using namespace SIMD;
+
+    static const uint32_t kNoiseCacheMagic = 0x564E4E4D; // 'MNNV'
+
+    // Bump whenever the serialized layout, or the noise functions that produce it, change
+    static const uint32_t kNoiseCacheVersion = 1;
+
+    static const uint32_t kMaxVolumeSize = 512;
+    static const uint32_t kMaxLatticePeriod = 128; // Highest octave's frequency. The lattice tables hold period^3 entries.
+    static const size_t kRowsPerJob = 64;
+
+    // Edges of a cube, the gradient set from Perlin's improved noise
+    static const float kGradients[12][3] =
+    {
+        { 1, 1, 0 }, { -1, 1, 0 }, { 1, -1, 0 }, { -1, -1, 0 },
+        { 1, 0, 1 }, { -1, 0, 1 }, { 1, 0, -1 }, { -1, 0, -1 },
+        { 0, 1, 1 }, { 0, -1, 1 }, { 0, 1, -1 }, { 0, -1, -1 },
+    };
+
+    uint32_t Hash(uint32_t x)
+    {
+        x ^= x >> 16;
+        x *= 0x7FEB352Du;
+        x ^= x >> 15;
+        x *= 0x846CA68Bu;
+        x ^= x >> 16;
+        return x;
+    }
+
+    float ToUnitFloat(uint32_t h)
+    {
+        return (h >> 8) * (1.0f / 16777216.0f);
+    }
+
+    uint32_t OctaveSalt(uint32_t seed, uint32_t channel, uint32_t octave, uint32_t type)
+    {
+        return Hash(seed * 0x9E3779B9u ^ (channel + 1) * 0x85EBCA6Bu ^ (octave + 1) * 0xC2B2AE35u ^ type);
+    }
+
+    int32_t Wrap(int32_t i, int32_t period)
+    {
+        const int32_t r = i % period;
+        return r < 0 ? r + period : r;
+    }
+
+    // One gradient per lattice point, wrapping at Period so the noise tiles
+    struct PerlinLattice
+    {
+        uint32_t Period = 0;
+        std::vector<uint8_t> Gradients;
+
+        void Build(uint32_t period, uint32_t salt)
+        {
+            Period = period;
+            Gradients.resize(size_t(period) * period * period);
+            for (uint32_t i = 0; i != Gradients.size(); ++i)
+                Gradients[i] = static_cast<uint8_t>(Hash(i ^ salt) % 12);
+        }
+    };
+
+    // One feature point per cell, as an offset within the cell
+    struct WorleyLattice
+    {
+        uint32_t Period = 0;
+        std::vector<float> X, Y, Z;
+
+        void Build(uint32_t period, uint32_t salt)
+        {
+            Period = period;
+            const size_t count = size_t(period) * period * period;
+            X.resize(count);
+            Y.resize(count);
+            Z.resize(count);
+            for (uint32_t i = 0; i != count; ++i)
+            {
+                const uint32_t h = Hash(i ^ salt);
+                X[i] = ToUnitFloat(h);
+                Y[i] = ToUnitFloat(Hash(h ^ 0x68E31DA4u));
+                Z[i] = ToUnitFloat(Hash(h ^ 0xB5297A4Du));
+            }
+        }
+    };
+
+    struct ChannelLattices
+    {
+        std::vector<PerlinLattice> Perlin;
+        std::vector<WorleyLattice> Worley;
+    };
+
+    float Fade(float t)
+    {
+        return t * t * t * (t * (t * 6.0f - 15.0f) + 10.0f);
+    }
+
+    Float4 Fade4(Float4 t)
+    {
+        const Float4 inner = Add4(Mul4(t, Sub4(Mul4(t, Splat4(6.0f)), Splat4(15.0f))), Splat4(10.0f));
+        return Mul4(Mul4(Mul4(t, t), t), inner);
+    }
+
+    Float4 Lerp4(Float4 a, Float4 b, Float4 t)
+    {
+        return Add4(a, Mul4(Sub4(b, a), t));
+    }
+
+    // Adds amplitude * noise for the voxel centers (x + 0.5, y + 0.5, z + 0.5) of a row, 4 voxels at a time.
+    // The lanes share y and z, so only their x lattice coordinates and gradients differ.
+    void AddPerlinRow(const PerlinLattice& lattice, uint32_t size, uint32_t paddedSize, uint32_t y, uint32_t z, float amplitude, float* pRow)
+    {
+        const int32_t period = static_cast<int32_t>(lattice.Period);
+        const float scale = float(period) / size;
+
+        const float py = (y + 0.5f) * scale;
+        const float pz = (z + 0.5f) * scale;
+        const int32_t iy = static_cast<int32_t>(py);
+        const int32_t iz = static_cast<int32_t>(pz);
+        const float fy = py - iy;
+        const float fz = pz - iz;
+        const Float4 v = Splat4(Fade(fy));
+        const Float4 w = Splat4(Fade(fz));
+
+        // Offsets of the four (y, z) lattice rows the corners come from
+        size_t rowBase[2][2];
+        for (int32_t dz = 0; dz != 2; ++dz)
+        {
+            for (int32_t dy = 0; dy != 2; ++dy)
+                rowBase[dz][dy] = (size_t(Wrap(iz + dz, period)) * period + Wrap(iy + dy, period)) * period;
+        }
+
+        for (uint32_t x0 = 0; x0 < paddedSize; x0 += 4)
+        {
+            int32_t ix[2][4];
+            float fxLanes[4];
+            for (uint32_t l = 0; l != 4; ++l)
+            {
+                const float px = (x0 + l + 0.5f) * scale;
+                const int32_t i = static_cast<int32_t>(px);
+                fxLanes[l] = px - i;
+                ix[0][l] = Wrap(i, period);
+                ix[1][l] = Wrap(i + 1, period);
+            }
+
+            const Float4 fx = Load4(fxLanes);
+            const Float4 u = Fade4(fx);
+
+            Float4 corners[2][2][2];
+            for (int32_t dz = 0; dz != 2; ++dz)
+            {
+                for (int32_t dy = 0; dy != 2; ++dy)
+                {
+                    const uint8_t* pGradients = &lattice.Gradients[rowBase[dz][dy]];
+                    const Float4 ry = Splat4(fy - dy);
+                    const Float4 rz = Splat4(fz - dz);
+                    for (int32_t dx = 0; dx != 2; ++dx)
+                    {
+                        const float* g0 = kGradients[pGradients[ix[dx][0]]];
+                        const float* g1 = kGradients[pGradients[ix[dx][1]]];
+                        const float* g2 = kGradients[pGradients[ix[dx][2]]];
+                        const float* g3 = kGradients[pGradients[ix[dx][3]]];
+
+                        const Float4 gx = Set4(g0[0], g1[0], g2[0], g3[0]);
+                        const Float4 gy = Set4(g0[1], g1[1], g2[1], g3[1]);
+                        const Float4 gz = Set4(g0[2], g1[2], g2[2], g3[2]);
+                        const Float4 rx = Sub4(fx, Splat4(float(dx)));
+                        corners[dz][dy][dx] = Add4(Add4(Mul4(gx, rx), Mul4(gy, ry)), Mul4(gz, rz));
+                    }
+                }
+            }
+
+            const Float4 y0 = Lerp4(Lerp4(corners[0][0][0], corners[0][0][1], u), Lerp4(corners[0][1][0], corners[0][1][1], u), v);
+            const Float4 y1 = Lerp4(Lerp4(corners[1][0][0], corners[1][0][1], u), Lerp4(corners[1][1][0], corners[1][1][1], u), v);
+            const Float4 noise = Lerp4(y0, y1, w);
+
+            Store4(pRow + x0, Add4(Load4(pRow + x0), Mul4(noise, Splat4(amplitude))));
+        }
+    }
+
+    // Adds amplitude * (1 - distance to the nearest feature point, in cells) for a row, 4 voxels at a time.
+    // The lanes share y and z, so each candidate point is one splat. Lanes straddling a cell boundary test the union
+    // of their neighbourhoods, which can only find the same or a nearer point.
+    void AddWorleyRow(const WorleyLattice& lattice, uint32_t size, uint32_t paddedSize, uint32_t y, uint32_t z, float amplitude,
+        std::vector<float>& scratch, float* pRow)
+    {
+        const int32_t period = static_cast<int32_t>(lattice.Period);
+        const float scale = float(period) / size;
+
+        const float py = (y + 0.5f) * scale;
+        const float pz = (z + 0.5f) * scale;
+        const int32_t cy = static_cast<int32_t>(py);
+        const int32_t cz = static_cast<int32_t>(pz);
+
+        // The 9 neighbouring rows of cells only change with y and z, so their points are looked up once per row:
+        // the absolute x of each, and its squared distance to the row in y and z. Cell nx is stored at nx + 1.
+        const int32_t numCells = static_cast<int32_t>(paddedSize * scale) + 3;
+        scratch.resize(size_t(numCells) * 9 * 2);
+        float* pPointX = scratch.data();
+        float* pDistSqYZ = pPointX + size_t(numCells) * 9;
+
+        for (int32_t n = 0; n != 9; ++n)
+        {
+            const int32_t ny = cy + n % 3 - 1;
+            const int32_t nz = cz + n / 3 - 1;
+            const size_t rowBase = (size_t(Wrap(nz, period)) * period + Wrap(ny, period)) * period;
+            for (int32_t c = 0; c != numCells; ++c)
+            {
+                const int32_t nx = c - 1;
+                const size_t i = rowBase + Wrap(nx, period);
+                const float dy = py - (ny + lattice.Y[i]);
+                const float dz = pz - (nz + lattice.Z[i]);
+                pPointX[n * numCells + c] = nx + lattice.X[i];
+                pDistSqYZ[n * numCells + c] = dy * dy + dz * dz;
+            }
+        }
+
+        for (uint32_t x0 = 0; x0 < paddedSize; x0 += 4)
+        {
+            const Float4 px = Mul4(Add4(Splat4(float(x0) + 0.5f), Set4(0.0f, 1.0f, 2.0f, 3.0f)), Splat4(scale));
+
+            // One cell either side of the lanes' own, shifted by the storage offset
+            const int32_t cFirst = static_cast<int32_t>((x0 + 0.5f) * scale);
+            const int32_t cLast = static_cast<int32_t>((x0 + 3.5f) * scale) + 2;
+
+            Float4 minDistSq = Splat4(3.0f);
+            for (int32_t n = 0; n != 9; ++n)
+            {
+                const float* pX = pPointX + n * numCells;
+                const float* pYZ = pDistSqYZ + n * numCells;
+                for (int32_t c = cFirst; c <= cLast; ++c)
+                {
+                    const Float4 dx = Sub4(px, Splat4(pX[c]));
+                    minDistSq = Min4(minDistSq, Add4(Mul4(dx, dx), Splat4(pYZ[c])));
+                }
+            }
+
+            const Float4 cellular = Max4(Sub4(Splat4(1.0f), Sqrt4(minDistSq)), Splat4(0.0f));
+            Store4(pRow + x0, Add4(Load4(pRow + x0), Mul4(cellular, Splat4(amplitude))));
+        }
+    }
+
+    // Amplitudes halve every octave and are normalized to sum to one
+    float OctaveAmplitude(uint32_t octave, uint32_t numOctaves)
+    {
+        const float total = 2.0f - 1.0f / float(1u << (numOctaves - 1));
+        return (1.0f / float(1u << octave)) / total;
+    }
+
+    void PerlinFbmRow(const ChannelLattices& lattices, uint32_t size, uint32_t paddedSize, uint32_t y, uint32_t z, float* pRow)
+    {
+        std::fill(pRow, pRow + paddedSize, 0.0f);
+        const uint32_t numOctaves = static_cast<uint32_t>(lattices.Perlin.size());
+        for (uint32_t o = 0; o != numOctaves; ++o)
+            AddPerlinRow(lattices.Perlin[o], size, paddedSize, y, z, OctaveAmplitude(o, numOctaves), pRow);
+
+        for (uint32_t x = 0; x != paddedSize; ++x)
+            pRow[x] = std::min(std::max(pRow[x] * 0.5f + 0.5f, 0.0f), 1.0f);
+    }
+
+    void WorleyFbmRow(const ChannelLattices& lattices, uint32_t size, uint32_t paddedSize, uint32_t y, uint32_t z, std::vector<float>& scratch, float* pRow)
+    {
+        std::fill(pRow, pRow + paddedSize, 0.0f);
+        const uint32_t numOctaves = static_cast<uint32_t>(lattices.Worley.size());
+        for (uint32_t o = 0; o != numOctaves; ++o)
+            AddWorleyRow(lattices.Worley[o], size, paddedSize, y, z, OctaveAmplitude(o, numOctaves), scratch, pRow);
+    }
+
+    bool ValidateDesc(const NoiseVolumeDesc& desc)
+    {
+        if (desc.Size == 0 || desc.Size > kMaxVolumeSize)
+        {
+            Muon::Printf("Error: Noise volumes must be between 1 and %u voxels across, not %u!\n", kMaxVolumeSize, desc.Size);
+            return false;
+        }
+
+        for (const NoiseChannelDesc& channel : desc.Channels)
+        {
+            if (channel.Type == NoiseType::None)
+                continue;
+
+            if (channel.Frequency == 0 || channel.Octaves == 0 || channel.Octaves > 8 ||
+                (uint64_t(channel.Frequency) << (channel.Octaves - 1)) > kMaxLatticePeriod)
+            {
+                Muon::Printf("Error: Noise channel frequency %u over %u octaves is out of range, the last octave can be at most %u!\n",
+                    channel.Frequency, channel.Octaves, kMaxLatticePeriod);
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    void WriteDesc(BinaryWriter& writer, const NoiseVolumeDesc& desc)
+    {
+        writer.Write(desc.Size);
+        writer.Write(desc.Seed);
+        for (const NoiseChannelDesc& channel : desc.Channels)
+        {
+            writer.Write(channel.Type);
+            writer.Write(channel.Frequency);
+            writer.Write(channel.Octaves);
+        }
+    }
+
+    std::wstring GetNoiseCachePath(const wchar_t* cacheDir, uint64_t hash)
+    {
+        wchar_t fileName[32];
+        swprintf(fileName, 32, L"%016llx.bin", static_cast<unsigned long long>(hash));
+        return std::wstring(cacheDir ? cacheDir : CACHEPATHW L"Noise" PATHSEP) + fileName;
+    }
+
+    bool LoadCachedVolume(const std::wstring& path, uint64_t hash, uint32_t size, NoiseVolume& out_volume)
+    {
+        std::vector<uint8_t> bytes;
+        if (!LoadFileBytes(path.c_str(), bytes))
+            return false;
+
+        BinaryReader reader(bytes.data(), bytes.size());
+        uint32_t magic = 0, version = 0, cachedSize = 0, numBytes = 0;
+        uint64_t cachedHash = 0;
+        reader.Read(magic);
+        reader.Read(version);
+        reader.Read(cachedHash);
+        reader.Read(cachedSize);
+        reader.ReadCount(numBytes);
+
+        if (reader.IsFailed() || magic != kNoiseCacheMagic || version != kNoiseCacheVersion || cachedHash != hash ||
+            cachedSize != size || numBytes != size_t(size) * size * size * 4)
+            return false;
+
+        out_volume.Size = size;
+        out_volume.Voxels.resize(numBytes);
+        return reader.ReadBytes(out_volume.Voxels.data(), numBytes) && reader.IsAtEnd();
+    }
+}
+
+NoiseVolumeDesc GetCloudShapeNoiseDesc(uint32_t size)
+{
+    NoiseVolumeDesc desc;
+    desc.Size = size;
+    desc.Channels[0] = { NoiseType::PerlinWorley, 4, 3 };
+    desc.Channels[1] = { NoiseType::Worley, 4, 3 };
+    desc.Channels[2] = { NoiseType::Worley, 8, 3 };
+    desc.Channels[3] = { NoiseType::Worley, 16, 3 };
+    return desc;
+}
+
+NoiseVolumeDesc GetCloudDetailNoiseDesc(uint32_t size)
+{
+    NoiseVolumeDesc desc;
+    desc.Size = size;
+    desc.Channels[0] = { NoiseType::Worley, 2, 3 };
+    desc.Channels[1] = { NoiseType::Worley, 4, 3 };
+    desc.Channels[2] = { NoiseType::Worley, 8, 3 };
+    return desc;
+}
+
+NoiseVolumeDesc GetCloudWeatherNoiseDesc(uint32_t size)
+{
+    NoiseVolumeDesc desc;
+    desc.Size = size;
+    desc.Channels[0] = { NoiseType::Perlin, 4, 3 };
+    desc.Channels[1] = { NoiseType::Perlin, 2, 2 };
+    return desc;
+}
+
+uint64_t HashNoiseVolumeDesc(const NoiseVolumeDesc& desc)
+{
+    BinaryWriter writer;
+    writer.Write(kNoiseCacheVersion);
+    WriteDesc(writer, desc);
+    return fnv1a64_bytes(writer.GetBuffer().data(), writer.GetBuffer().size());
+}
+
+bool GenerateNoiseVolume(const NoiseVolumeDesc& desc, NoiseVolume& out_volume)
+{
+    MUON_PROFILE_SCOPE("Generate Noise Volume");
+    if (!ValidateDesc(desc))
+        return false;
+
+    const uint32_t size = desc.Size;
+    const uint32_t paddedSize = (size + 3) & ~3u;
+
+    // Built up front so the rows only read them
+    ChannelLattices lattices[4];
+    for (uint32_t c = 0; c != 4; ++c)
+    {
+        const NoiseChannelDesc& channel = desc.Channels[c];
+        const bool usesPerlin = channel.Type == NoiseType::Perlin || channel.Type == NoiseType::PerlinWorley;
+        const bool usesWorley = channel.Type == NoiseType::Worley || channel.Type == NoiseType::PerlinWorley;
+
+        for (uint32_t o = 0; o != channel.Octaves; ++o)
+        {
+            const uint32_t period = channel.Frequency << o;
+            if (usesPerlin)
+            {
+                lattices[c].Perlin.emplace_back();
+                lattices[c].Perlin.back().Build(period, OctaveSalt(desc.Seed, c, o, 0));
+            }
+            if (usesWorley)
+            {
+                lattices[c].Worley.emplace_back();
+                lattices[c].Worley.back().Build(period, OctaveSalt(desc.Seed, c, o, 1));
+            }
+        }
+    }
+
+    out_volume.Size = size;
+    out_volume.Voxels.assign(size_t(size) * size * size * 4, 0);
+
+    const size_t numRows = size_t(size) * size;
+    JobSystem::GetSingleton().ParallelFor(numRows, kRowsPerJob, [&](size_t begin, size_t end)
+    {
+        std::vector<float> row(paddedSize);
+        std::vector<float> worleyRow(paddedSize);
+        std::vector<float> scratch;
+
+        for (size_t r = begin; r != end; ++r)
+        {
+            const uint32_t y = static_cast<uint32_t>(r % size);
+            const uint32_t z = static_cast<uint32_t>(r / size);
+            uint8_t* pOut = &out_volume.Voxels[r * size * 4];
+
+            for (uint32_t c = 0; c != 4; ++c)
+            {
+                switch (desc.Channels[c].Type)
+                {
+                case NoiseType::None:
+                    continue;
+                case NoiseType::Perlin:
+                    PerlinFbmRow(lattices[c], size, paddedSize, y, z, row.data());
+                    break;
+                case NoiseType::Worley:
+                    WorleyFbmRow(lattices[c], size, paddedSize, y, z, scratch, row.data());
+                    break;
+                case NoiseType::PerlinWorley:
+                    // Remapping Perlin from [0, 1] to [worley, 1] keeps its billows but rounds them off with cells
+                    PerlinFbmRow(lattices[c], size, paddedSize, y, z, row.data());
+                    WorleyFbmRow(lattices[c], size, paddedSize, y, z, scratch, worleyRow.data());
+                    for (uint32_t x = 0; x != size; ++x)
+                        row[x] = worleyRow[x] + row[x] * (1.0f - worleyRow[x]);
+                    break;
+                }
+
+                for (uint32_t x = 0; x != size; ++x)
+                    pOut[x * 4 + c] = static_cast<uint8_t>(std::min(std::max(row[x], 0.0f), 1.0f) * 255.0f + 0.5f);
+            }
+        }
+    });
+
+    return true;
+}
+
+bool LoadOrGenerateNoiseVolume(const NoiseVolumeDesc& desc, NoiseVolume& out_volume, NoiseVolumeStats* pStats, const wchar_t* cacheDir)
+{
+    using Clock = std::chrono::high_resolution_clock;
+
+    NoiseVolumeStats stats;
+    const uint64_t hash = HashNoiseVolumeDesc(desc);
+    const std::wstring cachePath = GetNoiseCachePath(cacheDir, hash);
+
+    const Clock::time_point loadStart = Clock::now();
+    stats.FromCache = LoadCachedVolume(cachePath, hash, desc.Size, out_volume);
+    stats.LoadMs = std::chrono::duration<double, std::milli>(Clock::now() - loadStart).count();
+
+    bool success = stats.FromCache;
+    if (!success)
+    {
+        const Clock::time_point generateStart = Clock::now();
+        success = GenerateNoiseVolume(desc, out_volume);
+        stats.GenerateMs = std::chrono::duration<double, std::milli>(Clock::now() - generateStart).count();
+
+        if (success)
+        {
+            BinaryWriter writer;
+            writer.Write(kNoiseCacheMagic);
+            writer.Write(kNoiseCacheVersion);
+            writer.Write(hash);
+            writer.Write(out_volume.Size);
+            writer.Write(static_cast<uint32_t>(out_volume.Voxels.size()));
+            writer.WriteBytes(out_volume.Voxels.data(), out_volume.Voxels.size());
+            if (!writer.SaveToFile(cachePath.c_str()))
+                Muon::Printf(L"Warning: Failed to cache noise volume %s!\n", cachePath.c_str());
+        }
+    }
+
+    if (pStats)
+        *pStats = stats;
+    return success;
+}
+
+}
@@ -0,0 +1,73 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Tiling 3D Perlin, Worley and Perlin-Worley noise volumes for clouds, cached on disk
+----------------------------------------------*/
+#ifndef MUON_NOISEVOLUME_H
+#define MUON_NOISEVOLUME_H
+
+#include <stdint.h>
+#include <vector>
+
+namespace Muon
+{
+
+enum class NoiseType : uint32_t
+{
+    None,         // Channel is left at zero
+    Perlin,       // Gradient noise fBm, remapped to [0, 1]
+    Worley,       // Inverted cellular (F1) noise fBm, 1 at the feature points
+    PerlinWorley, // Perlin fBm dilated by Worley fBm of the same frequency, the usual cloud base shape
+};
+
+// Frequency is in lattice cells across the whole volume, and doubles with every octave. Being a whole number is what makes the volume tile.
+struct NoiseChannelDesc
+{
+    NoiseType Type = NoiseType::None;
+    uint32_t Frequency = 4;
+    uint32_t Octaves = 3;
+};
+
+// Always RGBA8, one channel description per component
+struct NoiseVolumeDesc
+{
+    uint32_t Size = 128; // Voxels along each axis
+    uint32_t Seed = 0;
+    NoiseChannelDesc Channels[4];
+};
+
+// R: Perlin-Worley, GBA: Worley fBm at increasing frequencies. Sampled for the coarse cloud shape.
+NoiseVolumeDesc GetCloudShapeNoiseDesc(uint32_t size = 128);
+
+// RGB: Worley fBm at increasing frequencies. Sampled at a higher frequency to erode the shape's edges.
+NoiseVolumeDesc GetCloudDetailNoiseDesc(uint32_t size = 32);
+
+// R: coverage, G: cloud type, both Perlin fBm. Laid flat over the sky in x and z, the third axis is walked over time to evolve the weather.
+NoiseVolumeDesc GetCloudWeatherNoiseDesc(uint32_t size = 64);
+
+// Voxels are RGBA8, with x varying fastest, then y, then z. That's the layout a 3D texture upload expects.
+struct NoiseVolume
+{
+    uint32_t Size = 0;
+    std::vector<uint8_t> Voxels;
+};
+
+struct NoiseVolumeStats
+{
+    bool FromCache = false;
+    double GenerateMs = 0.0; // Zero on a cache hit
+    double LoadMs = 0.0;     // Reading the cache, or failing to
+};
+
+uint64_t HashNoiseVolumeDesc(const NoiseVolumeDesc& desc);
+
+// Rows of voxels are spread across the job system, and every row is evaluated 4 voxels at a time
+bool GenerateNoiseVolume(const NoiseVolumeDesc& desc, NoiseVolume& out_volume);
+
+// Loads the volume from cacheDir if one was generated from the same description before, otherwise generates and caches it.
+// cacheDir = nullptr uses the default cache folder.
+bool LoadOrGenerateNoiseVolume(const NoiseVolumeDesc& desc, NoiseVolume& out_volume, NoiseVolumeStats* pStats = nullptr, const wchar_t* cacheDir = nullptr);
+
+}
+
+#endif
@@ -0,0 +1,536 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : CPU software depth rasterizer and hierarchical depth tests for occlusion culling
+----------------------------------------------*/
+#include <Core/OcclusionCuller.h>
+
+#include <Core/Culling.h>
+#include <Core/JobSystem.h>
+#include <Core/Profiler.h>
+#include <Core/SIMD.h>
+#include <Utils/Utils.h>
+
+#include <algorithm>
+#include <chrono>
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+namespace Muon
+{
+using namespace SIMD;
+
+namespace
+{
+    static const uint32_t kTileSize = 4;
+    static const uint32_t kTilePixels = kTileSize * kTileSize;
+    static const uint32_t kBinsX = 4;
+    static const uint32_t kBinsY = 4;
+
+    // Finer pyramid levels tried after the first inconclusive one
+    static const uint32_t kMaxRefinements = 2;
+
+    static const size_t kMinBoxesPerJob = 512;
+
+    static const uint32_t CLIP_LEFT = 1u << 0;
+    static const uint32_t CLIP_RIGHT = 1u << 1;
+    static const uint32_t CLIP_BOTTOM = 1u << 2;
+    static const uint32_t CLIP_TOP = 1u << 3;
+    static const uint32_t CLIP_FAR = 1u << 4;
+
+    void MultiplyMatrices(const float a[16], const float b[16], float out[16])
+    {
+        for (uint32_t r = 0; r != 4; ++r)
+        {
+            for (uint32_t c = 0; c != 4; ++c)
+                out[r * 4 + c] = a[r * 4 + 0] * b[0 * 4 + c] + a[r * 4 + 1] * b[1 * 4 + c] + a[r * 4 + 2] * b[2 * 4 + c] + a[r * 4 + 3] * b[3 * 4 + c];
+        }
+    }
+
+    void TransformPoint(const float m[16], float x, float y, float z, float out[4])
+    {
+        for (uint32_t c = 0; c != 4; ++c)
+            out[c] = x * m[0 * 4 + c] + y * m[1 * 4 + c] + z * m[2 * 4 + c] + m[3 * 4 + c];
+    }
+
+    uint32_t Outcode(const float v[4])
+    {
+        return (v[0] < -v[3] ? CLIP_LEFT : 0u) | (v[0] > v[3] ? CLIP_RIGHT : 0u) |
+               (v[1] < -v[3] ? CLIP_BOTTOM : 0u) | (v[1] > v[3] ? CLIP_TOP : 0u) |
+               (v[2] > v[3] ? CLIP_FAR : 0u);
+    }
+}
+
+bool InitOccluderMesh(OccluderMesh& out_mesh, const void* vertexData, uint32_t numVertices, uint32_t vertexStride, uint32_t positionOffset,
+    const uint32_t* pIndices, uint32_t numIndices)
+{
+    if (!vertexData || !pIndices || numIndices % 3 != 0)
+    {
+        Muon::Print("Error: Occluder meshes need vertices and a triangle list of indices!\n");
+        return false;
+    }
+
+    out_mesh.Positions.resize(size_t(numVertices) * 3);
+    const uint8_t* pVertex = static_cast<const uint8_t*>(vertexData) + positionOffset;
+    for (uint32_t i = 0; i != numVertices; ++i, pVertex += vertexStride)
+        memcpy(&out_mesh.Positions[size_t(i) * 3], pVertex, 3 * sizeof(float));
+
+    for (uint32_t i = 0; i != numIndices; ++i)
+    {
+        if (pIndices[i] >= numVertices)
+        {
+            Muon::Printf("Error: Occluder index %u is out of range of %u vertices!\n", pIndices[i], numVertices);
+            return false;
+        }
+    }
+
+    out_mesh.Indices.assign(pIndices, pIndices + numIndices);
+    return true;
+}
+
+bool OcclusionCuller::Init(uint32_t width, uint32_t height)
+{
+    const uint32_t binWidth = kTileSize * kBinsX;
+    const uint32_t binHeight = kTileSize * kBinsY;
+    if (width == 0 || height == 0)
+    {
+        Muon::Print("Error: Occlusion buffer needs a nonzero size!\n");
+        return false;
+    }
+
+    mWidth = (width + binWidth - 1) / binWidth * binWidth;
+    mHeight = (height + binHeight - 1) / binHeight * binHeight;
+    mTilesX = mWidth / kTileSize;
+    mTilesY = mHeight / kTileSize;
+    mDepth.assign(size_t(mWidth) * mHeight, 1.0f);
+
+    mHiZ.clear();
+    uint32_t levelWidth = mTilesX;
+    uint32_t levelHeight = mTilesY;
+    for (;;)
+    {
+        HiZLevel level;
+        level.Width = levelWidth;
+        level.Height = levelHeight;
+        level.MinDepth.assign(size_t(levelWidth) * levelHeight, 1.0f);
+        level.MaxDepth.assign(size_t(levelWidth) * levelHeight, 1.0f);
+        mHiZ.push_back(std::move(level));
+
+        if (levelWidth == 1 && levelHeight == 1)
+            break;
+        levelWidth = (levelWidth + 1) / 2;
+        levelHeight = (levelHeight + 1) / 2;
+    }
+
+    return true;
+}
+
+void OcclusionCuller::Destroy()
+{
+    mDepth.clear();
+    mHiZ.clear();
+    mOccluders.clear();
+    mChunkTriangles.clear();
+    mWidth = mHeight = mTilesX = mTilesY = 0;
+}
+
+void OcclusionCuller::BeginFrame(const float viewProj[16])
+{
+    memcpy(mViewProj, viewProj, sizeof(mViewProj));
+    mOccluders.clear();
+    mStats = {};
+}
+
+void OcclusionCuller::AddOccluder(const OccluderMesh* pMesh, const float world[16])
+{
+    Occluder occluder;
+    occluder.pMesh = pMesh;
+    MultiplyMatrices(world, mViewProj, occluder.WorldViewProj);
+    mOccluders.push_back(occluder);
+}
+
+void OcclusionCuller::RenderOccluders()
+{
+    MUON_PROFILE_SCOPE("Occlusion Raster");
+    using Clock = std::chrono::high_resolution_clock;
+    const Clock::time_point rasterStart = Clock::now();
+
+    JobSystem& jobs = JobSystem::GetSingleton();
+
+    // Setup jobs each fill their own triangle list, so the bins can read them all without locking
+    const uint32_t numChunks = std::max<uint32_t>(1, std::min<uint32_t>(jobs.GetNumThreads(), static_cast<uint32_t>(mOccluders.size())));
+    const size_t occludersPerChunk = (mOccluders.size() + numChunks - 1) / numChunks;
+    mChunkTriangles.resize(numChunks);
+    jobs.ParallelFor(numChunks, 1, [&](size_t chunkBegin, size_t chunkEnd)
+    {
+        for (size_t c = chunkBegin; c != chunkEnd; ++c)
+        {
+            std::vector<Triangle>& triangles = mChunkTriangles[c];
+            triangles.clear();
+
+            const size_t end = std::min(mOccluders.size(), (c + 1) * occludersPerChunk);
+            for (size_t i = c * occludersPerChunk; i < end; ++i)
+                SetupTriangles(mOccluders[i], triangles);
+        }
+    });
+
+    jobs.ParallelFor(kBinsX * kBinsY, 1, [this](size_t binBegin, size_t binEnd)
+    {
+        for (size_t bin = binBegin; bin != binEnd; ++bin)
+            RasterizeBin(static_cast<uint32_t>(bin));
+    });
+
+    BuildHiZ();
+
+    mStats.NumOccluders = static_cast<uint32_t>(mOccluders.size());
+    mStats.NumTriangles = 0;
+    for (const std::vector<Triangle>& triangles : mChunkTriangles)
+        mStats.NumTriangles += static_cast<uint32_t>(triangles.size());
+    mStats.RasterMs = std::chrono::duration<double, std::milli>(Clock::now() - rasterStart).count();
+}
+
+void OcclusionCuller::SetupTriangles(const Occluder& occluder, std::vector<Triangle>& out_triangles) const
+{
+    const OccluderMesh& mesh = *occluder.pMesh;
+    const size_t numVertices = mesh.Positions.size() / 3;
+
+    static thread_local std::vector<float> clipPositions;
+    static thread_local std::vector<uint32_t> outcodes;
+    clipPositions.resize(numVertices * 4);
+    outcodes.resize(numVertices);
+    for (size_t v = 0; v != numVertices; ++v)
+    {
+        TransformPoint(occluder.WorldViewProj, mesh.Positions[v * 3 + 0], mesh.Positions[v * 3 + 1], mesh.Positions[v * 3 + 2], &clipPositions[v * 4]);
+        outcodes[v] = Outcode(&clipPositions[v * 4]);
+    }
+
+    for (size_t i = 0; i + 2 < mesh.Indices.size(); i += 3)
+    {
+        const uint32_t i0 = mesh.Indices[i], i1 = mesh.Indices[i + 1], i2 = mesh.Indices[i + 2];
+        if (outcodes[i0] & outcodes[i1] & outcodes[i2])
+            continue;
+
+        float clip[3][4];
+        memcpy(clip[0], &clipPositions[size_t(i0) * 4], sizeof(clip[0]));
+        memcpy(clip[1], &clipPositions[size_t(i1) * 4], sizeof(clip[1]));
+        memcpy(clip[2], &clipPositions[size_t(i2) * 4], sizeof(clip[2]));
+
+        const bool inFront[3] = { clip[0][2] >= 0.0f, clip[1][2] >= 0.0f, clip[2][2] >= 0.0f };
+        if (inFront[0] && inFront[1] && inFront[2])
+        {
+            EmitTriangle(clip, out_triangles);
+            continue;
+        }
+        if (!inFront[0] && !inFront[1] && !inFront[2])
+            continue;
+
+        // Clip against the near plane, z >= 0 in D3D clip space. A triangle crossing it becomes one or two.
+        float polygon[4][4];
+        uint32_t numPolygon = 0;
+        for (uint32_t e = 0; e != 3; ++e)
+        {
+            const float* a = clip[e];
+            const float* b = clip[(e + 1) % 3];
+            if (inFront[e])
+                memcpy(polygon[numPolygon++], a, sizeof(polygon[0]));
+
+            if (inFront[e] != inFront[(e + 1) % 3])
+            {
+                const float t = a[2] / (a[2] - b[2]);
+                for (uint32_t c = 0; c != 4; ++c)
+                    polygon[numPolygon][c] = a[c] + t * (b[c] - a[c]);
+                numPolygon++;
+            }
+        }
+
+        for (uint32_t v = 1; v + 1 < numPolygon; ++v)
+        {
+            float fan[3][4];
+            memcpy(fan[0], polygon[0], sizeof(fan[0]));
+            memcpy(fan[1], polygon[v], sizeof(fan[1]));
+            memcpy(fan[2], polygon[v + 1], sizeof(fan[2]));
+            EmitTriangle(fan, out_triangles);
+        }
+    }
+}
+
+// Both windings are kept. Occluders are drawn for depth only, and the nearer faces win the min regardless.
+void OcclusionCuller::EmitTriangle(const float clip[3][4], std::vector<Triangle>& out_triangles) const
+{
+    float x[3], y[3], z[3];
+    for (uint32_t v = 0; v != 3; ++v)
+    {
+        const float invW = 1.0f / clip[v][3];
+        x[v] = (clip[v][0] * invW * 0.5f + 0.5f) * mWidth;
+        y[v] = (0.5f - clip[v][1] * invW * 0.5f) * mHeight;
+        z[v] = clip[v][2] * invW;
+    }
+
+    float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+    if (fabsf(area) < 1e-6f)
+        return;
+
+    if (area < 0.0f)
+    {
+        std::swap(x[1], x[2]);
+        std::swap(y[1], y[2]);
+        std::swap(z[1], z[2]);
+        area = -area;
+    }
+
+    const float minX = std::min(std::min(x[0], x[1]), x[2]);
+    const float maxX = std::max(std::max(x[0], x[1]), x[2]);
+    const float minY = std::min(std::min(y[0], y[1]), y[2]);
+    const float maxY = std::max(std::max(y[0], y[1]), y[2]);
+
+    // Pixel centers sit at +0.5, so these are the first and last pixels whose centers can be inside
+    Triangle tri;
+    tri.MinX = static_cast<int32_t>(std::max(ceilf(minX - 0.5f), 0.0f));
+    tri.MinY = static_cast<int32_t>(std::max(ceilf(minY - 0.5f), 0.0f));
+    tri.MaxX = static_cast<int32_t>(std::min(floorf(maxX - 0.5f), float(mWidth - 1)));
+    tri.MaxY = static_cast<int32_t>(std::min(floorf(maxY - 0.5f), float(mHeight - 1)));
+    if (tri.MinX > tri.MaxX || tri.MinY > tri.MaxY)
+        return;
+
+    // Edge e runs from vertex e to the next, and is zero along it
+    for (uint32_t e = 0; e != 3; ++e)
+    {
+        const uint32_t next = (e + 1) % 3;
+        tri.EdgeA[e] = y[e] - y[next];
+        tri.EdgeB[e] = x[next] - x[e];
+        tri.EdgeC[e] = -(tri.EdgeA[e] * x[e] + tri.EdgeB[e] * y[e]);
+    }
+
+    // The edge opposite a vertex, over the area, is that vertex's barycentric weight. z/w is linear in screen space.
+    const float invArea = 1.0f / area;
+    const float dz1 = (z[1] - z[0]) * invArea;
+    const float dz2 = (z[2] - z[0]) * invArea;
+    tri.DepthA = dz1 * tri.EdgeA[2] + dz2 * tri.EdgeA[0];
+    tri.DepthB = dz1 * tri.EdgeB[2] + dz2 * tri.EdgeB[0];
+    tri.DepthC = z[0] + dz1 * tri.EdgeC[2] + dz2 * tri.EdgeC[0];
+
+    out_triangles.push_back(tri);
+}
+
+void OcclusionCuller::RasterizeBin(uint32_t bin)
+{
+    MUON_PROFILE_SCOPE("Occlusion Raster Bin");
+    const uint32_t tilesPerBinX = mTilesX / kBinsX;
+    const uint32_t tilesPerBinY = mTilesY / kBinsY;
+    const uint32_t tileX0 = (bin % kBinsX) * tilesPerBinX;
+    const uint32_t tileY0 = (bin / kBinsX) * tilesPerBinY;
+    const uint32_t tileX1 = tileX0 + tilesPerBinX;
+    const uint32_t tileY1 = tileY0 + tilesPerBinY;
+
+    for (uint32_t ty = tileY0; ty != tileY1; ++ty)
+        std::fill_n(&mDepth[(size_t(ty) * mTilesX + tileX0) * kTilePixels], size_t(tilesPerBinX) * kTilePixels, 1.0f);
+
+    const int32_t binMinX = tileX0 * kTileSize, binMaxX = tileX1 * kTileSize - 1;
+    const int32_t binMinY = tileY0 * kTileSize, binMaxY = tileY1 * kTileSize - 1;
+    const Float4 laneOffsets = Set4(0.5f, 1.5f, 2.5f, 3.5f);
+    const Float4 zero = Splat4(0.0f);
+
+    for (const std::vector<Triangle>& triangles : mChunkTriangles)
+    {
+        for (const Triangle& tri : triangles)
+        {
+            const int32_t minX = std::max(tri.MinX, binMinX), maxX = std::min(tri.MaxX, binMaxX);
+            const int32_t minY = std::max(tri.MinY, binMinY), maxY = std::min(tri.MaxY, binMaxY);
+            if (minX > maxX || minY > maxY)
+                continue;
+
+            const Float4 edgeA0 = Splat4(tri.EdgeA[0]), edgeA1 = Splat4(tri.EdgeA[1]), edgeA2 = Splat4(tri.EdgeA[2]);
+            const Float4 depthA = Splat4(tri.DepthA);
+
+            for (int32_t ty = minY / kTileSize; ty <= maxY / int32_t(kTileSize); ++ty)
+            {
+                for (int32_t tx = minX / kTileSize; tx <= maxX / int32_t(kTileSize); ++tx)
+                {
+                    float* pTile = &mDepth[(size_t(ty) * mTilesX + tx) * kTilePixels];
+                    const Float4 px = Add4(Splat4(float(tx * kTileSize)), laneOffsets);
+                    const Float4 e0x = Mul4(edgeA0, px), e1x = Mul4(edgeA1, px), e2x = Mul4(edgeA2, px);
+                    const Float4 zx = Mul4(depthA, px);
+
+                    for (uint32_t row = 0; row != kTileSize; ++row)
+                    {
+                        const int32_t y = ty * kTileSize + row;
+                        if (y < minY || y > maxY)
+                            continue;
+
+                        // Row terms are scalar, only x varies across the lanes
+                        const float py = y + 0.5f;
+                        const Float4 e0 = Add4(e0x, Splat4(tri.EdgeB[0] * py + tri.EdgeC[0]));
+                        const Float4 e1 = Add4(e1x, Splat4(tri.EdgeB[1] * py + tri.EdgeC[1]));
+                        const Float4 e2 = Add4(e2x, Splat4(tri.EdgeB[2] * py + tri.EdgeC[2]));
+                        const Float4 inside = And4(And4(GreaterEqual4(e0, zero), GreaterEqual4(e1, zero)), GreaterEqual4(e2, zero));
+                        if (!MoveMask4(inside))
+                            continue;
+
+                        const Float4 z = Add4(zx, Splat4(tri.DepthB * py + tri.DepthC));
+                        float* pRow = pTile + row * kTileSize;
+                        const Float4 depth = Load4(pRow);
+                        Store4(pRow, Select4(inside, Min4(depth, z), depth));
+                    }
+                }
+            }
+        }
+    }
+
+    // The bin's part of the pyramid's base
+    HiZLevel& base = mHiZ[0];
+    for (uint32_t ty = tileY0; ty != tileY1; ++ty)
+    {
+        for (uint32_t tx = tileX0; tx != tileX1; ++tx)
+        {
+            const float* pTile = &mDepth[(size_t(ty) * mTilesX + tx) * kTilePixels];
+            Float4 tileMin = Load4(pTile), tileMax = tileMin;
+            for (uint32_t row = 1; row != kTileSize; ++row)
+            {
+                const Float4 depth = Load4(pTile + row * kTileSize);
+                tileMin = Min4(tileMin, depth);
+                tileMax = Max4(tileMax, depth);
+            }
+
+            float mins[4], maxs[4];
+            Store4(mins, tileMin);
+            Store4(maxs, tileMax);
+            base.MinDepth[size_t(ty) * mTilesX + tx] = std::min(std::min(mins[0], mins[1]), std::min(mins[2], mins[3]));
+            base.MaxDepth[size_t(ty) * mTilesX + tx] = std::max(std::max(maxs[0], maxs[1]), std::max(maxs[2], maxs[3]));
+        }
+    }
+}
+
+void OcclusionCuller::BuildHiZ()
+{
+    for (size_t l = 1; l < mHiZ.size(); ++l)
+    {
+        const HiZLevel& src = mHiZ[l - 1];
+        HiZLevel& dst = mHiZ[l];
+        for (uint32_t y = 0; y != dst.Height; ++y)
+        {
+            const uint32_t y0 = y * 2, y1 = std::min(y * 2 + 1, src.Height - 1);
+            for (uint32_t x = 0; x != dst.Width; ++x)
+            {
+                const uint32_t x0 = x * 2, x1 = std::min(x * 2 + 1, src.Width - 1);
+                const size_t i00 = size_t(y0) * src.Width + x0, i01 = size_t(y0) * src.Width + x1;
+                const size_t i10 = size_t(y1) * src.Width + x0, i11 = size_t(y1) * src.Width + x1;
+                dst.MinDepth[size_t(y) * dst.Width + x] = std::min(std::min(src.MinDepth[i00], src.MinDepth[i01]), std::min(src.MinDepth[i10], src.MinDepth[i11]));
+                dst.MaxDepth[size_t(y) * dst.Width + x] = std::max(std::max(src.MaxDepth[i00], src.MaxDepth[i01]), std::max(src.MaxDepth[i10], src.MaxDepth[i11]));
+            }
+        }
+    }
+}
+
+// Starts at the level where the box's screen rectangle spans at most 2x2 texels. The box is hidden if it's behind
+// every texel's max depth, and visible as soon as it's in front of some texel's min. Anything in between is
+// retried at finer levels, where the rectangle covers less of what it doesn't overlap.
+bool OcclusionCuller::IsBoxVisible(const float center[3], const float extents[3]) const
+{
+    if (mHiZ.empty())
+        return true;
+
+    float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX, nearestZ = FLT_MAX;
+    for (uint32_t corner = 0; corner != 8; ++corner)
+    {
+        float clip[4];
+        TransformPoint(mViewProj,
+            center[0] + ((corner & 1) ? extents[0] : -extents[0]),
+            center[1] + ((corner & 2) ? extents[1] : -extents[1]),
+            center[2] + ((corner & 4) ? extents[2] : -extents[2]), clip);
+
+        // Crossing the near plane, the projected rectangle would be meaningless
+        if (clip[2] < 0.0f || clip[3] <= 0.0f)
+            return true;
+
+        const float invW = 1.0f / clip[3];
+        const float sx = (clip[0] * invW * 0.5f + 0.5f) * mWidth;
+        const float sy = (0.5f - clip[1] * invW * 0.5f) * mHeight;
+        minX = std::min(minX, sx);
+        maxX = std::max(maxX, sx);
+        minY = std::min(minY, sy);
+        maxY = std::max(maxY, sy);
+        nearestZ = std::min(nearestZ, clip[2] * invW);
+    }
+
+    // Off screen boxes are left to frustum culling
+    if (maxX < 0.0f || maxY < 0.0f || minX >= float(mWidth) || minY >= float(mHeight))
+        return true;
+
+    const uint32_t tileX0 = static_cast<uint32_t>(std::max(minX, 0.0f)) / kTileSize;
+    const uint32_t tileY0 = static_cast<uint32_t>(std::max(minY, 0.0f)) / kTileSize;
+    const uint32_t tileX1 = std::min(static_cast<uint32_t>(maxX), mWidth - 1) / kTileSize;
+    const uint32_t tileY1 = std::min(static_cast<uint32_t>(maxY), mHeight - 1) / kTileSize;
+
+    uint32_t level = 0;
+    while (level + 1 < mHiZ.size() && ((tileX1 >> level) - (tileX0 >> level) > 1 || (tileY1 >> level) - (tileY0 >> level) > 1))
+        level++;
+
+    const uint32_t lastLevel = level > kMaxRefinements ? level - kMaxRefinements : 0;
+    for (;; --level)
+    {
+        const HiZLevel& hiz = mHiZ[level];
+        bool inconclusive = false;
+        for (uint32_t y = tileY0 >> level; y <= (tileY1 >> level); ++y)
+        {
+            for (uint32_t x = tileX0 >> level; x <= (tileX1 >> level); ++x)
+            {
+                const size_t texel = size_t(y) * hiz.Width + x;
+                if (nearestZ <= hiz.MinDepth[texel])
+                    return true;
+                inconclusive |= nearestZ <= hiz.MaxDepth[texel];
+            }
+        }
+
+        if (!inconclusive)
+            return false;
+        if (level == lastLevel)
+            return true;
+    }
+}
+
+void OcclusionCuller::CullBoxes(const BoundingBoxesSoA& boxes, const std::vector<uint32_t>& candidates, std::vector<uint32_t>& out_visible)
+{
+    MUON_PROFILE_SCOPE("Occlusion Cull Boxes");
+    using Clock = std::chrono::high_resolution_clock;
+    const Clock::time_point testStart = Clock::now();
+
+    // Flags rather than indices, so the jobs never write to the same place
+    std::vector<uint8_t>& visible = mVisibleFlags;
+    visible.resize(candidates.size());
+
+    auto testRange = [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i != end; ++i)
+        {
+            const uint32_t box = candidates[i];
+            const float center[3] = { boxes.CenterX[box], boxes.CenterY[box], boxes.CenterZ[box] };
+            const float extents[3] = { boxes.ExtentX[box], boxes.ExtentY[box], boxes.ExtentZ[box] };
+            visible[i] = IsBoxVisible(center, extents) ? 1 : 0;
+        }
+    };
+
+    if (candidates.size() < 2 * kMinBoxesPerJob)
+        testRange(0, candidates.size());
+    else
+        JobSystem::GetSingleton().ParallelFor(candidates.size(), kMinBoxesPerJob, testRange);
+
+    out_visible.clear();
+    for (size_t i = 0; i != candidates.size(); ++i)
+    {
+        if (visible[i])
+            out_visible.push_back(candidates[i]);
+    }
+
+    mStats.NumTested = static_cast<uint32_t>(candidates.size());
+    mStats.NumOccluded = static_cast<uint32_t>(candidates.size() - out_visible.size());
+    mStats.TestMs = std::chrono::duration<double, std::milli>(Clock::now() - testStart).count();
+}
+
+float OcclusionCuller::GetPixelDepth(uint32_t x, uint32_t y) const
+{
+    const size_t tile = size_t(y / kTileSize) * mTilesX + x / kTileSize;
+    return mDepth[tile * kTilePixels + (y % kTileSize) * kTileSize + x % kTileSize];
+}
+
+}
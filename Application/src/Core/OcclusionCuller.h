@@ -0,0 +1,112 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : CPU software depth rasterizer and hierarchical depth tests for occlusion culling
+----------------------------------------------*/
+#ifndef MUON_OCCLUSIONCULLER_H
+#define MUON_OCCLUSIONCULLER_H
+
+#include <stdint.h>
+#include <vector>
+
+namespace Muon
+{
+struct BoundingBoxesSoA;
+
+// CPU copy of the triangles a mesh contributes as an occluder
+struct OccluderMesh
+{
+    std::vector<float> Positions; // xyz
+    std::vector<uint32_t> Indices;
+};
+
+bool InitOccluderMesh(OccluderMesh& out_mesh, const void* vertexData, uint32_t numVertices, uint32_t vertexStride, uint32_t positionOffset,
+    const uint32_t* pIndices, uint32_t numIndices);
+
+struct OcclusionStats
+{
+    uint32_t NumOccluders = 0;
+    uint32_t NumTriangles = 0; // After clipping and rejection
+    uint32_t NumTested = 0;
+    uint32_t NumOccluded = 0;
+    double RasterMs = 0.0;     // Triangle setup, rasterization and the depth pyramid
+    double TestMs = 0.0;
+};
+
+// Occluders are rasterized into a small depth buffer of 4x4 pixel tiles, one SSE row at a time. The screen is
+// split into bins that are cleared, rasterized and reduced by separate jobs, so no two threads touch the same tile.
+// Every tile's min and max depth then seed a pyramid where each level halves the last.
+//
+// Objects are occluded when their nearest depth lies behind the furthest occluder depth everywhere they cover.
+// Uncovered pixels stay at the far plane and never occlude. Depth follows D3D, 0 at the near plane.
+class OcclusionCuller
+{
+public:
+    // Dimensions are rounded up to whole bins
+    bool Init(uint32_t width, uint32_t height);
+    void Destroy();
+
+    // viewProj is row-major in the row-vector convention used by DirectXMath (clip = v * M)
+    void BeginFrame(const float viewProj[16]);
+
+    // The mesh and world matrix must stay valid until RenderOccluders
+    void AddOccluder(const OccluderMesh* pMesh, const float world[16]);
+
+    // Splits the work across the job system, which must be initialized
+    void RenderOccluders();
+
+    bool IsBoxVisible(const float center[3], const float extents[3]) const;
+
+    // Keeps the candidates whose boxes aren't occluded, in order. out_visible can't be candidates.
+    void CullBoxes(const BoundingBoxesSoA& boxes, const std::vector<uint32_t>& candidates, std::vector<uint32_t>& out_visible);
+
+    uint32_t GetWidth() const { return mWidth; }
+    uint32_t GetHeight() const { return mHeight; }
+    float GetPixelDepth(uint32_t x, uint32_t y) const;
+    const OcclusionStats& GetStats() const { return mStats; }
+
+private:
+    struct Triangle
+    {
+        // Edge functions A * x + B * y + C, positive inside, and the depth plane in the same form
+        float EdgeA[3], EdgeB[3], EdgeC[3];
+        float DepthA, DepthB, DepthC;
+        int32_t MinX, MinY, MaxX, MaxY; // Pixels whose centers might be covered, clamped to the screen
+    };
+
+    struct Occluder
+    {
+        const OccluderMesh* pMesh;
+        float WorldViewProj[16];
+    };
+
+    struct HiZLevel
+    {
+        uint32_t Width, Height;
+        std::vector<float> MinDepth, MaxDepth;
+    };
+
+    void SetupTriangles(const Occluder& occluder, std::vector<Triangle>& out_triangles) const;
+    void EmitTriangle(const float clip[3][4], std::vector<Triangle>& out_triangles) const;
+    void RasterizeBin(uint32_t bin);
+    void BuildHiZ();
+
+    uint32_t mWidth = 0;
+    uint32_t mHeight = 0;
+    uint32_t mTilesX = 0;
+    uint32_t mTilesY = 0;
+    std::vector<float> mDepth; // Tile major, 16 floats per tile, rows of 4
+
+    std::vector<HiZLevel> mHiZ; // Level 0 is one texel per tile
+
+    float mViewProj[16];
+    std::vector<Occluder> mOccluders;
+    std::vector<std::vector<Triangle>> mChunkTriangles; // One list per setup job
+    std::vector<uint8_t> mVisibleFlags;
+
+    OcclusionStats mStats;
+};
+
+}
+
+#endif
@@ -17,12 +17,26 @@ helper macros for reaching certain paths
 #define __WLINE__ WIDEN(__LINE__)
 
 // Helper macros for getting correct paths. WILL ONLY WORK IN THIS PROJECT CONFIG
-#define ASSETPATH "..\\Assets\\"
-#define MODELPATH ASSETPATH ## "Models\\"
+// Windows takes either separator, but the headless tests run elsewhere too, where only '/' is one.
+#if defined(_WIN32)
+#define PATHSEP "\\"
+#else
+#define PATHSEP "/"
+#endif
+#define ASSETPATH ".." PATHSEP "Assets" PATHSEP
+#define ASSETPATHW WIDEN(ASSETPATH)
+#define MODELPATH ASSETPATH "Models" PATHSEP
 #define MODELPATHW WIDEN(MODELPATH)
-#define TEXTUREPATH ASSETPATH ## "Textures\\"
-#define SHADERPATH "..\\_bin\\Shaders\\"
+#define TEXTUREPATH ASSETPATH "Textures" PATHSEP
+#define VOLUMEPATH ASSETPATH "Volumes" PATHSEP
+#define SHADERPATH ".." PATHSEP "_bin" PATHSEP "Shaders" PATHSEP
 #define SHADERPATHW WIDEN(SHADERPATH)
+#define CACHEPATH ".." PATHSEP "_bin" PATHSEP "Cache" PATHSEP
+#define CACHEPATHW WIDEN(CACHEPATH)
+#define PROFILEPATH ".." PATHSEP "_bin" PATHSEP "Profiles" PATHSEP
+#define PROFILEPATHW WIDEN(PROFILEPATH)
+#define CAPTUREPATH ".." PATHSEP "_bin" PATHSEP "Captures" PATHSEP
+#define CAPTUREPATHW WIDEN(CAPTUREPATH)
 
 inline std::wstring GetShaderPathFromFile_W(std::wstring fileName)
 {
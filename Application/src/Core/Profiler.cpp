@@ -0,0 +1,360 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Scoped CPU timing markers collected per frame, with rolling summaries and Chrome trace export
+----------------------------------------------*/
+#include <Core/Profiler.h>
+
+#include <Utils/Utils.h>
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <inttypes.h>
+#include <stdio.h>
+#include <unordered_map>
+
+namespace Muon
+{
+
+namespace
+{
+    using Clock = std::chrono::high_resolution_clock;
+
+    // Events each thread can hold between two EndFrames before the oldest are dropped. Must be a power of two.
+    static const uint64_t kThreadBufferSize = 1 << 14;
+    static_assert((kThreadBufferSize & (kThreadBufferSize - 1)) == 0, "Thread buffer size must be a power of two");
+
+    static Profiler* gProfilerInstance = nullptr;
+    static Clock::time_point gProfilerEpoch;
+
+    // Bumped on every Init so threads notice their cached buffer belonged to a destroyed profiler
+    static std::atomic<uint64_t> gProfilerGeneration{ 0 };
+
+    int64_t Now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - gProfilerEpoch).count();
+    }
+
+    double ToMs(int64_t ns)
+    {
+        return ns * 1e-6;
+    }
+
+    void AppendJsonString(std::string& out, const char* str)
+    {
+        out += '"';
+        for (const char* c = str; *c; ++c)
+        {
+            if (*c == '"' || *c == '\\')
+                out += '\\';
+            if (static_cast<unsigned char>(*c) >= 0x20)
+                out += *c;
+        }
+        out += '"';
+    }
+}
+
+std::atomic<bool> Profiler::sEnabled{ false };
+
+// A ring written only by its owning thread. WriteCount is published after each event so the collector never reads a half written one.
+struct Profiler::ThreadBuffer
+{
+    std::vector<ProfileEvent> Events;
+    std::atomic<uint64_t> WriteCount{ 0 };
+    uint64_t ReadCount = 0; // Only touched by the collector
+    uint32_t Depth = 0;
+    uint32_t Index = 0;
+    std::string Name;       // Guarded by mThreadsMutex
+};
+
+void Profiler::Init(uint32_t historyFrames)
+{
+    if (gProfilerInstance)
+    {
+        Muon::Print("ERROR: Tried to initialize already initialized Profiler!\n");
+        return;
+    }
+
+    gProfilerInstance = new Profiler();
+    gProfilerInstance->mHistory.resize(std::max<uint32_t>(historyFrames, 1));
+    gProfilerEpoch = Clock::now();
+    gProfilerGeneration.fetch_add(1, std::memory_order_release);
+    sEnabled.store(true, std::memory_order_relaxed);
+}
+
+void Profiler::Destroy()
+{
+    if (!gProfilerInstance)
+        return;
+
+    sEnabled.store(false, std::memory_order_relaxed);
+    delete gProfilerInstance;
+    gProfilerInstance = nullptr;
+}
+
+Profiler& Profiler::GetSingleton()
+{
+    return *gProfilerInstance;
+}
+
+bool Profiler::IsInitialized()
+{
+    return gProfilerInstance != nullptr;
+}
+
+void Profiler::SetEnabled(bool enabled)
+{
+    sEnabled.store(enabled && gProfilerInstance, std::memory_order_relaxed);
+}
+
+void Profiler::SetThreadName(const char* name)
+{
+    if (!gProfilerInstance)
+        return;
+
+    ThreadBuffer* pBuffer = GetThreadBuffer();
+    std::lock_guard<std::mutex> lock(gProfilerInstance->mThreadsMutex);
+    pBuffer->Name = name;
+}
+
+// Registration is the only time a thread takes the lock. Every scope after that only touches its own buffer.
+Profiler::ThreadBuffer* Profiler::GetThreadBuffer()
+{
+    static thread_local ThreadBuffer* tBuffer = nullptr;
+    static thread_local uint64_t tGeneration = 0;
+
+    const uint64_t generation = gProfilerGeneration.load(std::memory_order_acquire);
+    if (tBuffer && tGeneration == generation)
+        return tBuffer;
+
+    Profiler& profiler = *gProfilerInstance;
+    std::lock_guard<std::mutex> lock(profiler.mThreadsMutex);
+
+    std::unique_ptr<ThreadBuffer> pBuffer = std::make_unique<ThreadBuffer>();
+    pBuffer->Events.resize(kThreadBufferSize);
+    pBuffer->Index = static_cast<uint32_t>(profiler.mThreads.size());
+    pBuffer->Name = "Thread " + std::to_string(pBuffer->Index);
+
+    tBuffer = pBuffer.get();
+    tGeneration = generation;
+    profiler.mThreads.push_back(std::move(pBuffer));
+    return tBuffer;
+}
+
+int64_t Profiler::BeginScope()
+{
+    if (!gProfilerInstance)
+        return 0;
+
+    ++GetThreadBuffer()->Depth;
+    return Now();
+}
+
+void Profiler::EndScope(const char* name, int64_t beginNs)
+{
+    const int64_t endNs = Now();
+    if (!gProfilerInstance)
+        return;
+
+    ThreadBuffer& buffer = *GetThreadBuffer();
+    if (buffer.Depth > 0)
+        --buffer.Depth;
+
+    const uint64_t writeCount = buffer.WriteCount.load(std::memory_order_relaxed);
+    ProfileEvent& event = buffer.Events[writeCount & (kThreadBufferSize - 1)];
+    event.Name = name;
+    event.BeginNs = beginNs;
+    event.EndNs = endNs;
+    event.Depth = buffer.Depth;
+    event.ThreadIndex = buffer.Index;
+    buffer.WriteCount.store(writeCount + 1, std::memory_order_release);
+}
+
+void Profiler::BeginFrame()
+{
+    if (!IsEnabled())
+        return;
+
+    mFrameBeginNs = BeginScope();
+    mFrameOpen = true;
+}
+
+void Profiler::EndFrame()
+{
+    if (!mFrameOpen)
+        return;
+
+    EndScope("Frame", mFrameBeginNs);
+    mFrameOpen = false;
+
+    Frame& frame = mHistory[mNumFrames % mHistory.size()];
+    frame.BeginNs = mFrameBeginNs;
+    frame.EndNs = Now();
+    frame.Index = mNumFrames;
+    frame.Events.clear();
+    {
+        std::lock_guard<std::mutex> lock(mThreadsMutex);
+        for (std::unique_ptr<ThreadBuffer>& pBuffer : mThreads)
+            Collect(*pBuffer, frame.Events);
+    }
+
+    ++mNumFrames;
+}
+
+void Profiler::Collect(ThreadBuffer& buffer, std::vector<ProfileEvent>& out_events)
+{
+    const uint64_t writeCount = buffer.WriteCount.load(std::memory_order_acquire);
+
+    // Anything the owner has already lapped is gone
+    uint64_t begin = buffer.ReadCount;
+    if (writeCount - begin > kThreadBufferSize)
+    {
+        mNumDropped += writeCount - kThreadBufferSize - begin;
+        begin = writeCount - kThreadBufferSize;
+    }
+
+    const size_t first = out_events.size();
+    for (uint64_t i = begin; i != writeCount; ++i)
+        out_events.push_back(buffer.Events[i & (kThreadBufferSize - 1)]);
+
+    // The owner keeps recording while this copies. Throw away the oldest events if it could have overwritten them meanwhile.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const uint64_t afterCount = buffer.WriteCount.load(std::memory_order_relaxed);
+    if (afterCount - begin > kThreadBufferSize)
+    {
+        const uint64_t numLost = std::min(afterCount - kThreadBufferSize, writeCount) - begin;
+        out_events.erase(out_events.begin() + first, out_events.begin() + first + static_cast<size_t>(numLost));
+        mNumDropped += numLost;
+    }
+
+    buffer.ReadCount = writeCount;
+}
+
+void Profiler::GetSummary(std::vector<ProfileScopeStats>& out_stats) const
+{
+    struct Accumulator
+    {
+        std::vector<double> FrameMs;
+        uint64_t NumCalls = 0;
+        uint64_t LastFrame = UINT64_MAX;
+    };
+
+    // Names are compared by value since the same literal can have a different address in each translation unit
+    std::unordered_map<std::string, Accumulator> byName;
+    std::unordered_map<const char*, Accumulator*> byAddress;
+
+    const uint64_t numFrames = std::min<uint64_t>(mNumFrames, mHistory.size());
+    for (uint64_t f = mNumFrames - numFrames; f != mNumFrames; ++f)
+    {
+        const Frame& frame = mHistory[f % mHistory.size()];
+        for (const ProfileEvent& event : frame.Events)
+        {
+            Accumulator*& pAccum = byAddress[event.Name];
+            if (!pAccum)
+                pAccum = &byName[event.Name];
+
+            if (pAccum->LastFrame != f)
+            {
+                pAccum->FrameMs.push_back(0.0);
+                pAccum->LastFrame = f;
+            }
+            pAccum->FrameMs.back() += ToMs(event.EndNs - event.BeginNs);
+            ++pAccum->NumCalls;
+        }
+    }
+
+    out_stats.clear();
+    out_stats.reserve(byName.size());
+    for (std::pair<const std::string, Accumulator>& entry : byName)
+    {
+        std::vector<double>& frameMs = entry.second.FrameMs;
+        std::sort(frameMs.begin(), frameMs.end());
+
+        double totalMs = 0.0;
+        for (double ms : frameMs)
+            totalMs += ms;
+
+        ProfileScopeStats stats;
+        stats.Name = entry.first;
+        stats.NumFrames = static_cast<uint32_t>(frameMs.size());
+        stats.AvgCalls = double(entry.second.NumCalls) / frameMs.size();
+        stats.MinMs = frameMs.front();
+        stats.AvgMs = totalMs / frameMs.size();
+        stats.P99Ms = frameMs[(frameMs.size() * 99 + 99) / 100 - 1];
+        out_stats.push_back(std::move(stats));
+    }
+
+    std::sort(out_stats.begin(), out_stats.end(), [](const ProfileScopeStats& a, const ProfileScopeStats& b) { return a.AvgMs > b.AvgMs; });
+}
+
+void Profiler::PrintSummary() const
+{
+    std::vector<ProfileScopeStats> stats;
+    GetSummary(stats);
+
+    Muon::Printf("Info: CPU profile over the last %u frames (%" PRIu64 " events dropped)\n",
+        static_cast<uint32_t>(std::min<uint64_t>(mNumFrames, mHistory.size())), mNumDropped);
+    for (const ProfileScopeStats& scope : stats)
+    {
+        Muon::Printf("    %-28s avg %8.3f ms  min %8.3f ms  p99 %8.3f ms  %6.1f calls/frame\n",
+            scope.Name.c_str(), scope.AvgMs, scope.MinMs, scope.P99Ms, scope.AvgCalls);
+    }
+}
+
+// Complete ("X") events in microseconds, one track per thread. Nesting comes from the timestamps, so depth isn't written.
+bool Profiler::WriteChromeTrace(const wchar_t* path) const
+{
+    namespace fs = std::filesystem;
+
+    std::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    char line[256];
+
+    {
+        std::lock_guard<std::mutex> lock(mThreadsMutex);
+        for (const std::unique_ptr<ThreadBuffer>& pBuffer : mThreads)
+        {
+            snprintf(line, sizeof(line), "{\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"name\":\"thread_name\",\"args\":{\"name\":", pBuffer->Index);
+            json += line;
+            AppendJsonString(json, pBuffer->Name.c_str());
+            json += "}},\n";
+        }
+    }
+
+    const uint64_t numFrames = std::min<uint64_t>(mNumFrames, mHistory.size());
+    for (uint64_t f = mNumFrames - numFrames; f != mNumFrames; ++f)
+    {
+        const Frame& frame = mHistory[f % mHistory.size()];
+        for (const ProfileEvent& event : frame.Events)
+        {
+            json += "{\"ph\":\"X\",\"pid\":1,\"name\":";
+            AppendJsonString(json, event.Name);
+            snprintf(line, sizeof(line), ",\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"frame\":%" PRIu64 "}},\n",
+                event.ThreadIndex, event.BeginNs * 1e-3, (event.EndNs - event.BeginNs) * 1e-3, frame.Index);
+            json += line;
+        }
+    }
+
+    // The format allows a trailing comma, but not every viewer does
+    if (json.back() == '\n' && json[json.size() - 2] == ',')
+        json.erase(json.size() - 2, 1);
+    json += "]}\n";
+
+    std::error_code ec;
+    fs::path filePath(path);
+    if (filePath.has_parent_path())
+        fs::create_directories(filePath.parent_path(), ec);
+
+    std::ofstream file(filePath, std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        Muon::Printf(L"Error: Failed to open %s for the CPU trace!\n", path);
+        return false;
+    }
+
+    file.write(json.data(), json.size());
+    return file.good();
+}
+
+}
@@ -0,0 +1,144 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Scoped CPU timing markers collected per frame, with rolling summaries and Chrome trace export
+----------------------------------------------*/
+#ifndef MUON_PROFILER_H
+#define MUON_PROFILER_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Set to 0 to compile every marker out. Otherwise a marker costs one relaxed load while the profiler is disabled.
+#ifndef MN_PROFILE
+#define MN_PROFILE 1
+#endif
+
+#define MUON_PROFILE_CONCAT_INNER(a, b) a##b
+#define MUON_PROFILE_CONCAT(a, b) MUON_PROFILE_CONCAT_INNER(a, b)
+
+#if MN_PROFILE
+// Times the rest of the enclosing scope. name must be a string literal, only its address is stored.
+#define MUON_PROFILE_SCOPE(name) Muon::ProfileScope MUON_PROFILE_CONCAT(profileScope_, __LINE__)(name)
+#else
+#define MUON_PROFILE_SCOPE(name)
+#endif
+
+namespace Muon
+{
+
+// One timed scope. Times are in nanoseconds since the profiler was initialized.
+struct ProfileEvent
+{
+    const char* Name = nullptr;
+    int64_t BeginNs = 0;
+    int64_t EndNs = 0;
+    uint32_t Depth = 0;       // Scopes already open on the same thread
+    uint32_t ThreadIndex = 0;
+};
+
+// Per frame time spent in a scope, summed over every call in the frame, across the frames in the history
+struct ProfileScopeStats
+{
+    std::string Name;
+    uint32_t NumFrames = 0; // Frames in the history the scope appeared in
+    double AvgCalls = 0.0;  // Per frame, over those frames
+    double MinMs = 0.0;
+    double AvgMs = 0.0;
+    double P99Ms = 0.0;
+};
+
+class Profiler
+{
+public:
+    // Singleton Stuff. The profiler starts enabled, and markers hit before Init are ignored.
+    static void Init(uint32_t historyFrames = 240);
+    static void Destroy();
+
+    static Profiler& GetSingleton();
+    static bool IsInitialized();
+
+    static bool IsEnabled() { return sEnabled.load(std::memory_order_relaxed); }
+    static void SetEnabled(bool enabled);
+
+    // Shows up as the thread's name in traces. Threads that never call this are numbered in the order they first record.
+    static void SetThreadName(const char* name);
+
+    // Brackets a frame with a "Frame" scope on the calling thread. EndFrame gathers everything recorded on any thread since
+    // the previous EndFrame into the history, so jobs still running at the boundary are counted in the next frame.
+    void BeginFrame();
+    void EndFrame();
+
+    uint32_t GetNumFrames() const { return static_cast<uint32_t>(mNumFrames); }
+    uint64_t GetNumDroppedEvents() const { return mNumDropped; }
+
+    // Rolling statistics over the frames in the history, slowest average first
+    void GetSummary(std::vector<ProfileScopeStats>& out_stats) const;
+    void PrintSummary() const;
+
+    // Writes the frames in the history as Chrome trace event JSON, for chrome://tracing or Perfetto
+    bool WriteChromeTrace(const wchar_t* path) const;
+
+    // Used by ProfileScope
+    static int64_t BeginScope();
+    static void EndScope(const char* name, int64_t beginNs);
+
+private:
+    Profiler() = default;
+
+    struct ThreadBuffer;
+    struct Frame
+    {
+        int64_t BeginNs = 0;
+        int64_t EndNs = 0;
+        uint64_t Index = 0;
+        std::vector<ProfileEvent> Events;
+    };
+
+    static ThreadBuffer* GetThreadBuffer();
+    void Collect(ThreadBuffer& buffer, std::vector<ProfileEvent>& out_events);
+
+    static std::atomic<bool> sEnabled;
+
+    // Buffers are only added under the mutex. After that each is written by its own thread alone.
+    std::vector<std::unique_ptr<ThreadBuffer>> mThreads;
+    mutable std::mutex mThreadsMutex;
+
+    std::vector<Frame> mHistory; // Ring of the most recent frames
+    uint64_t mNumFrames = 0;
+    uint64_t mNumDropped = 0;
+    int64_t mFrameBeginNs = 0;
+    bool mFrameOpen = false;
+};
+
+class ProfileScope
+{
+public:
+    explicit ProfileScope(const char* name) :
+        mName(Profiler::IsEnabled() ? name : nullptr)
+    {
+        if (mName)
+            mBeginNs = Profiler::BeginScope();
+    }
+
+    ~ProfileScope()
+    {
+        if (mName)
+            Profiler::EndScope(mName, mBeginNs);
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    const char* mName;
+    int64_t mBeginNs = 0;
+};
+
+}
+
+#endif
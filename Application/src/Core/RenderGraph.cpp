@@ -0,0 +1,507 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Render graph declaration and compiler (pass culling, ordering, barriers, transient aliasing)
+----------------------------------------------*/
+#include <Core/RenderGraph.h>
+
+#include <Utils/Utils.h>
+
+#include <algorithm>
+#include <chrono>
+
+namespace Muon
+{
+
+namespace
+{
+    uint64_t AlignUp(uint64_t value, uint64_t alignment)
+    {
+        return alignment ? (value + alignment - 1) / alignment * alignment : value;
+    }
+
+    RGMemoryRequirements EstimateMemory(const RGTextureDesc& desc)
+    {
+        RGMemoryRequirements req;
+        req.Size = AlignUp(uint64_t(desc.Width) * desc.Height * desc.DepthOrArraySize * 4, req.Alignment);
+        return req;
+    }
+
+    // Present maps to the common state, so it can't be combined with other reads
+    bool CanMergeReads(uint32_t a, uint32_t b)
+    {
+        return !(a & RG_ACCESS_WRITE_MASK) && !(b & RG_ACCESS_WRITE_MASK) && !((a | b) & RG_ACCESS_PRESENT);
+    }
+}
+
+void RenderGraph::Reset()
+{
+    mResources.clear();
+    mPasses.clear();
+    mCompiledPasses.clear();
+    mBarriers.clear();
+    mFinalBarriers.clear();
+    mStats = {};
+}
+
+RGResourceHandle RenderGraph::ImportTexture(const char* name, const RGTextureDesc& desc, uint32_t initialAccess, uint32_t finalAccess)
+{
+    Resource resource;
+    resource.Name = name;
+    resource.Desc = desc;
+    resource.Imported = true;
+    resource.InitialAccess = initialAccess;
+    resource.FinalAccess = finalAccess;
+    mResources.push_back(std::move(resource));
+    return static_cast<RGResourceHandle>(mResources.size() - 1);
+}
+
+RGResourceHandle RenderGraph::CreateTexture(const char* name, const RGTextureDesc& desc)
+{
+    Resource resource;
+    resource.Name = name;
+    resource.Desc = desc;
+    mResources.push_back(std::move(resource));
+    return static_cast<RGResourceHandle>(mResources.size() - 1);
+}
+
+RGPassHandle RenderGraph::AddPass(const char* name, RGExecuteFunc execute)
+{
+    Pass pass;
+    pass.Name = name;
+    pass.Execute = std::move(execute);
+    mPasses.push_back(std::move(pass));
+    return static_cast<RGPassHandle>(mPasses.size() - 1);
+}
+
+void RenderGraph::Read(RGPassHandle pass, RGResourceHandle resource, uint32_t access)
+{
+    if (access & RG_ACCESS_WRITE_MASK)
+    {
+        Muon::Printf("Error: Render graph pass '%s' reads with a write access, use Write()!\n", mPasses[pass].Name.c_str());
+        return;
+    }
+
+    AddAccess(pass, resource, access);
+}
+
+void RenderGraph::Write(RGPassHandle pass, RGResourceHandle resource, uint32_t access)
+{
+    if (!(access & RG_ACCESS_WRITE_MASK))
+    {
+        Muon::Printf("Error: Render graph pass '%s' writes with a read-only access, use Read()!\n", mPasses[pass].Name.c_str());
+        return;
+    }
+
+    AddAccess(pass, resource, access);
+}
+
+void RenderGraph::AddAccess(RGPassHandle pass, RGResourceHandle resource, uint32_t access)
+{
+    if (pass >= mPasses.size() || resource >= mResources.size())
+    {
+        Muon::Print("Error: Invalid render graph handle!\n");
+        return;
+    }
+
+    mResources[resource].Usage |= access;
+
+    std::vector<Access>& accesses = mPasses[pass].Accesses;
+    for (Access& existing : accesses)
+    {
+        if (existing.Resource == resource)
+        {
+            existing.Flags |= access;
+            return;
+        }
+    }
+
+    accesses.push_back({ resource, access });
+}
+
+void RenderGraph::SetSideEffects(RGPassHandle pass)
+{
+    mPasses[pass].SideEffects = true;
+}
+
+bool RenderGraph::Compile(const RGMemoryFunc& memoryFunc)
+{
+    using Clock = std::chrono::high_resolution_clock;
+    const Clock::time_point compileStart = Clock::now();
+
+    mCompiledPasses.clear();
+    mBarriers.clear();
+    mFinalBarriers.clear();
+    mStats = {};
+
+    CullPasses();
+    if (!SortPasses())
+        return false;
+
+    ComputeLifetimes();
+    AllocateTransients(memoryFunc);
+    DeriveBarriers();
+
+    mStats.NumPasses = static_cast<uint32_t>(mCompiledPasses.size());
+    mStats.NumCulledPasses = static_cast<uint32_t>(mPasses.size() - mCompiledPasses.size());
+    mStats.NumBarriers = static_cast<uint32_t>(mBarriers.size() + mFinalBarriers.size());
+    mStats.CompileMs = std::chrono::duration<double, std::milli>(Clock::now() - compileStart).count();
+    return true;
+}
+
+// Walks the passes backwards from the outputs. A pass survives if it has side effects or writes something a surviving pass
+// (or the outside world, for imported resources) reads later. Writes don't end liveness since a pass may only touch part of a target.
+void RenderGraph::CullPasses()
+{
+    std::vector<bool> needed(mResources.size(), false);
+    for (size_t i = 0; i != mResources.size(); ++i)
+        needed[i] = mResources[i].Imported;
+
+    for (size_t p = mPasses.size(); p-- != 0;)
+    {
+        Pass& pass = mPasses[p];
+
+        bool alive = pass.SideEffects;
+        for (const Access& access : pass.Accesses)
+            alive |= (access.Flags & RG_ACCESS_WRITE_MASK) && needed[access.Resource];
+
+        pass.Culled = !alive;
+        if (!alive)
+            continue;
+
+        for (const Access& access : pass.Accesses)
+            needed[access.Resource] = true;
+    }
+}
+
+// Topological sort of the surviving passes over their read/write hazards. Among the passes that are ready, the one consuming the
+// most recently produced resource goes first, which keeps transient lifetimes short and gives the allocator more to alias.
+bool RenderGraph::SortPasses()
+{
+    const uint32_t numPasses = static_cast<uint32_t>(mPasses.size());
+
+    std::vector<std::vector<uint32_t>> successors(numPasses);
+    std::vector<uint32_t> numPredecessors(numPasses, 0);
+    auto addEdge = [&](uint32_t from, uint32_t to)
+    {
+        if (from == RG_INVALID_HANDLE || from == to)
+            return;
+
+        successors[from].push_back(to);
+        numPredecessors[to]++;
+    };
+
+    std::vector<uint32_t> lastWriter(mResources.size(), RG_INVALID_HANDLE);
+    std::vector<std::vector<uint32_t>> readersSinceWrite(mResources.size());
+    uint32_t lastSideEffectPass = RG_INVALID_HANDLE;
+
+    for (uint32_t p = 0; p != numPasses; ++p)
+    {
+        const Pass& pass = mPasses[p];
+        if (pass.Culled)
+            continue;
+
+        for (const Access& access : pass.Accesses)
+        {
+            addEdge(lastWriter[access.Resource], p);
+
+            std::vector<uint32_t>& readers = readersSinceWrite[access.Resource];
+            if (access.Flags & RG_ACCESS_WRITE_MASK)
+            {
+                for (uint32_t reader : readers)
+                    addEdge(reader, p);
+
+                readers.clear();
+                lastWriter[access.Resource] = p;
+            }
+            else
+            {
+                readers.push_back(p);
+            }
+        }
+
+        // Side effects are invisible to the graph, so those passes keep their declared order
+        if (pass.SideEffects)
+        {
+            addEdge(lastSideEffectPass, p);
+            lastSideEffectPass = p;
+        }
+    }
+
+    // Duplicate edges are harmless since both ends count them
+    std::vector<uint32_t> ready;
+    for (uint32_t p = 0; p != numPasses; ++p)
+    {
+        if (!mPasses[p].Culled && numPredecessors[p] == 0)
+            ready.push_back(p);
+    }
+
+    std::vector<uint32_t> position(numPasses, RG_INVALID_HANDLE);
+    std::vector<uint32_t> producedAt(mResources.size(), 0);
+
+    while (!ready.empty())
+    {
+        // Score = latest position at which something this pass reads was written, ties broken by declaration order
+        size_t best = 0;
+        uint32_t bestScore = 0;
+        for (size_t i = 0; i != ready.size(); ++i)
+        {
+            uint32_t score = 0;
+            for (const Access& access : mPasses[ready[i]].Accesses)
+                score = std::max(score, producedAt[access.Resource]);
+
+            if (score > bestScore || (score == bestScore && ready[i] < ready[best]))
+            {
+                best = i;
+                bestScore = score;
+            }
+        }
+
+        const uint32_t p = ready[best];
+        ready.erase(ready.begin() + best);
+
+        position[p] = static_cast<uint32_t>(mCompiledPasses.size());
+        RGCompiledPass compiled;
+        compiled.Pass = p;
+        mCompiledPasses.push_back(compiled);
+
+        for (const Access& access : mPasses[p].Accesses)
+        {
+            if (access.Flags & RG_ACCESS_WRITE_MASK)
+                producedAt[access.Resource] = position[p] + 1;
+        }
+
+        for (uint32_t next : successors[p])
+        {
+            if (--numPredecessors[next] == 0)
+                ready.push_back(next);
+        }
+    }
+
+    // Edges only ever point at later declarations, so this only trips if the bookkeeping above is broken
+    size_t numAlive = 0;
+    for (const Pass& pass : mPasses)
+        numAlive += pass.Culled ? 0 : 1;
+
+    if (mCompiledPasses.size() != numAlive)
+    {
+        Muon::Print("Error: Render graph has a dependency cycle!\n");
+        mCompiledPasses.clear();
+        return false;
+    }
+
+    return true;
+}
+
+void RenderGraph::ComputeLifetimes()
+{
+    for (Resource& resource : mResources)
+    {
+        resource.Used = false;
+        resource.Aliases = false;
+        resource.HeapOffset = 0;
+        resource.Size = 0;
+    }
+
+    for (uint32_t i = 0; i != mCompiledPasses.size(); ++i)
+    {
+        for (const Access& access : mPasses[mCompiledPasses[i].Pass].Accesses)
+        {
+            Resource& resource = mResources[access.Resource];
+            if (!resource.Used)
+            {
+                resource.Used = true;
+                resource.FirstUse = i;
+            }
+            resource.LastUse = i;
+        }
+    }
+}
+
+// Places transients in one heap, largest first. Each goes at the lowest offset that doesn't collide with an already
+// placed transient whose lifetime overlaps its own.
+void RenderGraph::AllocateTransients(const RGMemoryFunc& memoryFunc)
+{
+    struct Placement
+    {
+        RGResourceHandle Resource;
+        uint64_t Alignment;
+    };
+
+    std::vector<Placement> transients;
+    for (RGResourceHandle r = 0; r != mResources.size(); ++r)
+    {
+        Resource& resource = mResources[r];
+        if (resource.Imported || !resource.Used)
+            continue;
+
+        const RGMemoryRequirements req = memoryFunc ? memoryFunc(resource.Desc, resource.Usage) : EstimateMemory(resource.Desc);
+        resource.Size = req.Size;
+        transients.push_back({ r, std::max<uint64_t>(req.Alignment, 1) });
+
+        // Placed back to back, so this is comparable with the aliased heap size
+        mStats.UnaliasedBytes = AlignUp(mStats.UnaliasedBytes, req.Alignment) + req.Size;
+    }
+
+    std::sort(transients.begin(), transients.end(), [this](const Placement& a, const Placement& b)
+        {
+            const uint64_t sizeA = mResources[a.Resource].Size;
+            const uint64_t sizeB = mResources[b.Resource].Size;
+            return sizeA != sizeB ? sizeA > sizeB : a.Resource < b.Resource;
+        });
+
+    struct Range
+    {
+        uint64_t Begin;
+        uint64_t End;
+    };
+
+    std::vector<Range> blocked;
+    uint64_t heapSize = 0;
+    for (size_t i = 0; i != transients.size(); ++i)
+    {
+        Resource& resource = mResources[transients[i].Resource];
+
+        blocked.clear();
+        for (size_t j = 0; j != i; ++j)
+        {
+            const Resource& other = mResources[transients[j].Resource];
+            if (other.FirstUse <= resource.LastUse && resource.FirstUse <= other.LastUse)
+                blocked.push_back({ other.HeapOffset, other.HeapOffset + other.Size });
+        }
+
+        std::sort(blocked.begin(), blocked.end(), [](const Range& a, const Range& b) { return a.Begin < b.Begin; });
+
+        uint64_t offset = 0;
+        for (const Range& range : blocked)
+        {
+            if (offset + resource.Size <= range.Begin)
+                break;
+
+            offset = std::max(offset, AlignUp(range.End, transients[i].Alignment));
+        }
+
+        resource.HeapOffset = offset;
+        heapSize = std::max(heapSize, offset + resource.Size);
+
+        // Anything placed earlier that overlaps this memory must have a disjoint lifetime
+        for (size_t j = 0; j != i; ++j)
+        {
+            Resource& other = mResources[transients[j].Resource];
+            if (other.HeapOffset < offset + resource.Size && offset < other.HeapOffset + other.Size)
+            {
+                resource.Aliases = true;
+                other.Aliases = true;
+            }
+        }
+    }
+
+    mStats.TransientBytes = heapSize;
+}
+
+// Each resource's accesses in execution order are split into groups: a writing pass on its own, or a run of passes that only read,
+// which share one combined read state. A transition is only issued when a group needs a different state than the one before it.
+void RenderGraph::DeriveBarriers()
+{
+    struct Use
+    {
+        uint32_t Position;
+        uint32_t Flags;
+    };
+
+    std::vector<std::vector<Use>> uses(mResources.size());
+    for (uint32_t i = 0; i != mCompiledPasses.size(); ++i)
+    {
+        for (const Access& access : mPasses[mCompiledPasses[i].Pass].Accesses)
+            uses[access.Resource].push_back({ i, access.Flags });
+    }
+
+    struct PendingBarrier
+    {
+        uint32_t Position;
+        RGBarrier Barrier;
+    };
+
+    std::vector<PendingBarrier> pending;
+    for (RGResourceHandle r = 0; r != mResources.size(); ++r)
+    {
+        Resource& resource = mResources[r];
+        const std::vector<Use>& resourceUses = uses[r];
+        if (resourceUses.empty())
+            continue;
+
+        // Transients start every frame in the state the previous frame left them in, which is the state of their last group
+        if (!resource.Imported)
+        {
+            size_t lastGroup = resourceUses.size() - 1;
+            uint32_t lastState = resourceUses[lastGroup].Flags;
+            while (lastGroup != 0 && CanMergeReads(resourceUses[lastGroup - 1].Flags, lastState))
+                lastState |= resourceUses[--lastGroup].Flags;
+
+            resource.InitialAccess = lastState;
+            resource.FinalAccess = lastState;
+
+            if (resource.Aliases)
+            {
+                RGBarrier aliasing;
+                aliasing.Resource = r;
+                aliasing.BarrierType = RGBarrier::Aliasing;
+                pending.push_back({ resourceUses[0].Position, aliasing });
+            }
+        }
+
+        uint32_t state = resource.InitialAccess;
+        size_t i = 0;
+        while (i != resourceUses.size())
+        {
+            uint32_t target = resourceUses[i].Flags;
+            size_t next = i + 1;
+            while (next != resourceUses.size() && CanMergeReads(target, resourceUses[next].Flags))
+                target |= resourceUses[next++].Flags;
+
+            RGBarrier barrier;
+            barrier.Resource = r;
+            if (target != state)
+            {
+                barrier.Before = state;
+                barrier.After = target;
+                pending.push_back({ resourceUses[i].Position, barrier });
+            }
+            else if (i != 0 && (target & RG_ACCESS_UNORDERED_ACCESS))
+            {
+                barrier.BarrierType = RGBarrier::UAV;
+                barrier.Before = barrier.After = target;
+                pending.push_back({ resourceUses[i].Position, barrier });
+            }
+
+            state = target;
+            i = next;
+        }
+
+        if (resource.Imported && state != resource.FinalAccess)
+        {
+            RGBarrier barrier;
+            barrier.Resource = r;
+            barrier.Before = state;
+            barrier.After = resource.FinalAccess;
+            mFinalBarriers.push_back(barrier);
+        }
+    }
+
+    // Group by pass, keeping each resource's aliasing barrier ahead of its transition
+    std::stable_sort(pending.begin(), pending.end(), [](const PendingBarrier& a, const PendingBarrier& b) { return a.Position < b.Position; });
+
+    mBarriers.reserve(pending.size());
+    size_t cursor = 0;
+    for (uint32_t i = 0; i != mCompiledPasses.size(); ++i)
+    {
+        RGCompiledPass& compiled = mCompiledPasses[i];
+        compiled.FirstBarrier = static_cast<uint32_t>(mBarriers.size());
+        while (cursor != pending.size() && pending[cursor].Position == i)
+            mBarriers.push_back(pending[cursor++].Barrier);
+
+        compiled.NumBarriers = static_cast<uint32_t>(mBarriers.size()) - compiled.FirstBarrier;
+    }
+}
+
+}
@@ -0,0 +1,192 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Render graph declaration and compiler (pass culling, ordering, barriers, transient aliasing)
+This part is CPU only, RenderGraphExecutor turns the compiled result into D3D12 calls.
+----------------------------------------------*/
+#ifndef MUON_RENDERGRAPH_H
+#define MUON_RENDERGRAPH_H
+
+#include <functional>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+struct ID3D12GraphicsCommandList;
+
+namespace Muon
+{
+
+typedef uint32_t RGResourceHandle;
+typedef uint32_t RGPassHandle;
+
+static const uint32_t RG_INVALID_HANDLE = UINT32_MAX;
+
+// How a pass uses a resource. Several read flags can be combined into one state, so resources read by consecutive passes transition once.
+enum RGAccess : uint32_t
+{
+    RG_ACCESS_NONE              = 0,
+    RG_ACCESS_RENDER_TARGET     = 1 << 0,
+    RG_ACCESS_DEPTH_WRITE       = 1 << 1,
+    RG_ACCESS_UNORDERED_ACCESS  = 1 << 2,
+    RG_ACCESS_COPY_DEST         = 1 << 3,
+    RG_ACCESS_DEPTH_READ        = 1 << 4,
+    RG_ACCESS_SHADER_READ       = 1 << 5,
+    RG_ACCESS_COPY_SOURCE       = 1 << 6,
+    RG_ACCESS_PRESENT           = 1 << 7,
+
+    RG_ACCESS_WRITE_MASK = RG_ACCESS_RENDER_TARGET | RG_ACCESS_DEPTH_WRITE | RG_ACCESS_UNORDERED_ACCESS | RG_ACCESS_COPY_DEST,
+    RG_ACCESS_READ_MASK  = RG_ACCESS_DEPTH_READ | RG_ACCESS_SHADER_READ | RG_ACCESS_COPY_SOURCE | RG_ACCESS_PRESENT,
+};
+
+struct RGTextureDesc
+{
+    uint32_t Width = 0;
+    uint32_t Height = 0;
+    uint32_t DepthOrArraySize = 1;
+    uint32_t Format = 0; // DXGI_FORMAT
+};
+
+struct RGMemoryRequirements
+{
+    uint64_t Size = 0;
+    uint64_t Alignment = 65536;
+};
+
+// Usage is every access the graph makes to the texture. The executor asks the device; without one (e.g. when compiling headless)
+// sizes are estimated at 4 bytes per texel.
+typedef std::function<RGMemoryRequirements(const RGTextureDesc& desc, uint32_t usage)> RGMemoryFunc;
+
+class RGPassContext;
+typedef std::function<void(const RGPassContext& context, ID3D12GraphicsCommandList* pCommandList)> RGExecuteFunc;
+
+struct RGBarrier
+{
+    enum Type : uint8_t
+    {
+        Transition,
+        Aliasing, // The resource takes over heap memory another transient used earlier in the frame
+        UAV,      // Back to back unordered access
+    };
+
+    RGResourceHandle Resource = RG_INVALID_HANDLE;
+    uint32_t Before = RG_ACCESS_NONE;
+    uint32_t After = RG_ACCESS_NONE;
+    Type BarrierType = Transition;
+};
+
+struct RGCompiledPass
+{
+    RGPassHandle Pass = RG_INVALID_HANDLE;
+    uint32_t FirstBarrier = 0; // Into RenderGraph::GetBarriers(), issued right before the pass
+    uint32_t NumBarriers = 0;
+};
+
+struct RGCompileStats
+{
+    uint32_t NumPasses = 0;
+    uint32_t NumCulledPasses = 0;
+    uint32_t NumBarriers = 0;
+    uint64_t TransientBytes = 0;     // Heap size with aliasing
+    uint64_t UnaliasedBytes = 0;     // What the transients would need without it
+    double CompileMs = 0.0;
+};
+
+class RenderGraph
+{
+public:
+    // Clears all passes and resources, keeping allocations for the next frame's declarations
+    void Reset();
+
+    // External resources live across frames. They arrive in initialAccess and are left in finalAccess,
+    // and anything written to them counts as output, so the passes producing it are never culled.
+    RGResourceHandle ImportTexture(const char* name, const RGTextureDesc& desc, uint32_t initialAccess, uint32_t finalAccess);
+
+    // Transient textures only exist within the graph and share heap memory with transients whose lifetimes don't overlap.
+    // Their contents are undefined on first use, so the first access must fully overwrite them.
+    RGResourceHandle CreateTexture(const char* name, const RGTextureDesc& desc);
+
+    RGPassHandle AddPass(const char* name, RGExecuteFunc execute);
+    void Read(RGPassHandle pass, RGResourceHandle resource, uint32_t access);
+    void Write(RGPassHandle pass, RGResourceHandle resource, uint32_t access);
+
+    // Keeps a pass even if nothing reads what it writes (e.g. readbacks, UI)
+    void SetSideEffects(RGPassHandle pass);
+
+    bool Compile(const RGMemoryFunc& memoryFunc = nullptr);
+
+    // Compiled results
+    const std::vector<RGCompiledPass>& GetCompiledPasses() const { return mCompiledPasses; }
+    const std::vector<RGBarrier>& GetBarriers() const { return mBarriers; }
+    const std::vector<RGBarrier>& GetFinalBarriers() const { return mFinalBarriers; }
+    const RGCompileStats& GetCompileStats() const { return mStats; }
+    uint64_t GetTransientHeapSize() const { return mStats.TransientBytes; }
+
+    struct Resource
+    {
+        std::string Name;
+        RGTextureDesc Desc;
+        bool Imported = false;
+        uint32_t InitialAccess = RG_ACCESS_NONE; // For transients: the state they're created in and left in at the end of every frame
+        uint32_t FinalAccess = RG_ACCESS_NONE;
+        uint32_t Usage = RG_ACCESS_NONE; // Every access flag any pass declared
+
+        // Filled by Compile for transients
+        bool Used = false;
+        uint32_t FirstUse = 0; // Indices into the compiled pass order
+        uint32_t LastUse = 0;
+        uint64_t HeapOffset = 0;
+        uint64_t Size = 0;
+        bool Aliases = false; // Shares memory with another transient
+    };
+
+    struct Access
+    {
+        RGResourceHandle Resource;
+        uint32_t Flags;
+    };
+
+    struct Pass
+    {
+        std::string Name;
+        RGExecuteFunc Execute;
+        std::vector<Access> Accesses; // Reads and writes, merged per resource
+        bool SideEffects = false;
+        bool Culled = false;
+    };
+
+    const std::vector<Resource>& GetResources() const { return mResources; }
+    const Pass& GetPass(RGPassHandle pass) const { return mPasses[pass]; }
+
+private:
+    void AddAccess(RGPassHandle pass, RGResourceHandle resource, uint32_t access);
+
+    void CullPasses();
+    bool SortPasses();
+    void ComputeLifetimes();
+    void AllocateTransients(const RGMemoryFunc& memoryFunc);
+    void DeriveBarriers();
+
+    std::vector<Resource> mResources;
+    std::vector<Pass> mPasses;
+
+    std::vector<RGCompiledPass> mCompiledPasses;
+    std::vector<RGBarrier> mBarriers;
+    std::vector<RGBarrier> mFinalBarriers;
+    RGCompileStats mStats;
+};
+
+// What a pass can see of the graph while executing. The executor fills in the physical resources.
+class RGPassContext
+{
+public:
+    virtual ~RGPassContext() = default;
+
+    virtual struct ID3D12Resource* GetResource(RGResourceHandle resource) const = 0;
+    virtual uint64_t GetRTV(RGResourceHandle resource) const = 0; // D3D12_CPU_DESCRIPTOR_HANDLE::ptr, 0 if the resource has none
+    virtual uint64_t GetDSV(RGResourceHandle resource) const = 0;
+};
+
+}
+
+#endif
@@ -0,0 +1,353 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Runs a compiled RenderGraph on a D3D12 command list
+----------------------------------------------*/
+#include <Core/RenderGraphExecutor.h>
+
+#include <Core/ThrowMacros.h>
+#include <Utils/Utils.h>
+
+#include <string>
+
+namespace Muon
+{
+
+namespace
+{
+    D3D12_RESOURCE_STATES ToResourceStates(uint32_t access)
+    {
+        D3D12_RESOURCE_STATES states = D3D12_RESOURCE_STATE_COMMON;
+        if (access & RG_ACCESS_RENDER_TARGET)    states |= D3D12_RESOURCE_STATE_RENDER_TARGET;
+        if (access & RG_ACCESS_DEPTH_WRITE)      states |= D3D12_RESOURCE_STATE_DEPTH_WRITE;
+        if (access & RG_ACCESS_UNORDERED_ACCESS) states |= D3D12_RESOURCE_STATE_UNORDERED_ACCESS;
+        if (access & RG_ACCESS_COPY_DEST)        states |= D3D12_RESOURCE_STATE_COPY_DEST;
+        if (access & RG_ACCESS_DEPTH_READ)       states |= D3D12_RESOURCE_STATE_DEPTH_READ;
+        if (access & RG_ACCESS_SHADER_READ)      states |= D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
+        if (access & RG_ACCESS_COPY_SOURCE)      states |= D3D12_RESOURCE_STATE_COPY_SOURCE;
+        return states; // Present is the common state
+    }
+
+    D3D12_RESOURCE_DESC ToResourceDesc(const RGTextureDesc& desc, uint32_t usage)
+    {
+        D3D12_RESOURCE_FLAGS flags = D3D12_RESOURCE_FLAG_NONE;
+        if (usage & RG_ACCESS_RENDER_TARGET)
+            flags |= D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET;
+        if (usage & (RG_ACCESS_DEPTH_WRITE | RG_ACCESS_DEPTH_READ))
+            flags |= D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL;
+        if (usage & RG_ACCESS_UNORDERED_ACCESS)
+            flags |= D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
+
+        return CD3DX12_RESOURCE_DESC::Tex2D(static_cast<DXGI_FORMAT>(desc.Format), desc.Width, desc.Height, static_cast<UINT16>(desc.DepthOrArraySize), 1, 1, 0, flags);
+    }
+
+    bool SameDesc(const RGTextureDesc& a, const RGTextureDesc& b)
+    {
+        return a.Width == b.Width && a.Height == b.Height && a.DepthOrArraySize == b.DepthOrArraySize && a.Format == b.Format;
+    }
+}
+
+class RenderGraphExecutor::Context : public RGPassContext
+{
+public:
+    explicit Context(const RenderGraphExecutor& executor) : mExecutor(executor) {}
+
+    ID3D12Resource* GetResource(RGResourceHandle resource) const override
+    {
+        return mExecutor.GetResource(resource);
+    }
+
+    uint64_t GetRTV(RGResourceHandle resource) const override
+    {
+        if (resource < mExecutor.mImports.size() && mExecutor.mImports[resource].pResource)
+            return mExecutor.mImports[resource].RTV.ptr;
+
+        return resource < mExecutor.mTransients.size() ? mExecutor.mTransients[resource].RTV.ptr : 0;
+    }
+
+    uint64_t GetDSV(RGResourceHandle resource) const override
+    {
+        if (resource < mExecutor.mImports.size() && mExecutor.mImports[resource].pResource)
+            return mExecutor.mImports[resource].DSV.ptr;
+
+        return resource < mExecutor.mTransients.size() ? mExecutor.mTransients[resource].DSV.ptr : 0;
+    }
+
+private:
+    const RenderGraphExecutor& mExecutor;
+};
+
+bool RenderGraphExecutor::Init()
+{
+    ID3D12Device* pDevice = GetDevice();
+    if (!pDevice)
+        return false;
+
+    D3D12_FEATURE_DATA_D3D12_OPTIONS options = {};
+    HRESULT hr = pDevice->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS, &options, sizeof(options));
+    mUsePlacedResources = SUCCEEDED(hr) && options.ResourceHeapTier >= D3D12_RESOURCE_HEAP_TIER_2;
+    if (!mUsePlacedResources)
+        Muon::Print("Warning: Resource heap tier 1, render graph transients won't be aliased!\n");
+
+    D3D12_DESCRIPTOR_HEAP_DESC heapDesc = {};
+    heapDesc.NumDescriptors = RG_MAX_RESOURCES;
+    heapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
+    heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+    hr = pDevice->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(mpRTVHeap.GetAddressOf()));
+    COM_EXCEPT(hr);
+    if (FAILED(hr))
+        return false;
+
+    heapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_DSV;
+    hr = pDevice->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(mpDSVHeap.GetAddressOf()));
+    COM_EXCEPT(hr);
+    if (FAILED(hr))
+        return false;
+
+    mpRTVHeap->SetName(L"Render Graph RTV Heap");
+    mpDSVHeap->SetName(L"Render Graph DSV Heap");
+    mRTVSize = pDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
+    mDSVSize = pDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_DSV);
+    return true;
+}
+
+void RenderGraphExecutor::Destroy()
+{
+    mTransients.clear();
+    mImports.clear();
+    mpHeap.Reset();
+    mHeapSize = 0;
+    mpRTVHeap.Reset();
+    mpDSVHeap.Reset();
+}
+
+void RenderGraphExecutor::SetImportedTexture(RGResourceHandle resource, ID3D12Resource* pResource, D3D12_CPU_DESCRIPTOR_HANDLE rtv, D3D12_CPU_DESCRIPTOR_HANDLE dsv)
+{
+    if (resource >= RG_MAX_RESOURCES)
+    {
+        Muon::Printf("Error: Render graph resource %u is past RG_MAX_RESOURCES!\n", resource);
+        return;
+    }
+
+    if (resource >= mImports.size())
+        mImports.resize(resource + 1);
+
+    mImports[resource] = { pResource, rtv, dsv };
+}
+
+ID3D12Resource* RenderGraphExecutor::GetResource(RGResourceHandle resource) const
+{
+    if (resource < mImports.size() && mImports[resource].pResource)
+        return mImports[resource].pResource;
+
+    return resource < mTransients.size() ? mTransients[resource].Resource.Get() : nullptr;
+}
+
+bool RenderGraphExecutor::Execute(RenderGraph& graph, ID3D12GraphicsCommandList* pCommandList)
+{
+    ID3D12Device* pDevice = GetDevice();
+    if (!pDevice || !pCommandList)
+        return false;
+
+    if (graph.GetResources().size() > RG_MAX_RESOURCES)
+    {
+        Muon::Printf("Error: Render graph declares %zu resources, the executor supports %u!\n", graph.GetResources().size(), RG_MAX_RESOURCES);
+        return false;
+    }
+
+    const RGMemoryFunc memoryFunc = [this, pDevice](const RGTextureDesc& desc, uint32_t usage)
+    {
+        const D3D12_RESOURCE_DESC resourceDesc = ToResourceDesc(desc, usage);
+        const D3D12_RESOURCE_ALLOCATION_INFO info = pDevice->GetResourceAllocationInfo(0, 1, &resourceDesc);
+
+        RGMemoryRequirements req;
+        req.Size = info.SizeInBytes;
+        req.Alignment = info.Alignment;
+        return req;
+    };
+
+    if (!graph.Compile(memoryFunc) || !RealizeTransients(graph))
+    {
+        mImports.clear();
+        return false;
+    }
+
+    const std::vector<RGBarrier>& barriers = graph.GetBarriers();
+    const std::vector<RenderGraph::Resource>& resources = graph.GetResources();
+    const Context context(*this);
+
+    for (uint32_t i = 0; i != graph.GetCompiledPasses().size(); ++i)
+    {
+        const RGCompiledPass& compiled = graph.GetCompiledPasses()[i];
+        RecordBarriers(graph, barriers.data() + compiled.FirstBarrier, compiled.NumBarriers, pCommandList);
+
+        // Aliased render and depth targets hold another transient's memory until discarded, and by now they're in their first access state
+        const RenderGraph::Pass& pass = graph.GetPass(compiled.Pass);
+        if (mUsePlacedResources)
+        {
+            for (const RenderGraph::Access& access : pass.Accesses)
+            {
+                const RenderGraph::Resource& resource = resources[access.Resource];
+                if (!resource.Imported && resource.Aliases && resource.FirstUse == i && (access.Flags & (RG_ACCESS_RENDER_TARGET | RG_ACCESS_DEPTH_WRITE)))
+                    pCommandList->DiscardResource(GetResource(access.Resource), nullptr);
+            }
+        }
+
+        if (pass.Execute)
+            pass.Execute(context, pCommandList);
+    }
+
+    const std::vector<RGBarrier>& finalBarriers = graph.GetFinalBarriers();
+    RecordBarriers(graph, finalBarriers.data(), static_cast<uint32_t>(finalBarriers.size()), pCommandList);
+
+    mImports.clear();
+    return true;
+}
+
+void RenderGraphExecutor::RecordBarriers(const RenderGraph& graph, const RGBarrier* pBarriers, uint32_t numBarriers, ID3D12GraphicsCommandList* pCommandList) const
+{
+    static const uint32_t kMaxBatch = 32;
+    D3D12_RESOURCE_BARRIER batch[kMaxBatch];
+    uint32_t numBatched = 0;
+
+    for (uint32_t i = 0; i != numBarriers; ++i)
+    {
+        const RGBarrier& barrier = pBarriers[i];
+        ID3D12Resource* pResource = GetResource(barrier.Resource);
+        if (!pResource)
+        {
+            Muon::Printf("Error: Render graph resource '%s' has no physical resource bound!\n", graph.GetResources()[barrier.Resource].Name.c_str());
+            continue;
+        }
+
+        switch (barrier.BarrierType)
+        {
+        case RGBarrier::Transition:
+            batch[numBatched++] = CD3DX12_RESOURCE_BARRIER::Transition(pResource, ToResourceStates(barrier.Before), ToResourceStates(barrier.After));
+            break;
+        case RGBarrier::Aliasing:
+            // Committed fallbacks don't share memory
+            if (!mUsePlacedResources)
+                continue;
+            batch[numBatched++] = CD3DX12_RESOURCE_BARRIER::Aliasing(nullptr, pResource);
+            break;
+        case RGBarrier::UAV:
+            batch[numBatched++] = CD3DX12_RESOURCE_BARRIER::UAV(pResource);
+            break;
+        }
+
+        if (numBatched == kMaxBatch)
+        {
+            pCommandList->ResourceBarrier(numBatched, batch);
+            numBatched = 0;
+        }
+    }
+
+    if (numBatched)
+        pCommandList->ResourceBarrier(numBatched, batch);
+}
+
+// Keeps last frame's transients when nothing about them changed, which is the common case. Anything else waits for the GPU
+// to let go of the old resources first, so this should only happen on resizes or when the set of passes changes.
+bool RenderGraphExecutor::RealizeTransients(const RenderGraph& graph)
+{
+    const std::vector<RenderGraph::Resource>& resources = graph.GetResources();
+
+    bool changed = resources.size() != mTransients.size() || (mUsePlacedResources && graph.GetTransientHeapSize() > mHeapSize);
+    for (size_t i = 0; i != resources.size() && !changed; ++i)
+    {
+        const RenderGraph::Resource& resource = resources[i];
+        const PhysicalTexture& physical = mTransients[i];
+        const bool wanted = !resource.Imported && resource.Used;
+        if (wanted != (physical.Resource != nullptr))
+            changed = true;
+        else if (wanted)
+            changed = !SameDesc(resource.Desc, physical.Desc) || resource.Usage != physical.Usage || resource.InitialAccess != physical.InitialAccess
+                || (mUsePlacedResources && resource.HeapOffset != physical.HeapOffset);
+    }
+
+    if (!changed)
+        return true;
+
+    FlushCommandQueue();
+    mTransients.clear();
+    mTransients.resize(resources.size());
+
+    if (mUsePlacedResources && graph.GetTransientHeapSize() > mHeapSize)
+    {
+        mpHeap.Reset();
+        mHeapSize = 0;
+
+        D3D12_HEAP_DESC heapDesc = {};
+        heapDesc.SizeInBytes = graph.GetTransientHeapSize();
+        heapDesc.Properties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
+        heapDesc.Alignment = D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT;
+        heapDesc.Flags = D3D12_HEAP_FLAG_ALLOW_ALL_BUFFERS_AND_TEXTURES;
+
+        HRESULT hr = GetDevice()->CreateHeap(&heapDesc, IID_PPV_ARGS(mpHeap.GetAddressOf()));
+        COM_EXCEPT(hr);
+        if (FAILED(hr))
+            return false;
+
+        mpHeap->SetName(L"Render Graph Transient Heap");
+        mHeapSize = heapDesc.SizeInBytes;
+    }
+
+    bool success = true;
+    for (RGResourceHandle i = 0; i != resources.size(); ++i)
+    {
+        if (!resources[i].Imported && resources[i].Used)
+            success &= CreateTransient(i, resources[i], mTransients[i]);
+    }
+
+    const RGCompileStats& stats = graph.GetCompileStats();
+    Muon::Printf("Info: Render graph: %u passes (%u culled), %u barriers, %.2f MB of transients in %.2f MB, compiled in %.3f ms\n",
+        stats.NumPasses, stats.NumCulledPasses, stats.NumBarriers, stats.UnaliasedBytes / (1024.0 * 1024.0), stats.TransientBytes / (1024.0 * 1024.0), stats.CompileMs);
+
+    return success;
+}
+
+bool RenderGraphExecutor::CreateTransient(RGResourceHandle handle, const RenderGraph::Resource& resource, PhysicalTexture& out_texture)
+{
+    ID3D12Device* pDevice = GetDevice();
+    const D3D12_RESOURCE_DESC desc = ToResourceDesc(resource.Desc, resource.Usage);
+
+    // Created in the state the graph leaves them in at the end of a frame, so every frame starts from the same state
+    const D3D12_RESOURCE_STATES initialState = ToResourceStates(resource.InitialAccess);
+
+    HRESULT hr;
+    if (mUsePlacedResources)
+    {
+        hr = pDevice->CreatePlacedResource(mpHeap.Get(), resource.HeapOffset, &desc, initialState, nullptr, IID_PPV_ARGS(out_texture.Resource.GetAddressOf()));
+    }
+    else
+    {
+        const CD3DX12_HEAP_PROPERTIES heapProps(D3D12_HEAP_TYPE_DEFAULT);
+        hr = pDevice->CreateCommittedResource(&heapProps, D3D12_HEAP_FLAG_NONE, &desc, initialState, nullptr, IID_PPV_ARGS(out_texture.Resource.GetAddressOf()));
+    }
+    COM_EXCEPT(hr);
+    if (FAILED(hr))
+        return false;
+
+    out_texture.Resource->SetName(std::wstring(resource.Name.begin(), resource.Name.end()).c_str());
+    out_texture.Desc = resource.Desc;
+    out_texture.Usage = resource.Usage;
+    out_texture.InitialAccess = resource.InitialAccess;
+    out_texture.HeapOffset = resource.HeapOffset;
+
+    if (resource.Usage & RG_ACCESS_RENDER_TARGET)
+    {
+        out_texture.RTV = CD3DX12_CPU_DESCRIPTOR_HANDLE(mpRTVHeap->GetCPUDescriptorHandleForHeapStart(), handle, mRTVSize);
+        pDevice->CreateRenderTargetView(out_texture.Resource.Get(), nullptr, out_texture.RTV);
+    }
+
+    if (resource.Usage & (RG_ACCESS_DEPTH_WRITE | RG_ACCESS_DEPTH_READ))
+    {
+        out_texture.DSV = CD3DX12_CPU_DESCRIPTOR_HANDLE(mpDSVHeap->GetCPUDescriptorHandleForHeapStart(), handle, mDSVSize);
+        pDevice->CreateDepthStencilView(out_texture.Resource.Get(), nullptr, out_texture.DSV);
+    }
+
+    return true;
+}
+
+}
@@ -0,0 +1,78 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Runs a compiled RenderGraph on a D3D12 command list
+Transient textures are placed resources in one heap, recreated only when the graph's layout changes.
+----------------------------------------------*/
+#ifndef MUON_RENDERGRAPHEXECUTOR_H
+#define MUON_RENDERGRAPHEXECUTOR_H
+
+#include <Core/DXCore.h>
+#include <Core/RenderGraph.h>
+
+#include <vector>
+#include <wrl/client.h>
+
+namespace Muon
+{
+
+// Resource handles past this can't be executed, it sizes the executor's RTV and DSV heaps
+static const uint32_t RG_MAX_RESOURCES = 256;
+
+class RenderGraphExecutor
+{
+public:
+    bool Init();
+    void Destroy();
+
+    // Imported handles are only valid for the graph they came from, so bind them again every frame before Execute
+    void SetImportedTexture(RGResourceHandle resource, ID3D12Resource* pResource, D3D12_CPU_DESCRIPTOR_HANDLE rtv = {}, D3D12_CPU_DESCRIPTOR_HANDLE dsv = {});
+
+    // Compiles the graph, then records its barriers and passes. Passes may submit and reopen pCommandList (e.g. RecordInParallel),
+    // everything after them is recorded into the reopened list.
+    bool Execute(RenderGraph& graph, ID3D12GraphicsCommandList* pCommandList);
+
+private:
+    class Context;
+
+    struct PhysicalTexture
+    {
+        Microsoft::WRL::ComPtr<ID3D12Resource> Resource;
+        RGTextureDesc Desc;
+        uint32_t Usage = RG_ACCESS_NONE;
+        uint32_t InitialAccess = RG_ACCESS_NONE;
+        uint64_t HeapOffset = 0;
+        D3D12_CPU_DESCRIPTOR_HANDLE RTV = {};
+        D3D12_CPU_DESCRIPTOR_HANDLE DSV = {};
+    };
+
+    struct ImportedTexture
+    {
+        ID3D12Resource* pResource = nullptr;
+        D3D12_CPU_DESCRIPTOR_HANDLE RTV = {};
+        D3D12_CPU_DESCRIPTOR_HANDLE DSV = {};
+    };
+
+    bool RealizeTransients(const RenderGraph& graph);
+    bool CreateTransient(RGResourceHandle handle, const RenderGraph::Resource& resource, PhysicalTexture& out_texture);
+    void RecordBarriers(const RenderGraph& graph, const RGBarrier* pBarriers, uint32_t numBarriers, ID3D12GraphicsCommandList* pCommandList) const;
+    ID3D12Resource* GetResource(RGResourceHandle resource) const;
+
+    Microsoft::WRL::ComPtr<ID3D12Heap> mpHeap;
+    uint64_t mHeapSize = 0;
+
+    // Resource heap tier 1 can't put render targets and other textures in one heap, so transients fall back to committed resources without aliasing
+    bool mUsePlacedResources = false;
+
+    Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> mpRTVHeap;
+    Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> mpDSVHeap;
+    UINT mRTVSize = 0;
+    UINT mDSVSize = 0;
+
+    std::vector<PhysicalTexture> mTransients; // Indexed by resource handle
+    std::vector<ImportedTexture> mImports;    // Indexed by resource handle, cleared after every Execute
+};
+
+}
+
+#endif
@@ -0,0 +1,253 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Orders a frame's draw packets by 64-bit sort keys to minimize state changes
+----------------------------------------------*/
+#include <Core/RenderQueue.h>
+
+#include <Core/JobSystem.h>
+#include <Utils/Utils.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string.h>
+
+namespace Muon
+{
+
+namespace
+{
+    static const uint32_t kRadixBits = 8;
+    static const uint32_t kNumBuckets = 1 << kRadixBits;
+    static const uint32_t kNumRadixPasses = 64 / kRadixBits;
+
+    // Below this many keys per chunk, handing chunks to other threads costs more than it saves
+    static const size_t kMinKeysPerChunk = 16384;
+
+    static const uint32_t SORTKEY_DEPTH_BITS = 32;
+    static const uint32_t SORTKEY_MATERIAL_SHIFT = SORTKEY_DEPTH_BITS;
+    static const uint32_t SORTKEY_PIPELINE_SHIFT = SORTKEY_MATERIAL_SHIFT + SORTKEY_MATERIAL_BITS;
+    static const uint32_t SORTKEY_PASS_SHIFT = SORTKEY_PIPELINE_SHIFT + SORTKEY_PIPELINE_BITS;
+
+    // Depth first keeps the pass on top and moves depth above the state IDs
+    static const uint32_t SORTKEY_DF_PIPELINE_SHIFT = SORTKEY_MATERIAL_BITS;
+    static const uint32_t SORTKEY_DF_DEPTH_SHIFT = SORTKEY_DF_PIPELINE_SHIFT + SORTKEY_PIPELINE_BITS;
+
+    static_assert(SORTKEY_PASS_SHIFT + SORTKEY_PASS_BITS == 64, "Sort key fields must fill 64 bits");
+    static_assert(SORTKEY_DF_DEPTH_SHIFT + SORTKEY_DEPTH_BITS == SORTKEY_PASS_SHIFT, "Both key layouts must share the pass field");
+    static_assert(RENDERPASS_COUNT <= (1 << SORTKEY_PASS_BITS), "Too many render passes for the sort key");
+
+    uint32_t Digit(uint64_t key, uint32_t pass)
+    {
+        return static_cast<uint32_t>(key >> (pass * kRadixBits)) & (kNumBuckets - 1);
+    }
+
+    // Flips the float's bits so unsigned comparison matches float order, negatives included
+    uint32_t OrderedFloatBits(float value)
+    {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+    }
+}
+
+uint64_t EncodeSortKey(uint8_t pass, uint16_t pipelineSortID, uint16_t materialSortID, float depth, SortOrder order)
+{
+    const uint64_t passBits = uint64_t(pass & ((1u << SORTKEY_PASS_BITS) - 1)) << SORTKEY_PASS_SHIFT;
+    const uint64_t pipelineID = pipelineSortID & ((1u << SORTKEY_PIPELINE_BITS) - 1);
+    const uint64_t depthBits = OrderedFloatBits(depth);
+
+    if (order == SORTORDER_DEPTH_FIRST)
+        return passBits | (depthBits << SORTKEY_DF_DEPTH_SHIFT) | (pipelineID << SORTKEY_DF_PIPELINE_SHIFT) | materialSortID;
+
+    return passBits | (pipelineID << SORTKEY_PIPELINE_SHIFT) | (uint64_t(materialSortID) << SORTKEY_MATERIAL_SHIFT) | depthBits;
+}
+
+uint8_t GetSortKeyPass(uint64_t key)
+{
+    return static_cast<uint8_t>(key >> SORTKEY_PASS_SHIFT);
+}
+
+uint16_t GetSortKeyPipeline(uint64_t key, SortOrder order)
+{
+    const uint32_t shift = order == SORTORDER_DEPTH_FIRST ? SORTKEY_DF_PIPELINE_SHIFT : SORTKEY_PIPELINE_SHIFT;
+    return static_cast<uint16_t>((key >> shift) & ((1u << SORTKEY_PIPELINE_BITS) - 1));
+}
+
+uint16_t GetSortKeyMaterial(uint64_t key, SortOrder order)
+{
+    const uint32_t shift = order == SORTORDER_DEPTH_FIRST ? 0 : SORTKEY_MATERIAL_SHIFT;
+    return static_cast<uint16_t>(key >> shift);
+}
+
+uint16_t SortIDTable::GetID(const void* ptr)
+{
+    auto it = mIDs.find(ptr);
+    if (it != mIDs.end())
+        return it->second;
+
+    if (mIDs.size() >= mMaxID)
+    {
+        if (!mWarnedFull)
+        {
+            Muon::Printf("Warning: Sort ID table is full at %u entries, further entries share one ID!\n", mMaxID);
+            mWarnedFull = true;
+        }
+        return static_cast<uint16_t>(mMaxID);
+    }
+
+    const uint16_t id = static_cast<uint16_t>(mIDs.size());
+    mIDs.emplace(ptr, id);
+    return id;
+}
+
+// LSD radix sort. Each pass counts digits per chunk, turns the counts into per-chunk output offsets, then every chunk
+// scatters its keys independently. Chunks write in chunk order within each bucket, which keeps the sort stable.
+void RadixSortKeys(uint64_t* pKeys, uint32_t* pValues, size_t count, uint64_t* pTempKeys, uint32_t* pTempValues)
+{
+    if (count < 2)
+        return;
+
+    uint32_t numChunks = 1;
+    if (count >= 2 * kMinKeysPerChunk)
+        numChunks = static_cast<uint32_t>(std::min<size_t>(JobSystem::GetSingleton().GetNumThreads(), count / kMinKeysPerChunk));
+
+    const size_t chunkSize = (count + numChunks - 1) / numChunks;
+    auto forEachChunk = [numChunks](const JobSystem::RangeJob& func)
+    {
+        if (numChunks == 1)
+            func(0, 1);
+        else
+            JobSystem::GetSingleton().ParallelFor(numChunks, 1, func);
+    };
+
+    // One read over the keys counts every digit of every pass, so passes where all keys agree are known up front
+    std::vector<uint32_t> histograms(size_t(numChunks) * kNumRadixPasses * kNumBuckets, 0);
+    forEachChunk([&](size_t chunkBegin, size_t chunkEnd)
+    {
+        for (size_t c = chunkBegin; c != chunkEnd; ++c)
+        {
+            uint32_t* pHistogram = &histograms[c * kNumRadixPasses * kNumBuckets];
+            const size_t end = std::min(count, (c + 1) * chunkSize);
+            for (size_t i = c * chunkSize; i < end; ++i)
+            {
+                const uint64_t key = pKeys[i];
+                for (uint32_t pass = 0; pass != kNumRadixPasses; ++pass)
+                    pHistogram[pass * kNumBuckets + Digit(key, pass)]++;
+            }
+        }
+    });
+
+    uint64_t* pSrcKeys = pKeys;
+    uint32_t* pSrcValues = pValues;
+    uint64_t* pDstKeys = pTempKeys;
+    uint32_t* pDstValues = pTempValues;
+
+    std::vector<uint32_t> offsets(size_t(numChunks) * kNumBuckets);
+    bool permuted = false;
+
+    for (uint32_t pass = 0; pass != kNumRadixPasses; ++pass)
+    {
+        size_t firstDigitCount = 0;
+        const uint32_t firstDigit = Digit(pKeys[0], pass);
+        for (uint32_t c = 0; c != numChunks; ++c)
+            firstDigitCount += histograms[(size_t(c) * kNumRadixPasses + pass) * kNumBuckets + firstDigit];
+
+        if (firstDigitCount == count)
+            continue;
+
+        // The up-front counts only describe each chunk until the first scatter moves keys between chunks
+        if (permuted && numChunks > 1)
+        {
+            forEachChunk([&](size_t chunkBegin, size_t chunkEnd)
+            {
+                for (size_t c = chunkBegin; c != chunkEnd; ++c)
+                {
+                    uint32_t* pHistogram = &histograms[(c * kNumRadixPasses + pass) * kNumBuckets];
+                    memset(pHistogram, 0, kNumBuckets * sizeof(uint32_t));
+
+                    const size_t end = std::min(count, (c + 1) * chunkSize);
+                    for (size_t i = c * chunkSize; i < end; ++i)
+                        pHistogram[Digit(pSrcKeys[i], pass)]++;
+                }
+            });
+        }
+
+        uint32_t running = 0;
+        for (uint32_t digit = 0; digit != kNumBuckets; ++digit)
+        {
+            for (uint32_t c = 0; c != numChunks; ++c)
+            {
+                offsets[size_t(c) * kNumBuckets + digit] = running;
+                running += histograms[(size_t(c) * kNumRadixPasses + pass) * kNumBuckets + digit];
+            }
+        }
+
+        forEachChunk([&](size_t chunkBegin, size_t chunkEnd)
+        {
+            for (size_t c = chunkBegin; c != chunkEnd; ++c)
+            {
+                uint32_t* pOffsets = &offsets[c * kNumBuckets];
+                const size_t end = std::min(count, (c + 1) * chunkSize);
+                for (size_t i = c * chunkSize; i < end; ++i)
+                {
+                    const uint32_t dst = pOffsets[Digit(pSrcKeys[i], pass)]++;
+                    pDstKeys[dst] = pSrcKeys[i];
+                    pDstValues[dst] = pSrcValues[i];
+                }
+            }
+        });
+
+        std::swap(pSrcKeys, pDstKeys);
+        std::swap(pSrcValues, pDstValues);
+        permuted = true;
+    }
+
+    if (pSrcKeys != pKeys)
+    {
+        memcpy(pKeys, pSrcKeys, count * sizeof(uint64_t));
+        memcpy(pValues, pSrcValues, count * sizeof(uint32_t));
+    }
+}
+
+RenderQueue::RenderQueue() :
+    mPipelineIDs(SORTKEY_PIPELINE_BITS),
+    mMaterialIDs(SORTKEY_MATERIAL_BITS)
+{
+    for (SortOrder& order : mPassOrders)
+        order = SORTORDER_DEPTH_FIRST;
+}
+
+void RenderQueue::Reset()
+{
+    mKeys.clear();
+    mIndices.clear();
+    mStats = {};
+}
+
+void RenderQueue::Push(uint8_t pass, const void* pPipeline, const void* pMaterial, float depth, uint32_t packetIndex)
+{
+    mKeys.push_back(EncodeSortKey(pass, mPipelineIDs.GetID(pPipeline), mMaterialIDs.GetID(pMaterial), depth, mPassOrders[pass]));
+    mIndices.push_back(packetIndex);
+}
+
+void RenderQueue::Sort()
+{
+    using Clock = std::chrono::high_resolution_clock;
+    const Clock::time_point sortStart = Clock::now();
+
+    mTempKeys.resize(mKeys.size());
+    mTempIndices.resize(mIndices.size());
+    RadixSortKeys(mKeys.data(), mIndices.data(), mKeys.size(), mTempKeys.data(), mTempIndices.data());
+
+    mStats.NumPackets = static_cast<uint32_t>(mKeys.size());
+    mStats.SortMs = std::chrono::duration<double, std::milli>(Clock::now() - sortStart).count();
+}
+
+size_t RenderQueue::GetPassBegin(uint8_t pass) const
+{
+    const uint64_t firstKey = uint64_t(pass) << SORTKEY_PASS_SHIFT;
+    return std::lower_bound(mKeys.begin(), mKeys.end(), firstKey) - mKeys.begin();
+}
+
+}
@@ -0,0 +1,115 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Orders a frame's draw packets by 64-bit sort keys to minimize state changes
+----------------------------------------------*/
+#ifndef MUON_RENDERQUEUE_H
+#define MUON_RENDERQUEUE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+
+namespace Muon
+{
+
+// Passes sort before everything else in the key, so all of one pass is drawn before the next
+enum RenderPassID : uint8_t
+{
+    RENDERPASS_DEPTH_PREPASS = 0,
+    RENDERPASS_OPAQUE,
+    RENDERPASS_COUNT
+};
+
+// What a pass sorts on after the pass itself. State first minimizes binds, depth first gets the most out of early depth
+// rejection but only batches state between packets at the same depth.
+enum SortOrder : uint8_t
+{
+    SORTORDER_STATE_FIRST = 0,
+    SORTORDER_DEPTH_FIRST
+};
+
+// Key layouts, most significant first:
+//  State first: [63:60] pass       [59:48] pipeline sort ID       [47:32] material sort ID       [31:0] depth
+//  Depth first: [63:60] pass       [59:28] depth                  [27:16] pipeline sort ID       [15:0] material sort ID
+// Depth sorts ascending, i.e. front to back. Pass a negated depth for back to front.
+static const uint32_t SORTKEY_PASS_BITS = 4;
+static const uint32_t SORTKEY_PIPELINE_BITS = 12;
+static const uint32_t SORTKEY_MATERIAL_BITS = 16;
+
+uint64_t EncodeSortKey(uint8_t pass, uint16_t pipelineSortID, uint16_t materialSortID, float depth, SortOrder order = SORTORDER_STATE_FIRST);
+uint8_t GetSortKeyPass(uint64_t key);
+uint16_t GetSortKeyPipeline(uint64_t key, SortOrder order = SORTORDER_STATE_FIRST);
+uint16_t GetSortKeyMaterial(uint64_t key, SortOrder order = SORTORDER_STATE_FIRST);
+
+// Maps pointers to the small dense IDs that fit in a sort key. IDs are handed out on first use and kept,
+// so the key order of a pipeline or material stays the same from frame to frame.
+class SortIDTable
+{
+public:
+    explicit SortIDTable(uint32_t numBits) : mMaxID((1u << numBits) - 1) {}
+
+    // Returns the last ID for every pointer once the table is full, which only costs sorting quality
+    uint16_t GetID(const void* ptr);
+    void Clear() { mIDs.clear(); }
+
+private:
+    std::unordered_map<const void*, uint16_t> mIDs;
+    uint32_t mMaxID;
+    bool mWarnedFull = false;
+};
+
+// Sorts keys ascending and carries values along. Stable, 8 bits per pass, and skips passes where every key
+// shares the digit. Large inputs are split across the job system, which must be initialized for that.
+// pTempKeys and pTempValues must hold count elements each. The result ends up back in pKeys and pValues.
+void RadixSortKeys(uint64_t* pKeys, uint32_t* pValues, size_t count, uint64_t* pTempKeys, uint32_t* pTempValues);
+
+struct RenderQueueStats
+{
+    uint32_t NumPackets = 0;
+    double SortMs = 0.0;
+};
+
+// The queue only holds keys and the caller's packet indices. Packets themselves stay wherever the caller keeps them,
+// and recording walks GetSortedIndex(0..GetCount()) comparing each packet with the previous one.
+class RenderQueue
+{
+public:
+    RenderQueue();
+
+    void Reset();
+
+    // Every pass defaults to depth first, i.e. opaque draws go front to back. Applies to packets pushed afterwards.
+    void SetPassOrder(uint8_t pass, SortOrder order) { mPassOrders[pass] = order; }
+
+    // Not thread safe, packets are pushed on the main thread
+    void Push(uint8_t pass, const void* pPipeline, const void* pMaterial, float depth, uint32_t packetIndex);
+
+    void Sort();
+
+    // After Sort, the pass's packets are the sorted range [GetPassBegin(pass), GetPassBegin(pass + 1))
+    size_t GetPassBegin(uint8_t pass) const;
+
+    size_t GetCount() const { return mKeys.size(); }
+    uint64_t GetSortedKey(size_t i) const { return mKeys[i]; }
+    uint32_t GetSortedIndex(size_t i) const { return mIndices[i]; }
+
+    const RenderQueueStats& GetStats() const { return mStats; }
+
+private:
+    SortIDTable mPipelineIDs;
+    SortIDTable mMaterialIDs;
+    SortOrder mPassOrders[RENDERPASS_COUNT];
+
+    std::vector<uint64_t> mKeys;
+    std::vector<uint32_t> mIndices;
+    std::vector<uint64_t> mTempKeys;
+    std::vector<uint32_t> mTempIndices;
+
+    RenderQueueStats mStats;
+};
+
+}
+
+#endif
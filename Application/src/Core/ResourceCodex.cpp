@@ -5,7 +5,9 @@ Description : Master Resource Distributor
 ----------------------------------------------*/
 #include "ResourceCodex.h"
 
+#include <Core/CodexManifest.h>
 #include <Core/PathMacros.h>
+#include <Core/Profiler.h>
 #include <Utils/Utils.h>
 #include "Factories.h"
 #include "Material.h"
@@ -14,12 +16,19 @@ Description : Master Resource Distributor
 
 #include "hash_util.h"
 
+#include <chrono>
+
 namespace Muon
 {
 static ResourceCodex* gCodexInstance = nullptr;
+static const size_t kMaxMaterialTypes = 64;
+
+// Keeps each volume's copies to 128KB a frame, so a fast camera fills in over a few frames instead of hitching
+static const uint32_t kMaxCloudBricksPerUpdate = 256;
 
 MeshID ResourceCodex::AddMeshFromFile(const char* fileName, const VertexBufferDescription* vertAttr)
 {
+    MUON_PROFILE_SCOPE("Load Mesh");
     ResourceCodex& codexInstance = GetSingleton();
 
     Mesh mesh;
@@ -48,6 +57,7 @@ ResourceCodex& ResourceCodex::GetSingleton()
 
 void ResourceCodex::Init()
 {
+    MUON_PROFILE_SCOPE("Load Assets");
     if (gCodexInstance)
     {
         Muon::Print("ERROR: Tried to initialize already initialized ResourceCodex!\n");
@@ -56,14 +66,29 @@ void ResourceCodex::Init()
 
     gCodexInstance = new ResourceCodex();
     gCodexInstance->mMeshStagingBuffer.Create(L"Mesh Staging Buffer", 64 * 1024 * 1024);
-    gCodexInstance->mMaterialParamsStagingBuffer.Create(L"material params staging buffer", sizeof(cbMaterialParams));
+    gCodexInstance->mMaterialParamsStagingBuffer.Create(L"material params staging buffer", kMaxMaterialTypes * GetConstantBufferSize(sizeof(cbMaterialParams)));
     gCodexInstance->mSRVDescriptorHeap.Init(GetDevice(), 64);
 
     //gCodexInstance->mTextureUploadBatch = std::make_unique<DirectX::ResourceUploadBatch>(GetDevice());
 
-    ShaderFactory::LoadAllShaders(*gCodexInstance);
-    TextureFactory::LoadAllTextures(GetDevice(), GetCommandList(), *gCodexInstance);
-    MaterialFactory::CreateAllMaterials(*gCodexInstance);
+    // The manifest decides which shaders and textures exist, the folders are never enumerated for them
+    using Clock = std::chrono::high_resolution_clock;
+    const Clock::time_point parseStart = Clock::now();
+
+    CodexManifest manifest;
+    bool fromBinary = false;
+    if (manifest.Load(fromBinary))
+    {
+        Muon::Printf("Info: Parsed asset manifest (%s) in %.3f ms.\n", fromBinary ? "binary" : "xml",
+            std::chrono::duration<double, std::milli>(Clock::now() - parseStart).count());
+
+        ShaderFactory::LoadAllShaders(*gCodexInstance, manifest);
+        ShaderFactory::LoadAllShaderSources(*gCodexInstance);
+        TextureFactory::LoadAllTextures(GetDevice(), GetCommandList(), *gCodexInstance, manifest);
+        MaterialFactory::CreateAllMaterials(*gCodexInstance, manifest);
+    }
+
+    CloudVolumeFactory::LoadAllCloudVolumes(*gCodexInstance);
 
     //gCodexInstance->mTextureUploadBatch.reset();
 }
@@ -85,9 +110,27 @@ void ResourceCodex::Destroy()
         mat.Destroy();
     }
     gCodexInstance->mMaterialTypeMap.clear();
+    gCodexInstance->mRootSignatureCache.clear();
 
     gCodexInstance->mMaterialParamsStagingBuffer.Destroy();
 
+    // In-flight compiles still write into their pending entries, so let them finish first
+    for (auto& p : gCodexInstance->mPendingVariants)
+    {
+        PendingShaderVariant& pending = *p.second;
+        try
+        {
+            JobSystem::GetSingleton().Wait(pending.Counter);
+        }
+        catch (...)
+        {
+        }
+        pending.VS.Release();
+        pending.PS.Release();
+    }
+    gCodexInstance->mPendingVariants.clear();
+    gCodexInstance->mShaderSources.clear();
+
     for (auto& s : gCodexInstance->mVertexShaders)
     {
         VertexShader& vs = s.second;
@@ -108,6 +151,7 @@ void ResourceCodex::Destroy()
         tex.Destroy();
     }
     gCodexInstance->mTextureMap.clear();
+    gCodexInstance->mCloudVolumes.clear();
     gCodexInstance->mSRVDescriptorHeap.Destroy();
 
     delete gCodexInstance;
@@ -138,6 +182,137 @@ const PixelShader* ResourceCodex::GetPixelShader(ShaderID UID) const
         return nullptr;
 }
 
+const ShaderPermutationSource* ResourceCodex::GetShaderSource(ShaderID baseID) const
+{
+    auto itFind = mShaderSources.find(baseID);
+    if (itFind == mShaderSources.end())
+        return nullptr;
+
+    return &itFind->second;
+}
+
+bool ResourceCodex::GetShaderVariantKey(ShaderID baseID, std::string_view defineList, VariantKey& out_key) const
+{
+    out_key = 0;
+    if (defineList.find_first_not_of(" ,\t") == std::string_view::npos)
+        return true;
+
+    const ShaderPermutationSource* pSource = GetShaderSource(baseID);
+    return pSource && pSource->GetVariantKey(defineList, out_key);
+}
+
+void ResourceCodex::RequestShaderVariant(ShaderID baseID, VariantKey key)
+{
+    const ShaderID variantID = GetShaderVariantID(baseID, key);
+    if (mVertexShaders.count(variantID) || mPixelShaders.count(variantID) || mPendingVariants.count(variantID))
+        return;
+
+    const ShaderPermutationSource* pSource = GetShaderSource(baseID);
+    if (!pSource)
+    {
+        Muon::Printf("Error: Requested variant 0x%08x of shader 0x%08x, which has no known source!\n", key, baseID);
+        return;
+    }
+
+    auto& pending = mPendingVariants[variantID];
+    pending = std::make_unique<PendingShaderVariant>();
+    pending->Source = *pSource;
+    pending->Key = key;
+
+    PendingShaderVariant* pPending = pending.get();
+    JobSystem::GetSingleton().Submit([pPending]()
+    {
+        MUON_PROFILE_SCOPE("Compile Shader Variant");
+        Microsoft::WRL::ComPtr<ID3DBlob> pBlob;
+        if (!CompileShaderVariant(pPending->Source, pPending->Key, pBlob, pPending->FromCache))
+            return;
+
+        if (pPending->Source.Stage == ShaderStage::Vertex)
+            pPending->Succeeded = pPending->VS.InitFromBlob(pBlob.Get(), pPending->Source.Path.c_str());
+        else
+            pPending->Succeeded = pPending->PS.InitFromBlob(pBlob.Get(), pPending->Source.Path.c_str());
+    }, &pPending->Counter);
+}
+
+const VertexShader* ResourceCodex::GetVertexShaderVariant(ShaderID baseID, VariantKey key, bool waitForCompile)
+{
+    const ShaderID variantID = GetShaderVariantID(baseID, key);
+    if (const VertexShader* pVS = GetVertexShader(variantID))
+        return pVS;
+
+    RequestShaderVariant(baseID, key);
+
+    auto itPending = mPendingVariants.find(variantID);
+    if (itPending == mPendingVariants.end())
+        return nullptr;
+
+    if (!waitForCompile && !itPending->second->Counter.IsDone())
+        return nullptr;
+
+    JobSystem::GetSingleton().Wait(itPending->second->Counter);
+    RetireShaderVariant(variantID, *itPending->second);
+    mPendingVariants.erase(itPending);
+
+    return GetVertexShader(variantID);
+}
+
+const PixelShader* ResourceCodex::GetPixelShaderVariant(ShaderID baseID, VariantKey key, bool waitForCompile)
+{
+    const ShaderID variantID = GetShaderVariantID(baseID, key);
+    if (const PixelShader* pPS = GetPixelShader(variantID))
+        return pPS;
+
+    RequestShaderVariant(baseID, key);
+
+    auto itPending = mPendingVariants.find(variantID);
+    if (itPending == mPendingVariants.end())
+        return nullptr;
+
+    if (!waitForCompile && !itPending->second->Counter.IsDone())
+        return nullptr;
+
+    JobSystem::GetSingleton().Wait(itPending->second->Counter);
+    RetireShaderVariant(variantID, *itPending->second);
+    mPendingVariants.erase(itPending);
+
+    return GetPixelShader(variantID);
+}
+
+void ResourceCodex::RetireShaderVariants()
+{
+    for (auto it = mPendingVariants.begin(); it != mPendingVariants.end();)
+    {
+        if (!it->second->Counter.IsDone())
+        {
+            ++it;
+            continue;
+        }
+
+        JobSystem::GetSingleton().Wait(it->second->Counter);
+        RetireShaderVariant(it->first, *it->second);
+        it = mPendingVariants.erase(it);
+    }
+}
+
+void ResourceCodex::RetireShaderVariant(ShaderID variantID, PendingShaderVariant& pending)
+{
+    const std::string variantName = pending.Source.GetVariantName(pending.Key);
+    if (!pending.Succeeded)
+    {
+        Muon::Printf(L"Error: Failed to build shader variant %s [%S]!\n", pending.Source.Path.c_str(), variantName.c_str());
+        pending.VS.Release();
+        pending.PS.Release();
+        return;
+    }
+
+    if (pending.Source.Stage == ShaderStage::Vertex)
+        AddVertexShader(variantID, std::move(pending.VS));
+    else
+        AddPixelShader(variantID, std::move(pending.PS));
+
+    Muon::Printf(L"Info: Shader variant %s [%S] ready%s.\n", pending.Source.Path.c_str(), variantName.c_str(), pending.FromCache ? L" (cached)" : L"");
+}
+
 const MaterialType* ResourceCodex::GetMaterialType(MaterialTypeID UID) const
 {
     if (mMaterialTypeMap.find(UID) != mMaterialTypeMap.end())
@@ -154,14 +329,87 @@ const Texture* ResourceCodex::GetTexture(TextureID UID) const
         return nullptr;
 }
 
-void ResourceCodex::AddVertexShader(ShaderID hash, const wchar_t* path)
-{   
-    mVertexShaders.emplace(hash, path);
+const SparseCloudVolume* ResourceCodex::GetCloudVolume(CloudVolumeID UID) const
+{
+    auto itFind = mCloudVolumes.find(UID);
+    if (itFind == mCloudVolumes.end())
+        return nullptr;
+
+    return itFind->second.get();
+}
+
+void ResourceCodex::UpdateCloudVolumeStreaming(const float cameraPos[3])
+{
+    for (auto& v : mCloudVolumes)
+        v.second->UpdateStreaming(cameraPos, kMaxCloudBricksPerUpdate);
 }
 
-void ResourceCodex::AddPixelShader(ShaderID hash, const wchar_t* path)
-{   
-    mPixelShaders.emplace(hash, path);
+void ResourceCodex::PrintCloudVolumeStats() const
+{
+    for (const auto& v : mCloudVolumes)
+    {
+        const SparseVolumeResidencyStats& stats = v.second->GetResidencyStats();
+        Muon::Printf("Info: Cloud volume 0x%08x: %u/%u bricks resident (%u pending), pool %.1f MB of a %.1f MB file, "
+            "%llu streamed in, %llu evicted, last update %.3f ms\n",
+            v.first, stats.NumResident, stats.NumBricks, stats.NumPending, stats.PoolBytes / (1024.0 * 1024.0), stats.FileBytes / (1024.0 * 1024.0),
+            static_cast<unsigned long long>(stats.TotalStreamedIn), static_cast<unsigned long long>(stats.TotalEvicted), stats.LastUpdateMs);
+    }
+}
+
+bool ResourceCodex::GetOrCreateRootSignature(const RootSignatureBuilder& builder, ID3D12RootSignature** ppRootSig)
+{
+    if (!ppRootSig)
+        return false;
+
+    const uint32_t hash = builder.GetHash();
+
+    // Hash collisions are possible, so every candidate still gets a full comparison
+    auto range = mRootSignatureCache.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        if (it->second.Desc.IsEquivalent(builder))
+            return SUCCEEDED(it->second.pRootSignature.CopyTo(ppRootSig));
+    }
+
+    CachedRootSignature entry;
+    entry.Desc = builder;
+    if (!builder.Build(GetDevice(), entry.pRootSignature.GetAddressOf()))
+        return false;
+
+    auto inserted = mRootSignatureCache.emplace(hash, std::move(entry));
+    return SUCCEEDED(inserted->second.pRootSignature.CopyTo(ppRootSig));
+}
+
+bool ResourceCodex::AddVertexShader(ShaderID hash, VertexShader&& vs)
+{
+    // try_emplace leaves vs untouched if the hash already exists, so it can still be released
+    if (!mVertexShaders.try_emplace(hash, std::move(vs)).second)
+    {
+        vs.Release();
+        Muon::Printf(L"Warning: Attempted to insert duplicate vertex shader: 0x%08x!\n", hash);
+        return false;
+    }
+
+    return true;
+}
+
+bool ResourceCodex::AddPixelShader(ShaderID hash, PixelShader&& ps)
+{
+    // try_emplace leaves ps untouched if the hash already exists, so it can still be released
+    if (!mPixelShaders.try_emplace(hash, std::move(ps)).second)
+    {
+        ps.Release();
+        Muon::Printf(L"Warning: Attempted to insert duplicate pixel shader: 0x%08x!\n", hash);
+        return false;
+    }
+
+    return true;
+}
+
+void ResourceCodex::AddShaderSource(ShaderPermutationSource&& source)
+{
+    const ShaderID baseID = source.BaseID;
+    mShaderSources[baseID] = std::move(source);
 }
 
 Texture& ResourceCodex::InsertTexture(TextureID hash)
@@ -174,6 +422,15 @@ Texture& ResourceCodex::InsertTexture(TextureID hash)
     return mTextureMap[hash];
 }
 
+void ResourceCodex::InsertCloudVolume(CloudVolumeID hash, std::unique_ptr<SparseCloudVolume> pVolume)
+{
+    std::unique_ptr<SparseCloudVolume>& pSlot = mCloudVolumes[hash];
+    if (pSlot)
+        Muon::Printf(L"Warning: Attempted to insert duplicate cloud volume: 0x%08x!\n", hash);
+    else
+        pSlot = std::move(pVolume);
+}
+
 MaterialType* ResourceCodex::InsertMaterialType(const wchar_t* name)
 {
     if (!name)
@@ -14,17 +14,23 @@ Description : Loads and distributes all static resources (materials, textures, e
 #include <Core/Shader.h>
 #include <Core/Buffers.h>
 #include <Core/DescriptorHeap.h>
+#include <Core/RootSignatureBuilder.h>
+#include <Core/ShaderCompiler.h>
+#include <Core/JobSystem.h>
+#include <Core/SparseCloudVolume.h>
 
 #include <ResourceUploadBatch.h>
 
 #include <unordered_map>
 #include <memory>
+#include <string_view>
 
 namespace Muon
 {
 struct MeshFactory;
 struct ShaderFactory;
 struct TextureFactory;
+struct CloudVolumeFactory;
 }
 
 namespace Muon
@@ -38,6 +44,7 @@ struct Texture
 
     UINT Width = 0;
     UINT Height = 0;
+    UINT Depth = 1; // Above 1 for volume textures
     DXGI_FORMAT Format = DXGI_FORMAT_UNKNOWN;
 
     bool IsValid() const { return pResource != nullptr && GPUHandle.ptr != 0; }
@@ -48,6 +55,7 @@ struct Texture
         GPUHandle = { 0 };
         Width = 0;
         Height = 0;
+        Depth = 1;
         Format = DXGI_FORMAT_UNKNOWN;
     }
 };
@@ -68,18 +76,63 @@ public:
     const VertexShader* GetVertexShader(ShaderID UID) const;
     const PixelShader* GetPixelShader(ShaderID UID) const;
     const MaterialType* GetMaterialType(MaterialTypeID UID) const;
+
+    // Shader permutations. Key 0 is the offline-built shader, any other variant is compiled from source on the job system
+    // the first time it's requested. With waitForCompile = false, this returns nullptr until RetireShaderVariants picks it up.
+    const ShaderPermutationSource* GetShaderSource(ShaderID baseID) const;
+    bool GetShaderVariantKey(ShaderID baseID, std::string_view defineList, VariantKey& out_key) const;
+    void RequestShaderVariant(ShaderID baseID, VariantKey key);
+    const VertexShader* GetVertexShaderVariant(ShaderID baseID, VariantKey key, bool waitForCompile = true);
+    const PixelShader* GetPixelShaderVariant(ShaderID baseID, VariantKey key, bool waitForCompile = true);
+
+    // Moves variants that finished compiling into the codex. Main thread only, once per frame.
+    void RetireShaderVariants();
     const Texture* GetTexture(TextureID UID) const;
+
+    // Sparse cloud volumes stay mapped from disk, each frame streams the bricks nearest the camera into their pools
+    const SparseCloudVolume* GetCloudVolume(CloudVolumeID UID) const;
+    void UpdateCloudVolumeStreaming(const float cameraPos[3]);
+    void PrintCloudVolumeStats() const;
+
     UploadBuffer& GetMeshStagingBuffer() { return mMeshStagingBuffer; }
     UploadBuffer& GetMatParamsStagingBuffer() { return mMaterialParamsStagingBuffer; }
     DescriptorHeap& GetSRVDescriptorHeap() { return mSRVDescriptorHeap; }
     DirectX::ResourceUploadBatch* GetUploadBatch() { return mTextureUploadBatch.get(); }
 
+    // Returns the root signature matching the builder's layout, only creating a new one if no equivalent layout has been seen yet.
+    bool GetOrCreateRootSignature(const RootSignatureBuilder& builder, ID3D12RootSignature** ppRootSig);
+    size_t GetNumRootSignatures() const { return mRootSignatureCache.size(); }
+
 private:
     std::unordered_map<ShaderID, VertexShader>  mVertexShaders;
     std::unordered_map<ShaderID, PixelShader>   mPixelShaders;
     std::unordered_map<MeshID, Mesh>            mMeshMap;
     std::unordered_map<TextureID, Texture>      mTextureMap;
     std::unordered_map<MaterialTypeID, MaterialType> mMaterialTypeMap;
+    std::unordered_map<CloudVolumeID, std::unique_ptr<SparseCloudVolume>> mCloudVolumes; // Not movable, they own a mapping
+
+    // Keyed by base ID. Only written while loading, so compile jobs can read them freely.
+    std::unordered_map<ShaderID, ShaderPermutationSource> mShaderSources;
+
+    // Everything a compile job touches lives here until the main thread retires it into mVertexShaders/mPixelShaders
+    struct PendingShaderVariant
+    {
+        ShaderPermutationSource Source;
+        VariantKey Key = 0;
+        JobCounter Counter;
+        VertexShader VS;
+        PixelShader PS;
+        bool Succeeded = false;
+        bool FromCache = false;
+    };
+    std::unordered_map<ShaderID, std::unique_ptr<PendingShaderVariant>> mPendingVariants; // Keyed by variant ID
+
+    struct CachedRootSignature
+    {
+        RootSignatureBuilder Desc;
+        Microsoft::WRL::ComPtr<ID3D12RootSignature> pRootSignature;
+    };
+    std::unordered_multimap<uint32_t, CachedRootSignature> mRootSignatureCache;
 
     // An intermediate upload buffer used for uploading vertex/index data to the GPU
     UploadBuffer mMeshStagingBuffer;
@@ -91,14 +144,21 @@ private:
 private:
     friend struct TextureFactory;
     Texture& InsertTexture(TextureID hash);
+
+    friend struct CloudVolumeFactory;
+    void InsertCloudVolume(CloudVolumeID hash, std::unique_ptr<SparseCloudVolume> pVolume); // Takes an opened volume
     
     friend struct MaterialFactory;
     //MaterialIndex PushMaterial(const Material& material);
     MaterialType* InsertMaterialType(const wchar_t* name);
 
     friend struct ShaderFactory;
-    void AddVertexShader(ShaderID hash, const wchar_t* path);
-    void AddPixelShader(ShaderID hash, const wchar_t* path);
+    // Shaders are loaded and reflected in parallel by the factory, only the insert into the codex is serialized.
+    bool AddVertexShader(ShaderID hash, VertexShader&& vs);
+    bool AddPixelShader(ShaderID hash, PixelShader&& ps);
+    void AddShaderSource(ShaderPermutationSource&& source);
+
+    void RetireShaderVariant(ShaderID variantID, PendingShaderVariant& pending);
 };
 }
 #endif
\ No newline at end of file
@@ -0,0 +1,84 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Chooses how reflected shader resources are bound in a root signature
+----------------------------------------------*/
+#include <Core/RootParameterPlan.h>
+#include <Core/Shader.h>
+
+#include <algorithm>
+
+namespace Muon
+{
+    UINT GetRootParameterCost(RootParameterKind kind, UINT num32BitValues)
+    {
+        switch (kind)
+        {
+        case RootParameterKind::RootConstants:   return num32BitValues;
+        case RootParameterKind::RootCBV:         return 2;
+        case RootParameterKind::DescriptorTable: return 1;
+        default:                                 return 0;
+        }
+    }
+
+    bool PlanRootParameters(const std::vector<ShaderResourceBinding>& resources, UINT maxPromotedBytes, UINT budgetDWORDs, RootParameterPlan& out_plan)
+    {
+        out_plan.Kinds.resize(resources.size());
+        out_plan.TotalDWORDs = 0;
+
+        // Start with nothing promoted
+        std::vector<size_t> candidates;
+        for (size_t i = 0; i < resources.size(); ++i)
+        {
+            const ShaderResourceBinding& res = resources[i];
+
+            RootParameterKind kind = RootParameterKind::Unbound;
+            switch (res.Type)
+            {
+            case ShaderResourceType::ConstantBuffer:
+                kind = RootParameterKind::RootCBV;
+                if (res.Size > 0 && res.Size <= maxPromotedBytes)
+                    candidates.push_back(i);
+                break;
+            case ShaderResourceType::Texture:
+            case ShaderResourceType::StructuredBuffer:
+                kind = RootParameterKind::DescriptorTable;
+                break;
+            case ShaderResourceType::Sampler:
+                kind = RootParameterKind::StaticSampler;
+                break;
+            default:
+                break;
+            }
+
+            out_plan.Kinds[i] = kind;
+            out_plan.TotalDWORDs += GetRootParameterCost(kind, 0);
+        }
+
+        if (out_plan.TotalDWORDs > budgetDWORDs)
+            return false;
+
+        // Stable so that equal layouts always promote the same buffers, which keeps their root signatures shareable
+        std::stable_sort(candidates.begin(), candidates.end(), [&resources](size_t a, size_t b)
+        {
+            return resources[a].Size < resources[b].Size;
+        });
+
+        for (size_t i : candidates)
+        {
+            const UINT num32BitValues = resources[i].Size / sizeof(UINT);
+            const UINT promotedTotal = out_plan.TotalDWORDs
+                - GetRootParameterCost(RootParameterKind::RootCBV, 0)
+                + GetRootParameterCost(RootParameterKind::RootConstants, num32BitValues);
+
+            // Buffers are sorted by size, so once one doesn't fit none of the remaining ones will
+            if (promotedTotal > budgetDWORDs)
+                break;
+
+            out_plan.Kinds[i] = RootParameterKind::RootConstants;
+            out_plan.TotalDWORDs = promotedTotal;
+        }
+
+        return true;
+    }
+}
@@ -0,0 +1,51 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Chooses how reflected shader resources are bound in a root signature
+----------------------------------------------*/
+#ifndef MUON_ROOTPARAMETERPLAN_H
+#define MUON_ROOTPARAMETERPLAN_H
+
+#include <Core/DXCore.h>
+
+#include <vector>
+
+namespace Muon
+{
+    struct ShaderResourceBinding;
+}
+
+namespace Muon
+{
+// D3D12 limits a root signature to 64 DWORDs: root constants cost one per value, root descriptors two, descriptor tables one.
+static const UINT ROOTSIG_MAX_DWORDS = 64;
+
+// Constant buffers up to this size are bound as root constants rather than root CBVs
+static const UINT ROOTCONSTANT_MAX_BYTES = 64;
+
+enum class RootParameterKind : uint8_t
+{
+    RootConstants,
+    RootCBV,
+    DescriptorTable,
+    StaticSampler,
+    Unbound
+};
+
+struct RootParameterPlan
+{
+    std::vector<RootParameterKind> Kinds; // Parallel to the resources that were planned
+    UINT TotalDWORDs = 0;
+};
+
+UINT GetRootParameterCost(RootParameterKind kind, UINT num32BitValues);
+
+// Decides which constant buffers get promoted to root constants. Smallest buffers are promoted first, as long as they
+// fit under maxPromotedBytes and the whole signature stays within budgetDWORDs. Returns false if even the unpromoted layout is over budget.
+bool PlanRootParameters(const std::vector<ShaderResourceBinding>& resources,
+    UINT maxPromotedBytes,
+    UINT budgetDWORDs,
+    RootParameterPlan& out_plan);
+
+}
+#endif
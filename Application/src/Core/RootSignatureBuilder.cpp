@@ -5,6 +5,9 @@ Description : Generator for D3D12 Root Signatures
 ----------------------------------------------*/
 
 #include <Core/RootSignatureBuilder.h>
+#include <Core/hash_util.h>
+
+#include <string.h>
 
 namespace Muon
 {
@@ -14,6 +17,7 @@ void RootSignatureBuilder::Reset()
     mParameters.clear();
     mStaticSamplers.clear();
     mDescriptorRanges.clear();
+    mFlags = D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT;
 }
 
 void RootSignatureBuilder::AddConstantBufferView(UINT shaderRegister, UINT space, D3D12_SHADER_VISIBILITY visibility)
@@ -26,6 +30,17 @@ void RootSignatureBuilder::AddConstantBufferView(UINT shaderRegister, UINT space
     mParameters.push_back(param);
 }
 
+void RootSignatureBuilder::AddConstants(UINT num32BitValues, UINT shaderRegister, UINT space, D3D12_SHADER_VISIBILITY visibility)
+{
+    D3D12_ROOT_PARAMETER param = {};
+    param.ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
+    param.ShaderVisibility = visibility;
+    param.Constants.ShaderRegister = shaderRegister;
+    param.Constants.RegisterSpace = space;
+    param.Constants.Num32BitValues = num32BitValues;
+    mParameters.push_back(param);
+}
+
 void RootSignatureBuilder::AddShaderResourceView(UINT shaderRegister, UINT space, D3D12_SHADER_VISIBILITY visibility)
 {
     D3D12_DESCRIPTOR_RANGE srvRange = {};
@@ -46,7 +61,7 @@ void RootSignatureBuilder::AddDescriptorTable(const D3D12_DESCRIPTOR_RANGE* rang
     param.ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
     param.ShaderVisibility = visibility;
     param.DescriptorTable.NumDescriptorRanges = numRanges;
-    param.DescriptorTable.pDescriptorRanges = mDescriptorRanges.back().data();
+    param.DescriptorTable.pDescriptorRanges = nullptr; // Resolved in Build()
     mParameters.push_back(param);
 }
 
@@ -55,14 +70,14 @@ void RootSignatureBuilder::AddStaticSampler(const D3D12_STATIC_SAMPLER_DESC& sam
     mStaticSamplers.push_back(sampler);
 }
 
-bool RootSignatureBuilder::Build(ID3D12Device* pDevice, ID3D12RootSignature** ppRootSig)
+bool RootSignatureBuilder::Build(ID3D12Device* pDevice, ID3D12RootSignature** ppRootSig) const
 {
-    D3D12_ROOT_SIGNATURE_DESC rootSigDesc = {};
-    rootSigDesc.NumParameters = static_cast<UINT>(mParameters.size());
-    rootSigDesc.pParameters = mParameters.data();
-    rootSigDesc.NumStaticSamplers = static_cast<UINT>(mStaticSamplers.size());
-    rootSigDesc.pStaticSamplers = mStaticSamplers.data();
-    rootSigDesc.Flags = D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT;
+    if (!pDevice || !ppRootSig)
+        return false;
+
+    std::vector<D3D12_ROOT_PARAMETER> parameters;
+    D3D12_ROOT_SIGNATURE_DESC rootSigDesc;
+    GetDesc(parameters, rootSigDesc);
 
     Microsoft::WRL::ComPtr<ID3DBlob> pSignatureBlob;
     Microsoft::WRL::ComPtr<ID3DBlob> pErrorBlob;
@@ -89,4 +104,103 @@ bool RootSignatureBuilder::Build(ID3D12Device* pDevice, ID3D12RootSignature** pp
     return SUCCEEDED(hr);
 }
 
-}
\ No newline at end of file
+void RootSignatureBuilder::GetDesc(std::vector<D3D12_ROOT_PARAMETER>& out_parameters, D3D12_ROOT_SIGNATURE_DESC& out_desc) const
+{
+    // Point each descriptor table at its ranges now that the vectors won't move anymore
+    out_parameters = mParameters;
+    size_t tableIndex = 0;
+    for (D3D12_ROOT_PARAMETER& param : out_parameters)
+    {
+        if (param.ParameterType == D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE)
+            param.DescriptorTable.pDescriptorRanges = mDescriptorRanges[tableIndex++].data();
+    }
+
+    out_desc = {};
+    out_desc.NumParameters = static_cast<UINT>(out_parameters.size());
+    out_desc.pParameters = out_parameters.data();
+    out_desc.NumStaticSamplers = static_cast<UINT>(mStaticSamplers.size());
+    out_desc.pStaticSamplers = mStaticSamplers.data();
+    out_desc.Flags = mFlags;
+}
+
+uint32_t RootSignatureBuilder::GetHash() const
+{
+    uint32_t hash = fnv1a_bytes(&mFlags, sizeof(mFlags));
+
+    size_t tableIndex = 0;
+    for (const D3D12_ROOT_PARAMETER& param : mParameters)
+    {
+        hash = fnv1a_bytes(&param.ParameterType, sizeof(param.ParameterType), hash);
+        hash = fnv1a_bytes(&param.ShaderVisibility, sizeof(param.ShaderVisibility), hash);
+
+        switch (param.ParameterType)
+        {
+        case D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE:
+        {
+            const std::vector<D3D12_DESCRIPTOR_RANGE>& ranges = mDescriptorRanges[tableIndex++];
+            hash = fnv1a_bytes(ranges.data(), ranges.size() * sizeof(D3D12_DESCRIPTOR_RANGE), hash);
+            break;
+        }
+        case D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS:
+            hash = fnv1a_bytes(&param.Constants, sizeof(param.Constants), hash);
+            break;
+        default:
+            hash = fnv1a_bytes(&param.Descriptor, sizeof(param.Descriptor), hash);
+            break;
+        }
+    }
+
+    // Static sampler descs are made up entirely of 4 byte fields, so there is no padding to worry about
+    return fnv1a_bytes(mStaticSamplers.data(), mStaticSamplers.size() * sizeof(D3D12_STATIC_SAMPLER_DESC), hash);
+}
+
+bool RootSignatureBuilder::IsEquivalent(const RootSignatureBuilder& other) const
+{
+    if (mFlags != other.mFlags ||
+        mParameters.size() != other.mParameters.size() ||
+        mStaticSamplers.size() != other.mStaticSamplers.size() ||
+        mDescriptorRanges.size() != other.mDescriptorRanges.size())
+    {
+        return false;
+    }
+
+    size_t tableIndex = 0;
+    for (size_t i = 0; i < mParameters.size(); ++i)
+    {
+        const D3D12_ROOT_PARAMETER& a = mParameters[i];
+        const D3D12_ROOT_PARAMETER& b = other.mParameters[i];
+
+        if (a.ParameterType != b.ParameterType || a.ShaderVisibility != b.ShaderVisibility)
+            return false;
+
+        switch (a.ParameterType)
+        {
+        case D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE:
+        {
+            const std::vector<D3D12_DESCRIPTOR_RANGE>& rangesA = mDescriptorRanges[tableIndex];
+            const std::vector<D3D12_DESCRIPTOR_RANGE>& rangesB = other.mDescriptorRanges[tableIndex];
+            tableIndex++;
+
+            if (rangesA.size() != rangesB.size() ||
+                (!rangesA.empty() && memcmp(rangesA.data(), rangesB.data(), rangesA.size() * sizeof(D3D12_DESCRIPTOR_RANGE)) != 0))
+            {
+                return false;
+            }
+            break;
+        }
+        case D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS:
+            if (memcmp(&a.Constants, &b.Constants, sizeof(a.Constants)) != 0)
+                return false;
+            break;
+        default:
+            if (memcmp(&a.Descriptor, &b.Descriptor, sizeof(a.Descriptor)) != 0)
+                return false;
+            break;
+        }
+    }
+
+    return mStaticSamplers.empty() ||
+        memcmp(mStaticSamplers.data(), other.mStaticSamplers.data(), mStaticSamplers.size() * sizeof(D3D12_STATIC_SAMPLER_DESC)) == 0;
+}
+
+}
@@ -8,26 +8,43 @@ Description : Generator for D3D12 Root Signatures
 
 #include <Core/DXCore.h>
 
+#include <vector>
+
 namespace Muon
 {
 
+// The builder doubles as the canonical description of a root signature.
+// Descriptor range pointers are only resolved inside Build(), so builders can be copied, hashed and compared freely.
 class RootSignatureBuilder
 {
 public:
     void Reset();
     void AddConstantBufferView(UINT shaderRegister, UINT space, D3D12_SHADER_VISIBILITY visibility);
+    void AddConstants(UINT num32BitValues, UINT shaderRegister, UINT space, D3D12_SHADER_VISIBILITY visibility);
     void AddShaderResourceView(UINT shaderRegister, UINT space, D3D12_SHADER_VISIBILITY visibility);
     void AddDescriptorTable(const D3D12_DESCRIPTOR_RANGE* ranges, UINT numRanges, D3D12_SHADER_VISIBILITY visibility);
     void AddStaticSampler(const D3D12_STATIC_SAMPLER_DESC& sampler);
+    void SetFlags(D3D12_ROOT_SIGNATURE_FLAGS flags) { mFlags = flags; }
+
+    bool Build(ID3D12Device* pDevice, ID3D12RootSignature** ppRootSig) const;
+
+    // Fills out_desc as Build() would serialize it. It points into out_parameters and this builder, so it's only valid while neither changes.
+    void GetDesc(std::vector<D3D12_ROOT_PARAMETER>& out_parameters, D3D12_ROOT_SIGNATURE_DESC& out_desc) const;
+
+    // Hash and equality only look at the layout, never at pointers, so two materials that reflect to the same layout compare equal.
+    uint32_t GetHash() const;
+    bool IsEquivalent(const RootSignatureBuilder& other) const;
 
-    bool Build(ID3D12Device* pDevice, ID3D12RootSignature** ppRootSig);
+    UINT GetNumParameters() const { return static_cast<UINT>(mParameters.size()); }
+    UINT GetNumStaticSamplers() const { return static_cast<UINT>(mStaticSamplers.size()); }
 
 private:
     std::vector<D3D12_ROOT_PARAMETER> mParameters;
     std::vector<D3D12_STATIC_SAMPLER_DESC> mStaticSamplers;
-    std::vector<std::vector<D3D12_DESCRIPTOR_RANGE>> mDescriptorRanges;
+    std::vector<std::vector<D3D12_DESCRIPTOR_RANGE>> mDescriptorRanges; // One entry per descriptor table, in parameter order
+    D3D12_ROOT_SIGNATURE_FLAGS mFlags = D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT;
 };
 
 }
 
-#endif
\ No newline at end of file
+#endif
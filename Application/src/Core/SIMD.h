@@ -0,0 +1,90 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Thin 4-wide float vector wrappers, SSE on x64 and plain loops elsewhere
+----------------------------------------------*/
+#ifndef MUON_SIMD_H
+#define MUON_SIMD_H
+
+#include <math.h>
+#include <stdint.h>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define MUON_SIMD_SSE 1
+#endif
+
+namespace Muon
+{
+namespace SIMD
+{
+
+// Comparisons return lane masks. Only And4, Or4, Select4 and MoveMask4 should consume them.
+#if MUON_SIMD_SSE
+typedef __m128 Float4;
+
+inline Float4 Load4(const float* p) { return _mm_loadu_ps(p); }
+inline void Store4(float* p, Float4 a) { _mm_storeu_ps(p, a); }
+inline Float4 Splat4(float f) { return _mm_set1_ps(f); }
+inline Float4 Set4(float x, float y, float z, float w) { return _mm_setr_ps(x, y, z, w); }
+inline Float4 Add4(Float4 a, Float4 b) { return _mm_add_ps(a, b); }
+inline Float4 Sub4(Float4 a, Float4 b) { return _mm_sub_ps(a, b); }
+inline Float4 Mul4(Float4 a, Float4 b) { return _mm_mul_ps(a, b); }
+inline Float4 Div4(Float4 a, Float4 b) { return _mm_div_ps(a, b); }
+inline Float4 Min4(Float4 a, Float4 b) { return _mm_min_ps(a, b); }
+inline Float4 Max4(Float4 a, Float4 b) { return _mm_max_ps(a, b); }
+inline Float4 Sqrt4(Float4 a) { return _mm_sqrt_ps(a); }
+inline Float4 GreaterEqual4(Float4 a, Float4 b) { return _mm_cmpge_ps(a, b); }
+inline Float4 LessEqual4(Float4 a, Float4 b) { return _mm_cmple_ps(a, b); }
+inline Float4 And4(Float4 a, Float4 b) { return _mm_and_ps(a, b); }
+inline Float4 Or4(Float4 a, Float4 b) { return _mm_or_ps(a, b); }
+inline Float4 Select4(Float4 mask, Float4 a, Float4 b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+inline uint32_t MoveMask4(Float4 a) { return static_cast<uint32_t>(_mm_movemask_ps(a)); }
+#else
+struct Float4 { float v[4]; };
+
+template <typename Op>
+inline Float4 Map4(Float4 a, Float4 b, Op op)
+{
+    Float4 r;
+    for (uint32_t i = 0; i != 4; ++i)
+        r.v[i] = op(a.v[i], b.v[i]);
+    return r;
+}
+
+// Masks are 1.0 for true and 0.0 for false
+inline Float4 Load4(const float* p) { return { { p[0], p[1], p[2], p[3] } }; }
+inline void Store4(float* p, Float4 a) { for (uint32_t i = 0; i != 4; ++i) p[i] = a.v[i]; }
+inline Float4 Splat4(float f) { return { { f, f, f, f } }; }
+inline Float4 Set4(float x, float y, float z, float w) { return { { x, y, z, w } }; }
+inline Float4 Add4(Float4 a, Float4 b) { return Map4(a, b, [](float x, float y) { return x + y; }); }
+inline Float4 Sub4(Float4 a, Float4 b) { return Map4(a, b, [](float x, float y) { return x - y; }); }
+inline Float4 Mul4(Float4 a, Float4 b) { return Map4(a, b, [](float x, float y) { return x * y; }); }
+inline Float4 Div4(Float4 a, Float4 b) { return Map4(a, b, [](float x, float y) { return x / y; }); }
+inline Float4 Min4(Float4 a, Float4 b) { return Map4(a, b, [](float x, float y) { return x < y ? x : y; }); }
+inline Float4 Max4(Float4 a, Float4 b) { return Map4(a, b, [](float x, float y) { return x > y ? x : y; }); }
+inline Float4 Sqrt4(Float4 a) { return Map4(a, a, [](float x, float) { return sqrtf(x); }); }
+inline Float4 GreaterEqual4(Float4 a, Float4 b) { return Map4(a, b, [](float x, float y) { return x >= y ? 1.0f : 0.0f; }); }
+inline Float4 LessEqual4(Float4 a, Float4 b) { return Map4(a, b, [](float x, float y) { return x <= y ? 1.0f : 0.0f; }); }
+inline Float4 And4(Float4 a, Float4 b) { return Map4(a, b, [](float x, float y) { return (x != 0.0f && y != 0.0f) ? 1.0f : 0.0f; }); }
+inline Float4 Or4(Float4 a, Float4 b) { return Map4(a, b, [](float x, float y) { return (x != 0.0f || y != 0.0f) ? 1.0f : 0.0f; }); }
+inline Float4 Select4(Float4 mask, Float4 a, Float4 b)
+{
+    Float4 r;
+    for (uint32_t i = 0; i != 4; ++i)
+        r.v[i] = mask.v[i] != 0.0f ? a.v[i] : b.v[i];
+    return r;
+}
+inline uint32_t MoveMask4(Float4 a)
+{
+    uint32_t mask = 0;
+    for (uint32_t i = 0; i != 4; ++i)
+        mask |= (a.v[i] != 0.0f ? 1u : 0u) << i;
+    return mask;
+}
+#endif
+
+}
+}
+
+#endif
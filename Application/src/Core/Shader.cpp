@@ -5,6 +5,7 @@ Description : Implementations of Muon shader objects
 ----------------------------------------------*/
 
 #include <Core/Shader.h>
+#include <Core/ShaderReflectionCache.h>
 #include <Core/ShaderUtils.h>
 #include <Core/ThrowMacros.h>
 #include <Utils/Utils.h>
@@ -19,6 +20,64 @@ VertexShader::VertexShader(const wchar_t* path)
     Init(path);
 }
 
+// Runs the reflection API over the shader's bytecode. Only needed when the reflection cache misses.
+static bool ReflectVertexShader(VertexShader& vs)
+{
+    Microsoft::WRL::ComPtr<ID3D12ShaderReflection> pReflection;
+    HRESULT hr = CreateShaderReflection(vs.ShaderBlob.Get(), pReflection.GetAddressOf());
+
+    if (FAILED(hr))
+        return false;
+
+    if (!BuildInputLayout(pReflection.Get(), vs.ShaderBlob.Get(), &vs))
+        return false;
+
+    return ParseReflectedResources(pReflection.Get(), vs.ReflectionData);
+}
+
+static bool ReflectPixelShader(PixelShader& ps)
+{
+    Microsoft::WRL::ComPtr<ID3D12ShaderReflection> pReflection;
+    HRESULT hr = CreateShaderReflection(ps.ShaderBlob.Get(), pReflection.GetAddressOf());
+
+    if (FAILED(hr))
+        return false;
+
+    return ParseReflectedResources(pReflection.Get(), ps.ReflectionData);
+}
+
+#if MN_VALIDATE_REFLECTION_CACHE
+// Reflects a second copy live and compares it with what came out of the cache. On mismatch the live results win.
+template<typename ShaderType>
+static void ValidateCachedReflection(const wchar_t* path, uint64_t bytecodeHash, ShaderType& cached, bool (*reflectFunc)(ShaderType&))
+{
+    ShaderType live;
+    live.ShaderBlob = cached.ShaderBlob;
+    if (!reflectFunc(live))
+    {
+        Muon::Printf(L"Error: Live reflection failed while validating the cache for %s!\n", path);
+        live.Release();
+        return;
+    }
+
+    std::string diff;
+    if (CompareReflection(cached, live, diff))
+    {
+        live.Release();
+        return;
+    }
+
+    Muon::Printf(L"Warning: Reflection cache for %s is out of date, rewriting it.\n", path);
+    Muon::Printf("Warning: First difference: %s\n", diff.c_str());
+
+    // live's allocations are handed over to cached
+    cached.Release();
+    cached = std::move(live);
+    cached.FromReflectionCache = false;
+    SaveCachedReflection(bytecodeHash, cached);
+}
+#endif
+
 bool VertexShader::Init(const wchar_t* path)
 {
     if (Initialized)
@@ -27,24 +86,43 @@ bool VertexShader::Init(const wchar_t* path)
         return false;
     }
 
-    HRESULT hr = D3DReadFileToBlob(path, this->ShaderBlob.GetAddressOf());
+    Microsoft::WRL::ComPtr<ID3DBlob> pBlob;
+    HRESULT hr = D3DReadFileToBlob(path, pBlob.GetAddressOf());
     COM_EXCEPT(hr);
 
     if (FAILED(hr))
         return false;
 
-    Microsoft::WRL::ComPtr<ID3D12ShaderReflection> pReflection;
-    hr = D3DReflect(ShaderBlob->GetBufferPointer(), ShaderBlob->GetBufferSize(),
-        IID_ID3D12ShaderReflection, (void**)pReflection.GetAddressOf());
+    return InitFromBlob(pBlob.Get(), path);
+}
 
-    if (FAILED(hr))
+bool VertexShader::InitFromBlob(ID3DBlob* pBlob, const wchar_t* debugName)
+{
+    if (Initialized || !pBlob)
         return false;
 
-    if (!BuildInputLayout(pReflection.Get(), ShaderBlob.Get(), this))
-        return false;
+    ShaderBlob = pBlob;
+
+    const uint64_t bytecodeHash = HashShaderBytecode(ShaderBlob.Get());
+    FromReflectionCache = LoadCachedReflection(bytecodeHash, *this);
+
+    if (FromReflectionCache)
+    {
+#if MN_VALIDATE_REFLECTION_CACHE
+        ValidateCachedReflection(debugName, bytecodeHash, *this, &ReflectVertexShader);
+#endif
+    }
+    else
+    {
+        if (!ReflectVertexShader(*this))
+            return false;
 
-    Initialized = ParseReflectedResources(pReflection.Get(), this->ReflectionData);
-    return SUCCEEDED(hr);
+        if (!SaveCachedReflection(bytecodeHash, *this))
+            Muon::Printf(L"Warning: Failed to write reflection cache for %s.\n", debugName);
+    }
+
+    Initialized = ReflectionData.IsReflected;
+    return Initialized;
 }
 
 bool VertexShader::Release()
@@ -65,15 +143,11 @@ bool VertexShader::Release()
         released = true;
     }
 
-    for (D3D12_INPUT_ELEMENT_DESC& param : InputElements)
-    {
-        if (param.SemanticName)
-        {
-            delete[] param.SemanticName;
-            param.SemanticName = nullptr;
-            released = true;
-        }
-    }
+    // InstanceDesc pointed into the arrays above
+    InstanceDesc = VertexBufferDescription();
+
+    // Semantic names are interned in a shared arena, there's nothing to free per element
+    InputElements.clear();
 
     return released;
 }
@@ -89,21 +163,43 @@ PixelShader::PixelShader(const wchar_t* path)
 
 bool PixelShader::Init(const wchar_t* path)
 {
-    HRESULT hr = D3DReadFileToBlob(path, this->ShaderBlob.GetAddressOf());
+    Microsoft::WRL::ComPtr<ID3DBlob> pBlob;
+    HRESULT hr = D3DReadFileToBlob(path, pBlob.GetAddressOf());
     COM_EXCEPT(hr);
 
     if (FAILED(hr))
         return false;
 
-    Microsoft::WRL::ComPtr<ID3D12ShaderReflection> pReflection;
-    hr = D3DReflect(ShaderBlob->GetBufferPointer(), ShaderBlob->GetBufferSize(),
-        IID_ID3D12ShaderReflection, (void**)pReflection.GetAddressOf());
+    return InitFromBlob(pBlob.Get(), path);
+}
 
-    if (FAILED(hr))
+bool PixelShader::InitFromBlob(ID3DBlob* pBlob, const wchar_t* debugName)
+{
+    if (Initialized || !pBlob)
         return false;
 
-    Initialized = ParseReflectedResources(pReflection.Get(), this->ReflectionData);
-    return SUCCEEDED(hr);
+    ShaderBlob = pBlob;
+
+    const uint64_t bytecodeHash = HashShaderBytecode(ShaderBlob.Get());
+    FromReflectionCache = LoadCachedReflection(bytecodeHash, *this);
+
+    if (FromReflectionCache)
+    {
+#if MN_VALIDATE_REFLECTION_CACHE
+        ValidateCachedReflection(debugName, bytecodeHash, *this, &ReflectPixelShader);
+#endif
+    }
+    else
+    {
+        if (!ReflectPixelShader(*this))
+            return false;
+
+        if (!SaveCachedReflection(bytecodeHash, *this))
+            Muon::Printf(L"Warning: Failed to write reflection cache for %s.\n", debugName);
+    }
+
+    Initialized = ReflectionData.IsReflected;
+    return Initialized;
 }
 
 bool PixelShader::Release()
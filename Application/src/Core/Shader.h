@@ -15,6 +15,12 @@ Description : Wrapper for Vertex/Pixel/other shader code
 namespace Muon
 {
 
+enum class ShaderStage : uint8_t
+{
+    Vertex,
+    Pixel
+};
+
 enum class ShaderResourceType
 {
     ConstantBuffer,
@@ -107,6 +113,7 @@ struct VertexShader
     VertexShader(const wchar_t* path);
 
     bool Init(const wchar_t* path);
+    bool InitFromBlob(ID3DBlob* pBlob, const wchar_t* debugName); // For bytecode that didn't come straight from a .cso, e.g. compiled variants
     bool Release();
 
     std::vector<D3D12_INPUT_ELEMENT_DESC> InputElements;
@@ -117,6 +124,7 @@ struct VertexShader
     ShaderReflectionData ReflectionData;
     BOOL Initialized = false;
     BOOL Instanced = false;
+    bool FromReflectionCache = false;
 };
 
 struct PixelShader
@@ -125,11 +133,13 @@ struct PixelShader
     PixelShader(const wchar_t* path);
     
     bool Init(const wchar_t* path);
+    bool InitFromBlob(ID3DBlob* pBlob, const wchar_t* debugName);
     bool Release();
 
     Microsoft::WRL::ComPtr<ID3DBlob> ShaderBlob;
     ShaderReflectionData ReflectionData;
     BOOL Initialized = false;
+    bool FromReflectionCache = false;
 };
 
 }
@@ -0,0 +1,336 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Runtime shader permutation compiling through DXC
+----------------------------------------------*/
+#include <Core/ShaderCompiler.h>
+
+#include <Core/BinaryStream.h>
+#include <Core/PathMacros.h>
+#include <Core/hash_util.h>
+#include <Utils/Utils.h>
+
+#include <dxcapi.h>
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string.h>
+#include <unordered_set>
+
+namespace Muon
+{
+
+// Bump to invalidate every cached variant, e.g. when the compile arguments below change
+static const uint32_t kVariantCacheVersion = 1;
+
+static const char* kPermutationTag = "// permutations:";
+
+static bool ReadTextFile(const std::filesystem::path& path, std::string& out_text)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+
+    std::ostringstream stream;
+    stream << file.rdbuf();
+    out_text = stream.str();
+    return true;
+}
+
+static bool IsDefineSeparator(char c)
+{
+    return c == ' ' || c == '\t' || c == ',' || c == '\r' || c == '\n';
+}
+
+// Splits a space or comma separated list into its names
+static void SplitDefineList(std::string_view list, std::vector<std::string_view>& out_names)
+{
+    size_t pos = 0;
+    while (pos < list.size())
+    {
+        while (pos < list.size() && IsDefineSeparator(list[pos]))
+            pos++;
+
+        size_t start = pos;
+        while (pos < list.size() && !IsDefineSeparator(list[pos]))
+            pos++;
+
+        if (pos > start)
+            out_names.push_back(list.substr(start, pos - start));
+    }
+}
+
+bool ShaderPermutationSource::GetVariantKey(std::string_view defineList, VariantKey& out_key) const
+{
+    std::vector<std::string_view> names;
+    SplitDefineList(defineList, names);
+
+    out_key = 0;
+    for (std::string_view name : names)
+    {
+        bool found = false;
+        for (size_t bit = 0; bit != Defines.size(); ++bit)
+        {
+            if (Defines[bit] == name)
+            {
+                out_key |= (1u << bit);
+                found = true;
+                break;
+            }
+        }
+
+        if (!found)
+            return false;
+    }
+
+    return true;
+}
+
+std::string ShaderPermutationSource::GetVariantName(VariantKey key) const
+{
+    std::string name;
+    for (size_t bit = 0; bit != Defines.size(); ++bit)
+    {
+        if (key & (1u << bit))
+        {
+            if (!name.empty())
+                name += ' ';
+            name += Defines[bit];
+        }
+    }
+
+    return name.empty() ? "default" : name;
+}
+
+ShaderID GetShaderVariantID(ShaderID baseID, VariantKey key)
+{
+    if (key == 0)
+        return baseID;
+
+    return fnv1a_bytes(&key, sizeof(key), baseID);
+}
+
+bool ParsePermutationSource(const std::wstring& path, ShaderPermutationSource& out_source)
+{
+    namespace fs = std::filesystem;
+
+    const fs::path sourcePath(path);
+    const std::wstring stem = sourcePath.stem().wstring();
+
+    if (stem.size() >= 2 && stem.compare(stem.size() - 2, 2, L"VS") == 0)
+        out_source.Stage = ShaderStage::Vertex;
+    else if (stem.size() >= 2 && stem.compare(stem.size() - 2, 2, L"PS") == 0)
+        out_source.Stage = ShaderStage::Pixel;
+    else
+        return false;
+
+    std::string text;
+    if (!ReadTextFile(sourcePath, text))
+        return false;
+
+    out_source.Path = path;
+    out_source.BaseID = fnv1a((stem + L".cso").c_str());
+    out_source.Defines.clear();
+
+    const size_t tagPos = text.find(kPermutationTag);
+    if (tagPos != std::string::npos)
+    {
+        const size_t listStart = tagPos + strlen(kPermutationTag);
+        const size_t lineEnd = text.find('\n', listStart);
+        std::string_view list(text.data() + listStart, (lineEnd == std::string::npos ? text.size() : lineEnd) - listStart);
+
+        std::vector<std::string_view> names;
+        SplitDefineList(list, names);
+        for (std::string_view name : names)
+            out_source.Defines.emplace_back(name);
+    }
+
+    if (out_source.Defines.size() > SHADER_MAX_PERMUTATION_DEFINES)
+    {
+        Muon::Printf(L"Error: %s declares more permutation defines than a VariantKey can hold!\n", path.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+// Hashes the source and everything it (transitively) includes. Only quoted includes are followed, relative to the including file.
+static void HashSourceTree(const std::filesystem::path& path, std::unordered_set<std::wstring>& visited, uint64_t& hash)
+{
+    namespace fs = std::filesystem;
+
+    std::error_code ec;
+    const fs::path canonical = fs::weakly_canonical(path, ec);
+    if (!visited.insert(canonical.wstring()).second)
+        return;
+
+    std::string text;
+    if (!ReadTextFile(path, text))
+    {
+        // A missing include will fail to compile anyway, but keep it in the hash so fixing it changes the key
+        const std::string name = path.filename().string();
+        hash = fnv1a64_bytes(name.data(), name.size(), hash);
+        return;
+    }
+
+    hash = fnv1a64_bytes(text.data(), text.size(), hash);
+
+    size_t pos = 0;
+    while ((pos = text.find("#include", pos)) != std::string::npos)
+    {
+        pos += 8;
+        const size_t open = text.find_first_of("\"\n", pos);
+        if (open == std::string::npos || text[open] != '"')
+            continue;
+
+        const size_t close = text.find('"', open + 1);
+        if (close == std::string::npos)
+            break;
+
+        HashSourceTree(path.parent_path() / text.substr(open + 1, close - open - 1), visited, hash);
+        pos = close + 1;
+    }
+}
+
+static const wchar_t* GetTargetProfile(ShaderStage stage)
+{
+    return stage == ShaderStage::Vertex ? L"vs_6_0" : L"ps_6_0";
+}
+
+static std::wstring GetVariantCachePath(uint64_t hash)
+{
+    wchar_t fileName[32];
+    swprintf(fileName, 32, L"%016llx.cso", static_cast<unsigned long long>(hash));
+    return std::wstring(CACHEPATHW L"Shaders\\") + fileName;
+}
+
+bool CompileShaderVariant(const ShaderPermutationSource& source, VariantKey key, Microsoft::WRL::ComPtr<ID3DBlob>& out_blob, bool& out_fromCache)
+{
+    namespace fs = std::filesystem;
+    using Microsoft::WRL::ComPtr;
+
+    out_fromCache = false;
+
+    // Every define is passed explicitly as 0 or 1
+    std::vector<std::wstring> defineArgs;
+    for (size_t bit = 0; bit != source.Defines.size(); ++bit)
+    {
+        const std::string& name = source.Defines[bit];
+        std::wstring arg(name.begin(), name.end());
+        arg += (key & (1u << bit)) ? L"=1" : L"=0";
+        defineArgs.push_back(std::move(arg));
+    }
+
+    uint64_t hash = fnv1a64_bytes(&kVariantCacheVersion, sizeof(kVariantCacheVersion));
+    std::unordered_set<std::wstring> visited;
+    HashSourceTree(fs::path(source.Path), visited, hash);
+    for (const std::wstring& define : defineArgs)
+        hash = fnv1a64_bytes(define.data(), define.size() * sizeof(wchar_t), hash);
+
+    const std::wstring profile = GetTargetProfile(source.Stage);
+    hash = fnv1a64_bytes(profile.data(), profile.size() * sizeof(wchar_t), hash);
+#if defined(MN_DEBUG)
+    hash = fnv1a64_bytes("debug", 5, hash);
+#endif
+
+    const std::wstring cachePath = GetVariantCachePath(hash);
+
+    std::vector<uint8_t> cachedBytes;
+    if (LoadFileBytes(cachePath.c_str(), cachedBytes) && !cachedBytes.empty())
+    {
+        if (SUCCEEDED(D3DCreateBlob(cachedBytes.size(), out_blob.ReleaseAndGetAddressOf())))
+        {
+            memcpy(out_blob->GetBufferPointer(), cachedBytes.data(), cachedBytes.size());
+            out_fromCache = true;
+            return true;
+        }
+    }
+
+    ComPtr<IDxcUtils> pUtils;
+    ComPtr<IDxcCompiler3> pCompiler;
+    if (FAILED(DxcCreateInstance(CLSID_DxcUtils, IID_PPV_ARGS(pUtils.GetAddressOf()))) ||
+        FAILED(DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(pCompiler.GetAddressOf()))))
+    {
+        Muon::Print("Error: Failed to create the DXC compiler. Is dxcompiler.dll next to the executable?\n");
+        return false;
+    }
+
+    ComPtr<IDxcIncludeHandler> pIncludeHandler;
+    pUtils->CreateDefaultIncludeHandler(pIncludeHandler.GetAddressOf());
+
+    ComPtr<IDxcBlobEncoding> pSource;
+    if (FAILED(pUtils->LoadFile(source.Path.c_str(), nullptr, pSource.GetAddressOf())))
+    {
+        Muon::Printf(L"Error: Failed to read shader source %s!\n", source.Path.c_str());
+        return false;
+    }
+
+    DxcBuffer sourceBuffer;
+    sourceBuffer.Ptr = pSource->GetBufferPointer();
+    sourceBuffer.Size = pSource->GetBufferSize();
+    sourceBuffer.Encoding = DXC_CP_ACP;
+
+    const std::wstring includeDir = fs::path(source.Path).parent_path().wstring();
+
+    std::vector<LPCWSTR> args;
+    args.push_back(source.Path.c_str());
+    args.push_back(L"-E");
+    args.push_back(L"main");
+    args.push_back(L"-T");
+    args.push_back(profile.c_str());
+    args.push_back(L"-I");
+    args.push_back(includeDir.c_str());
+    for (const std::wstring& define : defineArgs)
+    {
+        args.push_back(L"-D");
+        args.push_back(define.c_str());
+    }
+#if defined(MN_DEBUG)
+    args.push_back(DXC_ARG_DEBUG);
+    args.push_back(L"-Qembed_debug");
+    args.push_back(DXC_ARG_SKIP_OPTIMIZATIONS);
+#else
+    args.push_back(DXC_ARG_OPTIMIZATION_LEVEL3);
+#endif
+
+    ComPtr<IDxcResult> pResult;
+    HRESULT hr = pCompiler->Compile(&sourceBuffer, args.data(), static_cast<UINT32>(args.size()),
+        pIncludeHandler.Get(), IID_PPV_ARGS(pResult.GetAddressOf()));
+
+    HRESULT status = E_FAIL;
+    if (SUCCEEDED(hr))
+        pResult->GetStatus(&status);
+
+    ComPtr<IDxcBlobUtf8> pErrors;
+    if (pResult)
+        pResult->GetOutput(DXC_OUT_ERRORS, IID_PPV_ARGS(pErrors.GetAddressOf()), nullptr);
+
+    if (pErrors && pErrors->GetStringLength() > 0)
+    {
+        // Printf truncates, so errors go out whole
+        Muon::Printf(L"%s [%S]:\n", source.Path.c_str(), source.GetVariantName(key).c_str());
+        Muon::Print(pErrors->GetStringPointer());
+    }
+
+    if (FAILED(hr) || FAILED(status))
+        return false;
+
+    ComPtr<IDxcBlob> pObject;
+    if (FAILED(pResult->GetOutput(DXC_OUT_OBJECT, IID_PPV_ARGS(pObject.GetAddressOf()), nullptr)) || !pObject)
+        return false;
+
+    if (FAILED(D3DCreateBlob(pObject->GetBufferSize(), out_blob.ReleaseAndGetAddressOf())))
+        return false;
+
+    memcpy(out_blob->GetBufferPointer(), pObject->GetBufferPointer(), pObject->GetBufferSize());
+
+    BinaryWriter writer;
+    writer.WriteBytes(pObject->GetBufferPointer(), pObject->GetBufferSize());
+    if (!writer.SaveToFile(cachePath.c_str()))
+        Muon::Printf(L"Warning: Failed to cache shader variant %s!\n", cachePath.c_str());
+
+    return true;
+}
+
+}
@@ -0,0 +1,50 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Runtime shader permutation compiling through DXC
+----------------------------------------------*/
+#ifndef MUON_SHADERCOMPILER_H
+#define MUON_SHADERCOMPILER_H
+
+#include <Core/DXCore.h>
+#include <Core/CommonTypes.h>
+#include <Core/Shader.h>
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <wrl/client.h>
+
+namespace Muon
+{
+
+static const uint32_t SHADER_MAX_PERMUTATION_DEFINES = 32;
+
+// A shader source that declares its permutation defines with a line like:
+//   // permutations: NORMAL_MAP INSTANCED
+// Each define becomes one bit of a VariantKey. Defines are always passed as 0 or 1, so the source tests them with #if.
+struct ShaderPermutationSource
+{
+    std::wstring Path;
+    ShaderStage Stage = ShaderStage::Vertex;
+    ShaderID BaseID = 0; // Same as the offline-built .cso, which is the key 0 variant
+    std::vector<std::string> Defines;
+
+    // Parses a space or comma separated define list into a key. Fails on names the source doesn't declare.
+    bool GetVariantKey(std::string_view defineList, VariantKey& out_key) const;
+    std::string GetVariantName(VariantKey key) const;
+};
+
+// Key 0 maps to the base ID, so default variants are found by the regular codex lookups too
+ShaderID GetShaderVariantID(ShaderID baseID, VariantKey key);
+
+// Reads the permutation declaration and works out the stage from the file name (*VS.hlsl / *PS.hlsl)
+bool ParsePermutationSource(const std::wstring& path, ShaderPermutationSource& out_source);
+
+// Compiles one variant with DXC. Results are cached under the cache folder by a hash of the source, its includes and the defines,
+// so unchanged variants are loaded straight from disk.
+bool CompileShaderVariant(const ShaderPermutationSource& source, VariantKey key, Microsoft::WRL::ComPtr<ID3DBlob>& out_blob, bool& out_fromCache);
+
+}
+
+#endif
@@ -0,0 +1,424 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : On-disk cache of shader reflection results
+----------------------------------------------*/
+#include <Core/ShaderReflectionCache.h>
+
+#include <Core/BinaryStream.h>
+#include <Core/PathMacros.h>
+#include <Core/Shader.h>
+#include <Core/ShaderUtils.h>
+#include <Core/hash_util.h>
+
+#include <stdio.h>
+#include <string.h>
+
+namespace Muon
+{
+
+static const uint32_t kReflectionCacheMagic = 0x43524E4D; // 'MNRC'
+
+// Bump whenever the serialized layout, or the reflection code that produces it, changes
+static const uint32_t kReflectionCacheVersion = 2;
+
+static std::wstring GetReflectionCachePath(uint64_t bytecodeHash)
+{
+    wchar_t fileName[32];
+    swprintf(fileName, 32, L"%016llx.bin", static_cast<unsigned long long>(bytecodeHash));
+    return std::wstring(CACHEPATHW L"Reflection\\") + fileName;
+}
+
+uint64_t HashShaderBytecode(ID3DBlob* pBlob)
+{
+    if (!pBlob)
+        return 0;
+
+    return fnv1a64_bytes(pBlob->GetBufferPointer(), pBlob->GetBufferSize());
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+// Serialization
+
+static void WriteHeader(BinaryWriter& writer, uint64_t bytecodeHash, ShaderStage stage)
+{
+    writer.Write(kReflectionCacheMagic);
+    writer.Write(kReflectionCacheVersion);
+    writer.Write(bytecodeHash);
+    writer.Write(stage);
+}
+
+static bool ReadHeader(BinaryReader& reader, uint64_t bytecodeHash, ShaderStage stage)
+{
+    uint32_t magic = 0, version = 0;
+    uint64_t hash = 0;
+    ShaderStage cachedStage = ShaderStage::Vertex;
+
+    reader.Read(magic);
+    reader.Read(version);
+    reader.Read(hash);
+    reader.Read(cachedStage);
+
+    return !reader.IsFailed() &&
+        magic == kReflectionCacheMagic &&
+        version == kReflectionCacheVersion &&
+        hash == bytecodeHash &&
+        cachedStage == stage;
+}
+
+static void WriteReflectionData(BinaryWriter& writer, const ShaderReflectionData& data)
+{
+    writer.Write<uint32_t>(static_cast<uint32_t>(data.Resources.size()));
+    for (const ShaderResourceBinding& res : data.Resources)
+    {
+        writer.WriteString(res.Name);
+        writer.Write<uint8_t>(static_cast<uint8_t>(res.Type));
+        writer.Write<uint32_t>(res.BindPoint);
+        writer.Write<uint32_t>(res.BindCount);
+        writer.Write<uint32_t>(res.Space);
+        writer.Write<uint32_t>(res.Size);
+    }
+
+    writer.Write<uint32_t>(static_cast<uint32_t>(data.ConstantBuffers.size()));
+    for (const ConstantBufferReflection& cb : data.ConstantBuffers)
+    {
+        writer.WriteString(cb.Name);
+        writer.Write<uint32_t>(cb.BindPoint);
+        writer.Write<uint32_t>(cb.Space);
+        writer.Write<uint32_t>(cb.Size);
+
+        writer.Write<uint32_t>(static_cast<uint32_t>(cb.Variables.size()));
+        for (const ParameterDesc& var : cb.Variables)
+        {
+            writer.WriteString(var.Name);
+            writer.Write<uint8_t>(static_cast<uint8_t>(var.Type));
+            writer.Write<uint32_t>(var.Index);
+            writer.Write<uint32_t>(var.Offset);
+            writer.WriteString(var.ConstantBufferName);
+        }
+    }
+}
+
+static bool ReadReflectionData(BinaryReader& reader, ShaderReflectionData& out_data)
+{
+    uint32_t numResources = 0;
+    reader.ReadCount(numResources);
+    out_data.Resources.resize(numResources);
+    for (ShaderResourceBinding& res : out_data.Resources)
+    {
+        uint8_t type = 0;
+        reader.ReadString(res.Name);
+        reader.Read(type);
+        reader.Read(res.BindPoint);
+        reader.Read(res.BindCount);
+        reader.Read(res.Space);
+        reader.Read(res.Size);
+        res.Type = static_cast<ShaderResourceType>(type);
+    }
+
+    uint32_t numCBs = 0;
+    reader.ReadCount(numCBs);
+    out_data.ConstantBuffers.resize(numCBs);
+    for (ConstantBufferReflection& cb : out_data.ConstantBuffers)
+    {
+        reader.ReadString(cb.Name);
+        reader.Read(cb.BindPoint);
+        reader.Read(cb.Space);
+        reader.Read(cb.Size);
+
+        uint32_t numVars = 0;
+        reader.ReadCount(numVars);
+        cb.Variables.resize(numVars);
+        for (ParameterDesc& var : cb.Variables)
+        {
+            uint8_t type = 0;
+            reader.ReadString(var.Name);
+            reader.Read(type);
+            reader.Read(var.Index);
+            reader.Read(var.Offset);
+            reader.ReadString(var.ConstantBufferName);
+            var.Type = static_cast<ParameterType>(type);
+        }
+    }
+
+    out_data.IsReflected = !reader.IsFailed();
+    return out_data.IsReflected;
+}
+
+static bool SaveCacheFile(uint64_t bytecodeHash, const BinaryWriter& writer)
+{
+    if (bytecodeHash == 0)
+        return false;
+
+    return writer.SaveToFile(GetReflectionCachePath(bytecodeHash).c_str());
+}
+
+static bool LoadCacheFile(uint64_t bytecodeHash, std::vector<uint8_t>& out_bytes)
+{
+    if (bytecodeHash == 0)
+        return false;
+
+    return LoadFileBytes(GetReflectionCachePath(bytecodeHash).c_str(), out_bytes);
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+
+bool LoadCachedReflection(uint64_t bytecodeHash, VertexShader& out_vs)
+{
+    std::vector<uint8_t> bytes;
+    if (!LoadCacheFile(bytecodeHash, bytes))
+        return false;
+
+    BinaryReader reader(bytes.data(), bytes.size());
+    if (!ReadHeader(reader, bytecodeHash, ShaderStage::Vertex))
+        return false;
+
+    ShaderReflectionData reflectionData;
+    if (!ReadReflectionData(reader, reflectionData))
+        return false;
+
+    uint8_t instanced = 0;
+    reader.Read(instanced);
+
+    uint32_t numElements = 0;
+    reader.ReadCount(numElements);
+
+    std::vector<std::string> semanticNames(numElements);
+    std::vector<D3D12_INPUT_ELEMENT_DESC> inputElements(numElements);
+    for (uint32_t i = 0; i != numElements; ++i)
+    {
+        D3D12_INPUT_ELEMENT_DESC& element = inputElements[i];
+        uint32_t format = 0, slotClass = 0;
+
+        reader.ReadString(semanticNames[i]);
+        reader.Read(element.SemanticIndex);
+        reader.Read(format);
+        reader.Read(element.InputSlot);
+        reader.Read(element.AlignedByteOffset);
+        reader.Read(slotClass);
+        reader.Read(element.InstanceDataStepRate);
+
+        element.Format = static_cast<DXGI_FORMAT>(format);
+        element.InputSlotClass = static_cast<D3D12_INPUT_CLASSIFICATION>(slotClass);
+    }
+
+    uint16_t attrCount = 0, byteSize = 0, instanceAttrCount = 0, instanceByteSize = 0;
+    reader.Read(attrCount);
+    reader.Read(byteSize);
+    reader.Read(instanceAttrCount);
+    reader.Read(instanceByteSize);
+
+    // Vertex then instance attributes, stored contiguously like BuildInputLayout allocates them
+    const size_t totalAttrCount = size_t(attrCount) + instanceAttrCount;
+    std::vector<Semantics> semantics(totalAttrCount);
+    std::vector<uint16_t> byteOffsets(totalAttrCount);
+    reader.ReadBytes(semantics.data(), semantics.size() * sizeof(Semantics));
+    reader.ReadBytes(byteOffsets.data(), byteOffsets.size() * sizeof(uint16_t));
+
+    if (reader.IsFailed() || !reader.IsAtEnd())
+        return false;
+
+    // Only touch the shader once everything has been read successfully
+    for (uint32_t i = 0; i != numElements; ++i)
+        inputElements[i].SemanticName = InternSemanticName(semanticNames[i]);
+
+    out_vs.ReflectionData = std::move(reflectionData);
+    out_vs.InputElements = std::move(inputElements);
+    out_vs.Instanced = instanced != 0;
+
+    VertexBufferDescription vbDesc;
+    vbDesc.SemanticsArr = new Semantics[totalAttrCount];
+    vbDesc.ByteOffsets = new uint16_t[totalAttrCount];
+    vbDesc.AttrCount = attrCount;
+    vbDesc.ByteSize = byteSize;
+    memcpy(vbDesc.SemanticsArr, semantics.data(), totalAttrCount * sizeof(Semantics));
+    memcpy(vbDesc.ByteOffsets, byteOffsets.data(), totalAttrCount * sizeof(uint16_t));
+    out_vs.VertexDesc = vbDesc;
+
+    ZeroMemory(&out_vs.InstanceDesc, sizeof(VertexBufferDescription));
+    if (out_vs.Instanced)
+    {
+        out_vs.InstanceDesc.SemanticsArr = vbDesc.SemanticsArr + attrCount;
+        out_vs.InstanceDesc.ByteOffsets = vbDesc.ByteOffsets + attrCount;
+        out_vs.InstanceDesc.AttrCount = instanceAttrCount;
+        out_vs.InstanceDesc.ByteSize = instanceByteSize;
+    }
+
+    return true;
+}
+
+bool LoadCachedReflection(uint64_t bytecodeHash, PixelShader& out_ps)
+{
+    std::vector<uint8_t> bytes;
+    if (!LoadCacheFile(bytecodeHash, bytes))
+        return false;
+
+    BinaryReader reader(bytes.data(), bytes.size());
+    if (!ReadHeader(reader, bytecodeHash, ShaderStage::Pixel))
+        return false;
+
+    ShaderReflectionData reflectionData;
+    if (!ReadReflectionData(reader, reflectionData) || !reader.IsAtEnd())
+        return false;
+
+    out_ps.ReflectionData = std::move(reflectionData);
+    return true;
+}
+
+bool SaveCachedReflection(uint64_t bytecodeHash, const VertexShader& vs)
+{
+    BinaryWriter writer;
+    WriteHeader(writer, bytecodeHash, ShaderStage::Vertex);
+    WriteReflectionData(writer, vs.ReflectionData);
+
+    writer.Write<uint8_t>(vs.Instanced ? 1 : 0);
+
+    writer.Write<uint32_t>(static_cast<uint32_t>(vs.InputElements.size()));
+    for (const D3D12_INPUT_ELEMENT_DESC& element : vs.InputElements)
+    {
+        writer.WriteString(element.SemanticName ? element.SemanticName : "");
+        writer.Write<uint32_t>(element.SemanticIndex);
+        writer.Write<uint32_t>(static_cast<uint32_t>(element.Format));
+        writer.Write<uint32_t>(element.InputSlot);
+        writer.Write<uint32_t>(element.AlignedByteOffset);
+        writer.Write<uint32_t>(static_cast<uint32_t>(element.InputSlotClass));
+        writer.Write<uint32_t>(element.InstanceDataStepRate);
+    }
+
+    const VertexBufferDescription& vbDesc = vs.VertexDesc;
+    const VertexBufferDescription& instDesc = vs.InstanceDesc;
+    const uint16_t attrCount = (vbDesc.SemanticsArr && vbDesc.ByteOffsets) ? vbDesc.AttrCount : 0;
+    const uint16_t instanceAttrCount = (attrCount && vs.Instanced) ? instDesc.AttrCount : 0;
+    writer.Write<uint16_t>(attrCount);
+    writer.Write<uint16_t>(vbDesc.ByteSize);
+    writer.Write<uint16_t>(instanceAttrCount);
+    writer.Write<uint16_t>(instanceAttrCount ? instDesc.ByteSize : 0);
+
+    // InstanceDesc points at the tail of VertexDesc's arrays, so both are written in one go
+    const size_t totalAttrCount = size_t(attrCount) + instanceAttrCount;
+    writer.WriteBytes(vbDesc.SemanticsArr, totalAttrCount * sizeof(Semantics));
+    writer.WriteBytes(vbDesc.ByteOffsets, totalAttrCount * sizeof(uint16_t));
+
+    return SaveCacheFile(bytecodeHash, writer);
+}
+
+bool SaveCachedReflection(uint64_t bytecodeHash, const PixelShader& ps)
+{
+    BinaryWriter writer;
+    WriteHeader(writer, bytecodeHash, ShaderStage::Pixel);
+    WriteReflectionData(writer, ps.ReflectionData);
+
+    return SaveCacheFile(bytecodeHash, writer);
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+// Validation
+
+static bool Mismatch(std::string& out_diff, const std::string& what)
+{
+    out_diff = what;
+    return false;
+}
+
+static bool CompareReflectionData(const ShaderReflectionData& a, const ShaderReflectionData& b, std::string& out_diff)
+{
+    if (a.Resources.size() != b.Resources.size())
+        return Mismatch(out_diff, "resource count");
+
+    for (size_t i = 0; i != a.Resources.size(); ++i)
+    {
+        const ShaderResourceBinding& ra = a.Resources[i];
+        const ShaderResourceBinding& rb = b.Resources[i];
+        if (ra.Name != rb.Name || ra.Type != rb.Type || ra.BindPoint != rb.BindPoint ||
+            ra.BindCount != rb.BindCount || ra.Space != rb.Space || ra.Size != rb.Size)
+        {
+            return Mismatch(out_diff, "resource '" + ra.Name + "'");
+        }
+    }
+
+    if (a.ConstantBuffers.size() != b.ConstantBuffers.size())
+        return Mismatch(out_diff, "constant buffer count");
+
+    for (size_t i = 0; i != a.ConstantBuffers.size(); ++i)
+    {
+        const ConstantBufferReflection& ca = a.ConstantBuffers[i];
+        const ConstantBufferReflection& cb = b.ConstantBuffers[i];
+        if (ca.Name != cb.Name || ca.BindPoint != cb.BindPoint || ca.Space != cb.Space ||
+            ca.Size != cb.Size || ca.Variables.size() != cb.Variables.size())
+        {
+            return Mismatch(out_diff, "constant buffer '" + ca.Name + "'");
+        }
+
+        for (size_t v = 0; v != ca.Variables.size(); ++v)
+        {
+            const ParameterDesc& va = ca.Variables[v];
+            const ParameterDesc& vb = cb.Variables[v];
+            if (va.Name != vb.Name || va.Type != vb.Type || va.Index != vb.Index ||
+                va.Offset != vb.Offset || va.ConstantBufferName != vb.ConstantBufferName)
+            {
+                return Mismatch(out_diff, "variable '" + ca.Name + "." + va.Name + "'");
+            }
+        }
+    }
+
+    return true;
+}
+
+bool CompareReflection(const VertexShader& a, const VertexShader& b, std::string& out_diff)
+{
+    if (!CompareReflectionData(a.ReflectionData, b.ReflectionData, out_diff))
+        return false;
+
+    if (!a.Instanced != !b.Instanced)
+        return Mismatch(out_diff, "instancing");
+
+    if (a.InputElements.size() != b.InputElements.size())
+        return Mismatch(out_diff, "input element count");
+
+    for (size_t i = 0; i != a.InputElements.size(); ++i)
+    {
+        const D3D12_INPUT_ELEMENT_DESC& ea = a.InputElements[i];
+        const D3D12_INPUT_ELEMENT_DESC& eb = b.InputElements[i];
+        const char* nameA = ea.SemanticName ? ea.SemanticName : "";
+        const char* nameB = eb.SemanticName ? eb.SemanticName : "";
+        if (strcmp(nameA, nameB) != 0 || ea.SemanticIndex != eb.SemanticIndex || ea.Format != eb.Format ||
+            ea.InputSlot != eb.InputSlot || ea.AlignedByteOffset != eb.AlignedByteOffset ||
+            ea.InputSlotClass != eb.InputSlotClass || ea.InstanceDataStepRate != eb.InstanceDataStepRate)
+        {
+            return Mismatch(out_diff, std::string("input element '") + nameA + "'");
+        }
+    }
+
+    const VertexBufferDescription& da = a.VertexDesc;
+    const VertexBufferDescription& db = b.VertexDesc;
+    if (da.AttrCount != db.AttrCount || da.ByteSize != db.ByteSize)
+        return Mismatch(out_diff, "vertex buffer description");
+
+    if (da.AttrCount != 0 &&
+        (memcmp(da.SemanticsArr, db.SemanticsArr, da.AttrCount * sizeof(Semantics)) != 0 ||
+         memcmp(da.ByteOffsets, db.ByteOffsets, da.AttrCount * sizeof(uint16_t)) != 0))
+    {
+        return Mismatch(out_diff, "vertex buffer semantics/offsets");
+    }
+
+    const VertexBufferDescription& ia = a.InstanceDesc;
+    const VertexBufferDescription& ib = b.InstanceDesc;
+    if (ia.AttrCount != ib.AttrCount || ia.ByteSize != ib.ByteSize)
+        return Mismatch(out_diff, "instance buffer description");
+
+    if (ia.AttrCount != 0 &&
+        (memcmp(ia.SemanticsArr, ib.SemanticsArr, ia.AttrCount * sizeof(Semantics)) != 0 ||
+         memcmp(ia.ByteOffsets, ib.ByteOffsets, ia.AttrCount * sizeof(uint16_t)) != 0))
+    {
+        return Mismatch(out_diff, "instance buffer semantics/offsets");
+    }
+
+    return true;
+}
+
+bool CompareReflection(const PixelShader& a, const PixelShader& b, std::string& out_diff)
+{
+    return CompareReflectionData(a.ReflectionData, b.ReflectionData, out_diff);
+}
+
+}
@@ -0,0 +1,45 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : On-disk cache of shader reflection results
+----------------------------------------------*/
+#ifndef MUON_SHADERREFLECTIONCACHE_H
+#define MUON_SHADERREFLECTIONCACHE_H
+
+#include <Core/DXCore.h>
+
+#include <stdint.h>
+#include <string>
+
+// When enabled, shaders loaded from the reflection cache are also reflected live and compared field by field.
+// Mismatches are reported and the cache entry is rewritten from the live results.
+#ifndef MN_VALIDATE_REFLECTION_CACHE
+#define MN_VALIDATE_REFLECTION_CACHE 0
+#endif
+
+namespace Muon
+{
+struct VertexShader;
+struct PixelShader;
+}
+
+namespace Muon
+{
+
+// One file per shader under the cache folder, named after a 64-bit hash of its bytecode,
+// so recompiling a shader naturally misses and stale entries are simply never read again.
+uint64_t HashShaderBytecode(ID3DBlob* pBlob);
+
+bool LoadCachedReflection(uint64_t bytecodeHash, VertexShader& out_vs);
+bool LoadCachedReflection(uint64_t bytecodeHash, PixelShader& out_ps);
+
+bool SaveCachedReflection(uint64_t bytecodeHash, const VertexShader& vs);
+bool SaveCachedReflection(uint64_t bytecodeHash, const PixelShader& ps);
+
+// Returns true if both hold the same reflection results, otherwise describes the first difference
+bool CompareReflection(const VertexShader& a, const VertexShader& b, std::string& out_diff);
+bool CompareReflection(const PixelShader& a, const PixelShader& b, std::string& out_diff);
+
+}
+
+#endif
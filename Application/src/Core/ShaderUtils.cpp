@@ -5,9 +5,11 @@ Description : Useful functions for shader reflection system
 ----------------------------------------------*/
 #include <Core/ShaderUtils.h>
 #include <Core/Shader.h>
+#include <Core/StringArena.h>
 #include <Utils/Utils.h>
 
 #include <DirectXMath.h>
+#include <dxcapi.h>
 #include <unordered_map>
 
 namespace Muon
@@ -29,7 +31,7 @@ namespace Muon
     {
         "INSTANCE_POSITION",
         "INSTANCE_NORMAL",
-        "INSTANCE_TEXCOORD,",
+        "INSTANCE_TEXCOORD",
         "INSTANCE_TANGENT",
         "INSTANCE_BINORMAL",
         "INSTANCE_COLOR",
@@ -38,6 +40,14 @@ namespace Muon
         "INSTANCE_WORLDMATRIX"
     };
 
+    // Input element semantic names for every loaded vertex shader. Shared, since most shaders use the same handful.
+    static StringArena gSemanticNames;
+
+    const char* InternSemanticName(std::string_view name)
+    {
+        return gSemanticNames.Intern(name);
+    }
+
     ParameterDesc::ParameterDesc(const char* name, ParameterType type)
         : Name(name)
         , Type(type)
@@ -90,6 +100,30 @@ namespace Muon
         return ParameterType::Invalid;
     }
 
+    HRESULT CreateShaderReflection(ID3DBlob* pBlob, ID3D12ShaderReflection** ppReflection)
+    {
+        if (!pBlob || !ppReflection)
+            return E_INVALIDARG;
+
+        HRESULT hr = D3DReflect(pBlob->GetBufferPointer(), pBlob->GetBufferSize(),
+            IID_ID3D12ShaderReflection, (void**)ppReflection);
+
+        if (SUCCEEDED(hr))
+            return hr;
+
+        Microsoft::WRL::ComPtr<IDxcUtils> pUtils;
+        hr = DxcCreateInstance(CLSID_DxcUtils, IID_PPV_ARGS(pUtils.GetAddressOf()));
+        if (FAILED(hr))
+            return hr;
+
+        DxcBuffer buffer;
+        buffer.Ptr = pBlob->GetBufferPointer();
+        buffer.Size = pBlob->GetBufferSize();
+        buffer.Encoding = 0;
+
+        return pUtils->CreateReflection(&buffer, IID_PPV_ARGS(ppReflection));
+    }
+
     bool ParseReflectedResources(ID3D12ShaderReflection* pReflection, ShaderReflectionData& outShaderReflectionData)
     {
         D3D12_SHADER_DESC shaderDesc;
@@ -182,7 +216,8 @@ namespace Muon
 
     // Previously called AssignDXGIFormatsAndByteOffsets
     void PopulateInputElements(D3D12_INPUT_CLASSIFICATION slotClass,
-        std::vector < D3D12_SIGNATURE_PARAMETER_DESC> paramDescs,
+        const std::vector<D3D12_SIGNATURE_PARAMETER_DESC>& paramDescs,
+        UINT firstInput,
         UINT numInputs,
         std::vector<D3D12_INPUT_ELEMENT_DESC>& out_inputParams,
         uint16_t* out_byteOffsets,
@@ -191,16 +226,13 @@ namespace Muon
         uint16_t totalByteSize = 0;
         for (uint8_t i = 0; i != numInputs; ++i)
         {
-            D3D12_SIGNATURE_PARAMETER_DESC& paramDesc = paramDescs[i];
+            const D3D12_SIGNATURE_PARAMETER_DESC& paramDesc = paramDescs[firstInput + i];
 
             out_inputParams.push_back(D3D12_INPUT_ELEMENT_DESC());
             D3D12_INPUT_ELEMENT_DESC& inputParam = out_inputParams.back();
 
-            size_t length = 1 + strnlen_s(paramDesc.SemanticName, 256);
-            char* buf = new CHAR[length];
-            memset(buf, 0, length);
-            strncpy(buf, paramDesc.SemanticName, length);
-            inputParam.SemanticName = buf;
+            // The reflection interface owns SemanticName, so it needs a copy that outlives it
+            inputParam.SemanticName = InternSemanticName(paramDesc.SemanticName);
             inputParam.SemanticIndex = paramDesc.SemanticIndex;
             inputParam.InputSlotClass = slotClass;
 
@@ -247,9 +279,6 @@ namespace Muon
                 else if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_SINT32)   inputParam.Format = DXGI_FORMAT_R32G32B32A32_SINT;
                 else if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_FLOAT32)   inputParam.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
             }
-
-
-            out_inputParams[i] = inputParam;
         }
 
         out_byteSize = totalByteSize;
@@ -304,14 +333,25 @@ namespace Muon
         }
 
         // Now the temp array has all the semantics properly labeled. Use it to create the vertex buffer and the instance buffer(if applicable)
+        const UINT numVertexInputs = out_shader->Instanced ? instanceStartIdx : numInputs;
         VertexBufferDescription vbDesc;
 
         vbDesc.ByteOffsets = new uint16_t[numInputs];//(uint16_t*)malloc(sizeof(uint16_t) * numInputs);
-        PopulateInputElements(D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, paramDescs, numInputs, out_shader->InputElements, vbDesc.ByteOffsets, vbDesc.ByteSize);
+        PopulateInputElements(D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, paramDescs, 0, numVertexInputs, out_shader->InputElements, vbDesc.ByteOffsets, vbDesc.ByteSize);
         vbDesc.SemanticsArr = semanticsArr;
-        vbDesc.AttrCount = numInputs;
+        vbDesc.AttrCount = static_cast<uint16_t>(numVertexInputs);
         out_shader->VertexDesc = vbDesc;
 
+        // Instance attributes go in slot 1 and live at the tail of the vertex description's arrays
+        if (out_shader->Instanced)
+        {
+            VertexBufferDescription& instDesc = out_shader->InstanceDesc;
+            instDesc.SemanticsArr = semanticsArr + numVertexInputs;
+            instDesc.ByteOffsets = vbDesc.ByteOffsets + numVertexInputs;
+            instDesc.AttrCount = numInstanceInputs;
+            PopulateInputElements(D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, paramDescs, numVertexInputs, numInstanceInputs, out_shader->InputElements, instDesc.ByteOffsets, instDesc.ByteSize);
+        }
+
         return true;
     }
 
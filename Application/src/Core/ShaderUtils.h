@@ -8,6 +8,9 @@ Description : Useful functions for shader reflection system
 
 #include <Core/DXCore.h>
 
+#include <string_view>
+#include <vector>
+
 namespace Muon
 {
     struct VertexShader;
@@ -21,15 +24,22 @@ namespace Muon
 
 namespace Muon
 {
+// Returns a copy of name that lives as long as the program, for use as an input element's SemanticName
+const char* InternSemanticName(std::string_view name);
+
 size_t GetParamTypeSize(ParameterType type);
 
 ParameterType D3DTypeToParameterType(const D3D12_SHADER_TYPE_DESC& typeDesc);
     
+// D3DReflect only understands DXBC (fxc). DXIL from DXC is reflected through IDxcUtils instead.
+HRESULT CreateShaderReflection(ID3DBlob* pBlob, ID3D12ShaderReflection** ppReflection);
+
 bool ParseReflectedResources(ID3D12ShaderReflection* pReflection, 
     ShaderReflectionData& outShaderReflectionData);
 
 void PopulateInputElements(D3D12_INPUT_CLASSIFICATION slotClass,
-    std::vector<D3D12_SIGNATURE_PARAMETER_DESC> paramDescs,
+    const std::vector<D3D12_SIGNATURE_PARAMETER_DESC>& paramDescs,
+    UINT firstInput,
     UINT numInputs,
     std::vector<D3D12_INPUT_ELEMENT_DESC>& out_inputParams,
     uint16_t* out_byteOffsets,
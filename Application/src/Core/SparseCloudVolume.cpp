@@ -0,0 +1,561 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Sparse brick volumes for voxel clouds, memory mapped from disk and streamed into a fixed-size brick pool
+----------------------------------------------*/
+#include <Core/SparseCloudVolume.h>
+
+#include <Core/JobSystem.h>
+#include <Core/Profiler.h>
+#include <Utils/Utils.h>
+
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <numeric>
+#include <string.h>
+
+namespace Muon
+{
+
+namespace
+{
+    static const uint32_t kSparseVolumeMagic = 0x56534E4D; // 'MNSV'
+    static const uint32_t kSparseVolumeVersion = 1;
+    static const size_t kMaxGridCells = size_t(1) << 24;
+    static const uint64_t kBrickDataAlignment = 4096;
+    static const size_t kBricksPerJob = 64;
+    static const size_t kCopiesPerJob = 16;
+
+    static_assert(sizeof(SparseBrickCoord) == 8, "SparseBrickCoord is written to disk as is");
+    static_assert(sizeof(SparseCloudVolumeHeader) == 80, "SparseCloudVolumeHeader is written to disk as is");
+
+    size_t GetNumCells(const uint32_t gridSize[3])
+    {
+        return size_t(gridSize[0]) * gridSize[1] * gridSize[2];
+    }
+
+    size_t GetCellIndex(const uint32_t gridSize[3], uint32_t x, uint32_t y, uint32_t z)
+    {
+        return (size_t(z) * gridSize[1] + y) * gridSize[0] + x;
+    }
+
+    // Spreads the low 12 bits of v three bits apart
+    uint64_t SpreadBits3(uint64_t v)
+    {
+        v &= 0xFFF;
+        v = (v | (v << 16)) & 0x0000FF0000FFull;
+        v = (v | (v << 8)) & 0x00F00F00F00Full;
+        v = (v | (v << 4)) & 0x0C30C30C30C3ull;
+        v = (v | (v << 2)) & 0x249249249249ull;
+        return v;
+    }
+
+    uint64_t MortonCode(const SparseBrickCoord& coord)
+    {
+        return SpreadBits3(coord.X) | (SpreadBits3(coord.Y) << 1) | (SpreadBits3(coord.Z) << 2);
+    }
+
+    bool ValidateGrid(const uint32_t gridSize[3])
+    {
+        for (uint32_t a = 0; a != 3; ++a)
+        {
+            if (gridSize[a] == 0 || gridSize[a] > SPARSE_MAX_GRID_SIZE)
+            {
+                Muon::Printf("Error: Sparse volumes must be between 1 and %u bricks across, not %ux%ux%u!\n",
+                    SPARSE_MAX_GRID_SIZE, gridSize[0], gridSize[1], gridSize[2]);
+                return false;
+            }
+        }
+
+        if (GetNumCells(gridSize) > kMaxGridCells)
+        {
+            Muon::Printf("Error: A %ux%ux%u brick grid has more than %zu cells!\n", gridSize[0], gridSize[1], gridSize[2], kMaxGridCells);
+            return false;
+        }
+        return true;
+    }
+
+    // Written so a huge offset can't wrap around and pass
+    bool FitsInFile(uint64_t offset, uint64_t bytes, size_t fileSize)
+    {
+        return offset <= fileSize && bytes <= fileSize - offset;
+    }
+
+    // Everything Open relies on to index safely into the mapping
+    bool ValidateHeader(const SparseCloudVolumeHeader& header, size_t fileSize)
+    {
+        if (header.Magic != kSparseVolumeMagic || header.Version != kSparseVolumeVersion || header.BrickSize != SPARSE_BRICK_SIZE)
+            return false;
+
+        if (!ValidateGrid(header.GridSize) || header.NumBricks > GetNumCells(header.GridSize))
+            return false;
+
+        if (!(header.VoxelSize > 0.0f) || !(header.DensityScale > 0.0f) || !isfinite(header.VoxelSize) || !isfinite(header.DensityScale))
+            return false;
+
+        const uint64_t indirectionBytes = uint64_t(GetNumCells(header.GridSize)) * sizeof(uint32_t);
+        const uint64_t coordBytes = uint64_t(header.NumBricks) * sizeof(SparseBrickCoord);
+        const uint64_t brickBytes = uint64_t(header.NumBricks) * SPARSE_BRICK_VOXELS;
+        return header.IndirectionOffset % alignof(uint32_t) == 0 && header.BrickCoordsOffset % alignof(SparseBrickCoord) == 0 &&
+            header.IndirectionOffset >= sizeof(header) && FitsInFile(header.IndirectionOffset, indirectionBytes, fileSize) &&
+            header.BrickCoordsOffset >= sizeof(header) && FitsInFile(header.BrickCoordsOffset, coordBytes, fileSize) &&
+            header.BrickDataOffset >= sizeof(header) && FitsInFile(header.BrickDataOffset, brickBytes, fileSize);
+    }
+}
+
+bool SparseCloudVolumeData::Init(const uint32_t gridSize[3], const float origin[3], float voxelSize, float densityScale)
+{
+    if (!ValidateGrid(gridSize))
+        return false;
+
+    if (!(voxelSize > 0.0f) || !(densityScale > 0.0f))
+    {
+        Muon::Printf("Error: Sparse volume voxel size (%f) and density scale (%f) must be positive!\n", voxelSize, densityScale);
+        return false;
+    }
+
+    for (uint32_t a = 0; a != 3; ++a)
+    {
+        GridSize[a] = gridSize[a];
+        Origin[a] = origin[a];
+    }
+    VoxelSize = voxelSize;
+    DensityScale = densityScale;
+
+    Indirection.assign(GetNumCells(gridSize), SPARSE_EMPTY_BRICK);
+    Bricks.clear();
+    BrickVoxels.clear();
+    return true;
+}
+
+uint32_t SparseCloudVolumeData::AddBrick(uint16_t x, uint16_t y, uint16_t z)
+{
+    uint32_t& index = Indirection[GetCellIndex(GridSize, x, y, z)];
+    if (index != SPARSE_EMPTY_BRICK)
+        return index;
+
+    SparseBrickCoord coord;
+    coord.X = x;
+    coord.Y = y;
+    coord.Z = z;
+
+    index = static_cast<uint32_t>(Bricks.size());
+    Bricks.push_back(coord);
+    BrickVoxels.resize(BrickVoxels.size() + SPARSE_BRICK_VOXELS, 0);
+    return index;
+}
+
+void SparseCloudVolumeData::Finalize()
+{
+    std::vector<uint32_t> order;
+    order.reserve(Bricks.size());
+    for (uint32_t b = 0; b != Bricks.size(); ++b)
+    {
+        const uint8_t* pVoxels = &BrickVoxels[size_t(b) * SPARSE_BRICK_VOXELS];
+        Bricks[b].MaxValue = *std::max_element(pVoxels, pVoxels + SPARSE_BRICK_VOXELS);
+        if (Bricks[b].MaxValue != 0)
+            order.push_back(b);
+    }
+
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return MortonCode(Bricks[a]) < MortonCode(Bricks[b]); });
+
+    std::vector<SparseBrickCoord> sortedBricks(order.size());
+    std::vector<uint8_t> sortedVoxels(order.size() * SPARSE_BRICK_VOXELS);
+    std::fill(Indirection.begin(), Indirection.end(), SPARSE_EMPTY_BRICK);
+    for (uint32_t i = 0; i != order.size(); ++i)
+    {
+        const SparseBrickCoord& coord = Bricks[order[i]];
+        sortedBricks[i] = coord;
+        memcpy(&sortedVoxels[size_t(i) * SPARSE_BRICK_VOXELS], &BrickVoxels[size_t(order[i]) * SPARSE_BRICK_VOXELS], SPARSE_BRICK_VOXELS);
+        Indirection[GetCellIndex(GridSize, coord.X, coord.Y, coord.Z)] = i;
+    }
+
+    Bricks.swap(sortedBricks);
+    BrickVoxels.swap(sortedVoxels);
+}
+
+bool BuildSparseCloudVolume(const float* pDensity, const uint32_t dims[3], const float origin[3], float voxelSize, float threshold,
+    SparseCloudVolumeData& out_data)
+{
+    MUON_PROFILE_SCOPE("Build Sparse Cloud Volume");
+
+    uint32_t gridSize[3];
+    for (uint32_t a = 0; a != 3; ++a)
+        gridSize[a] = (dims[a] + SPARSE_BRICK_SIZE - 1) / SPARSE_BRICK_SIZE;
+
+    if (!pDensity || !ValidateGrid(gridSize))
+        return false;
+
+    JobSystem& jobSystem = JobSystem::GetSingleton();
+
+    // Densest voxel of every brick, which decides both occupancy and the quantization scale
+    const size_t numCells = GetNumCells(gridSize);
+    std::vector<float> brickMax(numCells, 0.0f);
+    jobSystem.ParallelFor(numCells, kBricksPerJob, [&](size_t begin, size_t end)
+    {
+        for (size_t cell = begin; cell != end; ++cell)
+        {
+            const uint32_t bx = static_cast<uint32_t>(cell % gridSize[0]) * SPARSE_BRICK_SIZE;
+            const uint32_t by = static_cast<uint32_t>(cell / gridSize[0] % gridSize[1]) * SPARSE_BRICK_SIZE;
+            const uint32_t bz = static_cast<uint32_t>(cell / (size_t(gridSize[0]) * gridSize[1])) * SPARSE_BRICK_SIZE;
+
+            float maxValue = 0.0f;
+            for (uint32_t z = bz; z < std::min(bz + SPARSE_BRICK_SIZE, dims[2]); ++z)
+            {
+                for (uint32_t y = by; y < std::min(by + SPARSE_BRICK_SIZE, dims[1]); ++y)
+                {
+                    const float* pRow = pDensity + (size_t(z) * dims[1] + y) * dims[0];
+                    for (uint32_t x = bx; x < std::min(bx + SPARSE_BRICK_SIZE, dims[0]); ++x)
+                        maxValue = std::max(maxValue, pRow[x]);
+                }
+            }
+            brickMax[cell] = maxValue;
+        }
+    });
+
+    const float densityScale = *std::max_element(brickMax.begin(), brickMax.end());
+    if (!out_data.Init(gridSize, origin, voxelSize, densityScale > 0.0f ? densityScale : 1.0f))
+        return false;
+
+    for (size_t cell = 0; cell != numCells; ++cell)
+    {
+        if (brickMax[cell] > threshold)
+        {
+            out_data.AddBrick(static_cast<uint16_t>(cell % gridSize[0]), static_cast<uint16_t>(cell / gridSize[0] % gridSize[1]),
+                static_cast<uint16_t>(cell / (size_t(gridSize[0]) * gridSize[1])));
+        }
+    }
+
+    const float quantize = 255.0f / out_data.DensityScale;
+    jobSystem.ParallelFor(out_data.Bricks.size(), kBricksPerJob, [&](size_t begin, size_t end)
+    {
+        for (size_t b = begin; b != end; ++b)
+        {
+            const SparseBrickCoord& coord = out_data.Bricks[b];
+            uint8_t* pBrick = &out_data.BrickVoxels[b * SPARSE_BRICK_VOXELS];
+            for (uint32_t z = 0; z != SPARSE_BRICK_SIZE; ++z)
+            {
+                const uint32_t vz = coord.Z * SPARSE_BRICK_SIZE + z;
+                for (uint32_t y = 0; y != SPARSE_BRICK_SIZE; ++y)
+                {
+                    const uint32_t vy = coord.Y * SPARSE_BRICK_SIZE + y;
+                    for (uint32_t x = 0; x != SPARSE_BRICK_SIZE; ++x)
+                    {
+                        // Voxels past the edge of a partial brick stay empty
+                        const uint32_t vx = coord.X * SPARSE_BRICK_SIZE + x;
+                        if (vx >= dims[0] || vy >= dims[1] || vz >= dims[2])
+                            continue;
+
+                        const float value = pDensity[(size_t(vz) * dims[1] + vy) * dims[0] + vx] * quantize;
+                        pBrick[(z * SPARSE_BRICK_SIZE + y) * SPARSE_BRICK_SIZE + x] = static_cast<uint8_t>(std::min(std::max(value, 0.0f), 255.0f) + 0.5f);
+                    }
+                }
+            }
+        }
+    });
+
+    out_data.Finalize();
+    return true;
+}
+
+bool SaveSparseCloudVolume(const SparseCloudVolumeData& data, const wchar_t* path, uint64_t sourceHash)
+{
+    const size_t numCells = GetNumCells(data.GridSize);
+    if (!ValidateGrid(data.GridSize) || data.Indirection.size() != numCells || data.BrickVoxels.size() != data.Bricks.size() * SPARSE_BRICK_VOXELS)
+    {
+        Muon::Printf(L"Error: Can't save malformed sparse volume %s!\n", path);
+        return false;
+    }
+
+    SparseCloudVolumeHeader header;
+    header.Magic = kSparseVolumeMagic;
+    header.Version = kSparseVolumeVersion;
+    header.BrickSize = SPARSE_BRICK_SIZE;
+    header.NumBricks = static_cast<uint32_t>(data.Bricks.size());
+    for (uint32_t a = 0; a != 3; ++a)
+    {
+        header.GridSize[a] = data.GridSize[a];
+        header.Origin[a] = data.Origin[a];
+    }
+    header.VoxelSize = data.VoxelSize;
+    header.DensityScale = data.DensityScale;
+    header.SourceHash = sourceHash;
+    header.IndirectionOffset = sizeof(header);
+    header.BrickCoordsOffset = header.IndirectionOffset + numCells * sizeof(uint32_t);
+
+    const uint64_t coordsEnd = header.BrickCoordsOffset + data.Bricks.size() * sizeof(SparseBrickCoord);
+    header.BrickDataOffset = (coordsEnd + kBrickDataAlignment - 1) & ~(kBrickDataAlignment - 1);
+
+    BinaryWriter writer;
+    writer.Write(header);
+    writer.WriteBytes(data.Indirection.data(), numCells * sizeof(uint32_t));
+    writer.WriteBytes(data.Bricks.data(), data.Bricks.size() * sizeof(SparseBrickCoord));
+
+    const std::vector<uint8_t> padding(static_cast<size_t>(header.BrickDataOffset - coordsEnd), 0);
+    writer.WriteBytes(padding.data(), padding.size());
+    writer.WriteBytes(data.BrickVoxels.data(), data.BrickVoxels.size());
+
+    if (!writer.SaveToFile(path))
+    {
+        Muon::Printf(L"Error: Failed to write sparse volume %s!\n", path);
+        return false;
+    }
+    return true;
+}
+
+bool ReadSparseCloudVolumeHeader(const wchar_t* path, SparseCloudVolumeHeader& out_header)
+{
+    MappedFile file;
+    if (!file.Open(path) || file.GetSize() < sizeof(out_header))
+        return false;
+
+    memcpy(&out_header, file.GetData(), sizeof(out_header));
+    return ValidateHeader(out_header, file.GetSize());
+}
+
+bool SparseCloudVolume::Open(const wchar_t* path, uint32_t poolCapacity)
+{
+    Close();
+
+    if (!mFile.Open(path) || mFile.GetSize() < sizeof(mHeader))
+    {
+        Muon::Printf(L"Error: Failed to map sparse volume %s!\n", path);
+        Close();
+        return false;
+    }
+
+    memcpy(&mHeader, mFile.GetData(), sizeof(mHeader));
+    if (!ValidateHeader(mHeader, mFile.GetSize()))
+    {
+        Muon::Printf(L"Error: %s isn't a valid sparse volume, or was written by another version!\n", path);
+        Close();
+        return false;
+    }
+
+    const uint32_t* pIndirection = reinterpret_cast<const uint32_t*>(mFile.GetData() + mHeader.IndirectionOffset);
+    mpBricks = reinterpret_cast<const SparseBrickCoord*>(mFile.GetData() + mHeader.BrickCoordsOffset);
+    mpBrickData = mFile.GetData() + mHeader.BrickDataOffset;
+
+    // The tables are small next to the bricks, and checking them here means nothing later has to
+    for (uint32_t b = 0; b != mHeader.NumBricks; ++b)
+    {
+        const SparseBrickCoord& coord = mpBricks[b];
+        if (coord.X >= mHeader.GridSize[0] || coord.Y >= mHeader.GridSize[1] || coord.Z >= mHeader.GridSize[2] ||
+            pIndirection[GetCellIndex(mHeader.GridSize, coord.X, coord.Y, coord.Z)] != b)
+        {
+            Muon::Printf(L"Error: Sparse volume %s has a corrupt brick table!\n", path);
+            Close();
+            return false;
+        }
+    }
+
+    const uint32_t capacity = std::min(poolCapacity, mHeader.NumBricks);
+    mPool.assign(size_t(capacity) * SPARSE_BRICK_VOXELS, 0);
+    mPageTable.assign(GetNumCells(mHeader.GridSize), INVALID_SLOT);
+    mBrickSlots.assign(mHeader.NumBricks, INVALID_SLOT);
+    mSlotBricks.assign(capacity, INVALID_SLOT);
+    mFreeSlots.resize(capacity);
+    for (uint32_t s = 0; s != capacity; ++s)
+        mFreeSlots[s] = capacity - 1 - s;
+
+    mRanking.resize(mHeader.NumBricks);
+    std::iota(mRanking.begin(), mRanking.end(), 0);
+    mBrickDistances.assign(mHeader.NumBricks, 0.0f);
+    mWanted.assign(mHeader.NumBricks, 0);
+    mMissing.clear();
+    mHasRanking = false;
+
+    mStats = SparseVolumeResidencyStats();
+    mStats.NumBricks = mHeader.NumBricks;
+    mStats.PoolCapacity = capacity;
+    mStats.PoolBytes = mPool.size();
+    mStats.FileBytes = mFile.GetSize();
+    return true;
+}
+
+void SparseCloudVolume::Close()
+{
+    mFile.Close();
+    mHeader = SparseCloudVolumeHeader();
+    mpBricks = nullptr;
+    mpBrickData = nullptr;
+
+    mPool.clear();
+    mPageTable.clear();
+    mBrickSlots.clear();
+    mSlotBricks.clear();
+    mFreeSlots.clear();
+    mRanking.clear();
+    mBrickDistances.clear();
+    mWanted.clear();
+    mMissing.clear();
+    mHasRanking = false;
+    mStats = SparseVolumeResidencyStats();
+}
+
+float SparseCloudVolume::GetBrickDistanceSq(uint32_t brick, const float cameraPos[3]) const
+{
+    const SparseBrickCoord& coord = mpBricks[brick];
+    const float brickWorldSize = SPARSE_BRICK_SIZE * mHeader.VoxelSize;
+    const float dx = mHeader.Origin[0] + (coord.X + 0.5f) * brickWorldSize - cameraPos[0];
+    const float dy = mHeader.Origin[1] + (coord.Y + 0.5f) * brickWorldSize - cameraPos[1];
+    const float dz = mHeader.Origin[2] + (coord.Z + 0.5f) * brickWorldSize - cameraPos[2];
+    return dx * dx + dy * dy + dz * dz;
+}
+
+void SparseCloudVolume::UpdateStreaming(const float cameraPos[3], uint32_t maxBricksPerUpdate)
+{
+    using Clock = std::chrono::high_resolution_clock;
+
+    MUON_PROFILE_SCOPE("Stream Cloud Bricks");
+    if (!IsOpen() || mSlotBricks.empty())
+        return;
+
+    const Clock::time_point start = Clock::now();
+    const uint32_t numBricks = mHeader.NumBricks;
+    const uint32_t capacity = static_cast<uint32_t>(mSlotBricks.size());
+    const float brickWorldSize = SPARSE_BRICK_SIZE * mHeader.VoxelSize;
+
+    const float movedX = cameraPos[0] - mLastRankedPos[0];
+    const float movedY = cameraPos[1] - mLastRankedPos[1];
+    const float movedZ = cameraPos[2] - mLastRankedPos[2];
+    const float rerankDistance = 0.5f * brickWorldSize;
+    if (!mHasRanking || movedX * movedX + movedY * movedY + movedZ * movedZ > rerankDistance * rerankDistance)
+    {
+        // Resident bricks are ranked a brick closer than they are, so bricks on the cut-off don't thrash as the camera wobbles
+        for (uint32_t b = 0; b != numBricks; ++b)
+        {
+            const float distance = sqrtf(GetBrickDistanceSq(b, cameraPos));
+            mBrickDistances[b] = mBrickSlots[b] != INVALID_SLOT ? distance - brickWorldSize : distance;
+        }
+
+        const auto byDistance = [&](uint32_t a, uint32_t b) { return mBrickDistances[a] < mBrickDistances[b]; };
+        if (capacity < numBricks)
+            std::nth_element(mRanking.begin(), mRanking.begin() + capacity, mRanking.end(), byDistance);
+
+        std::fill(mWanted.begin(), mWanted.end(), 0);
+        mMissing.clear();
+        for (uint32_t i = 0; i != capacity; ++i)
+        {
+            const uint32_t brick = mRanking[i];
+            mWanted[brick] = 1;
+            if (mBrickSlots[brick] == INVALID_SLOT)
+                mMissing.push_back(brick);
+        }
+
+        // Nearest first, so a limited budget fills in around the camera
+        std::sort(mMissing.begin(), mMissing.end(), byDistance);
+
+        for (uint32_t a = 0; a != 3; ++a)
+            mLastRankedPos[a] = cameraPos[a];
+        mHasRanking = true;
+    }
+
+    const uint32_t numToStream = std::min<uint32_t>(maxBricksPerUpdate, static_cast<uint32_t>(mMissing.size()));
+    if (numToStream > 0)
+    {
+        // Any brick that fell out of the wanted set can go, farthest first. Wanted bricks never exceed the pool, so there are always enough.
+        std::vector<uint32_t> evictable;
+        if (mFreeSlots.size() < numToStream)
+        {
+            for (uint32_t s = 0; s != capacity; ++s)
+            {
+                if (mSlotBricks[s] != INVALID_SLOT && !mWanted[mSlotBricks[s]])
+                    evictable.push_back(s);
+            }
+            std::sort(evictable.begin(), evictable.end(), [&](uint32_t a, uint32_t b)
+            {
+                return mBrickDistances[mSlotBricks[a]] < mBrickDistances[mSlotBricks[b]];
+            });
+        }
+
+        std::vector<uint32_t> slots(numToStream);
+        for (uint32_t i = 0; i != numToStream; ++i)
+        {
+            uint32_t slot = INVALID_SLOT;
+            if (!mFreeSlots.empty())
+            {
+                slot = mFreeSlots.back();
+                mFreeSlots.pop_back();
+            }
+            else
+            {
+                slot = evictable.back();
+                evictable.pop_back();
+
+                const uint32_t evicted = mSlotBricks[slot];
+                const SparseBrickCoord& coord = mpBricks[evicted];
+                mBrickSlots[evicted] = INVALID_SLOT;
+                mPageTable[GetCellIndex(mHeader.GridSize, coord.X, coord.Y, coord.Z)] = INVALID_SLOT;
+                ++mStats.TotalEvicted;
+            }
+
+            const uint32_t brick = mMissing[i];
+            const SparseBrickCoord& coord = mpBricks[brick];
+            mSlotBricks[slot] = brick;
+            mBrickSlots[brick] = slot;
+            mPageTable[GetCellIndex(mHeader.GridSize, coord.X, coord.Y, coord.Z)] = slot;
+            slots[i] = slot;
+        }
+
+        // Reading the mapping is what pulls bricks in from disk, so the page faults are spread across the workers
+        JobSystem::GetSingleton().ParallelFor(numToStream, kCopiesPerJob, [&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i != end; ++i)
+                memcpy(&mPool[size_t(slots[i]) * SPARSE_BRICK_VOXELS], mpBrickData + size_t(mMissing[i]) * SPARSE_BRICK_VOXELS, SPARSE_BRICK_VOXELS);
+        });
+
+        mMissing.erase(mMissing.begin(), mMissing.begin() + numToStream);
+        mStats.TotalStreamedIn += numToStream;
+    }
+
+    mStats.NumResident = capacity - static_cast<uint32_t>(mFreeSlots.size());
+    mStats.NumPending = static_cast<uint32_t>(mMissing.size());
+    mStats.LastUpdateMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+uint8_t SparseCloudVolume::LoadVoxel(int32_t x, int32_t y, int32_t z) const
+{
+    const int32_t brickSize = static_cast<int32_t>(SPARSE_BRICK_SIZE);
+    if (x < 0 || y < 0 || z < 0 ||
+        x >= int32_t(mHeader.GridSize[0]) * brickSize || y >= int32_t(mHeader.GridSize[1]) * brickSize || z >= int32_t(mHeader.GridSize[2]) * brickSize)
+        return 0;
+
+    const uint32_t slot = mPageTable[GetCellIndex(mHeader.GridSize, x / brickSize, y / brickSize, z / brickSize)];
+    if (slot == INVALID_SLOT)
+        return 0;
+
+    const uint32_t local = ((z % brickSize) * brickSize + (y % brickSize)) * brickSize + (x % brickSize);
+    return mPool[size_t(slot) * SPARSE_BRICK_VOXELS + local];
+}
+
+float SparseCloudVolume::SampleDensity(const float worldPos[3]) const
+{
+    if (!IsOpen())
+        return 0.0f;
+
+    int32_t base[3];
+    float weights[3];
+    for (uint32_t a = 0; a != 3; ++a)
+    {
+        const float voxel = (worldPos[a] - mHeader.Origin[a]) / mHeader.VoxelSize - 0.5f;
+        const float floorVoxel = floorf(voxel);
+        if (!(floorVoxel > -2.0f && floorVoxel < float(mHeader.GridSize[a] * SPARSE_BRICK_SIZE)))
+            return 0.0f;
+
+        base[a] = static_cast<int32_t>(floorVoxel);
+        weights[a] = voxel - floorVoxel;
+    }
+
+    float value = 0.0f;
+    for (uint32_t corner = 0; corner != 8; ++corner)
+    {
+        const uint32_t dx = corner & 1, dy = (corner >> 1) & 1, dz = corner >> 2;
+        const float weight = (dx ? weights[0] : 1.0f - weights[0]) * (dy ? weights[1] : 1.0f - weights[1]) * (dz ? weights[2] : 1.0f - weights[2]);
+        value += weight * LoadVoxel(base[0] + dx, base[1] + dy, base[2] + dz);
+    }
+    return value * (mHeader.DensityScale / 255.0f);
+}
+
+}
@@ -0,0 +1,146 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Sparse brick volumes for voxel clouds, memory mapped from disk and streamed into a fixed-size brick pool
+----------------------------------------------*/
+#ifndef MUON_SPARSECLOUDVOLUME_H
+#define MUON_SPARSECLOUDVOLUME_H
+
+#include <Core/BinaryStream.h>
+
+#include <stdint.h>
+#include <vector>
+
+namespace Muon
+{
+
+// Bricks are 8^3 R8 density voxels, x fastest, with no apron.
+static const uint32_t SPARSE_BRICK_SIZE = 8;
+static const uint32_t SPARSE_BRICK_VOXELS = SPARSE_BRICK_SIZE * SPARSE_BRICK_SIZE * SPARSE_BRICK_SIZE;
+static const uint32_t SPARSE_EMPTY_BRICK = UINT32_MAX;
+static const uint32_t SPARSE_MAX_GRID_SIZE = 4096; // Bricks along each axis, so coordinates fit in 16 bits
+
+struct SparseBrickCoord
+{
+    uint16_t X = 0;
+    uint16_t Y = 0;
+    uint16_t Z = 0;
+    uint8_t MaxValue = 0; // Densest voxel in the brick
+    uint8_t Pad = 0;
+};
+
+// In-memory form, built by the importers and written with SaveSparseCloudVolume
+struct SparseCloudVolumeData
+{
+    uint32_t GridSize[3] = {};   // Bricks along each axis
+    float Origin[3] = {};        // World position of the volume's min corner
+    float VoxelSize = 1.0f;      // World units
+    float DensityScale = 1.0f;   // Density of a voxel value of 255
+
+    std::vector<uint32_t> Indirection; // One per grid cell, x fastest: an index into Bricks or SPARSE_EMPTY_BRICK
+    std::vector<SparseBrickCoord> Bricks;
+    std::vector<uint8_t> BrickVoxels;  // SPARSE_BRICK_VOXELS per brick, in the same order as Bricks
+
+    bool Init(const uint32_t gridSize[3], const float origin[3], float voxelSize, float densityScale);
+    uint32_t AddBrick(uint16_t x, uint16_t y, uint16_t z); // Returns the new brick's index, its voxels start zeroed
+
+    // Reorders bricks along a Morton curve, so bricks that are close in space are close on disk and share pages.
+    // Also rebuilds the indirection table and each brick's MaxValue, and drops bricks that ended up empty.
+    void Finalize();
+};
+
+// Quantizes a dense float grid (x fastest) into bricks, skipping bricks with no voxel above threshold.
+// Bricks are scanned and filled in parallel. The density scale is the grid's maximum.
+bool BuildSparseCloudVolume(const float* pDensity, const uint32_t dims[3], const float origin[3], float voxelSize, float threshold,
+    SparseCloudVolumeData& out_data);
+
+// Layout on disk, all little endian. The indirection table and brick coordinates follow the header,
+// and the brick data starts on a 4K boundary so bricks never straddle more pages than they have to.
+struct SparseCloudVolumeHeader
+{
+    uint32_t Magic = 0;
+    uint32_t Version = 0;
+    uint32_t BrickSize = 0;
+    uint32_t NumBricks = 0;
+    uint32_t GridSize[3] = {};
+    float Origin[3] = {};
+    float VoxelSize = 0.0f;
+    float DensityScale = 0.0f;
+    uint64_t SourceHash = 0;   // Whatever the file was converted from, so importers can tell when it's stale
+    uint64_t IndirectionOffset = 0;
+    uint64_t BrickCoordsOffset = 0;
+    uint64_t BrickDataOffset = 0;
+};
+
+bool SaveSparseCloudVolume(const SparseCloudVolumeData& data, const wchar_t* path, uint64_t sourceHash = 0);
+
+// Reads and validates only the header, for cache checks
+bool ReadSparseCloudVolumeHeader(const wchar_t* path, SparseCloudVolumeHeader& out_header);
+
+struct SparseVolumeResidencyStats
+{
+    uint32_t NumBricks = 0;        // Non-empty bricks in the file
+    uint32_t PoolCapacity = 0;
+    uint32_t NumResident = 0;
+    uint32_t NumPending = 0;       // Wanted but not resident yet, waiting on the per-update budget
+    uint64_t TotalStreamedIn = 0;
+    uint64_t TotalEvicted = 0;
+    size_t PoolBytes = 0;
+    size_t FileBytes = 0;          // Mapped, only touched pages are actually in memory
+    double LastUpdateMs = 0.0;
+};
+
+// A sparse volume mapped from disk. Only the bricks nearest the camera are copied into the pool, and the page table
+// maps each grid cell to its pool slot, which is what a GPU renderer would upload alongside the pool.
+class SparseCloudVolume
+{
+public:
+    static constexpr uint32_t INVALID_SLOT = UINT32_MAX;
+
+    bool Open(const wchar_t* path, uint32_t poolCapacity);
+    void Close();
+    bool IsOpen() const { return mFile.IsOpen(); }
+
+    // Ranks bricks by distance to the camera and streams in at most maxBricksPerUpdate of the nearest missing ones,
+    // evicting the farthest resident ones to make room. Ranking is skipped while the camera stays within half a brick.
+    void UpdateStreaming(const float cameraPos[3], uint32_t maxBricksPerUpdate);
+
+    // Trilinear density at a world position. Empty and non-resident bricks read as zero.
+    float SampleDensity(const float worldPos[3]) const;
+
+    const SparseCloudVolumeHeader& GetHeader() const { return mHeader; }
+    const std::vector<uint32_t>& GetPageTable() const { return mPageTable; }
+    const std::vector<uint8_t>& GetBrickPool() const { return mPool; }
+    bool IsBrickResident(uint32_t brick) const { return mBrickSlots[brick] != INVALID_SLOT; }
+    const SparseVolumeResidencyStats& GetResidencyStats() const { return mStats; }
+
+private:
+    float GetBrickDistanceSq(uint32_t brick, const float cameraPos[3]) const;
+    uint8_t LoadVoxel(int32_t x, int32_t y, int32_t z) const;
+
+    MappedFile mFile;
+    SparseCloudVolumeHeader mHeader;
+    const SparseBrickCoord* mpBricks = nullptr; // Points into the mapped file
+    const uint8_t* mpBrickData = nullptr;
+
+    std::vector<uint8_t> mPool;          // PoolCapacity bricks
+    std::vector<uint32_t> mPageTable;    // Grid cell -> pool slot
+    std::vector<uint32_t> mBrickSlots;   // Brick -> pool slot
+    std::vector<uint32_t> mSlotBricks;   // Pool slot -> brick
+    std::vector<uint32_t> mFreeSlots;
+
+    // Scratch kept between updates. mRanking stays nearly sorted from frame to frame.
+    std::vector<uint32_t> mRanking;
+    std::vector<float> mBrickDistances;
+    std::vector<uint8_t> mWanted;
+    std::vector<uint32_t> mMissing;
+
+    float mLastRankedPos[3] = {};
+    bool mHasRanking = false;
+
+    SparseVolumeResidencyStats mStats;
+};
+
+}
+
+#endif
@@ -0,0 +1,64 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Append-only storage for interned strings
+----------------------------------------------*/
+#include <Core/StringArena.h>
+
+#include <string.h>
+#include <utility>
+
+namespace Muon
+{
+
+const char* StringArena::Intern(std::string_view str)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    auto itFind = mStrings.find(str);
+    if (itFind != mStrings.end())
+        return itFind->data();
+
+    char* pCopy = AllocateChars(str.size() + 1);
+    memcpy(pCopy, str.data(), str.size());
+    pCopy[str.size()] = '\0';
+
+    mStrings.emplace(pCopy, str.size());
+    return pCopy;
+}
+
+void StringArena::Clear()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mStrings.clear();
+    mBlocks.clear();
+    mBlockOffset = kBlockSize;
+}
+
+char* StringArena::AllocateChars(size_t count)
+{
+    // Oversized strings get a block to themselves
+    if (count > kBlockSize)
+    {
+        mBlocks.emplace_back(new char[count]);
+        char* pBlock = mBlocks.back().get();
+
+        // Keep filling the previous block, it's still the one with free space
+        if (mBlocks.size() > 1)
+            std::swap(mBlocks[mBlocks.size() - 1], mBlocks[mBlocks.size() - 2]);
+
+        return pBlock;
+    }
+
+    if (mBlockOffset + count > kBlockSize)
+    {
+        mBlocks.emplace_back(new char[kBlockSize]);
+        mBlockOffset = 0;
+    }
+
+    char* pChars = mBlocks.back().get() + mBlockOffset;
+    mBlockOffset += count;
+    return pChars;
+}
+
+}
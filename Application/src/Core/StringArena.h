@@ -0,0 +1,41 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Append-only storage for interned strings
+----------------------------------------------*/
+#ifndef MUON_STRINGARENA_H
+#define MUON_STRINGARENA_H
+
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+namespace Muon
+{
+
+// Strings are copied into large blocks and never freed individually, so the returned pointers stay valid for the arena's lifetime.
+// Equal strings share one copy. Safe to call from multiple threads.
+class StringArena
+{
+public:
+    // Returns a null terminated copy of str owned by the arena
+    const char* Intern(std::string_view str);
+
+    void Clear();
+
+private:
+    static const size_t kBlockSize = 4096;
+
+    char* AllocateChars(size_t count);
+
+    std::mutex mMutex;
+    std::vector<std::unique_ptr<char[]>> mBlocks;
+    size_t mBlockOffset = kBlockSize;
+    std::unordered_set<std::string_view> mStrings; // Views into mBlocks
+};
+
+}
+
+#endif
@@ -0,0 +1,219 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Composes world matrices for many transforms at once from arrays of their components
+----------------------------------------------*/
+#include <Core/TransformBatch.h>
+
+#include <Core/JobSystem.h>
+
+#include <algorithm>
+#include <string.h>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define MUON_TRANSFORM_AVX 1
+#elif defined(_M_X64) || defined(__SSE2__)
+#include <xmmintrin.h>
+#define MUON_TRANSFORM_SSE 1
+#endif
+
+namespace Muon
+{
+
+namespace
+{
+    // Below this many transforms per job, handing work to other threads costs more than it saves
+    static const size_t kMinTransformsPerJob = 8192;
+
+#if MUON_TRANSFORM_AVX
+    static const size_t kGroupWidth = 8;
+    typedef __m256 Lanes;
+
+    Lanes Splat(float f) { return _mm256_set1_ps(f); }
+    Lanes Load(const float* p) { return _mm256_loadu_ps(p); }
+    Lanes Add(Lanes a, Lanes b) { return _mm256_add_ps(a, b); }
+    Lanes Sub(Lanes a, Lanes b) { return _mm256_sub_ps(a, b); }
+    Lanes Mul(Lanes a, Lanes b) { return _mm256_mul_ps(a, b); }
+
+    // Transposes within each 128 bit half: matrix l's four values land in a for l = 0 and 4, b for 1 and 5, and so on
+    void Store4x4(Lanes a, Lanes b, Lanes c, Lanes d, float* pOut, size_t matrixStride, size_t rowOffset)
+    {
+        const Lanes ab0 = _mm256_unpacklo_ps(a, b);
+        const Lanes ab1 = _mm256_unpackhi_ps(a, b);
+        const Lanes cd0 = _mm256_unpacklo_ps(c, d);
+        const Lanes cd1 = _mm256_unpackhi_ps(c, d);
+
+        const Lanes rows[4] =
+        {
+            _mm256_shuffle_ps(ab0, cd0, _MM_SHUFFLE(1, 0, 1, 0)),
+            _mm256_shuffle_ps(ab0, cd0, _MM_SHUFFLE(3, 2, 3, 2)),
+            _mm256_shuffle_ps(ab1, cd1, _MM_SHUFFLE(1, 0, 1, 0)),
+            _mm256_shuffle_ps(ab1, cd1, _MM_SHUFFLE(3, 2, 3, 2)),
+        };
+
+        for (size_t l = 0; l != 4; ++l)
+        {
+            _mm_storeu_ps(pOut + l * matrixStride + rowOffset, _mm256_castps256_ps128(rows[l]));
+            _mm_storeu_ps(pOut + (l + 4) * matrixStride + rowOffset, _mm256_extractf128_ps(rows[l], 1));
+        }
+    }
+#elif MUON_TRANSFORM_SSE
+    static const size_t kGroupWidth = 4;
+    typedef __m128 Lanes;
+
+    Lanes Splat(float f) { return _mm_set1_ps(f); }
+    Lanes Load(const float* p) { return _mm_loadu_ps(p); }
+    Lanes Add(Lanes a, Lanes b) { return _mm_add_ps(a, b); }
+    Lanes Sub(Lanes a, Lanes b) { return _mm_sub_ps(a, b); }
+    Lanes Mul(Lanes a, Lanes b) { return _mm_mul_ps(a, b); }
+
+    void Store4x4(Lanes a, Lanes b, Lanes c, Lanes d, float* pOut, size_t matrixStride, size_t rowOffset)
+    {
+        _MM_TRANSPOSE4_PS(a, b, c, d);
+        _mm_storeu_ps(pOut + rowOffset, a);
+        _mm_storeu_ps(pOut + matrixStride + rowOffset, b);
+        _mm_storeu_ps(pOut + 2 * matrixStride + rowOffset, c);
+        _mm_storeu_ps(pOut + 3 * matrixStride + rowOffset, d);
+    }
+#else
+    static const size_t kGroupWidth = 1;
+    typedef float Lanes;
+
+    Lanes Splat(float f) { return f; }
+    Lanes Load(const float* p) { return *p; }
+    Lanes Add(Lanes a, Lanes b) { return a + b; }
+    Lanes Sub(Lanes a, Lanes b) { return a - b; }
+    Lanes Mul(Lanes a, Lanes b) { return a * b; }
+
+    void Store4x4(Lanes a, Lanes b, Lanes c, Lanes d, float* pOut, size_t /*matrixStride*/, size_t rowOffset)
+    {
+        pOut[rowOffset] = a;
+        pOut[rowOffset + 1] = b;
+        pOut[rowOffset + 2] = c;
+        pOut[rowOffset + 3] = d;
+    }
+#endif
+
+    static_assert(TRANSFORM_SIMD_PADDING % kGroupWidth == 0, "Padding must cover a whole SIMD group");
+
+    size_t PaddedCount(size_t count)
+    {
+        return (count + TRANSFORM_SIMD_PADDING - 1) / TRANSFORM_SIMD_PADDING * TRANSFORM_SIMD_PADDING;
+    }
+
+    // Composes the kGroupWidth transforms starting at i into pOut, which holds kGroupWidth matrices.
+    // Same terms as XMMatrixRotationQuaternion, with each row scaled and the translation as the last row.
+    void ComposeGroup(const TransformsSoA& t, size_t i, float* pOut, MatrixLayout layout)
+    {
+        const Lanes one = Splat(1.0f);
+        const Lanes two = Splat(2.0f);
+        const Lanes zero = Splat(0.0f);
+
+        const Lanes qx = Load(&t.RotationX[i]);
+        const Lanes qy = Load(&t.RotationY[i]);
+        const Lanes qz = Load(&t.RotationZ[i]);
+        const Lanes qw = Load(&t.RotationW[i]);
+
+        const Lanes x2 = Mul(qx, two), y2 = Mul(qy, two), z2 = Mul(qz, two);
+        const Lanes xx = Mul(qx, x2), yy = Mul(qy, y2), zz = Mul(qz, z2);
+        const Lanes xy = Mul(qx, y2), xz = Mul(qx, z2), yz = Mul(qy, z2);
+        const Lanes wx = Mul(qw, x2), wy = Mul(qw, y2), wz = Mul(qw, z2);
+
+        const Lanes sx = Load(&t.ScaleX[i]);
+        const Lanes sy = Load(&t.ScaleY[i]);
+        const Lanes sz = Load(&t.ScaleZ[i]);
+
+        const Lanes m[4][4] =
+        {
+            { Mul(Sub(one, Add(yy, zz)), sx), Mul(Add(xy, wz), sx), Mul(Sub(xz, wy), sx), zero },
+            { Mul(Sub(xy, wz), sy), Mul(Sub(one, Add(xx, zz)), sy), Mul(Add(yz, wx), sy), zero },
+            { Mul(Add(xz, wy), sz), Mul(Sub(yz, wx), sz), Mul(Sub(one, Add(xx, yy)), sz), zero },
+            { Load(&t.PositionX[i]), Load(&t.PositionY[i]), Load(&t.PositionZ[i]), one },
+        };
+
+        if (layout == MatrixLayout::RowMajor)
+        {
+            for (size_t r = 0; r != 4; ++r)
+                Store4x4(m[r][0], m[r][1], m[r][2], m[r][3], pOut, 16, r * 4);
+        }
+        else
+        {
+            for (size_t c = 0; c != 4; ++c)
+                Store4x4(m[0][c], m[1][c], m[2][c], m[3][c], pOut, 16, c * 4);
+        }
+    }
+
+    // pOut receives the range's matrices from its start
+    void ComposeRange(const TransformsSoA& transforms, size_t begin, size_t end, DirectX::XMFLOAT4X4* pOut, MatrixLayout layout)
+    {
+        size_t i = begin;
+        for (; i + kGroupWidth <= end; i += kGroupWidth)
+            ComposeGroup(transforms, i, &pOut[i - begin].m[0][0], layout);
+
+        // The padding makes a full group safe to compute, but only the real matrices get copied out. A range starting off a
+        // group boundary can end too close to the padding for a group from i, so the last group is moved back to fit.
+        if (i != end)
+        {
+            const size_t groupStart = std::min(i, transforms.PositionX.size() - kGroupWidth);
+            DirectX::XMFLOAT4X4 tail[kGroupWidth];
+            ComposeGroup(transforms, groupStart, &tail[0].m[0][0], layout);
+            memcpy(&pOut[i - begin], &tail[i - groupStart], (end - i) * sizeof(DirectX::XMFLOAT4X4));
+        }
+    }
+}
+
+void TransformsSoA::Resize(size_t count)
+{
+    const size_t paddedCount = PaddedCount(count);
+    PositionX.resize(paddedCount, 0.0f);
+    PositionY.resize(paddedCount, 0.0f);
+    PositionZ.resize(paddedCount, 0.0f);
+    RotationX.resize(paddedCount, 0.0f);
+    RotationY.resize(paddedCount, 0.0f);
+    RotationZ.resize(paddedCount, 0.0f);
+    RotationW.resize(paddedCount, 1.0f);
+    ScaleX.resize(paddedCount, 1.0f);
+    ScaleY.resize(paddedCount, 1.0f);
+    ScaleZ.resize(paddedCount, 1.0f);
+    mCount = count;
+}
+
+void TransformsSoA::Set(size_t i, const float position[3], const float rotation[4], const float scale[3])
+{
+    PositionX[i] = position[0];
+    PositionY[i] = position[1];
+    PositionZ[i] = position[2];
+    RotationX[i] = rotation[0];
+    RotationY[i] = rotation[1];
+    RotationZ[i] = rotation[2];
+    RotationW[i] = rotation[3];
+    ScaleX[i] = scale[0];
+    ScaleY[i] = scale[1];
+    ScaleZ[i] = scale[2];
+}
+
+void ComposeTransforms(const TransformsSoA& transforms, DirectX::XMFLOAT4X4* pOut, MatrixLayout layout)
+{
+    const size_t count = transforms.GetCount();
+    if (count < 2 * kMinTransformsPerJob)
+    {
+        ComposeRange(transforms, 0, count, pOut, layout);
+        return;
+    }
+
+    // Jobs start on whole groups so none of them writes another's matrices through the tail copy
+    const size_t numThreads = JobSystem::GetSingleton().GetNumThreads();
+    const size_t grainSize = std::max(kMinTransformsPerJob, PaddedCount((count + numThreads - 1) / numThreads));
+    JobSystem::GetSingleton().ParallelFor(count, grainSize, [&](size_t begin, size_t end)
+    {
+        ComposeRange(transforms, begin, end, pOut + begin, layout);
+    });
+}
+
+void ComposeTransforms(const TransformsSoA& transforms, size_t begin, size_t end, DirectX::XMFLOAT4X4* pOut, MatrixLayout layout)
+{
+    ComposeRange(transforms, begin, end, pOut, layout);
+}
+
+}
@@ -0,0 +1,53 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Composes world matrices for many transforms at once from arrays of their components
+----------------------------------------------*/
+#ifndef MUON_TRANSFORMBATCH_H
+#define MUON_TRANSFORMBATCH_H
+
+#include <DirectXMath.h>
+#include <stddef.h>
+#include <vector>
+
+namespace Muon
+{
+
+// Component arrays are padded to this many entries so the last SIMD group never reads past the end
+static const size_t TRANSFORM_SIMD_PADDING = 8;
+
+// RowMajor is DirectXMath's layout, translation in the last row, and what the shaders take: their cbuffers use HLSL's default
+// column_major packing, which loads it as its transpose, and they multiply with mul(matrix, vector) to match.
+// ColumnMajor is the transpose, for row_major packed consumers or anything else that wants the translation in the last column.
+enum class MatrixLayout
+{
+    RowMajor,
+    ColumnMajor
+};
+
+// Position, rotation quaternion and scale of every transform, one array per component. Padding is the identity.
+struct TransformsSoA
+{
+    std::vector<float> PositionX, PositionY, PositionZ;
+    std::vector<float> RotationX, RotationY, RotationZ, RotationW;
+    std::vector<float> ScaleX, ScaleY, ScaleZ;
+
+    void Resize(size_t count);
+    void Set(size_t i, const float position[3], const float rotation[4], const float scale[3]);
+    size_t GetCount() const { return mCount; }
+
+private:
+    size_t mCount = 0;
+};
+
+// Writes scale * rotation * translation for every transform into pOut, which holds GetCount() matrices.
+// Matches XMMatrixAffineTransformation with a zero rotation origin, i.e. Transform::Recompute.
+// Groups of 8 (AVX) or 4 (SSE) are composed per pass, and large batches are split across the job system.
+void ComposeTransforms(const TransformsSoA& transforms, DirectX::XMFLOAT4X4* pOut, MatrixLayout layout = MatrixLayout::RowMajor);
+
+// Composes transforms [begin, end) into pOut[0, end - begin) on the calling thread, for callers that only need part of a batch
+void ComposeTransforms(const TransformsSoA& transforms, size_t begin, size_t end, DirectX::XMFLOAT4X4* pOut, MatrixLayout layout = MatrixLayout::RowMajor);
+
+}
+
+#endif
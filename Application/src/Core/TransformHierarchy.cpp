@@ -0,0 +1,315 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Parented transforms stored as arrays in depth order, recomputed only where they changed
+----------------------------------------------*/
+#include <Core/TransformHierarchy.h>
+
+#include <Core/JobSystem.h>
+
+#include <algorithm>
+#include <chrono>
+
+namespace Muon
+{
+
+namespace
+{
+    static const size_t kMinNodesPerJob = 4096;
+
+    // Local matrices are composed for runs of this many nodes that hold at least one dirty one. Short runs waste little
+    // on clean neighbours when only a few nodes move.
+    static const uint32_t kComposeRun = 16;
+
+    static const float kZero[3] = { 0.0f, 0.0f, 0.0f };
+    static const float kOne[3] = { 1.0f, 1.0f, 1.0f };
+    static const float kIdentityRotation[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+
+    static const DirectX::XMFLOAT4X4 kIdentity(
+        1.0f, 0.0f, 0.0f, 0.0f,
+        0.0f, 1.0f, 0.0f, 0.0f,
+        0.0f, 0.0f, 1.0f, 0.0f,
+        0.0f, 0.0f, 0.0f, 1.0f);
+
+    // Moves every element to its new index, dropping the ones mapped to TRANSFORM_INVALID and any padding past them
+    template <typename T>
+    void Reorder(std::vector<T>& v, const std::vector<uint32_t>& newIndex, size_t newCount)
+    {
+        std::vector<T> sorted(newCount);
+        for (size_t i = 0; i != newIndex.size(); ++i)
+        {
+            if (newIndex[i] != TRANSFORM_INVALID)
+                sorted[newIndex[i]] = v[i];
+        }
+        v.swap(sorted);
+    }
+
+    void Reorder(TransformsSoA& t, const std::vector<uint32_t>& newIndex, size_t newCount)
+    {
+        Reorder(t.PositionX, newIndex, newCount); Reorder(t.PositionY, newIndex, newCount); Reorder(t.PositionZ, newIndex, newCount);
+        Reorder(t.RotationX, newIndex, newCount); Reorder(t.RotationY, newIndex, newCount);
+        Reorder(t.RotationZ, newIndex, newCount); Reorder(t.RotationW, newIndex, newCount);
+        Reorder(t.ScaleX, newIndex, newCount); Reorder(t.ScaleY, newIndex, newCount); Reorder(t.ScaleZ, newIndex, newCount);
+        t.Resize(newCount); // Restores the padding
+    }
+}
+
+uint32_t TransformHierarchy::Create(uint32_t parent)
+{
+    const uint32_t index = static_cast<uint32_t>(mParent.size());
+
+    uint32_t handle;
+    if (!mFreeHandles.empty())
+    {
+        handle = mFreeHandles.back();
+        mFreeHandles.pop_back();
+        mHandleToIndex[handle] = index;
+    }
+    else
+    {
+        handle = static_cast<uint32_t>(mHandleToIndex.size());
+        mHandleToIndex.push_back(index);
+    }
+
+    const uint32_t parentIndex = parent != TRANSFORM_INVALID ? mHandleToIndex[parent] : TRANSFORM_INVALID;
+
+    mLocal.Resize(size_t(index) + 1);
+    mLocal.Set(index, kZero, kIdentityRotation, kOne);
+
+    // Appending keeps parents ahead of their children, so the order only needs fixing once depths stop ascending
+    const uint32_t depth = parentIndex != TRANSFORM_INVALID ? mDepth[parentIndex] + 1 : 0;
+    if (!mDepth.empty() && depth < mDepth.back())
+        mOrderStale = true;
+
+    mParent.push_back(parentIndex);
+    mDepth.push_back(depth);
+    mDirty.push_back(0);
+    mDestroyed.push_back(0);
+    mIndexToHandle.push_back(handle);
+    mWorld.push_back(kIdentity);
+
+    MarkDirty(index);
+    return handle;
+}
+
+void TransformHierarchy::Destroy(uint32_t handle)
+{
+    // Children are found when the order is rebuilt, since nothing here links downward
+    mDestroyed[mHandleToIndex[handle]] = 1;
+    mOrderStale = true;
+}
+
+void TransformHierarchy::Clear()
+{
+    mLocal = TransformsSoA();
+
+    mParent.clear();
+    mDepth.clear();
+    mDirty.clear();
+    mDestroyed.clear();
+    mIndexToHandle.clear();
+    mWorld.clear();
+
+    mHandleToIndex.clear();
+    mFreeHandles.clear();
+    mLevelStarts.clear();
+
+    mNumDirty = 0;
+    mOrderStale = false;
+    mStats = TransformStats();
+}
+
+void TransformHierarchy::SetLocalPosition(uint32_t handle, float x, float y, float z)
+{
+    const uint32_t index = mHandleToIndex[handle];
+    mLocal.PositionX[index] = x;
+    mLocal.PositionY[index] = y;
+    mLocal.PositionZ[index] = z;
+    MarkDirty(index);
+}
+
+void TransformHierarchy::SetLocalRotation(uint32_t handle, float x, float y, float z, float w)
+{
+    const uint32_t index = mHandleToIndex[handle];
+    mLocal.RotationX[index] = x;
+    mLocal.RotationY[index] = y;
+    mLocal.RotationZ[index] = z;
+    mLocal.RotationW[index] = w;
+    MarkDirty(index);
+}
+
+void TransformHierarchy::SetLocalScale(uint32_t handle, float x, float y, float z)
+{
+    const uint32_t index = mHandleToIndex[handle];
+    mLocal.ScaleX[index] = x;
+    mLocal.ScaleY[index] = y;
+    mLocal.ScaleZ[index] = z;
+    MarkDirty(index);
+}
+
+void TransformHierarchy::MarkDirty(uint32_t index)
+{
+    if (!mDirty[index])
+    {
+        mDirty[index] = 1;
+        ++mNumDirty;
+    }
+}
+
+// Stable counting sort by depth. Parents keep coming before their children, and siblings keep their relative order.
+void TransformHierarchy::RebuildOrder()
+{
+    const size_t count = mParent.size();
+
+    uint32_t maxDepth = 0;
+    for (size_t i = 0; i != count; ++i)
+    {
+        if (mParent[i] != TRANSFORM_INVALID && mDestroyed[mParent[i]])
+            mDestroyed[i] = 1;
+        if (!mDestroyed[i])
+            maxDepth = std::max(maxDepth, mDepth[i]);
+    }
+
+    std::vector<uint32_t> levelCounts(maxDepth + 2, 0);
+    for (size_t i = 0; i != count; ++i)
+    {
+        if (!mDestroyed[i])
+            ++levelCounts[mDepth[i] + 1];
+    }
+    for (uint32_t d = 1; d != levelCounts.size(); ++d)
+        levelCounts[d] += levelCounts[d - 1];
+
+    const size_t newCount = levelCounts.back();
+    mLevelStarts = levelCounts;
+
+    std::vector<uint32_t> newIndex(count, TRANSFORM_INVALID);
+    for (size_t i = 0; i != count; ++i)
+    {
+        if (mDestroyed[i])
+        {
+            mHandleToIndex[mIndexToHandle[i]] = TRANSFORM_INVALID;
+            mFreeHandles.push_back(mIndexToHandle[i]);
+            if (mDirty[i])
+                --mNumDirty;
+            continue;
+        }
+
+        newIndex[i] = levelCounts[mDepth[i]]++;
+    }
+
+    for (size_t i = 0; i != count; ++i)
+    {
+        if (mParent[i] != TRANSFORM_INVALID)
+            mParent[i] = newIndex[mParent[i]];
+    }
+
+    Reorder(mLocal, newIndex, newCount);
+    Reorder(mParent, newIndex, newCount);
+    Reorder(mDepth, newIndex, newCount);
+    Reorder(mDirty, newIndex, newCount);
+    Reorder(mIndexToHandle, newIndex, newCount);
+    Reorder(mWorld, newIndex, newCount);
+
+    mDestroyed.assign(newCount, 0);
+    for (uint32_t i = 0; i != newCount; ++i)
+        mHandleToIndex[mIndexToHandle[i]] = i;
+
+    mOrderStale = false;
+}
+
+// Every parent in the range's level is final by now, so a node only has to look one step up to know if it moved
+void TransformHierarchy::UpdateRange(uint32_t begin, uint32_t end)
+{
+    DirectX::XMFLOAT4X4 local[kComposeRun];
+    for (uint32_t runBegin = begin; runBegin < end; runBegin += kComposeRun)
+    {
+        const uint32_t runEnd = std::min(end, runBegin + kComposeRun);
+
+        bool anyDirty = false;
+        for (uint32_t i = runBegin; i != runEnd; ++i)
+        {
+            if (mParent[i] != TRANSFORM_INVALID)
+                mDirty[i] |= mDirty[mParent[i]];
+            anyDirty |= mDirty[i] != 0;
+        }
+
+        if (!anyDirty)
+            continue;
+
+        ComposeTransforms(mLocal, runBegin, runEnd, local);
+
+        for (uint32_t i = runBegin; i != runEnd; ++i)
+        {
+            if (!mDirty[i])
+                continue;
+
+            const DirectX::XMFLOAT4X4& l = local[i - runBegin];
+            DirectX::XMFLOAT4X4& world = mWorld[i];
+            if (mParent[i] == TRANSFORM_INVALID)
+            {
+                world = l;
+                continue;
+            }
+
+            const DirectX::XMFLOAT4X4& p = mWorld[mParent[i]];
+            for (uint32_t r = 0; r != 4; ++r)
+            {
+                for (uint32_t c = 0; c != 4; ++c)
+                    world.m[r][c] = l.m[r][0] * p.m[0][c] + l.m[r][1] * p.m[1][c] + l.m[r][2] * p.m[2][c] + l.m[r][3] * p.m[3][c];
+            }
+        }
+    }
+}
+
+void TransformHierarchy::Update()
+{
+    using Clock = std::chrono::high_resolution_clock;
+    const Clock::time_point updateStart = Clock::now();
+
+    if (mOrderStale)
+        RebuildOrder();
+    else if (mLevelStarts.empty() || mLevelStarts.back() != mParent.size())
+    {
+        // Only appends since the last sort, which are already in depth order. Extend the level table to cover them.
+        mLevelStarts.assign(1, 0);
+        for (uint32_t i = 0; i != mDepth.size(); ++i)
+        {
+            while (mLevelStarts.size() <= mDepth[i] + 1)
+                mLevelStarts.push_back(i);
+        }
+        mLevelStarts.push_back(static_cast<uint32_t>(mDepth.size()));
+    }
+
+    const uint32_t numLevels = static_cast<uint32_t>(mLevelStarts.size()) - 1;
+    uint32_t numUpdated = 0;
+
+    if (mNumDirty != 0)
+    {
+        JobSystem& jobSystem = JobSystem::GetSingleton();
+        for (uint32_t level = 0; level != numLevels; ++level)
+        {
+            const uint32_t levelBegin = mLevelStarts[level];
+            const uint32_t levelCount = mLevelStarts[level + 1] - levelBegin;
+            const size_t grainSize = std::max<size_t>(kMinNodesPerJob, (levelCount + jobSystem.GetNumThreads() - 1) / jobSystem.GetNumThreads());
+
+            jobSystem.ParallelFor(levelCount, grainSize, [&](size_t begin, size_t end)
+            {
+                UpdateRange(levelBegin + static_cast<uint32_t>(begin), levelBegin + static_cast<uint32_t>(end));
+            });
+        }
+
+        for (size_t i = 0; i != mDirty.size(); ++i)
+        {
+            numUpdated += mDirty[i];
+            mDirty[i] = 0;
+        }
+        mNumDirty = 0;
+    }
+
+    mStats.NumNodes = static_cast<uint32_t>(mParent.size());
+    mStats.NumLevels = numLevels;
+    mStats.NumUpdated = numUpdated;
+    mStats.UpdateMs = std::chrono::duration<double, std::milli>(Clock::now() - updateStart).count();
+}
+
+}
@@ -0,0 +1,89 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Parented transforms stored as arrays in depth order, recomputed only where they changed
+----------------------------------------------*/
+#ifndef MUON_TRANSFORMHIERARCHY_H
+#define MUON_TRANSFORMHIERARCHY_H
+
+#include <Core/TransformBatch.h>
+
+#include <DirectXMath.h>
+#include <stdint.h>
+#include <vector>
+
+namespace Muon
+{
+
+static const uint32_t TRANSFORM_INVALID = 0xFFFFFFFF;
+
+struct TransformStats
+{
+    uint32_t NumNodes = 0;
+    uint32_t NumLevels = 0;
+    uint32_t NumUpdated = 0; // World matrices recomputed by the last Update
+    double UpdateMs = 0.0;
+};
+
+// Nodes are addressed through stable handles, while their data lives in parallel arrays sorted by depth, so every
+// parent comes before its children and each level is a contiguous range. Update walks the levels in order, marking
+// a node dirty when it or its parent changed, and only recomputes the dirty ones: world = scale * rotation * translation
+// * parent world, in DirectXMath's row vector convention. Local matrices come from ComposeTransforms, a small run of
+// nodes at a time, and large levels are split across the job system.
+//
+// Creating and destroying nodes only flags the order as stale; the arrays are re-sorted at the next Update.
+class TransformHierarchy
+{
+public:
+    // The parent must already exist. New nodes start at the identity.
+    uint32_t Create(uint32_t parent = TRANSFORM_INVALID);
+
+    // Destroys the node and everything below it. Their handles are invalid from here on.
+    void Destroy(uint32_t handle);
+
+    void Clear();
+
+    void SetLocalPosition(uint32_t handle, float x, float y, float z);
+    void SetLocalRotation(uint32_t handle, float x, float y, float z, float w); // Unit quaternion
+    void SetLocalScale(uint32_t handle, float x, float y, float z);
+
+    void Update();
+
+    // Valid after the Update following the node's last change
+    const DirectX::XMFLOAT4X4& GetWorld(uint32_t handle) const { return mWorld[mHandleToIndex[handle]]; }
+
+    // Every world matrix in depth order, ready to copy into an upload. Indices change when the order is rebuilt,
+    // i.e. on the first Update after a Create or Destroy, and pointers into the array may too.
+    const std::vector<DirectX::XMFLOAT4X4>& GetWorldMatrices() const { return mWorld; }
+    uint32_t GetWorldIndex(uint32_t handle) const { return mHandleToIndex[handle]; }
+
+    uint32_t GetCount() const { return static_cast<uint32_t>(mParent.size()); }
+    const TransformStats& GetStats() const { return mStats; }
+
+private:
+    void MarkDirty(uint32_t index);
+    void RebuildOrder();
+    void UpdateRange(uint32_t begin, uint32_t end);
+
+    TransformsSoA mLocal;
+
+    std::vector<uint32_t> mParent; // Index, always lower than the child's
+    std::vector<uint32_t> mDepth;
+    std::vector<uint8_t> mDirty;
+    std::vector<uint8_t> mDestroyed;
+    std::vector<uint32_t> mIndexToHandle;
+    std::vector<DirectX::XMFLOAT4X4> mWorld;
+
+    std::vector<uint32_t> mHandleToIndex;
+    std::vector<uint32_t> mFreeHandles;
+    std::vector<uint32_t> mLevelStarts; // Where each depth begins, plus the end
+
+    uint32_t mNumDirty = 0;
+    bool mOrderStale = false;
+
+    TransformStats mStats;
+};
+
+}
+
+#endif
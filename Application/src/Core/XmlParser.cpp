@@ -0,0 +1,254 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Small, allocation-light XML parser for asset manifests
+----------------------------------------------*/
+#include <Core/XmlParser.h>
+
+namespace Muon
+{
+
+static bool IsXmlSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static bool IsNameChar(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+        c == '_' || c == '-' || c == ':' || c == '.';
+}
+
+static std::string_view TrimView(std::string_view view)
+{
+    while (!view.empty() && IsXmlSpace(view.front()))
+        view.remove_prefix(1);
+    while (!view.empty() && IsXmlSpace(view.back()))
+        view.remove_suffix(1);
+    return view;
+}
+
+bool XmlDocument::Parse(std::string_view text)
+{
+    mText = text;
+    mPos = 0;
+    mNodes.clear();
+    mAttributes.clear();
+    mFirstRoot = INVALID_NODE;
+    mError.clear();
+
+    // Rough guess to avoid most regrowth: manifests average well over 32 characters per element
+    mNodes.reserve(text.size() / 32);
+
+    uint32_t prevRoot = INVALID_NODE;
+    while (true)
+    {
+        if (!SkipMisc())
+            return false;
+
+        if (mPos >= mText.size())
+            break;
+
+        uint32_t rootIndex;
+        if (!ParseElement(rootIndex))
+            return false;
+
+        if (prevRoot == INVALID_NODE)
+            mFirstRoot = rootIndex;
+        else
+            mNodes[prevRoot].NextSibling = rootIndex;
+        prevRoot = rootIndex;
+    }
+
+    return true;
+}
+
+std::string_view XmlDocument::GetAttribute(uint32_t nodeIndex, std::string_view name) const
+{
+    const XmlNode& node = mNodes[nodeIndex];
+    for (uint32_t i = 0; i != node.NumAttributes; ++i)
+    {
+        const XmlAttribute& attr = mAttributes[node.FirstAttribute + i];
+        if (attr.Name == name)
+            return attr.Value;
+    }
+
+    return std::string_view();
+}
+
+uint32_t XmlDocument::FindChild(uint32_t nodeIndex, std::string_view name) const
+{
+    for (uint32_t child = mNodes[nodeIndex].FirstChild; child != INVALID_NODE; child = mNodes[child].NextSibling)
+    {
+        if (mNodes[child].Name == name)
+            return child;
+    }
+
+    return INVALID_NODE;
+}
+
+void XmlDocument::SkipWhitespace()
+{
+    while (mPos < mText.size() && IsXmlSpace(mText[mPos]))
+        mPos++;
+}
+
+// Skips whitespace, comments and processing instructions (e.g. the <?xml ... ?> prolog)
+bool XmlDocument::SkipMisc()
+{
+    while (true)
+    {
+        SkipWhitespace();
+
+        if (mText.compare(mPos, 4, "<!--") == 0)
+        {
+            size_t end = mText.find("-->", mPos + 4);
+            if (end == std::string_view::npos)
+                return Fail("Unterminated comment");
+            mPos = end + 3;
+        }
+        else if (mText.compare(mPos, 2, "<?") == 0)
+        {
+            size_t end = mText.find("?>", mPos + 2);
+            if (end == std::string_view::npos)
+                return Fail("Unterminated processing instruction");
+            mPos = end + 2;
+        }
+        else
+        {
+            return true;
+        }
+    }
+}
+
+bool XmlDocument::ParseElement(uint32_t& out_index)
+{
+    if (mPos >= mText.size() || mText[mPos] != '<')
+        return Fail("Expected '<'");
+    mPos++;
+
+    size_t nameStart = mPos;
+    while (mPos < mText.size() && IsNameChar(mText[mPos]))
+        mPos++;
+
+    if (mPos == nameStart)
+        return Fail("Expected element name");
+
+    out_index = static_cast<uint32_t>(mNodes.size());
+    mNodes.emplace_back();
+    mNodes[out_index].Name = mText.substr(nameStart, mPos - nameStart);
+    mNodes[out_index].FirstAttribute = static_cast<uint32_t>(mAttributes.size());
+
+    // Attributes
+    while (true)
+    {
+        SkipWhitespace();
+        if (mPos >= mText.size())
+            return Fail("Unexpected end of file inside tag");
+
+        const char c = mText[mPos];
+        if (c == '/')
+        {
+            if (mText.compare(mPos, 2, "/>") != 0)
+                return Fail("Expected '/>'");
+            mPos += 2;
+            return true;
+        }
+        if (c == '>')
+        {
+            mPos++;
+            break;
+        }
+
+        size_t attrNameStart = mPos;
+        while (mPos < mText.size() && IsNameChar(mText[mPos]))
+            mPos++;
+        if (mPos == attrNameStart)
+            return Fail("Expected attribute name");
+
+        XmlAttribute attr;
+        attr.Name = mText.substr(attrNameStart, mPos - attrNameStart);
+
+        SkipWhitespace();
+        if (mPos >= mText.size() || mText[mPos] != '=')
+            return Fail("Expected '=' after attribute name");
+        mPos++;
+        SkipWhitespace();
+
+        if (mPos >= mText.size() || (mText[mPos] != '"' && mText[mPos] != '\''))
+            return Fail("Expected quoted attribute value");
+
+        const char quote = mText[mPos++];
+        size_t valueEnd = mText.find(quote, mPos);
+        if (valueEnd == std::string_view::npos)
+            return Fail("Unterminated attribute value");
+
+        attr.Value = mText.substr(mPos, valueEnd - mPos);
+        mPos = valueEnd + 1;
+
+        mAttributes.push_back(attr);
+        mNodes[out_index].NumAttributes++;
+    }
+
+    // Content: text and child elements until the matching end tag
+    uint32_t prevChild = INVALID_NODE;
+    size_t textStart = mPos;
+    while (true)
+    {
+        size_t tagStart = mText.find('<', mPos);
+        if (tagStart == std::string_view::npos)
+            return Fail("Missing end tag");
+
+        // Only the text before the first child is kept, which is all the manifests need
+        if (prevChild == INVALID_NODE && mNodes[out_index].Text.empty())
+            mNodes[out_index].Text = TrimView(mText.substr(textStart, tagStart - textStart));
+
+        mPos = tagStart;
+        if (mText.compare(mPos, 2, "</") == 0)
+        {
+            mPos += 2;
+            const std::string_view& name = mNodes[out_index].Name;
+            if (mText.compare(mPos, name.size(), name) != 0)
+                return Fail("Mismatched end tag");
+
+            mPos += name.size();
+            SkipWhitespace();
+            if (mPos >= mText.size() || mText[mPos] != '>')
+                return Fail("Expected '>' to close end tag");
+            mPos++;
+            return true;
+        }
+
+        if (mText.compare(mPos, 4, "<!--") == 0 || mText.compare(mPos, 2, "<?") == 0)
+        {
+            if (!SkipMisc())
+                return false;
+            continue;
+        }
+
+        uint32_t childIndex;
+        if (!ParseElement(childIndex))
+            return false;
+
+        if (prevChild == INVALID_NODE)
+            mNodes[out_index].FirstChild = childIndex;
+        else
+            mNodes[prevChild].NextSibling = childIndex;
+        prevChild = childIndex;
+    }
+}
+
+bool XmlDocument::Fail(const char* message)
+{
+    size_t line = 1;
+    for (size_t i = 0; i < mPos && i < mText.size(); ++i)
+    {
+        if (mText[i] == '\n')
+            line++;
+    }
+
+    mError = std::string(message) + " (line " + std::to_string(line) + ")";
+    return false;
+}
+
+}
@@ -0,0 +1,70 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Small, allocation-light XML parser for asset manifests
+----------------------------------------------*/
+#ifndef MUON_XMLPARSER_H
+#define MUON_XMLPARSER_H
+
+#include <stdint.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Muon
+{
+
+// Only supports the subset of XML our manifests use: elements, attributes, text, comments and the prolog.
+// All names/values are views into the source text, so the document must outlive anything read out of it.
+struct XmlAttribute
+{
+    std::string_view Name;
+    std::string_view Value;
+};
+
+struct XmlNode
+{
+    std::string_view Name;
+    std::string_view Text;
+    uint32_t FirstAttribute = 0;
+    uint32_t NumAttributes = 0;
+    uint32_t FirstChild = UINT32_MAX;
+    uint32_t NextSibling = UINT32_MAX;
+};
+
+class XmlDocument
+{
+public:
+    static const uint32_t INVALID_NODE = UINT32_MAX;
+
+    // Parses the given text. On failure, GetError() describes what went wrong and where.
+    bool Parse(std::string_view text);
+
+    // Top-level elements. A manifest file may contain more than one.
+    uint32_t GetFirstRoot() const { return mFirstRoot; }
+
+    const XmlNode& GetNode(uint32_t index) const { return mNodes[index]; }
+    std::string_view GetAttribute(uint32_t nodeIndex, std::string_view name) const;
+    uint32_t FindChild(uint32_t nodeIndex, std::string_view name) const;
+
+    const std::string& GetError() const { return mError; }
+
+private:
+    bool ParseElement(uint32_t& out_index);
+    bool SkipMisc();
+    void SkipWhitespace();
+    bool Fail(const char* message);
+
+    std::string_view mText;
+    size_t mPos = 0;
+
+    std::vector<XmlNode> mNodes;
+    std::vector<XmlAttribute> mAttributes;
+    uint32_t mFirstRoot = INVALID_NODE;
+
+    std::string mError;
+};
+
+}
+
+#endif
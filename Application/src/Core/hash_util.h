@@ -6,23 +6,42 @@ Description : Material class for shader information
 #ifndef EASEL_HASH_UTIL_H
 #define EASEL_HASH_UTIL_H
 
+#include <stddef.h>
 #include <stdint.h>
 
-// Helper function for hashing c strings
-inline uint32_t fnv1a(const char* text, uint32_t hash = 0x811C9DC5, uint32_t prime = 0x01000193)
+// Helper function for hashing c strings. constexpr so string literals can be hashed at compile time.
+constexpr uint32_t fnv1a(const char* text, uint32_t hash = 0x811C9DC5, uint32_t prime = 0x01000193)
 {
-    const unsigned char* ptr = (const unsigned char*)text;
-    while (*ptr)
-        hash = (*ptr++ ^ hash) * prime;
+    while (*text)
+        hash = (static_cast<unsigned char>(*text++) ^ hash) * prime;
 
     return hash;
 }
 
-inline uint32_t fnv1a(const wchar_t* text, uint32_t hash = 0x811C9DC5, uint32_t prime = 0x01000193)
+constexpr uint32_t fnv1a(const wchar_t* text, uint32_t hash = 0x811C9DC5, uint32_t prime = 0x01000193)
 {
-    const wchar_t* ptr = (const wchar_t*)text;
-    while (*ptr)
-        hash = (*ptr++ ^ hash) * prime;
+    while (*text)
+        hash = (static_cast<uint32_t>(*text++) ^ hash) * prime;
+
+    return hash;
+}
+
+// Helper function for hashing raw memory, e.g. POD descriptions
+inline uint32_t fnv1a_bytes(const void* data, size_t size, uint32_t hash = 0x811C9DC5, uint32_t prime = 0x01000193)
+{
+    const unsigned char* ptr = (const unsigned char*)data;
+    for (size_t i = 0; i != size; ++i)
+        hash = (ptr[i] ^ hash) * prime;
+
+    return hash;
+}
+
+// 64-bit variant for keying larger blobs (e.g. shader bytecode) where 32 bits would collide too easily
+inline uint64_t fnv1a64_bytes(const void* data, size_t size, uint64_t hash = 0xCBF29CE484222325ull, uint64_t prime = 0x00000100000001B3ull)
+{
+    const unsigned char* ptr = (const unsigned char*)data;
+    for (size_t i = 0; i != size; ++i)
+        hash = (ptr[i] ^ hash) * prime;
 
     return hash;
 }
@@ -0,0 +1,78 @@
+/*----------------------------------------------
+Generated by ShaderBuild from the compiled shaders' reflection data. Do not edit by hand,
+rebuild the Shaders project instead.
+Description : C++ mirrors of the HLSL constant buffers
+----------------------------------------------*/
+#ifndef MUON_SHADERCBUFFERS_H
+#define MUON_SHADERCBUFFERS_H
+
+#include <DirectXMath.h>
+#include <cstddef>
+#include <stdint.h>
+
+namespace Muon
+{
+
+struct alignas(16) DirectionalLight
+{
+    DirectX::XMFLOAT3 diffuseColor = {};
+    uint32_t _pad0 = 0;
+    DirectX::XMFLOAT3 toLight = {};
+    uint32_t _pad1 = 0;
+};
+static_assert(offsetof(DirectionalLight, diffuseColor) == 0, "DirectionalLight::diffuseColor doesn't match the HLSL layout");
+static_assert(offsetof(DirectionalLight, toLight) == 16, "DirectionalLight::toLight doesn't match the HLSL layout");
+static_assert(sizeof(DirectionalLight) == 32, "DirectionalLight doesn't match the HLSL layout");
+
+struct alignas(16) cbPSLights
+{
+    static constexpr const char* kName = "PSLights";
+
+    DirectX::XMFLOAT3 ambientColor = {};
+    uint32_t _pad0 = 0;
+    DirectionalLight directionalLight = {};
+    DirectX::XMFLOAT3 cameraWorldPos = {};
+    uint32_t _pad1 = 0;
+};
+static_assert(offsetof(cbPSLights, ambientColor) == 0, "cbPSLights::ambientColor doesn't match the HLSL layout");
+static_assert(offsetof(cbPSLights, directionalLight) == 16, "cbPSLights::directionalLight doesn't match the HLSL layout");
+static_assert(offsetof(cbPSLights, cameraWorldPos) == 48, "cbPSLights::cameraWorldPos doesn't match the HLSL layout");
+static_assert(sizeof(cbPSLights) == 64, "cbPSLights doesn't match the HLSL layout");
+
+struct alignas(16) cbPSPerMaterial
+{
+    static constexpr const char* kName = "PSPerMaterial";
+
+    DirectX::XMFLOAT4 colorTint = {};
+    float specularity = {};
+    uint32_t _pad0[3] = {};
+};
+static_assert(offsetof(cbPSPerMaterial, colorTint) == 0, "cbPSPerMaterial::colorTint doesn't match the HLSL layout");
+static_assert(offsetof(cbPSPerMaterial, specularity) == 16, "cbPSPerMaterial::specularity doesn't match the HLSL layout");
+static_assert(sizeof(cbPSPerMaterial) == 32, "cbPSPerMaterial doesn't match the HLSL layout");
+
+struct alignas(16) cbVSCamera
+{
+    static constexpr const char* kName = "VSCamera";
+
+    DirectX::XMFLOAT4X4 view = {};
+    DirectX::XMFLOAT4X4 proj = {};
+    DirectX::XMFLOAT4X4 viewProj = {};
+};
+static_assert(offsetof(cbVSCamera, view) == 0, "cbVSCamera::view doesn't match the HLSL layout");
+static_assert(offsetof(cbVSCamera, proj) == 64, "cbVSCamera::proj doesn't match the HLSL layout");
+static_assert(offsetof(cbVSCamera, viewProj) == 128, "cbVSCamera::viewProj doesn't match the HLSL layout");
+static_assert(sizeof(cbVSCamera) == 192, "cbVSCamera doesn't match the HLSL layout");
+
+struct alignas(16) cbVSWorld
+{
+    static constexpr const char* kName = "VSWorld";
+
+    DirectX::XMFLOAT4X4 world = {};
+};
+static_assert(offsetof(cbVSWorld, world) == 0, "cbVSWorld::world doesn't match the HLSL layout");
+static_assert(sizeof(cbVSWorld) == 64, "cbVSWorld doesn't match the HLSL layout");
+
+}
+
+#endif
@@ -4,10 +4,17 @@ Date : 2019/11
 Description : Implementation of GameInput method overrides
 ----------------------------------------------*/
 #include <Core/WinApp.h>
+#include <Core/CloudRaymarcher.h>
+#include <Core/PathMacros.h>
+#include <Core/Profiler.h>
+#include <Core/ResourceCodex.h>
+#include <Utils/Utils.h>
 
 #include "InputSystem.h"
 #include "GameInput.h"
 
+#include <algorithm>
+
 namespace Input {
 
     GameInput::GameInput()
@@ -35,6 +42,28 @@ namespace Input {
             case GameCommands::Quit:
                 PostQuitMessage(0);
                 break;
+            case GameCommands::DumpProfile:
+            {
+                const Muon::Profiler& profiler = Muon::Profiler::GetSingleton();
+                profiler.PrintSummary();
+                Muon::ResourceCodex::GetSingleton().PrintCloudVolumeStats();
+                if (profiler.WriteChromeTrace(PROFILEPATHW L"frame_trace.json"))
+                    Muon::Print("Info: Wrote the CPU trace to " PROFILEPATH "frame_trace.json, open it in chrome://tracing\n");
+                break;
+            }
+            case GameCommands::CaptureClouds:
+            {
+                const Muon::cbCamera& constants = pCamera->GetConstants();
+                XMFLOAT4X4 invViewProj;
+                XMStoreFloat4x4(&invViewProj, XMMatrixInverse(nullptr, XMLoadFloat4x4(&constants.viewProj)));
+
+                // _11 / _22 of a projection is height / width
+                const uint32_t width = 640;
+                const uint32_t height = std::max<uint32_t>(static_cast<uint32_t>(width * constants.proj._11 / constants.proj._22 + 0.5f), 1);
+                if (Muon::CaptureCloudReference(&invViewProj.m[0][0], width, height, CAPTUREPATHW L"clouds_reference"))
+                    Muon::Print("Info: Wrote the cloud reference to " CAPTUREPATH "clouds_reference.png/.exr\n");
+                break;
+            }
             case GameCommands::MoveForward:
                 pCamera->MoveForward(kSpeed * dt);
                 break;
@@ -116,5 +145,7 @@ namespace Input {
 
         mKeyMap[GameCommands::MouseRotation] = new Chord(L"Mouse Rotation", VK_LBUTTON, KeyState::StillPressed);
         mKeyMap[GameCommands::MouseMovement] = new Chord(L"Mouse Movement", VK_RBUTTON, KeyState::StillPressed);
+        mKeyMap[GameCommands::DumpProfile]   = new Chord(L"Dump Profile", VK_F9, KeyState::JustReleased);
+        mKeyMap[GameCommands::CaptureClouds] = new Chord(L"Capture Cloud Reference", VK_F10, KeyState::JustReleased);
     }
 }
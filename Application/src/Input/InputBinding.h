@@ -30,7 +30,9 @@ namespace Input {
         RollLeft,
         RollRight,
         MouseRotation,
-        MouseMovement
+        MouseMovement,
+        DumpProfile,
+        CaptureClouds
     };
 
     // Enum to emphasize the different states of a key
@@ -5,18 +5,56 @@ Description : Utility functions
 ----------------------------------------------*/
 
 #include <Utils/Utils.h>
+#include <stdarg.h>
 #include <stdio.h>
+#include <wchar.h>
 
 namespace Muon
 {
+#if !defined(_WIN32)
+	namespace
+	{
+		// Wide format strings are written for MSVC, where %s is a wide string and %S a narrow one. Elsewhere it's the other way around.
+		void SwapStringConversions(const wchar_t* format, wchar_t* out_format, size_t size)
+		{
+			size_t i = 0;
+			bool inConversion = false;
+			for (; format[i] && i + 1 < size; ++i)
+			{
+				wchar_t c = format[i];
+				if (!inConversion)
+					inConversion = c == L'%';
+				else if (c == L's' || c == L'S')
+				{
+					c = c == L's' ? L'S' : L's';
+					inConversion = false;
+				}
+				else if (!wcschr(L"-+ #0123456789.*", c))
+					inConversion = false; // Any other conversion, a length modifier, or %%
+
+				out_format[i] = c;
+			}
+			out_format[i] = L'\0';
+		}
+	}
+#endif
+
 	void Print(const char* str)
 	{
+#if defined(_WIN32)
 		OutputDebugStringA(str);
+#else
+		fputs(str, stdout);
+#endif
 	}
 
 	void Print(const wchar_t* str)
 	{
+#if defined(_WIN32)
 		OutputDebugString(str);
+#else
+		printf("%ls", str);
+#endif
 	}
 
 	void Printf(const char* format, ...)
@@ -24,7 +62,7 @@ namespace Muon
 		char buffer[256];
 		va_list ap;
 		va_start(ap, format);
-		vsprintf_s(buffer, 256, format, ap);
+		vsnprintf(buffer, 256, format, ap);
 		va_end(ap);
 		Print(buffer);
 	}
@@ -34,7 +72,13 @@ namespace Muon
 		wchar_t buffer[256];
 		va_list ap;
 		va_start(ap, format);
+#if defined(_WIN32)
 		vswprintf(buffer, 256, format, ap);
+#else
+		wchar_t portableFormat[256];
+		SwapStringConversions(format, portableFormat, 256);
+		vswprintf(buffer, 256, portableFormat, ap);
+#endif
 		va_end(ap);
 		Print(buffer);
 	}
@@ -1,3 +1,4 @@
+// permutations: NORMAL_MAP
 #include "PhongCommon.hlsli"
 
 struct VertexOut
@@ -25,16 +26,27 @@ cbuffer PSPerMaterial : register(b11)
 }
 
 Texture2D diffuseTexture    : register(t0);
+#if NORMAL_MAP
+Texture2D normalMap         : register(t1);
+#endif
 SamplerState samplerOptions : register(s0);
 float4 main(VertexOut input) : SV_TARGET
 {
-    float3 normalRGB = input.normal.xyz * 0.5 + 0.5;
-
     // Sample diffuse texture, normal map(unpacked)
     float3 surfaceColor = diffuseTexture.Sample(samplerOptions, input.uv).rgb;
     
     // Normalize normal vector
     input.normal = normalize(input.normal);
+
+#if NORMAL_MAP
+    float3 sampledNormal = normalMap.Sample(samplerOptions, input.uv).rgb * 2 - 1;
+    input.tangent = normalize(input.tangent - dot(input.tangent, input.normal) * input.normal);
+    input.binormal = normalize(input.binormal);
+
+    // create transformation matrix TBN
+    float3x3 TBN = float3x3(input.tangent, input.binormal, input.normal);
+    input.normal = mul(sampledNormal, TBN);
+#endif
     
     // Holds the total light for this pixel
     float3 totalLight = 0;
@@ -1,3 +1,4 @@
+// permutations: INSTANCED
 #include "VS_Common.hlsli"
 
 struct VertexIn
@@ -7,6 +8,10 @@ struct VertexIn
     float2 uv       : TEXCOORD;
     float3 tangent  : TANGENT;
     float3 binormal : BINORMAL;
+
+#if INSTANCED
+    float4x4 world  : INSTANCE_WORLDMATRIX;
+#endif
 };
 
 struct VertexOut
@@ -24,6 +29,11 @@ VertexOut main( VertexIn vi)
 {
     VertexOut vo;
 
+#if INSTANCED
+    // Instances carry their own world matrix instead of using VSWorld
+    float4x4 world = vi.world;
+#endif
+
     // Construct camera matrix
     matrix wvp = mul(viewProj, world);
 
@@ -3,12 +3,36 @@ Ruben Young (rubenaryo@gmail.com)
 Date : 2025/3
 Description : Test Vertex Shader
 ----------------------------------------------*/
+// permutations: INSTANCED
+#if INSTANCED
+#include "VS_Common.hlsli"
+#endif
+
 struct PSInput
 {
     float4 position : SV_POSITION;
     float4 color : COLOR;
 };
 
+#if INSTANCED
+struct VertexIn
+{
+    float3 position : POSITION;
+
+    float4x4 world : INSTANCE_WORLDMATRIX;
+};
+
+PSInput main(VertexIn vi)
+{
+    PSInput result;
+
+    float4x4 wvp = mul(viewProj, vi.world);
+    result.position = mul(wvp, float4(vi.position, 1.0f));
+    result.color = float4(1, 1, 1, 1);
+
+    return result;
+}
+#else
 PSInput main(float4 position : POSITION, float4 color : COLOR)
 {
     PSInput result;
@@ -17,4 +41,5 @@ PSInput main(float4 position : POSITION, float4 color : COLOR)
     result.color = color;
 
     return result;
-}
\ No newline at end of file
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,357 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Randomized tests against brute force and query/refit benchmarks for the dynamic BVH
+----------------------------------------------*/
+#include "TestFramework.h"
+
+#include <Core/BVH.h>
+#include <Core/Culling.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <math.h>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace
+{
+using namespace Muon;
+
+// Objects scattered over [-100, 100]^3
+struct RandomBoxes
+{
+    std::mt19937 Rng;
+    std::uniform_real_distribution<float> Position{ -100.0f, 100.0f };
+    std::uniform_real_distribution<float> Extent{ 0.1f, 5.0f };
+
+    explicit RandomBoxes(uint32_t seed) : Rng(seed) {}
+
+    BVHBounds Next()
+    {
+        BVHBounds bounds;
+        for (uint32_t k = 0; k != 3; ++k)
+        {
+            const float center = Position(Rng), extent = Extent(Rng);
+            bounds.Min[k] = center - extent;
+            bounds.Max[k] = center + extent;
+        }
+        return bounds;
+    }
+};
+
+// The axis aligned box [-halfSize, halfSize]^3, as six inward facing planes
+void MakeBoxFrustum(float halfSize, Frustum& out_frustum)
+{
+    const float normals[Frustum::COUNT][3] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+    for (uint32_t p = 0; p != Frustum::COUNT; ++p)
+    {
+        out_frustum.NormalX[p] = normals[p][0];
+        out_frustum.NormalY[p] = normals[p][1];
+        out_frustum.NormalZ[p] = normals[p][2];
+        out_frustum.D[p] = halfSize;
+    }
+}
+
+bool TouchesSphere(const BVHBounds& b, const float center[3], float radius)
+{
+    float distSq = 0.0f;
+    for (uint32_t k = 0; k != 3; ++k)
+    {
+        const float d = std::max(b.Min[k], std::min(center[k], b.Max[k])) - center[k];
+        distSq += d * d;
+    }
+    return distSq <= radius * radius;
+}
+
+bool TouchesFrustum(const BVHBounds& b, const Frustum& f)
+{
+    for (uint32_t p = 0; p != Frustum::COUNT; ++p)
+    {
+        const float c[3] = { (b.Min[0] + b.Max[0]) * 0.5f, (b.Min[1] + b.Max[1]) * 0.5f, (b.Min[2] + b.Max[2]) * 0.5f };
+        const float e[3] = { (b.Max[0] - b.Min[0]) * 0.5f, (b.Max[1] - b.Min[1]) * 0.5f, (b.Max[2] - b.Min[2]) * 0.5f };
+        const float dist = f.NormalX[p] * c[0] + f.NormalY[p] * c[1] + f.NormalZ[p] * c[2] + f.D[p];
+        const float reach = fabsf(f.NormalX[p]) * e[0] + fabsf(f.NormalY[p]) * e[1] + fabsf(f.NormalZ[p]) * e[2];
+        if (dist + reach < 0.0f)
+            return false;
+    }
+    return true;
+}
+
+// Slab test, out_t is where the ray enters the box or 0 if it starts inside
+bool RayHitsBox(const BVHBounds& b, const float origin[3], const float dir[3], float maxT, float& out_t)
+{
+    float tEnter = 0.0f, tExit = maxT;
+    for (uint32_t k = 0; k != 3; ++k)
+    {
+        const float invDir = 1.0f / dir[k];
+        float t0 = (b.Min[k] - origin[k]) * invDir, t1 = (b.Max[k] - origin[k]) * invDir;
+        if (t0 > t1)
+            std::swap(t0, t1);
+        tEnter = std::max(tEnter, t0);
+        tExit = std::min(tExit, t1);
+    }
+    out_t = tEnter;
+    return tEnter <= tExit;
+}
+
+// Mirrors what the BVH should hold: bounds by user data, and which user data are currently inserted
+struct Reference
+{
+    std::vector<BVHBounds> Bounds;
+    std::vector<uint32_t> Proxies;
+    std::vector<uint32_t> Alive;
+};
+
+bool CheckQueries(const DynamicBVH& bvh, const Reference& ref, RandomBoxes& random, const Frustum& frustum)
+{
+    bool matches = true;
+    std::vector<uint32_t> found, expected;
+
+    for (uint32_t q = 0; q != 20; ++q)
+    {
+        const float center[3] = { random.Position(random.Rng), random.Position(random.Rng), random.Position(random.Rng) };
+        const float radius = random.Extent(random.Rng) * 5.0f;
+
+        found.clear();
+        bvh.QuerySphere(center, radius, found);
+        std::sort(found.begin(), found.end());
+
+        expected.clear();
+        for (uint32_t id : ref.Alive)
+        {
+            if (TouchesSphere(ref.Bounds[id], center, radius))
+                expected.push_back(id);
+        }
+        std::sort(expected.begin(), expected.end());
+        matches &= found == expected;
+
+        // Short rays from anywhere, so both hits and misses come up
+        const float origin[3] = { random.Position(random.Rng), random.Position(random.Rng), random.Position(random.Rng) };
+        const float dir[3] = { random.Position(random.Rng), random.Position(random.Rng), random.Position(random.Rng) };
+        const float maxT = 2.0f;
+
+        float closestT = maxT;
+        bool expectHit = false;
+        for (uint32_t id : ref.Alive)
+        {
+            float t;
+            if (RayHitsBox(ref.Bounds[id], origin, dir, maxT, t) && (!expectHit || t < closestT))
+            {
+                closestT = t;
+                expectHit = true;
+            }
+        }
+
+        BVHRayHit hit;
+        const bool didHit = bvh.RayCast(origin, dir, maxT, hit);
+        matches &= didHit == expectHit;
+        if (didHit && expectHit)
+            matches &= fabsf(hit.T - closestT) <= 1e-4f && hit.UserData == bvh.GetUserData(hit.Proxy);
+    }
+
+    found.clear();
+    bvh.QueryFrustum(frustum, found);
+    std::sort(found.begin(), found.end());
+
+    expected.clear();
+    for (uint32_t id : ref.Alive)
+    {
+        if (TouchesFrustum(ref.Bounds[id], frustum))
+            expected.push_back(id);
+    }
+    std::sort(expected.begin(), expected.end());
+    matches &= found == expected;
+
+    return matches;
+}
+
+void BuildRandomTree(uint32_t count, uint32_t seed, DynamicBVH& out_bvh, std::vector<uint32_t>& out_proxies)
+{
+    RandomBoxes random(seed);
+    out_bvh.Clear();
+    out_proxies.resize(count);
+    for (uint32_t i = 0; i != count; ++i)
+        out_proxies[i] = out_bvh.Insert(random.Next(), i);
+    out_bvh.Rebuild();
+}
+}
+
+MUON_TEST(BVH_MatchesBruteForce)
+{
+    RandomBoxes random(5);
+    Frustum frustum;
+    MakeBoxFrustum(30.0f, frustum);
+
+    DynamicBVH bvh;
+    Reference ref;
+    for (uint32_t round = 0; round != 60; ++round)
+    {
+        // Inserts outnumber removes, so the tree grows while churning
+        for (uint32_t i = 0; i != 300; ++i)
+        {
+            if (random.Rng() % 3 == 0 && !ref.Alive.empty())
+            {
+                const size_t k = random.Rng() % ref.Alive.size();
+                bvh.Remove(ref.Proxies[ref.Alive[k]]);
+                ref.Alive[k] = ref.Alive.back();
+                ref.Alive.pop_back();
+            }
+            else
+            {
+                const uint32_t id = static_cast<uint32_t>(ref.Bounds.size());
+                ref.Bounds.push_back(random.Next());
+                ref.Proxies.push_back(bvh.Insert(ref.Bounds.back(), id));
+                ref.Alive.push_back(id);
+            }
+        }
+
+        for (uint32_t i = 0; i != 100 && !ref.Alive.empty(); ++i)
+        {
+            const uint32_t id = ref.Alive[random.Rng() % ref.Alive.size()];
+            ref.Bounds[id] = random.Next();
+            bvh.Update(ref.Proxies[id], ref.Bounds[id]);
+        }
+        bvh.Refit();
+
+        if (round % 7 == 3)
+            bvh.Rebuild();
+
+        const bool matches = CheckQueries(bvh, ref, random, frustum);
+        if (!matches)
+            std::printf("    Mismatch in round %u with %zu objects\n", round, ref.Alive.size());
+        MUON_CHECK(matches);
+    }
+
+    const BVHStats stats = bvh.GetStats();
+    MUON_CHECK(stats.NumProxies == ref.Alive.size());
+    for (uint32_t id : ref.Alive)
+        MUON_CHECK(bvh.GetUserData(ref.Proxies[id]) == id);
+}
+
+MUON_TEST(BVH_EmptyTree)
+{
+    Frustum frustum;
+    MakeBoxFrustum(30.0f, frustum);
+    const float origin[3] = { 0.0f, 0.0f, 0.0f };
+    const float dir[3] = { 1.0f, 0.0f, 0.0f };
+
+    DynamicBVH bvh;
+    std::vector<uint32_t> found;
+    BVHRayHit hit;
+    bvh.Refit();
+    bvh.Rebuild();
+    bvh.QuerySphere(origin, 1.0f, found);
+    bvh.QueryFrustum(frustum, found);
+    MUON_CHECK(found.empty());
+    MUON_CHECK(!bvh.RayCast(origin, dir, 100.0f, hit));
+
+    // Emptied again after holding something
+    const BVHBounds bounds = { { -1.0f, -1.0f, -1.0f }, { 1.0f, 1.0f, 1.0f } };
+    bvh.Remove(bvh.Insert(bounds, 7));
+    bvh.Rebuild();
+    bvh.QueryFrustum(frustum, found);
+    MUON_CHECK(found.empty());
+    MUON_CHECK(bvh.GetStats().NumProxies == 0);
+}
+
+MUON_BENCHMARK(BVH_Queries)
+{
+    static const uint32_t kNumObjects = 100000;
+    static const uint32_t kNumQueries = 1000;
+
+    DynamicBVH bvh;
+    std::vector<uint32_t> proxies;
+    BuildRandomTree(kNumObjects, 1, bvh, proxies);
+
+    RandomBoxes random(2);
+    std::vector<float> points(kNumQueries * 6);
+    for (float& p : points)
+        p = random.Position(random.Rng);
+
+    Frustum frustum;
+    MakeBoxFrustum(30.0f, frustum);
+
+    std::vector<uint32_t> found;
+    found.reserve(kNumObjects);
+    const BenchmarkResult frustumResult = RunBenchmark(20, [&]()
+    {
+        found.clear();
+        bvh.QueryFrustum(frustum, found);
+    });
+
+    const BenchmarkResult sphereResult = RunBenchmark(20, [&]()
+    {
+        for (uint32_t q = 0; q != kNumQueries; ++q)
+        {
+            found.clear();
+            bvh.QuerySphere(&points[q * 6], 10.0f, found);
+        }
+    });
+
+    uint32_t numHits = 0;
+    const BenchmarkResult rayResult = RunBenchmark(20, [&]()
+    {
+        numHits = 0;
+        BVHRayHit hit;
+        for (uint32_t q = 0; q != kNumQueries; ++q)
+            numHits += bvh.RayCast(&points[q * 6], &points[q * 6 + 3], 1.0f, hit);
+    });
+
+    const BVHStats stats = bvh.GetStats();
+    std::printf("    100k objects, %u nodes, depth %u, SAH cost %.2f\n", stats.NumNodes, stats.MaxDepth, stats.SAHCost);
+    PrintBenchmark("QueryFrustum, 100k objects", frustumResult, (double)kNumObjects, "objects");
+    PrintBenchmark("QuerySphere, r = 10", sphereResult, (double)kNumQueries, "queries");
+    char label[64];
+    std::snprintf(label, sizeof(label), "RayCast, %u/%u hit", numHits, kNumQueries);
+    PrintBenchmark(label, rayResult, (double)kNumQueries, "rays");
+}
+
+MUON_BENCHMARK(BVH_RefitAndRebuild)
+{
+    static const uint32_t kNumObjects = 100000;
+
+    DynamicBVH bvh;
+    std::vector<uint32_t> proxies;
+    BuildRandomTree(kNumObjects, 1, bvh, proxies);
+
+    std::vector<BVHBounds> bounds(kNumObjects);
+    for (uint32_t i = 0; i != kNumObjects; ++i)
+        bounds[i] = bvh.GetBounds(proxies[i]);
+
+    // A tenth of the objects moving, then every object, as with a scene full of movers. Alternating offsets keep the tree's quality steady.
+    std::mt19937 rng(3);
+    std::vector<uint32_t> someMovers(kNumObjects / 10), allMovers(kNumObjects);
+    for (uint32_t& m : someMovers)
+        m = rng() % kNumObjects;
+    for (uint32_t i = 0; i != kNumObjects; ++i)
+        allMovers[i] = i;
+
+    float offset = 0.1f;
+    auto moveAndRefit = [&](const std::vector<uint32_t>& movers)
+    {
+        offset = -offset;
+        for (uint32_t m : movers)
+        {
+            bounds[m].Min[0] += offset;
+            bounds[m].Max[0] += offset;
+            bvh.Update(proxies[m], bounds[m]);
+        }
+        bvh.Refit();
+    };
+
+    const BenchmarkResult someResult = RunBenchmark(20, [&]() { moveAndRefit(someMovers); });
+    const double someRefitMs = bvh.GetStats().RefitMs;
+    const BenchmarkResult allResult = RunBenchmark(20, [&]() { moveAndRefit(allMovers); });
+    const double allRefitMs = bvh.GetStats().RefitMs;
+
+    const BenchmarkResult rebuildResult = RunBenchmark(5, [&]() { bvh.Rebuild(); });
+
+    char label[80];
+    std::snprintf(label, sizeof(label), "Update + Refit, 10k moved (refit %.3f ms)", someRefitMs);
+    PrintBenchmark(label, someResult, (double)someMovers.size(), "objects");
+    std::snprintf(label, sizeof(label), "Update + Refit, 100k moved (refit %.3f ms)", allRefitMs);
+    PrintBenchmark(label, allResult, (double)allMovers.size(), "objects");
+    PrintBenchmark("Rebuild, 100k objects", rebuildResult, (double)kNumObjects, "objects");
+}
@@ -0,0 +1,247 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Packet vs single ray and determinism tests and baseline benchmark for the CPU cloud raymarcher
+----------------------------------------------*/
+#include "TestFramework.h"
+
+#include <Core/CloudRaymarcher.h>
+#include <Core/JobSystem.h>
+#include <Core/NoiseVolume.h>
+#include <Core/PathMacros.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <math.h>
+#include <string.h>
+#include <vector>
+
+namespace
+{
+using namespace Muon;
+
+static const float kNear = 0.1f;
+static const float kFar = 1000.0f;
+
+struct TestVolumes
+{
+    NoiseVolume Shape, Detail, Weather;
+    CloudVolumes Volumes;
+};
+
+bool MakeVolumes(uint32_t shapeSize, uint32_t detailSize, uint32_t weatherSize, TestVolumes& out_volumes, const wchar_t* cacheDir = nullptr)
+{
+    const bool loaded = cacheDir ?
+        LoadOrGenerateNoiseVolume(GetCloudShapeNoiseDesc(shapeSize), out_volumes.Shape, nullptr, cacheDir) &&
+        LoadOrGenerateNoiseVolume(GetCloudDetailNoiseDesc(detailSize), out_volumes.Detail, nullptr, cacheDir) &&
+        LoadOrGenerateNoiseVolume(GetCloudWeatherNoiseDesc(weatherSize), out_volumes.Weather, nullptr, cacheDir) :
+        GenerateNoiseVolume(GetCloudShapeNoiseDesc(shapeSize), out_volumes.Shape) &&
+        GenerateNoiseVolume(GetCloudDetailNoiseDesc(detailSize), out_volumes.Detail) &&
+        GenerateNoiseVolume(GetCloudWeatherNoiseDesc(weatherSize), out_volumes.Weather);
+
+    out_volumes.Volumes.pShape = &out_volumes.Shape;
+    out_volumes.Volumes.pDetail = &out_volumes.Detail;
+    out_volumes.Volumes.pWeather = &out_volumes.Weather;
+    return loaded;
+}
+
+void MultiplyMatrices(const float a[16], const float b[16], float out[16])
+{
+    for (uint32_t r = 0; r != 4; ++r)
+    {
+        for (uint32_t c = 0; c != 4; ++c)
+            out[r * 4 + c] = a[r * 4 + 0] * b[0 * 4 + c] + a[r * 4 + 1] * b[1 * 4 + c] + a[r * 4 + 2] * b[2 * 4 + c] + a[r * 4 + 3] * b[3 * 4 + c];
+    }
+}
+
+// Inverse of a DirectXMath style perspective projection followed by the inverse view, for a camera at height y
+// pitched up by pitch radians, looking down +z. The clouds are ahead and above it, the ground below the horizon is clear.
+void MakeInvViewProj(float aspect, float pitch, float y, float out_invViewProj[16])
+{
+    const float yScale = 1.0f / tanf(0.5f * 1.0471976f);
+    const float xScale = yScale / aspect;
+    const float range = kFar / (kFar - kNear);
+
+    // clip = [x * xScale, y * yScale, z * range - near * range, z], undone row by row
+    const float invProj[16] =
+    {
+        1.0f / xScale, 0.0f,          0.0f, 0.0f,
+        0.0f,          1.0f / yScale, 0.0f, 0.0f,
+        0.0f,          0.0f,          0.0f, -1.0f / (kNear * range),
+        0.0f,          0.0f,          1.0f, 1.0f / kNear
+    };
+
+    // Camera to world: right, up and forward as rows, then the position
+    const float s = sinf(pitch), c = cosf(pitch);
+    const float invView[16] =
+    {
+        1.0f, 0.0f, 0.0f, 0.0f,
+        0.0f, c,    -s,   0.0f,
+        0.0f, s,    c,    0.0f,
+        0.0f, y,    0.0f, 1.0f
+    };
+    MultiplyMatrices(invProj, invView, out_invViewProj);
+}
+
+// The same view, narrowed so a 1x1 image covers only the pixel centered at (ndcX, ndcY), the one ray the full view
+// traces there. Every lane of its packet is the same ray, so nothing another lane does can leak into it.
+void MakeSinglePixelInvViewProj(const float invViewProj[16], float ndcX, float ndcY, float out_invViewProj[16])
+{
+    const float offset[16] =
+    {
+        0.0f, 0.0f, 0.0f, 0.0f,
+        0.0f, 0.0f, 0.0f, 0.0f,
+        0.0f, 0.0f, 1.0f, 0.0f,
+        ndcX, ndcY, 0.0f, 1.0f
+    };
+    MultiplyMatrices(offset, invViewProj, out_invViewProj);
+}
+
+CloudLayerDesc MakeTestLayer()
+{
+    // Fewer steps than the default keeps the per pixel renders quick, and the heavier coverage makes sure a small view has clouds in it
+    CloudLayerDesc desc;
+    desc.NumSteps = 24;
+    desc.NumLightSteps = 4;
+    desc.Coverage = 0.6f;
+    return desc;
+}
+}
+
+MUON_TEST(CloudRaymarcher_PacketsMatchSingleRays)
+{
+    JobSystem::Init(3);
+
+    TestVolumes volumes;
+    MUON_CHECK(MakeVolumes(32, 16, 16, volumes));
+    const CloudLayerDesc desc = MakeTestLayer();
+
+    // Odd dimensions, so the last column and row of packets are part empty
+    const uint32_t width = 21, height = 13;
+    float invViewProj[16];
+    MakeInvViewProj(float(width) / height, 0.3f, 20.0f, invViewProj);
+
+    CloudImage image;
+    CloudRenderStats stats;
+    MUON_CHECK(RenderCloudReference(invViewProj, volumes.Volumes, desc, width, height, image, &stats));
+    MUON_CHECK(image.Width == width && image.Height == height && image.Pixels.size() == size_t(width) * height * 4);
+    MUON_CHECK(stats.NumRays == uint64_t(width) * height && stats.NumDensitySamples > 0);
+
+    uint32_t numCloudy = 0, numClear = 0;
+    float maxError = 0.0f;
+    bool inRange = true;
+    for (uint32_t y = 0; y != height; ++y)
+    {
+        for (uint32_t x = 0; x != width; ++x)
+        {
+            const float ndcX = (x + 0.5f) / width * 2.0f - 1.0f;
+            const float ndcY = 1.0f - (y + 0.5f) / height * 2.0f;
+            float pixelInvViewProj[16];
+            MakeSinglePixelInvViewProj(invViewProj, ndcX, ndcY, pixelInvViewProj);
+
+            CloudImage pixel;
+            MUON_CHECK(RenderCloudReference(pixelInvViewProj, volumes.Volumes, desc, 1, 1, pixel));
+
+            const float* pPacket = &image.Pixels[(size_t(y) * width + x) * 4];
+            for (uint32_t c = 0; c != 4; ++c)
+            {
+                inRange &= pPacket[c] >= 0.0f && pPacket[c] <= (c == 3 ? 1.0f : 4.0f);
+                maxError = std::max(maxError, fabsf(pPacket[c] - pixel.Pixels[c]));
+            }
+
+            numCloudy += pPacket[3] > 0.1f ? 1 : 0;
+            numClear += pPacket[3] == 0.0f ? 1 : 0;
+        }
+    }
+
+    // The single pixel views round a little differently, so the rays only match to within float precision
+    if (maxError > 1e-3f)
+        std::printf("    Max difference from single rays %g\n", maxError);
+    MUON_CHECK(maxError <= 1e-3f);
+    MUON_CHECK(inRange);
+
+    // Both clouds and clear sky below the layer, so the comparison covers more than empty rays
+    if (!numCloudy || !numClear)
+        std::printf("    %u cloudy and %u clear pixels\n", numCloudy, numClear);
+    MUON_CHECK(numCloudy > 0 && numClear > 0);
+
+    JobSystem::Destroy();
+}
+
+MUON_TEST(CloudRaymarcher_SameAcrossThreadCounts)
+{
+    JobSystem::Init(3);
+    TestVolumes volumes;
+    MUON_CHECK(MakeVolumes(32, 16, 16, volumes));
+    JobSystem::Destroy();
+    const CloudLayerDesc desc = MakeTestLayer();
+
+    float invViewProj[16];
+    MakeInvViewProj(2.0f, 0.3f, 20.0f, invViewProj);
+
+    // Tiles are independent, so how they're spread over threads can't change a single bit
+    const uint32_t threadCounts[] = { 1, 4 };
+    std::vector<float> reference;
+    for (uint32_t numThreads : threadCounts)
+    {
+        JobSystem::Init(numThreads);
+
+        CloudImage image;
+        MUON_CHECK(RenderCloudReference(invViewProj, volumes.Volumes, desc, 70, 35, image));
+        if (reference.empty())
+            reference = image.Pixels;
+        else
+            MUON_CHECK(image.Pixels.size() == reference.size() && memcmp(image.Pixels.data(), reference.data(), reference.size() * sizeof(float)) == 0);
+
+        JobSystem::Destroy();
+    }
+}
+
+MUON_TEST(CloudRaymarcher_RejectsInvalidInputs)
+{
+    JobSystem::Init(3);
+
+    TestVolumes volumes;
+    MUON_CHECK(MakeVolumes(8, 8, 8, volumes));
+    float invViewProj[16];
+    MakeInvViewProj(1.0f, 0.3f, 20.0f, invViewProj);
+
+    CloudImage image;
+    CloudLayerDesc desc = MakeTestLayer();
+    MUON_CHECK(!RenderCloudReference(invViewProj, volumes.Volumes, desc, 0, 4, image));
+
+    CloudVolumes missing = volumes.Volumes;
+    missing.pDetail = nullptr;
+    MUON_CHECK(!RenderCloudReference(invViewProj, missing, desc, 4, 4, image));
+
+    desc.TopHeight = desc.BottomHeight;
+    MUON_CHECK(!RenderCloudReference(invViewProj, volumes.Volumes, desc, 4, 4, image));
+
+    JobSystem::Destroy();
+}
+
+MUON_BENCHMARK(CloudRaymarcher_Baseline)
+{
+    JobSystem::Init();
+
+    // The game's volumes and layer, at a resolution a capture would use
+    TestVolumes volumes;
+    MakeVolumes(128, 32, 64, volumes, CACHEPATHW L"Tests/Clouds/");
+    const CloudLayerDesc desc;
+
+    const uint32_t width = 320, height = 180;
+    float invViewProj[16];
+    MakeInvViewProj(float(width) / height, 0.3f, 20.0f, invViewProj);
+
+    CloudImage image;
+    CloudRenderStats stats;
+    const BenchmarkResult result = RunBenchmark(5, [&]() { RenderCloudReference(invViewProj, volumes.Volumes, desc, width, height, image, &stats); });
+
+    char label[96];
+    std::snprintf(label, sizeof(label), "Reference %ux%u, %u steps", width, height, desc.NumSteps);
+    PrintBenchmark(label, result, double(stats.NumRays), "rays");
+    std::printf("    %.1f M density samples/s, %u threads\n",
+        stats.NumDensitySamples / (result.MedianMs * 1e-3) * 1e-6, JobSystem::GetSingleton().GetNumThreads());
+
+    JobSystem::Destroy();
+}
@@ -0,0 +1,206 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Tests and thread scaling benchmark for parallel command recording
+----------------------------------------------*/
+#include "TestFramework.h"
+
+#include <Core/CommandRecorder.h>
+#include <Core/JobSystem.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+namespace
+{
+using namespace Muon;
+
+// Stands in for D3D12CommandRecorder: each chunk "records" its items into its own stream, Submit concatenates them
+class MockCommandRecorder : public ICommandRecorder
+{
+public:
+    explicit MockCommandRecorder(uint32_t maxChunks, uint32_t workPerItem = 0) : mMaxChunks(maxChunks), mWorkPerItem(workPerItem) {}
+
+    uint32_t GetMaxChunks() const override { return mMaxChunks; }
+
+    bool BeginRecording(uint32_t numChunks) override
+    {
+        mNumBegins++;
+        mStreams.assign(numChunks, {});
+        mRanges.assign(numChunks, {});
+        mRecordCounts = std::vector<std::atomic<uint32_t>>(numChunks);
+        return numChunks <= mMaxChunks;
+    }
+
+    void RecordChunk(uint32_t chunkIndex, size_t begin, size_t end) override
+    {
+        mRecordCounts[chunkIndex].fetch_add(1, std::memory_order_relaxed);
+        mRanges[chunkIndex] = { begin, end };
+
+        std::vector<uint64_t>& stream = mStreams[chunkIndex];
+        for (size_t i = begin; i != end; ++i)
+        {
+            // Something for the optimizer to keep, roughly the cost of setting up and issuing one draw
+            uint64_t command = i;
+            for (uint32_t w = 0; w != mWorkPerItem; ++w)
+                command = command * 6364136223846793005ull + 1442695040888963407ull;
+            stream.push_back(mWorkPerItem ? (command & ~0xFFFFFFFFull) | i : i);
+        }
+    }
+
+    bool Submit() override
+    {
+        mSubmitted.clear();
+        for (size_t i = 0; i != mStreams.size(); ++i)
+        {
+            // Every chunk has to be recorded exactly once before anything is submitted
+            if (mRecordCounts[i].load(std::memory_order_relaxed) != 1)
+                return false;
+            for (uint64_t command : mStreams[i])
+                mSubmitted.push_back(command & 0xFFFFFFFFull);
+        }
+        return true;
+    }
+
+    uint32_t mMaxChunks;
+    uint32_t mWorkPerItem;
+    uint32_t mNumBegins = 0;
+    std::vector<std::vector<uint64_t>> mStreams;
+    std::vector<RecordingChunk> mRanges;
+    std::vector<std::atomic<uint32_t>> mRecordCounts;
+    std::vector<uint64_t> mSubmitted; // Item indices in submission order
+};
+
+bool IsSequential(const std::vector<uint64_t>& submitted, size_t numItems)
+{
+    if (submitted.size() != numItems)
+        return false;
+    for (size_t i = 0; i != numItems; ++i)
+    {
+        if (submitted[i] != i)
+            return false;
+    }
+    return true;
+}
+}
+
+MUON_TEST(CommandRecorder_PlanChunks)
+{
+    const size_t itemCounts[] = { 0, 1, 2, 7, 63, 64, 65, 1000, 4097 };
+    const uint32_t chunkCounts[] = { 0, 1, 3, 8, 64 };
+    const size_t minSizes[] = { 0, 1, 16, 64 };
+
+    std::vector<RecordingChunk> chunks;
+    for (size_t numItems : itemCounts)
+    for (uint32_t maxChunks : chunkCounts)
+    for (size_t minItems : minSizes)
+    {
+        PlanRecordingChunks(numItems, maxChunks, minItems, chunks);
+        if (numItems == 0)
+        {
+            MUON_CHECK(chunks.empty());
+            continue;
+        }
+
+        // Contiguous, ordered and covering every item once
+        MUON_CHECK(!chunks.empty());
+        MUON_CHECK(chunks.size() <= (maxChunks ? maxChunks : 1));
+        size_t expectedBegin = 0;
+        size_t smallest = SIZE_MAX, largest = 0;
+        for (const RecordingChunk& chunk : chunks)
+        {
+            MUON_CHECK(chunk.Begin == expectedBegin);
+            MUON_CHECK(chunk.End > chunk.Begin);
+            expectedBegin = chunk.End;
+            smallest = std::min(smallest, chunk.End - chunk.Begin);
+            largest = std::max(largest, chunk.End - chunk.Begin);
+        }
+        MUON_CHECK(expectedBegin == numItems);
+        MUON_CHECK(largest - smallest <= 1);
+
+        // Only one chunk may fall short of the minimum, and only when there aren't enough items for more
+        if (chunks.size() > 1)
+            MUON_CHECK(smallest >= minItems);
+    }
+}
+
+MUON_TEST(CommandRecorder_DeterministicSubmissionOrder)
+{
+    const uint32_t threadCounts[] = { 1, 2, 4, 8 };
+    const size_t itemCounts[] = { 0, 1, 5, 100, 1023, 10000 };
+
+    for (uint32_t numThreads : threadCounts)
+    {
+        JobSystem::Init(numThreads - 1);
+
+        for (size_t numItems : itemCounts)
+        {
+            // Repeated so a race between chunks has a chance to show up as a reordering
+            for (uint32_t run = 0; run != 20; ++run)
+            {
+                MockCommandRecorder recorder(16);
+                RecordingStats stats;
+                MUON_CHECK(RecordInParallel(recorder, numItems, 8, &stats));
+                MUON_CHECK(recorder.mNumBegins == 1);
+                MUON_CHECK(stats.NumChunks == recorder.mStreams.size());
+                MUON_CHECK(stats.NumChunks <= std::min<uint32_t>(16, numThreads));
+                MUON_CHECK(IsSequential(recorder.mSubmitted, numItems));
+
+                std::vector<RecordingChunk> expected;
+                PlanRecordingChunks(numItems, std::min<uint32_t>(16, numThreads), 8, expected);
+                MUON_CHECK(expected.size() == recorder.mRanges.size());
+                for (size_t i = 0; i < expected.size() && i < recorder.mRanges.size(); ++i)
+                    MUON_CHECK(expected[i].Begin == recorder.mRanges[i].Begin && expected[i].End == recorder.mRanges[i].End);
+            }
+        }
+
+        JobSystem::Destroy();
+    }
+}
+
+MUON_TEST(CommandRecorder_RecorderCapsChunks)
+{
+    JobSystem::Init(7);
+
+    // Fewer command lists than threads: the recorder's limit wins
+    MockCommandRecorder recorder(3);
+    RecordingStats stats;
+    MUON_CHECK(RecordInParallel(recorder, 5000, 1, &stats));
+    MUON_CHECK(stats.NumChunks == 3);
+    MUON_CHECK(IsSequential(recorder.mSubmitted, 5000));
+
+    JobSystem::Destroy();
+}
+
+MUON_BENCHMARK(CommandRecorder_ThreadScaling)
+{
+    static const size_t kNumDraws = 20000;
+    static const uint32_t kWorkPerDraw = 200;
+
+    const uint32_t hwThreads = std::max(1u, std::thread::hardware_concurrency());
+    double singleThreadMs = 0.0;
+
+    for (uint32_t numThreads = 1; numThreads <= hwThreads; numThreads *= 2)
+    {
+        JobSystem::Init(numThreads - 1);
+
+        MockCommandRecorder recorder(64, kWorkPerDraw);
+        BenchmarkResult result = RunBenchmark(20, [&]() { RecordInParallel(recorder, kNumDraws, 64); });
+
+        if (numThreads == 1)
+            singleThreadMs = result.MedianMs;
+
+        char label[64];
+        std::snprintf(label, sizeof(label), "%u threads (%.2fx)", numThreads, singleThreadMs / result.MedianMs);
+        PrintBenchmark(label, result, (double)kNumDraws, "draws");
+
+        JobSystem::Destroy();
+
+        if (numThreads < hwThreads && numThreads * 2 > hwThreads)
+            numThreads = hwThreads / 2; // Always finish on the full thread count
+    }
+}
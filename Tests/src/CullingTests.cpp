@@ -0,0 +1,165 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Tests and benchmark for SoA frustum culling
+----------------------------------------------*/
+#include "TestFramework.h"
+
+#include <Core/Culling.h>
+#include <Core/JobSystem.h>
+
+#include <cstdio>
+#include <math.h>
+#include <random>
+#include <vector>
+
+namespace
+{
+using namespace Muon;
+
+// The axis aligned box [-10, 10]^3, as six inward facing planes
+void MakeBoxFrustum(Frustum& out_frustum)
+{
+    const float normals[Frustum::COUNT][3] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+    for (uint32_t p = 0; p != Frustum::COUNT; ++p)
+    {
+        out_frustum.NormalX[p] = normals[p][0];
+        out_frustum.NormalY[p] = normals[p][1];
+        out_frustum.NormalZ[p] = normals[p][2];
+        out_frustum.D[p] = 10.0f;
+    }
+}
+
+// Volumes spread over three times the frustum's size, so roughly a tenth of them are visible
+void MakeVolumes(size_t count, uint32_t seed, BoundingSpheresSoA& out_spheres, BoundingBoxesSoA& out_boxes)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> position(-30.0f, 30.0f), size(0.0f, 5.0f);
+    out_spheres.Resize(count);
+    out_boxes.Resize(count);
+    for (size_t i = 0; i != count; ++i)
+    {
+        const float center[3] = { position(rng), position(rng), position(rng) };
+        const float extents[3] = { size(rng), size(rng), size(rng) };
+        out_spheres.Set(i, center[0], center[1], center[2], extents[0]);
+        out_boxes.Set(i, center, extents);
+    }
+}
+
+void BruteForceCull(const Frustum& f, const BoundingSpheresSoA& s, const BoundingBoxesSoA& b, std::vector<uint32_t>& out_spheres, std::vector<uint32_t>& out_boxes)
+{
+    out_spheres.clear();
+    out_boxes.clear();
+    for (size_t i = 0; i != s.GetCount(); ++i)
+    {
+        bool sphereInside = true, boxInside = true;
+        for (uint32_t p = 0; p != Frustum::COUNT; ++p)
+        {
+            sphereInside &= f.NormalX[p] * s.CenterX[i] + f.NormalY[p] * s.CenterY[i] + f.NormalZ[p] * s.CenterZ[i] + f.D[p] >= -s.Radius[i];
+
+            const float dist = f.NormalX[p] * b.CenterX[i] + f.NormalY[p] * b.CenterY[i] + f.NormalZ[p] * b.CenterZ[i] + f.D[p];
+            const float reach = fabsf(f.NormalX[p]) * b.ExtentX[i] + fabsf(f.NormalY[p]) * b.ExtentY[i] + fabsf(f.NormalZ[p]) * b.ExtentZ[i];
+            boxInside &= dist + reach >= 0.0f;
+        }
+
+        if (sphereInside)
+            out_spheres.push_back(static_cast<uint32_t>(i));
+        if (boxInside)
+            out_boxes.push_back(static_cast<uint32_t>(i));
+    }
+}
+}
+
+MUON_TEST(Culling_MatchesBruteForce)
+{
+    // Counts off the SIMD group width, so the padding past the last volume has to be masked off. The large ones are split into chunks.
+    const size_t counts[] = { 0, 1, 3, 7, 9, 13, 1000, 16384, 16387, 100003, 1000000 };
+
+    Frustum frustum;
+    MakeBoxFrustum(frustum);
+
+    JobSystem::Init(3);
+    for (size_t count : counts)
+    {
+        BoundingSpheresSoA spheres;
+        BoundingBoxesSoA boxes;
+        MakeVolumes(count, static_cast<uint32_t>(count), spheres, boxes);
+
+        // The frustum origin is inside every padding volume, so any padding that isn't masked off shows up as visible
+        std::vector<uint32_t> expectedSpheres, expectedBoxes;
+        BruteForceCull(frustum, spheres, boxes, expectedSpheres, expectedBoxes);
+
+        std::vector<uint32_t> visibleSpheres, visibleBoxes;
+        CullStats sphereStats, boxStats;
+        CullSpheres(frustum, spheres, visibleSpheres, &sphereStats);
+        CullBoxes(frustum, boxes, visibleBoxes, &boxStats);
+
+        const bool matches = visibleSpheres == expectedSpheres && visibleBoxes == expectedBoxes;
+        if (!matches)
+            std::printf("    Mismatch culling %zu volumes: %zu/%zu spheres, %zu/%zu boxes visible\n", count,
+                visibleSpheres.size(), expectedSpheres.size(), visibleBoxes.size(), expectedBoxes.size());
+        MUON_CHECK(matches);
+        MUON_CHECK(sphereStats.NumTested == count && sphereStats.NumVisible == expectedSpheres.size());
+        MUON_CHECK(boxStats.NumTested == count && boxStats.NumVisible == expectedBoxes.size());
+    }
+    JobSystem::Destroy();
+}
+
+MUON_TEST(Culling_ExtractFrustumPlanes)
+{
+    // Orthographic over [-2, 2] x [-1, 1] x [0.5, 4.5]: x' = x / 2, y' = y, z' = (z - 0.5) / 4, w = 1
+    const float viewProj[16] =
+    {
+        0.5f, 0.0f, 0.0f,   0.0f,
+        0.0f, 1.0f, 0.0f,   0.0f,
+        0.0f, 0.0f, 0.25f,  0.0f,
+        0.0f, 0.0f, -0.125f, 1.0f
+    };
+
+    Frustum frustum;
+    ExtractFrustumPlanes(viewProj, frustum);
+
+    BoundingSpheresSoA spheres;
+    spheres.Resize(6);
+    spheres.Set(0, 0.0f, 0.0f, 2.0f, 0.1f);   // Center
+    spheres.Set(1, 1.9f, 0.9f, 4.4f, 0.0f);   // Inside a corner
+    spheres.Set(2, 2.5f, 0.0f, 2.0f, 0.4f);   // Right, out of reach
+    spheres.Set(3, 2.5f, 0.0f, 2.0f, 0.6f);   // Right, overlapping
+    spheres.Set(4, 0.0f, 0.0f, 0.2f, 0.2f);   // In front of the near plane
+    spheres.Set(5, 0.0f, -1.5f, 5.0f, 0.1f);  // Below and past the far plane
+
+    std::vector<uint32_t> visible;
+    CullSpheres(frustum, spheres, visible);
+    const std::vector<uint32_t> expected = { 0, 1, 3 };
+    MUON_CHECK(visible == expected);
+}
+
+MUON_BENCHMARK(Culling_Throughput)
+{
+    JobSystem::Init();
+
+    Frustum frustum;
+    MakeBoxFrustum(frustum);
+
+    const size_t counts[] = { 100000, 1000000 };
+    for (size_t count : counts)
+    {
+        BoundingSpheresSoA spheres;
+        BoundingBoxesSoA boxes;
+        MakeVolumes(count, 1, spheres, boxes);
+
+        std::vector<uint32_t> visible;
+        visible.reserve(count);
+        CullStats stats;
+        const BenchmarkResult sphereResult = RunBenchmark(20, [&]() { CullSpheres(frustum, spheres, visible, &stats); });
+        const BenchmarkResult boxResult = RunBenchmark(20, [&]() { CullBoxes(frustum, boxes, visible, &stats); });
+
+        char label[96];
+        std::snprintf(label, sizeof(label), "CullSpheres, %zu volumes, %u chunks", count, stats.NumChunks);
+        PrintBenchmark(label, sphereResult, (double)count, "volumes");
+        std::snprintf(label, sizeof(label), "CullBoxes, %zu volumes, %u chunks", count, stats.NumChunks);
+        PrintBenchmark(label, boxResult, (double)count, "volumes");
+    }
+
+    JobSystem::Destroy();
+}
@@ -0,0 +1,240 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Tests and benchmark for instance batching, run against a CPU buffer instead of the frame upload buffer
+----------------------------------------------*/
+#include "TestFramework.h"
+
+#include <Core/InstanceBatcher.h>
+#include <Core/Material.h>
+#include <Core/Mesh.h>
+#include <Core/Shader.h>
+
+#include <cstdio>
+#include <string.h>
+#include <vector>
+
+namespace
+{
+using namespace Muon;
+
+static const uint32_t kNumCubes = 10000;
+static const D3D12_GPU_VIRTUAL_ADDRESS kFakeBaseAddr = 0x10000;
+
+// Stands in for the frame upload buffer. GPU addresses are offsets from a fake base, so streams can be read back.
+struct CPUUploadBuffer
+{
+    std::vector<uint8_t> Data;
+    size_t Used = 0;
+
+    explicit CPUUploadBuffer(size_t capacity) : Data(capacity) {}
+
+    bool Allocate(size_t size, UINT alignment, void*& out_mappedPtr, D3D12_GPU_VIRTUAL_ADDRESS& out_gpuAddr)
+    {
+        const size_t offset = (Used + alignment - 1) & ~size_t(alignment - 1);
+        if (offset + size > Data.size())
+            return false;
+
+        Used = offset + size;
+        out_mappedPtr = Data.data() + offset;
+        out_gpuAddr = kFakeBaseAddr + offset;
+        return true;
+    }
+
+    const uint8_t* Read(D3D12_GPU_VIRTUAL_ADDRESS gpuAddr) const { return Data.data() + (gpuAddr - kFakeBaseAddr); }
+};
+
+// A vertex shader whose reflected instance inputs are the four world matrix rows, as the instanced .hlsl files declare them
+struct InstancedShader
+{
+    Semantics SemanticsArr[4] = { Semantics::WORLDMATRIX, Semantics::WORLDMATRIX, Semantics::WORLDMATRIX, Semantics::WORLDMATRIX };
+    uint16_t ByteOffsets[4] = { 0, 16, 32, 48 };
+    VertexShader VS;
+
+    InstancedShader()
+    {
+        VS.Instanced = true;
+        VS.InstanceDesc.SemanticsArr = SemanticsArr;
+        VS.InstanceDesc.ByteOffsets = ByteOffsets;
+        VS.InstanceDesc.AttrCount = 4;
+        VS.InstanceDesc.ByteSize = 64;
+    }
+};
+
+void MakeWorlds(uint32_t count, std::vector<DirectX::XMFLOAT4X4>& out_worlds)
+{
+    out_worlds.resize(count);
+    for (uint32_t i = 0; i != count; ++i)
+        DirectX::XMStoreFloat4x4(&out_worlds[i], DirectX::XMMatrixTranslation(float(i % 100) * 2.0f, 0.0f, float(i / 100) * 2.0f));
+}
+}
+
+MUON_TEST(InstanceBatcher_GroupsByMaterialAndMesh)
+{
+    InstancedShader instancedVS;
+    VertexShader plainVS;
+
+    MaterialType instancedMat(L"Instanced");
+    instancedMat.SetVertexShader(&instancedVS.VS);
+    MaterialType plainMat(L"Plain");
+    plainMat.SetVertexShader(&plainVS);
+
+    Mesh cube, sphere;
+    std::vector<DirectX::XMFLOAT4X4> worlds;
+    MakeWorlds(8, worlds);
+
+    CPUUploadBuffer upload(64 * 1024);
+    InstanceBatcher batcher;
+    batcher.SetUploadFunc([&](size_t size, UINT alignment, void*& out_mappedPtr, D3D12_GPU_VIRTUAL_ADDRESS& out_gpuAddr)
+    {
+        return upload.Allocate(size, alignment, out_mappedPtr, out_gpuAddr);
+    });
+
+    // Interleaved on purpose, each instanced batch has to keep its own submission order
+    batcher.Reset();
+    batcher.Add(&instancedMat, &cube, &worlds[0], 5.0f);
+    batcher.Add(&instancedMat, &sphere, &worlds[1], 3.0f);
+    batcher.Add(&plainMat, &cube, &worlds[2], 1.0f);
+    batcher.Add(&instancedMat, &cube, &worlds[3], 2.0f);
+    batcher.Add(&plainMat, &cube, &worlds[4], 4.0f);
+    batcher.Add(&instancedMat, &cube, &worlds[5], 7.0f);
+    MUON_CHECK(batcher.Build());
+
+    const std::vector<InstanceBatch>& batches = batcher.GetBatches();
+    MUON_CHECK(batcher.GetStats().NumEntities == 6);
+    MUON_CHECK(batcher.GetStats().NumBatches == 4);
+    if (batches.size() != 4)
+        return;
+
+    // Batches come out in order of their first entity
+    const InstanceBatch& cubes = batches[0];
+    MUON_CHECK(cubes.pMaterial == &instancedMat && cubes.pMesh == &cube);
+    MUON_CHECK(cubes.IsInstanced() && cubes.NumInstances == 3 && cubes.MinDepth == 2.0f);
+    MUON_CHECK(cubes.InstanceView.StrideInBytes == 64 && cubes.InstanceView.SizeInBytes == 3 * 64);
+    const uint32_t expectedCubes[] = { 0, 3, 5 };
+    for (uint32_t i = 0; i != 3; ++i)
+        MUON_CHECK(memcmp(upload.Read(cubes.InstanceView.BufferLocation) + i * 64, &worlds[expectedCubes[i]], 64) == 0);
+
+    const InstanceBatch& spheres = batches[1];
+    MUON_CHECK(spheres.pMesh == &sphere && spheres.IsInstanced() && spheres.NumInstances == 1);
+    MUON_CHECK(memcmp(upload.Read(spheres.InstanceView.BufferLocation), &worlds[1], 64) == 0);
+
+    // Non-instanced shaders draw one entity at a time with their matrix in a constant buffer
+    const uint32_t expectedSingles[] = { 2, 4 };
+    for (uint32_t i = 0; i != 2; ++i)
+    {
+        const InstanceBatch& single = batches[2 + i];
+        MUON_CHECK(!single.IsInstanced() && single.NumInstances == 1);
+        MUON_CHECK(single.pWorld == &worlds[expectedSingles[i]]);
+        MUON_CHECK(single.WorldAddr % D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT == 0);
+        MUON_CHECK(memcmp(upload.Read(single.WorldAddr), &worlds[expectedSingles[i]], 64) == 0);
+    }
+}
+
+MUON_TEST(InstanceBatcher_ZeroesUnwrittenAttributes)
+{
+    // A color attribute the batcher has no data for sits between the matrix rows
+    InstancedShader instancedVS;
+    Semantics semantics[5] = { Semantics::WORLDMATRIX, Semantics::COLOR, Semantics::WORLDMATRIX, Semantics::WORLDMATRIX, Semantics::WORLDMATRIX };
+    uint16_t offsets[5] = { 0, 16, 32, 48, 64 };
+    instancedVS.VS.InstanceDesc.SemanticsArr = semantics;
+    instancedVS.VS.InstanceDesc.ByteOffsets = offsets;
+    instancedVS.VS.InstanceDesc.AttrCount = 5;
+    instancedVS.VS.InstanceDesc.ByteSize = 80;
+
+    MaterialType mat(L"InstancedColor");
+    mat.SetVertexShader(&instancedVS.VS);
+    Mesh cube;
+    std::vector<DirectX::XMFLOAT4X4> worlds;
+    MakeWorlds(2, worlds);
+
+    // Upload memory is recycled, so start from garbage
+    CPUUploadBuffer upload(4096);
+    memset(upload.Data.data(), 0xCD, upload.Data.size());
+
+    InstanceBatcher batcher;
+    batcher.SetUploadFunc([&](size_t size, UINT alignment, void*& out_mappedPtr, D3D12_GPU_VIRTUAL_ADDRESS& out_gpuAddr)
+    {
+        return upload.Allocate(size, alignment, out_mappedPtr, out_gpuAddr);
+    });
+    batcher.Reset();
+    batcher.Add(&mat, &cube, &worlds[0], 1.0f);
+    batcher.Add(&mat, &cube, &worlds[1], 1.0f);
+    MUON_CHECK(batcher.Build());
+    MUON_CHECK(batcher.GetBatches().size() == 1);
+    if (batcher.GetBatches().size() != 1)
+        return;
+
+    const uint8_t* pStream = upload.Read(batcher.GetBatches()[0].InstanceView.BufferLocation);
+    const uint8_t zeroes[16] = {};
+    for (uint32_t i = 0; i != 2; ++i)
+    {
+        const uint8_t* pInstance = pStream + i * 80;
+        MUON_CHECK(memcmp(pInstance, worlds[i].m[0], 16) == 0);
+        MUON_CHECK(memcmp(pInstance + 16, zeroes, 16) == 0);
+        MUON_CHECK(memcmp(pInstance + 32, worlds[i].m[1], 48) == 0);
+    }
+}
+
+MUON_TEST(InstanceBatcher_ReportsUploadFailure)
+{
+    InstancedShader instancedVS;
+    MaterialType mat(L"Instanced");
+    mat.SetVertexShader(&instancedVS.VS);
+    Mesh cube;
+    std::vector<DirectX::XMFLOAT4X4> worlds;
+    MakeWorlds(4, worlds);
+
+    InstanceBatcher batcher;
+    batcher.SetUploadFunc([](size_t, UINT, void*&, D3D12_GPU_VIRTUAL_ADDRESS&) { return false; });
+    batcher.Reset();
+    for (const DirectX::XMFLOAT4X4& world : worlds)
+        batcher.Add(&mat, &cube, &world, 1.0f);
+    MUON_CHECK(!batcher.Build());
+    MUON_CHECK(batcher.GetBatches().size() == 1 && !batcher.GetBatches()[0].IsInstanced());
+}
+
+MUON_BENCHMARK(InstanceBatcher_10kCubes)
+{
+    InstancedShader instancedVS;
+    VertexShader plainVS;
+
+    MaterialType instancedMat(L"Instanced");
+    instancedMat.SetVertexShader(&instancedVS.VS);
+    MaterialType plainMat(L"Plain");
+    plainMat.SetVertexShader(&plainVS);
+
+    Mesh cube;
+    std::vector<DirectX::XMFLOAT4X4> worlds;
+    MakeWorlds(kNumCubes, worlds);
+
+    // Sized for the single draw path, which pads every matrix to constant buffer alignment
+    CPUUploadBuffer upload(size_t(kNumCubes) * D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
+    InstanceBatcher batcher;
+    batcher.SetUploadFunc([&](size_t size, UINT alignment, void*& out_mappedPtr, D3D12_GPU_VIRTUAL_ADDRESS& out_gpuAddr)
+    {
+        return upload.Allocate(size, alignment, out_mappedPtr, out_gpuAddr);
+    });
+
+    uint32_t numDraws[2] = {};
+    const MaterialType* materials[2] = { &instancedMat, &plainMat };
+    BenchmarkResult results[2];
+    for (uint32_t m = 0; m != 2; ++m)
+    {
+        results[m] = RunBenchmark(20, [&]()
+        {
+            upload.Used = 0;
+            batcher.Reset();
+            for (uint32_t i = 0; i != kNumCubes; ++i)
+                batcher.Add(materials[m], &cube, &worlds[i], float(i));
+            batcher.Build();
+        });
+        numDraws[m] = batcher.GetStats().NumBatches;
+    }
+
+    char label[96];
+    std::snprintf(label, sizeof(label), "Build, 10k cubes instanced (%u draws)", numDraws[0]);
+    PrintBenchmark(label, results[0], (double)kNumCubes, "cubes");
+    std::snprintf(label, sizeof(label), "Build, 10k cubes one draw each (%u draws)", numDraws[1]);
+    PrintBenchmark(label, results[1], (double)kNumCubes, "cubes");
+}
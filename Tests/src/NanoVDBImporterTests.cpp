@@ -0,0 +1,427 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Fog volume and level set import tests, and the import throughput benchmark for NanoVDB grids
+----------------------------------------------*/
+#include "TestFramework.h"
+
+#include <Core/BinaryStream.h>
+#include <Core/JobSystem.h>
+#include <Core/NanoVDBImporter.h>
+#include <Core/PathMacros.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <map>
+#include <math.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+namespace
+{
+using namespace Muon;
+
+static const wchar_t* kGridPath = CACHEPATHW L"Tests/NanoVDB/Grid.nvdb";
+static const uint32_t kLeafVoxels = 512;
+
+// Builds float grids with just the parts of the NanoVDB 32.x layout the importer reads: the file and grid headers,
+// the transform, and flat leaf, lower and upper node arrays. Child offsets and the root are left zeroed.
+class NanoVDBWriter
+{
+public:
+    explicit NanoVDBWriter(float background) : mBackground(background) {}
+
+    // Values are z fastest, like NanoVDB's own
+    void AddLeaf(const int32_t origin[3], const float values[kLeafVoxels], const uint64_t activeMask[kLeafVoxels / 64])
+    {
+        std::vector<uint8_t> leaf(kLeafSize, 0);
+        memcpy(leaf.data(), origin, 3 * sizeof(int32_t));
+        memcpy(leaf.data() + 16, activeMask, kLeafVoxels / 8);
+        memcpy(leaf.data() + 96, values, kLeafVoxels * sizeof(float));
+        mLeaves.insert(mLeaves.end(), leaf.begin(), leaf.end());
+
+        SetEntry(GetNode(mLowers, kLower, origin), kLower, origin, true, false, 0.0f);
+        SetEntry(GetNode(mUppers, kUpper, origin), kUpper, origin, true, false, 0.0f);
+        ++mNumLeaves;
+    }
+
+    // An 8^3 tile in a lower node
+    void AddTile(const int32_t origin[3], float value, bool active)
+    {
+        SetEntry(GetNode(mLowers, kLower, origin), kLower, origin, false, active, value);
+        SetEntry(GetNode(mUppers, kUpper, origin), kUpper, origin, true, false, 0.0f);
+    }
+
+    bool Save(const wchar_t* path, double voxelSize, const double translation[3]) const
+    {
+        std::vector<uint8_t> lowers, uppers;
+        for (const auto& node : mLowers)
+            lowers.insert(lowers.end(), node.second.Bytes.begin(), node.second.Bytes.end());
+        for (const auto& node : mUppers)
+            uppers.insert(uppers.end(), node.second.Bytes.begin(), node.second.Bytes.end());
+
+        // Tree node offsets are relative to the tree, which starts right after the grid header
+        std::vector<uint8_t> tree(kTreeSize, 0);
+        const int64_t leafOffset = kTreeSize, lowerOffset = leafOffset + int64_t(mLeaves.size()), upperOffset = lowerOffset + int64_t(lowers.size());
+        const uint32_t counts[3] = { mNumLeaves, uint32_t(mLowers.size()), uint32_t(mUppers.size()) };
+        memcpy(tree.data(), &leafOffset, sizeof(int64_t));
+        memcpy(tree.data() + 8, &lowerOffset, sizeof(int64_t));
+        memcpy(tree.data() + 16, &upperOffset, sizeof(int64_t));
+        memcpy(tree.data() + 32, counts, sizeof(counts));
+
+        std::vector<uint8_t> grid(kGridSize, 0);
+        const uint64_t gridSize = kGridSize + tree.size() + mLeaves.size() + lowers.size() + uppers.size();
+        const double matrix[9] = { voxelSize, 0, 0, 0, voxelSize, 0, 0, 0, voxelSize };
+        memcpy(grid.data(), &kMagic, sizeof(kMagic));
+        memcpy(grid.data() + 16, &kVersion, sizeof(kVersion));
+        memcpy(grid.data() + 32, &gridSize, sizeof(gridSize));
+        memcpy(grid.data() + 384, matrix, sizeof(matrix));
+        memcpy(grid.data() + 528, translation, 3 * sizeof(double));
+        memcpy(grid.data() + 636, &kFloatType, sizeof(kFloatType));
+
+        static const char kName[] = "density";
+        std::vector<uint8_t> meta(kMetaSize, 0);
+        const uint32_t nameSize = sizeof(kName);
+        memcpy(meta.data(), &gridSize, sizeof(gridSize));
+        memcpy(meta.data() + 8, &gridSize, sizeof(gridSize));
+        memcpy(meta.data() + 32, &kFloatType, sizeof(kFloatType));
+        memcpy(meta.data() + 136, &nameSize, sizeof(nameSize));
+
+        const uint16_t numGrids = 1;
+        BinaryWriter writer;
+        writer.Write(kMagic);
+        writer.Write(kVersion);
+        writer.Write(numGrids);
+        writer.Write(uint16_t(0)); // Codec
+        writer.WriteBytes(meta.data(), meta.size());
+        writer.WriteBytes(kName, sizeof(kName));
+        const std::vector<uint8_t>* parts[] = { &grid, &tree, &mLeaves, &lowers, &uppers };
+        for (const std::vector<uint8_t>* pPart : parts)
+            writer.WriteBytes(pPart->data(), pPart->size());
+        return writer.SaveToFile(path);
+    }
+
+private:
+    struct NodeLayout
+    {
+        uint32_t Log2Dim;
+        uint32_t ChildLog2Dim;
+        size_t ChildMask;
+        size_t Table;
+        size_t Size;
+    };
+    static const NodeLayout kLower, kUpper;
+
+    struct Node
+    {
+        std::vector<uint8_t> Bytes;
+    };
+    typedef std::map<std::array<int32_t, 3>, Node> NodeMap; // Sorted by origin, so files come out the same every time
+
+    Node& GetNode(NodeMap& nodes, const NodeLayout& layout, const int32_t origin[3])
+    {
+        const int32_t mask = ~int32_t((1u << (layout.Log2Dim + layout.ChildLog2Dim)) - 1);
+        const std::array<int32_t, 3> key = { origin[0] & mask, origin[1] & mask, origin[2] & mask };
+        Node& node = nodes[key];
+        if (node.Bytes.empty())
+        {
+            // Everything that isn't a child or a tile is the background
+            node.Bytes.resize(layout.Size, 0);
+            memcpy(node.Bytes.data(), key.data(), sizeof(key));
+            for (uint32_t n = 0; n != 1u << (3 * layout.Log2Dim); ++n)
+                memcpy(node.Bytes.data() + layout.Table + n * sizeof(uint64_t), &mBackground, sizeof(float));
+        }
+        return node;
+    }
+
+    static void SetEntry(Node& node, const NodeLayout& layout, const int32_t origin[3], bool child, bool active, float value)
+    {
+        const uint32_t axisMask = (1u << layout.Log2Dim) - 1;
+        uint32_t entry = 0;
+        for (uint32_t a = 0; a != 3; ++a)
+            entry = (entry << layout.Log2Dim) | ((uint32_t(origin[a]) >> layout.ChildLog2Dim) & axisMask);
+
+        uint8_t* pBytes = node.Bytes.data();
+        const uint64_t bit = 1ull << (entry & 63);
+        uint64_t valueMask, childMask;
+        memcpy(&valueMask, pBytes + 32 + (entry >> 6) * sizeof(uint64_t), sizeof(uint64_t));
+        memcpy(&childMask, pBytes + layout.ChildMask + (entry >> 6) * sizeof(uint64_t), sizeof(uint64_t));
+        valueMask = active ? valueMask | bit : valueMask & ~bit;
+        childMask = child ? childMask | bit : childMask & ~bit;
+        memcpy(pBytes + 32 + (entry >> 6) * sizeof(uint64_t), &valueMask, sizeof(uint64_t));
+        memcpy(pBytes + layout.ChildMask + (entry >> 6) * sizeof(uint64_t), &childMask, sizeof(uint64_t));
+        if (!child)
+            memcpy(pBytes + layout.Table + entry * sizeof(uint64_t), &value, sizeof(float));
+    }
+
+    static constexpr uint64_t kMagic = 0x304244566F6E614Eull; // "NanoVDB0"
+    static constexpr uint32_t kVersion = 32u << 21;
+    static constexpr uint32_t kFloatType = 1;
+    static constexpr size_t kMetaSize = 176;
+    static constexpr size_t kGridSize = 672;
+    static constexpr size_t kTreeSize = 64;
+    static constexpr size_t kLeafSize = 2144;
+
+    float mBackground;
+    std::vector<uint8_t> mLeaves;
+    uint32_t mNumLeaves = 0;
+    NodeMap mLowers, mUppers;
+};
+
+const NanoVDBWriter::NodeLayout NanoVDBWriter::kLower = { 4, 3, 544, 1088, 33856 };
+const NanoVDBWriter::NodeLayout NanoVDBWriter::kUpper = { 5, 7, 4128, 8256, 270400 };
+
+// The whole grid as dense values, so samples can be checked against what was written
+struct DenseGrid
+{
+    static const int32_t kDim = 128; // One lower node
+    std::vector<float> Values = std::vector<float>(size_t(kDim) * kDim * kDim);
+    std::vector<uint8_t> Active = std::vector<uint8_t>(size_t(kDim) * kDim * kDim);
+
+    size_t Index(int32_t x, int32_t y, int32_t z) const { return (size_t(z) * kDim + y) * kDim + x; }
+
+    // Blocks with an active voxel become leaves, the rest become inactive tiles holding their first voxel
+    void Write(NanoVDBWriter& writer) const
+    {
+        for (int32_t bz = 0; bz != kDim; bz += 8)
+        {
+            for (int32_t by = 0; by != kDim; by += 8)
+            {
+                for (int32_t bx = 0; bx != kDim; bx += 8)
+                {
+                    float values[kLeafVoxels];
+                    uint64_t activeMask[kLeafVoxels / 64] = {};
+                    for (uint32_t n = 0; n != kLeafVoxels; ++n)
+                    {
+                        const size_t i = Index(bx + int32_t(n >> 6), by + int32_t((n >> 3) & 7), bz + int32_t(n & 7));
+                        values[n] = Values[i];
+                        activeMask[n >> 6] |= uint64_t(Active[i]) << (n & 63);
+                    }
+
+                    const int32_t origin[3] = { bx, by, bz };
+                    if (std::any_of(activeMask, activeMask + kLeafVoxels / 64, [](uint64_t word) { return word != 0; }))
+                        writer.AddLeaf(origin, values, activeMask);
+                    else
+                        writer.AddTile(origin, values[0], false);
+                }
+            }
+        }
+    }
+};
+
+uint8_t Quantize(float value, float valueMin, float valueMax)
+{
+    const float t = (value - valueMin) / (valueMax - valueMin);
+    if (!(t > 0.0f))
+        return 0;
+    return t < 1.0f ? static_cast<uint8_t>(t * 255.0f + 0.5f) : 255;
+}
+
+// Samples every voxel center of the imported volume against its quantized dense value. Voxels skipped as inactive read as zero.
+uint32_t CountMismatches(const SparseCloudVolumeData& data, const DenseGrid& dense, const NanoVDBImportDesc& desc, bool keepInactive)
+{
+    const std::wstring path = CACHEPATHW L"Tests/NanoVDB/Imported.mnsv";
+    SparseCloudVolume volume;
+    if (!SaveSparseCloudVolume(data, path.c_str()) || !volume.Open(path.c_str(), static_cast<uint32_t>(data.Bricks.size())))
+        return UINT32_MAX;
+
+    const float camera[3] = { 0.0f, 0.0f, 0.0f };
+    volume.UpdateStreaming(camera, static_cast<uint32_t>(data.Bricks.size()));
+
+    uint32_t numMismatches = 0;
+    for (int32_t z = 0; z != DenseGrid::kDim; ++z)
+    {
+        for (int32_t y = 0; y != DenseGrid::kDim; ++y)
+        {
+            for (int32_t x = 0; x != DenseGrid::kDim; ++x)
+            {
+                const size_t i = dense.Index(x, y, z);
+                const uint8_t quantized = (keepInactive || dense.Active[i]) ? Quantize(dense.Values[i], desc.ValueMin, desc.ValueMax) : 0;
+                const float expected = quantized * desc.DensityScale / 255.0f;
+                const float pos[3] = { float(x), float(y), float(z) };
+                if (fabsf(volume.SampleDensity(pos) - expected) > 1e-6f)
+                    ++numMismatches;
+            }
+        }
+    }
+    return numMismatches;
+}
+}
+
+MUON_TEST(NanoVDBImporter_FogVolume)
+{
+    JobSystem::Init(3);
+
+    // A density ball, with garbage left in the inactive voxels around it that has to be skipped
+    DenseGrid dense;
+    for (int32_t z = 0; z != DenseGrid::kDim; ++z)
+    {
+        for (int32_t y = 0; y != DenseGrid::kDim; ++y)
+        {
+            for (int32_t x = 0; x != DenseGrid::kDim; ++x)
+            {
+                const float r = sqrtf(float((x - 40) * (x - 40) + (y - 50) * (y - 50) + (z - 60) * (z - 60)));
+                const size_t i = dense.Index(x, y, z);
+                dense.Active[i] = r < 25.0f;
+                dense.Values[i] = r < 25.0f ? (1.0f - r / 25.0f) * 2.0f : 7.0f;
+            }
+        }
+    }
+
+    NanoVDBWriter writer(0.0f);
+    dense.Write(writer);
+
+    // Plus one constant active tile, which has to be expanded into a full brick. It's only marked active in the dense grid
+    // after writing, or it would have been written as a leaf.
+    const int32_t tileOrigin[3] = { 104, 0, 0 };
+    writer.AddTile(tileOrigin, 1.5f, true);
+    for (int32_t z = 0; z != 8; ++z)
+    {
+        for (int32_t y = 0; y != 8; ++y)
+        {
+            for (int32_t x = 104; x != 112; ++x)
+            {
+                dense.Values[dense.Index(x, y, z)] = 1.5f;
+                dense.Active[dense.Index(x, y, z)] = 1;
+            }
+        }
+    }
+
+    const double translation[3] = { 0.0, 0.0, 0.0 };
+    MUON_CHECK(writer.Save(kGridPath, 1.0, translation));
+
+    NanoVDBImportDesc desc;
+    desc.ValueMax = 2.0f;
+    desc.DensityScale = 0.1f;
+    SparseCloudVolumeData data;
+    NanoVDBImportStats stats;
+    MUON_CHECK(ImportNanoVDB(kGridPath, desc, data, &stats));
+    MUON_CHECK(stats.NumTiles == 1);
+
+    const uint32_t numMismatches = CountMismatches(data, dense, desc, false);
+    if (numMismatches != 0)
+        std::printf("    %u voxels differ from the grid\n", numMismatches);
+    MUON_CHECK(numMismatches == 0);
+
+    JobSystem::Destroy();
+}
+
+MUON_TEST(NanoVDBImporter_LevelSet)
+{
+    JobSystem::Init(3);
+
+    // A sphere's signed distance, active only in a narrow band. Inside it the values are -background, which is all a
+    // level set stores for its interior, and blocks entirely inside become inactive tiles of -background.
+    static const float kBackground = 3.0f;
+    DenseGrid dense;
+    for (int32_t bz = 0; bz != DenseGrid::kDim; bz += 8)
+    {
+        for (int32_t by = 0; by != DenseGrid::kDim; by += 8)
+        {
+            for (int32_t bx = 0; bx != DenseGrid::kDim; bx += 8)
+            {
+                bool inBand = false;
+                for (uint32_t n = 0; n != kLeafVoxels; ++n)
+                {
+                    const int32_t x = bx + int32_t(n >> 6), y = by + int32_t((n >> 3) & 7), z = bz + int32_t(n & 7);
+                    const float distance = sqrtf(float((x - 64) * (x - 64) + (y - 64) * (y - 64) + (z - 64) * (z - 64))) - 45.0f;
+                    const size_t i = dense.Index(x, y, z);
+                    dense.Active[i] = fabsf(distance) < kBackground;
+                    dense.Values[i] = std::min(std::max(distance, -kBackground), kBackground);
+                    inBand |= dense.Active[i] != 0;
+                }
+
+                // Outside the band every voxel of a block has the same sign, so the block is a constant tile
+                if (!inBand)
+                {
+                    const float value = dense.Values[dense.Index(bx, by, bz)];
+                    for (uint32_t n = 0; n != kLeafVoxels; ++n)
+                        dense.Values[dense.Index(bx + int32_t(n >> 6), by + int32_t((n >> 3) & 7), bz + int32_t(n & 7))] = value;
+                }
+            }
+        }
+    }
+
+    NanoVDBWriter writer(kBackground);
+    dense.Write(writer);
+    const double translation[3] = { 0.0, 0.0, 0.0 };
+    MUON_CHECK(writer.Save(kGridPath, 1.0, translation));
+
+    // Full one voxel inside the surface
+    NanoVDBImportDesc desc;
+    desc.ValueMin = 0.0f;
+    desc.ValueMax = -1.0f;
+    SparseCloudVolumeData data;
+    NanoVDBImportStats stats;
+    MUON_CHECK(ImportNanoVDB(kGridPath, desc, data, &stats));
+    MUON_CHECK(stats.NumTiles > 0);
+
+    // Including the center, which is deep inside and only covered by tiles
+    const uint32_t numMismatches = CountMismatches(data, dense, desc, true);
+    if (numMismatches != 0)
+        std::printf("    %u voxels differ from the level set\n", numMismatches);
+    MUON_CHECK(numMismatches == 0);
+
+    JobSystem::Destroy();
+}
+
+MUON_BENCHMARK(NanoVDBImporter_Throughput)
+{
+    JobSystem::Init();
+
+    // A 256x128x256 slab of leaves cycling through a few payloads, mostly active
+    static const int32_t kSlab[3] = { 256, 128, 256 };
+    std::vector<float> payloads[4];
+    std::vector<uint64_t> masks[4];
+    uint32_t state = 1;
+    for (uint32_t p = 0; p != 4; ++p)
+    {
+        payloads[p].resize(kLeafVoxels);
+        masks[p].assign(kLeafVoxels / 64, 0);
+        for (uint32_t n = 0; n != kLeafVoxels; ++n)
+        {
+            state = state * 1664525u + 1013904223u;
+            payloads[p][n] = (state >> 8) / float(1 << 24) * 1.2f;
+            masks[p][n >> 6] |= uint64_t((state >> 28) != 0) << (n & 63);
+        }
+    }
+
+    NanoVDBWriter writer(0.0f);
+    uint32_t leaf = 0;
+    for (int32_t z = 0; z != kSlab[2]; z += 8)
+    {
+        for (int32_t y = 0; y != kSlab[1]; y += 8)
+        {
+            for (int32_t x = 0; x != kSlab[0]; x += 8, ++leaf)
+            {
+                const int32_t origin[3] = { x, y, z };
+                writer.AddLeaf(origin, payloads[leaf % 4].data(), masks[leaf % 4].data());
+            }
+        }
+    }
+    const double translation[3] = { 0.0, 0.0, 0.0 };
+    if (!writer.Save(kGridPath, 1.0, translation))
+    {
+        std::printf("    Failed to write the benchmark grid\n");
+        JobSystem::Destroy();
+        return;
+    }
+
+    NanoVDBImportDesc desc;
+    desc.ValueMax = 1.2f;
+    NanoVDBImportStats stats;
+    const BenchmarkResult result = RunBenchmark(5, [&]()
+    {
+        SparseCloudVolumeData data;
+        ImportNanoVDB(kGridPath, desc, data, &stats);
+    });
+
+    char label[64];
+    std::snprintf(label, sizeof(label), "ImportNanoVDB, %u leaves", stats.NumLeaves);
+    PrintBenchmark(label, result, double(stats.NumVoxels), "voxels");
+    std::printf("    %u threads\n", JobSystem::GetSingleton().GetNumThreads());
+
+    JobSystem::Destroy();
+}
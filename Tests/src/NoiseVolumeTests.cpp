@@ -0,0 +1,98 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Cache tests and generation vs cache hit benchmark for noise volumes
+----------------------------------------------*/
+#include "TestFramework.h"
+
+#include <Core/JobSystem.h>
+#include <Core/NoiseVolume.h>
+#include <Core/PathMacros.h>
+
+#include <cstdio>
+#include <filesystem>
+
+namespace
+{
+using namespace Muon;
+
+// Kept apart from the game's cache, and emptied first so the first load always generates
+const wchar_t* ResetTestCacheDir()
+{
+    static const wchar_t* kCacheDir = CACHEPATHW L"Tests/Noise/";
+    std::error_code ec;
+    std::filesystem::remove_all(kCacheDir, ec);
+    return kCacheDir;
+}
+}
+
+MUON_TEST(NoiseVolume_CacheRoundTrip)
+{
+    JobSystem::Init(3);
+    const wchar_t* cacheDir = ResetTestCacheDir();
+
+    NoiseVolumeDesc desc = GetCloudShapeNoiseDesc(32);
+    NoiseVolume generated, loaded, regenerated;
+    NoiseVolumeStats stats;
+
+    MUON_CHECK(LoadOrGenerateNoiseVolume(desc, generated, &stats, cacheDir));
+    MUON_CHECK(!stats.FromCache && stats.GenerateMs > 0.0);
+    MUON_CHECK(generated.Size == 32 && generated.Voxels.size() == size_t(32) * 32 * 32 * 4);
+
+    MUON_CHECK(LoadOrGenerateNoiseVolume(desc, loaded, &stats, cacheDir));
+    MUON_CHECK(stats.FromCache && stats.GenerateMs == 0.0);
+    MUON_CHECK(loaded.Voxels == generated.Voxels);
+
+    // Generation is deterministic across thread counts, which is what makes the cache valid at all
+    MUON_CHECK(GenerateNoiseVolume(desc, regenerated));
+    MUON_CHECK(regenerated.Voxels == generated.Voxels);
+
+    // Anything in the description that changes the output changes the hash, so it misses instead of loading stale voxels
+    NoiseVolumeDesc reseeded = desc;
+    reseeded.Seed = 1;
+    MUON_CHECK(HashNoiseVolumeDesc(reseeded) != HashNoiseVolumeDesc(desc));
+    MUON_CHECK(LoadOrGenerateNoiseVolume(reseeded, loaded, &stats, cacheDir));
+    MUON_CHECK(!stats.FromCache && loaded.Voxels != generated.Voxels);
+
+    JobSystem::Destroy();
+}
+
+MUON_BENCHMARK(NoiseVolume_GenerateVsCacheHit)
+{
+    JobSystem::Init();
+    const wchar_t* cacheDir = ResetTestCacheDir();
+
+    struct NamedDesc
+    {
+        const char* Name;
+        NoiseVolumeDesc Desc;
+    };
+    const NamedDesc descs[] =
+    {
+        { "Shape 128^3", GetCloudShapeNoiseDesc() },
+        { "Detail 32^3", GetCloudDetailNoiseDesc() },
+        { "Weather 64^3", GetCloudWeatherNoiseDesc() },
+    };
+
+    for (const NamedDesc& named : descs)
+    {
+        const double numVoxels = double(named.Desc.Size) * named.Desc.Size * named.Desc.Size;
+
+        NoiseVolume volume;
+        const BenchmarkResult generate = RunBenchmark(5, [&]() { GenerateNoiseVolume(named.Desc, volume); });
+
+        // The first call writes the cache, every timed one reads it back
+        NoiseVolumeStats stats;
+        LoadOrGenerateNoiseVolume(named.Desc, volume, &stats, cacheDir);
+        const BenchmarkResult cacheHit = RunBenchmark(20, [&]() { LoadOrGenerateNoiseVolume(named.Desc, volume, &stats, cacheDir); });
+
+        char label[64];
+        std::snprintf(label, sizeof(label), "%s, generate", named.Name);
+        PrintBenchmark(label, generate, numVoxels, "voxels");
+        std::snprintf(label, sizeof(label), "%s, cache %s", named.Name, stats.FromCache ? "hit" : "MISS");
+        PrintBenchmark(label, cacheHit, numVoxels, "voxels");
+    }
+
+    std::printf("    %u threads\n", JobSystem::GetSingleton().GetNumThreads());
+    JobSystem::Destroy();
+}
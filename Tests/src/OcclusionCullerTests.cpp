@@ -0,0 +1,393 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Depth, conservativeness and determinism tests and benchmark for the software occlusion culler
+----------------------------------------------*/
+#include "TestFramework.h"
+
+#include <Core/Culling.h>
+#include <Core/JobSystem.h>
+#include <Core/OcclusionCuller.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <float.h>
+#include <math.h>
+#include <random>
+#include <string.h>
+#include <vector>
+
+namespace
+{
+using namespace Muon;
+
+static const float kNear = 1.0f;
+static const float kFar = 100.0f;
+
+// Row-major, row-vector convention like DirectXMath's XMMatrixPerspectiveFovLH, looking down +z
+void MakePerspective(float xScale, float yScale, float out_viewProj[16])
+{
+    const float range = kFar / (kFar - kNear);
+    const float m[16] =
+    {
+        xScale, 0.0f,   0.0f,            0.0f,
+        0.0f,   yScale, 0.0f,            0.0f,
+        0.0f,   0.0f,   range,           1.0f,
+        0.0f,   0.0f,   -kNear * range,  0.0f
+    };
+    memcpy(out_viewProj, m, sizeof(m));
+}
+
+float PerspectiveDepth(float z)
+{
+    return kFar / (kFar - kNear) * (1.0f - kNear / z);
+}
+
+void MakeScaleTranslation(const float scale[3], const float translation[3], float out_world[16])
+{
+    memset(out_world, 0, 16 * sizeof(float));
+    out_world[0] = scale[0];
+    out_world[5] = scale[1];
+    out_world[10] = scale[2];
+    out_world[12] = translation[0];
+    out_world[13] = translation[1];
+    out_world[14] = translation[2];
+    out_world[15] = 1.0f;
+}
+
+// The [-1, 1] square in the z = 0 plane
+bool MakeQuad(OccluderMesh& out_mesh)
+{
+    const float positions[] = { -1, -1, 0,  1, -1, 0,  1, 1, 0,  -1, 1, 0 };
+    const uint32_t indices[] = { 0, 1, 2,  0, 2, 3 };
+    return InitOccluderMesh(out_mesh, positions, 4, 3 * sizeof(float), 0, indices, 6);
+}
+
+// The [-1, 1] cube
+bool MakeCube(OccluderMesh& out_mesh)
+{
+    const float positions[] =
+    {
+        -1, -1, -1,  1, -1, -1,  1, 1, -1,  -1, 1, -1,
+        -1, -1,  1,  1, -1,  1,  1, 1,  1,  -1, 1,  1,
+    };
+    const uint32_t indices[] =
+    {
+        0, 2, 1,  0, 3, 2,  4, 5, 6,  4, 6, 7,
+        0, 1, 5,  0, 5, 4,  3, 7, 6,  3, 6, 2,
+        0, 4, 7,  0, 7, 3,  1, 2, 6,  1, 6, 5,
+    };
+    return InitOccluderMesh(out_mesh, positions, 8, 3 * sizeof(float), 0, indices, 36);
+}
+
+// Walls of cubes spread in front of the camera, and boxes scattered through the same space to test against them
+struct Scene
+{
+    float ViewProj[16];
+    OccluderMesh Cube;
+    std::vector<float> OccluderWorlds; // 16 floats each
+    BoundingBoxesSoA Boxes;
+    std::vector<uint32_t> Candidates;
+};
+
+bool MakeScene(size_t numOccluders, size_t numBoxes, uint32_t seed, Scene& out_scene)
+{
+    MakePerspective(1.0f, 1.0f, out_scene.ViewProj);
+    if (!MakeCube(out_scene.Cube))
+        return false;
+
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> lateral(-20.0f, 20.0f), occluderDepth(8.0f, 30.0f), boxDepth(3.0f, 80.0f);
+    std::uniform_real_distribution<float> occluderSize(0.5f, 4.0f), boxSize(0.1f, 1.5f);
+
+    out_scene.OccluderWorlds.resize(numOccluders * 16);
+    for (size_t i = 0; i != numOccluders; ++i)
+    {
+        const float z = occluderDepth(rng);
+        const float scale[3] = { occluderSize(rng), occluderSize(rng), 0.5f };
+        const float translation[3] = { lateral(rng) * z / 20.0f, lateral(rng) * z / 20.0f, z };
+        MakeScaleTranslation(scale, translation, &out_scene.OccluderWorlds[i * 16]);
+    }
+
+    out_scene.Boxes.Resize(numBoxes);
+    out_scene.Candidates.resize(numBoxes);
+    for (size_t i = 0; i != numBoxes; ++i)
+    {
+        const float z = boxDepth(rng);
+        const float center[3] = { lateral(rng) * z / 20.0f, lateral(rng) * z / 20.0f, z };
+        const float extents[3] = { boxSize(rng), boxSize(rng), boxSize(rng) };
+        out_scene.Boxes.Set(i, center, extents);
+        out_scene.Candidates[i] = static_cast<uint32_t>(i);
+    }
+    return true;
+}
+
+void RenderScene(const Scene& scene, OcclusionCuller& culler)
+{
+    culler.BeginFrame(scene.ViewProj);
+    for (size_t i = 0; i != scene.OccluderWorlds.size() / 16; ++i)
+        culler.AddOccluder(&scene.Cube, &scene.OccluderWorlds[i * 16]);
+    culler.RenderOccluders();
+}
+
+// Whether any pixel under the box's screen rectangle is at or behind its nearest depth, straight off the full
+// resolution buffer. Boxes the pyramid can't reason about count as visible, same as in the culler.
+bool IsBoxVisibleFlat(const OcclusionCuller& culler, const float viewProj[16], const float center[3], const float extents[3])
+{
+    const float width = float(culler.GetWidth()), height = float(culler.GetHeight());
+    float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX, nearestZ = FLT_MAX;
+    for (uint32_t corner = 0; corner != 8; ++corner)
+    {
+        const float p[3] =
+        {
+            center[0] + ((corner & 1) ? extents[0] : -extents[0]),
+            center[1] + ((corner & 2) ? extents[1] : -extents[1]),
+            center[2] + ((corner & 4) ? extents[2] : -extents[2]),
+        };
+        float clip[4];
+        for (uint32_t c = 0; c != 4; ++c)
+            clip[c] = p[0] * viewProj[c] + p[1] * viewProj[4 + c] + p[2] * viewProj[8 + c] + viewProj[12 + c];
+        if (clip[2] < 0.0f || clip[3] <= 0.0f)
+            return true;
+
+        minX = std::min(minX, (clip[0] / clip[3] * 0.5f + 0.5f) * width);
+        maxX = std::max(maxX, (clip[0] / clip[3] * 0.5f + 0.5f) * width);
+        minY = std::min(minY, (0.5f - clip[1] / clip[3] * 0.5f) * height);
+        maxY = std::max(maxY, (0.5f - clip[1] / clip[3] * 0.5f) * height);
+        nearestZ = std::min(nearestZ, clip[2] / clip[3]);
+    }
+
+    if (maxX < 0.0f || maxY < 0.0f || minX >= width || minY >= height)
+        return true;
+
+    const uint32_t x0 = static_cast<uint32_t>(std::max(minX, 0.0f)), x1 = std::min(static_cast<uint32_t>(maxX), culler.GetWidth() - 1);
+    const uint32_t y0 = static_cast<uint32_t>(std::max(minY, 0.0f)), y1 = std::min(static_cast<uint32_t>(maxY), culler.GetHeight() - 1);
+    for (uint32_t y = y0; y <= y1; ++y)
+    {
+        for (uint32_t x = x0; x <= x1; ++x)
+        {
+            if (nearestZ <= culler.GetPixelDepth(x, y))
+                return true;
+        }
+    }
+    return false;
+}
+}
+
+MUON_TEST(OcclusionCuller_DepthMatchesAnalytic)
+{
+    JobSystem::Init(3);
+
+    OcclusionCuller culler;
+    MUON_CHECK(culler.Init(64, 64));
+    OccluderMesh quad;
+    MUON_CHECK(MakeQuad(quad));
+
+    // Orthographic, x' = x / 2, y' = y / 2, z' = z / 10. Turned about y so its depth is (4 + x) / 10, the quad covers
+    // exactly the middle 32x32 pixels, and every pixel center is well clear of its edges.
+    const float ortho[16] =
+    {
+        0.5f, 0.0f, 0.0f, 0.0f,
+        0.0f, 0.5f, 0.0f, 0.0f,
+        0.0f, 0.0f, 0.1f, 0.0f,
+        0.0f, 0.0f, 0.0f, 1.0f
+    };
+    const float tilted[16] =
+    {
+        1.0f, 0.0f, 1.0f, 0.0f,
+        0.0f, 1.0f, 0.0f, 0.0f,
+        0.0f, 0.0f, 1.0f, 0.0f,
+        0.0f, 0.0f, 4.0f, 1.0f
+    };
+    culler.BeginFrame(ortho);
+    culler.AddOccluder(&quad, tilted);
+    culler.RenderOccluders();
+
+    float maxError = 0.0f;
+    bool outsideCleared = true;
+    for (uint32_t y = 0; y != 64; ++y)
+    {
+        for (uint32_t x = 0; x != 64; ++x)
+        {
+            const bool inside = x >= 16 && x < 48 && y >= 16 && y < 48;
+            const float worldX = ((x + 0.5f) / 64.0f * 2.0f - 1.0f) * 2.0f;
+            if (inside)
+                maxError = std::max(maxError, fabsf(culler.GetPixelDepth(x, y) - (4.0f + worldX) * 0.1f));
+            else
+                outsideCleared &= culler.GetPixelDepth(x, y) == 1.0f;
+        }
+    }
+    if (maxError > 1e-5f)
+        std::printf("    Max orthographic depth error %g\n", maxError);
+    MUON_CHECK(maxError <= 1e-5f);
+    MUON_CHECK(outsideCleared);
+    MUON_CHECK(culler.GetStats().NumOccluders == 1 && culler.GetStats().NumTriangles == 2);
+
+    // In perspective, a wall at z = 5 far wider than the view, so it's clipped to the screen everywhere and the
+    // depth is the same constant under every pixel. Another at z = 3 only covers the left half, and wins there.
+    float viewProj[16];
+    MakePerspective(1.0f, 1.0f, viewProj);
+    float farWall[16], nearWall[16];
+    const float farScale[3] = { 100.0f, 100.0f, 1.0f }, farTranslation[3] = { 0.0f, 0.0f, 5.0f };
+    const float nearScale[3] = { 3.0f, 3.0f, 1.0f }, nearTranslation[3] = { -3.0f, 0.0f, 3.0f };
+    MakeScaleTranslation(farScale, farTranslation, farWall);
+    MakeScaleTranslation(nearScale, nearTranslation, nearWall);
+
+    culler.BeginFrame(viewProj);
+    culler.AddOccluder(&quad, farWall);
+    culler.AddOccluder(&quad, nearWall);
+    culler.RenderOccluders();
+
+    maxError = 0.0f;
+    for (uint32_t y = 0; y != 64; ++y)
+    {
+        for (uint32_t x = 0; x != 64; ++x)
+        {
+            const float expected = PerspectiveDepth(x < 32 ? 3.0f : 5.0f);
+            maxError = std::max(maxError, fabsf(culler.GetPixelDepth(x, y) - expected));
+        }
+    }
+    if (maxError > 1e-5f)
+        std::printf("    Max perspective depth error %g\n", maxError);
+    MUON_CHECK(maxError <= 1e-5f);
+
+    // Boxes just in front of and just behind the far wall, away from the near one
+    const float extents[3] = { 0.25f, 0.25f, 0.25f };
+    const float inFront[3] = { 2.0f, 0.0f, 4.5f }, behind[3] = { 2.0f, 0.0f, 5.5f }, behindNear[3] = { -2.0f, 0.0f, 4.5f };
+    MUON_CHECK(culler.IsBoxVisible(inFront, extents));
+    MUON_CHECK(!culler.IsBoxVisible(behind, extents));
+    MUON_CHECK(!culler.IsBoxVisible(behindNear, extents));
+
+    culler.Destroy();
+    JobSystem::Destroy();
+}
+
+MUON_TEST(OcclusionCuller_PyramidIsConservative)
+{
+    JobSystem::Init(3);
+
+    Scene scene;
+    MUON_CHECK(MakeScene(48, 20000, 7, scene));
+
+    OcclusionCuller culler;
+    MUON_CHECK(culler.Init(256, 128));
+    RenderScene(scene, culler);
+
+    std::vector<uint32_t> visible;
+    culler.CullBoxes(scene.Boxes, scene.Candidates, visible);
+
+    // Anything the full resolution buffer shows must survive the pyramid
+    std::vector<uint8_t> survived(scene.Candidates.size(), 0);
+    for (uint32_t box : visible)
+        survived[box] = 1;
+
+    uint32_t numMissed = 0, numFlatHidden = 0;
+    for (uint32_t box : scene.Candidates)
+    {
+        const float center[3] = { scene.Boxes.CenterX[box], scene.Boxes.CenterY[box], scene.Boxes.CenterZ[box] };
+        const float extents[3] = { scene.Boxes.ExtentX[box], scene.Boxes.ExtentY[box], scene.Boxes.ExtentZ[box] };
+        if (!IsBoxVisibleFlat(culler, scene.ViewProj, center, extents))
+            numFlatHidden++;
+        else if (!survived[box])
+            numMissed++;
+    }
+
+    if (numMissed)
+        std::printf("    %u flat buffer visible boxes were culled\n", numMissed);
+    MUON_CHECK(numMissed == 0);
+
+    // And the scene is one where the pyramid actually culls, most of what the flat buffer can
+    const OcclusionStats& stats = culler.GetStats();
+    MUON_CHECK(stats.NumTested == scene.Candidates.size());
+    MUON_CHECK(stats.NumOccluded > 0 && stats.NumOccluded <= numFlatHidden);
+    MUON_CHECK(stats.NumOccluded * 2 > numFlatHidden);
+
+    culler.Destroy();
+    JobSystem::Destroy();
+}
+
+MUON_TEST(OcclusionCuller_SameAcrossThreadCounts)
+{
+    Scene scene;
+    MUON_CHECK(MakeScene(64, 20000, 11, scene));
+
+    // More bins and setup chunks than threads, and the other way around
+    const uint32_t threadCounts[] = { 1, 2, 3, 8 };
+    std::vector<float> referenceDepth;
+    std::vector<uint32_t> referenceVisible;
+    for (uint32_t numThreads : threadCounts)
+    {
+        JobSystem::Init(numThreads);
+
+        OcclusionCuller culler;
+        MUON_CHECK(culler.Init(200, 120));
+        RenderScene(scene, culler);
+
+        std::vector<float> depth;
+        depth.reserve(size_t(culler.GetWidth()) * culler.GetHeight());
+        for (uint32_t y = 0; y != culler.GetHeight(); ++y)
+        {
+            for (uint32_t x = 0; x != culler.GetWidth(); ++x)
+                depth.push_back(culler.GetPixelDepth(x, y));
+        }
+
+        std::vector<uint32_t> visible;
+        culler.CullBoxes(scene.Boxes, scene.Candidates, visible);
+
+        if (referenceDepth.empty())
+        {
+            referenceDepth = depth;
+            referenceVisible = visible;
+        }
+        else
+        {
+            const bool sameDepth = depth.size() == referenceDepth.size() && memcmp(depth.data(), referenceDepth.data(), depth.size() * sizeof(float)) == 0;
+            const bool sameVisible = visible == referenceVisible;
+            if (!sameDepth || !sameVisible)
+                std::printf("    %u threads differ from 1\n", JobSystem::GetSingleton().GetNumThreads());
+            MUON_CHECK(sameDepth);
+            MUON_CHECK(sameVisible);
+        }
+
+        culler.Destroy();
+        JobSystem::Destroy();
+    }
+}
+
+MUON_BENCHMARK(OcclusionCuller_RasterAndTest)
+{
+    JobSystem::Init();
+
+    struct Config
+    {
+        size_t NumOccluders;
+        size_t NumBoxes;
+    };
+    const Config configs[] = { { 64, 10000 }, { 256, 100000 } };
+
+    for (const Config& config : configs)
+    {
+        Scene scene;
+        MakeScene(config.NumOccluders, config.NumBoxes, 1, scene);
+
+        OcclusionCuller culler;
+        culler.Init(256, 128);
+
+        std::vector<uint32_t> visible;
+        visible.reserve(config.NumBoxes);
+        const BenchmarkResult raster = RunBenchmark(20, [&]() { RenderScene(scene, culler); });
+        const BenchmarkResult test = RunBenchmark(20, [&]() { culler.CullBoxes(scene.Boxes, scene.Candidates, visible); });
+        const OcclusionStats& stats = culler.GetStats();
+
+        char label[96];
+        std::snprintf(label, sizeof(label), "Raster, %zu occluders, %u triangles", config.NumOccluders, stats.NumTriangles);
+        PrintBenchmark(label, raster, (double)stats.NumTriangles, "triangles");
+        std::snprintf(label, sizeof(label), "Box test, %zu boxes, %u occluded", config.NumBoxes, stats.NumOccluded);
+        PrintBenchmark(label, test, (double)config.NumBoxes, "boxes");
+
+        culler.Destroy();
+    }
+
+    std::printf("    %u threads\n", JobSystem::GetSingleton().GetNumThreads());
+    JobSystem::Destroy();
+}
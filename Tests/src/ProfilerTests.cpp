@@ -0,0 +1,468 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Nesting, counting, overrun and trace export tests and marker cost benchmark for the CPU profiler
+----------------------------------------------*/
+#include "TestFramework.h"
+
+#include <Core/BinaryStream.h>
+#include <Core/PathMacros.h>
+#include <Core/Profiler.h>
+
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <stdlib.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+using namespace Muon;
+
+static const wchar_t* kTracePath = CACHEPATHW L"Tests/Profiler/trace.json";
+
+// Just enough JSON to check the trace is well formed and read its events back
+struct JsonValue
+{
+    enum Kind { Null, Bool, Number, String, Array, Object } Type = Null;
+    double Num = 0.0;
+    std::string Str;
+    std::vector<JsonValue> Items;
+    std::map<std::string, JsonValue> Members;
+
+    const JsonValue* Find(const char* key) const
+    {
+        auto it = Members.find(key);
+        return it != Members.end() ? &it->second : nullptr;
+    }
+};
+
+class JsonReader
+{
+public:
+    explicit JsonReader(const std::string& text) : mText(text) {}
+
+    // The whole text has to be exactly one value
+    bool ParseDocument(JsonValue& out_value)
+    {
+        if (!ParseValue(out_value))
+            return false;
+        SkipSpace();
+        return mPos == mText.size();
+    }
+
+private:
+    void SkipSpace()
+    {
+        while (mPos < mText.size() && (mText[mPos] == ' ' || mText[mPos] == '\n' || mText[mPos] == '\r' || mText[mPos] == '\t'))
+            ++mPos;
+    }
+
+    bool Consume(char c)
+    {
+        SkipSpace();
+        if (mPos < mText.size() && mText[mPos] == c)
+        {
+            ++mPos;
+            return true;
+        }
+        return false;
+    }
+
+    bool ParseString(std::string& out_str)
+    {
+        if (!Consume('"'))
+            return false;
+        while (mPos < mText.size() && mText[mPos] != '"')
+        {
+            char c = mText[mPos++];
+            if (static_cast<unsigned char>(c) < 0x20)
+                return false;
+            if (c == '\\')
+            {
+                if (mPos == mText.size())
+                    return false;
+                c = mText[mPos++];
+                if (c != '"' && c != '\\' && c != '/')
+                    return false; // The writer never needs any other escape
+            }
+            out_str += c;
+        }
+        return Consume('"');
+    }
+
+    bool ParseValue(JsonValue& out_value)
+    {
+        SkipSpace();
+        if (mPos == mText.size())
+            return false;
+
+        const char c = mText[mPos];
+        if (c == '{')
+        {
+            ++mPos;
+            out_value.Type = JsonValue::Object;
+            if (Consume('}'))
+                return true;
+            do
+            {
+                std::string key;
+                if (!ParseString(key) || !Consume(':') || !ParseValue(out_value.Members[key]))
+                    return false;
+            } while (Consume(','));
+            return Consume('}');
+        }
+        if (c == '[')
+        {
+            ++mPos;
+            out_value.Type = JsonValue::Array;
+            if (Consume(']'))
+                return true;
+            do
+            {
+                out_value.Items.emplace_back();
+                if (!ParseValue(out_value.Items.back()))
+                    return false;
+            } while (Consume(','));
+            return Consume(']');
+        }
+        if (c == '"')
+        {
+            out_value.Type = JsonValue::String;
+            return ParseString(out_value.Str);
+        }
+        if (mText.compare(mPos, 4, "true") == 0 || mText.compare(mPos, 4, "null") == 0)
+        {
+            out_value.Type = c == 't' ? JsonValue::Bool : JsonValue::Null;
+            mPos += 4;
+            return true;
+        }
+        if (mText.compare(mPos, 5, "false") == 0)
+        {
+            out_value.Type = JsonValue::Bool;
+            mPos += 5;
+            return true;
+        }
+
+        char* end = nullptr;
+        out_value.Type = JsonValue::Number;
+        out_value.Num = strtod(mText.c_str() + mPos, &end);
+        if (end == mText.c_str() + mPos)
+            return false;
+        mPos = end - mText.c_str();
+        return true;
+    }
+
+    const std::string& mText;
+    size_t mPos = 0;
+};
+
+struct TraceEvent
+{
+    std::string Name;
+    double Tid, Ts, Dur;
+};
+
+// Writes the trace and reads it back. Fails if it isn't valid JSON or an event is missing a field.
+bool ReadTrace(std::vector<TraceEvent>& out_events, std::map<double, std::string>& out_threadNames)
+{
+    std::vector<uint8_t> bytes;
+    if (!Profiler::GetSingleton().WriteChromeTrace(kTracePath) || !LoadFileBytes(kTracePath, bytes))
+        return false;
+
+    const std::string text(bytes.begin(), bytes.end());
+    JsonValue root;
+    JsonReader reader(text);
+    if (!reader.ParseDocument(root))
+    {
+        std::printf("    The trace isn't valid JSON\n");
+        return false;
+    }
+
+    const JsonValue* pEvents = root.Find("traceEvents");
+    if (!pEvents || pEvents->Type != JsonValue::Array)
+        return false;
+
+    out_events.clear();
+    out_threadNames.clear();
+    for (const JsonValue& event : pEvents->Items)
+    {
+        const JsonValue* ph = event.Find("ph");
+        const JsonValue* name = event.Find("name");
+        const JsonValue* tid = event.Find("tid");
+        if (!ph || !name || !tid || name->Type != JsonValue::String || tid->Type != JsonValue::Number)
+            return false;
+
+        if (ph->Str == "M")
+        {
+            const JsonValue* args = event.Find("args");
+            const JsonValue* threadName = args ? args->Find("name") : nullptr;
+            if (!threadName || threadName->Type != JsonValue::String)
+                return false;
+            out_threadNames[tid->Num] = threadName->Str;
+            continue;
+        }
+
+        const JsonValue* ts = event.Find("ts");
+        const JsonValue* dur = event.Find("dur");
+        if (ph->Str != "X" || !ts || !dur || ts->Type != JsonValue::Number || dur->Type != JsonValue::Number)
+            return false;
+        out_events.push_back({ name->Str, tid->Num, ts->Num, dur->Num });
+    }
+    return true;
+}
+
+const ProfileScopeStats* FindStats(const std::vector<ProfileScopeStats>& stats, const char* name)
+{
+    for (const ProfileScopeStats& scope : stats)
+    {
+        if (scope.Name == name)
+            return &scope;
+    }
+    return nullptr;
+}
+
+const TraceEvent* FindEvent(const std::vector<TraceEvent>& events, const char* name, size_t nth = 0)
+{
+    for (const TraceEvent& event : events)
+    {
+        if (event.Name == name && nth-- == 0)
+            return &event;
+    }
+    return nullptr;
+}
+
+// Times are written in microseconds to the nanosecond, so scopes that end on the same tick can round either way
+bool Contains(const TraceEvent* pOuter, const TraceEvent* pInner)
+{
+    const double kTolerance = 1e-3;
+    return pOuter && pInner && pOuter->Tid == pInner->Tid && pOuter->Ts <= pInner->Ts + kTolerance &&
+        pInner->Ts + pInner->Dur <= pOuter->Ts + pOuter->Dur + kTolerance;
+}
+
+void RecordScopes(const char* name, uint32_t count)
+{
+    for (uint32_t i = 0; i != count; ++i)
+        MUON_PROFILE_SCOPE(name);
+}
+
+void SpinFor(uint32_t microseconds)
+{
+    const auto end = std::chrono::steady_clock::now() + std::chrono::microseconds(microseconds);
+    while (std::chrono::steady_clock::now() < end)
+    {
+    }
+}
+}
+
+MUON_TEST(Profiler_NestingAndTrace)
+{
+    Profiler::Init(8);
+    Profiler& profiler = Profiler::GetSingleton();
+    Profiler::SetThreadName("Main \"render\" \\ thread");
+
+    profiler.BeginFrame();
+    {
+        MUON_PROFILE_SCOPE("Outer");
+        SpinFor(50);
+        {
+            MUON_PROFILE_SCOPE("Inner");
+            SpinFor(100);
+        }
+        {
+            MUON_PROFILE_SCOPE("Inner");
+            SpinFor(100);
+        }
+    }
+
+    // Recorded on a thread of its own, so it gets its own track
+    std::thread worker([]()
+    {
+        Profiler::SetThreadName("Worker");
+        MUON_PROFILE_SCOPE("Job");
+        SpinFor(50);
+    });
+    worker.join();
+    profiler.EndFrame();
+
+    std::vector<TraceEvent> events;
+    std::map<double, std::string> threadNames;
+    MUON_CHECK(ReadTrace(events, threadNames));
+    MUON_CHECK(events.size() == 5);
+
+    // Children lie inside their parents on the same track, and siblings don't overlap
+    const TraceEvent* pFrame = FindEvent(events, "Frame");
+    const TraceEvent* pOuter = FindEvent(events, "Outer");
+    const TraceEvent* pFirst = FindEvent(events, "Inner", 0);
+    const TraceEvent* pSecond = FindEvent(events, "Inner", 1);
+    const TraceEvent* pJob = FindEvent(events, "Job");
+    MUON_CHECK(Contains(pFrame, pOuter));
+    MUON_CHECK(Contains(pOuter, pFirst));
+    MUON_CHECK(Contains(pOuter, pSecond));
+    MUON_CHECK(pFirst && pSecond && pFirst->Ts + pFirst->Dur <= pSecond->Ts + 1e-3);
+    MUON_CHECK(pJob && pFrame && pJob->Tid != pFrame->Tid);
+
+    // Names go through JSON escaping intact
+    MUON_CHECK(pFrame && threadNames[pFrame->Tid] == "Main \"render\" \\ thread");
+    MUON_CHECK(pJob && threadNames[pJob->Tid] == "Worker");
+
+    std::vector<ProfileScopeStats> stats;
+    profiler.GetSummary(stats);
+    const ProfileScopeStats* pOuterStats = FindStats(stats, "Outer");
+    const ProfileScopeStats* pInnerStats = FindStats(stats, "Inner");
+    MUON_CHECK(pOuterStats && pInnerStats && pOuterStats->AvgMs >= pInnerStats->AvgMs);
+
+    Profiler::Destroy();
+}
+
+MUON_TEST(Profiler_CallCounts)
+{
+    Profiler::Init(8);
+    Profiler& profiler = Profiler::GetSingleton();
+
+    // A is hit 3 and then 5 times, B only in the first frame
+    profiler.BeginFrame();
+    RecordScopes("A", 3);
+    RecordScopes("B", 1);
+    profiler.EndFrame();
+
+    profiler.BeginFrame();
+    RecordScopes("A", 5);
+    Profiler::SetEnabled(false);
+    RecordScopes("A", 100); // Not recorded while disabled
+    Profiler::SetEnabled(true);
+    profiler.EndFrame();
+
+    // Outside of a frame it's picked up by the next one
+    RecordScopes("C", 2);
+    profiler.BeginFrame();
+    profiler.EndFrame();
+
+    std::vector<ProfileScopeStats> stats;
+    profiler.GetSummary(stats);
+    const ProfileScopeStats* pA = FindStats(stats, "A");
+    const ProfileScopeStats* pB = FindStats(stats, "B");
+    const ProfileScopeStats* pC = FindStats(stats, "C");
+    const ProfileScopeStats* pFrame = FindStats(stats, "Frame");
+    MUON_CHECK(stats.size() == 4);
+    MUON_CHECK(pA && pA->NumFrames == 2 && pA->AvgCalls == 4.0);
+    MUON_CHECK(pB && pB->NumFrames == 1 && pB->AvgCalls == 1.0);
+    MUON_CHECK(pC && pC->NumFrames == 1 && pC->AvgCalls == 2.0);
+    MUON_CHECK(pFrame && pFrame->NumFrames == 3 && pFrame->AvgCalls == 1.0);
+    MUON_CHECK(profiler.GetNumFrames() == 3 && profiler.GetNumDroppedEvents() == 0);
+
+    // Only the last few frames are kept
+    for (uint32_t f = 0; f != 10; ++f)
+    {
+        profiler.BeginFrame();
+        profiler.EndFrame();
+    }
+    profiler.GetSummary(stats);
+    pFrame = FindStats(stats, "Frame");
+    MUON_CHECK(stats.size() == 1 && pFrame && pFrame->NumFrames == 8);
+
+    Profiler::Destroy();
+}
+
+MUON_TEST(Profiler_RingOverrunDrops)
+{
+    Profiler::Init(4);
+    Profiler& profiler = Profiler::GetSingleton();
+
+    // Far more than a thread's ring holds between two EndFrames
+    const uint32_t numScopes = 50000;
+    profiler.BeginFrame();
+    RecordScopes("Spam", numScopes);
+    profiler.EndFrame();
+
+    std::vector<ProfileScopeStats> stats;
+    profiler.GetSummary(stats);
+    const ProfileScopeStats* pSpam = FindStats(stats, "Spam");
+    const ProfileScopeStats* pFrame = FindStats(stats, "Frame");
+
+    // The oldest are dropped and counted, so nothing goes missing silently, and the newest survive
+    const uint64_t numKept = pSpam ? uint64_t(pSpam->AvgCalls) : 0;
+    MUON_CHECK(pSpam && numKept > 0 && numKept < numScopes);
+    MUON_CHECK(pFrame && pFrame->AvgCalls == 1.0);
+    MUON_CHECK(profiler.GetNumDroppedEvents() > 0);
+    MUON_CHECK(numKept + 1 + profiler.GetNumDroppedEvents() == numScopes + 1);
+
+    // A frame that fits doesn't drop anything more
+    const uint64_t numDropped = profiler.GetNumDroppedEvents();
+    profiler.BeginFrame();
+    RecordScopes("Spam", 10);
+    profiler.EndFrame();
+    profiler.GetSummary(stats);
+    pSpam = FindStats(stats, "Spam");
+    MUON_CHECK(profiler.GetNumDroppedEvents() == numDropped);
+    MUON_CHECK(pSpam && pSpam->NumFrames == 2 && pSpam->AvgCalls == (numKept + 10) / 2.0);
+
+    Profiler::Destroy();
+}
+
+MUON_TEST(Profiler_ReinitAfterDestroy)
+{
+    Profiler::Init(4);
+    Profiler::SetThreadName("First");
+    Profiler::GetSingleton().BeginFrame();
+    RecordScopes("Before", 3);
+    std::thread([]() { RecordScopes("Before", 1); }).join();
+    Profiler::GetSingleton().EndFrame();
+
+    // A scope that's still open when the profiler goes away has nowhere to go, and markers are ignored until the next Init
+    {
+        MUON_PROFILE_SCOPE("Straddling");
+        Profiler::Destroy();
+        MUON_CHECK(!Profiler::IsInitialized() && !Profiler::IsEnabled());
+    }
+    RecordScopes("Between", 3);
+    Profiler::SetEnabled(true);
+    MUON_CHECK(!Profiler::IsEnabled());
+
+    // The threads' cached buffers belonged to the old profiler, so they register again from scratch
+    Profiler::Init(4);
+    Profiler& profiler = Profiler::GetSingleton();
+    MUON_CHECK(Profiler::IsEnabled() && profiler.GetNumFrames() == 0);
+    profiler.BeginFrame();
+    RecordScopes("After", 2);
+    profiler.EndFrame();
+
+    std::vector<ProfileScopeStats> stats;
+    profiler.GetSummary(stats);
+    const ProfileScopeStats* pAfter = FindStats(stats, "After");
+    MUON_CHECK(stats.size() == 2 && pAfter && pAfter->AvgCalls == 2.0);
+    MUON_CHECK(!FindStats(stats, "Before") && !FindStats(stats, "Between") && !FindStats(stats, "Straddling"));
+
+    std::vector<TraceEvent> events;
+    std::map<double, std::string> threadNames;
+    MUON_CHECK(ReadTrace(events, threadNames));
+    MUON_CHECK(threadNames.size() == 1 && threadNames[0] == "Thread 0");
+    MUON_CHECK(events.size() == 3);
+
+    Profiler::Destroy();
+}
+
+MUON_BENCHMARK(Profiler_MarkerCost)
+{
+    const uint32_t numMarkers = 1000000;
+    auto runMarkers = [numMarkers]() { RecordScopes("Marker", numMarkers); };
+
+    // Uninitialized and disabled both take the same early out, one relaxed load per marker
+    const BenchmarkResult uninitialized = RunBenchmark(10, runMarkers);
+
+    Profiler::Init();
+    Profiler::SetEnabled(false);
+    const BenchmarkResult disabled = RunBenchmark(10, runMarkers);
+
+    // Enabled, every marker reads the clock twice and writes an event. The ring wraps, which costs the same.
+    Profiler::SetEnabled(true);
+    const BenchmarkResult enabled = RunBenchmark(10, runMarkers);
+    Profiler::Destroy();
+
+    PrintBenchmark("Markers, uninitialized", uninitialized, numMarkers, "markers");
+    PrintBenchmark("Markers, disabled", disabled, numMarkers, "markers");
+    PrintBenchmark("Markers, enabled", enabled, numMarkers, "markers");
+    std::printf("    %.2f ns per disabled marker, %.2f ns per enabled one\n", disabled.MedianMs * 1e6 / numMarkers, enabled.MedianMs * 1e6 / numMarkers);
+}
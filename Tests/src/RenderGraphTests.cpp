@@ -0,0 +1,445 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Tests and compile benchmark for the render graph compiler
+----------------------------------------------*/
+#include "TestFramework.h"
+
+#include <Core/RenderGraph.h>
+
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace
+{
+using namespace Muon;
+
+RGTextureDesc MakeDesc(uint32_t width, uint32_t height)
+{
+    RGTextureDesc desc;
+    desc.Width = width;
+    desc.Height = height;
+    return desc;
+}
+
+std::vector<uint32_t> GetPositions(const RenderGraph& graph, size_t numPasses)
+{
+    std::vector<uint32_t> positions(numPasses, RG_INVALID_HANDLE);
+    const std::vector<RGCompiledPass>& compiled = graph.GetCompiledPasses();
+    for (uint32_t i = 0; i != compiled.size(); ++i)
+        positions[compiled[i].Pass] = i;
+    return positions;
+}
+
+// Checks everything a compiled graph has to guarantee, whatever was declared:
+// - every surviving pass runs exactly once and culled passes don't run
+// - passes touching the same resource, at least one of them writing, keep their declaration order
+// - replaying the barriers, every pass finds its resources in a state covering its access, each barrier starts from the
+//   current state, and the frame ends with imports in their final state and transients back in their initial one
+// - transients sharing heap memory have disjoint lifetimes, and each of them gets an aliasing barrier before first use
+void ValidateCompiledGraph(const RenderGraph& graph, size_t numPasses)
+{
+    const std::vector<RenderGraph::Resource>& resources = graph.GetResources();
+    const std::vector<RGCompiledPass>& compiled = graph.GetCompiledPasses();
+    const std::vector<RGBarrier>& barriers = graph.GetBarriers();
+    const std::vector<uint32_t> positions = GetPositions(graph, numPasses);
+
+    size_t numAlive = 0;
+    for (RGPassHandle p = 0; p != numPasses; ++p)
+    {
+        const bool culled = graph.GetPass(p).Culled;
+        numAlive += culled ? 0 : 1;
+        MUON_CHECK(culled == (positions[p] == RG_INVALID_HANDLE));
+    }
+    MUON_CHECK(compiled.size() == numAlive);
+
+    for (RGPassHandle a = 0; a != numPasses; ++a)
+    {
+        for (RGPassHandle b = a + 1; b != numPasses; ++b)
+        {
+            if (positions[a] == RG_INVALID_HANDLE || positions[b] == RG_INVALID_HANDLE)
+                continue;
+
+            bool hazard = false;
+            for (const RenderGraph::Access& accessA : graph.GetPass(a).Accesses)
+            {
+                for (const RenderGraph::Access& accessB : graph.GetPass(b).Accesses)
+                {
+                    hazard |= accessA.Resource == accessB.Resource &&
+                        ((accessA.Flags | accessB.Flags) & RG_ACCESS_WRITE_MASK) != 0;
+                }
+            }
+            hazard |= graph.GetPass(a).SideEffects && graph.GetPass(b).SideEffects;
+
+            if (hazard)
+                MUON_CHECK(positions[a] < positions[b]);
+        }
+    }
+
+    std::vector<uint32_t> state(resources.size());
+    std::vector<bool> aliasingSeen(resources.size(), false);
+    std::vector<bool> touched(resources.size(), false);
+    for (size_t r = 0; r != resources.size(); ++r)
+        state[r] = resources[r].InitialAccess;
+
+    uint32_t expectedFirstBarrier = 0;
+    for (const RGCompiledPass& pass : compiled)
+    {
+        MUON_CHECK(pass.FirstBarrier == expectedFirstBarrier);
+        expectedFirstBarrier += pass.NumBarriers;
+
+        for (uint32_t i = 0; i != pass.NumBarriers && pass.FirstBarrier + i < barriers.size(); ++i)
+        {
+            const RGBarrier& barrier = barriers[pass.FirstBarrier + i];
+            if (barrier.BarrierType == RGBarrier::Aliasing)
+            {
+                MUON_CHECK(!touched[barrier.Resource]);
+                aliasingSeen[barrier.Resource] = true;
+                continue;
+            }
+
+            MUON_CHECK(barrier.Before == state[barrier.Resource]);
+            if (barrier.BarrierType == RGBarrier::UAV)
+                MUON_CHECK((barrier.Before & RG_ACCESS_UNORDERED_ACCESS) && barrier.Before == barrier.After);
+            else
+                MUON_CHECK(barrier.Before != barrier.After);
+            state[barrier.Resource] = barrier.After;
+        }
+
+        for (const RenderGraph::Access& access : graph.GetPass(pass.Pass).Accesses)
+        {
+            MUON_CHECK((access.Flags & ~state[access.Resource]) == 0);
+            touched[access.Resource] = true;
+        }
+    }
+    MUON_CHECK(expectedFirstBarrier == barriers.size());
+
+    for (const RGBarrier& barrier : graph.GetFinalBarriers())
+    {
+        MUON_CHECK(resources[barrier.Resource].Imported);
+        MUON_CHECK(barrier.Before == state[barrier.Resource]);
+        state[barrier.Resource] = barrier.After;
+    }
+
+    uint64_t heapSize = 0;
+    for (size_t r = 0; r != resources.size(); ++r)
+    {
+        const RenderGraph::Resource& resource = resources[r];
+        MUON_CHECK(state[r] == (resource.Imported ? resource.FinalAccess : resource.InitialAccess));
+        if (resource.Imported || !resource.Used)
+            continue;
+
+        heapSize = std::max(heapSize, resource.HeapOffset + resource.Size);
+        MUON_CHECK(aliasingSeen[r] == resource.Aliases);
+
+        for (size_t o = r + 1; o != resources.size(); ++o)
+        {
+            const RenderGraph::Resource& other = resources[o];
+            if (other.Imported || !other.Used)
+                continue;
+
+            const bool memoryOverlaps = resource.HeapOffset < other.HeapOffset + other.Size && other.HeapOffset < resource.HeapOffset + resource.Size;
+            const bool lifetimeOverlaps = resource.FirstUse <= other.LastUse && other.FirstUse <= resource.LastUse;
+            MUON_CHECK(!(memoryOverlaps && lifetimeOverlaps));
+            if (memoryOverlaps)
+                MUON_CHECK(resource.Aliases && other.Aliases);
+        }
+    }
+
+    const RGCompileStats& stats = graph.GetCompileStats();
+    MUON_CHECK(stats.TransientBytes == heapSize);
+    MUON_CHECK(stats.TransientBytes <= stats.UnaliasedBytes);
+    MUON_CHECK(stats.NumPasses == compiled.size());
+    MUON_CHECK(stats.NumCulledPasses == numPasses - compiled.size());
+    MUON_CHECK(stats.NumBarriers == barriers.size() + graph.GetFinalBarriers().size());
+}
+
+// A frame-like graph: a depth prepass, chains of full screen passes over transients, some dead branches and a final composite
+void BuildRandomGraph(RenderGraph& graph, std::mt19937& rng, uint32_t numPasses, uint32_t numTransients)
+{
+    static const uint32_t kWriteAccesses[] = { RG_ACCESS_RENDER_TARGET, RG_ACCESS_UNORDERED_ACCESS, RG_ACCESS_COPY_DEST, RG_ACCESS_DEPTH_WRITE };
+    static const uint32_t kReadAccesses[] = { RG_ACCESS_SHADER_READ, RG_ACCESS_COPY_SOURCE, RG_ACCESS_DEPTH_READ };
+
+    graph.Reset();
+    const RGResourceHandle backBuffer = graph.ImportTexture("BackBuffer", MakeDesc(1920, 1080), RG_ACCESS_PRESENT, RG_ACCESS_PRESENT);
+    const RGResourceHandle history = graph.ImportTexture("History", MakeDesc(1920, 1080), RG_ACCESS_SHADER_READ, RG_ACCESS_SHADER_READ);
+
+    std::vector<RGResourceHandle> transients;
+    for (uint32_t i = 0; i != numTransients; ++i)
+    {
+        const uint32_t scale = 1u << (rng() % 3);
+        transients.push_back(graph.CreateTexture("Transient", MakeDesc(1920 / scale, 1080 / scale)));
+    }
+
+    auto pick = [&](uint32_t range) { return static_cast<uint32_t>(rng() % range); };
+    for (uint32_t p = 0; p + 1 < numPasses; ++p)
+    {
+        const RGPassHandle pass = graph.AddPass("Pass", nullptr);
+
+        const uint32_t numReads = pick(3);
+        for (uint32_t i = 0; i != numReads; ++i)
+            graph.Read(pass, transients[pick(numTransients)], kReadAccesses[pick(3)]);
+
+        if (pick(8) == 0)
+            graph.Read(pass, history, RG_ACCESS_SHADER_READ);
+
+        const uint32_t numWrites = 1 + pick(2);
+        for (uint32_t i = 0; i != numWrites; ++i)
+            graph.Write(pass, transients[pick(numTransients)], kWriteAccesses[pick(4)]);
+
+        if (pick(16) == 0)
+            graph.Write(pass, history, RG_ACCESS_RENDER_TARGET);
+        if (pick(32) == 0)
+            graph.SetSideEffects(pass);
+    }
+
+    const RGPassHandle composite = graph.AddPass("Composite", nullptr);
+    for (uint32_t i = 0; i != 4; ++i)
+        graph.Read(composite, transients[pick(numTransients)], RG_ACCESS_SHADER_READ);
+    graph.Write(composite, backBuffer, RG_ACCESS_RENDER_TARGET);
+}
+}
+
+MUON_TEST(RenderGraph_CullsDeadPasses)
+{
+    RenderGraph graph;
+    const RGTextureDesc desc = MakeDesc(1024, 1024);
+    const RGResourceHandle backBuffer = graph.ImportTexture("BackBuffer", desc, RG_ACCESS_PRESENT, RG_ACCESS_PRESENT);
+    const RGResourceHandle a = graph.CreateTexture("A", desc);
+    const RGResourceHandle b = graph.CreateTexture("B", desc);
+    const RGResourceHandle unused = graph.CreateTexture("Unused", desc);
+    const RGResourceHandle deadInput = graph.CreateTexture("DeadInput", desc);
+    const RGResourceHandle readback = graph.CreateTexture("Readback", desc);
+
+    const RGPassHandle writeA = graph.AddPass("WriteA", nullptr);
+    graph.Write(writeA, a, RG_ACCESS_RENDER_TARGET);
+
+    // Only feeds a pass that is dead itself, so it goes too
+    const RGPassHandle feedsDead = graph.AddPass("FeedsDead", nullptr);
+    graph.Write(feedsDead, deadInput, RG_ACCESS_RENDER_TARGET);
+
+    const RGPassHandle dead = graph.AddPass("Dead", nullptr);
+    graph.Read(dead, deadInput, RG_ACCESS_SHADER_READ);
+    graph.Write(dead, unused, RG_ACCESS_RENDER_TARGET);
+
+    const RGPassHandle sideEffects = graph.AddPass("Readback", nullptr);
+    graph.Write(sideEffects, readback, RG_ACCESS_COPY_DEST);
+    graph.SetSideEffects(sideEffects);
+
+    const RGPassHandle writeB = graph.AddPass("WriteB", nullptr);
+    graph.Read(writeB, a, RG_ACCESS_SHADER_READ);
+    graph.Write(writeB, b, RG_ACCESS_RENDER_TARGET);
+
+    const RGPassHandle composite = graph.AddPass("Composite", nullptr);
+    graph.Read(composite, b, RG_ACCESS_SHADER_READ);
+    graph.Write(composite, backBuffer, RG_ACCESS_RENDER_TARGET);
+
+    MUON_CHECK(graph.Compile());
+    MUON_CHECK(!graph.GetPass(writeA).Culled);
+    MUON_CHECK(graph.GetPass(feedsDead).Culled);
+    MUON_CHECK(graph.GetPass(dead).Culled);
+    MUON_CHECK(!graph.GetPass(sideEffects).Culled);
+    MUON_CHECK(!graph.GetPass(writeB).Culled);
+    MUON_CHECK(!graph.GetPass(composite).Culled);
+    MUON_CHECK(graph.GetCompileStats().NumCulledPasses == 2);
+
+    // Culled passes don't keep their resources alive
+    MUON_CHECK(!graph.GetResources()[unused].Used);
+    MUON_CHECK(!graph.GetResources()[deadInput].Used);
+    ValidateCompiledGraph(graph, 6);
+}
+
+MUON_TEST(RenderGraph_OrdersByHazards)
+{
+    RenderGraph graph;
+    const RGTextureDesc desc = MakeDesc(256, 256);
+    const RGResourceHandle backBuffer = graph.ImportTexture("BackBuffer", desc, RG_ACCESS_PRESENT, RG_ACCESS_PRESENT);
+    const RGResourceHandle a = graph.CreateTexture("A", desc);
+    const RGResourceHandle b = graph.CreateTexture("B", desc);
+    const RGResourceHandle a2 = graph.CreateTexture("A2", desc);
+    const RGResourceHandle b2 = graph.CreateTexture("B2", desc);
+
+    // Two independent chains declared breadth first. Consumers of the newest result run first, so A finishes before B starts.
+    const RGPassHandle produceA = graph.AddPass("ProduceA", nullptr);
+    graph.Write(produceA, a, RG_ACCESS_RENDER_TARGET);
+    const RGPassHandle produceB = graph.AddPass("ProduceB", nullptr);
+    graph.Write(produceB, b, RG_ACCESS_RENDER_TARGET);
+    const RGPassHandle consumeA = graph.AddPass("ConsumeA", nullptr);
+    graph.Read(consumeA, a, RG_ACCESS_SHADER_READ);
+    graph.Write(consumeA, a2, RG_ACCESS_RENDER_TARGET);
+    const RGPassHandle consumeB = graph.AddPass("ConsumeB", nullptr);
+    graph.Read(consumeB, b, RG_ACCESS_SHADER_READ);
+    graph.Write(consumeB, b2, RG_ACCESS_RENDER_TARGET);
+
+    // Write after read: overwriting A has to wait for ConsumeA
+    const RGPassHandle overwriteA = graph.AddPass("OverwriteA", nullptr);
+    graph.Write(overwriteA, a, RG_ACCESS_UNORDERED_ACCESS);
+
+    const RGPassHandle composite = graph.AddPass("Composite", nullptr);
+    graph.Read(composite, a, RG_ACCESS_SHADER_READ);
+    graph.Read(composite, a2, RG_ACCESS_SHADER_READ);
+    graph.Read(composite, b2, RG_ACCESS_SHADER_READ);
+    graph.Write(composite, backBuffer, RG_ACCESS_RENDER_TARGET);
+
+    MUON_CHECK(graph.Compile());
+    const std::vector<uint32_t> positions = GetPositions(graph, 6);
+    MUON_CHECK(positions[produceA] < positions[consumeA]);
+    MUON_CHECK(positions[produceB] < positions[consumeB]);
+    MUON_CHECK(positions[consumeA] < positions[overwriteA]);
+    MUON_CHECK(positions[consumeA] < positions[produceB]);
+    MUON_CHECK(positions[composite] == 5);
+    ValidateCompiledGraph(graph, 6);
+}
+
+MUON_TEST(RenderGraph_DerivesBarriers)
+{
+    RenderGraph graph;
+    const RGTextureDesc desc = MakeDesc(512, 512);
+    const RGResourceHandle backBuffer = graph.ImportTexture("BackBuffer", desc, RG_ACCESS_PRESENT, RG_ACCESS_PRESENT);
+    const RGResourceHandle depth = graph.ImportTexture("Depth", desc, RG_ACCESS_DEPTH_WRITE, RG_ACCESS_DEPTH_WRITE);
+    const RGResourceHandle color = graph.CreateTexture("Color", desc);
+
+    const RGPassHandle prepass = graph.AddPass("Prepass", nullptr);
+    graph.Write(prepass, depth, RG_ACCESS_DEPTH_WRITE);
+
+    // Two UAV passes back to back need a UAV barrier between them, not a transition
+    const RGPassHandle simulate0 = graph.AddPass("Simulate0", nullptr);
+    graph.Write(simulate0, color, RG_ACCESS_UNORDERED_ACCESS);
+    const RGPassHandle simulate1 = graph.AddPass("Simulate1", nullptr);
+    graph.Write(simulate1, color, RG_ACCESS_UNORDERED_ACCESS);
+
+    // Consecutive reads share one combined state
+    const RGPassHandle read0 = graph.AddPass("Read0", nullptr);
+    graph.Read(read0, color, RG_ACCESS_SHADER_READ);
+    graph.Read(read0, depth, RG_ACCESS_DEPTH_READ);
+    graph.Write(read0, backBuffer, RG_ACCESS_RENDER_TARGET);
+    const RGPassHandle read1 = graph.AddPass("Read1", nullptr);
+    graph.Read(read1, color, RG_ACCESS_COPY_SOURCE);
+    graph.Read(read1, depth, RG_ACCESS_SHADER_READ);
+    graph.Write(read1, backBuffer, RG_ACCESS_RENDER_TARGET);
+
+    MUON_CHECK(graph.Compile());
+    ValidateCompiledGraph(graph, 5);
+
+    const std::vector<RGCompiledPass>& compiled = graph.GetCompiledPasses();
+    const std::vector<RGBarrier>& barriers = graph.GetBarriers();
+    if (compiled.size() != 5)
+        return;
+
+    // The prepass finds depth in its imported state already
+    MUON_CHECK(compiled[0].NumBarriers == 0);
+
+    MUON_CHECK(compiled[2].NumBarriers == 1);
+    MUON_CHECK(barriers[compiled[2].FirstBarrier].BarrierType == RGBarrier::UAV);
+
+    // Read0 moves color and depth into their combined read states up front, Read1 needs no further transition for them
+    uint32_t colorState = 0, depthState = 0;
+    for (uint32_t i = 0; i != compiled[3].NumBarriers; ++i)
+    {
+        const RGBarrier& barrier = barriers[compiled[3].FirstBarrier + i];
+        if (barrier.Resource == color)
+            colorState = barrier.After;
+        if (barrier.Resource == depth)
+            depthState = barrier.After;
+    }
+    MUON_CHECK(colorState == (RG_ACCESS_SHADER_READ | RG_ACCESS_COPY_SOURCE));
+    MUON_CHECK(depthState == (RG_ACCESS_DEPTH_READ | RG_ACCESS_SHADER_READ));
+    for (uint32_t i = 0; i != compiled[4].NumBarriers; ++i)
+        MUON_CHECK(barriers[compiled[4].FirstBarrier + i].Resource == backBuffer);
+
+    // Imports are returned to their final state after the last pass
+    bool depthRestored = false, backBufferRestored = false;
+    for (const RGBarrier& barrier : graph.GetFinalBarriers())
+    {
+        depthRestored |= barrier.Resource == depth && barrier.After == RG_ACCESS_DEPTH_WRITE;
+        backBufferRestored |= barrier.Resource == backBuffer && barrier.After == RG_ACCESS_PRESENT;
+    }
+    MUON_CHECK(depthRestored && backBufferRestored);
+}
+
+MUON_TEST(RenderGraph_AliasesTransients)
+{
+    RenderGraph graph;
+    const RGTextureDesc desc = MakeDesc(1024, 1024);
+    const RGResourceHandle backBuffer = graph.ImportTexture("BackBuffer", desc, RG_ACCESS_PRESENT, RG_ACCESS_PRESENT);
+
+    // A -> B -> C -> D -> back buffer: each transient only overlaps its neighbours, so two slots are enough
+    RGResourceHandle chain[4];
+    const char* names[4] = { "A", "B", "C", "D" };
+    for (uint32_t i = 0; i != 4; ++i)
+        chain[i] = graph.CreateTexture(names[i], desc);
+
+    for (uint32_t i = 0; i != 4; ++i)
+    {
+        const RGPassHandle pass = graph.AddPass(names[i], nullptr);
+        if (i != 0)
+            graph.Read(pass, chain[i - 1], RG_ACCESS_SHADER_READ);
+        graph.Write(pass, chain[i], RG_ACCESS_RENDER_TARGET);
+    }
+    const RGPassHandle composite = graph.AddPass("Composite", nullptr);
+    graph.Read(composite, chain[3], RG_ACCESS_SHADER_READ);
+    graph.Write(composite, backBuffer, RG_ACCESS_RENDER_TARGET);
+
+    MUON_CHECK(graph.Compile());
+    ValidateCompiledGraph(graph, 5);
+
+    const uint64_t textureBytes = 1024ull * 1024 * 4;
+    const RGCompileStats& stats = graph.GetCompileStats();
+    MUON_CHECK(stats.UnaliasedBytes == 4 * textureBytes);
+    MUON_CHECK(stats.TransientBytes == 2 * textureBytes);
+
+    const std::vector<RenderGraph::Resource>& resources = graph.GetResources();
+    MUON_CHECK(resources[chain[0]].HeapOffset == resources[chain[2]].HeapOffset);
+    MUON_CHECK(resources[chain[1]].HeapOffset == resources[chain[3]].HeapOffset);
+    MUON_CHECK(resources[chain[0]].HeapOffset != resources[chain[1]].HeapOffset);
+    for (RGResourceHandle r : chain)
+        MUON_CHECK(resources[r].Aliases);
+
+    // The memory function decides sizes and alignment when there is one
+    MUON_CHECK(graph.Compile([](const RGTextureDesc&, uint32_t) { RGMemoryRequirements req; req.Size = 1000; req.Alignment = 4096; return req; }));
+    ValidateCompiledGraph(graph, 5);
+    MUON_CHECK(graph.GetCompileStats().TransientBytes == 4096 + 1000);
+    MUON_CHECK(graph.GetResources()[chain[1]].HeapOffset % 4096 == 0);
+}
+
+MUON_TEST(RenderGraph_RandomGraphs)
+{
+    std::mt19937 rng(1234);
+    RenderGraph graph;
+    for (uint32_t run = 0; run != 200; ++run)
+    {
+        const uint32_t numPasses = 2 + static_cast<uint32_t>(rng() % 60);
+        const uint32_t numTransients = 1 + static_cast<uint32_t>(rng() % 24);
+        BuildRandomGraph(graph, rng, numPasses, numTransients);
+
+        MUON_CHECK(graph.Compile());
+        ValidateCompiledGraph(graph, numPasses);
+
+        // Recompiling the same declarations gives the same result
+        const std::vector<RGCompiledPass> first = graph.GetCompiledPasses();
+        const size_t numBarriers = graph.GetBarriers().size();
+        MUON_CHECK(graph.Compile());
+        MUON_CHECK(graph.GetBarriers().size() == numBarriers);
+        MUON_CHECK(graph.GetCompiledPasses().size() == first.size());
+        for (size_t i = 0; i != first.size() && i != graph.GetCompiledPasses().size(); ++i)
+            MUON_CHECK(graph.GetCompiledPasses()[i].Pass == first[i].Pass);
+    }
+}
+
+MUON_BENCHMARK(RenderGraph_Compile)
+{
+    const uint32_t passCounts[] = { 32, 128, 512, 2048 };
+    for (uint32_t numPasses : passCounts)
+    {
+        std::mt19937 rng(numPasses);
+        RenderGraph graph;
+        BuildRandomGraph(graph, rng, numPasses, numPasses / 4 + 4);
+
+        const BenchmarkResult result = RunBenchmark(20, [&]() { graph.Compile(); });
+
+        char label[64];
+        std::snprintf(label, sizeof(label), "Compile %u passes (%u barriers)", numPasses, graph.GetCompileStats().NumBarriers);
+        PrintBenchmark(label, result, (double)numPasses, "passes");
+    }
+}
@@ -0,0 +1,187 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Tests and sort benchmark for the render queue
+----------------------------------------------*/
+#include "TestFramework.h"
+
+#include <Core/JobSystem.h>
+#include <Core/RenderQueue.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace
+{
+using namespace Muon;
+
+// Mixes fully random keys with keys that share most of their digits, so both the digit skipping and the stability matter
+void MakeKeys(size_t count, uint64_t seed, std::vector<uint64_t>& out_keys, std::vector<uint32_t>& out_values)
+{
+    std::mt19937_64 rng(seed);
+    out_keys.resize(count);
+    out_values.resize(count);
+    for (size_t i = 0; i != count; ++i)
+    {
+        out_keys[i] = (rng() % 3 == 0) ? (rng() & 0xF0000000FFFF0000ull) : rng();
+        out_values[i] = static_cast<uint32_t>(i);
+    }
+}
+
+// Keys as RenderQueue::Push builds them: a few passes, a handful of pipelines and materials, random depths
+void MakePacketKeys(size_t count, uint64_t seed, std::vector<uint64_t>& out_keys, std::vector<uint32_t>& out_values)
+{
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<float> depth(0.1f, 1000.0f);
+    out_keys.resize(count);
+    out_values.resize(count);
+    for (size_t i = 0; i != count; ++i)
+    {
+        const uint8_t pass = static_cast<uint8_t>(rng() % RENDERPASS_COUNT);
+        const SortOrder order = pass == RENDERPASS_DEPTH_PREPASS ? SORTORDER_DEPTH_FIRST : SORTORDER_STATE_FIRST;
+        out_keys[i] = EncodeSortKey(pass, static_cast<uint16_t>(rng() % 16), static_cast<uint16_t>(rng() % 256), depth(rng), order);
+        out_values[i] = static_cast<uint32_t>(i);
+    }
+}
+
+bool MatchesStableSort(const std::vector<uint64_t>& unsortedKeys, const std::vector<uint32_t>& unsortedValues,
+    const std::vector<uint64_t>& sortedKeys, const std::vector<uint32_t>& sortedValues)
+{
+    std::vector<std::pair<uint64_t, uint32_t>> reference(unsortedKeys.size());
+    for (size_t i = 0; i != reference.size(); ++i)
+        reference[i] = { unsortedKeys[i], unsortedValues[i] };
+
+    std::stable_sort(reference.begin(), reference.end(), [](const std::pair<uint64_t, uint32_t>& a, const std::pair<uint64_t, uint32_t>& b)
+    {
+        return a.first < b.first;
+    });
+
+    for (size_t i = 0; i != reference.size(); ++i)
+    {
+        if (sortedKeys[i] != reference[i].first || sortedValues[i] != reference[i].second)
+            return false;
+    }
+    return true;
+}
+
+void CheckRadixSort(size_t count, uint64_t seed, bool packetKeys)
+{
+    std::vector<uint64_t> keys;
+    std::vector<uint32_t> values;
+    if (packetKeys)
+        MakePacketKeys(count, seed, keys, values);
+    else
+        MakeKeys(count, seed, keys, values);
+
+    std::vector<uint64_t> sortedKeys = keys;
+    std::vector<uint32_t> sortedValues = values;
+    std::vector<uint64_t> tempKeys(count);
+    std::vector<uint32_t> tempValues(count);
+    RadixSortKeys(sortedKeys.data(), sortedValues.data(), count, tempKeys.data(), tempValues.data());
+
+    const bool matches = MatchesStableSort(keys, values, sortedKeys, sortedValues);
+    if (!matches)
+        std::printf("    Mismatch sorting %zu %s keys\n", count, packetKeys ? "packet" : "random");
+    MUON_CHECK(matches);
+}
+}
+
+MUON_TEST(RenderQueue_RadixSortMatchesStableSort)
+{
+    const size_t counts[] = { 0, 1, 2, 3, 100, 255, 256, 257, 4095, 40000, 1000000 };
+
+    // Serial and split across the job system
+    const uint32_t threadCounts[] = { 1, 4 };
+    for (uint32_t numThreads : threadCounts)
+    {
+        JobSystem::Init(numThreads - 1);
+        for (size_t count : counts)
+        {
+            CheckRadixSort(count, count + numThreads, false);
+            CheckRadixSort(count, count * 7 + numThreads, true);
+        }
+        JobSystem::Destroy();
+    }
+}
+
+MUON_TEST(RenderQueue_RadixSortIdenticalKeys)
+{
+    // Every digit is skipped, the values have to come back untouched
+    JobSystem::Init(3);
+    const size_t count = 100000;
+    std::vector<uint64_t> keys(count, 0x123456789ABCDEF0ull);
+    std::vector<uint32_t> values(count);
+    for (size_t i = 0; i != count; ++i)
+        values[i] = static_cast<uint32_t>(count - i);
+
+    const std::vector<uint32_t> expected = values;
+    std::vector<uint64_t> tempKeys(count);
+    std::vector<uint32_t> tempValues(count);
+    RadixSortKeys(keys.data(), values.data(), count, tempKeys.data(), tempValues.data());
+    MUON_CHECK(values == expected);
+    JobSystem::Destroy();
+}
+
+MUON_TEST(RenderQueue_SortKeyOrder)
+{
+    // Pass always dominates, then the pass's own order
+    const uint64_t prepassFar = EncodeSortKey(RENDERPASS_DEPTH_PREPASS, 9, 9, 100.0f, SORTORDER_DEPTH_FIRST);
+    const uint64_t opaqueNear = EncodeSortKey(RENDERPASS_OPAQUE, 0, 0, 1.0f, SORTORDER_DEPTH_FIRST);
+    MUON_CHECK(prepassFar < opaqueNear);
+
+    const uint64_t behind = EncodeSortKey(RENDERPASS_OPAQUE, 3, 4, 2.0f, SORTORDER_DEPTH_FIRST);
+    const uint64_t negative = EncodeSortKey(RENDERPASS_OPAQUE, 3, 4, -5.0f, SORTORDER_DEPTH_FIRST);
+    MUON_CHECK(opaqueNear < behind);
+    MUON_CHECK(negative < opaqueNear);
+
+    const uint64_t statePipeline0 = EncodeSortKey(RENDERPASS_OPAQUE, 0, 7, 500.0f, SORTORDER_STATE_FIRST);
+    const uint64_t statePipeline1 = EncodeSortKey(RENDERPASS_OPAQUE, 1, 0, 1.0f, SORTORDER_STATE_FIRST);
+    MUON_CHECK(statePipeline0 < statePipeline1);
+
+    const SortOrder orders[] = { SORTORDER_STATE_FIRST, SORTORDER_DEPTH_FIRST };
+    for (SortOrder order : orders)
+    {
+        const uint64_t key = EncodeSortKey(RENDERPASS_OPAQUE, 0xABC, 0x1234, 3.0f, order);
+        MUON_CHECK(GetSortKeyPass(key) == RENDERPASS_OPAQUE);
+        MUON_CHECK(GetSortKeyPipeline(key, order) == 0xABC);
+        MUON_CHECK(GetSortKeyMaterial(key, order) == 0x1234);
+    }
+}
+
+MUON_BENCHMARK(RenderQueue_Sort)
+{
+    static const size_t kNumPackets = 1000000;
+    JobSystem::Init();
+
+    std::vector<uint64_t> keys, sortedKeys, tempKeys(kNumPackets);
+    std::vector<uint32_t> values, sortedValues, tempValues(kNumPackets);
+    MakePacketKeys(kNumPackets, 1, keys, values);
+
+    const BenchmarkResult radix = RunBenchmark(10, [&]()
+    {
+        sortedKeys = keys;
+        sortedValues = values;
+        RadixSortKeys(sortedKeys.data(), sortedValues.data(), kNumPackets, tempKeys.data(), tempValues.data());
+    });
+
+    std::vector<std::pair<uint64_t, uint32_t>> pairs(kNumPackets);
+    const BenchmarkResult stable = RunBenchmark(10, [&]()
+    {
+        for (size_t i = 0; i != kNumPackets; ++i)
+            pairs[i] = { keys[i], values[i] };
+        std::stable_sort(pairs.begin(), pairs.end(), [](const std::pair<uint64_t, uint32_t>& a, const std::pair<uint64_t, uint32_t>& b)
+        {
+            return a.first < b.first;
+        });
+    });
+
+    char label[64];
+    std::snprintf(label, sizeof(label), "RadixSortKeys, 1M packets, %u threads", JobSystem::GetSingleton().GetNumThreads());
+    PrintBenchmark(label, radix, (double)kNumPackets, "packets");
+    PrintBenchmark("std::stable_sort, 1M packets", stable, (double)kNumPackets, "packets");
+
+    JobSystem::Destroy();
+}
@@ -0,0 +1,119 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Tests for promoting constant buffers to root constants
+----------------------------------------------*/
+#include "TestFramework.h"
+
+#include <Core/RootParameterPlan.h>
+#include <Core/Shader.h>
+
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+using namespace Muon;
+
+void AddResource(ShaderReflectionData& data, const char* name, ShaderResourceType type, UINT bindPoint, UINT size = 0)
+{
+    ShaderResourceBinding binding;
+    binding.Name = name;
+    binding.Type = type;
+    binding.BindPoint = bindPoint;
+    binding.BindCount = 1;
+    binding.Space = 0;
+    binding.Size = size;
+    data.Resources.push_back(binding);
+}
+
+// Constant buffers listed out of size order, one too big to ever promote, alongside a texture and a sampler.
+// Unpromoted it costs 5 root CBVs and a table, 11 DWORDs.
+void MakeReflection(ShaderReflectionData& out_data)
+{
+    out_data = {};
+    AddResource(out_data, "Material", ShaderResourceType::ConstantBuffer, 0, 64);
+    AddResource(out_data, "Object", ShaderResourceType::ConstantBuffer, 1, 16);
+    AddResource(out_data, "Lights", ShaderResourceType::ConstantBuffer, 2, 48);
+    AddResource(out_data, "Frame", ShaderResourceType::ConstantBuffer, 3, 128);
+    AddResource(out_data, "Fog", ShaderResourceType::ConstantBuffer, 4, 32);
+    AddResource(out_data, "Albedo", ShaderResourceType::Texture, 0);
+    AddResource(out_data, "Linear", ShaderResourceType::Sampler, 0);
+    out_data.IsReflected = true;
+}
+
+static const RootParameterKind kConstants = RootParameterKind::RootConstants;
+static const RootParameterKind kCBV = RootParameterKind::RootCBV;
+static const RootParameterKind kTable = RootParameterKind::DescriptorTable;
+static const RootParameterKind kSampler = RootParameterKind::StaticSampler;
+
+bool HasKinds(const RootParameterPlan& plan, const std::vector<RootParameterKind>& expected, UINT expectedDWORDs)
+{
+    const bool matches = plan.Kinds == expected && plan.TotalDWORDs == expectedDWORDs;
+    if (!matches)
+        std::printf("    Plan costs %u DWORDs, expected %u\n", plan.TotalDWORDs, expectedDWORDs);
+    return matches;
+}
+}
+
+MUON_TEST(RootParameterPlan_PromotesSmallestUnderThreshold)
+{
+    ShaderReflectionData data;
+    MakeReflection(data);
+
+    // With room to spare everything up to the threshold is promoted: 16, 32, 48 and 64 bytes are 4 + 8 + 12 + 16
+    // DWORDs in place of four 2 DWORD CBVs. The 128 byte buffer stays a root CBV.
+    RootParameterPlan plan;
+    MUON_CHECK(PlanRootParameters(data.Resources, ROOTCONSTANT_MAX_BYTES, ROOTSIG_MAX_DWORDS, plan));
+    MUON_CHECK(HasKinds(plan, { kConstants, kConstants, kConstants, kCBV, kConstants, kTable, kSampler }, 11 - 8 + 40));
+
+    // A lower threshold leaves the bigger ones as CBVs, even though the budget could take them
+    MUON_CHECK(PlanRootParameters(data.Resources, 32, ROOTSIG_MAX_DWORDS, plan));
+    MUON_CHECK(HasKinds(plan, { kCBV, kConstants, kCBV, kCBV, kConstants, kTable, kSampler }, 11 - 4 + 12));
+
+    // Empty buffers have nothing to put in root constants
+    AddResource(data, "Empty", ShaderResourceType::ConstantBuffer, 5, 0);
+    MUON_CHECK(PlanRootParameters(data.Resources, ROOTCONSTANT_MAX_BYTES, ROOTSIG_MAX_DWORDS, plan));
+    MUON_CHECK(plan.Kinds.size() == data.Resources.size() && plan.Kinds.back() == kCBV);
+}
+
+MUON_TEST(RootParameterPlan_StopsAtBudget)
+{
+    ShaderReflectionData data;
+    MakeReflection(data);
+
+    // 16 and 32 bytes bring it to 19 DWORDs. The 48 byte buffer would make it 29, and so would anything after it.
+    RootParameterPlan plan;
+    MUON_CHECK(PlanRootParameters(data.Resources, ROOTCONSTANT_MAX_BYTES, 25, plan));
+    MUON_CHECK(HasKinds(plan, { kCBV, kConstants, kCBV, kCBV, kConstants, kTable, kSampler }, 19));
+
+    // Exactly at the budget still fits
+    MUON_CHECK(PlanRootParameters(data.Resources, ROOTCONSTANT_MAX_BYTES, 29, plan));
+    MUON_CHECK(HasKinds(plan, { kCBV, kConstants, kConstants, kCBV, kConstants, kTable, kSampler }, 29));
+
+    // Between equal sizes the one listed first wins, so equal layouts always share a root signature
+    ShaderReflectionData tied;
+    AddResource(tied, "A", ShaderResourceType::ConstantBuffer, 0, 32);
+    AddResource(tied, "B", ShaderResourceType::ConstantBuffer, 1, 32);
+    MUON_CHECK(PlanRootParameters(tied.Resources, ROOTCONSTANT_MAX_BYTES, 10, plan));
+    MUON_CHECK(HasKinds(plan, { kConstants, kCBV }, 10));
+}
+
+MUON_TEST(RootParameterPlan_FallsBackToRootCBVs)
+{
+    ShaderReflectionData data;
+    MakeReflection(data);
+
+    // No room to promote even the smallest buffer, so every constant buffer stays a root CBV
+    RootParameterPlan plan;
+    MUON_CHECK(PlanRootParameters(data.Resources, ROOTCONSTANT_MAX_BYTES, 12, plan));
+    MUON_CHECK(HasKinds(plan, { kCBV, kCBV, kCBV, kCBV, kCBV, kTable, kSampler }, 11));
+
+    // And when even that doesn't fit, there's no plan at all
+    MUON_CHECK(!PlanRootParameters(data.Resources, ROOTCONSTANT_MAX_BYTES, 10, plan));
+
+    MUON_CHECK(GetRootParameterCost(kConstants, 16) == 16);
+    MUON_CHECK(GetRootParameterCost(kCBV, 16) == 2);
+    MUON_CHECK(GetRootParameterCost(kTable, 0) == 1);
+    MUON_CHECK(GetRootParameterCost(kSampler, 0) == 0);
+}
@@ -0,0 +1,293 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Tests for the root signature layout generator
+----------------------------------------------*/
+#include "TestFramework.h"
+
+#include <Core/RootSignatureBuilder.h>
+
+#include <cstdio>
+
+namespace
+{
+using Muon::RootSignatureBuilder;
+
+D3D12_STATIC_SAMPLER_DESC MakeSampler(UINT shaderRegister)
+{
+    D3D12_STATIC_SAMPLER_DESC sampler = {};
+    sampler.Filter = D3D12_FILTER_MIN_MAG_MIP_LINEAR;
+    sampler.AddressU = D3D12_TEXTURE_ADDRESS_MODE_WRAP;
+    sampler.AddressV = D3D12_TEXTURE_ADDRESS_MODE_WRAP;
+    sampler.AddressW = D3D12_TEXTURE_ADDRESS_MODE_WRAP;
+    sampler.MaxAnisotropy = 16;
+    sampler.ComparisonFunc = D3D12_COMPARISON_FUNC_LESS_EQUAL;
+    sampler.MaxLOD = D3D12_FLOAT32_MAX;
+    sampler.ShaderRegister = shaderRegister;
+    sampler.ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;
+    return sampler;
+}
+
+D3D12_DESCRIPTOR_RANGE MakeRange(D3D12_DESCRIPTOR_RANGE_TYPE type, UINT numDescriptors, UINT baseRegister)
+{
+    D3D12_DESCRIPTOR_RANGE range = {};
+    range.RangeType = type;
+    range.NumDescriptors = numDescriptors;
+    range.BaseShaderRegister = baseRegister;
+    range.OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;
+    return range;
+}
+
+// The layout a typical lit material reflects to: root constants and a CBV per stage, two textures, a sampler
+void BuildMaterialLayout(RootSignatureBuilder& builder)
+{
+    builder.AddConstants(16, 0, 0, D3D12_SHADER_VISIBILITY_VERTEX);
+    builder.AddConstantBufferView(1, 0, D3D12_SHADER_VISIBILITY_VERTEX);
+    builder.AddConstantBufferView(0, 0, D3D12_SHADER_VISIBILITY_PIXEL);
+    builder.AddShaderResourceView(0, 0, D3D12_SHADER_VISIBILITY_PIXEL);
+    builder.AddShaderResourceView(1, 0, D3D12_SHADER_VISIBILITY_PIXEL);
+    builder.AddStaticSampler(MakeSampler(0));
+}
+
+bool IsEquivalentAndSameHash(const RootSignatureBuilder& a, const RootSignatureBuilder& b)
+{
+    return a.IsEquivalent(b) && b.IsEquivalent(a) && a.GetHash() == b.GetHash();
+}
+}
+
+MUON_TEST(RootSignatureBuilder_EmptyLayout)
+{
+    RootSignatureBuilder builder;
+
+    std::vector<D3D12_ROOT_PARAMETER> parameters;
+    D3D12_ROOT_SIGNATURE_DESC desc;
+    builder.GetDesc(parameters, desc);
+
+    MUON_CHECK(desc.NumParameters == 0);
+    MUON_CHECK(desc.NumStaticSamplers == 0);
+    MUON_CHECK(desc.Flags == D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT);
+}
+
+MUON_TEST(RootSignatureBuilder_ParameterLayout)
+{
+    RootSignatureBuilder builder;
+    BuildMaterialLayout(builder);
+
+    const D3D12_DESCRIPTOR_RANGE tableRanges[] =
+    {
+        MakeRange(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 4, 2),
+        MakeRange(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 1, 0),
+    };
+    builder.AddDescriptorTable(tableRanges, 2, D3D12_SHADER_VISIBILITY_ALL);
+    builder.SetFlags(D3D12_ROOT_SIGNATURE_FLAG_NONE);
+
+    MUON_CHECK(builder.GetNumParameters() == 6);
+    MUON_CHECK(builder.GetNumStaticSamplers() == 1);
+
+    std::vector<D3D12_ROOT_PARAMETER> parameters;
+    D3D12_ROOT_SIGNATURE_DESC desc;
+    builder.GetDesc(parameters, desc);
+
+    MUON_CHECK(desc.NumParameters == 6);
+    MUON_CHECK(desc.pParameters == parameters.data());
+    MUON_CHECK(desc.NumStaticSamplers == 1);
+    MUON_CHECK(desc.pStaticSamplers && desc.pStaticSamplers[0].ShaderRegister == 0);
+    MUON_CHECK(desc.Flags == D3D12_ROOT_SIGNATURE_FLAG_NONE);
+    if (parameters.size() != 6)
+        return;
+
+    // Parameters stay in the order they were added
+    MUON_CHECK(parameters[0].ParameterType == D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS);
+    MUON_CHECK(parameters[0].ShaderVisibility == D3D12_SHADER_VISIBILITY_VERTEX);
+    MUON_CHECK(parameters[0].Constants.Num32BitValues == 16);
+    MUON_CHECK(parameters[0].Constants.ShaderRegister == 0);
+
+    MUON_CHECK(parameters[1].ParameterType == D3D12_ROOT_PARAMETER_TYPE_CBV);
+    MUON_CHECK(parameters[1].ShaderVisibility == D3D12_SHADER_VISIBILITY_VERTEX);
+    MUON_CHECK(parameters[1].Descriptor.ShaderRegister == 1);
+
+    MUON_CHECK(parameters[2].ParameterType == D3D12_ROOT_PARAMETER_TYPE_CBV);
+    MUON_CHECK(parameters[2].ShaderVisibility == D3D12_SHADER_VISIBILITY_PIXEL);
+    MUON_CHECK(parameters[2].Descriptor.ShaderRegister == 0);
+
+    // Each SRV is a single-range table of its own
+    for (UINT i = 0; i < 2; ++i)
+    {
+        const D3D12_ROOT_PARAMETER& srv = parameters[3 + i];
+        MUON_CHECK(srv.ParameterType == D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE);
+        MUON_CHECK(srv.ShaderVisibility == D3D12_SHADER_VISIBILITY_PIXEL);
+        MUON_CHECK(srv.DescriptorTable.NumDescriptorRanges == 1);
+        MUON_CHECK(srv.DescriptorTable.pDescriptorRanges != nullptr);
+        if (!srv.DescriptorTable.pDescriptorRanges)
+            continue;
+
+        const D3D12_DESCRIPTOR_RANGE& range = srv.DescriptorTable.pDescriptorRanges[0];
+        MUON_CHECK(range.RangeType == D3D12_DESCRIPTOR_RANGE_TYPE_SRV);
+        MUON_CHECK(range.NumDescriptors == 1);
+        MUON_CHECK(range.BaseShaderRegister == i);
+        MUON_CHECK(range.OffsetInDescriptorsFromTableStart == D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND);
+    }
+
+    // The explicit table is copied, so the caller's ranges can go out of scope
+    const D3D12_ROOT_PARAMETER& table = parameters[5];
+    MUON_CHECK(table.ParameterType == D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE);
+    MUON_CHECK(table.ShaderVisibility == D3D12_SHADER_VISIBILITY_ALL);
+    MUON_CHECK(table.DescriptorTable.NumDescriptorRanges == 2);
+    MUON_CHECK(table.DescriptorTable.pDescriptorRanges != tableRanges);
+    if (table.DescriptorTable.pDescriptorRanges)
+    {
+        MUON_CHECK(table.DescriptorTable.pDescriptorRanges[0].NumDescriptors == 4);
+        MUON_CHECK(table.DescriptorTable.pDescriptorRanges[0].BaseShaderRegister == 2);
+        MUON_CHECK(table.DescriptorTable.pDescriptorRanges[1].RangeType == D3D12_DESCRIPTOR_RANGE_TYPE_UAV);
+    }
+}
+
+MUON_TEST(RootSignatureBuilder_CopyResolvesOwnRanges)
+{
+    RootSignatureBuilder original;
+    BuildMaterialLayout(original);
+    RootSignatureBuilder copy = original;
+
+    std::vector<D3D12_ROOT_PARAMETER> originalParams;
+    std::vector<D3D12_ROOT_PARAMETER> copyParams;
+    D3D12_ROOT_SIGNATURE_DESC originalDesc;
+    D3D12_ROOT_SIGNATURE_DESC copyDesc;
+    original.GetDesc(originalParams, originalDesc);
+    copy.GetDesc(copyParams, copyDesc);
+
+    MUON_CHECK(copyDesc.pStaticSamplers != originalDesc.pStaticSamplers);
+    MUON_CHECK(copyParams[3].DescriptorTable.pDescriptorRanges != originalParams[3].DescriptorTable.pDescriptorRanges);
+    MUON_CHECK(copyParams[3].DescriptorTable.pDescriptorRanges->BaseShaderRegister == 0);
+    MUON_CHECK(IsEquivalentAndSameHash(original, copy));
+}
+
+MUON_TEST(RootSignatureBuilder_EqualLayoutsDedup)
+{
+    RootSignatureBuilder a;
+    RootSignatureBuilder b;
+    BuildMaterialLayout(a);
+    BuildMaterialLayout(b);
+    MUON_CHECK(IsEquivalentAndSameHash(a, b));
+
+    // Ranges live in different allocations but describe the same table
+    D3D12_DESCRIPTOR_RANGE rangesA[] = { MakeRange(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 8, 0) };
+    D3D12_DESCRIPTOR_RANGE rangesB[] = { MakeRange(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 8, 0) };
+    a.AddDescriptorTable(rangesA, 1, D3D12_SHADER_VISIBILITY_PIXEL);
+    b.AddDescriptorTable(rangesB, 1, D3D12_SHADER_VISIBILITY_PIXEL);
+    MUON_CHECK(IsEquivalentAndSameHash(a, b));
+
+    // Reset brings a builder back to the default layout
+    a.Reset();
+    MUON_CHECK(a.GetNumParameters() == 0);
+    MUON_CHECK(a.GetNumStaticSamplers() == 0);
+    MUON_CHECK(IsEquivalentAndSameHash(a, RootSignatureBuilder()));
+    MUON_CHECK(!a.IsEquivalent(b));
+}
+
+MUON_TEST(RootSignatureBuilder_LayoutDifferencesDontDedup)
+{
+    RootSignatureBuilder base;
+    BuildMaterialLayout(base);
+
+    auto checkDiffers = [&](const char* what, RootSignatureBuilder& other)
+    {
+        const bool differs = !base.IsEquivalent(other) && !other.IsEquivalent(base);
+        const bool hashDiffers = base.GetHash() != other.GetHash();
+        if (!differs || !hashDiffers)
+            std::printf("    difference not detected: %s\n", what);
+        MUON_CHECK(differs);
+        MUON_CHECK(hashDiffers);
+    };
+
+    {
+        RootSignatureBuilder other;
+        other.AddConstants(16, 0, 0, D3D12_SHADER_VISIBILITY_VERTEX);
+        other.AddConstantBufferView(2, 0, D3D12_SHADER_VISIBILITY_VERTEX); // Register
+        other.AddConstantBufferView(0, 0, D3D12_SHADER_VISIBILITY_PIXEL);
+        other.AddShaderResourceView(0, 0, D3D12_SHADER_VISIBILITY_PIXEL);
+        other.AddShaderResourceView(1, 0, D3D12_SHADER_VISIBILITY_PIXEL);
+        other.AddStaticSampler(MakeSampler(0));
+        checkDiffers("CBV register", other);
+    }
+    {
+        RootSignatureBuilder other;
+        other.AddConstants(16, 0, 0, D3D12_SHADER_VISIBILITY_VERTEX);
+        other.AddConstantBufferView(1, 1, D3D12_SHADER_VISIBILITY_VERTEX); // Space
+        other.AddConstantBufferView(0, 0, D3D12_SHADER_VISIBILITY_PIXEL);
+        other.AddShaderResourceView(0, 0, D3D12_SHADER_VISIBILITY_PIXEL);
+        other.AddShaderResourceView(1, 0, D3D12_SHADER_VISIBILITY_PIXEL);
+        other.AddStaticSampler(MakeSampler(0));
+        checkDiffers("CBV space", other);
+    }
+    {
+        RootSignatureBuilder other;
+        other.AddConstants(16, 0, 0, D3D12_SHADER_VISIBILITY_ALL); // Visibility
+        other.AddConstantBufferView(1, 0, D3D12_SHADER_VISIBILITY_VERTEX);
+        other.AddConstantBufferView(0, 0, D3D12_SHADER_VISIBILITY_PIXEL);
+        other.AddShaderResourceView(0, 0, D3D12_SHADER_VISIBILITY_PIXEL);
+        other.AddShaderResourceView(1, 0, D3D12_SHADER_VISIBILITY_PIXEL);
+        other.AddStaticSampler(MakeSampler(0));
+        checkDiffers("visibility", other);
+    }
+    {
+        RootSignatureBuilder other;
+        other.AddConstants(12, 0, 0, D3D12_SHADER_VISIBILITY_VERTEX); // Constant count
+        other.AddConstantBufferView(1, 0, D3D12_SHADER_VISIBILITY_VERTEX);
+        other.AddConstantBufferView(0, 0, D3D12_SHADER_VISIBILITY_PIXEL);
+        other.AddShaderResourceView(0, 0, D3D12_SHADER_VISIBILITY_PIXEL);
+        other.AddShaderResourceView(1, 0, D3D12_SHADER_VISIBILITY_PIXEL);
+        other.AddStaticSampler(MakeSampler(0));
+        checkDiffers("constant count", other);
+    }
+    {
+        RootSignatureBuilder other;
+        other.AddConstants(16, 0, 0, D3D12_SHADER_VISIBILITY_VERTEX);
+        other.AddConstantBufferView(1, 0, D3D12_SHADER_VISIBILITY_VERTEX);
+        other.AddConstantBufferView(0, 0, D3D12_SHADER_VISIBILITY_PIXEL);
+        other.AddShaderResourceView(0, 0, D3D12_SHADER_VISIBILITY_PIXEL);
+        other.AddShaderResourceView(2, 0, D3D12_SHADER_VISIBILITY_PIXEL); // Range contents
+        other.AddStaticSampler(MakeSampler(0));
+        checkDiffers("SRV register", other);
+    }
+    {
+        RootSignatureBuilder other;
+        other.AddConstants(16, 0, 0, D3D12_SHADER_VISIBILITY_VERTEX);
+        other.AddConstantBufferView(1, 0, D3D12_SHADER_VISIBILITY_VERTEX);
+        other.AddConstantBufferView(0, 0, D3D12_SHADER_VISIBILITY_PIXEL);
+        other.AddShaderResourceView(0, 0, D3D12_SHADER_VISIBILITY_PIXEL);
+        other.AddShaderResourceView(1, 0, D3D12_SHADER_VISIBILITY_PIXEL);
+        other.AddStaticSampler(MakeSampler(1)); // Sampler
+        checkDiffers("sampler register", other);
+    }
+    {
+        RootSignatureBuilder other;
+        BuildMaterialLayout(other);
+        other.SetFlags(D3D12_ROOT_SIGNATURE_FLAG_NONE); // Flags
+        checkDiffers("flags", other);
+    }
+    {
+        RootSignatureBuilder other;
+        other.AddConstantBufferView(1, 0, D3D12_SHADER_VISIBILITY_VERTEX); // Order
+        other.AddConstants(16, 0, 0, D3D12_SHADER_VISIBILITY_VERTEX);
+        other.AddConstantBufferView(0, 0, D3D12_SHADER_VISIBILITY_PIXEL);
+        other.AddShaderResourceView(0, 0, D3D12_SHADER_VISIBILITY_PIXEL);
+        other.AddShaderResourceView(1, 0, D3D12_SHADER_VISIBILITY_PIXEL);
+        other.AddStaticSampler(MakeSampler(0));
+        checkDiffers("parameter order", other);
+    }
+    {
+        RootSignatureBuilder other;
+        BuildMaterialLayout(other);
+        other.AddConstantBufferView(2, 0, D3D12_SHADER_VISIBILITY_PIXEL); // Extra parameter
+        checkDiffers("parameter count", other);
+    }
+    {
+        // A CBV and an SRV table on the same register are different parameters
+        RootSignatureBuilder cbv;
+        RootSignatureBuilder srv;
+        cbv.AddConstantBufferView(0, 0, D3D12_SHADER_VISIBILITY_PIXEL);
+        srv.AddShaderResourceView(0, 0, D3D12_SHADER_VISIBILITY_PIXEL);
+        MUON_CHECK(!cbv.IsEquivalent(srv));
+        MUON_CHECK(cbv.GetHash() != srv.GetHash());
+    }
+}
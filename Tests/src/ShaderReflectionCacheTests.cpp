@@ -0,0 +1,164 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Tests and loader benchmark for the shader reflection cache
+----------------------------------------------*/
+#include "TestFramework.h"
+
+#include <Core/CodexManifest.h>
+#include <Core/PathMacros.h>
+#include <Core/Shader.h>
+#include <Core/ShaderReflectionCache.h>
+#include <Core/ShaderUtils.h>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace
+{
+using namespace Muon;
+
+struct CompiledShader
+{
+    std::wstring Path;
+    Microsoft::WRL::ComPtr<ID3DBlob> Blob;
+    uint64_t Hash = 0;
+    ShaderStage Stage = ShaderStage::Vertex;
+};
+
+// Reads the bytecode of every shader the manifest declares. Needs the Shaders project to have been built.
+bool LoadCompiledShaders(std::vector<CompiledShader>& out_shaders)
+{
+    CodexManifest manifest;
+    bool fromBinary = false;
+    if (!manifest.Load(fromBinary))
+        return false;
+
+    for (const ShaderDefinition& def : manifest.Shaders)
+    {
+        CompiledShader shader;
+        shader.Path = GetShaderPathFromFile_W(std::wstring(def.FileName.begin(), def.FileName.end()));
+        shader.Stage = def.Stage;
+        if (FAILED(D3DReadFileToBlob(shader.Path.c_str(), shader.Blob.GetAddressOf())))
+        {
+            std::printf("    Missing %s, build the Shaders project first.\n", def.FileName.c_str());
+            return false;
+        }
+
+        shader.Hash = HashShaderBytecode(shader.Blob.Get());
+        out_shaders.push_back(std::move(shader));
+    }
+
+    return !out_shaders.empty();
+}
+
+// The same steps the loader takes when the cache misses
+bool ReflectLive(const CompiledShader& shader, VertexShader& out_vs, PixelShader& out_ps)
+{
+    Microsoft::WRL::ComPtr<ID3D12ShaderReflection> pReflection;
+    if (FAILED(CreateShaderReflection(shader.Blob.Get(), pReflection.GetAddressOf())))
+        return false;
+
+    if (shader.Stage == ShaderStage::Vertex)
+    {
+        out_vs.ShaderBlob = shader.Blob;
+        return BuildInputLayout(pReflection.Get(), shader.Blob.Get(), &out_vs) &&
+            ParseReflectedResources(pReflection.Get(), out_vs.ReflectionData);
+    }
+
+    out_ps.ShaderBlob = shader.Blob;
+    return ParseReflectedResources(pReflection.Get(), out_ps.ReflectionData);
+}
+
+bool LoadFromCache(const CompiledShader& shader, VertexShader& out_vs, PixelShader& out_ps)
+{
+    if (shader.Stage == ShaderStage::Vertex)
+        return LoadCachedReflection(shader.Hash, out_vs);
+    return LoadCachedReflection(shader.Hash, out_ps);
+}
+}
+
+MUON_TEST(ShaderReflectionCache_RoundTripsLiveReflection)
+{
+    std::vector<CompiledShader> shaders;
+    if (!LoadCompiledShaders(shaders))
+    {
+        std::printf("    Skipped, no compiled shaders.\n");
+        return;
+    }
+
+    for (const CompiledShader& shader : shaders)
+    {
+        VertexShader liveVS, cachedVS;
+        PixelShader livePS, cachedPS;
+        MUON_CHECK(ReflectLive(shader, liveVS, livePS));
+
+        const bool saved = shader.Stage == ShaderStage::Vertex ?
+            SaveCachedReflection(shader.Hash, liveVS) : SaveCachedReflection(shader.Hash, livePS);
+        MUON_CHECK(saved);
+        MUON_CHECK(LoadFromCache(shader, cachedVS, cachedPS));
+
+        std::string diff;
+        const bool same = shader.Stage == ShaderStage::Vertex ?
+            CompareReflection(liveVS, cachedVS, diff) : CompareReflection(livePS, cachedPS, diff);
+        if (!same)
+            std::printf("    %ls: %s\n", shader.Path.c_str(), diff.c_str());
+        MUON_CHECK(same);
+
+        liveVS.Release();
+        cachedVS.Release();
+        livePS.Release();
+        cachedPS.Release();
+    }
+}
+
+MUON_BENCHMARK(ShaderReflectionCache_Load)
+{
+    std::vector<CompiledShader> shaders;
+    if (!LoadCompiledShaders(shaders))
+    {
+        std::printf("    Skipped, no compiled shaders.\n");
+        return;
+    }
+
+    auto reflectAll = [&](bool fromCache)
+    {
+        for (const CompiledShader& shader : shaders)
+        {
+            VertexShader vs;
+            PixelShader ps;
+            if (fromCache)
+                LoadFromCache(shader, vs, ps);
+            else
+                ReflectLive(shader, vs, ps);
+            vs.Release();
+            ps.Release();
+        }
+    };
+
+    // The whole per-shader load, file read included, the way ShaderFactory does it on a warm cache
+    auto loadAll = [&]()
+    {
+        for (const CompiledShader& shader : shaders)
+        {
+            if (shader.Stage == ShaderStage::Vertex)
+            {
+                VertexShader vs;
+                vs.Init(shader.Path.c_str());
+                vs.Release();
+            }
+            else
+            {
+                PixelShader ps;
+                ps.Init(shader.Path.c_str());
+                ps.Release();
+            }
+        }
+    };
+
+    const double numShaders = (double)shaders.size();
+    PrintBenchmark("Live reflection", RunBenchmark(20, [&]() { reflectAll(false); }), numShaders, "shaders");
+    PrintBenchmark("Reflection cache hit", RunBenchmark(20, [&]() { reflectAll(true); }), numShaders, "shaders");
+    PrintBenchmark("Init from .cso, warm cache", RunBenchmark(20, loadAll), numShaders, "shaders");
+}
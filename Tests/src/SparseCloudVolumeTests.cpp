@@ -0,0 +1,167 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Round trip and corrupt header tests for sparse cloud volumes
+----------------------------------------------*/
+#include "TestFramework.h"
+
+#include <Core/BinaryStream.h>
+#include <Core/JobSystem.h>
+#include <Core/PathMacros.h>
+#include <Core/SparseCloudVolume.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <math.h>
+#include <string.h>
+#include <vector>
+
+namespace
+{
+using namespace Muon;
+
+static const wchar_t* kVolumePath = CACHEPATHW L"Tests/Volumes/Valid.mnsv";
+static const wchar_t* kCorruptPath = CACHEPATHW L"Tests/Volumes/Corrupt.mnsv";
+
+// A wavy slab spread over a few bricks, with empty space left around it
+void MakeDensity(const uint32_t dims[3], std::vector<float>& out_density)
+{
+    out_density.assign(size_t(dims[0]) * dims[1] * dims[2], 0.0f);
+    for (uint32_t z = 0; z != dims[2]; ++z)
+    {
+        for (uint32_t y = 0; y != dims[1]; ++y)
+        {
+            for (uint32_t x = 0; x != dims[0]; ++x)
+            {
+                const float value = sinf(x * 0.2f) * cosf(z * 0.15f) + 0.1f * y - 1.0f;
+                out_density[(size_t(z) * dims[1] + y) * dims[0] + x] = value > 0.0f ? value : 0.0f;
+            }
+        }
+    }
+}
+
+bool WriteBytes(const std::vector<uint8_t>& bytes, const wchar_t* path)
+{
+    BinaryWriter writer;
+    writer.WriteBytes(bytes.data(), bytes.size());
+    return writer.SaveToFile(path);
+}
+}
+
+MUON_TEST(SparseCloudVolume_RoundTrip)
+{
+    JobSystem::Init(3);
+
+    const uint32_t dims[3] = { 70, 20, 50 };
+    const float origin[3] = { -5.0f, 0.0f, 3.0f };
+    const float voxelSize = 0.5f;
+    std::vector<float> density;
+    MakeDensity(dims, density);
+
+    SparseCloudVolumeData data;
+    MUON_CHECK(BuildSparseCloudVolume(density.data(), dims, origin, voxelSize, 0.0f, data));
+    MUON_CHECK(!data.Bricks.empty() && data.Bricks.size() < data.Indirection.size());
+    MUON_CHECK(SaveSparseCloudVolume(data, kVolumePath, 42));
+
+    SparseCloudVolumeHeader header;
+    MUON_CHECK(ReadSparseCloudVolumeHeader(kVolumePath, header));
+    MUON_CHECK(header.SourceHash == 42 && header.NumBricks == data.Bricks.size());
+
+    // With every brick resident, sampling at voxel centers gives back the source density within quantization
+    SparseCloudVolume volume;
+    MUON_CHECK(volume.Open(kVolumePath, header.NumBricks));
+    const float camera[3] = { 0.0f, 0.0f, 0.0f };
+    volume.UpdateStreaming(camera, header.NumBricks);
+    MUON_CHECK(volume.GetResidencyStats().NumResident == header.NumBricks);
+
+    double maxError = 0.0;
+    for (uint32_t z = 0; z != dims[2]; ++z)
+    {
+        for (uint32_t y = 0; y != dims[1]; ++y)
+        {
+            for (uint32_t x = 0; x != dims[0]; ++x)
+            {
+                const float pos[3] = { origin[0] + (x + 0.5f) * voxelSize, origin[1] + (y + 0.5f) * voxelSize, origin[2] + (z + 0.5f) * voxelSize };
+                maxError = std::max(maxError, fabs(double(volume.SampleDensity(pos)) - density[(size_t(z) * dims[1] + y) * dims[0] + x]));
+            }
+        }
+    }
+
+    const double tolerance = header.DensityScale / 255.0;
+    if (maxError > tolerance)
+        std::printf("    Max sample error %g, quantization step %g\n", maxError, tolerance);
+    MUON_CHECK(maxError <= tolerance);
+
+    JobSystem::Destroy();
+}
+
+MUON_TEST(SparseCloudVolume_RejectsCorruptHeaders)
+{
+    JobSystem::Init(3);
+
+    const uint32_t dims[3] = { 40, 16, 40 };
+    const float origin[3] = { 0.0f, 0.0f, 0.0f };
+    std::vector<float> density;
+    MakeDensity(dims, density);
+
+    SparseCloudVolumeData data;
+    MUON_CHECK(BuildSparseCloudVolume(density.data(), dims, origin, 1.0f, 0.0f, data));
+    MUON_CHECK(SaveSparseCloudVolume(data, kVolumePath));
+
+    std::vector<uint8_t> bytes;
+    MUON_CHECK(LoadFileBytes(kVolumePath, bytes));
+    SparseCloudVolumeHeader valid;
+    memcpy(&valid, bytes.data(), sizeof(valid));
+
+    // Each of these would have Open index outside the mapping if it got through. The wrapping offsets are the ones
+    // where offset + size overflows back into the file.
+    const uint64_t coordBytes = uint64_t(valid.NumBricks) * sizeof(SparseBrickCoord);
+    const uint64_t brickBytes = uint64_t(valid.NumBricks) * SPARSE_BRICK_VOXELS;
+    const uint64_t fileSize = bytes.size();
+
+    struct Corruption
+    {
+        const char* Name;
+        uint64_t SparseCloudVolumeHeader::* Offset;
+        uint64_t Value;
+    };
+    const Corruption corruptions[] =
+    {
+        { "indirection past the end", &SparseCloudVolumeHeader::IndirectionOffset, fileSize },
+        { "indirection wrapping", &SparseCloudVolumeHeader::IndirectionOffset, UINT64_MAX - 3 },
+        { "indirection misaligned", &SparseCloudVolumeHeader::IndirectionOffset, valid.IndirectionOffset + 1 },
+        { "coords past the end", &SparseCloudVolumeHeader::BrickCoordsOffset, fileSize - coordBytes + 8 },
+        { "coords wrapping", &SparseCloudVolumeHeader::BrickCoordsOffset, 0ull - coordBytes + sizeof(SparseCloudVolumeHeader) },
+        { "coords inside the header", &SparseCloudVolumeHeader::BrickCoordsOffset, 0 },
+        { "bricks past the end", &SparseCloudVolumeHeader::BrickDataOffset, fileSize - brickBytes + 1 },
+        { "bricks wrapping", &SparseCloudVolumeHeader::BrickDataOffset, 0ull - brickBytes + sizeof(SparseCloudVolumeHeader) },
+    };
+
+    for (const Corruption& corruption : corruptions)
+    {
+        SparseCloudVolumeHeader header = valid;
+        header.*corruption.Offset = corruption.Value;
+        memcpy(bytes.data(), &header, sizeof(header));
+        MUON_CHECK(WriteBytes(bytes, kCorruptPath));
+
+        SparseCloudVolumeHeader readHeader;
+        SparseCloudVolume volume;
+        const bool rejected = !ReadSparseCloudVolumeHeader(kCorruptPath, readHeader) && !volume.Open(kCorruptPath, 16) && !volume.IsOpen();
+        if (!rejected)
+            std::printf("    Accepted a header with %s\n", corruption.Name);
+        MUON_CHECK(rejected);
+    }
+
+    // Truncated, so the bricks the header promises aren't there
+    memcpy(bytes.data(), &valid, sizeof(valid));
+    bytes.resize(bytes.size() - 1);
+    MUON_CHECK(WriteBytes(bytes, kCorruptPath));
+    SparseCloudVolume truncated;
+    MUON_CHECK(!truncated.Open(kCorruptPath, 16));
+
+    // And the untouched file still opens
+    SparseCloudVolume volume;
+    MUON_CHECK(volume.Open(kVolumePath, 16));
+
+    JobSystem::Destroy();
+}
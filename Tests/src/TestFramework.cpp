@@ -0,0 +1,105 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Minimal headless test and benchmark registry
+----------------------------------------------*/
+#include "TestFramework.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace Muon
+{
+
+namespace
+{
+struct TestCase
+{
+    const char* Name;
+    const char* File;
+    TestFunc Func;
+    bool IsBenchmark;
+};
+
+// Function-local so registration doesn't depend on static initialization order across files
+std::vector<TestCase>& GetTestCases()
+{
+    static std::vector<TestCase> sTestCases;
+    return sTestCases;
+}
+
+size_t sNumFailedChecks = 0;
+}
+
+TestRegistrar::TestRegistrar(const char* name, const char* file, TestFunc func, bool isBenchmark)
+{
+    GetTestCases().push_back({ name, file, func, isBenchmark });
+}
+
+void ReportCheck(bool passed, const char* expr, const char* file, int line)
+{
+    if (passed)
+        return;
+
+    sNumFailedChecks++;
+    std::printf("    %s(%d): check failed: %s\n", file, line, expr);
+}
+
+BenchmarkResult SummarizeRuns(double* runMs, size_t numRuns)
+{
+    std::sort(runMs, runMs + numRuns);
+
+    BenchmarkResult result;
+    result.MinMs = runMs[0];
+    result.MedianMs = runMs[numRuns / 2];
+    return result;
+}
+
+void PrintBenchmark(const char* label, const BenchmarkResult& result, double itemsPerRun, const char* itemName)
+{
+    if (itemsPerRun > 0.0 && result.MedianMs > 0.0)
+    {
+        std::printf("    %-40s min %9.3f ms  median %9.3f ms  %12.0f %s/s\n",
+            label, result.MinMs, result.MedianMs, itemsPerRun * 1000.0 / result.MedianMs, itemName ? itemName : "items");
+    }
+    else
+    {
+        std::printf("    %-40s min %9.3f ms  median %9.3f ms\n", label, result.MinMs, result.MedianMs);
+    }
+}
+
+int RunTests(bool benchmarks, const char* filter)
+{
+    std::vector<TestCase> cases = GetTestCases();
+    // Files register in link order, cases within a file in declaration order
+    std::stable_sort(cases.begin(), cases.end(), [](const TestCase& a, const TestCase& b)
+    {
+        return strcmp(a.File, b.File) < 0;
+    });
+
+    size_t numRun = 0;
+    size_t numFailed = 0;
+    for (const TestCase& test : cases)
+    {
+        if (test.IsBenchmark != benchmarks || (filter && !strstr(test.Name, filter)))
+            continue;
+
+        std::printf("[ RUN  ] %s\n", test.Name);
+        std::fflush(stdout);
+
+        const size_t failedBefore = sNumFailedChecks;
+        test.Func();
+        const bool passed = sNumFailedChecks == failedBefore;
+
+        std::printf("[ %s ] %s\n", passed ? " OK " : "FAIL", test.Name);
+        numRun++;
+        numFailed += passed ? 0 : 1;
+    }
+
+    std::printf("%zu %s run, %zu failed\n", numRun, benchmarks ? "benchmarks" : "tests", numFailed);
+    return numFailed == 0 ? 0 : 1;
+}
+
+}
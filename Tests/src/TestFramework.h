@@ -0,0 +1,70 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Minimal headless test and benchmark registry
+----------------------------------------------*/
+#ifndef MUON_TESTFRAMEWORK_H
+#define MUON_TESTFRAMEWORK_H
+
+#include <chrono>
+#include <stddef.h>
+
+namespace Muon
+{
+
+typedef void (*TestFunc)();
+
+// Registered by the macros below from static initializers, so every test file only has to be part of the project
+struct TestRegistrar
+{
+    TestRegistrar(const char* name, const char* file, TestFunc func, bool isBenchmark);
+};
+
+// Records a failed check and keeps going, so one run reports every broken expectation of a test
+void ReportCheck(bool passed, const char* expr, const char* file, int line);
+
+struct BenchmarkResult
+{
+    double MinMs = 0.0;
+    double MedianMs = 0.0;
+};
+
+BenchmarkResult SummarizeRuns(double* runMs, size_t numRuns);
+
+// Times numRuns calls of fn after one untimed warmup call
+template <typename Fn>
+BenchmarkResult RunBenchmark(size_t numRuns, Fn&& fn)
+{
+    static const size_t kMaxRuns = 64;
+    double runMs[kMaxRuns];
+    numRuns = numRuns < 1 ? 1 : (numRuns > kMaxRuns ? kMaxRuns : numRuns);
+
+    fn();
+    for (size_t i = 0; i < numRuns; ++i)
+    {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        runMs[i] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+    return SummarizeRuns(runMs, numRuns);
+}
+
+// Prints min/median times, plus a throughput when itemsPerRun is non-zero
+void PrintBenchmark(const char* label, const BenchmarkResult& result, double itemsPerRun = 0.0, const char* itemName = nullptr);
+
+// Runs the registered tests, or the benchmarks, whose name contains filter. Returns the process exit code.
+int RunTests(bool benchmarks, const char* filter);
+
+}
+
+#define MUON_TEST_REGISTER(name, isBenchmark) \
+    static void name(); \
+    static Muon::TestRegistrar name##_Registrar(#name, __FILE__, &name, isBenchmark); \
+    static void name()
+
+#define MUON_TEST(name) MUON_TEST_REGISTER(name, false)
+#define MUON_BENCHMARK(name) MUON_TEST_REGISTER(name, true)
+
+#define MUON_CHECK(expr) Muon::ReportCheck(!!(expr), #expr, __FILE__, __LINE__)
+
+#endif
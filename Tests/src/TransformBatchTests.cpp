@@ -0,0 +1,182 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Tests and throughput benchmark for batched transform composition
+----------------------------------------------*/
+#include "TestFramework.h"
+
+#include <Core/JobSystem.h>
+#include <Core/TransformBatch.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <math.h>
+#include <random>
+#include <vector>
+
+namespace
+{
+using namespace Muon;
+
+void MakeTransforms(size_t count, uint32_t seed, TransformsSoA& out_transforms)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    out_transforms.Resize(count);
+    for (size_t i = 0; i != count; ++i)
+    {
+        float rotation[4];
+        float lengthSq = 0.0f;
+        for (float& q : rotation)
+        {
+            q = unit(rng);
+            lengthSq += q * q;
+        }
+        for (float& q : rotation)
+            q /= sqrtf(lengthSq);
+
+        const float position[3] = { unit(rng) * 10.0f, unit(rng) * 10.0f, unit(rng) * 10.0f };
+        const float scale[3] = { unit(rng) + 2.0f, unit(rng) + 2.0f, unit(rng) + 2.0f };
+        out_transforms.Set(i, position, rotation, scale);
+    }
+}
+
+// XMMatrixAffineTransformation's result for transform i, in double
+void ReferenceMatrix(const TransformsSoA& t, size_t i, double out[4][4])
+{
+    const double x = t.RotationX[i], y = t.RotationY[i], z = t.RotationZ[i], w = t.RotationW[i];
+    const double rotation[3][3] =
+    {
+        { 1 - 2 * (y * y + z * z), 2 * (x * y + w * z), 2 * (x * z - w * y) },
+        { 2 * (x * y - w * z), 1 - 2 * (x * x + z * z), 2 * (y * z + w * x) },
+        { 2 * (x * z + w * y), 2 * (y * z - w * x), 1 - 2 * (x * x + y * y) },
+    };
+    const double scale[3] = { t.ScaleX[i], t.ScaleY[i], t.ScaleZ[i] };
+
+    for (uint32_t r = 0; r != 3; ++r)
+    {
+        for (uint32_t c = 0; c != 3; ++c)
+            out[r][c] = rotation[r][c] * scale[r];
+        out[r][3] = 0.0;
+    }
+    out[3][0] = t.PositionX[i];
+    out[3][1] = t.PositionY[i];
+    out[3][2] = t.PositionZ[i];
+    out[3][3] = 1.0;
+}
+
+double MaxError(const TransformsSoA& t, size_t begin, const DirectX::XMFLOAT4X4* pMatrices, size_t count, MatrixLayout layout)
+{
+    double maxError = 0.0;
+    for (size_t i = 0; i != count; ++i)
+    {
+        double expected[4][4];
+        ReferenceMatrix(t, begin + i, expected);
+        for (uint32_t r = 0; r != 4; ++r)
+        {
+            for (uint32_t c = 0; c != 4; ++c)
+            {
+                const float value = layout == MatrixLayout::RowMajor ? pMatrices[i].m[r][c] : pMatrices[i].m[c][r];
+                maxError = std::max(maxError, fabs(value - expected[r][c]) / std::max(1.0, fabs(expected[r][c])));
+            }
+        }
+    }
+    return maxError;
+}
+
+static const float kGuard = 12345.0f;
+}
+
+MUON_TEST(TransformBatch_MatchesReference)
+{
+    // Counts off the SIMD group width and large enough to be split across jobs
+    const size_t counts[] = { 0, 1, 3, 4, 8, 9, 17, 4096, 20000, 100003 };
+    const MatrixLayout layouts[] = { MatrixLayout::RowMajor, MatrixLayout::ColumnMajor };
+
+    JobSystem::Init(3);
+    for (size_t count : counts)
+    {
+        TransformsSoA transforms;
+        MakeTransforms(count, static_cast<uint32_t>(count), transforms);
+
+        for (MatrixLayout layout : layouts)
+        {
+            // One extra matrix catches writes past the end
+            std::vector<DirectX::XMFLOAT4X4> matrices(count + 1);
+            matrices[count].m[0][0] = kGuard;
+            ComposeTransforms(transforms, matrices.data(), layout);
+
+            const double maxError = MaxError(transforms, 0, matrices.data(), count, layout);
+            if (maxError > 1e-6)
+                std::printf("    %zu transforms, max relative error %g\n", count, maxError);
+            MUON_CHECK(maxError <= 1e-6);
+            MUON_CHECK(matrices[count].m[0][0] == kGuard);
+        }
+    }
+    JobSystem::Destroy();
+}
+
+MUON_TEST(TransformBatch_Ranges)
+{
+    // Every range of a count that ends right at the padding, including ones starting off a group boundary
+    const size_t counts[] = { 5, 8, 16, 19 };
+    for (size_t count : counts)
+    {
+        TransformsSoA transforms;
+        MakeTransforms(count, 7, transforms);
+        for (size_t begin = 0; begin != count; ++begin)
+        {
+            for (size_t end = begin; end <= count; ++end)
+            {
+                std::vector<DirectX::XMFLOAT4X4> matrices(end - begin + 1);
+                matrices[end - begin].m[0][0] = kGuard;
+                ComposeTransforms(transforms, begin, end, matrices.data());
+
+                MUON_CHECK(MaxError(transforms, begin, matrices.data(), end - begin, MatrixLayout::RowMajor) <= 1e-6);
+                MUON_CHECK(matrices[end - begin].m[0][0] == kGuard);
+            }
+        }
+    }
+}
+
+MUON_BENCHMARK(TransformBatch_Throughput)
+{
+    JobSystem::Init();
+
+    // In cache, then bound by the matrix writes
+    const size_t counts[] = { 4096, 100000 };
+    for (size_t count : counts)
+    {
+        TransformsSoA transforms;
+        MakeTransforms(count, 1, transforms);
+        std::vector<DirectX::XMFLOAT4X4> matrices(count);
+
+        const BenchmarkResult rowResult = RunBenchmark(50, [&]() { ComposeTransforms(transforms, matrices.data(), MatrixLayout::RowMajor); });
+        const BenchmarkResult columnResult = RunBenchmark(50, [&]() { ComposeTransforms(transforms, matrices.data(), MatrixLayout::ColumnMajor); });
+
+        // One matrix at a time with the same math, what the batch replaces
+        const BenchmarkResult scalarResult = RunBenchmark(50, [&]()
+        {
+            for (size_t i = 0; i != count; ++i)
+            {
+                const float x = transforms.RotationX[i], y = transforms.RotationY[i], z = transforms.RotationZ[i], w = transforms.RotationW[i];
+                const float sx = transforms.ScaleX[i], sy = transforms.ScaleY[i], sz = transforms.ScaleZ[i];
+                DirectX::XMFLOAT4X4& m = matrices[i];
+                m.m[0][0] = (1 - 2 * (y * y + z * z)) * sx; m.m[0][1] = 2 * (x * y + w * z) * sx; m.m[0][2] = 2 * (x * z - w * y) * sx; m.m[0][3] = 0;
+                m.m[1][0] = 2 * (x * y - w * z) * sy; m.m[1][1] = (1 - 2 * (x * x + z * z)) * sy; m.m[1][2] = 2 * (y * z + w * x) * sy; m.m[1][3] = 0;
+                m.m[2][0] = 2 * (x * z + w * y) * sz; m.m[2][1] = 2 * (y * z - w * x) * sz; m.m[2][2] = (1 - 2 * (x * x + y * y)) * sz; m.m[2][3] = 0;
+                m.m[3][0] = transforms.PositionX[i]; m.m[3][1] = transforms.PositionY[i]; m.m[3][2] = transforms.PositionZ[i]; m.m[3][3] = 1;
+            }
+        });
+
+        char label[64];
+        std::snprintf(label, sizeof(label), "ComposeTransforms, %zu, row major", count);
+        PrintBenchmark(label, rowResult, (double)count, "transforms");
+        std::snprintf(label, sizeof(label), "ComposeTransforms, %zu, column major", count);
+        PrintBenchmark(label, columnResult, (double)count, "transforms");
+        std::snprintf(label, sizeof(label), "Per transform loop, %zu", count);
+        PrintBenchmark(label, scalarResult, (double)count, "transforms");
+    }
+
+    JobSystem::Destroy();
+}
@@ -0,0 +1,267 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Tests against a recursive reference and the 100k node update benchmark for the transform hierarchy
+----------------------------------------------*/
+#include "TestFramework.h"
+
+#include <Core/JobSystem.h>
+#include <Core/TransformHierarchy.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <math.h>
+#include <random>
+#include <string.h>
+#include <vector>
+
+namespace
+{
+using namespace Muon;
+
+struct LocalTransform
+{
+    float Position[3] = { 0.0f, 0.0f, 0.0f };
+    float Rotation[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+    float Scale[3] = { 1.0f, 1.0f, 1.0f };
+};
+
+struct ReferenceNode
+{
+    uint32_t Parent = TRANSFORM_INVALID; // Handle
+    LocalTransform Local;
+    bool Alive = false;
+};
+
+// scale * rotation * translation, row vector convention, in double so the reference doesn't share the hierarchy's rounding
+void ComposeLocal(const LocalTransform& t, double out[4][4])
+{
+    const double x = t.Rotation[0], y = t.Rotation[1], z = t.Rotation[2], w = t.Rotation[3];
+    const double rotation[3][3] =
+    {
+        { 1 - 2 * (y * y + z * z), 2 * (x * y + w * z), 2 * (x * z - w * y) },
+        { 2 * (x * y - w * z), 1 - 2 * (x * x + z * z), 2 * (y * z + w * x) },
+        { 2 * (x * z + w * y), 2 * (y * z - w * x), 1 - 2 * (x * x + y * y) },
+    };
+
+    for (uint32_t r = 0; r != 3; ++r)
+    {
+        for (uint32_t c = 0; c != 3; ++c)
+            out[r][c] = rotation[r][c] * t.Scale[r];
+        out[r][3] = 0.0;
+        out[3][r] = t.Position[r];
+    }
+    out[3][3] = 1.0;
+}
+
+void ReferenceWorld(const std::vector<ReferenceNode>& nodes, uint32_t handle, double out[4][4])
+{
+    ComposeLocal(nodes[handle].Local, out);
+    if (nodes[handle].Parent == TRANSFORM_INVALID)
+        return;
+
+    double parent[4][4], local[4][4];
+    ReferenceWorld(nodes, nodes[handle].Parent, parent);
+    memcpy(local, out, sizeof(local));
+    for (uint32_t r = 0; r != 4; ++r)
+    {
+        for (uint32_t c = 0; c != 4; ++c)
+            out[r][c] = local[r][0] * parent[0][c] + local[r][1] * parent[1][c] + local[r][2] * parent[2][c] + local[r][3] * parent[3][c];
+    }
+}
+
+LocalTransform RandomLocal(std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> position(-5.0f, 5.0f), unit(-1.0f, 1.0f), scale(0.5f, 1.5f);
+
+    LocalTransform t;
+    float lengthSq = 0.0f;
+    for (uint32_t k = 0; k != 4; ++k)
+    {
+        t.Rotation[k] = unit(rng);
+        lengthSq += t.Rotation[k] * t.Rotation[k];
+    }
+    for (uint32_t k = 0; k != 4; ++k)
+        t.Rotation[k] /= sqrtf(lengthSq);
+
+    for (uint32_t k = 0; k != 3; ++k)
+    {
+        t.Position[k] = position(rng);
+        t.Scale[k] = scale(rng);
+    }
+    return t;
+}
+
+void SetLocal(TransformHierarchy& hierarchy, uint32_t handle, const LocalTransform& t)
+{
+    hierarchy.SetLocalPosition(handle, t.Position[0], t.Position[1], t.Position[2]);
+    hierarchy.SetLocalRotation(handle, t.Rotation[0], t.Rotation[1], t.Rotation[2], t.Rotation[3]);
+    hierarchy.SetLocalScale(handle, t.Scale[0], t.Scale[1], t.Scale[2]);
+}
+
+// Deep random tree: each node picks a parent among the last few created, so levels stay wide but chains get long
+void BuildRandomTree(uint32_t count, uint32_t seed, TransformHierarchy& out_hierarchy, std::vector<uint32_t>& out_handles)
+{
+    std::mt19937 rng(seed);
+    out_hierarchy.Clear();
+    out_handles.clear();
+    for (uint32_t i = 0; i != count; ++i)
+    {
+        const uint32_t parent = (i < 16 || rng() % 64 == 0) ? TRANSFORM_INVALID : out_handles[i - 1 - rng() % std::min<uint32_t>(i, 4096)];
+        out_handles.push_back(out_hierarchy.Create(parent));
+        SetLocal(out_hierarchy, out_handles.back(), RandomLocal(rng));
+    }
+    out_hierarchy.Update();
+}
+}
+
+MUON_TEST(TransformHierarchy_MatchesReference)
+{
+    JobSystem::Init(3);
+
+    std::mt19937 rng(5);
+    TransformHierarchy hierarchy;
+    std::vector<ReferenceNode> nodes;
+    std::vector<uint32_t> alive;
+
+    double maxError = 0.0;
+    bool countsMatch = true;
+    for (uint32_t iter = 0; iter != 2000; ++iter)
+    {
+        const uint32_t op = rng() % 10;
+        if (op < 6 || alive.empty())
+        {
+            const uint32_t parent = (alive.empty() || rng() % 4 == 0) ? TRANSFORM_INVALID : alive[rng() % alive.size()];
+            const uint32_t handle = hierarchy.Create(parent);
+            if (handle >= nodes.size())
+                nodes.resize(handle + 1);
+
+            nodes[handle] = ReferenceNode();
+            nodes[handle].Parent = parent;
+            nodes[handle].Alive = true;
+            if (rng() % 2)
+            {
+                nodes[handle].Local = RandomLocal(rng);
+                SetLocal(hierarchy, handle, nodes[handle].Local);
+            }
+            alive.push_back(handle);
+        }
+        else if (op < 8)
+        {
+            const uint32_t handle = alive[rng() % alive.size()];
+            nodes[handle].Local = RandomLocal(rng);
+            SetLocal(hierarchy, handle, nodes[handle].Local);
+        }
+        else
+        {
+            // Everything below goes with it
+            const uint32_t handle = alive[rng() % alive.size()];
+            hierarchy.Destroy(handle);
+            nodes[handle].Alive = false;
+            for (bool changed = true; changed;)
+            {
+                changed = false;
+                for (uint32_t h : alive)
+                {
+                    if (nodes[h].Alive && nodes[h].Parent != TRANSFORM_INVALID && !nodes[nodes[h].Parent].Alive)
+                    {
+                        nodes[h].Alive = false;
+                        changed = true;
+                    }
+                }
+            }
+            alive.erase(std::remove_if(alive.begin(), alive.end(), [&](uint32_t h) { return !nodes[h].Alive; }), alive.end());
+        }
+
+        if (rng() % 3 != 0)
+            continue;
+
+        hierarchy.Update();
+        countsMatch &= hierarchy.GetCount() == alive.size();
+        for (uint32_t handle : alive)
+        {
+            double expected[4][4];
+            ReferenceWorld(nodes, handle, expected);
+            const DirectX::XMFLOAT4X4& world = hierarchy.GetWorld(handle);
+            MUON_CHECK(&hierarchy.GetWorldMatrices()[hierarchy.GetWorldIndex(handle)] == &world);
+            for (uint32_t r = 0; r != 4; ++r)
+            {
+                for (uint32_t c = 0; c != 4; ++c)
+                    maxError = std::max(maxError, fabs(world.m[r][c] - expected[r][c]) / std::max(1.0, fabs(expected[r][c])));
+            }
+        }
+    }
+
+    if (maxError > 1e-4)
+        std::printf("    Max relative error %g\n", maxError);
+    MUON_CHECK(maxError <= 1e-4);
+    MUON_CHECK(countsMatch);
+
+    JobSystem::Destroy();
+}
+
+MUON_TEST(TransformHierarchy_OnlyUpdatesDirtySubtrees)
+{
+    JobSystem::Init(0);
+
+    TransformHierarchy hierarchy;
+    const uint32_t root = hierarchy.Create();
+    const uint32_t child = hierarchy.Create(root);
+    const uint32_t grandchild = hierarchy.Create(child);
+    const uint32_t other = hierarchy.Create();
+    hierarchy.Update();
+    MUON_CHECK(hierarchy.GetStats().NumUpdated == 4);
+
+    hierarchy.Update();
+    MUON_CHECK(hierarchy.GetStats().NumUpdated == 0);
+
+    hierarchy.SetLocalPosition(child, 1.0f, 2.0f, 3.0f);
+    hierarchy.Update();
+    MUON_CHECK(hierarchy.GetStats().NumUpdated == 2);
+    MUON_CHECK(hierarchy.GetWorld(grandchild).m[3][0] == 1.0f && hierarchy.GetWorld(grandchild).m[3][2] == 3.0f);
+    MUON_CHECK(hierarchy.GetWorld(other).m[3][0] == 0.0f);
+    MUON_CHECK(hierarchy.GetStats().NumLevels == 3);
+
+    JobSystem::Destroy();
+}
+
+MUON_BENCHMARK(TransformHierarchy_Update100k)
+{
+    static const uint32_t kNumNodes = 100000;
+    JobSystem::Init();
+
+    TransformHierarchy hierarchy;
+    std::vector<uint32_t> handles;
+    BuildRandomTree(kNumNodes, 1, hierarchy, handles);
+
+    std::mt19937 rng(2);
+    std::vector<uint32_t> someMoved(kNumNodes / 100);
+    for (uint32_t& h : someMoved)
+        h = handles[rng() % kNumNodes];
+
+    // Positions only, alternating between two values
+    float offset = 0.1f;
+    auto moveAndUpdate = [&](const std::vector<uint32_t>& moved)
+    {
+        offset = -offset;
+        for (uint32_t h : moved)
+            hierarchy.SetLocalPosition(h, offset, offset, offset);
+        hierarchy.Update();
+    };
+
+    const BenchmarkResult allResult = RunBenchmark(20, [&]() { moveAndUpdate(handles); });
+    const uint32_t allUpdated = hierarchy.GetStats().NumUpdated;
+    const BenchmarkResult someResult = RunBenchmark(20, [&]() { moveAndUpdate(someMoved); });
+    const uint32_t someUpdated = hierarchy.GetStats().NumUpdated;
+    const BenchmarkResult noneResult = RunBenchmark(20, [&]() { hierarchy.Update(); });
+
+    std::printf("    100k nodes, %u levels, %u threads\n", hierarchy.GetStats().NumLevels, JobSystem::GetSingleton().GetNumThreads());
+    char label[64];
+    std::snprintf(label, sizeof(label), "Update, all dirty (%u recomputed)", allUpdated);
+    PrintBenchmark(label, allResult, (double)allUpdated, "nodes");
+    std::snprintf(label, sizeof(label), "Update, 1%% dirty (%u recomputed)", someUpdated);
+    PrintBenchmark(label, someResult, (double)someUpdated, "nodes");
+    PrintBenchmark("Update, nothing dirty", noneResult, 0.0, nullptr);
+
+    JobSystem::Destroy();
+}
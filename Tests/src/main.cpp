@@ -0,0 +1,41 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Tests command line entry point
+----------------------------------------------*/
+#include "TestFramework.h"
+
+#include <cstdio>
+#include <cstring>
+
+static void PrintUsage()
+{
+    std::printf(
+        "Usage: Tests [options] [filter]\n"
+        "  --bench        Run the benchmarks instead of the tests\n"
+        "  filter         Only run cases whose name contains this string\n");
+}
+
+int main(int argc, char** argv)
+{
+    bool benchmarks = false;
+    const char* filter = nullptr;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const char* arg = argv[i];
+
+        if (!strcmp(arg, "--bench"))
+            benchmarks = true;
+        else if (arg[0] != '-' && !filter)
+            filter = arg;
+        else
+        {
+            std::fprintf(stderr, "Error: Unknown argument '%s'\n", arg);
+            PrintUsage();
+            return 2;
+        }
+    }
+
+    return Muon::RunTests(benchmarks, filter);
+}
@@ -0,0 +1,443 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Constant buffer layouts read back from DXC disassembly, and the C++ header generated from them
+----------------------------------------------*/
+#include "CBufferLayout.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+namespace Muon
+{
+
+// HLSL packs cbuffer members into 16 byte registers
+static const uint32_t kRegisterSize = 16;
+
+static uint32_t AlignToRegister(uint32_t size)
+{
+    return (size + kRegisterSize - 1) & ~(kRegisterSize - 1);
+}
+
+static std::string Trim(const std::string& str)
+{
+    const size_t first = str.find_first_not_of(" \t\r");
+    if (first == std::string::npos)
+        return std::string();
+
+    const size_t last = str.find_last_not_of(" \t\r");
+    return str.substr(first, last - first + 1);
+}
+
+static bool StartsWith(const std::string& str, const char* prefix)
+{
+    return str.compare(0, strlen(prefix), prefix) == 0;
+}
+
+struct HLSLTypeInfo
+{
+    const char* HLSLName;
+    const char* CppName;
+    uint32_t Size;
+};
+
+// Only types with an identical C++ layout are mirrored. Matrices other than float4x4 pack differently depending on their majorness.
+static const HLSLTypeInfo kTypeInfos[] =
+{
+    { "float",    "float",                   4 },
+    { "float2",   "DirectX::XMFLOAT2",       8 },
+    { "float3",   "DirectX::XMFLOAT3",      12 },
+    { "float4",   "DirectX::XMFLOAT4",      16 },
+    { "int",      "int32_t",                 4 },
+    { "int2",     "DirectX::XMINT2",         8 },
+    { "int3",     "DirectX::XMINT3",        12 },
+    { "int4",     "DirectX::XMINT4",        16 },
+    { "uint",     "uint32_t",                4 },
+    { "dword",    "uint32_t",                4 },
+    { "uint2",    "DirectX::XMUINT2",        8 },
+    { "uint3",    "DirectX::XMUINT3",       12 },
+    { "uint4",    "DirectX::XMUINT4",       16 },
+    { "bool",     "uint32_t",                4 },
+    { "float4x4", "DirectX::XMFLOAT4X4",    64 },
+};
+
+static const HLSLTypeInfo* FindTypeInfo(const std::string& hlslType)
+{
+    for (const HLSLTypeInfo& info : kTypeInfos)
+    {
+        if (hlslType == info.HLSLName)
+            return &info;
+    }
+
+    return nullptr;
+}
+
+static const CBufferStruct* FindStruct(const std::vector<CBufferStruct>& structs, const std::string& name)
+{
+    for (const CBufferStruct& s : structs)
+    {
+        if (s.Name == name)
+            return &s;
+    }
+
+    return nullptr;
+}
+
+static bool GetMemberSize(const CBufferMember& member, const std::vector<CBufferStruct>& structs, uint32_t& out_elementSize)
+{
+    if (member.IsStruct)
+    {
+        const CBufferStruct* pStruct = FindStruct(structs, member.Type);
+        if (!pStruct)
+            return false;
+
+        out_elementSize = pStruct->Size;
+        return true;
+    }
+
+    const HLSLTypeInfo* pInfo = FindTypeInfo(member.Type);
+    if (!pInfo)
+        return false;
+
+    out_elementSize = pInfo->Size;
+    return true;
+}
+
+// Array elements each start on a new register, so the last one is the only one without padding
+static uint32_t GetMemberEnd(const CBufferMember& member, uint32_t elementSize)
+{
+    if (member.ArraySize <= 1)
+        return member.Offset + elementSize;
+
+    return member.Offset + AlignToRegister(elementSize) * (member.ArraySize - 1) + elementSize;
+}
+
+static bool SameLayout(const CBufferStruct& a, const CBufferStruct& b)
+{
+    if (a.Size != b.Size || a.Members.size() != b.Members.size())
+        return false;
+
+    for (size_t i = 0; i != a.Members.size(); ++i)
+    {
+        const CBufferMember& ma = a.Members[i];
+        const CBufferMember& mb = b.Members[i];
+        if (ma.Type != mb.Type || ma.Name != mb.Name || ma.Offset != mb.Offset || ma.ArraySize != mb.ArraySize)
+            return false;
+    }
+
+    return true;
+}
+
+static bool MergeStruct(std::vector<CBufferStruct>& structs, CBufferStruct&& s, const char* kind, const std::string& sourceName)
+{
+    for (const CBufferStruct& existing : structs)
+    {
+        if (existing.Name != s.Name)
+            continue;
+
+        if (SameLayout(existing, s))
+            return true;
+
+        std::fprintf(stderr, "Error: %s %s in %s is declared differently by another shader!\n", kind, s.Name.c_str(), sourceName.c_str());
+        return false;
+    }
+
+    structs.push_back(std::move(s));
+    return true;
+}
+
+// "float3 name[2];   ; Offset:   16 Size: 28" -> declaration, offset and optional size
+static bool SplitLayoutComment(const std::string& line, std::string& out_decl, uint32_t& out_offset, uint32_t& out_size)
+{
+    const size_t commentPos = line.find("; Offset:");
+    if (commentPos == std::string::npos)
+        return false;
+
+    out_decl = Trim(line.substr(0, commentPos));
+    out_offset = static_cast<uint32_t>(std::strtoul(line.c_str() + commentPos + 9, nullptr, 10));
+
+    const size_t sizePos = line.find("Size:", commentPos);
+    out_size = sizePos == std::string::npos ? 0 : static_cast<uint32_t>(std::strtoul(line.c_str() + sizePos + 5, nullptr, 10));
+    return true;
+}
+
+// "name[4];" -> name, 4
+static void ParseDeclaratorName(std::string decl, std::string& out_name, uint32_t& out_arraySize)
+{
+    if (!decl.empty() && decl.back() == ';')
+        decl.pop_back();
+
+    out_arraySize = 0;
+    const size_t bracket = decl.find('[');
+    if (bracket != std::string::npos)
+    {
+        out_arraySize = static_cast<uint32_t>(std::strtoul(decl.c_str() + bracket + 1, nullptr, 10));
+        decl = decl.substr(0, bracket);
+    }
+
+    out_name = Trim(decl);
+}
+
+bool ParseCBufferLayouts(const std::string& disassembly, const std::string& sourceName, CBufferLayoutSet& out_set)
+{
+    struct Frame
+    {
+        CBufferStruct Struct;
+        bool IsRoot = false;
+    };
+
+    std::istringstream stream(disassembly);
+    std::string rawLine;
+
+    bool inDefinitions = false;
+    bool inCBuffer = false;
+    bool skipping = false; // Inside a tbuffer or other block that isn't mirrored
+    std::string cbufferName;
+    std::vector<Frame> frames;
+
+    while (std::getline(stream, rawLine))
+    {
+        std::string line = Trim(rawLine);
+        if (line.empty() || line[0] != ';')
+        {
+            if (inDefinitions)
+                break;
+            continue;
+        }
+
+        line = Trim(line.substr(1));
+
+        if (!inDefinitions)
+        {
+            inDefinitions = line == "Buffer Definitions:";
+            continue;
+        }
+
+        if (line == "Resource Bindings:")
+            break;
+
+        if (line.empty() || line == "{")
+            continue;
+
+        if (!inCBuffer && !skipping)
+        {
+            if (StartsWith(line, "cbuffer "))
+            {
+                cbufferName = Trim(line.substr(8));
+                inCBuffer = true;
+            }
+            else if (StartsWith(line, "tbuffer "))
+            {
+                skipping = true;
+            }
+            continue;
+        }
+
+        if (skipping)
+        {
+            // Only the block's own closing brace stands alone at the end
+            if (line == "}")
+                skipping = false;
+            continue;
+        }
+
+        if (line == "}")
+        {
+            inCBuffer = false;
+            continue;
+        }
+
+        if (StartsWith(line, "struct ") && line.find(';') == std::string::npos)
+        {
+            std::string name = Trim(line.substr(7));
+            if (StartsWith(name, "struct."))
+                name = name.substr(7);
+
+            Frame frame;
+            frame.IsRoot = frames.empty();
+            frame.Struct.Name = frame.IsRoot ? cbufferName : name;
+            frames.push_back(std::move(frame));
+            continue;
+        }
+
+        std::string decl;
+        uint32_t offset = 0, size = 0;
+        if (!SplitLayoutComment(line, decl, offset, size))
+            continue;
+
+        if (frames.empty())
+        {
+            std::fprintf(stderr, "Error: Unexpected line in the buffer definitions of %s: %s\n", sourceName.c_str(), line.c_str());
+            return false;
+        }
+
+        if (decl[0] == '}')
+        {
+            Frame frame = std::move(frames.back());
+            frames.pop_back();
+
+            CBufferStruct& s = frame.Struct;
+            if (frame.IsRoot)
+            {
+                s.Size = size;
+                if (!MergeStruct(out_set.CBuffers, std::move(s), "cbuffer", sourceName))
+                    return false;
+                continue;
+            }
+
+            // Nested offsets are printed relative to the cbuffer, make them relative to the struct
+            const bool absolute = !s.Members.empty() && s.Members.front().Offset == offset;
+            uint32_t end = 0;
+            for (CBufferMember& member : s.Members)
+            {
+                if (absolute)
+                    member.Offset -= offset;
+
+                uint32_t elementSize = 0;
+                if (!GetMemberSize(member, out_set.Structs, elementSize))
+                {
+                    std::fprintf(stderr, "Error: %s.%s in %s has unsupported type %s!\n", s.Name.c_str(), member.Name.c_str(), sourceName.c_str(), member.Type.c_str());
+                    return false;
+                }
+                end = std::max(end, GetMemberEnd(member, elementSize));
+            }
+            s.Size = AlignToRegister(end); // Whatever follows a struct starts on a new register
+
+            CBufferMember member;
+            member.Type = s.Name;
+            member.Offset = offset;
+            member.IsStruct = true;
+            ParseDeclaratorName(Trim(decl.substr(1)), member.Name, member.ArraySize);
+            frames.back().Struct.Members.push_back(member);
+
+            if (!MergeStruct(out_set.Structs, std::move(s), "struct", sourceName))
+                return false;
+            continue;
+        }
+
+        // Majorness only matters for the non-square matrices, which are rejected when the header is generated
+        if (StartsWith(decl, "row_major "))
+            decl = Trim(decl.substr(10));
+        else if (StartsWith(decl, "column_major "))
+            decl = Trim(decl.substr(13));
+
+        const size_t typeEnd = decl.find_first_of(" \t");
+        if (typeEnd == std::string::npos)
+            continue;
+
+        CBufferMember member;
+        member.Type = decl.substr(0, typeEnd);
+        member.Offset = offset;
+        ParseDeclaratorName(decl.substr(typeEnd + 1), member.Name, member.ArraySize);
+        frames.back().Struct.Members.push_back(member);
+    }
+
+    return true;
+}
+
+static bool AppendStruct(const CBufferStruct& s, bool isCBuffer, const std::vector<CBufferStruct>& structs, std::ostringstream& out)
+{
+    const std::string cppName = isCBuffer ? "cb" + s.Name : s.Name;
+
+    std::vector<CBufferMember> members = s.Members;
+    std::sort(members.begin(), members.end(), [](const CBufferMember& a, const CBufferMember& b) { return a.Offset < b.Offset; });
+
+    std::ostringstream asserts;
+    out << "struct alignas(16) " << cppName << "\n{\n";
+    if (isCBuffer)
+        out << "    static constexpr const char* kName = \"" << s.Name << "\";\n\n";
+
+    uint32_t cursor = 0;
+    uint32_t padIndex = 0;
+    auto appendPadding = [&](uint32_t bytes)
+    {
+        const uint32_t dwords = bytes / 4;
+        if (dwords == 1)
+            out << "    uint32_t _pad" << padIndex++ << " = 0;\n";
+        else if (dwords > 1)
+            out << "    uint32_t _pad" << padIndex++ << "[" << dwords << "] = {};\n";
+    };
+
+    for (const CBufferMember& member : members)
+    {
+        uint32_t elementSize = 0;
+        if (!GetMemberSize(member, structs, elementSize))
+        {
+            std::fprintf(stderr, "Error: %s.%s has type %s, which has no C++ mirror!\n", s.Name.c_str(), member.Name.c_str(), member.Type.c_str());
+            return false;
+        }
+
+        // HLSL pads every array element to a register, C++ arrays don't
+        if (member.ArraySize > 1 && elementSize % kRegisterSize != 0)
+        {
+            std::fprintf(stderr, "Error: %s.%s is an array of %s, which packs differently in C++. Use a 16 byte element type.\n", s.Name.c_str(), member.Name.c_str(), member.Type.c_str());
+            return false;
+        }
+
+        if (member.Offset < cursor)
+        {
+            std::fprintf(stderr, "Error: %s.%s overlaps the previous member!\n", s.Name.c_str(), member.Name.c_str());
+            return false;
+        }
+
+        appendPadding(member.Offset - cursor);
+
+        const HLSLTypeInfo* pInfo = member.IsStruct ? nullptr : FindTypeInfo(member.Type);
+        out << "    " << (pInfo ? pInfo->CppName : member.Type.c_str()) << " " << member.Name;
+        if (member.ArraySize > 0)
+            out << "[" << member.ArraySize << "]";
+        out << " = {};\n";
+
+        asserts << "static_assert(offsetof(" << cppName << ", " << member.Name << ") == " << member.Offset << ", \"" << cppName << "::" << member.Name << " doesn't match the HLSL layout\");\n";
+        cursor = GetMemberEnd(member, elementSize);
+    }
+
+    const uint32_t size = AlignToRegister(std::max(cursor, s.Size));
+    appendPadding(size - cursor);
+    out << "};\n";
+
+    out << asserts.str();
+    out << "static_assert(sizeof(" << cppName << ") == " << size << ", \"" << cppName << " doesn't match the HLSL layout\");\n\n";
+    return true;
+}
+
+bool GenerateCBufferHeader(const CBufferLayoutSet& set, std::string& out_header)
+{
+    std::vector<CBufferStruct> cbuffers = set.CBuffers;
+    std::sort(cbuffers.begin(), cbuffers.end(), [](const CBufferStruct& a, const CBufferStruct& b) { return a.Name < b.Name; });
+
+    std::ostringstream out;
+    out << "/*----------------------------------------------\n"
+           "Generated by ShaderBuild from the compiled shaders' reflection data. Do not edit by hand,\n"
+           "rebuild the Shaders project instead.\n"
+           "Description : C++ mirrors of the HLSL constant buffers\n"
+           "----------------------------------------------*/\n"
+           "#ifndef MUON_SHADERCBUFFERS_H\n"
+           "#define MUON_SHADERCBUFFERS_H\n\n"
+           "#include <DirectXMath.h>\n"
+           "#include <cstddef>\n"
+           "#include <stdint.h>\n\n"
+           "namespace Muon\n{\n\n";
+
+    // Nested structs are parsed before the structs that contain them, so this order already compiles
+    for (const CBufferStruct& s : set.Structs)
+    {
+        if (!AppendStruct(s, false, set.Structs, out))
+            return false;
+    }
+
+    for (const CBufferStruct& s : cbuffers)
+    {
+        if (!AppendStruct(s, true, set.Structs, out))
+            return false;
+    }
+
+    out << "}\n\n#endif\n";
+    out_header = out.str();
+    return true;
+}
+
+}
@@ -0,0 +1,48 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Constant buffer layouts read back from DXC disassembly, and the C++ header generated from them
+----------------------------------------------*/
+#ifndef MUON_CBUFFERLAYOUT_H
+#define MUON_CBUFFERLAYOUT_H
+
+#include <filesystem>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace Muon
+{
+
+struct CBufferMember
+{
+    std::string Type;       // HLSL type, or the struct name for nested structs
+    std::string Name;
+    uint32_t Offset = 0;    // Relative to the enclosing struct
+    uint32_t ArraySize = 0; // 0 if not an array
+    bool IsStruct = false;
+};
+
+struct CBufferStruct
+{
+    std::string Name;
+    std::vector<CBufferMember> Members;
+    uint32_t Size = 0; // As reported by the compiler for cbuffers, computed for nested structs
+};
+
+struct CBufferLayoutSet
+{
+    std::vector<CBufferStruct> CBuffers;
+    std::vector<CBufferStruct> Structs; // Nested struct types used by the cbuffers
+};
+
+// Reads the "Buffer Definitions" block that dxc -Fc writes at the top of its disassembly.
+// Layouts are merged into out_set; a cbuffer or struct that is declared differently by two shaders is an error.
+bool ParseCBufferLayouts(const std::string& disassembly, const std::string& sourceName, CBufferLayoutSet& out_set);
+
+// Emits packed C++ structs with explicit padding and static_asserted offsets. Returns false on HLSL types it can't mirror.
+bool GenerateCBufferHeader(const CBufferLayoutSet& set, std::string& out_header);
+
+}
+
+#endif
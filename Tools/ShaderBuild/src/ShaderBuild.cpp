@@ -0,0 +1,397 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Incremental offline shader build through the DXC command line
+----------------------------------------------*/
+#include "ShaderBuild.h"
+
+#include "CBufferLayout.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <thread>
+
+namespace Muon
+{
+namespace fs = std::filesystem;
+
+// Bump whenever the compile arguments change, so every output is rebuilt once
+static const uint32_t kShaderBuildVersion = 2;
+static const char* kManifestHeader = "# ShaderBuild manifest v1";
+static const char* kManifestName = "ShaderBuild.manifest";
+// Disassembly only feeds the cbuffer header. It lives in a subfolder so nothing scanning the output folder mistakes it for a shader.
+static const char* kDisassemblyDir = "asm";
+
+static uint64_t Fnv1a64(const void* data, size_t size, uint64_t hash = 0xCBF29CE484222325ull)
+{
+    const unsigned char* ptr = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i != size; ++i)
+        hash = (ptr[i] ^ hash) * 0x00000100000001B3ull;
+
+    return hash;
+}
+
+static uint64_t Fnv1a64(const std::string& str, uint64_t hash)
+{
+    return Fnv1a64(str.data(), str.size(), hash);
+}
+
+static bool ReadTextFile(const fs::path& path, std::string& out_text)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+
+    std::ostringstream stream;
+    stream << file.rdbuf();
+    out_text = stream.str();
+    return true;
+}
+
+// Both "quoted" and <angled> includes are followed, first relative to the including file then to the source folder
+static void ScanIncludes(const fs::path& file, const fs::path& sourceDir, std::set<fs::path>& visited, std::vector<fs::path>& out_dependencies, uint64_t& hash)
+{
+    std::string text;
+    if (!ReadTextFile(file, text))
+        return;
+
+    hash = Fnv1a64(text, hash);
+
+    size_t pos = 0;
+    while ((pos = text.find("#include", pos)) != std::string::npos)
+    {
+        pos += 8;
+        while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\t'))
+            pos++;
+
+        if (pos >= text.size() || (text[pos] != '"' && text[pos] != '<'))
+            continue;
+
+        const char closeChar = text[pos] == '"' ? '"' : '>';
+        const size_t close = text.find(closeChar, pos + 1);
+        if (close == std::string::npos)
+            break;
+
+        const std::string name = text.substr(pos + 1, close - pos - 1);
+        pos = close + 1;
+
+        fs::path resolved = file.parent_path() / name;
+        if (!fs::exists(resolved))
+            resolved = sourceDir / name;
+
+        std::error_code ec;
+        resolved = fs::weakly_canonical(resolved, ec);
+        if (!visited.insert(resolved).second)
+            continue;
+
+        if (!fs::exists(resolved))
+        {
+            // Missing includes still count, so creating the file later makes the shader stale
+            hash = Fnv1a64(name, hash);
+            continue;
+        }
+
+        out_dependencies.push_back(resolved);
+        ScanIncludes(resolved, sourceDir, visited, out_dependencies, hash);
+    }
+}
+
+static const char* GetProfileFromName(const std::string& stem)
+{
+    if (stem.size() < 2)
+        return nullptr;
+
+    const std::string suffix = stem.substr(stem.size() - 2);
+    if (suffix == "VS") return "vs_6_0";
+    if (suffix == "PS") return "ps_6_0";
+    if (suffix == "CS") return "cs_6_0";
+    return nullptr;
+}
+
+static std::string GetCompilerArguments(const ShaderBuildOptions& options)
+{
+    return options.Debug ? "-Zi -Qembed_debug -Od" : "-O3";
+}
+
+bool GatherShaderBuildItems(const ShaderBuildOptions& options, std::vector<ShaderBuildItem>& out_items)
+{
+    std::error_code ec;
+    if (!fs::is_directory(options.SourceDir, ec))
+    {
+        std::fprintf(stderr, "Error: Shader source folder '%s' doesn't exist!\n", options.SourceDir.string().c_str());
+        return false;
+    }
+
+    const fs::path sourceDir = fs::weakly_canonical(options.SourceDir, ec);
+    const std::string arguments = GetCompilerArguments(options);
+
+    for (const auto& entry : fs::directory_iterator(sourceDir))
+    {
+        if (!entry.is_regular_file() || entry.path().extension() != ".hlsl")
+            continue;
+
+        const std::string stem = entry.path().stem().string();
+        const char* profile = GetProfileFromName(stem);
+        if (!profile)
+        {
+            if (options.Verbose)
+                std::printf("Skipping %s: can't tell the stage from its name\n", entry.path().filename().string().c_str());
+            continue;
+        }
+
+        ShaderBuildItem item;
+        item.Source = entry.path();
+        item.Output = options.OutputDir / (stem + ".cso");
+        item.Disassembly = options.OutputDir / kDisassemblyDir / (stem + ".asm");
+        item.Profile = profile;
+
+        uint64_t hash = Fnv1a64(&kShaderBuildVersion, sizeof(kShaderBuildVersion));
+        hash = Fnv1a64(item.Profile, hash);
+        hash = Fnv1a64(arguments, hash);
+
+        std::set<fs::path> visited = { fs::weakly_canonical(item.Source, ec) };
+        ScanIncludes(item.Source, sourceDir, visited, item.Dependencies, hash);
+        item.Hash = hash;
+
+        out_items.push_back(std::move(item));
+    }
+
+    // Directory iteration order isn't specified, keep the output stable
+    std::sort(out_items.begin(), out_items.end(), [](const ShaderBuildItem& a, const ShaderBuildItem& b) { return a.Source < b.Source; });
+    return true;
+}
+
+bool LoadShaderBuildManifest(const fs::path& path, ShaderBuildManifest& out_manifest)
+{
+    std::ifstream file(path);
+    if (!file)
+        return false;
+
+    std::string line;
+    if (!std::getline(file, line) || line != kManifestHeader)
+        return false;
+
+    // <output> <hash> <dependency>...
+    while (std::getline(file, line))
+    {
+        std::istringstream stream(line);
+        std::string output, hashStr;
+        if (!(stream >> output >> hashStr))
+            continue;
+
+        ShaderBuildManifestEntry entry;
+        entry.Hash = std::strtoull(hashStr.c_str(), nullptr, 16);
+
+        std::string dependency;
+        while (stream >> dependency)
+            entry.Dependencies.push_back(dependency);
+
+        out_manifest[output] = std::move(entry);
+    }
+
+    return true;
+}
+
+bool SaveShaderBuildManifest(const fs::path& path, const ShaderBuildManifest& manifest)
+{
+    std::vector<const ShaderBuildManifest::value_type*> sorted;
+    for (const auto& entry : manifest)
+        sorted.push_back(&entry);
+    std::sort(sorted.begin(), sorted.end(), [](auto* a, auto* b) { return a->first < b->first; });
+
+    // Written next to the real one and swapped in, so an interrupted build never leaves a half written manifest
+    const fs::path tempPath = path.string() + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::trunc);
+        if (!file)
+            return false;
+
+        file << kManifestHeader << '\n';
+        for (const auto* pEntry : sorted)
+        {
+            char hashStr[17];
+            std::snprintf(hashStr, sizeof(hashStr), "%016llx", static_cast<unsigned long long>(pEntry->second.Hash));
+
+            file << pEntry->first << ' ' << hashStr;
+            for (const std::string& dependency : pEntry->second.Dependencies)
+                file << ' ' << dependency;
+            file << '\n';
+        }
+
+        if (!file.good())
+            return false;
+    }
+
+    std::error_code ec;
+    fs::rename(tempPath, path, ec);
+    return !ec;
+}
+
+static std::string Quote(const fs::path& path)
+{
+    return "\"" + path.string() + "\"";
+}
+
+static bool CompileItem(const ShaderBuildOptions& options, const ShaderBuildItem& item, std::string& out_log)
+{
+    const fs::path logPath = item.Output.string() + ".log";
+
+    std::string command = Quote(options.Compiler) + " -nologo -E main -T " + item.Profile +
+        " " + GetCompilerArguments(options) +
+        " -I " + Quote(item.Source.parent_path()) +
+        " -Fo " + Quote(item.Output) +
+        " -Fc " + Quote(item.Disassembly) +
+        " " + Quote(item.Source) +
+        " > " + Quote(logPath) + " 2>&1";
+
+#if defined(_WIN32)
+    // cmd.exe strips the outer quotes of a command line that starts with one
+    command = "\"" + command + "\"";
+#endif
+
+    const int result = std::system(command.c_str());
+
+    ReadTextFile(logPath, out_log);
+    std::error_code ec;
+    fs::remove(logPath, ec);
+
+    return result == 0 && fs::exists(item.Output);
+}
+
+// The header is only rewritten when its contents change, so an unchanged layout doesn't rebuild everything including it
+static bool WriteCBufferHeader(const std::vector<ShaderBuildItem>& items, const fs::path& headerPath)
+{
+    CBufferLayoutSet layouts;
+    for (const ShaderBuildItem& item : items)
+    {
+        std::string disassembly;
+        if (!ReadTextFile(item.Disassembly, disassembly))
+        {
+            std::fprintf(stderr, "Error: Missing disassembly %s, rebuild with --force.\n", item.Disassembly.string().c_str());
+            return false;
+        }
+
+        if (!ParseCBufferLayouts(disassembly, item.Source.filename().string(), layouts))
+            return false;
+    }
+
+    std::string header;
+    if (!GenerateCBufferHeader(layouts, header))
+        return false;
+
+    std::string existing;
+    if (ReadTextFile(headerPath, existing) && existing == header)
+        return true;
+
+    std::ofstream file(headerPath, std::ios::binary | std::ios::trunc);
+    if (!file || !(file << header))
+    {
+        std::fprintf(stderr, "Error: Failed to write %s\n", headerPath.string().c_str());
+        return false;
+    }
+
+    std::printf("Generated %s (%zu cbuffers)\n", headerPath.string().c_str(), layouts.CBuffers.size());
+    return true;
+}
+
+int RunShaderBuild(const ShaderBuildOptions& options)
+{
+    using Clock = std::chrono::steady_clock;
+    const Clock::time_point buildStart = Clock::now();
+
+    std::vector<ShaderBuildItem> items;
+    if (!GatherShaderBuildItems(options, items))
+        return 1;
+
+    std::error_code ec;
+    fs::create_directories(options.OutputDir / kDisassemblyDir, ec);
+
+    const fs::path manifestPath = options.OutputDir / kManifestName;
+    ShaderBuildManifest manifest;
+    if (!options.Force)
+        LoadShaderBuildManifest(manifestPath, manifest);
+
+    const fs::path sourceDir = fs::weakly_canonical(options.SourceDir, ec);
+
+    std::vector<size_t> stale;
+    ShaderBuildManifest nextManifest;
+    for (size_t i = 0; i != items.size(); ++i)
+    {
+        const ShaderBuildItem& item = items[i];
+        const std::string outputName = item.Output.filename().string();
+
+        auto itFind = manifest.find(outputName);
+        if (itFind != manifest.end() && itFind->second.Hash == item.Hash && fs::exists(item.Output) && fs::exists(item.Disassembly))
+        {
+            nextManifest[outputName] = itFind->second;
+            continue;
+        }
+
+        stale.push_back(i);
+    }
+
+    unsigned numJobs = options.NumJobs ? options.NumJobs : std::max(1u, std::thread::hardware_concurrency());
+    numJobs = std::min<unsigned>(numJobs, static_cast<unsigned>(std::max<size_t>(stale.size(), 1)));
+
+    std::atomic<size_t> nextStale{ 0 };
+    std::atomic<size_t> numFailed{ 0 };
+    std::mutex outputMutex;
+
+    auto worker = [&]()
+    {
+        for (size_t s = nextStale++; s < stale.size(); s = nextStale++)
+        {
+            const ShaderBuildItem& item = items[stale[s]];
+
+            std::string log;
+            const bool succeeded = CompileItem(options, item, log);
+
+            std::lock_guard<std::mutex> lock(outputMutex);
+            std::printf("%s %s\n", succeeded ? "Built " : "FAILED", item.Source.filename().string().c_str());
+            if (!log.empty() && (!succeeded || options.Verbose))
+                std::printf("%s\n", log.c_str());
+
+            if (!succeeded)
+            {
+                numFailed++;
+                continue; // Left out of the manifest so it is retried next time
+            }
+
+            ShaderBuildManifestEntry entry;
+            entry.Hash = item.Hash;
+            for (const fs::path& dependency : item.Dependencies)
+                entry.Dependencies.push_back(fs::relative(dependency, sourceDir, ec).generic_string());
+            nextManifest[item.Output.filename().string()] = std::move(entry);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned i = 1; i < numJobs; ++i)
+        threads.emplace_back(worker);
+    worker();
+    for (std::thread& thread : threads)
+        thread.join();
+
+    if (!SaveShaderBuildManifest(manifestPath, nextManifest))
+        std::fprintf(stderr, "Warning: Failed to write %s\n", manifestPath.string().c_str());
+
+    // Only generated from a complete build, a failed shader would drop its cbuffers from the header
+    bool headerFailed = false;
+    if (!options.CBufferHeader.empty() && numFailed.load() == 0)
+        headerFailed = !WriteCBufferHeader(items, options.CBufferHeader);
+
+    const double buildMs = std::chrono::duration<double, std::milli>(Clock::now() - buildStart).count();
+    std::printf("ShaderBuild: %zu up to date, %zu rebuilt, %zu failed in %.1f ms on %u threads.\n",
+        items.size() - stale.size(), stale.size() - numFailed.load(), numFailed.load(), buildMs, numJobs);
+
+    return numFailed.load() == 0 && !headerFailed ? 0 : 1;
+}
+
+}
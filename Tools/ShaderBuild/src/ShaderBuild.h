@@ -0,0 +1,61 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : Incremental offline shader build through the DXC command line
+----------------------------------------------*/
+#ifndef MUON_SHADERBUILD_H
+#define MUON_SHADERBUILD_H
+
+#include <filesystem>
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Muon
+{
+
+struct ShaderBuildOptions
+{
+    std::filesystem::path SourceDir = "Assets/Shaders";
+    std::filesystem::path OutputDir = "_bin/Shaders";
+    std::string Compiler = "dxc";
+    std::filesystem::path CBufferHeader; // Generated C++ mirror of the cbuffer layouts, skipped if empty
+    unsigned NumJobs = 0; // 0 = one per hardware thread
+    bool Debug = false;
+    bool Force = false;
+    bool Verbose = false;
+};
+
+// One compilable source (*VS.hlsl, *PS.hlsl, *CS.hlsl) and everything it includes
+struct ShaderBuildItem
+{
+    std::filesystem::path Source;
+    std::filesystem::path Output;
+    std::filesystem::path Disassembly; // dxc -Fc output in the asm subfolder, read back for the cbuffer layouts
+    std::string Profile;
+    std::vector<std::filesystem::path> Dependencies; // Includes, transitively, relative to the source folder
+    uint64_t Hash = 0; // Source, dependencies and compile arguments
+};
+
+// Last successful build of each output, stored next to the outputs as ShaderBuild.manifest
+struct ShaderBuildManifestEntry
+{
+    uint64_t Hash = 0;
+    std::vector<std::string> Dependencies;
+};
+
+typedef std::unordered_map<std::string, ShaderBuildManifestEntry> ShaderBuildManifest; // Keyed by output file name
+
+bool LoadShaderBuildManifest(const std::filesystem::path& path, ShaderBuildManifest& out_manifest);
+bool SaveShaderBuildManifest(const std::filesystem::path& path, const ShaderBuildManifest& manifest);
+
+// Finds every shader in the source folder and hashes it along with its include graph
+bool GatherShaderBuildItems(const ShaderBuildOptions& options, std::vector<ShaderBuildItem>& out_items);
+
+// Returns the process exit code: 0 if everything is up to date or rebuilt successfully
+int RunShaderBuild(const ShaderBuildOptions& options);
+
+}
+
+#endif
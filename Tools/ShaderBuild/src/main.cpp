@@ -0,0 +1,60 @@
+/*----------------------------------------------
+Ruben Young (rubenaryo@gmail.com)
+Date : 2025/12
+Description : ShaderBuild command line entry point
+----------------------------------------------*/
+#include "ShaderBuild.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+static void PrintUsage()
+{
+    std::printf(
+        "Usage: ShaderBuild [options]\n"
+        "  --src <dir>    Shader source folder (default Assets/Shaders)\n"
+        "  --out <dir>    Output folder for .cso files and the manifest (default _bin/Shaders)\n"
+        "  --dxc <path>   DXC executable (default dxc, from PATH)\n"
+        "  --cbuffers <h> Generate C++ structs mirroring the reflected cbuffer layouts into this header\n"
+        "  --jobs <n>     Parallel compiles (default one per hardware thread)\n"
+        "  --debug        Compile with embedded debug info and no optimizations\n"
+        "  --force        Ignore the manifest and rebuild everything\n"
+        "  --verbose      Print compiler output for successful builds too\n");
+}
+
+int main(int argc, char** argv)
+{
+    Muon::ShaderBuildOptions options;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const char* arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+
+        if (!strcmp(arg, "--src") && hasValue)
+            options.SourceDir = argv[++i];
+        else if (!strcmp(arg, "--out") && hasValue)
+            options.OutputDir = argv[++i];
+        else if (!strcmp(arg, "--dxc") && hasValue)
+            options.Compiler = argv[++i];
+        else if (!strcmp(arg, "--cbuffers") && hasValue)
+            options.CBufferHeader = argv[++i];
+        else if (!strcmp(arg, "--jobs") && hasValue)
+            options.NumJobs = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        else if (!strcmp(arg, "--debug"))
+            options.Debug = true;
+        else if (!strcmp(arg, "--force"))
+            options.Force = true;
+        else if (!strcmp(arg, "--verbose"))
+            options.Verbose = true;
+        else
+        {
+            std::fprintf(stderr, "Error: Unknown argument '%s'\n", arg);
+            PrintUsage();
+            return 2;
+        }
+    }
+
+    return Muon::RunShaderBuild(options);
+}
@@ -21,6 +21,7 @@ project (APP_NAME)
     location (APP_NAME)
     kind "WindowedApp"
     language "C++"
+    dependson "Shaders" -- Generates Generated/ShaderCBuffers.h
 
     targetdir ("_bin/" .. outputdir .. "/%{prj.name}")
     objdir ("_int/" .. outputdir .. "/%{prj.name}")
@@ -81,22 +82,208 @@ project (APP_NAME)
         staticruntime "Off"
         shadermodel "5.0"
 
-project "Shaders"
-    location "Assets/Shaders"
+project "ShaderBuild"
+    location "Tools/ShaderBuild"
+    kind "ConsoleApp"
+    language "C++"
+    cppdialect "C++17"
+
+    targetdir ("_bin/" .. outputdir .. "/%{prj.name}")
+    objdir ("_int/" .. outputdir .. "/%{prj.name}")
+
+    files
+    {
+        "Tools/%{prj.name}/src/**.h",
+        "Tools/%{prj.name}/src/**.cpp"
+    }
+
+    filter "system:linux"
+        links "pthread"
+
+    filter "configurations:Debug"
+        symbols "On"
+
+    filter "configurations:Release"
+        optimize "On"
+
+-- Headless tests and benchmarks for the CPU side of the engine. Run with --bench for the benchmarks.
+-- Only the Application sources under test are compiled in, so it doesn't need a window, a device or the shaders.
+project "Tests"
+    location "Tests"
+    kind "ConsoleApp"
+    language "C++"
+    cppdialect "C++17"
+
+    targetdir ("_bin/" .. outputdir .. "/%{prj.name}")
+    objdir ("_int/" .. outputdir .. "/%{prj.name}")
+
+    files
+    {
+        "%{prj.name}/src/**.h",
+        "%{prj.name}/src/**.cpp",
+        "Application/src/Core/BinaryStream.cpp",
+        "Application/src/Core/BVH.cpp",
+        "Application/src/Core/CloudRaymarcher.cpp",
+        "Application/src/Core/CodexManifest.cpp",
+        "Application/src/Core/CommandRecorder.cpp",
+        "Application/src/Core/Culling.cpp",
+        "Application/src/Core/ImageWriter.cpp",
+        "Application/src/Core/JobSystem.cpp",
+        "Application/src/Core/NameID.cpp",
+        "Application/src/Core/NanoVDBImporter.cpp",
+        "Application/src/Core/NoiseVolume.cpp",
+        "Application/src/Core/OcclusionCuller.cpp",
+        "Application/src/Core/Profiler.cpp",
+        "Application/src/Core/RenderGraph.cpp",
+        "Application/src/Core/RenderQueue.cpp",
+        "Application/src/Core/RootParameterPlan.cpp",
+        "Application/src/Core/RootSignatureBuilder.cpp",
+        "Application/src/Core/SparseCloudVolume.cpp",
+        "Application/src/Core/StringArena.cpp",
+        "Application/src/Core/TransformBatch.cpp",
+        "Application/src/Core/TransformHierarchy.cpp",
+        "Application/src/Core/XmlParser.cpp",
+        "Application/src/Utils/Utils.cpp"
+    }
+
+    removefiles
+    {
+        "%{prj.name}/src/Device/**"
+    }
+
+    includedirs
+    {
+        "external/**/include/",
+        "Application/src",
+        "%{prj.name}/src"
+    }
+
+    filter "system:windows"
+        systemversion "latest"
+
+        defines
+        {
+            "MN_PLATFORM_WINDOWS"
+        }
+
+        -- Shader reflection goes through COM and DXC's reflection interfaces, which only exist on Windows
+        files
+        {
+            "Application/src/Core/Shader.cpp",
+            "Application/src/Core/ShaderReflectionCache.cpp",
+            "Application/src/Core/ShaderUtils.cpp"
+        }
+
+    filter "system:not windows"
+        removefiles
+        {
+            "%{prj.name}/src/ShaderReflectionCacheTests.cpp"
+        }
+
+    filter "system:linux"
+        links "pthread"
+
+    filter "configurations:Debug"
+        defines "MN_DEBUG"
+        symbols "On"
+
+    filter "configurations:Release"
+        defines "MN_RELEASE"
+        optimize "On"
+
+-- Tests for code that's tied to the renderer (Tests/src/Device), so everything but the entry point is compiled in.
+-- Still nothing creates a window or a device, but it needs the generated cbuffer headers and the Application's libraries.
+project "DeviceTests"
+    location "Tests"
     kind "ConsoleApp"
-    shadermodel "5.0"
+    language "C++"
+    cppdialect "C++17"
+    dependson "Shaders" -- Application sources include Generated/ShaderCBuffers.h
 
-    shaderobjectfileoutput ("%{!wks.location}/_bin/Shaders/%%(Filename).cso")
+    targetdir ("_bin/" .. outputdir .. "/%{prj.name}")
     objdir ("_int/" .. outputdir .. "/%{prj.name}")
 
+    files
+    {
+        "Tests/src/TestFramework.h",
+        "Tests/src/TestFramework.cpp",
+        "Tests/src/main.cpp",
+        "Tests/src/Device/**.cpp",
+        "Application/src/**.h",
+        "Application/src/**.cpp"
+    }
+
+    removefiles
+    {
+        "Application/src/Core/main.cpp"
+    }
+
+    includedirs
+    {
+        "external/**/include/",
+        "Application/src",
+        "Tests/src"
+    }
+
+    libdirs
+    {
+        "external/assimp/",
+        "external/dxtk12/%{cfg.buildcfg}/"
+    }
+
+    links
+    {
+        "external/assimp/assimp",
+        "external/dxtk12/%{cfg.buildcfg}/DirectXTK12"
+    }
+
+    postbuildcommands
+    {
+        ("{COPYFILE} %{!wks.location}/external/assimp/Assimp64.dll %{!wks.location}_bin/".. outputdir .. "/%{prj.name}/Assimp64.dll")
+    }
+
+    filter "system:windows"
+        systemversion "latest"
+
+        defines
+        {
+            "MN_PLATFORM_WINDOWS"
+        }
+
+    filter "configurations:Debug"
+        defines "MN_DEBUG"
+        symbols "On"
+        staticruntime "Off"
+
+    filter "configurations:Release"
+        defines "MN_RELEASE"
+        optimize "On"
+        staticruntime "Off"
+
+-- Shaders are built by ShaderBuild through DXC, which only recompiles sources whose include graph changed.
+-- It also regenerates the C++ mirrors of the cbuffer layouts from the compiled shaders.
+project "Shaders"
+    location "Assets/Shaders"
+    kind "Utility"
+    dependson "ShaderBuild"
+
     files
     {
         "%{!wks.location}/Assets/Shaders/**.hlsl",
         "%{!wks.location}/Assets/Shaders/**.hlsli"
     }
 
-    filter { "files:**PS.hlsl" }
-        shadertype "Pixel"
+    filter { "files:**.hlsl or **.hlsli" }
+        buildaction "None"
 
-    filter { "files:**VS.hlsl" }
-        shadertype "Vertex"
+    filter "configurations:Debug"
+        prebuildcommands
+        {
+            ("\"%{!wks.location}/_bin/" .. outputdir .. "/ShaderBuild/ShaderBuild\" --src \"%{!wks.location}/Assets/Shaders\" --out \"%{!wks.location}/_bin/Shaders\" --cbuffers \"%{!wks.location}/Application/src/Generated/ShaderCBuffers.h\" --debug")
+        }
+
+    filter "configurations:Release"
+        prebuildcommands
+        {
+            ("\"%{!wks.location}/_bin/" .. outputdir .. "/ShaderBuild/ShaderBuild\" --src \"%{!wks.location}/Assets/Shaders\" --out \"%{!wks.location}/_bin/Shaders\" --cbuffers \"%{!wks.location}/Application/src/Generated/ShaderCBuffers.h\"")
+        }